@@ -14,10 +14,13 @@
 // to create a spatially averaged model.
 
 #include "cencalvm/average/Averager.h" // USES VMCreator
+#include "cencalvm/storage/Telemetry.h" // USES Telemetry
+#include "cencalvm/storage/CacheMonitor.h" // USES CacheMonitor
 
-#include <stdlib.h> // USES exit()
+#include <stdlib.h> // USES exit(), atoi(), atol()
 #include <unistd.h> // USES getopt()
 #include <stdio.h> // USES EOF
+#include <strings.h> // USES strcasecmp()
 #include <assert.h> // USES assert()
 
 #include <iostream> // USES std::cerr
@@ -28,9 +31,23 @@ void
 usage(void)
 { // usage
   std::cerr
-    << "usage: cencalvmavg [-h] -i inFile -o outFile\n"
+    << "usage: cencalvmavg [-h] -i inFile -o outFile [-b bufferSize]\n"
+    << "         [-c cacheSize] [-k numOctants] [-r] [-w jsonFile]\n"
+    << "       cencalvmavg [-h] -u -o outFile [-c cacheSize]\n"
     << "  -i inFile     Etree database to average.\n"
     << "  -o outFile    Averaged Etree database.\n"
+    << "  -b bufferSize Number of octants held in write-behind buffer.\n"
+    << "  -c cacheSize  Size of etree cache in MB of each database or 'auto'\n"
+    << "                to size caches from available memory (default is\n"
+    << "                512).\n"
+    << "  -k numOctants Write checkpoint to outFile.checkpoint every numOctants\n"
+    << "                input octants.\n"
+    << "  -r            Resume interrupted averaging from its last checkpoint.\n"
+    << "  -u            Update averaged database outFile in place,\n"
+    << "                recomputing only interior octants affected by the\n"
+    << "                octants listed in outFile.dirty.\n"
+    << "  -w jsonFile   Write telemetry of averaging (octants/s, bytes read\n"
+    << "                and written, ETA) to jsonFile as JSON lines.\n"
     << "  -h            Display usage and exit.\n"
     << "\n";
   exit(1);
@@ -40,29 +57,67 @@ usage(void)
 void
 parseArgs(std::string* pFilenameIn,
 	  std::string* pFilenameOut,
+	  int* pBufferSize,
+	  int* pCacheSize,
+	  bool* pUpdate,
+	  long* pCheckpointInterval,
+	  bool* pResume,
+	  std::string* pFilenameTelemetry,
 	  int argc,
 	  char** argv)
 { // parseArgs
   assert(0 != pFilenameIn);
   assert(0 != pFilenameOut);
+  assert(0 != pBufferSize);
+  assert(0 != pCacheSize);
+  assert(0 != pUpdate);
+  assert(0 != pCheckpointInterval);
+  assert(0 != pResume);
+  assert(0 != pFilenameTelemetry);
 
   extern char* optarg;
 
   int nparsed = 1;
   *pFilenameIn = "";
   *pFilenameOut = "";
+  *pFilenameTelemetry = "";
   int c = EOF;
-  while ( (c = getopt(argc, argv, "hi:o:") ) != EOF) {
+  while ( (c = getopt(argc, argv, "b:c:hi:k:o:ruw:") ) != EOF) {
     switch (c)
       { // switch
+	case 'b' : // process -b option
+	  *pBufferSize = atoi(optarg);
+	  nparsed += 2;
+	  break;
+	case 'c' : // process -c option
+	  *pCacheSize = (0 == strcasecmp(optarg, "auto")) ?
+	    cencalvm::storage::CacheMonitor::AUTOSIZE : atoi(optarg);
+	  nparsed += 2;
+	  break;
 	case 'i' : // process -i option
 	  *pFilenameIn = optarg;
 	  nparsed += 2;
 	  break;
+	case 'k' : // process -k option
+	  *pCheckpointInterval = atol(optarg);
+	  nparsed += 2;
+	  break;
 	case 'o' : // process -o option
 	  *pFilenameOut = optarg;
 	  nparsed += 2;
 	  break;
+	case 'r' : // process -r option
+	  *pResume = true;
+	  nparsed += 1;
+	  break;
+	case 'u' : // process -u option
+	  *pUpdate = true;
+	  nparsed += 1;
+	  break;
+	case 'w' : // process -w option
+	  *pFilenameTelemetry = optarg;
+	  nparsed += 2;
+	  break;
 	case 'h' : // process -h option
 	  nparsed += 1;
 	  usage();
@@ -73,8 +128,10 @@ parseArgs(std::string* pFilenameIn,
 	} // switch
     } // while
   if (nparsed != argc || 
-      0 == pFilenameIn->length() ||
-      0 == pFilenameOut->length())
+      (0 == pFilenameIn->length()) != *pUpdate ||
+      0 == pFilenameOut->length() ||
+      *pCheckpointInterval < 0 ||
+      (*pUpdate && (*pCheckpointInterval > 0 || *pResume)))
     usage();
 } // parseArgs
 
@@ -85,15 +142,33 @@ main(int argc,
 { // main
   std::string filenameIn = "";
   std::string filenameOut = "";
+  int bufferSize = 0;
+  int cacheSize = 512;
+  bool update = false;
+  long checkpointInterval = 0;
+  bool resume = false;
+  std::string filenameTelemetry = "";
   
-  parseArgs(&filenameIn, &filenameOut, argc, argv);
+  parseArgs(&filenameIn, &filenameOut, &bufferSize, &cacheSize, &update,
+	    &checkpointInterval, &resume, &filenameTelemetry, argc, argv);
 
   try {
+    cencalvm::storage::Telemetry telemetry;
+    telemetry.filename(filenameTelemetry.c_str());
+
     cencalvm::average::Averager averager;
 
     averager.filenameIn(filenameIn.c_str());
     averager.filenameOut(filenameOut.c_str());
-    averager.average();
+    averager.bufferSize(bufferSize);
+    averager.cacheSize(cacheSize);
+    averager.checkpointInterval(checkpointInterval);
+    averager.resume(resume);
+    averager.telemetry(&telemetry);
+    if (update)
+      averager.update();
+    else
+      averager.average();
   } catch (const std::exception& err) {
     std::cerr << err.what();
     return 1;
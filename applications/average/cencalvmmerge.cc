@@ -0,0 +1,145 @@
+// -*- C++ -*-
+//
+// ======================================================================
+//
+//                           Brad T. Aagaard
+//                        U.S. Geological Survey
+//
+// {LicenseText}
+//
+// ======================================================================
+//
+
+// Application driver to merge the etree databases for the detailed
+// and extended central CA velocity models into a single database.
+
+#include "cencalvm/average/Merger.h" // USES Merger
+#include "cencalvm/storage/CacheMonitor.h" // USES CacheMonitor
+
+#include <stdlib.h> // USES exit(), atoi()
+#include <unistd.h> // USES getopt()
+#include <stdio.h> // USES EOF
+#include <strings.h> // USES strcasecmp()
+#include <assert.h> // USES assert()
+
+#include <iostream> // USES std::cerr
+#include <stdexcept> // USES std::exception
+
+// ----------------------------------------------------------------------
+void
+usage(void)
+{ // usage
+  std::cerr
+    << "usage: cencalvmmerge [-h] -i inFile -e extFile -o outFile "
+    << "[-b bufferSize]\n"
+    << "         [-c cacheSize]\n"
+    << "  -i inFile     Etree database for detailed model.\n"
+    << "  -e extFile    Etree database for extended model.\n"
+    << "  -o outFile    Merged Etree database.\n"
+    << "  -b bufferSize Number of octants held in write-behind buffer.\n"
+    << "  -c cacheSize  Size of etree cache in MB of each database or 'auto'\n"
+    << "                to size caches from available memory (default is\n"
+    << "                512).\n"
+    << "  -h            Display usage and exit.\n"
+    << "\n"
+    << "Both input databases must be averaged or both not averaged.\n";
+  exit(1);
+} // usage
+
+// ----------------------------------------------------------------------
+void
+parseArgs(std::string* pFilenameIn,
+	  std::string* pFilenameExt,
+	  std::string* pFilenameOut,
+	  int* pBufferSize,
+	  int* pCacheSize,
+	  int argc,
+	  char** argv)
+{ // parseArgs
+  assert(0 != pFilenameIn);
+  assert(0 != pFilenameExt);
+  assert(0 != pFilenameOut);
+  assert(0 != pBufferSize);
+  assert(0 != pCacheSize);
+
+  extern char* optarg;
+
+  int nparsed = 1;
+  *pFilenameIn = "";
+  *pFilenameExt = "";
+  *pFilenameOut = "";
+  int c = EOF;
+  while ( (c = getopt(argc, argv, "b:c:e:hi:o:") ) != EOF) {
+    switch (c)
+      { // switch
+	case 'b' : // process -b option
+	  *pBufferSize = atoi(optarg);
+	  nparsed += 2;
+	  break;
+	case 'c' : // process -c option
+	  *pCacheSize = (0 == strcasecmp(optarg, "auto")) ?
+	    cencalvm::storage::CacheMonitor::AUTOSIZE : atoi(optarg);
+	  nparsed += 2;
+	  break;
+	case 'e' : // process -e option
+	  *pFilenameExt = optarg;
+	  nparsed += 2;
+	  break;
+	case 'i' : // process -i option
+	  *pFilenameIn = optarg;
+	  nparsed += 2;
+	  break;
+	case 'o' : // process -o option
+	  *pFilenameOut = optarg;
+	  nparsed += 2;
+	  break;
+	case 'h' : // process -h option
+	  nparsed += 1;
+	  usage();
+	  exit(0);
+	  break;
+	default :
+	  usage();
+	} // switch
+    } // while
+  if (nparsed != argc || 
+      0 == pFilenameIn->length() ||
+      0 == pFilenameExt->length() ||
+      0 == pFilenameOut->length())
+    usage();
+} // parseArgs
+
+// ----------------------------------------------------------------------
+int
+main(int argc,
+     char* argv[])
+{ // main
+  std::string filenameIn = "";
+  std::string filenameExt = "";
+  std::string filenameOut = "";
+  int bufferSize = 0;
+  int cacheSize = 512;
+  
+  parseArgs(&filenameIn, &filenameExt, &filenameOut, &bufferSize, 
+	    &cacheSize, argc, argv);
+
+  try {
+    cencalvm::average::Merger merger;
+
+    merger.filenameIn(filenameIn.c_str());
+    merger.filenameExt(filenameExt.c_str());
+    merger.filenameOut(filenameOut.c_str());
+    merger.bufferSize(bufferSize);
+    merger.cacheSize(cacheSize);
+    merger.merge();
+  } catch (const std::exception& err) {
+    std::cerr << err.what();
+    return 1;
+  } catch (...) {
+    return 1;
+  } // catch
+
+  return 0;
+} // main
+
+// End of file 
@@ -0,0 +1,145 @@
+// -*- C++ -*-
+//
+// ======================================================================
+//
+//                           Brad T. Aagaard
+//                        U.S. Geological Survey
+//
+// {LicenseText}
+//
+// ======================================================================
+//
+
+// Application driver to merge a patch etree database for a revised
+// region into the central CA velocity model.
+
+#include "cencalvm/average/Patcher.h" // USES Patcher
+#include "cencalvm/storage/CacheMonitor.h" // USES CacheMonitor
+
+#include <stdlib.h> // USES exit(), atoi()
+#include <unistd.h> // USES getopt()
+#include <stdio.h> // USES EOF
+#include <strings.h> // USES strcasecmp()
+#include <assert.h> // USES assert()
+
+#include <iostream> // USES std::cerr
+#include <stdexcept> // USES std::exception
+
+// ----------------------------------------------------------------------
+void
+usage(void)
+{ // usage
+  std::cerr
+    << "usage: cencalvmpatch [-h] -i inFile -p patchFile -o outFile "
+    << "[-b bufferSize]\n"
+    << "         [-c cacheSize]\n"
+    << "  -i inFile     Etree database to patch (averaged or not).\n"
+    << "  -p patchFile  Etree database for revised region created with\n"
+    << "                cencalvmgen (not averaged).\n"
+    << "  -o outFile    Patched Etree database.\n"
+    << "  -b bufferSize Number of octants held in write-behind buffer.\n"
+    << "  -c cacheSize  Size of etree cache in MB of each database or 'auto'\n"
+    << "                to size caches from available memory (default is\n"
+    << "                512).\n"
+    << "  -h            Display usage and exit.\n"
+    << "\n";
+  exit(1);
+} // usage
+
+// ----------------------------------------------------------------------
+void
+parseArgs(std::string* pFilenameIn,
+	  std::string* pFilenamePatch,
+	  std::string* pFilenameOut,
+	  int* pBufferSize,
+	  int* pCacheSize,
+	  int argc,
+	  char** argv)
+{ // parseArgs
+  assert(0 != pFilenameIn);
+  assert(0 != pFilenamePatch);
+  assert(0 != pFilenameOut);
+  assert(0 != pBufferSize);
+  assert(0 != pCacheSize);
+
+  extern char* optarg;
+
+  int nparsed = 1;
+  *pFilenameIn = "";
+  *pFilenamePatch = "";
+  *pFilenameOut = "";
+  int c = EOF;
+  while ( (c = getopt(argc, argv, "b:c:hi:o:p:") ) != EOF) {
+    switch (c)
+      { // switch
+	case 'b' : // process -b option
+	  *pBufferSize = atoi(optarg);
+	  nparsed += 2;
+	  break;
+	case 'c' : // process -c option
+	  *pCacheSize = (0 == strcasecmp(optarg, "auto")) ?
+	    cencalvm::storage::CacheMonitor::AUTOSIZE : atoi(optarg);
+	  nparsed += 2;
+	  break;
+	case 'i' : // process -i option
+	  *pFilenameIn = optarg;
+	  nparsed += 2;
+	  break;
+	case 'o' : // process -o option
+	  *pFilenameOut = optarg;
+	  nparsed += 2;
+	  break;
+	case 'p' : // process -p option
+	  *pFilenamePatch = optarg;
+	  nparsed += 2;
+	  break;
+	case 'h' : // process -h option
+	  nparsed += 1;
+	  usage();
+	  exit(0);
+	  break;
+	default :
+	  usage();
+	} // switch
+    } // while
+  if (nparsed != argc || 
+      0 == pFilenameIn->length() ||
+      0 == pFilenamePatch->length() ||
+      0 == pFilenameOut->length())
+    usage();
+} // parseArgs
+
+// ----------------------------------------------------------------------
+int
+main(int argc,
+     char* argv[])
+{ // main
+  std::string filenameIn = "";
+  std::string filenamePatch = "";
+  std::string filenameOut = "";
+  int bufferSize = 0;
+  int cacheSize = 512;
+  
+  parseArgs(&filenameIn, &filenamePatch, &filenameOut, &bufferSize, 
+	    &cacheSize, argc, argv);
+
+  try {
+    cencalvm::average::Patcher patcher;
+
+    patcher.filenameIn(filenameIn.c_str());
+    patcher.filenamePatch(filenamePatch.c_str());
+    patcher.filenameOut(filenameOut.c_str());
+    patcher.bufferSize(bufferSize);
+    patcher.cacheSize(cacheSize);
+    patcher.patch();
+  } catch (const std::exception& err) {
+    std::cerr << err.what();
+    return 1;
+  } catch (...) {
+    return 1;
+  } // catch
+
+  return 0;
+} // main
+
+// End of file 
@@ -0,0 +1,180 @@
+// -*- C++ -*-
+//
+// ======================================================================
+//
+//                           Brad T. Aagaard
+//                        U.S. Geological Survey
+//
+// ======================================================================
+//
+// Application driver to build the packed, spatially averaged etree
+// database of central CA velocity model in a single pass. Points are
+// sorted into etree order and averaged as they are appended, so no
+// unpacked or unaveraged databases are created.
+
+#include "cencalvm/create/GridIngester.h" // USES GridIngester
+#include "cencalvm/storage/Geometry.h" // USES Geometry
+#include "cencalvm/storage/GeomCenCA.h" // USES GeomCenCA
+#include "cencalvm/storage/Telemetry.h" // USES Telemetry
+
+#include <stdlib.h> // USES exit()
+#include <unistd.h> // USES getopt()
+#include <stdio.h> // USES EOF
+
+#include <iostream> // USES std::cerr
+#include <stdexcept> // USES std::exception
+#include <assert.h> // USES assert()
+
+// ----------------------------------------------------------------------
+void
+usage(void)
+{ // usage
+  std::cerr
+    << "usage: cencalvmbuild [-h] -i paramFile -o outFile -t tmpFile\n"
+    << "         [-c cacheSize] [-j numThreads] [-s sortSize] [-w jsonFile]\n"
+    << "  -i paramFile  Parameter file with list of grid input files\n"
+    << "  -o outFile    Packed, averaged etree database file created.\n"
+    << "  -t tmpFile    Root name of sorted runs that do not fit in memory.\n"
+    << "  -c cacheSize  Size of database cache in MB.\n"
+    << "  -j numThreads Number of threads used to parse grids (default is\n"
+    << "                number of processors).\n"
+    << "  -s sortSize   Size of memory in MB used to sort points (default\n"
+    << "                is 1024).\n"
+    << "  -w jsonFile   Write telemetry of each phase (octants/s, bytes read\n"
+    << "                and written, ETA) to jsonFile as JSON lines.\n"
+    << "  -h            Display usage and exit.\n"
+    << "\n"
+    << "Equivalent to cencalvmgen with sorting followed by cencalvmavg,\n"
+    << "without writing and rereading the unaveraged database.\n";
+  exit(1);
+} // usage
+
+// ----------------------------------------------------------------------
+void
+parseArgs(std::string* pFilenameParams,
+	  std::string* pFilenameOut,
+	  std::string* pFilenameTmp,
+	  int* pCacheSize,
+	  int* pNumThreads,
+	  int* pSortSize,
+	  std::string* pFilenameTelemetry,
+	  int argc,
+	  char** argv)
+{ // parseArgs
+  assert(0 != pFilenameParams);
+  assert(0 != pFilenameOut);
+  assert(0 != pFilenameTmp);
+  assert(0 != pCacheSize);
+  assert(0 != pNumThreads);
+  assert(0 != pSortSize);
+  assert(0 != pFilenameTelemetry);
+
+  extern char* optarg;
+
+  int nparsed = 1;
+  *pFilenameParams = "";
+  *pFilenameOut = "";
+  *pFilenameTmp = "";
+  *pFilenameTelemetry = "";
+  int c = EOF;
+  while ( (c = getopt(argc, argv, "c:hi:j:o:s:t:w:") ) != EOF) {
+    switch (c)
+      { // switch
+      case 'c' : // process -c option
+	*pCacheSize = atoi(optarg);
+	nparsed += 2;
+	break;
+      case 'h' : // process -h option
+	nparsed += 1;
+	usage();
+	exit(0);
+	break;
+      case 'i' : // process -i option
+	*pFilenameParams = optarg;
+	nparsed += 2;
+	break;
+      case 'j' : // process -j option
+	*pNumThreads = atoi(optarg);
+	nparsed += 2;
+	break;
+      case 'o' : // process -o option
+	*pFilenameOut = optarg;
+	nparsed += 2;
+	break;
+      case 's' : // process -s option
+	*pSortSize = atoi(optarg);
+	nparsed += 2;
+	break;
+      case 't' : // process -t option
+	*pFilenameTmp = optarg;
+	nparsed += 2;
+	break;
+      case 'w' : // process -w option
+	*pFilenameTelemetry = optarg;
+	nparsed += 2;
+	break;
+      default :
+	usage();
+      } // switch
+    } // while
+  if (nparsed != argc || 
+      0 == pFilenameParams->length() ||
+      0 == pFilenameOut->length() ||
+      0 == pFilenameTmp->length() ||
+      *pSortSize <= 0)
+    usage();
+} // parseArgs
+
+// ----------------------------------------------------------------------
+int
+main(int argc,
+     char* argv[])
+{ // main
+  std::string filenameParams = "";
+  std::string filenameOut = "";
+  std::string filenameTmp = "";
+  int cacheSize = 512;
+  int numThreads = 0;
+  int sortSize = 1024;
+  std::string filenameTelemetry = "";
+  const char* description = 
+    "U.S. Geological Survey\n"
+    "Thomas Brocher, Robert Jachens, Carl Wentworth, Russel Graymer, "
+    "Robert Simpson, Brad Aagaard";
+  
+  parseArgs(&filenameParams, &filenameOut, &filenameTmp, &cacheSize,
+	    &numThreads, &sortSize, &filenameTelemetry, argc, argv);
+
+  try {
+    cencalvm::storage::Telemetry telemetry;
+    telemetry.filename(filenameTelemetry.c_str());
+
+    cencalvm::create::GridIngester db;
+    
+    cencalvm::storage::GeomCenCA geom;
+
+    db.geometry(&geom);
+    db.filenameParams(filenameParams.c_str());
+    db.filenameOut(filenameOut.c_str());
+    db.filenameTmp(filenameTmp.c_str());
+    db.cacheSize(cacheSize);
+    db.numThreads(numThreads);
+    db.sortSize(sortSize);
+    db.average(true);
+    db.telemetry(&telemetry);
+    db.description(description);
+    db.run();
+  } catch (const std::exception& err) {
+    std::cerr << err.what() << std::endl;
+    return 1;
+  } catch (...) {
+    return 1;
+  } // catch
+
+  return 0;
+} // main
+
+// version
+// $Id$
+
+// End of file 
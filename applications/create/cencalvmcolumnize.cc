@@ -0,0 +1,111 @@
+// ======================================================================
+//
+//                           Brad T. Aagaard
+//                        U.S. Geological Survey
+//
+// ======================================================================
+//
+// Application driver to convert a packed etree database for the
+// central CA velocity model to a read-only column-split database.
+
+#include "cencalvm/create/Columnizer.h" // USES Columnizer
+
+#include <stdlib.h> // USES exit(), atoi()
+#include <unistd.h> // USES getopt()
+#include <stdio.h> // USES EOF
+
+#include <iostream> // USES std::cerr
+#include <stdexcept> // USES std::exception
+#include <string> // USES std::string
+#include <assert.h> // USES assert()
+
+// ----------------------------------------------------------------------
+void
+usage(void)
+{ // usage
+  std::cerr
+    << "usage: cencalvmcolumnize [-h] -i inFile -o outFile [-c cacheSize]\n"
+    << "  -i inFile       Packed etree database file to split into columns.\n"
+    << "  -o outFile      Key file of column-split database created; value\n"
+    << "                  files are outFile.Vp, outFile.Vs, etc.\n"
+    << "  -c cacheSize    Size of cache in MB for input database.\n"
+    << "  -h              Display usage and exit.\n";
+  exit(1);
+} // usage
+
+// ----------------------------------------------------------------------
+void
+parseArgs(std::string* pFilenameIn,
+	  std::string* pFilenameOut,
+	  int* pCacheSize,
+	  int argc,
+	  char** argv)
+{ // parseArgs
+  assert(0 != pFilenameIn);
+  assert(0 != pFilenameOut);
+  assert(0 != pCacheSize);
+
+  extern char* optarg;
+
+  int nparsed = 1;
+  *pFilenameIn = "";
+  *pFilenameOut = "";
+  int c = EOF;
+  while ( (c = getopt(argc, argv, "c:hi:o:") ) != EOF) {
+    switch (c)
+      { // switch
+      case 'c': // process -c options
+	*pCacheSize = atoi(optarg);
+	nparsed += 2;
+	break;
+      case 'i' : // process -i option
+	*pFilenameIn = optarg;
+	nparsed += 2;
+	break;
+      case 'o' : // process -o option
+	*pFilenameOut = optarg;
+	nparsed += 2;
+	break;
+      case 'h' : // process -h option
+	nparsed += 1;
+	usage();
+	exit(0);
+	break;
+      default :
+	usage();
+      } // switch
+  } // while
+  if (nparsed != argc ||
+      0 == pFilenameIn->length() ||
+      0 == pFilenameOut->length())
+    usage();
+} // parseArgs
+
+// ----------------------------------------------------------------------
+int
+main(int argc,
+     char* argv[])
+{ // main
+  std::string filenameIn = "";
+  std::string filenameOut = "";
+  int cacheSize = 64;
+
+  parseArgs(&filenameIn, &filenameOut, &cacheSize, argc, argv);
+
+  try {
+    cencalvm::create::Columnizer columnizer;
+    columnizer.filenameIn(filenameIn.c_str());
+    columnizer.filenameOut(filenameOut.c_str());
+    columnizer.cacheSize(cacheSize);
+    columnizer.columnize();
+  } catch (const std::exception& err) {
+    std::cerr << err.what() << std::endl;
+    return 1;
+  } catch (...) {
+    return 1;
+  } // catch
+
+  return 0;
+} // main
+
+// End of file
@@ -0,0 +1,116 @@
+// ======================================================================
+//
+//                           Brad T. Aagaard
+//                        U.S. Geological Survey
+//
+// ======================================================================
+//
+// Application driver to collapse homogeneous subtrees of a packed
+// etree database for the central CA velocity model into single leaf
+// octants.
+
+#include "cencalvm/create/Compactor.h" // USES Compactor
+
+#include <stdlib.h> // USES exit(), atoi()
+#include <unistd.h> // USES getopt()
+#include <stdio.h> // USES EOF
+
+#include <iostream> // USES std::cerr
+#include <stdexcept> // USES std::exception
+#include <string> // USES std::string
+#include <assert.h> // USES assert()
+
+// ----------------------------------------------------------------------
+void
+usage(void)
+{ // usage
+  std::cerr
+    << "usage: cencalvmcompact [-h] -i inFile -o outFile [-c cacheSize]\n"
+    << "  -i inFile       Packed etree database file to compact.\n"
+    << "  -o outFile      Compacted etree database file created.\n"
+    << "  -c cacheSize    Size of cache in MB for each database.\n"
+    << "  -h              Display usage and exit.\n"
+    << "\n"
+    << "Subtrees whose leaf octants fill them and have identical payloads\n"
+    << "(with depths of the free surface that share a free surface) are\n"
+    << "replaced by a single leaf octant. Compact after patching;\n"
+    << "compacted databases cannot be patched.\n";
+  exit(1);
+} // usage
+
+// ----------------------------------------------------------------------
+void
+parseArgs(std::string* pFilenameIn,
+	  std::string* pFilenameOut,
+	  int* pCacheSize,
+	  int argc,
+	  char** argv)
+{ // parseArgs
+  assert(0 != pFilenameIn);
+  assert(0 != pFilenameOut);
+  assert(0 != pCacheSize);
+
+  extern char* optarg;
+
+  int nparsed = 1;
+  *pFilenameIn = "";
+  *pFilenameOut = "";
+  int c = EOF;
+  while ( (c = getopt(argc, argv, "c:hi:o:") ) != EOF) {
+    switch (c)
+      { // switch
+      case 'c': // process -c options
+	*pCacheSize = atoi(optarg);
+	nparsed += 2;
+	break;
+      case 'i' : // process -i option
+	*pFilenameIn = optarg;
+	nparsed += 2;
+	break;
+      case 'o' : // process -o option
+	*pFilenameOut = optarg;
+	nparsed += 2;
+	break;
+      case 'h' : // process -h option
+	nparsed += 1;
+	usage();
+	exit(0);
+	break;
+      default :
+	usage();
+      } // switch
+  } // while
+  if (nparsed != argc ||
+      0 == pFilenameIn->length() ||
+      0 == pFilenameOut->length())
+    usage();
+} // parseArgs
+
+// ----------------------------------------------------------------------
+int
+main(int argc,
+     char* argv[])
+{ // main
+  std::string filenameIn = "";
+  std::string filenameOut = "";
+  int cacheSize = 64;
+
+  parseArgs(&filenameIn, &filenameOut, &cacheSize, argc, argv);
+
+  try {
+    cencalvm::create::Compactor compactor;
+    compactor.filenameIn(filenameIn.c_str());
+    compactor.filenameOut(filenameOut.c_str());
+    compactor.cacheSize(cacheSize);
+    compactor.compact();
+  } catch (const std::exception& err) {
+    std::cerr << err.what() << std::endl;
+    return 1;
+  } catch (...) {
+    return 1;
+  } // catch
+
+  return 0;
+} // main
+
+// End of file
@@ -0,0 +1,125 @@
+// ======================================================================
+//
+//                           Brad T. Aagaard
+//                        U.S. Geological Survey
+//
+// ======================================================================
+//
+// Application driver to convert a packed etree database for the
+// central CA velocity model to a read-only compressed container.
+
+#include "cencalvm/create/Compressor.h" // USES Compressor
+
+#include <stdlib.h> // USES exit(), atoi()
+#include <unistd.h> // USES getopt()
+#include <stdio.h> // USES EOF
+
+#include <iostream> // USES std::cerr
+#include <stdexcept> // USES std::exception
+#include <string> // USES std::string
+#include <assert.h> // USES assert()
+
+// ----------------------------------------------------------------------
+void
+usage(void)
+{ // usage
+  std::cerr
+    << "usage: cencalvmcompress [-h] -i inFile -o outFile\n"
+    << "         [-b blockSize] [-c cacheSize]\n"
+    << "  -i inFile       Packed etree database file to compress.\n"
+    << "  -o outFile      Compressed etree database file created.\n"
+    << "  -b blockSize    Number of octants in each compressed block\n"
+    << "                  (default is 4096).\n"
+    << "  -c cacheSize    Size of cache in MB for input database.\n"
+    << "  -h              Display usage and exit.\n"
+    << "\n"
+    << "The dictionary of a dictionary-encoded database is copied to\n"
+    << "outFile.dict.\n";
+  exit(1);
+} // usage
+
+// ----------------------------------------------------------------------
+void
+parseArgs(std::string* pFilenameIn,
+	  std::string* pFilenameOut,
+	  int* pBlockSize,
+	  int* pCacheSize,
+	  int argc,
+	  char** argv)
+{ // parseArgs
+  assert(0 != pFilenameIn);
+  assert(0 != pFilenameOut);
+  assert(0 != pBlockSize);
+  assert(0 != pCacheSize);
+
+  extern char* optarg;
+
+  int nparsed = 1;
+  *pFilenameIn = "";
+  *pFilenameOut = "";
+  int c = EOF;
+  while ( (c = getopt(argc, argv, "b:c:hi:o:") ) != EOF) {
+    switch (c)
+      { // switch
+      case 'b': // process -b options
+	*pBlockSize = atoi(optarg);
+	nparsed += 2;
+	break;
+      case 'c': // process -c options
+	*pCacheSize = atoi(optarg);
+	nparsed += 2;
+	break;
+      case 'i' : // process -i option
+	*pFilenameIn = optarg;
+	nparsed += 2;
+	break;
+      case 'o' : // process -o option
+	*pFilenameOut = optarg;
+	nparsed += 2;
+	break;
+      case 'h' : // process -h option
+	nparsed += 1;
+	usage();
+	exit(0);
+	break;
+      default :
+	usage();
+      } // switch
+  } // while
+  if (nparsed != argc ||
+      0 == pFilenameIn->length() ||
+      0 == pFilenameOut->length() ||
+      *pBlockSize <= 0)
+    usage();
+} // parseArgs
+
+// ----------------------------------------------------------------------
+int
+main(int argc,
+     char* argv[])
+{ // main
+  std::string filenameIn = "";
+  std::string filenameOut = "";
+  int blockSize = 4096;
+  int cacheSize = 64;
+
+  parseArgs(&filenameIn, &filenameOut, &blockSize, &cacheSize, argc, argv);
+
+  try {
+    cencalvm::create::Compressor compressor;
+    compressor.filenameIn(filenameIn.c_str());
+    compressor.filenameOut(filenameOut.c_str());
+    compressor.blockSize(blockSize);
+    compressor.cacheSize(cacheSize);
+    compressor.compress();
+  } catch (const std::exception& err) {
+    std::cerr << err.what() << std::endl;
+    return 1;
+  } catch (...) {
+    return 1;
+  } // catch
+
+  return 0;
+} // main
+
+// End of file
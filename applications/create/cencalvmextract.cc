@@ -0,0 +1,166 @@
+// ======================================================================
+//
+//                           Brad T. Aagaard
+//                        U.S. Geological Survey
+//
+// ======================================================================
+//
+// Application driver to extract a region of interest from an etree
+// database for the central CA velocity model.
+
+#include "cencalvm/create/Extractor.h" // USES Extractor
+#include "cencalvm/storage/Geometry.h" // USES GeomCenCA
+#include "cencalvm/storage/GeomCenCA.h" // USES GeomCenCA
+
+#include <stdlib.h> // USES exit()
+#include <unistd.h> // USES getopt()
+#include <stdio.h> // USES EOF, sscanf()
+
+#include <iostream> // USES std::cerr
+#include <stdexcept> // USES std::exception
+#include <string> // USES std::string
+#include <assert.h> // USES assert()
+
+// ----------------------------------------------------------------------
+void
+usage(void)
+{ // usage
+  std::cerr
+    << "usage: cencalvmextract [-h] -i inFile -o outFile\n"
+    << "         -x lonMin/lonMax -y latMin/latMax -z elevMin/elevMax\n"
+    << "         [-l maxLevel] [-c cacheSize]\n"
+    << "  -i inFile     Etree database file to extract region from.\n"
+    << "  -o outFile    Etree database file created.\n"
+    << "  -x lonMin/lonMax  Range in longitude (degrees, WGS84).\n"
+    << "  -y latMin/latMax  Range in latitude (degrees, WGS84).\n"
+    << "  -z elevMin/elevMax  Range in elevation (m).\n"
+    << "  -l maxLevel   Maximum octant level (database must be averaged).\n"
+    << "  -c cacheSize  Size of cache in MB for input database.\n"
+    << "  -h            Display usage and exit.\n";
+  exit(1);
+} // usage
+
+// ----------------------------------------------------------------------
+void
+parseRange(double* pMin,
+	   double* pMax,
+	   const char* arg)
+{ // parseRange
+  assert(0 != pMin);
+  assert(0 != pMax);
+
+  if (2 != sscanf(arg, "%lf/%lf", pMin, pMax)) {
+    std::cerr << "Could not parse range '" << arg << "'.\n";
+    usage();
+  } // if
+} // parseRange
+
+// ----------------------------------------------------------------------
+void
+parseArgs(std::string* pFilenameIn,
+	  std::string* pFilenameOut,
+	  double* pBounds,
+	  int* pMaxLevel,
+	  int* pCacheSize,
+	  int argc,
+	  char** argv)
+{ // parseArgs
+  assert(0 != pFilenameIn);
+  assert(0 != pFilenameOut);
+  assert(0 != pBounds);
+  assert(0 != pMaxLevel);
+  assert(0 != pCacheSize);
+
+  extern char* optarg;
+
+  int nparsed = 1;
+  *pFilenameIn = "";
+  *pFilenameOut = "";
+  bool haveRange[3] = { false, false, false };
+  int c = EOF;
+  while ( (c = getopt(argc, argv, "c:hi:l:o:x:y:z:") ) != EOF) {
+    switch (c)
+      { // switch
+      case 'c': // process -c options
+	*pCacheSize = atoi(optarg);
+	nparsed += 2;
+	break;
+      case 'i' : // process -i option
+	*pFilenameIn = optarg;
+	nparsed += 2;
+	break;
+      case 'l' : // process -l option
+	*pMaxLevel = atoi(optarg);
+	nparsed += 2;
+	break;
+      case 'o' : // process -o option
+	*pFilenameOut = optarg;
+	nparsed += 2;
+	break;
+      case 'x' : // process -x option
+	parseRange(&pBounds[0], &pBounds[1], optarg);
+	haveRange[0] = true;
+	nparsed += 2;
+	break;
+      case 'y' : // process -y option
+	parseRange(&pBounds[2], &pBounds[3], optarg);
+	haveRange[1] = true;
+	nparsed += 2;
+	break;
+      case 'z' : // process -z option
+	parseRange(&pBounds[4], &pBounds[5], optarg);
+	haveRange[2] = true;
+	nparsed += 2;
+	break;
+      case 'h' : // process -h option
+	nparsed += 1;
+	usage();
+	exit(0);
+	break;
+      default :
+	usage();
+      } // switch
+  } // while
+  if (nparsed != argc || 
+      0 == pFilenameIn->length() ||
+      0 == pFilenameOut->length() ||
+      !haveRange[0] || !haveRange[1] || !haveRange[2])
+    usage();
+} // parseArgs
+
+// ----------------------------------------------------------------------
+int
+main(int argc,
+     char* argv[])
+{ // main
+  std::string filenameIn = "";
+  std::string filenameOut = "";
+  double bounds[6];
+  int maxLevel = -1;
+  int cacheSize = 64;
+  
+  parseArgs(&filenameIn, &filenameOut, bounds, &maxLevel, &cacheSize,
+	    argc, argv);
+
+  try {
+    cencalvm::storage::GeomCenCA geometry;
+    cencalvm::create::Extractor extractor;
+    extractor.filenameIn(filenameIn.c_str());
+    extractor.filenameOut(filenameOut.c_str());
+    extractor.cacheSize(cacheSize);
+    extractor.geometry(&geometry);
+    extractor.region(bounds[0], bounds[1], bounds[2], bounds[3],
+		     bounds[4], bounds[5]);
+    extractor.maxLevel(maxLevel);
+    extractor.extract();
+  } catch (const std::exception& err) {
+    std::cerr << err.what() << std::endl;
+    return 1;
+  } catch (...) {
+    return 1;
+  } // catch
+
+  return 0;
+} // main
+
+// End of file
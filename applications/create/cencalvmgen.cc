@@ -13,8 +13,9 @@
 #include "cencalvm/create/GridIngester.h" // USES GridIngester
 #include "cencalvm/storage/Geometry.h" // USES Geometry
 #include "cencalvm/storage/GeomCenCA.h" // USES GeomCenCA
+#include "cencalvm/storage/Telemetry.h" // USES Telemetry
 
-#include <stdlib.h> // USES exit()
+#include <stdlib.h> // USES exit(), atoi(), atol()
 #include <unistd.h> // USES getopt()
 #include <stdio.h> // USES EOF
 
@@ -28,13 +29,27 @@ usage(void)
 { // usage
   std::cerr
     << "usage: cencalvmgen [-h] -i paramFile -o outFile -t tmpFile [-l logFile]\n"
+    << "         [-j numThreads] [-s sortSize] [-k numPoints] [-r]\n"
+    << "         [-w jsonFile]\n"
     << "  -i paramFile  Parameter file with list of grid input files\n"
     << "  -o outFile    Etree database file created.\n"
     << "  -t tmpFile    Name of scratch file used in database construction.\n"
     << "  -h            Display usage and exit.\n"
     << "  -l logFile    Log file for warnings about data.\n"
+    << "  -j numThreads Number of threads used to parse grids and pack database\n"
+    << "                (default is number of processors).\n"
+    << "  -s sortSize   Build packed database directly by sorting points using\n"
+    << "                sortSize MB of memory (tmpFile is root name of sorted\n"
+    << "                runs) instead of packing temporary database.\n"
+    << "  -k numPoints  Write checkpoint to outFile.checkpoint every numPoints\n"
+    << "                points.\n"
+    << "  -r            Resume interrupted run from its last checkpoint (use\n"
+    << "                the same arguments as the interrupted run).\n"
+    << "  -w jsonFile   Write telemetry of each phase (octants/s, bytes read\n"
+    << "                and written, ETA) to jsonFile as JSON lines.\n"
     << "\n"
-    << "Parameter file is list of grid input files, one per line.\n";
+    << "Parameter file is list of grid input files, one per line. Grid\n"
+    << "files may be ASCII or binary (see cencalvmgrid2bin).\n";
   exit(1);
 } // usage
 
@@ -44,6 +59,11 @@ parseArgs(std::string* pFilenameParams,
 	  std::string* pFilenameOut,
 	  std::string* pFilenameTmp,
 	  int* pCacheSize,
+	  int* pNumThreads,
+	  int* pSortSize,
+	  long* pCheckpointInterval,
+	  bool* pResume,
+	  std::string* pFilenameTelemetry,
 	  int argc,
 	  char** argv)
 { // parseArgs
@@ -51,6 +71,11 @@ parseArgs(std::string* pFilenameParams,
   assert(0 != pFilenameOut);
   assert(0 != pFilenameTmp);
   assert(0 != pCacheSize);
+  assert(0 != pNumThreads);
+  assert(0 != pSortSize);
+  assert(0 != pCheckpointInterval);
+  assert(0 != pResume);
+  assert(0 != pFilenameTelemetry);
 
   extern char* optarg;
 
@@ -58,8 +83,9 @@ parseArgs(std::string* pFilenameParams,
   *pFilenameParams = "";
   *pFilenameOut = "";
   *pFilenameTmp = "";
+  *pFilenameTelemetry = "";
   int c = EOF;
-  while ( (c = getopt(argc, argv, "c:hi:o:t:") ) != EOF) {
+  while ( (c = getopt(argc, argv, "c:hi:j:k:o:rs:t:w:") ) != EOF) {
     switch (c)
       { // switch
       case 'c' : // process -c option
@@ -75,14 +101,34 @@ parseArgs(std::string* pFilenameParams,
 	*pFilenameParams = optarg;
 	nparsed += 2;
 	break;
+      case 'j' : // process -j option
+	*pNumThreads = atoi(optarg);
+	nparsed += 2;
+	break;
+      case 'k' : // process -k option
+	*pCheckpointInterval = atol(optarg);
+	nparsed += 2;
+	break;
       case 'o' : // process -o option
 	*pFilenameOut = optarg;
 	nparsed += 2;
 	break;
+      case 'r' : // process -r option
+	*pResume = true;
+	nparsed += 1;
+	break;
+      case 's' : // process -s option
+	*pSortSize = atoi(optarg);
+	nparsed += 2;
+	break;
       case 't' : // process -t option
 	*pFilenameTmp = optarg;
 	nparsed += 2;
 	break;
+      case 'w' : // process -w option
+	*pFilenameTelemetry = optarg;
+	nparsed += 2;
+	break;
       default :
 	usage();
       } // switch
@@ -90,7 +136,8 @@ parseArgs(std::string* pFilenameParams,
   if (nparsed != argc || 
       0 == pFilenameParams->length() ||
       0 == pFilenameOut->length() ||
-      0 == pFilenameTmp->length())
+      0 == pFilenameTmp->length() ||
+      *pCheckpointInterval < 0)
     usage();
 } // parseArgs
 
@@ -104,15 +151,24 @@ main(int argc,
   std::string filenameTmp = "";
   std::string filenameLog = "";
   int cacheSize = 512;
+  int numThreads = 0;
+  int sortSize = 0;
+  long checkpointInterval = 0;
+  bool resume = false;
+  std::string filenameTelemetry = "";
   const char* description = 
     "U.S. Geological Survey\n"
     "Thomas Brocher, Robert Jachens, Carl Wentworth, Russel Graymer, "
     "Robert Simpson, Brad Aagaard";
   
   parseArgs(&filenameParams, &filenameOut, &filenameTmp, &cacheSize,
-	    argc, argv);
+	    &numThreads, &sortSize, &checkpointInterval, &resume,
+	    &filenameTelemetry, argc, argv);
 
   try {
+    cencalvm::storage::Telemetry telemetry;
+    telemetry.filename(filenameTelemetry.c_str());
+
     cencalvm::create::GridIngester db;
     
     cencalvm::storage::GeomCenCA geom;
@@ -122,6 +178,11 @@ main(int argc,
     db.filenameOut(filenameOut.c_str());
     db.filenameTmp(filenameTmp.c_str());
     db.cacheSize(cacheSize);
+    db.numThreads(numThreads);
+    db.sortSize(sortSize);
+    db.checkpointInterval(checkpointInterval);
+    db.resume(resume);
+    db.telemetry(&telemetry);
     db.description(description);
     db.run();
   } catch (const std::exception& err) {
@@ -0,0 +1,102 @@
+// ======================================================================
+//
+//                           Brad T. Aagaard
+//                        U.S. Geological Survey
+//
+// ======================================================================
+//
+// Application driver to convert an ASCII input grid into the binary
+// input grid format read by cencalvmgen.
+
+#include "cencalvm/create/BinaryGrid.h" // USES BinaryGrid
+
+#include <stdlib.h> // USES exit()
+#include <unistd.h> // USES getopt()
+#include <stdio.h> // USES EOF
+
+#include <iostream> // USES std::cerr
+#include <stdexcept> // USES std::exception
+#include <string> // USES std::string
+#include <assert.h> // USES assert()
+
+// ----------------------------------------------------------------------
+void
+usage(void)
+{ // usage
+  std::cerr
+    << "usage: cencalvmgrid2bin [-h] -i inFile -o outFile\n"
+    << "  -i inFile     ASCII grid input file.\n"
+    << "  -o outFile    Binary grid file created.\n"
+    << "  -h            Display usage and exit.\n"
+    << "\n"
+    << "Binary grid files may be listed in the cencalvmgen parameter file\n"
+    << "in place of ASCII grid files.\n";
+  exit(1);
+} // usage
+
+// ----------------------------------------------------------------------
+void
+parseArgs(std::string* pFilenameIn,
+	  std::string* pFilenameOut,
+	  int argc,
+	  char** argv)
+{ // parseArgs
+  assert(0 != pFilenameIn);
+  assert(0 != pFilenameOut);
+
+  extern char* optarg;
+
+  int nparsed = 1;
+  *pFilenameIn = "";
+  *pFilenameOut = "";
+  int c = EOF;
+  while ( (c = getopt(argc, argv, "hi:o:") ) != EOF) {
+    switch (c)
+      { // switch
+      case 'i' : // process -i option
+	*pFilenameIn = optarg;
+	nparsed += 2;
+	break;
+      case 'o' : // process -o option
+	*pFilenameOut = optarg;
+	nparsed += 2;
+	break;
+      case 'h' : // process -h option
+	nparsed += 1;
+	usage();
+	exit(0);
+	break;
+      default :
+	usage();
+      } // switch
+  } // while
+  if (nparsed != argc || 
+      0 == pFilenameIn->length() ||
+      0 == pFilenameOut->length())
+    usage();
+} // parseArgs
+
+// ----------------------------------------------------------------------
+int
+main(int argc,
+     char* argv[])
+{ // main
+  std::string filenameIn = "";
+  std::string filenameOut = "";
+  
+  parseArgs(&filenameIn, &filenameOut, argc, argv);
+
+  try {
+    cencalvm::create::BinaryGrid::convert(filenameIn.c_str(),
+					  filenameOut.c_str());
+  } catch (const std::exception& err) {
+    std::cerr << err.what();
+    return 1;
+  } catch (...) {
+    return 1;
+  } // catch
+
+  return 0;
+} // main
+
+// End of file
@@ -11,6 +11,8 @@
 #include "cencalvm/create/VMCreator.h" // USES VMCreator
 #include "cencalvm/storage/ErrorHandler.h" // USES VMCreator
 
+#include "cencalvm/storage/Telemetry.h" // USES Telemetry
+
 #include <stdlib.h> // USES exit()
 #include <unistd.h> // USES getopt()
 #include <stdio.h> // USES EOF
@@ -24,12 +26,16 @@ void
 usage(void)
 { // usage
   std::cerr
-    << "usage: cencalvmpack [-h] -i inFile -o outFile\n"
-    << "  -i inFile  Parameter file with list of grid input files\n"
-    << "  -o outFile    Etree database file created.\n"
-    << "  -h            Display usage and exit.\n"
-    << "\n"
-    << "Parameter file is list of grid input files, one per line.\n";
+    << "usage: cencalvmpack [-h] -i inFile -o outFile [-c cacheSize]\n"
+    << "                    [-j numThreads] [-w jsonFile]\n"
+    << "  -i inFile       Unpacked etree database file.\n"
+    << "  -o outFile      Packed etree database file created.\n"
+    << "  -c cacheSize    Size of cache in MB for each database.\n"
+    << "  -j numThreads   Number of threads used to read unpacked database\n"
+    << "                  (default is 1, 0 for number of processors).\n"
+    << "  -w jsonFile     Write telemetry of packing (octants/s, bytes read\n"
+    << "                  and written, ETA) to jsonFile as JSON lines.\n"
+    << "  -h              Display usage and exit.\n";
   exit(1);
 } // usage
 
@@ -38,20 +44,25 @@ void
 parseArgs(std::string* pFilenameIn,
 	  std::string* pFilenameOut,
 	  int* pCacheSize,
+	  int* pNumThreads,
+	  std::string* pFilenameTelemetry,
 	  int argc,
 	  char** argv)
 { // parseArgs
   assert(0 != pFilenameIn);
   assert(0 != pFilenameOut);
   assert(0 != pCacheSize);
+  assert(0 != pNumThreads);
+  assert(0 != pFilenameTelemetry);
 
   extern char* optarg;
 
   int nparsed = 1;
   *pFilenameIn = "";
   *pFilenameOut = "";
+  *pFilenameTelemetry = "";
   int c = EOF;
-  while ( (c = getopt(argc, argv, "c:hi:o:") ) != EOF) {
+  while ( (c = getopt(argc, argv, "c:hi:j:o:w:") ) != EOF) {
     switch (c)
       { // switch
       case 'c': // process -c options
@@ -62,10 +73,18 @@ parseArgs(std::string* pFilenameIn,
 	*pFilenameIn = optarg;
 	nparsed += 2;
 	break;
+      case 'j' : // process -j option
+	*pNumThreads = atoi(optarg);
+	nparsed += 2;
+	break;
       case 'o' : // process -o option
 	*pFilenameOut = optarg;
 	nparsed += 2;
 	break;
+      case 'w' : // process -w option
+	*pFilenameTelemetry = optarg;
+	nparsed += 2;
+	break;
       case 'h' : // process -h option
 	nparsed += 1;
 	usage();
@@ -89,11 +108,19 @@ main(int argc,
   std::string filenameIn = "";
   std::string filenameOut = "";
   int cacheSize = 64;
+  int numThreads = 1;
+  std::string filenameTelemetry = "";
   
-  parseArgs(&filenameIn, &filenameOut, &cacheSize, argc, argv);
+  parseArgs(&filenameIn, &filenameOut, &cacheSize, &numThreads,
+	    &filenameTelemetry, argc, argv);
 
   try {
+    cencalvm::storage::Telemetry telemetry;
+    telemetry.filename(filenameTelemetry.c_str());
+
     cencalvm::create::VMCreator creator;
+    creator.numThreads(numThreads);
+    creator.telemetry(&telemetry);
     creator.packDB(filenameOut.c_str(), filenameIn.c_str(), cacheSize);
   } catch (const std::exception& err) {
     std::cerr << err.what();
@@ -0,0 +1,136 @@
+// ======================================================================
+//
+//                           Brad T. Aagaard
+//                        U.S. Geological Survey
+//
+// ======================================================================
+//
+// Application driver to build a multi-resolution brick pyramid of a
+// packed etree database for the central CA velocity model.
+
+#include "cencalvm/create/PyramidBuilder.h" // USES PyramidBuilder
+
+#include <stdlib.h> // USES exit(), atoi()
+#include <unistd.h> // USES getopt()
+#include <stdio.h> // USES EOF
+
+#include <iostream> // USES std::cerr
+#include <stdexcept> // USES std::exception
+#include <string> // USES std::string
+#include <assert.h> // USES assert()
+
+// ----------------------------------------------------------------------
+void
+usage(void)
+{ // usage
+  std::cerr
+    << "usage: cencalvmpyramid [-h] -i inFile -o outFile -l minLevel\n"
+    << "       -m maxLevel [-c cacheSize]\n"
+    << "  -i inFile       Packed etree database file.\n"
+    << "  -o outFile      Brick pyramid file created.\n"
+    << "  -l minLevel     Coarsest octant level in pyramid.\n"
+    << "  -m maxLevel     Finest octant level in pyramid.\n"
+    << "  -c cacheSize    Size of cache in MB for input database.\n"
+    << "  -h              Display usage and exit.\n"
+    << "\n"
+    << "Fixed resolution queries at levels in the pyramid are answered\n"
+    << "from the pyramid (see -p option of cencalvmquery).\n";
+  exit(1);
+} // usage
+
+// ----------------------------------------------------------------------
+void
+parseArgs(std::string* pFilenameIn,
+	  std::string* pFilenameOut,
+	  int* pMinLevel,
+	  int* pMaxLevel,
+	  int* pCacheSize,
+	  int argc,
+	  char** argv)
+{ // parseArgs
+  assert(0 != pFilenameIn);
+  assert(0 != pFilenameOut);
+  assert(0 != pMinLevel);
+  assert(0 != pMaxLevel);
+  assert(0 != pCacheSize);
+
+  extern char* optarg;
+
+  int nparsed = 1;
+  *pFilenameIn = "";
+  *pFilenameOut = "";
+  *pMinLevel = -1;
+  *pMaxLevel = -1;
+  int c = EOF;
+  while ( (c = getopt(argc, argv, "c:hi:l:m:o:") ) != EOF) {
+    switch (c)
+      { // switch
+      case 'c': // process -c options
+	*pCacheSize = atoi(optarg);
+	nparsed += 2;
+	break;
+      case 'i' : // process -i option
+	*pFilenameIn = optarg;
+	nparsed += 2;
+	break;
+      case 'l' : // process -l option
+	*pMinLevel = atoi(optarg);
+	nparsed += 2;
+	break;
+      case 'm' : // process -m option
+	*pMaxLevel = atoi(optarg);
+	nparsed += 2;
+	break;
+      case 'o' : // process -o option
+	*pFilenameOut = optarg;
+	nparsed += 2;
+	break;
+      case 'h' : // process -h option
+	nparsed += 1;
+	usage();
+	exit(0);
+	break;
+      default :
+	usage();
+      } // switch
+  } // while
+  if (nparsed != argc ||
+      0 == pFilenameIn->length() ||
+      0 == pFilenameOut->length() ||
+      *pMinLevel < 0 ||
+      *pMaxLevel < 0)
+    usage();
+} // parseArgs
+
+// ----------------------------------------------------------------------
+int
+main(int argc,
+     char* argv[])
+{ // main
+  std::string filenameIn = "";
+  std::string filenameOut = "";
+  int minLevel = -1;
+  int maxLevel = -1;
+  int cacheSize = 64;
+
+  parseArgs(&filenameIn, &filenameOut, &minLevel, &maxLevel, &cacheSize,
+	    argc, argv);
+
+  try {
+    cencalvm::create::PyramidBuilder builder;
+    builder.filenameIn(filenameIn.c_str());
+    builder.filenameOut(filenameOut.c_str());
+    builder.levels(minLevel, maxLevel);
+    builder.cacheSize(cacheSize);
+    builder.build();
+  } catch (const std::exception& err) {
+    std::cerr << err.what() << std::endl;
+    return 1;
+  } catch (...) {
+    return 1;
+  } // catch
+
+  return 0;
+} // main
+
+// End of file
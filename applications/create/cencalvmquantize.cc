@@ -0,0 +1,139 @@
+// ======================================================================
+//
+//                           Brad T. Aagaard
+//                        U.S. Geological Survey
+//
+// ======================================================================
+//
+// Application driver to convert an etree database for the central CA
+// velocity model to a compact etree database with quantized payloads.
+
+#include "cencalvm/create/Quantizer.h" // USES Quantizer
+
+#include <stdlib.h> // USES exit(), atoi(), atof()
+#include <unistd.h> // USES getopt()
+#include <stdio.h> // USES EOF
+
+#include <iostream> // USES std::cerr
+#include <stdexcept> // USES std::exception
+#include <string> // USES std::string
+#include <assert.h> // USES assert()
+
+// ----------------------------------------------------------------------
+void
+usage(void)
+{ // usage
+  std::cerr
+    << "usage: cencalvmquantize [-h] -i inFile -o outFile\n"
+    << "         [-e name=bound[,name=bound...]] [-c cacheSize]\n"
+    << "  -i inFile       Etree database file to quantize.\n"
+    << "  -o outFile      Compact etree database file created.\n"
+    << "  -e name=bound   Maximum errors for values (Vp, Vs, Density, Qp,\n"
+    << "                  Qs, DepthFreeSurf); defaults are 0.5 for Vp, Vs,\n"
+    << "                  Density, and DepthFreeSurf and 0.05 for Qp, Qs.\n"
+    << "  -c cacheSize    Size of cache in MB for each database.\n"
+    << "  -h              Display usage and exit.\n";
+  exit(1);
+} // usage
+
+// ----------------------------------------------------------------------
+void
+parseArgs(std::string* pFilenameIn,
+	  std::string* pFilenameOut,
+	  std::string* pBounds,
+	  int* pCacheSize,
+	  int argc,
+	  char** argv)
+{ // parseArgs
+  assert(0 != pFilenameIn);
+  assert(0 != pFilenameOut);
+  assert(0 != pBounds);
+  assert(0 != pCacheSize);
+
+  extern char* optarg;
+
+  int nparsed = 1;
+  *pFilenameIn = "";
+  *pFilenameOut = "";
+  int c = EOF;
+  while ( (c = getopt(argc, argv, "c:e:hi:o:") ) != EOF) {
+    switch (c)
+      { // switch
+      case 'c': // process -c options
+	*pCacheSize = atoi(optarg);
+	nparsed += 2;
+	break;
+      case 'e' : // process -e option
+	*pBounds = optarg;
+	nparsed += 2;
+	break;
+      case 'i' : // process -i option
+	*pFilenameIn = optarg;
+	nparsed += 2;
+	break;
+      case 'o' : // process -o option
+	*pFilenameOut = optarg;
+	nparsed += 2;
+	break;
+      case 'h' : // process -h option
+	nparsed += 1;
+	usage();
+	exit(0);
+	break;
+      default :
+	usage();
+      } // switch
+  } // while
+  if (nparsed != argc ||
+      0 == pFilenameIn->length() ||
+      0 == pFilenameOut->length())
+    usage();
+} // parseArgs
+
+// ----------------------------------------------------------------------
+int
+main(int argc,
+     char* argv[])
+{ // main
+  std::string filenameIn = "";
+  std::string filenameOut = "";
+  std::string bounds = "";
+  int cacheSize = 64;
+
+  parseArgs(&filenameIn, &filenameOut, &bounds, &cacheSize, argc, argv);
+
+  try {
+    cencalvm::create::Quantizer quantizer;
+    quantizer.filenameIn(filenameIn.c_str());
+    quantizer.filenameOut(filenameOut.c_str());
+    quantizer.cacheSize(cacheSize);
+
+    // Error bounds are given as comma separated list of name=bound.
+    std::string::size_type start = 0;
+    while (start < bounds.length()) {
+      std::string::size_type end = bounds.find(',', start);
+      if (std::string::npos == end)
+	end = bounds.length();
+      const std::string token = bounds.substr(start, end-start);
+      const std::string::size_type equals = token.find('=');
+      if (std::string::npos == equals) {
+	std::cerr << "Could not parse error bound '" << token << "'.\n";
+	usage();
+      } // if
+      quantizer.errorBound(token.substr(0, equals).c_str(),
+			   atof(token.substr(equals+1).c_str()));
+      start = end + 1;
+    } // while
+
+    quantizer.quantize();
+  } catch (const std::exception& err) {
+    std::cerr << err.what() << std::endl;
+    return 1;
+  } catch (...) {
+    return 1;
+  } // catch
+
+  return 0;
+} // main
+
+// End of file
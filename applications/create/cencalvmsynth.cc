@@ -0,0 +1,255 @@
+// -*- C++ -*-
+//
+// ======================================================================
+//
+//                           Brad T. Aagaard
+//                        U.S. Geological Survey
+//
+// ======================================================================
+//
+// Application driver to generate a synthetic etree database with the
+// geometry, schema, and structure of the central CA velocity model
+// for scale and performance testing.
+
+#include "cencalvm/create/SynthGenerator.h" // USES SynthGenerator
+#include "cencalvm/storage/Geometry.h" // USES Geometry
+#include "cencalvm/storage/GeomCenCA.h" // USES GeomCenCA
+#include "cencalvm/storage/Telemetry.h" // USES Telemetry
+
+#include <stdlib.h> // USES exit(), atoi(), atof(), strtoul()
+#include <unistd.h> // USES getopt()
+#include <stdio.h> // USES EOF
+
+#include <iostream> // USES std::cerr
+#include <sstream> // USES std::ostringstream
+#include <stdexcept> // USES std::exception
+#include <assert.h> // USES assert()
+
+// ----------------------------------------------------------------------
+void
+usage(void)
+{ // usage
+  std::cerr
+    << "usage: cencalvmsynth [-h] -o outFile -t tmpFile [-n numOctants]\n"
+    << "         [-r resolution] [-l numLayers] [-e maxElev] [-d waterDepth]\n"
+    << "         [-b numBlocks] [-g seed] [-c cacheSize] [-j numThreads]\n"
+    << "         [-s sortSize] [-a] [-w jsonFile]\n"
+    << "  -o outFile     Etree database file created.\n"
+    << "  -t tmpFile     Name of scratch file used in database construction\n"
+    << "                 (root name of sorted runs with -s).\n"
+    << "  -n numOctants  Target number of octants (default is 1000000).\n"
+    << "  -r resolution  Horizontal resolution in m of octants at the\n"
+    << "                 surface (default is 100).\n"
+    << "  -l numLayers   Number of layers with octant size doubling with\n"
+    << "                 depth (default is 4).\n"
+    << "  -e maxElev     Maximum elevation in m of topography (default is\n"
+    << "                 1500, 0 for flat ground surface).\n"
+    << "  -d waterDepth  Maximum depth in m of water offshore (default is\n"
+    << "                 500, 0 for no water).\n"
+    << "  -b numBlocks   Number of fault blocks (default is 6).\n"
+    << "  -g seed        Seed of random number generator (default is 1).\n"
+    << "  -c cacheSize   Size of database cache in MB.\n"
+    << "  -j numThreads  Number of threads used to pack database (default is\n"
+    << "                 number of processors).\n"
+    << "  -s sortSize    Build packed database directly by sorting octants\n"
+    << "                 using sortSize MB of memory.\n"
+    << "  -a             Average database while building it (requires -s).\n"
+    << "  -w jsonFile    Write telemetry of each phase (octants/s, bytes read\n"
+    << "                 and written, ETA) to jsonFile as JSON lines.\n"
+    << "  -h             Display usage and exit.\n"
+    << "\n"
+    << "The same arguments always generate the same database.\n";
+  exit(1);
+} // usage
+
+// ----------------------------------------------------------------------
+void
+parseArgs(std::string* pFilenameOut,
+	  std::string* pFilenameTmp,
+	  long* pNumOctants,
+	  double* pResolution,
+	  int* pNumLayers,
+	  double* pMaxElev,
+	  double* pWaterDepth,
+	  int* pNumBlocks,
+	  unsigned long* pSeed,
+	  int* pCacheSize,
+	  int* pNumThreads,
+	  int* pSortSize,
+	  bool* pAverage,
+	  std::string* pFilenameTelemetry,
+	  int argc,
+	  char** argv)
+{ // parseArgs
+  assert(0 != pFilenameOut);
+  assert(0 != pFilenameTmp);
+  assert(0 != pNumOctants);
+  assert(0 != pResolution);
+  assert(0 != pNumLayers);
+  assert(0 != pMaxElev);
+  assert(0 != pWaterDepth);
+  assert(0 != pNumBlocks);
+  assert(0 != pSeed);
+  assert(0 != pCacheSize);
+  assert(0 != pNumThreads);
+  assert(0 != pSortSize);
+  assert(0 != pAverage);
+  assert(0 != pFilenameTelemetry);
+
+  extern char* optarg;
+
+  int nparsed = 1;
+  *pFilenameOut = "";
+  *pFilenameTmp = "";
+  *pFilenameTelemetry = "";
+  int c = EOF;
+  while ( (c = getopt(argc, argv, "ab:c:d:e:g:hj:l:n:o:r:s:t:w:") ) != EOF) {
+    switch (c)
+      { // switch
+      case 'a' : // process -a option
+	*pAverage = true;
+	nparsed += 1;
+	break;
+      case 'b' : // process -b option
+	*pNumBlocks = atoi(optarg);
+	nparsed += 2;
+	break;
+      case 'c' : // process -c option
+	*pCacheSize = atoi(optarg);
+	nparsed += 2;
+	break;
+      case 'd' : // process -d option
+	*pWaterDepth = atof(optarg);
+	nparsed += 2;
+	break;
+      case 'e' : // process -e option
+	*pMaxElev = atof(optarg);
+	nparsed += 2;
+	break;
+      case 'g' : // process -g option
+	*pSeed = strtoul(optarg, 0, 10);
+	nparsed += 2;
+	break;
+      case 'h' : // process -h option
+	nparsed += 1;
+	usage();
+	exit(0);
+	break;
+      case 'j' : // process -j option
+	*pNumThreads = atoi(optarg);
+	nparsed += 2;
+	break;
+      case 'l' : // process -l option
+	*pNumLayers = atoi(optarg);
+	nparsed += 2;
+	break;
+      case 'n' : // process -n option
+	*pNumOctants = atol(optarg);
+	nparsed += 2;
+	break;
+      case 'o' : // process -o option
+	*pFilenameOut = optarg;
+	nparsed += 2;
+	break;
+      case 'r' : // process -r option
+	*pResolution = atof(optarg);
+	nparsed += 2;
+	break;
+      case 's' : // process -s option
+	*pSortSize = atoi(optarg);
+	nparsed += 2;
+	break;
+      case 't' : // process -t option
+	*pFilenameTmp = optarg;
+	nparsed += 2;
+	break;
+      case 'w' : // process -w option
+	*pFilenameTelemetry = optarg;
+	nparsed += 2;
+	break;
+      default :
+	usage();
+      } // switch
+    } // while
+  if (nparsed != argc ||
+      0 == pFilenameOut->length() ||
+      0 == pFilenameTmp->length() ||
+      *pNumOctants <= 0 ||
+      *pResolution <= 0.0 ||
+      *pNumLayers <= 0 ||
+      *pMaxElev < 0.0 ||
+      *pWaterDepth < 0.0 ||
+      *pNumBlocks <= 0 ||
+      (*pAverage && *pSortSize <= 0))
+    usage();
+} // parseArgs
+
+// ----------------------------------------------------------------------
+int
+main(int argc,
+     char* argv[])
+{ // main
+  std::string filenameOut = "";
+  std::string filenameTmp = "";
+  long numOctants = 1000000;
+  double resolution = 100.0;
+  int numLayers = 4;
+  double maxElev = 1500.0;
+  double waterDepth = 500.0;
+  int numBlocks = 6;
+  unsigned long seed = 1;
+  int cacheSize = 512;
+  int numThreads = 0;
+  int sortSize = 0;
+  bool average = false;
+  std::string filenameTelemetry = "";
+
+  parseArgs(&filenameOut, &filenameTmp, &numOctants, &resolution,
+	    &numLayers, &maxElev, &waterDepth, &numBlocks, &seed,
+	    &cacheSize, &numThreads, &sortSize, &average,
+	    &filenameTelemetry, argc, argv);
+
+  // Record parameters, so the database can be regenerated.
+  std::ostringstream description;
+  description
+    << "Synthetic central CA velocity model\n"
+    << "cencalvmsynth -n " << numOctants << " -r " << resolution
+    << " -l " << numLayers << " -e " << maxElev << " -d " << waterDepth
+    << " -b " << numBlocks << " -g " << seed;
+
+  try {
+    cencalvm::storage::Telemetry telemetry;
+    telemetry.filename(filenameTelemetry.c_str());
+
+    cencalvm::create::SynthGenerator generator;
+
+    cencalvm::storage::GeomCenCA geom;
+
+    generator.geometry(&geom);
+    generator.filenameOut(filenameOut.c_str());
+    generator.filenameTmp(filenameTmp.c_str());
+    generator.cacheSize(cacheSize);
+    generator.numThreads(numThreads);
+    generator.sortSize(sortSize);
+    generator.average(average);
+    generator.numOctants(numOctants);
+    generator.resolution(resolution);
+    generator.numLayers(numLayers);
+    generator.topography(maxElev);
+    generator.water(waterDepth);
+    generator.numFaultBlocks(numBlocks);
+    generator.seed(seed);
+    generator.telemetry(&telemetry);
+    generator.description(description.str().c_str());
+    generator.run();
+  } catch (const std::exception& err) {
+    std::cerr << err.what();
+    return 1;
+  } catch (...) {
+    return 1;
+  } // catch
+
+  return 0;
+} // main
+
+// End of file
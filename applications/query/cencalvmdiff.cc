@@ -0,0 +1,163 @@
+// ======================================================================
+//
+//                           Brad T. Aagaard
+//                        U.S. Geological Survey
+//
+// ======================================================================
+//
+// Application driver to find the differences between two etree
+// databases for the central CA velocity model.
+
+#include "cencalvm/query/VMDiff.h" // USES VMDiff
+
+#include <stdlib.h> // USES exit(), atoi(), atof()
+#include <unistd.h> // USES getopt()
+#include <stdio.h> // USES EOF
+
+#include <iostream> // USES std::cerr
+#include <stdexcept> // USES std::exception
+#include <string> // USES std::string
+#include <assert.h> // USES assert()
+
+// ----------------------------------------------------------------------
+void
+usage(void)
+{ // usage
+  std::cerr
+    << "usage: cencalvmdiff [-h] -a oldFile -b newFile [-o reportFile]\n"
+    << "         [-t name=tol[,name=tol...]] [-r regionLevel] "
+    << "[-c cacheSize]\n"
+    << "  -a oldFile      Etree database for old version of model.\n"
+    << "  -b newFile      Etree database for new version of model.\n"
+    << "  -o reportFile   File listing each added, removed, and changed\n"
+    << "                  octant.\n"
+    << "  -t name=tol     Tolerances for values (Vp, Vs, Density, Qp, Qs,\n"
+    << "                  DepthFreeSurf, FaultBlock, Zone); default is 0.\n"
+    << "  -r regionLevel  Level of octants for summary by region "
+    << "(default is 4).\n"
+    << "  -c cacheSize    Size of cache in MB for each database.\n"
+    << "  -h              Display usage and exit.\n";
+  exit(1);
+} // usage
+
+// ----------------------------------------------------------------------
+void
+parseArgs(std::string* pFilenameOld,
+	  std::string* pFilenameNew,
+	  std::string* pFilenameReport,
+	  std::string* pTolerances,
+	  int* pRegionLevel,
+	  int* pCacheSize,
+	  int argc,
+	  char** argv)
+{ // parseArgs
+  assert(0 != pFilenameOld);
+  assert(0 != pFilenameNew);
+  assert(0 != pFilenameReport);
+  assert(0 != pTolerances);
+  assert(0 != pRegionLevel);
+  assert(0 != pCacheSize);
+
+  extern char* optarg;
+
+  int nparsed = 1;
+  *pFilenameOld = "";
+  *pFilenameNew = "";
+  *pFilenameReport = "";
+  *pTolerances = "";
+  int c = EOF;
+  while ( (c = getopt(argc, argv, "a:b:c:ho:r:t:") ) != EOF) {
+    switch (c)
+      { // switch
+      case 'a' : // process -a option
+	*pFilenameOld = optarg;
+	nparsed += 2;
+	break;
+      case 'b' : // process -b option
+	*pFilenameNew = optarg;
+	nparsed += 2;
+	break;
+      case 'c' : // process -c option
+	*pCacheSize = atoi(optarg);
+	nparsed += 2;
+	break;
+      case 'o' : // process -o option
+	*pFilenameReport = optarg;
+	nparsed += 2;
+	break;
+      case 'r' : // process -r option
+	*pRegionLevel = atoi(optarg);
+	nparsed += 2;
+	break;
+      case 't' : // process -t option
+	*pTolerances = optarg;
+	nparsed += 2;
+	break;
+      case 'h' : // process -h option
+	nparsed += 1;
+	usage();
+	exit(0);
+	break;
+      default :
+	usage();
+      } // switch
+  } // while
+  if (nparsed != argc || 
+      0 == pFilenameOld->length() ||
+      0 == pFilenameNew->length())
+    usage();
+} // parseArgs
+
+// ----------------------------------------------------------------------
+int
+main(int argc,
+     char* argv[])
+{ // main
+  std::string filenameOld = "";
+  std::string filenameNew = "";
+  std::string filenameReport = "";
+  std::string tolerances = "";
+  int regionLevel = 4;
+  int cacheSize = 64;
+  
+  parseArgs(&filenameOld, &filenameNew, &filenameReport, &tolerances,
+	    &regionLevel, &cacheSize, argc, argv);
+
+  try {
+    cencalvm::query::VMDiff vmdiff;
+    vmdiff.filenameOld(filenameOld.c_str());
+    vmdiff.filenameNew(filenameNew.c_str());
+    if (filenameReport.length() > 0)
+      vmdiff.filenameReport(filenameReport.c_str());
+    vmdiff.regionLevel(regionLevel);
+    vmdiff.cacheSize(cacheSize);
+
+    // Tolerances are given as comma separated list of name=tol.
+    std::string::size_type start = 0;
+    while (start < tolerances.length()) {
+      std::string::size_type end = tolerances.find(',', start);
+      if (std::string::npos == end)
+	end = tolerances.length();
+      const std::string token = tolerances.substr(start, end-start);
+      const std::string::size_type equals = token.find('=');
+      if (std::string::npos == equals) {
+	std::cerr << "Could not parse tolerance '" << token << "'.\n";
+	usage();
+      } // if
+      vmdiff.tolerance(token.substr(0, equals).c_str(),
+		       atof(token.substr(equals+1).c_str()));
+      start = end + 1;
+    } // while
+
+    vmdiff.diff();
+  } catch (const std::exception& err) {
+    std::cerr << err.what() << std::endl;
+    return 1;
+  } catch (...) {
+    return 1;
+  } // catch
+
+  return 0;
+} // main
+
+// End of file
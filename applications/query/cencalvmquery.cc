@@ -10,6 +10,7 @@
 
 #include "cencalvm/query/VMQuery.h" // USES VMQuery
 #include "cencalvm/storage/ErrorHandler.h" // USES ErrorHandler
+#include "cencalvm/storage/CacheMonitor.h" // USES CacheMonitor
 
 #include <stdlib.h> // USES exit()
 #include <unistd.h> // USES getopt()
@@ -33,7 +34,8 @@ usage(void)
   std::cerr
     << "usage: cencalvmquery [-h] -i fileIn -o fileOut -d dbfile\n"
     << "       [-l logfile] [-t queryType] [-r res] [-e dbextfile]\n"
-    << "       [-c cacheSize] [-s squashLimit]\n"
+    << "       [-c cacheSize] [-s squashLimit] [-p pyramidfile]\n"
+    << "       [-T tracefile]\n"
     << "\n"
     << "  -h            Display usage and exit.\n"
     << "  -i fileIn     File containing list of locations: 'lon lat elev'.\n"
@@ -43,8 +45,11 @@ usage(void)
     << "  -l logfile    Log file for warnings about no data for locations.\n"
     << "  -t queryType  Type of query {'maxres', 'fixedres', 'waveres'}\n"
     << "  -r res        Resolution for query (not needed for maxres queries)\n"
-    << "  -c cacheSize  Size of cache in MB to use in query\n"
+    << "  -c cacheSize  Size of cache in MB to use in query ('auto' to size\n"
+    << "                cache from available memory and queries).\n"
     << "  -s squashLim  Turn on squashing of topography and set limit\n"
+    << "  -p pyramid    Brick pyramid of dbfile for fixedres queries.\n"
+    << "  -T tracefile  Record queries in tracefile for cencalvmreplay.\n"
     << "\n"
     << "Each line of the output file will have the following values:\n"
     << "  0: longitude (WGS84)\n"
@@ -79,7 +84,9 @@ parseArgs(std::string* pFilenameIn,
 	  std::string* pFilenameOut,
 	  std::string* pFilenameDB,
 	  std::string* pFilenameDBExt,
+	  std::string* pFilenamePyramid,
 	  std::string* pFilenameLog,
+	  std::string* pFilenameTrace,
 	  std::string* pQueryType,
 	  double* pQueryRes,
 	  int* pCacheSize,
@@ -91,7 +98,9 @@ parseArgs(std::string* pFilenameIn,
   assert(0 != pFilenameOut);
   assert(0 != pFilenameDB);
   assert(0 != pFilenameDBExt);
+  assert(0 != pFilenamePyramid);
   assert(0 != pFilenameLog);
+  assert(0 != pFilenameTrace);
   assert(0 != pQueryType);
   assert(0 != pQueryRes);
   assert(0 != pCacheSize);
@@ -104,13 +113,16 @@ parseArgs(std::string* pFilenameIn,
   *pFilenameOut = "";
   *pFilenameDB = "";
   *pFilenameDBExt = "";
+  *pFilenamePyramid = "";
   *pFilenameLog = "";
+  *pFilenameTrace = "";
   int c = EOF;
-  while ( (c = getopt(argc, argv, "c:d:e:hi:l:o:r:s:t:") ) != EOF) {
+  while ( (c = getopt(argc, argv, "c:d:e:hi:l:o:p:r:s:t:T:") ) != EOF) {
     switch (c)
       { // switch
       case 'c' : // process -c option
-	*pCacheSize = atoi(optarg);
+	*pCacheSize = (0 == strcasecmp(optarg, "auto")) ?
+	  cencalvm::storage::CacheMonitor::AUTOSIZE : atoi(optarg);
 	nparsed += 2;
 	break;
       case 'd' : // process -d option
@@ -138,10 +150,18 @@ parseArgs(std::string* pFilenameIn,
 	*pFilenameOut = optarg;
 	nparsed += 2;
 	break;
+      case 'p' : // process -p option
+	*pFilenamePyramid = optarg;
+	nparsed += 2;
+	break;
       case 't' : // process -t option
 	*pQueryType = optarg;
 	nparsed += 2;
 	break;
+      case 'T' : // process -T option
+	*pFilenameTrace = optarg;
+	nparsed += 2;
+	break;
       case 'r': // process -r option
 	*pQueryRes = atof(optarg);
 	nparsed += 2;
@@ -174,7 +194,9 @@ main(int argc,
   std::string filenameOut = "";
   std::string filenameDB = "";
   std::string filenameDBExt = "";
+  std::string filenamePyramid = "";
   std::string filenameLog = "";
+  std::string filenameTrace = "";
   std::string queryType = "maxres";
   double queryRes = 0.0;
   int cacheSize = 128;
@@ -183,7 +205,7 @@ main(int argc,
   
   // Parse command line arguments
   parseArgs(&filenameIn, &filenameOut, &filenameDB, &filenameDBExt,
-	    &filenameLog, &queryType, &queryRes, &cacheSize, &squashLimit,
+	    &filenamePyramid, &filenameLog, &filenameTrace, &queryType, &queryRes, &cacheSize, &squashLimit,
 	    argc, argv);
 
   // Create query
@@ -229,6 +251,24 @@ main(int argc,
     } // if
   } // if
 
+  // Set brick pyramid filename if given
+  if ("" != filenamePyramid) {
+    query.filenamePyramid(filenamePyramid.c_str());
+    if (cencalvm::storage::ErrorHandler::OK != pErrHandler->status()) {
+      std::cerr << pErrHandler->message();
+      return 1;
+    } // if
+  } // if
+
+  // Set trace filename if given
+  if ("" != filenameTrace) {
+    query.filenameTrace(filenameTrace.c_str());
+    if (cencalvm::storage::ErrorHandler::OK != pErrHandler->status()) {
+      std::cerr << pErrHandler->message();
+      return 1;
+    } // if
+  } // if
+
   // Turn on squashing if requested
   if (squashLimit != squashDefault) {
     query.squash(true, squashLimit);
@@ -0,0 +1,175 @@
+// ======================================================================
+//
+//                           Brad T. Aagaard
+//                        U.S. Geological Survey
+//
+// ======================================================================
+//
+// C++ application for replaying a trace of queries (recorded with
+// cencalvmquery -T or VMQuery::filenameTrace()) against a database
+// and reporting throughput and latency.
+
+#include "cencalvm/query/QueryReplayer.h" // USES QueryReplayer
+#include "cencalvm/storage/CacheMonitor.h" // USES CacheMonitor
+
+#include <stdlib.h> // USES exit(), atoi()
+#include <unistd.h> // USES getopt()
+#include <stdio.h> // USES EOF
+#include <strings.h> // USES strcasecmp()
+
+#include <iostream> // USES std::cerr
+#include <stdexcept> // USES std::exception
+#include <assert.h> // USES assert()
+
+#include <string> // USES std::string
+
+// ----------------------------------------------------------------------
+// Dump usage to std::cerr
+void
+usage(void)
+{ // usage
+  std::cerr
+    << "usage: cencalvmreplay [-h] -i tracefile -d dbfile [-e dbextfile]\n"
+    << "       [-p pyramidfile] [-c cacheSize] [-j numThreads] [-o jsonFile]\n"
+    << "       [-s]\n"
+    << "\n"
+    << "  -h            Display usage and exit.\n"
+    << "  -i tracefile  Trace of queries to replay.\n"
+    << "  -d dbfile     Etree database file to query.\n"
+    << "  -e dbextfile  Etree extended database file to query.\n"
+    << "  -p pyramid    Brick pyramid of dbfile for fixedres queries.\n"
+    << "  -c cacheSize  Size of cache in MB of each database in each thread\n"
+    << "                or 'auto' to size caches from available memory\n"
+    << "                and queries (default is 128).\n"
+    << "  -j numThreads Number of threads replaying queries; 0 uses all\n"
+    << "                hardware threads (default is 1).\n"
+    << "  -o jsonFile   Write results to jsonFile as JSON.\n"
+    << "  -s            Silent; do not write summary of results.\n"
+    << std::endl;
+} // usage
+
+// ----------------------------------------------------------------------
+// Parse command line arguments
+void
+parseArgs(std::string* pFilenameTrace,
+	  std::string* pFilenameDB,
+	  std::string* pFilenameDBExt,
+	  std::string* pFilenamePyramid,
+	  std::string* pFilenameJSON,
+	  int* pCacheSize,
+	  int* pNumThreads,
+	  bool* pQuiet,
+	  int argc,
+	  char** argv)
+{ // parseArgs
+  assert(0 != pFilenameTrace);
+  assert(0 != pFilenameDB);
+  assert(0 != pFilenameDBExt);
+  assert(0 != pFilenamePyramid);
+  assert(0 != pFilenameJSON);
+  assert(0 != pCacheSize);
+  assert(0 != pNumThreads);
+  assert(0 != pQuiet);
+
+  extern char* optarg;
+
+  int nparsed = 1;
+  int c = EOF;
+  while ( (c = getopt(argc, argv, "c:d:e:hi:j:o:p:s") ) != EOF) {
+    switch (c)
+      { // switch
+      case 'c' : // process -c option
+	*pCacheSize = (0 == strcasecmp(optarg, "auto")) ?
+	  cencalvm::storage::CacheMonitor::AUTOSIZE : atoi(optarg);
+	nparsed += 2;
+	break;
+      case 'd' : // process -d option
+	*pFilenameDB = optarg;
+	nparsed += 2;
+	break;
+      case 'e' : // process -e option
+	*pFilenameDBExt = optarg;
+	nparsed += 2;
+	break;
+      case 'h' : // process -h option
+	nparsed += 1;
+	usage();
+	exit(0);
+	break;
+      case 'i' : // process -i option
+	*pFilenameTrace = optarg;
+	nparsed += 2;
+	break;
+      case 'j' : // process -j option
+	*pNumThreads = atoi(optarg);
+	nparsed += 2;
+	break;
+      case 'o' : // process -o option
+	*pFilenameJSON = optarg;
+	nparsed += 2;
+	break;
+      case 'p' : // process -p option
+	*pFilenamePyramid = optarg;
+	nparsed += 2;
+	break;
+      case 's' : // process -s option
+	*pQuiet = true;
+	nparsed += 1;
+	break;
+      default :
+	usage();
+	exit(1);
+      } // switch
+  } // while
+  if (nparsed != argc ||
+      0 == pFilenameTrace->length() ||
+      0 == pFilenameDB->length() ||
+      *pCacheSize <= 0 ||
+      *pNumThreads < 0) {
+    usage();
+    exit(1);
+  } // if
+} // parseArgs
+
+// ----------------------------------------------------------------------
+// main
+int
+main(int argc,
+     char* argv[])
+{ // main
+  std::string filenameTrace = "";
+  std::string filenameDB = "";
+  std::string filenameDBExt = "";
+  std::string filenamePyramid = "";
+  std::string filenameJSON = "";
+  int cacheSize = 128;
+  int numThreads = 1;
+  bool quiet = false;
+
+  // Parse command line arguments
+  parseArgs(&filenameTrace, &filenameDB, &filenameDBExt, &filenamePyramid,
+	    &filenameJSON, &cacheSize, &numThreads, &quiet, argc, argv);
+
+  try {
+    cencalvm::query::QueryReplayer replayer;
+    replayer.filenameTrace(filenameTrace.c_str());
+    replayer.filename(filenameDB.c_str());
+    replayer.filenameExt(filenameDBExt.c_str());
+    replayer.filenamePyramid(filenamePyramid.c_str());
+    replayer.cacheSize(cacheSize);
+    replayer.cacheSizeExt(cacheSize);
+    replayer.numThreads(numThreads);
+    replayer.filenameJSON(filenameJSON.c_str());
+    replayer.quiet(quiet);
+    replayer.run();
+  } catch (const std::exception& err) {
+    std::cerr << err.what();
+    return 1;
+  } catch (...) {
+    return 1;
+  } // catch
+
+  return 0;
+} // main
+
+// End of file
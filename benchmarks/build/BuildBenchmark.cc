@@ -0,0 +1,622 @@
+// -*- C++ -*-
+//
+// ======================================================================
+//
+//                           Brad T. Aagaard
+//                        U.S. Geological Survey
+//
+// {LicenseText}
+//
+// ======================================================================
+//
+
+#include <portinfo>
+
+#include "BuildBenchmark.h" // implementation of class methods
+
+#include "cencalvm/create/VMCreator.h" // USES VMCreator
+#include "cencalvm/create/GridParser.h" // USES GridParser
+#include "cencalvm/create/GridIngester.h" // USES GridIngester
+#include "cencalvm/average/Averager.h" // USES Averager
+#include "cencalvm/storage/Geometry.h" // USES Geometry
+#include "cencalvm/storage/GeomCenCA.h" // USES GeomCenCA
+#include "cencalvm/storage/Telemetry.h" // USES Telemetry
+
+#if defined(ENABLE_VSGRADER)
+#include "VsGrader.h" // USES VsGrader
+#endif
+
+extern "C" {
+#include "etree.h"
+}
+
+#include <random> // USES std::mt19937
+#include <chrono> // USES std::chrono::steady_clock
+
+#include <math.h> // USES sin(), exp(), fabs()
+#include <stdio.h> // USES fopen(), fprintf(), fclose(), remove()
+#include <time.h> // USES time()
+#include <sys/stat.h> // USES stat()
+#include <sys/resource.h> // USES getrusage()
+
+#include <iostream> // USES std::cout
+#include <iomanip> // USES std::setw(), std::setprecision()
+#include <fstream> // USES std::ofstream
+#include <stdexcept> // USES std::runtime_error
+#include <sstream> // USES std::ostringstream
+#include <assert.h> // USES assert()
+
+// ----------------------------------------------------------------------
+const double cencalvm::create::BuildBenchmark::_ORIGINX = 0.25;
+const double cencalvm::create::BuildBenchmark::_ORIGINY = 0.125;
+const double cencalvm::create::BuildBenchmark::_BASINDEPTH = 4000.0;
+const double cencalvm::create::BuildBenchmark::_PERTURBATION = 0.02;
+const int cencalvm::create::BuildBenchmark::_NUMFAULTBLOCKS = 4;
+const double cencalvm::create::BuildBenchmark::_GRADEFRACTION = 0.4;
+
+// ----------------------------------------------------------------------
+/// Measurements at start of stage.
+struct cencalvm::create::BuildBenchmark::StageStruct {
+  std::chrono::steady_clock::time_point timeBegin; ///< Wall clock time
+  double sCPU; ///< User and system CPU time in s
+  storage::Telemetry::ProcessIOStruct io; ///< Bytes read and written
+}; // StageStruct
+
+// ----------------------------------------------------------------------
+// Get user and system CPU time of process in s.
+static
+double
+_cpuTime(void)
+{ // _cpuTime
+  struct rusage usage;
+  if (0 != getrusage(RUSAGE_SELF, &usage))
+    return 0.0;
+  return usage.ru_utime.tv_sec + 1.0e-6 * usage.ru_utime.tv_usec +
+    usage.ru_stime.tv_sec + 1.0e-6 * usage.ru_stime.tv_usec;
+} // _cpuTime
+
+// ----------------------------------------------------------------------
+// Constructor
+cencalvm::create::BuildBenchmark::BuildBenchmark(void) :
+  _filenameRoot("benchbuild"),
+  _filenameJSON(""),
+  _resolution(200.0),
+  _resHoriz(0.0),
+  _resVert(0.0),
+  _gridBytes(0),
+  _seed(1),
+  _numX(128),
+  _numY(128),
+  _numZ(64),
+  _numGrids(4),
+  _cacheSize(128),
+  _sortSize(0),
+  _numThreads(0),
+  _isPeakReset(true),
+  _quiet(false)
+{ // constructor
+} // constructor
+
+// ----------------------------------------------------------------------
+// Destructor
+cencalvm::create::BuildBenchmark::~BuildBenchmark(void)
+{ // destructor
+} // destructor
+
+// ----------------------------------------------------------------------
+// Generate the grids, run the stages, and write results.
+void
+cencalvm::create::BuildBenchmark::run(void)
+{ // run
+  _results.clear();
+  _isPeakReset = true;
+
+  _generate();
+  _ingest();
+  if (0 == _sortSize)
+    _pack();
+  _average();
+#if defined(ENABLE_VSGRADER)
+  _grade();
+#endif
+
+  _writeJSON();
+} // run
+
+// ----------------------------------------------------------------------
+// Generate grid files and parameter files.
+void
+cencalvm::create::BuildBenchmark::_generate(void)
+{ // _generate
+  StageStruct stage;
+  _beginStage(&stage);
+
+  storage::GeomCenCA geom;
+  const int level = _level(&geom);
+  const etree_tick_t rootLen = 0x80000000;
+  const etree_tick_t tickLen = rootLen >> level;
+  const etree_tick_t x0 = etree_tick_t(_ORIGINX * rootLen / tickLen) * tickLen;
+  const etree_tick_t y0 = etree_tick_t(_ORIGINY * rootLen / tickLen) * tickLen;
+  if (double(x0) + double(_numX) * tickLen > rootLen ||
+      double(y0) + double(_numY) * tickLen > rootLen) {
+    std::ostringstream msg;
+    msg << "Grids with " << _numX << " x " << _numY << " points at a "
+	<< "resolution of " << _resHoriz << " m extend beyond the geometry.";
+    throw std::runtime_error(msg.str());
+  } // if
+
+  etree_addr_t addr;
+  addr.x = x0;
+  addr.y = y0;
+  addr.z = 0;
+  addr.t = 0;
+  addr.level = level;
+  addr.type = ETREE_LEAF;
+
+  // Elevations of points are the centroids of the octants, so the
+  // points map back to the same octants when they are ingested.
+  double lon = 0.0;
+  double lat = 0.0;
+  double elev = 0.0;
+  geom.addrToLonLatElev(&lon, &lat, &elev, &addr);
+  std::vector<double> elevs(_numZ);
+  for (int iZ=0; iZ < _numZ; ++iZ) {
+    if (0 != geom.lonLatElevToAddr(&addr, lon, lat, -(iZ+0.5)*_resVert)) {
+      std::ostringstream msg;
+      msg << "Elevation of " << -(iZ+0.5)*_resVert << " m is outside the "
+	  << "geometry.";
+      throw std::runtime_error(msg.str());
+    } // if
+    geom.addrToLonLatElev(&lon, &lat, &elevs[iZ], &addr);
+  } // for
+
+  // Use raw output of generator, which is the same on all platforms.
+  std::mt19937 generator(_seed);
+  const double scale = 1.0 / 4294967296.0;
+
+  const std::string filenameParams = _filename("_grids.txt");
+  FILE* fileParams = fopen(filenameParams.c_str(), "w");
+  if (0 == fileParams) {
+    std::ostringstream msg;
+    msg << "Could not open grid parameter file '" << filenameParams
+	<< "' for writing.";
+    throw std::runtime_error(msg.str());
+  } // if
+
+  if (!_quiet)
+    std::cout << "Generating " << _numGrids << " grid files with "
+	      << _numX << " x " << _numY << " x " << _numZ << " points at a "
+	      << "resolution of " << _resHoriz << " m..." << std::endl;
+
+  _gridBytes = 0;
+  const int zoneBasin = 2;
+  const int zoneBasement = 3;
+  const int volumeId = 0;
+  for (int iGrid=0; iGrid < _numGrids; ++iGrid) {
+    const int yBegin = int(double(iGrid) * _numY / _numGrids);
+    const int yEnd = int(double(iGrid+1) * _numY / _numGrids);
+
+    std::ostringstream filenameGrid;
+    filenameGrid << _filenameRoot << "_grid" << iGrid << ".dat";
+    fprintf(fileParams, "%s\n", filenameGrid.str().c_str());
+
+    FILE* fileGrid = fopen(filenameGrid.str().c_str(), "w");
+    if (0 == fileGrid) {
+      fclose(fileParams);
+      std::ostringstream msg;
+      msg << "Could not open grid file '" << filenameGrid.str()
+	  << "' for writing.";
+      throw std::runtime_error(msg.str());
+    } // if
+
+    // Header gives resolution in km and number of points.
+    const int numPoints = _numX * (yEnd - yBegin) * _numZ;
+    fprintf(fileGrid, "%g %g %d %d %d %d\n", _resHoriz/1.0e+3,
+	    _resVert/1.0e+3, _numX, yEnd - yBegin, _numZ, numPoints);
+    for (int iY=yBegin; iY < yEnd; ++iY)
+      for (int iX=0; iX < _numX; ++iX) {
+	addr.x = x0 + iX * tickLen;
+	addr.y = y0 + iY * tickLen;
+	geom.addrToLonLatElev(&lon, &lat, &elev, &addr);
+
+	// Basins deepen and shallow smoothly across the grids.
+	const double u = double(iX) / _numX;
+	const double v = double(iY) / _numY;
+	const double basinDepth = 0.5 * _BASINDEPTH *
+	  (1.0 + sin(2.0*M_PI*u) * cos(3.0*M_PI*v));
+	const int faultBlock = 1 + iX * _NUMFAULTBLOCKS / _numX;
+	for (int iZ=0; iZ < _numZ; ++iZ) {
+	  const double depth = -elevs[iZ];
+	  double vp = 0.0;
+	  int zone = 0;
+	  if (depth < basinDepth) {
+	    vp = 1700.0 + 0.8 * depth;
+	    zone = zoneBasin;
+	  } else {
+	    vp = 5000.0 + 1800.0 * (1.0 - exp(-(depth - basinDepth)/15000.0));
+	    zone = zoneBasement;
+	  } // if/else
+	  vp *= 1.0 + _PERTURBATION * (2.0 * scale * generator() - 1.0);
+
+	  // Vs, density, and Q from Brocher (2005, 2008) with wave
+	  // speeds in km/s and density in g/cm^3.
+	  const double vpK = vp / 1.0e+3;
+	  const double vsK =
+	    0.7858 + vpK*(-1.2344 + vpK*(0.7949 + vpK*(-0.1238 + vpK*0.0064)));
+	  const double density =
+	    vpK*(1.6612 + vpK*(-0.4721 + vpK*(0.0671 + vpK*(-0.0043 +
+							    vpK*0.000106))));
+	  const double qs = -16.0 + vsK*(104.13 + vsK*(-25.225 + vsK*8.2184));
+	  fprintf(fileGrid,
+		  "%.7f %.7f %.4f %.4f %.4f %.4f %.1f %.1f %.4f %d %d %d\n",
+		  lon, lat, elevs[iZ]/1.0e+3, vpK, vsK, density, 2.0*qs, qs,
+		  depth/1.0e+3, faultBlock, zone, volumeId);
+	} // for
+      } // for
+
+    const bool writeError = 0 != ferror(fileGrid);
+    if (0 != fclose(fileGrid) || writeError) {
+      fclose(fileParams);
+      std::ostringstream msg;
+      msg << "Error while writing grid file '" << filenameGrid.str() << "'.";
+      throw std::runtime_error(msg.str());
+    } // if
+
+    _gridBytes += _fileSize(filenameGrid.str());
+  } // for
+  if (0 != fclose(fileParams)) {
+    std::ostringstream msg;
+    msg << "Error while writing grid parameter file '" << filenameParams
+	<< "'.";
+    throw std::runtime_error(msg.str());
+  } // if
+
+  _endStage(stage, "generate", filenameParams, size_t(_numX)*_numY*_numZ,
+	    _gridBytes);
+} // _generate
+
+// ----------------------------------------------------------------------
+// Ingest grids.
+void
+cencalvm::create::BuildBenchmark::_ingest(void)
+{ // _ingest
+  const std::string filenameParams = _filename("_grids.txt");
+  const std::string filenameTmp = _filename("_tmp.etree");
+  const std::string filenamePacked = _filename("_packed.etree");
+  const char* description = "Synthetic model for build benchmarks";
+  remove(filenameTmp.c_str());
+  remove(filenamePacked.c_str());
+
+  storage::GeomCenCA geom;
+  StageStruct stage;
+  _beginStage(&stage);
+
+  if (_sortSize > 0) {
+    // Points are sorted and appended to the packed database.
+    GridIngester ingester;
+    ingester.filenameParams(filenameParams.c_str());
+    ingester.filenameOut(filenamePacked.c_str());
+    ingester.filenameTmp(filenameTmp.c_str());
+    ingester.cacheSize(_cacheSize);
+    ingester.description(description);
+    ingester.geometry(&geom);
+    ingester.numThreads(_numThreads);
+    ingester.sortSize(_sortSize);
+    ingester.quiet(_quiet);
+    ingester.run();
+    _endStage(stage, "ingest", filenamePacked, size_t(_numX)*_numY*_numZ,
+	      _fileSize(filenamePacked));
+    return;
+  } // if
+
+  // Same as GridIngester::run() without packing, so packing is timed
+  // separately.
+  std::vector<std::string> filenameGrids(_numGrids);
+  for (int iGrid=0; iGrid < _numGrids; ++iGrid) {
+    std::ostringstream filenameGrid;
+    filenameGrid << _filenameRoot << "_grid" << iGrid << ".dat";
+    filenameGrids[iGrid] = filenameGrid.str();
+  } // for
+
+  VMCreator creator;
+  creator.quiet(_quiet);
+  creator.numThreads(_numThreads);
+  creator.openDB(filenameTmp.c_str(), _cacheSize, description);
+
+  GridParser parser;
+  parser.geometry(&geom);
+  parser.numThreads(_numThreads);
+  parser.quiet(_quiet);
+  parser.ingest(&creator, &filenameGrids[0], _numGrids);
+  creator.closeDB();
+
+  _endStage(stage, "ingest", filenameTmp, size_t(_numX)*_numY*_numZ,
+	    _fileSize(filenameTmp));
+} // _ingest
+
+// ----------------------------------------------------------------------
+// Pack database.
+void
+cencalvm::create::BuildBenchmark::_pack(void)
+{ // _pack
+  const std::string filenameTmp = _filename("_tmp.etree");
+  const std::string filenamePacked = _filename("_packed.etree");
+
+  StageStruct stage;
+  _beginStage(&stage);
+
+  VMCreator creator;
+  creator.quiet(_quiet);
+  creator.numThreads(_numThreads);
+  creator.packDB(filenamePacked.c_str(), filenameTmp.c_str(), _cacheSize);
+
+  _endStage(stage, "pack", filenamePacked, size_t(_numX)*_numY*_numZ,
+	    _fileSize(filenamePacked));
+} // _pack
+
+// ----------------------------------------------------------------------
+// Average database.
+void
+cencalvm::create::BuildBenchmark::_average(void)
+{ // _average
+  const std::string filenamePacked = _filename("_packed.etree");
+  const std::string filenameAvg = _filename("_avg.etree");
+  remove(filenameAvg.c_str());
+
+  StageStruct stage;
+  _beginStage(&stage);
+
+  average::Averager averager;
+  averager.filenameIn(filenamePacked.c_str());
+  averager.filenameOut(filenameAvg.c_str());
+  averager.quiet(_quiet);
+  averager.average();
+
+  _endStage(stage, "average", filenameAvg, size_t(_numX)*_numY*_numZ,
+	    _fileSize(filenameAvg));
+} // _average
+
+// ----------------------------------------------------------------------
+// Grade database.
+void
+cencalvm::create::BuildBenchmark::_grade(void)
+{ // _grade
+#if defined(ENABLE_VSGRADER)
+  const std::string filenameAvg = _filename("_avg.etree");
+  const std::string filenameGraded = _filename("_graded.etree");
+  const std::string filenameGradedTmp = _filename("_graded.tmp");
+  const std::string filenameParams = _filename("_grader.txt");
+  remove(filenameGraded.c_str());
+
+  // The graded box starts at the middle of the grids; its length runs
+  // toward the first points along the length of the grids and its
+  // width toward the last points across the width of the grids.
+  storage::GeomCenCA geom;
+  const int level = _level(&geom);
+  const etree_tick_t rootLen = 0x80000000;
+  const etree_tick_t tickLen = rootLen >> level;
+  etree_addr_t addr;
+  addr.x = etree_tick_t(_ORIGINX * rootLen / tickLen) * tickLen +
+    (_numX/2) * tickLen;
+  addr.y = etree_tick_t(_ORIGINY * rootLen / tickLen) * tickLen +
+    (_numY/2) * tickLen;
+  addr.z = 0;
+  addr.t = 0;
+  addr.level = level;
+  addr.type = ETREE_LEAF;
+  double lon = 0.0;
+  double lat = 0.0;
+  double elev = 0.0;
+  geom.addrToLonLatElev(&lon, &lat, &elev, &addr);
+
+  const double domainLen = _GRADEFRACTION * _numX * _resHoriz;
+  const double domainWidth = _GRADEFRACTION * _numY * _resHoriz;
+  const double domainHt = 0.5 * _numZ * _resVert;
+  std::ofstream fout(filenameParams.c_str());
+  if (!fout.is_open()) {
+    std::ostringstream msg;
+    msg << "Could not open grader parameter file '" << filenameParams
+	<< "' for writing.";
+    throw std::runtime_error(msg.str());
+  } // if
+  fout
+    << std::setprecision(10)
+    << "VsGrader {\n"
+    << "  vs-min = 500.0\n"
+    << "  vs-gradient-max = 1.0\n"
+    << "  domain-length = " << domainLen << "\n"
+    << "  domain-width = " << domainWidth << "\n"
+    << "  domain-height = " << domainHt << "\n"
+    << "  swcorner-lon = " << lon << "\n"
+    << "  swcorner-lat = " << lat << "\n"
+    << "  swcorner-elev = " << -0.5 * _resVert << "\n"
+    << "  resolution-vert = " << _resVert << "\n"
+    << "  query-type = maxres\n"
+    << "}\n";
+  fout.close();
+
+  StageStruct stage;
+  _beginStage(&stage);
+
+  vsgrader::VsGrader grader;
+  grader.filenameParams(filenameParams.c_str());
+  grader.filenameIn(filenameAvg.c_str());
+  grader.filenameOut(filenameGraded.c_str());
+  grader.filenameTmp(filenameGradedTmp.c_str());
+  grader.cacheSize(_cacheSize);
+  grader.numThreads(_numThreads);
+  grader.geometry(&geom);
+  grader.quiet(_quiet);
+  grader.run();
+
+  const size_t numPoints = size_t(1 + domainLen / _resHoriz) *
+    size_t(1 + domainWidth / _resHoriz) * size_t(1 + domainHt / _resVert);
+  _endStage(stage, "grade", filenameGraded, numPoints,
+	    _fileSize(filenameGraded));
+#endif
+} // _grade
+
+// ----------------------------------------------------------------------
+// Start measuring stage.
+void
+cencalvm::create::BuildBenchmark::_beginStage(StageStruct* pStage)
+{ // _beginStage
+  assert(0 != pStage);
+
+  // Peak of stage starts from the memory in use now.
+  if (!storage::Telemetry::resetPeakMemory())
+    _isPeakReset = false;
+  storage::Telemetry::processIO(&pStage->io);
+  pStage->sCPU = _cpuTime();
+  pStage->timeBegin = std::chrono::steady_clock::now();
+} // _beginStage
+
+// ----------------------------------------------------------------------
+// Finish measuring stage and add result.
+void
+cencalvm::create::BuildBenchmark::_endStage(const StageStruct& stage,
+					    const char* name,
+					    const std::string& filename,
+					    const size_t numPoints,
+					    const uint64_t outputBytes)
+{ // _endStage
+  assert(0 != name);
+
+  typedef std::chrono::duration<double> seconds;
+
+  ResultStruct result;
+  result.sWall =
+    seconds(std::chrono::steady_clock::now() - stage.timeBegin).count();
+  result.sCPU = _cpuTime() - stage.sCPU;
+  result.peakMemory = storage::Telemetry::peakMemory();
+  storage::Telemetry::ProcessIOStruct io;
+  storage::Telemetry::processIO(&io);
+  result.syscallBytesRead = io.syscallRead - stage.io.syscallRead;
+  result.syscallBytesWritten = io.syscallWritten - stage.io.syscallWritten;
+  result.deviceBytesRead = io.deviceRead - stage.io.deviceRead;
+  result.deviceBytesWritten = io.deviceWritten - stage.io.deviceWritten;
+  result.name = name;
+  result.filename = filename;
+  result.numPoints = numPoints;
+  result.outputBytes = outputBytes;
+  _results.push_back(result);
+
+  if (_quiet)
+    return;
+
+  const double MB = 1024.0 * 1024.0;
+  std::cout
+    << std::left << std::setw(10) << result.name << std::right
+    << std::fixed << std::setprecision(2)
+    << std::setw(9) << result.sWall << " s wall"
+    << std::setw(9) << result.sCPU << " s CPU"
+    << ", peak " << std::setprecision(1) << result.peakMemory / MB << " MB"
+    << ", wrote " << result.syscallBytesWritten / MB << " MB"
+    << ", output " << result.outputBytes / MB << " MB"
+    << ", " << std::setprecision(0)
+    << ((result.sWall > 0.0) ? result.numPoints / result.sWall : 0.0)
+    << " points/s" << std::endl;
+} // _endStage
+
+// ----------------------------------------------------------------------
+// Get size of file.
+uint64_t
+cencalvm::create::BuildBenchmark::_fileSize(const std::string& filename)
+{ // _fileSize
+  struct stat fileInfo;
+  return (0 == stat(filename.c_str(), &fileInfo)) ? fileInfo.st_size : 0;
+} // _fileSize
+
+// ----------------------------------------------------------------------
+// Get name of file.
+std::string
+cencalvm::create::BuildBenchmark::_filename(const char* suffix) const
+{ // _filename
+  assert(0 != suffix);
+  return _filenameRoot + suffix;
+} // _filename
+
+// ----------------------------------------------------------------------
+// Get level of octants in grids.
+int
+cencalvm::create::BuildBenchmark::_level(storage::GeomCenCA* pGeom)
+{ // _level
+  assert(0 != pGeom);
+
+  const int level = pGeom->level(_resolution);
+  if (level < 0 || level >= ETREE_MAXLEVEL) {
+    std::ostringstream msg;
+    msg << "Resolution of " << _resolution << " m does not match the size "
+	<< "of octants at any level in the geometry.";
+    throw std::runtime_error(msg.str());
+  } // if
+  _resHoriz = pGeom->edgeLen(level);
+  _resVert = _resHoriz / pGeom->vertExag();
+  return level;
+} // _level
+
+// ----------------------------------------------------------------------
+// Write results as JSON.
+void
+cencalvm::create::BuildBenchmark::_writeJSON(void) const
+{ // _writeJSON
+  if (_filenameJSON.empty())
+    return;
+
+  std::ofstream fout(_filenameJSON.c_str());
+  if (!fout.is_open()) {
+    std::ostringstream msg;
+    msg << "Could not open benchmark results file '" << _filenameJSON
+	<< "' for writing.";
+    throw std::runtime_error(msg.str());
+  } // if
+
+  fout
+    << "{\n"
+    << "  \"benchmark\": \"build\",\n"
+    << "  \"time\": " << time(0) << ",\n"
+    << "  \"numX\": " << _numX << ",\n"
+    << "  \"numY\": " << _numY << ",\n"
+    << "  \"numZ\": " << _numZ << ",\n"
+    << "  \"numPoints\": " << size_t(_numX)*_numY*_numZ << ",\n"
+    << "  \"numGrids\": " << _numGrids << ",\n"
+    << "  \"gridBytes\": " << _gridBytes << ",\n"
+    << "  \"resolution\": " << _resHoriz << ",\n"
+    << "  \"resolutionVert\": " << _resVert << ",\n"
+    << "  \"cacheSize\": " << _cacheSize << ",\n"
+    << "  \"sortSize\": " << _sortSize << ",\n"
+    << "  \"numThreads\": " << _numThreads << ",\n"
+    << "  \"seed\": " << _seed << ",\n"
+    << "  \"peakMemoryPerStage\": " << ((_isPeakReset) ? "true" : "false")
+    << ",\n"
+    << "  \"stages\": [";
+  const size_t numResults = _results.size();
+  for (size_t i=0; i < numResults; ++i) {
+    const ResultStruct& result = _results[i];
+    fout
+      << ((i > 0) ? "," : "") << "\n"
+      << "    {\"name\": \"" << result.name << "\""
+      << ", \"filename\": \"" << result.filename << "\""
+      << ", \"numPoints\": " << result.numPoints
+      << ", \"sWall\": " << result.sWall
+      << ", \"sCPU\": " << result.sCPU
+      << ", \"pointsPerSecond\": "
+      << ((result.sWall > 0.0) ? result.numPoints / result.sWall : 0.0)
+      << ", \"peakMemory\": " << result.peakMemory
+      << ", \"syscallBytesRead\": " << result.syscallBytesRead
+      << ", \"syscallBytesWritten\": " << result.syscallBytesWritten
+      << ", \"deviceBytesRead\": " << result.deviceBytesRead
+      << ", \"deviceBytesWritten\": " << result.deviceBytesWritten
+      << ", \"outputBytes\": " << result.outputBytes
+      << "}";
+  } // for
+  fout << "\n  ]\n}\n";
+  if (!fout.good()) {
+    std::ostringstream msg;
+    msg << "Error while writing benchmark results file '" << _filenameJSON
+	<< "'.";
+    throw std::runtime_error(msg.str());
+  } // if
+} // _writeJSON
+
+// End of file
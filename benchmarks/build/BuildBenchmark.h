@@ -0,0 +1,266 @@
+// -*- C++ -*-
+//
+// ======================================================================
+//
+//                           Brad T. Aagaard
+//                        U.S. Geological Survey
+//
+// {LicenseText}
+//
+// ======================================================================
+//
+
+/** @file benchmarks/build/BuildBenchmark.h
+ *
+ * @brief C++ end-to-end benchmark of building a velocity model
+ * database.
+ *
+ * Synthetic grid files in the ASCII format read by
+ * create::GridIngester are generated for a block of octants at a
+ * single level: a layered model with basins of varying depth, fault
+ * blocks across the length of the block, and small random
+ * perturbations. The same parameters always generate the same grids,
+ * so results can be compared across commits.
+ *
+ * The stages of building the database are run in order, as the
+ * applications run them:
+ *
+ *   @li ingest Parse the grids into an unpacked database (cencalvmgen);
+ *     with a positive sort size the points are sorted and appended to
+ *     a packed database instead and there is no pack stage.
+ *   @li pack Pack the database (cencalvmpack).
+ *   @li average Spatially average the database (cencalvmavg).
+ *   @li grade Limit the gradient in Vs over a box in the middle of the
+ *     block (gradecencalvm); only when configured with the vsgrader
+ *     extension.
+ *
+ * Each stage reports its wall clock and CPU time, its peak resident
+ * set size (see storage::Telemetry::peakMemory()), the bytes read and
+ * written by the process (see storage::Telemetry::processIO()), and
+ * the size of its output.
+ */
+
+#if !defined(cencalvm_create_buildbenchmark_h)
+#define cencalvm_create_buildbenchmark_h
+
+#include <string> // HASA std::string
+#include <vector> // HASA std::vector
+#include <inttypes.h> // USES uint64_t
+#include <sys/types.h> // USES size_t
+
+namespace cencalvm {
+  namespace create {
+    class BuildBenchmark;
+  } // namespace create
+  namespace storage {
+    class GeomCenCA; // USES GeomCenCA
+  } // namespace storage
+} // namespace cencalvm
+
+/// C++ end-to-end benchmark of building a velocity model database.
+class cencalvm::create::BuildBenchmark
+{ // BuildBenchmark
+
+public :
+  // PUBLIC METHODS /////////////////////////////////////////////////////
+
+  /// Constructor
+  BuildBenchmark(void);
+
+  /// Destructor
+  ~BuildBenchmark(void);
+
+  /** Set root name of grid and database files.
+   *
+   * @param filename Root name of files
+   */
+  void filenameRoot(const char* filename);
+
+  /** Set name of file for JSON results.
+   *
+   * @param filename Name of file ("" for none)
+   */
+  void filenameJSON(const char* filename);
+
+  /** Set number of points in the grids along each direction.
+   *
+   * @param numX Number of points along length of model
+   * @param numY Number of points along width of model
+   * @param numZ Number of points with depth
+   */
+  void numPoints(const int numX,
+		 const int numY,
+		 const int numZ);
+
+  /** Set number of grid files the points are divided into.
+   *
+   * @param num Number of grid files
+   */
+  void numGrids(const int num);
+
+  /** Set horizontal resolution of the grids (rounded to the edge
+   * length of the nearest level in the database).
+   *
+   * @param res Horizontal resolution in m
+   */
+  void resolution(const double res);
+
+  /** Set size of etree cache used by each stage.
+   *
+   * @param size Size of cache in MB
+   */
+  void cacheSize(const int size);
+
+  /** Set size of memory used to sort points while ingesting.
+   *
+   * @param size Size of memory in MB (0 to insert points into an
+   * unpacked database and pack it)
+   */
+  void sortSize(const int size);
+
+  /** Set number of threads used by each stage.
+   *
+   * @param num Number of threads (0 for number of processors)
+   */
+  void numThreads(const int num);
+
+  /** Set seed of random number generator for perturbations.
+   *
+   * @param seed Seed
+   */
+  void seed(const unsigned long seed);
+
+  /** Set flag indicating benchmark should be quiet (no summary).
+   *
+   * @param flag True for quiet operation, false to write summary
+   */
+  void quiet(const bool flag);
+
+  /// Generate the grids, run the stages, and write results.
+  void run(void);
+
+private :
+  // PRIVATE STRUCTS ////////////////////////////////////////////////////
+
+  /// Result of stage.
+  struct ResultStruct {
+    std::string name; ///< Name of stage
+    std::string filename; ///< Name of output file of stage
+    double sWall; ///< Wall clock time in s
+    double sCPU; ///< User and system CPU time in s
+    uint64_t peakMemory; ///< Peak resident set size in bytes
+    uint64_t syscallBytesRead; ///< Bytes read through system calls
+    uint64_t syscallBytesWritten; ///< Bytes written through system calls
+    uint64_t deviceBytesRead; ///< Bytes read from storage device
+    uint64_t deviceBytesWritten; ///< Bytes written to storage device
+    uint64_t outputBytes; ///< Size of output file in bytes
+    size_t numPoints; ///< Number of points processed by stage
+  }; // ResultStruct
+
+  struct StageStruct; ///< Measurements at start of stage
+
+private :
+  // PRIVATE METHODS ////////////////////////////////////////////////////
+
+  /// Generate grid files and parameter files.
+  void _generate(void);
+
+  /// Ingest grids.
+  void _ingest(void);
+
+  /// Pack database.
+  void _pack(void);
+
+  /// Average database.
+  void _average(void);
+
+  /// Grade database.
+  void _grade(void);
+
+  /** Start measuring stage.
+   *
+   * @param pStage Pointer to measurements at start of stage
+   */
+  void _beginStage(StageStruct* pStage);
+
+  /** Finish measuring stage and add result.
+   *
+   * @param stage Measurements at start of stage
+   * @param name Name of stage
+   * @param filename Name of output file of stage
+   * @param numPoints Number of points processed by stage
+   * @param outputBytes Size of output of stage in bytes
+   */
+  void _endStage(const StageStruct& stage,
+		 const char* name,
+		 const std::string& filename,
+		 const size_t numPoints,
+		 const uint64_t outputBytes);
+
+  /** Get size of file.
+   *
+   * @param filename Name of file
+   *
+   * @returns Size of file in bytes (0 if file does not exist)
+   */
+  static uint64_t _fileSize(const std::string& filename);
+
+  /** Get name of file.
+   *
+   * @param suffix Suffix appended to root name of files
+   *
+   * @returns Name of file
+   */
+  std::string _filename(const char* suffix) const;
+
+  /// Write results as JSON.
+  void _writeJSON(void) const;
+
+  /** Get level of octants in grids, setting horizontal and vertical
+   * resolution of grids.
+   *
+   * @param pGeom Pointer to geometry of database
+   *
+   * @returns Level of octants
+   */
+  int _level(storage::GeomCenCA* pGeom);
+
+  BuildBenchmark(const BuildBenchmark& b); ///< Not implemented
+  const BuildBenchmark& operator=(const BuildBenchmark& b); ///< Not implemented
+
+private :
+  // PRIVATE MEMBERS ////////////////////////////////////////////////////
+
+  std::string _filenameRoot; ///< Root name of files
+  std::string _filenameJSON; ///< Name of file for JSON results
+  std::vector<ResultStruct> _results; ///< Results of stages
+
+  double _resolution; ///< Horizontal resolution in m
+  double _resHoriz; ///< Horizontal resolution of grids in m
+  double _resVert; ///< Vertical resolution of grids in m
+  uint64_t _gridBytes; ///< Size of grid files in bytes
+  unsigned long _seed; ///< Seed of random number generator
+  int _numX; ///< Number of points along length of model
+  int _numY; ///< Number of points along width of model
+  int _numZ; ///< Number of points with depth
+  int _numGrids; ///< Number of grid files
+  int _cacheSize; ///< Size of etree cache in MB
+  int _sortSize; ///< Size of memory used to sort points in MB
+  int _numThreads; ///< Number of threads
+  bool _isPeakReset; ///< True if peak memory is reset for each stage
+  bool _quiet; ///< True if not writing summary
+
+  static const double _ORIGINX; ///< Origin of grids along x (fraction of root)
+  static const double _ORIGINY; ///< Origin of grids along y (fraction of root)
+  static const double _BASINDEPTH; ///< Maximum depth of basins in m
+  static const double _PERTURBATION; ///< Amplitude of perturbations
+  static const int _NUMFAULTBLOCKS; ///< Number of fault blocks
+  static const double _GRADEFRACTION; ///< Size of graded box (fraction of grids)
+
+}; // BuildBenchmark
+
+#include "BuildBenchmark.icc" // inline methods
+
+#endif // cencalvm_create_buildbenchmark_h
+
+// End of file
@@ -0,0 +1,206 @@
+// -*- C++ -*-
+//
+// ======================================================================
+//
+//                           Brad T. Aagaard
+//                        U.S. Geological Survey
+//
+// ======================================================================
+//
+// Application driver for end-to-end benchmark of building the
+// velocity model database from synthetic grids.
+
+#include "BuildBenchmark.h" // USES BuildBenchmark
+
+#include <stdlib.h> // USES exit(), atoi(), atof(), strtoul()
+#include <unistd.h> // USES getopt()
+#include <stdio.h> // USES EOF
+
+#include <iostream> // USES std::cerr
+#include <stdexcept> // USES std::exception
+#include <assert.h> // USES assert()
+
+// ----------------------------------------------------------------------
+void
+usage(void)
+{ // usage
+  std::cerr
+    << "usage: benchbuild [-h] [-d fileRoot] [-o jsonFile] [-x numX] [-y numY]\n"
+    << "         [-z numZ] [-n numGrids] [-r resolution] [-c cacheSize]\n"
+    << "         [-S sortSize] [-t numThreads] [-g seed] [-s]\n"
+    << "  -d fileRoot    Root name of grid and database files generated for\n"
+    << "                 the benchmark (default is benchbuild).\n"
+    << "  -o jsonFile    Write results to jsonFile as JSON.\n"
+    << "  -x numX        Number of points along length of grids (default is\n"
+    << "                 128).\n"
+    << "  -y numY        Number of points along width of grids (default is\n"
+    << "                 128).\n"
+    << "  -z numZ        Number of points with depth (default is 64).\n"
+    << "  -n numGrids    Number of grid files (default is 4).\n"
+    << "  -r resolution  Horizontal resolution in m of grids (default is 200).\n"
+    << "  -c cacheSize   Size of database cache in MB (default is 128).\n"
+    << "  -S sortSize    Size of memory in MB used to sort points while\n"
+    << "                 ingesting; 0 ingests into an unpacked database and\n"
+    << "                 packs it (default is 0).\n"
+    << "  -t numThreads  Number of threads (default is 0, the number of\n"
+    << "                 processors).\n"
+    << "  -g seed        Seed of random number generator (default is 1).\n"
+    << "  -s             Silent; do not write summary of results.\n"
+    << "  -h             Display usage and exit.\n";
+  exit(1);
+} // usage
+
+// ----------------------------------------------------------------------
+void
+parseArgs(std::string* pFilenameRoot,
+	  std::string* pFilenameJSON,
+	  int* pNumX,
+	  int* pNumY,
+	  int* pNumZ,
+	  int* pNumGrids,
+	  double* pResolution,
+	  int* pCacheSize,
+	  int* pSortSize,
+	  int* pNumThreads,
+	  unsigned long* pSeed,
+	  bool* pQuiet,
+	  int argc,
+	  char** argv)
+{ // parseArgs
+  assert(0 != pFilenameRoot);
+  assert(0 != pFilenameJSON);
+  assert(0 != pNumX);
+  assert(0 != pNumY);
+  assert(0 != pNumZ);
+  assert(0 != pNumGrids);
+  assert(0 != pResolution);
+  assert(0 != pCacheSize);
+  assert(0 != pSortSize);
+  assert(0 != pNumThreads);
+  assert(0 != pSeed);
+  assert(0 != pQuiet);
+
+  extern char* optarg;
+
+  int nparsed = 1;
+  int c = EOF;
+  while ( (c = getopt(argc, argv, "S:c:d:g:hn:o:r:st:x:y:z:") ) != EOF) {
+    switch (c)
+      { // switch
+      case 'S' : // process -S option
+	*pSortSize = atoi(optarg);
+	nparsed += 2;
+	break;
+      case 'c' : // process -c option
+	*pCacheSize = atoi(optarg);
+	nparsed += 2;
+	break;
+      case 'd' : // process -d option
+	*pFilenameRoot = optarg;
+	nparsed += 2;
+	break;
+      case 'g' : // process -g option
+	*pSeed = strtoul(optarg, 0, 10);
+	nparsed += 2;
+	break;
+      case 'h' : // process -h option
+	nparsed += 1;
+	usage();
+	exit(0);
+	break;
+      case 'n' : // process -n option
+	*pNumGrids = atoi(optarg);
+	nparsed += 2;
+	break;
+      case 'o' : // process -o option
+	*pFilenameJSON = optarg;
+	nparsed += 2;
+	break;
+      case 'r' : // process -r option
+	*pResolution = atof(optarg);
+	nparsed += 2;
+	break;
+      case 's' : // process -s option
+	*pQuiet = true;
+	nparsed += 1;
+	break;
+      case 't' : // process -t option
+	*pNumThreads = atoi(optarg);
+	nparsed += 2;
+	break;
+      case 'x' : // process -x option
+	*pNumX = atoi(optarg);
+	nparsed += 2;
+	break;
+      case 'y' : // process -y option
+	*pNumY = atoi(optarg);
+	nparsed += 2;
+	break;
+      case 'z' : // process -z option
+	*pNumZ = atoi(optarg);
+	nparsed += 2;
+	break;
+      default :
+	usage();
+      } // switch
+    } // while
+  if (nparsed != argc ||
+      0 == pFilenameRoot->length() ||
+      *pNumX <= 0 ||
+      *pNumY <= 0 ||
+      *pNumZ <= 0 ||
+      *pNumGrids <= 0 ||
+      *pNumGrids > *pNumY ||
+      *pResolution <= 0.0 ||
+      *pCacheSize <= 0 ||
+      *pSortSize < 0 ||
+      *pNumThreads < 0)
+    usage();
+} // parseArgs
+
+// ----------------------------------------------------------------------
+int
+main(int argc,
+     char* argv[])
+{ // main
+  std::string filenameRoot = "benchbuild";
+  std::string filenameJSON = "";
+  int numX = 128;
+  int numY = 128;
+  int numZ = 64;
+  int numGrids = 4;
+  double resolution = 200.0;
+  int cacheSize = 128;
+  int sortSize = 0;
+  int numThreads = 0;
+  unsigned long seed = 1;
+  bool quiet = false;
+
+  parseArgs(&filenameRoot, &filenameJSON, &numX, &numY, &numZ, &numGrids,
+	    &resolution, &cacheSize, &sortSize, &numThreads, &seed, &quiet,
+	    argc, argv);
+
+  try {
+    cencalvm::create::BuildBenchmark benchmark;
+    benchmark.filenameRoot(filenameRoot.c_str());
+    benchmark.filenameJSON(filenameJSON.c_str());
+    benchmark.numPoints(numX, numY, numZ);
+    benchmark.numGrids(numGrids);
+    benchmark.resolution(resolution);
+    benchmark.cacheSize(cacheSize);
+    benchmark.sortSize(sortSize);
+    benchmark.numThreads(numThreads);
+    benchmark.seed(seed);
+    benchmark.quiet(quiet);
+    benchmark.run();
+  } catch (const std::exception& err) {
+    std::cerr << err.what();
+    return 1;
+  } catch (...) {
+    return 1;
+  } // catch
+
+  return 0;
+} // main
+
+// End of file
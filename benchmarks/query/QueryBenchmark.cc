@@ -0,0 +1,524 @@
+// -*- C++ -*-
+//
+// ======================================================================
+//
+//                           Brad T. Aagaard
+//                        U.S. Geological Survey
+//
+// {LicenseText}
+//
+// ======================================================================
+//
+
+#include "QueryBenchmark.h" // implementation of class methods
+
+#include "cencalvm/query/VMQuery.h" // USES VMQuery
+#include "cencalvm/create/SynthGenerator.h" // USES SynthGenerator
+#include "cencalvm/storage/Geometry.h" // USES Geometry::precedes()
+#include "cencalvm/storage/GeomCenCA.h" // USES GeomCenCA
+#include "cencalvm/storage/Projector.h" // USES Projector
+#include "cencalvm/storage/ErrorHandler.h" // USES ErrorHandler
+#include "cencalvm/storage/Telemetry.h" // USES Telemetry::processIO()
+
+extern "C" {
+#include "etree.h"
+}
+
+#include <random> // USES std::mt19937
+#include <chrono> // USES std::chrono::steady_clock
+#include <algorithm> // USES std::sort(), std::nth_element()
+
+#include <time.h> // USES time()
+#include <string.h> // USES strcmp()
+
+#include <iostream> // USES std::cout
+#include <iomanip> // USES std::setw(), std::setprecision()
+#include <fstream> // USES std::ofstream
+#include <stdexcept> // USES std::runtime_error
+#include <sstream> // USES std::ostringstream
+#include <assert.h> // USES assert()
+
+// ----------------------------------------------------------------------
+const double cencalvm::query::QueryBenchmark::_ELEVMIN = -25000.0;
+const double cencalvm::query::QueryBenchmark::_ELEVMAX = 0.0;
+const double cencalvm::query::QueryBenchmark::_SQUASHLIMIT = -2000.0;
+const int cencalvm::query::QueryBenchmark::_NUMCOLUMNPOINTS = 100;
+const int cencalvm::query::QueryBenchmark::_EXTSCALE = 4;
+const int cencalvm::query::QueryBenchmark::_SORTSIZE = 256;
+
+// ----------------------------------------------------------------------
+/// Point with its etree address.
+struct cencalvm::query::QueryBenchmark::MortonStruct {
+  etree_addr_t addr; ///< Address of point at maximum level
+  PointStruct point; ///< Location of point
+}; // MortonStruct
+
+// ----------------------------------------------------------------------
+// Constructor
+cencalvm::query::QueryBenchmark::QueryBenchmark(void) :
+  _filenameRoot("benchquery"),
+  _filenameJSON(""),
+  _numOctants(1000000),
+  _resolution(100.0),
+  _numQueries(100000),
+  _cacheSize(128),
+  _fixedRes(400.0),
+  _wavePeriod(1.0),
+  _seed(1),
+  _nsTimer(0.0),
+  _quiet(false)
+{ // constructor
+} // constructor
+
+// ----------------------------------------------------------------------
+// Destructor
+cencalvm::query::QueryBenchmark::~QueryBenchmark(void)
+{ // destructor
+} // destructor
+
+// ----------------------------------------------------------------------
+// Generate the databases, run the benchmarks, and write results.
+void
+cencalvm::query::QueryBenchmark::run(void)
+{ // run
+  RegionStruct region;
+  RegionStruct regionExt;
+  _generate(&region, _filenameRoot + ".etree", _resolution);
+  _generate(&regionExt, _filenameRoot + "_ext.etree",
+	    _EXTSCALE * _resolution);
+
+  _results.clear();
+  _timerOverhead();
+
+  std::vector<PointStruct> points;
+  _points(&points, region, "random");
+  _benchGeometry(points);
+
+  // Points for queries with the extended model cover the region of
+  // the extended model, so most of them are outside the detailed
+  // model.
+  const char* patterns[] = { "random", "morton", "column" };
+  const int numPatterns = sizeof(patterns) / sizeof(const char*);
+  for (int iExt=0; iExt < 2; ++iExt) {
+    const bool extended = (1 == iExt);
+    for (int iPattern=0; iPattern < numPatterns; ++iPattern) {
+      _points(&points, (extended) ? regionExt : region, patterns[iPattern]);
+      for (int queryType=VMQuery::MAXRES;
+	   queryType <= VMQuery::WAVERES;
+	   ++queryType) {
+	_benchQuery(points, queryType, false, extended, patterns[iPattern]);
+	_benchQuery(points, queryType, true, extended, patterns[iPattern]);
+      } // for
+    } // for
+  } // for
+
+  _writeJSON();
+} // run
+
+// ----------------------------------------------------------------------
+// Generate database.
+void
+cencalvm::query::QueryBenchmark::_generate(RegionStruct* pRegion,
+					   const std::string& filename,
+					   const double resolution) const
+{ // _generate
+  assert(0 != pRegion);
+
+  // Average the database as the distributed model is, so queries at
+  // coarser resolutions find octants.
+  const std::string filenameTmp = filename + ".tmp";
+
+  storage::GeomCenCA geom;
+  create::SynthGenerator generator;
+  generator.geometry(&geom);
+  generator.filenameOut(filename.c_str());
+  generator.filenameTmp(filenameTmp.c_str());
+  generator.numOctants(_numOctants);
+  generator.resolution(resolution);
+  generator.seed(_seed);
+  generator.sortSize(_SORTSIZE);
+  generator.average(true);
+  generator.quiet(_quiet);
+  generator.description("Synthetic model for query benchmarks");
+  generator.run();
+  generator.region(&pRegion->x0, &pRegion->y0,
+		   &pRegion->lenX, &pRegion->lenY);
+} // _generate
+
+// ----------------------------------------------------------------------
+// Generate query points.
+void
+cencalvm::query::QueryBenchmark::_points(std::vector<PointStruct>* pPoints,
+					 const RegionStruct& region,
+					 const char* pattern) const
+{ // _points
+  assert(0 != pPoints);
+  assert(0 != pattern);
+
+  const bool isColumn = (0 == strcmp(pattern, "column"));
+  const bool isMorton = (0 == strcmp(pattern, "morton"));
+  const size_t numPerColumn = (isColumn) ? _NUMCOLUMNPOINTS : 1;
+
+  // Use raw output of generator, which is the same on all platforms.
+  std::mt19937 generator(_seed);
+  const double scale = 1.0 / 4294967296.0;
+
+  storage::GeomCenCA geom;
+  etree_addr_t addr;
+  addr.z = 0;
+  addr.t = 0;
+  addr.level = ETREE_MAXLEVEL;
+  addr.type = ETREE_LEAF;
+
+  pPoints->resize(_numQueries);
+  for (size_t iPoint=0; iPoint < _numQueries; iPoint += numPerColumn) {
+    addr.x = region.x0 + etree_tick_t(scale * generator() * region.lenX);
+    addr.y = region.y0 + etree_tick_t(scale * generator() * region.lenY);
+    double lon = 0.0;
+    double lat = 0.0;
+    double elev = 0.0;
+    geom.addrToLonLatElev(&lon, &lat, &elev, &addr);
+    for (size_t i=0; i < numPerColumn && iPoint+i < _numQueries; ++i) {
+      PointStruct& point = (*pPoints)[iPoint+i];
+      point.lon = lon;
+      point.lat = lat;
+      point.elev = (isColumn) ?
+	_ELEVMAX - (_ELEVMAX - _ELEVMIN) * i / (numPerColumn - 1) :
+	_ELEVMIN + (_ELEVMAX - _ELEVMIN) * scale * generator();
+    } // for
+  } // for
+
+  if (isMorton) {
+    std::vector<MortonStruct> sorted(_numQueries);
+    for (size_t iPoint=0; iPoint < _numQueries; ++iPoint) {
+      const PointStruct& point = (*pPoints)[iPoint];
+      MortonStruct& morton = sorted[iPoint];
+      morton.point = point;
+      morton.addr.level = ETREE_MAXLEVEL;
+      morton.addr.type = ETREE_LEAF;
+      geom.lonLatElevToAddr(&morton.addr, point.lon, point.lat, point.elev);
+    } // for
+    std::sort(sorted.begin(), sorted.end(), _mortonBefore);
+    for (size_t iPoint=0; iPoint < _numQueries; ++iPoint)
+      (*pPoints)[iPoint] = sorted[iPoint].point;
+  } // if
+} // _points
+
+// ----------------------------------------------------------------------
+// Check whether point comes before another in etree (Morton) order.
+bool
+cencalvm::query::QueryBenchmark::_mortonBefore(const MortonStruct& a,
+					       const MortonStruct& b)
+{ // _mortonBefore
+  return storage::Geometry::precedes(a.addr, b.addr);
+} // _mortonBefore
+
+// ----------------------------------------------------------------------
+// Time mapping between geographic coordinates and etree addresses and
+// the projection.
+void
+cencalvm::query::QueryBenchmark::_benchGeometry(const std::vector<PointStruct>& points)
+{ // _benchGeometry
+  typedef std::chrono::steady_clock clock;
+  typedef std::chrono::duration<double, std::nano> nanoseconds;
+
+  const size_t numPoints = points.size();
+  std::vector<double> samples(numPoints);
+  std::vector<etree_addr_t> addrs(numPoints);
+
+  storage::GeomCenCA geom;
+  storage::Projector* pProj = geom.projector();
+  assert(0 != pProj);
+
+  ResultStruct result;
+  result.queryType = "";
+  result.pattern = "random";
+  result.squash = false;
+  result.extended = false;
+  storage::Telemetry::ProcessIOStruct ioBegin;
+  storage::Telemetry::ProcessIOStruct ioEnd;
+
+  result.name = "GeomCenCA::lonLatElevToAddr";
+  result.numNoData = 0;
+  storage::Telemetry::processIO(&ioBegin);
+  for (size_t iPoint=0; iPoint < numPoints; ++iPoint) {
+    const PointStruct& point = points[iPoint];
+    etree_addr_t& addr = addrs[iPoint];
+    addr.level = ETREE_MAXLEVEL;
+    addr.type = ETREE_LEAF;
+    const clock::time_point t0 = clock::now();
+    const int err = geom.lonLatElevToAddr(&addr, point.lon, point.lat,
+					  point.elev);
+    samples[iPoint] = nanoseconds(clock::now() - t0).count();
+    if (0 != err)
+      ++result.numNoData;
+  } // for
+  storage::Telemetry::processIO(&ioEnd);
+  result.syscallBytesRead = ioEnd.syscallRead - ioBegin.syscallRead;
+  result.deviceBytesRead = ioEnd.deviceRead - ioBegin.deviceRead;
+  _addResult(&result, &samples);
+
+  result.name = "GeomCenCA::addrToLonLatElev";
+  result.numNoData = 0;
+  storage::Telemetry::processIO(&ioBegin);
+  for (size_t iPoint=0; iPoint < numPoints; ++iPoint) {
+    double lon = 0.0;
+    double lat = 0.0;
+    double elev = 0.0;
+    const clock::time_point t0 = clock::now();
+    geom.addrToLonLatElev(&lon, &lat, &elev, &addrs[iPoint]);
+    samples[iPoint] = nanoseconds(clock::now() - t0).count();
+  } // for
+  storage::Telemetry::processIO(&ioEnd);
+  result.syscallBytesRead = ioEnd.syscallRead - ioBegin.syscallRead;
+  result.deviceBytesRead = ioEnd.deviceRead - ioBegin.deviceRead;
+  _addResult(&result, &samples);
+
+  result.name = "Projector::project";
+  result.numNoData = 0;
+  storage::Telemetry::processIO(&ioBegin);
+  for (size_t iPoint=0; iPoint < numPoints; ++iPoint) {
+    const PointStruct& point = points[iPoint];
+    double x = 0.0;
+    double y = 0.0;
+    const clock::time_point t0 = clock::now();
+    pProj->project(&x, &y, point.lon, point.lat);
+    samples[iPoint] = nanoseconds(clock::now() - t0).count();
+  } // for
+  storage::Telemetry::processIO(&ioEnd);
+  result.syscallBytesRead = ioEnd.syscallRead - ioBegin.syscallRead;
+  result.deviceBytesRead = ioEnd.deviceRead - ioBegin.deviceRead;
+  _addResult(&result, &samples);
+} // _benchGeometry
+
+// ----------------------------------------------------------------------
+// Time queries.
+void
+cencalvm::query::QueryBenchmark::_benchQuery(const std::vector<PointStruct>& points,
+					     const int queryType,
+					     const bool squash,
+					     const bool extended,
+					     const char* pattern)
+{ // _benchQuery
+  assert(0 != pattern);
+
+  typedef std::chrono::steady_clock clock;
+  typedef std::chrono::duration<double, std::nano> nanoseconds;
+
+  const std::string filename = _filenameRoot + ".etree";
+  const std::string filenameExt = _filenameRoot + "_ext.etree";
+
+  VMQuery query;
+  storage::ErrorHandler* pErrHandler = query.errorHandler();
+  assert(0 != pErrHandler);
+
+  query.filename(filename.c_str());
+  query.cacheSize(_cacheSize);
+  if (extended) {
+    query.filenameExt(filenameExt.c_str());
+    query.cacheSizeExt(_cacheSize);
+  } // if
+  if (squash)
+    query.squash(true, _SQUASHLIMIT);
+  query.open();
+  if (storage::ErrorHandler::OK != pErrHandler->status())
+    throw std::runtime_error(pErrHandler->message());
+
+  ResultStruct result;
+  switch (queryType)
+    { // switch
+    case VMQuery::MAXRES :
+      result.queryType = "maxres";
+      break;
+    case VMQuery::FIXEDRES :
+      result.queryType = "fixedres";
+      query.queryRes(_fixedRes);
+      break;
+    case VMQuery::WAVERES :
+      result.queryType = "waveres";
+      query.queryRes(_wavePeriod);
+      break;
+    default :
+      throw std::logic_error("Unknown query type.");
+    } // switch
+  query.queryType(VMQuery::QueryEnum(queryType));
+  if (storage::ErrorHandler::OK != pErrHandler->status())
+    throw std::runtime_error(pErrHandler->message());
+
+  result.name = "VMQuery::query";
+  result.pattern = pattern;
+  result.squash = squash;
+  result.extended = extended;
+  result.numNoData = 0;
+
+  const int numVals = 9;
+  double* pVals = new double[numVals];
+
+  const size_t numPoints = points.size();
+  std::vector<double> samples(numPoints);
+  storage::Telemetry::ProcessIOStruct ioBegin;
+  storage::Telemetry::ProcessIOStruct ioEnd;
+  storage::Telemetry::processIO(&ioBegin);
+  for (size_t iPoint=0; iPoint < numPoints; ++iPoint) {
+    const PointStruct& point = points[iPoint];
+    const clock::time_point t0 = clock::now();
+    query.query(&pVals, numVals, point.lon, point.lat, point.elev);
+    samples[iPoint] = nanoseconds(clock::now() - t0).count();
+
+    if (storage::ErrorHandler::OK != pErrHandler->status()) {
+      if (storage::ErrorHandler::ERROR == pErrHandler->status()) {
+	delete[] pVals; pVals = 0;
+	throw std::runtime_error(pErrHandler->message());
+      } // if
+      ++result.numNoData;
+      pErrHandler->resetStatus();
+    } // if
+  } // for
+  storage::Telemetry::processIO(&ioEnd);
+  delete[] pVals; pVals = 0;
+  query.close();
+
+  result.syscallBytesRead = ioEnd.syscallRead - ioBegin.syscallRead;
+  result.deviceBytesRead = ioEnd.deviceRead - ioBegin.deviceRead;
+  _addResult(&result, &samples);
+} // _benchQuery
+
+// ----------------------------------------------------------------------
+// Compute statistics of times and add result.
+void
+cencalvm::query::QueryBenchmark::_addResult(ResultStruct* pResult,
+					    std::vector<double>* pSamples)
+{ // _addResult
+  assert(0 != pResult);
+  assert(0 != pSamples);
+  assert(pSamples->size() > 0);
+
+  std::vector<double>& samples = *pSamples;
+  const size_t numSamples = samples.size();
+  std::sort(samples.begin(), samples.end());
+
+  double sum = 0.0;
+  for (size_t i=0; i < numSamples; ++i)
+    sum += samples[i];
+
+  pResult->numQueries = numSamples;
+  pResult->nsMean = sum / numSamples;
+  pResult->nsMin = samples[0];
+  pResult->nsP50 = samples[size_t(0.5 * (numSamples-1) + 0.5)];
+  pResult->nsP90 = samples[size_t(0.9 * (numSamples-1) + 0.5)];
+  pResult->nsP99 = samples[size_t(0.99 * (numSamples-1) + 0.5)];
+  pResult->nsP999 = samples[size_t(0.999 * (numSamples-1) + 0.5)];
+  pResult->nsMax = samples[numSamples-1];
+  _results.push_back(*pResult);
+
+  if (_quiet)
+    return;
+
+  std::ostringstream name;
+  name << pResult->name;
+  if (!pResult->queryType.empty())
+    name << " " << pResult->queryType
+	 << ((pResult->squash) ? " squash" : "")
+	 << ((pResult->extended) ? " ext" : "");
+  name << " " << pResult->pattern;
+  std::cout
+    << std::left << std::setw(44) << name.str() << std::right
+    << std::fixed << std::setprecision(1)
+    << std::setw(10) << pResult->nsMean << " ns/query"
+    << ", p50 " << pResult->nsP50
+    << ", p99 " << pResult->nsP99
+    << ", no data " << pResult->numNoData
+    << ", read " << pResult->syscallBytesRead / double(numSamples)
+    << " B/query" << std::endl;
+} // _addResult
+
+// ----------------------------------------------------------------------
+// Measure overhead of timing a query.
+void
+cencalvm::query::QueryBenchmark::_timerOverhead(void)
+{ // _timerOverhead
+  typedef std::chrono::steady_clock clock;
+  typedef std::chrono::duration<double, std::nano> nanoseconds;
+
+  const size_t numSamples = 10000;
+  std::vector<double> samples(numSamples);
+  for (size_t i=0; i < numSamples; ++i) {
+    const clock::time_point t0 = clock::now();
+    samples[i] = nanoseconds(clock::now() - t0).count();
+  } // for
+  std::nth_element(samples.begin(), samples.begin() + numSamples/2,
+		   samples.end());
+  _nsTimer = samples[numSamples/2];
+} // _timerOverhead
+
+// ----------------------------------------------------------------------
+// Write results as JSON.
+void
+cencalvm::query::QueryBenchmark::_writeJSON(void) const
+{ // _writeJSON
+  if (_filenameJSON.empty())
+    return;
+
+  std::ofstream fout(_filenameJSON.c_str());
+  if (!fout.is_open()) {
+    std::ostringstream msg;
+    msg << "Could not open benchmark results file '" << _filenameJSON
+	<< "' for writing.";
+    throw std::runtime_error(msg.str());
+  } // if
+
+  fout
+    << "{\n"
+    << "  \"benchmark\": \"query\",\n"
+    << "  \"time\": " << time(0) << ",\n"
+    << "  \"numOctants\": " << _numOctants << ",\n"
+    << "  \"resolution\": " << _resolution << ",\n"
+    << "  \"resolutionExt\": " << _EXTSCALE * _resolution << ",\n"
+    << "  \"numQueries\": " << _numQueries << ",\n"
+    << "  \"cacheSize\": " << _cacheSize << ",\n"
+    << "  \"fixedRes\": " << _fixedRes << ",\n"
+    << "  \"wavePeriod\": " << _wavePeriod << ",\n"
+    << "  \"squashLimit\": " << _SQUASHLIMIT << ",\n"
+    << "  \"seed\": " << _seed << ",\n"
+    << "  \"timerOverheadNs\": " << _nsTimer << ",\n"
+    << "  \"results\": [";
+  const size_t numResults = _results.size();
+  for (size_t i=0; i < numResults; ++i) {
+    const ResultStruct& result = _results[i];
+    fout
+      << ((i > 0) ? "," : "") << "\n"
+      << "    {\"name\": \"" << result.name << "\""
+      << ", \"queryType\": ";
+    if (result.queryType.empty())
+      fout << "null";
+    else
+      fout << "\"" << result.queryType << "\"";
+    fout
+      << ", \"squash\": " << ((result.squash) ? "true" : "false")
+      << ", \"extended\": " << ((result.extended) ? "true" : "false")
+      << ", \"pattern\": \"" << result.pattern << "\""
+      << ", \"numQueries\": " << result.numQueries
+      << ", \"numNoData\": " << result.numNoData
+      << ", \"nsPerQuery\": " << result.nsMean
+      << ", \"nsMin\": " << result.nsMin
+      << ", \"nsP50\": " << result.nsP50
+      << ", \"nsP90\": " << result.nsP90
+      << ", \"nsP99\": " << result.nsP99
+      << ", \"nsP999\": " << result.nsP999
+      << ", \"nsMax\": " << result.nsMax
+      << ", \"syscallBytesRead\": " << result.syscallBytesRead
+      << ", \"deviceBytesRead\": " << result.deviceBytesRead
+      << ", \"syscallBytesReadPerQuery\": "
+      << double(result.syscallBytesRead) / result.numQueries
+      << "}";
+  } // for
+  fout << "\n  ]\n}\n";
+  if (!fout.good()) {
+    std::ostringstream msg;
+    msg << "Error while writing benchmark results file '" << _filenameJSON
+	<< "'.";
+    throw std::runtime_error(msg.str());
+  } // if
+} // _writeJSON
+
+// End of file
@@ -0,0 +1,281 @@
+// -*- C++ -*-
+//
+// ======================================================================
+//
+//                           Brad T. Aagaard
+//                        U.S. Geological Survey
+//
+// {LicenseText}
+//
+// ======================================================================
+//
+
+/** @file benchmarks/query/QueryBenchmark.h
+ *
+ * @brief C++ microbenchmarks of querying the velocity model.
+ *
+ * The benchmarks run on synthetic databases generated with
+ * create::SynthGenerator: a detailed model and an extended model with
+ * octants four times larger that covers a larger region with the same
+ * origin. Both are averaged like the distributed model. The same parameters always generate the same databases and
+ * query points, so results can be compared across commits.
+ *
+ * Mapping between geographic coordinates and etree addresses
+ * (GeomCenCA::lonLatElevToAddr() and addrToLonLatElev()) and the
+ * projection (Projector::project()) are timed for random points.
+ * VMQuery::query() is timed for each query type (MAXRES, FIXEDRES,
+ * and WAVERES), with and without squashing, and with and without the
+ * extended model for three access patterns:
+ *
+ *   @li random Points uniformly distributed over the region.
+ *   @li morton The random points sorted into etree (Morton) order.
+ *   @li column Vertical profiles of points at random locations.
+ *
+ * Each query is timed individually. The results give the mean and
+ * percentiles of the time per query and the number of queries without
+ * data. Etree does not expose statistics of its buffer cache, so
+ * cache behavior is given by the bytes read by the process through
+ * system calls and from the storage device (see
+ * storage::Telemetry::processIO()); etree reads a page for every miss
+ * in its cache. Each benchmark opens the databases, so it starts with
+ * an empty etree cache.
+ */
+
+#if !defined(cencalvm_query_querybenchmark_h)
+#define cencalvm_query_querybenchmark_h
+
+#include <string> // HASA std::string
+#include <vector> // USES std::vector
+#include <inttypes.h> // USES uint64_t
+
+#include "cencalvm/storage/etreefwd.h" // USES etree_tick_t
+
+namespace cencalvm {
+  namespace query {
+    class QueryBenchmark;
+  } // namespace query
+} // namespace cencalvm
+
+/// C++ microbenchmarks of querying the velocity model.
+class cencalvm::query::QueryBenchmark
+{ // QueryBenchmark
+
+public :
+  // PUBLIC METHODS /////////////////////////////////////////////////////
+
+  /// Constructor
+  QueryBenchmark(void);
+
+  /// Destructor
+  ~QueryBenchmark(void);
+
+  /** Set root name of database files. The detailed and extended
+   * databases are root.etree and root_ext.etree.
+   *
+   * @param filename Root name of database files
+   */
+  void filenameRoot(const char* filename);
+
+  /** Set name of file for JSON results.
+   *
+   * @param filename Name of file
+   */
+  void filenameJSON(const char* filename);
+
+  /** Set number of octants in detailed database (the extended
+   * database has the same number).
+   *
+   * @param num Number of octants
+   */
+  void numOctants(const size_t num);
+
+  /** Set horizontal resolution of octants at the surface in the
+   * detailed database.
+   *
+   * @param res Horizontal edge length of octants in m
+   */
+  void resolution(const double res);
+
+  /** Set number of queries in each benchmark.
+   *
+   * @param num Number of queries
+   */
+  void numQueries(const size_t num);
+
+  /** Set size of etree cache of each database.
+   *
+   * @param size Size of cache in MB
+   */
+  void cacheSize(const int size);
+
+  /** Set resolution of FIXEDRES queries.
+   *
+   * @param res Resolution in m
+   */
+  void fixedRes(const double res);
+
+  /** Set minimum period of WAVERES queries.
+   *
+   * @param period Minimum period in s
+   */
+  void wavePeriod(const double period);
+
+  /** Set seed of random number generator for databases and query
+   * points.
+   *
+   * @param seed Seed
+   */
+  void seed(const unsigned long seed);
+
+  /** Set flag indicating benchmarks should be quiet (no summary).
+   *
+   * @param flag True for quiet operation, false to write summary
+   */
+  void quiet(const bool flag);
+
+  /// Generate the databases, run the benchmarks, and write results.
+  void run(void);
+
+private :
+  // PRIVATE STRUCTS ////////////////////////////////////////////////////
+
+  /// Location of query.
+  struct PointStruct {
+    double lon; ///< Longitude in degrees
+    double lat; ///< Latitude in degrees
+    double elev; ///< Elevation wrt MSL in m
+  }; // PointStruct
+
+  struct MortonStruct; ///< Point with its etree address
+
+  /// Region of database in etree address space.
+  struct RegionStruct {
+    etree_tick_t x0; ///< X coordinate of origin
+    etree_tick_t y0; ///< Y coordinate of origin
+    etree_tick_t lenX; ///< Length along x in ticks
+    etree_tick_t lenY; ///< Length along y in ticks
+  }; // RegionStruct
+
+  /// Result of benchmark.
+  struct ResultStruct {
+    std::string name; ///< Name of function benchmarked
+    std::string queryType; ///< Type of query ("" if not a query)
+    std::string pattern; ///< Access pattern
+    bool squash; ///< True if squashing topography
+    bool extended; ///< True if using extended model
+    size_t numQueries; ///< Number of queries
+    size_t numNoData; ///< Number of queries without data
+    double nsMean; ///< Mean time per query in ns
+    double nsMin; ///< Minimum time per query in ns
+    double nsP50; ///< Median time per query in ns
+    double nsP90; ///< 90th percentile of time per query in ns
+    double nsP99; ///< 99th percentile of time per query in ns
+    double nsP999; ///< 99.9th percentile of time per query in ns
+    double nsMax; ///< Maximum time per query in ns
+    uint64_t syscallBytesRead; ///< Bytes read through system calls
+    uint64_t deviceBytesRead; ///< Bytes read from storage device
+  }; // ResultStruct
+
+private :
+  // PRIVATE METHODS ////////////////////////////////////////////////////
+
+  /** Generate database.
+   *
+   * @param pRegion Pointer to region of database
+   * @param filename Name of database file
+   * @param resolution Horizontal resolution at surface in m
+   */
+  void _generate(RegionStruct* pRegion,
+		 const std::string& filename,
+		 const double resolution) const;
+
+  /** Generate query points.
+   *
+   * @param pPoints Pointer to points
+   * @param region Region of points
+   * @param pattern Access pattern ("random", "morton", or "column")
+   */
+  void _points(std::vector<PointStruct>* pPoints,
+	       const RegionStruct& region,
+	       const char* pattern) const;
+
+  /** Check whether point comes before another in etree (Morton)
+   * order.
+   *
+   * @param a First point
+   * @param b Second point
+   *
+   * @returns True if first point comes before second point
+   */
+  static bool _mortonBefore(const MortonStruct& a,
+			    const MortonStruct& b);
+
+  /** Time mapping between geographic coordinates and etree addresses
+   * and the projection.
+   *
+   * @param points Query points
+   */
+  void _benchGeometry(const std::vector<PointStruct>& points);
+
+  /** Time queries.
+   *
+   * @param points Query points
+   * @param queryType Type of query (VMQuery::QueryEnum)
+   * @param squash True to squash topography
+   * @param extended True to use extended model
+   * @param pattern Access pattern of points
+   */
+  void _benchQuery(const std::vector<PointStruct>& points,
+		   const int queryType,
+		   const bool squash,
+		   const bool extended,
+		   const char* pattern);
+
+  /** Compute statistics of times and add result.
+   *
+   * @param pResult Pointer to result (statistics are set)
+   * @param pSamples Pointer to times of queries in ns (sorted)
+   */
+  void _addResult(ResultStruct* pResult,
+		  std::vector<double>* pSamples);
+
+  /// Measure overhead of timing a query.
+  void _timerOverhead(void);
+
+  /// Write results as JSON.
+  void _writeJSON(void) const;
+
+  QueryBenchmark(const QueryBenchmark& b); ///< Not implemented
+  const QueryBenchmark& operator=(const QueryBenchmark& b); ///< Not implemented
+
+private :
+  // PRIVATE MEMBERS ////////////////////////////////////////////////////
+
+  std::string _filenameRoot; ///< Root name of database files
+  std::string _filenameJSON; ///< Name of file for JSON results
+  size_t _numOctants; ///< Number of octants in each database
+  double _resolution; ///< Resolution at surface of detailed database
+  size_t _numQueries; ///< Number of queries in each benchmark
+  int _cacheSize; ///< Size of etree cache in MB
+  double _fixedRes; ///< Resolution of FIXEDRES queries in m
+  double _wavePeriod; ///< Minimum period of WAVERES queries in s
+  unsigned long _seed; ///< Seed of random number generator
+  double _nsTimer; ///< Overhead of timing a query in ns
+  bool _quiet; ///< Flag to eliminate summary
+
+  std::vector<ResultStruct> _results; ///< Results of benchmarks
+
+  static const double _ELEVMIN; ///< Minimum elevation of points in m
+  static const double _ELEVMAX; ///< Maximum elevation of points in m
+  static const double _SQUASHLIMIT; ///< Minimum elevation of squashing
+  static const int _NUMCOLUMNPOINTS; ///< Number of points in column
+  static const int _EXTSCALE; ///< Ratio of octant size in extended model
+  static const int _SORTSIZE; ///< Memory used to sort octants in MB
+
+}; // QueryBenchmark
+
+#include "QueryBenchmark.icc" // inline methods
+
+#endif // cencalvm_query_querybenchmark_h
+
+// End of file
@@ -0,0 +1,185 @@
+// -*- C++ -*-
+//
+// ======================================================================
+//
+//                           Brad T. Aagaard
+//                        U.S. Geological Survey
+//
+// ======================================================================
+//
+// Application driver for microbenchmarks of querying the velocity
+// model on synthetic databases.
+
+#include "QueryBenchmark.h" // USES QueryBenchmark
+
+#include <stdlib.h> // USES exit(), atoi(), atol(), atof(), strtoul()
+#include <unistd.h> // USES getopt()
+#include <stdio.h> // USES EOF
+
+#include <iostream> // USES std::cerr
+#include <stdexcept> // USES std::exception
+#include <assert.h> // USES assert()
+
+// ----------------------------------------------------------------------
+void
+usage(void)
+{ // usage
+  std::cerr
+    << "usage: benchquery [-h] [-d dbRoot] [-o jsonFile] [-n numOctants]\n"
+    << "         [-r resolution] [-q numQueries] [-c cacheSize] [-f fixedRes]\n"
+    << "         [-p wavePeriod] [-g seed] [-s]\n"
+    << "  -d dbRoot      Root name of synthetic databases generated for the\n"
+    << "                 benchmarks (default is benchquery).\n"
+    << "  -o jsonFile    Write results to jsonFile as JSON.\n"
+    << "  -n numOctants  Number of octants in each database (default is\n"
+    << "                 1000000).\n"
+    << "  -r resolution  Horizontal resolution in m of octants at the surface\n"
+    << "                 in the detailed database (default is 100).\n"
+    << "  -q numQueries  Number of queries in each benchmark (default is\n"
+    << "                 100000).\n"
+    << "  -c cacheSize   Size of database cache in MB (default is 128).\n"
+    << "  -f fixedRes    Resolution in m of fixedres queries (default is 400).\n"
+    << "  -p wavePeriod  Minimum period in s of waveres queries (default is 1).\n"
+    << "  -g seed        Seed of random number generator (default is 1).\n"
+    << "  -s             Silent; do not write summary of results.\n"
+    << "  -h             Display usage and exit.\n";
+  exit(1);
+} // usage
+
+// ----------------------------------------------------------------------
+void
+parseArgs(std::string* pFilenameRoot,
+	  std::string* pFilenameJSON,
+	  long* pNumOctants,
+	  double* pResolution,
+	  long* pNumQueries,
+	  int* pCacheSize,
+	  double* pFixedRes,
+	  double* pWavePeriod,
+	  unsigned long* pSeed,
+	  bool* pQuiet,
+	  int argc,
+	  char** argv)
+{ // parseArgs
+  assert(0 != pFilenameRoot);
+  assert(0 != pFilenameJSON);
+  assert(0 != pNumOctants);
+  assert(0 != pResolution);
+  assert(0 != pNumQueries);
+  assert(0 != pCacheSize);
+  assert(0 != pFixedRes);
+  assert(0 != pWavePeriod);
+  assert(0 != pSeed);
+  assert(0 != pQuiet);
+
+  extern char* optarg;
+
+  int nparsed = 1;
+  int c = EOF;
+  while ( (c = getopt(argc, argv, "c:d:f:g:hn:o:p:q:r:s") ) != EOF) {
+    switch (c)
+      { // switch
+      case 'c' : // process -c option
+	*pCacheSize = atoi(optarg);
+	nparsed += 2;
+	break;
+      case 'd' : // process -d option
+	*pFilenameRoot = optarg;
+	nparsed += 2;
+	break;
+      case 'f' : // process -f option
+	*pFixedRes = atof(optarg);
+	nparsed += 2;
+	break;
+      case 'g' : // process -g option
+	*pSeed = strtoul(optarg, 0, 10);
+	nparsed += 2;
+	break;
+      case 'h' : // process -h option
+	nparsed += 1;
+	usage();
+	exit(0);
+	break;
+      case 'n' : // process -n option
+	*pNumOctants = atol(optarg);
+	nparsed += 2;
+	break;
+      case 'o' : // process -o option
+	*pFilenameJSON = optarg;
+	nparsed += 2;
+	break;
+      case 'p' : // process -p option
+	*pWavePeriod = atof(optarg);
+	nparsed += 2;
+	break;
+      case 'q' : // process -q option
+	*pNumQueries = atol(optarg);
+	nparsed += 2;
+	break;
+      case 'r' : // process -r option
+	*pResolution = atof(optarg);
+	nparsed += 2;
+	break;
+      case 's' : // process -s option
+	*pQuiet = true;
+	nparsed += 1;
+	break;
+      default :
+	usage();
+      } // switch
+    } // while
+  if (nparsed != argc ||
+      0 == pFilenameRoot->length() ||
+      *pNumOctants <= 0 ||
+      *pResolution <= 0.0 ||
+      *pNumQueries <= 0 ||
+      *pCacheSize <= 0 ||
+      *pFixedRes <= 0.0 ||
+      *pWavePeriod <= 0.0)
+    usage();
+} // parseArgs
+
+// ----------------------------------------------------------------------
+int
+main(int argc,
+     char* argv[])
+{ // main
+  std::string filenameRoot = "benchquery";
+  std::string filenameJSON = "";
+  long numOctants = 1000000;
+  double resolution = 100.0;
+  long numQueries = 100000;
+  int cacheSize = 128;
+  double fixedRes = 400.0;
+  double wavePeriod = 1.0;
+  unsigned long seed = 1;
+  bool quiet = false;
+
+  parseArgs(&filenameRoot, &filenameJSON, &numOctants, &resolution,
+	    &numQueries, &cacheSize, &fixedRes, &wavePeriod, &seed, &quiet,
+	    argc, argv);
+
+  try {
+    cencalvm::query::QueryBenchmark benchmark;
+    benchmark.filenameRoot(filenameRoot.c_str());
+    benchmark.filenameJSON(filenameJSON.c_str());
+    benchmark.numOctants(numOctants);
+    benchmark.resolution(resolution);
+    benchmark.numQueries(numQueries);
+    benchmark.cacheSize(cacheSize);
+    benchmark.fixedRes(fixedRes);
+    benchmark.wavePeriod(wavePeriod);
+    benchmark.seed(seed);
+    benchmark.quiet(quiet);
+    benchmark.run();
+  } catch (const std::exception& err) {
+    std::cerr << err.what();
+    return 1;
+  } catch (...) {
+    return 1;
+  } // catch
+
+  return 0;
+} // main
+
+// End of file
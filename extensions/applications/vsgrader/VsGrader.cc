@@ -16,6 +16,7 @@
 #include "cencalvm/storage/Geometry.h" // USES Geometry
 #include "cencalvm/storage/GeomCenCA.h" // USES GeomCenCA
 #include "cencalvm/storage/Projector.h" // USES Projector
+#include "cencalvm/storage/Telemetry.h" // USES Telemetry
 #include "cencalvm/create/VMCreator.h" // USES VMCreator
 
 extern "C" {
@@ -23,7 +24,10 @@ extern "C" {
 }
 
 #include <fstream> // USES std::ifstream
+#include <thread> // USES std::thread
 #include <strings.h> // USES strcasecmp()
+#include <stdio.h> // USES fopen(), fread(), fwrite(), fseeko(), remove()
+#include <stdlib.h> // USES atoi()
 
 #include <stdexcept> // USES std::runtime_error
 #include <sstream> // USES std::ostringstream
@@ -35,6 +39,7 @@ const double cencalvm::vsgrader::VsGrader::_AZIMUTHLEN = -36.3620 * M_PI/180.0;
 const double cencalvm::vsgrader::VsGrader::_NODATAVAL = 1.0e+10;
 const int16_t cencalvm::vsgrader::VsGrader::_NODATABLOCK = 999;
 const int16_t cencalvm::vsgrader::VsGrader::_NODATAZONE = 999;
+const double cencalvm::vsgrader::VsGrader::_AUTOFRACTION = 0.25;
 
 // ----------------------------------------------------------------------
 // Constructor
@@ -55,9 +60,12 @@ cencalvm::vsgrader::VsGrader::VsGrader(void) :
   _filenameOut(""),
   _filenameTmp(""),
   _filenameParams(""),
+  _memorySize(size_t(1024)*1024*1024),
   _cacheSize(128),
+  _numThreads(0),
   _queryType(query::VMQuery::MAXRES),
   _pGeom(new cencalvm::storage::GeomCenCA),
+  _pTelemetry(0),
   _quiet(false)
 { // constructor
 } // constructor
@@ -85,9 +93,18 @@ cencalvm::vsgrader::VsGrader::run(void)
 { // run
   _readParams();
   _initialize();
-  _extract();
-  _pack();
-  _grade();
+
+  GridStruct grid;
+  _initGrid(&grid);
+  try {
+    _extract(&grid);
+    _grade(&grid);
+    _pack(&grid);
+  } catch (...) {
+    _closeGrid(&grid);
+    throw;
+  } // try/catch
+  _closeGrid(&grid);
 } // run
 
 // ----------------------------------------------------------------------
@@ -157,10 +174,12 @@ cencalvm::vsgrader::VsGrader::_readParams(void)
 	filein >> _minVs;
       } else if (0 == strcasecmp(token.c_str(), "cache-size")) {
 	filein.ignore(maxIgnore, '=');
-	int value;
+	std::string value;
 	filein >> value;
-	if (value > 0)
-	  _cacheSize = value;
+	if (0 == strcasecmp(value.c_str(), "auto"))
+	  _cacheSize = cencalvm::storage::CacheMonitor::AUTOSIZE;
+	else if (atoi(value.c_str()) > 0)
+	  _cacheSize = atoi(value.c_str());
       } else if (0 == strcasecmp(token.c_str(), "query-resolution")) {	
 	filein.ignore(maxIgnore, '=');
 	double value;
@@ -264,10 +283,83 @@ cencalvm::vsgrader::VsGrader::_initialize(void)
 } // _initialize
 
 // ----------------------------------------------------------------------
-// Extract database.
+// Set dimensions of grid and size of slabs.
+void
+cencalvm::vsgrader::VsGrader::_initGrid(GridStruct* pGrid) const
+{ // _initGrid
+  assert(0 != pGrid);
+  assert(0 != _pGeom);
+
+  const double resHoriz = _resVert * _pGeom->vertExag();
+  pGrid->numLen = int(1 + _domainLen / resHoriz);
+  pGrid->numWidth = int(1 + _domainWidth / resHoriz);
+  pGrid->numHt = int(1 + _domainHt / _resVert);
+  pGrid->lenBegin = 0;
+  pGrid->lenEnd = 0;
+  pGrid->widthBegin = 0;
+  pGrid->widthEnd = 0;
+  pGrid->fileTmp = 0;
+
+  const size_t numColumns = size_t(pGrid->numLen) * pGrid->numWidth;
+  pGrid->lon.resize(numColumns);
+  pGrid->lat.resize(numColumns);
+
+  const size_t numCells = numColumns * pGrid->numHt;
+  const size_t maxCells = _memorySize / sizeof(storage::PayloadStruct);
+  pGrid->isTiled = numCells > maxCells;
+  if (!pGrid->isTiled) {
+    pGrid->slabLen = pGrid->numLen;
+    pGrid->slabWidth = pGrid->numWidth;
+    return;
+  } // if
+
+  // Slabs across length hold entire width planes and slabs across
+  // width hold entire length planes.
+  pGrid->slabLen = maxCells / (size_t(pGrid->numWidth) * pGrid->numHt);
+  pGrid->slabWidth = maxCells / (size_t(pGrid->numLen) * pGrid->numHt);
+  if (0 == pGrid->slabLen || 0 == pGrid->slabWidth) {
+    const int maxDim = (pGrid->numLen > pGrid->numWidth) ?
+      pGrid->numLen : pGrid->numWidth;
+    const size_t minSize = size_t(maxDim) * pGrid->numHt *
+      sizeof(storage::PayloadStruct);
+    std::ostringstream msg;
+    msg << "Memory size of " << _memorySize / (1024*1024) << " MB is too "
+	<< "small to hold a slab of the grid. At least "
+	<< 1 + minSize / (1024*1024) << " MB is required.";
+    throw std::runtime_error(msg.str());
+  } // if
+
+  pGrid->fileTmp = fopen(_filenameTmp.c_str(), "w+b");
+  if (0 == pGrid->fileTmp) {
+    std::ostringstream msg;
+    msg << "Could not open scratch file '" << _filenameTmp << "'.";
+    throw std::runtime_error(msg.str());
+  } // if
+
+  if (!_quiet)
+    std::cout << "Grid does not fit in memory; using scratch file '"
+	      << _filenameTmp << "'." << std::endl;
+} // _initGrid
+
+// ----------------------------------------------------------------------
+// Close and remove scratch file.
 void
-cencalvm::vsgrader::VsGrader::_extract(void) const
+cencalvm::vsgrader::VsGrader::_closeGrid(GridStruct* pGrid) const
+{ // _closeGrid
+  assert(0 != pGrid);
+
+  if (0 != pGrid->fileTmp) {
+    fclose(pGrid->fileTmp); pGrid->fileTmp = 0;
+    remove(_filenameTmp.c_str());
+  } // if
+} // _closeGrid
+
+// ----------------------------------------------------------------------
+// Extract grid from database.
+void
+cencalvm::vsgrader::VsGrader::_extract(GridStruct* pGrid) const
 { // _extract
+  assert(0 != pGrid);
   assert(0 != _pGeom);
 
   if (!_quiet)
@@ -281,198 +373,411 @@ cencalvm::vsgrader::VsGrader::_extract(void) const
   dbOrig.filename(_filenameIn.c_str());
   dbOrig.open();
 
-  std::ostringstream description;
-  description << _pGeom->metadata() << "\n"
-	      << "Gradient in Vs limited to " << _gradientMaxVs << ".";
-  create::VMCreator dbNew;
-  dbNew.openDB(_filenameTmp.c_str(),
-	       _cacheSize,
-	       description.str().c_str());
-  
-  const double resHoriz = _resVert * _pGeom->vertExag();
-  const int numLen = int(1 + _domainLen / resHoriz);
-  const int numWidth = int(1 + _domainWidth / resHoriz);
-  const int numHt = int(1 + _domainHt / _resVert);
+  const int numLen = pGrid->numLen;
+  const int numWidth = pGrid->numWidth;
+  const int numHt = pGrid->numHt;
 
-  cencalvm::storage::PayloadStruct payload;
   const int numVals = 8;
   const char* valNames[] = { "Vp", "Vs", "Density", "Qp", "Qs", 
 			     "DepthFreeSurf", "FaultBlock", "Zone" };
   dbOrig.queryVals(valNames, numVals);
   double* pVals = (numVals > 0) ? new double[numVals] : 0;
-  for (int iLen=0; iLen < numLen; ++iLen) {
-    for (int iWidth=0; iWidth < numWidth; ++iWidth) {
-      double lon = 0;
-      double lat = 0;
-      _indexToLonLat(&lon, &lat, iLen, iWidth);
-      for (int iHt=0; iHt < numHt; ++iHt) {
-	const double elev = _indexToElev(iHt);
-	dbOrig.query(&pVals, numVals, lon, lat, elev);
-	payload.Vp = pVals[0];
-	payload.Vs = pVals[1];
-	payload.Density = pVals[2];
-	payload.Qp = pVals[3];
-	payload.Qs = pVals[4];
-	payload.DepthFreeSurf = pVals[5];
-	payload.FaultBlock = int16_t(pVals[6]);
-	payload.Zone = int16_t(pVals[7]);
-	if (payload.Vs < 0) {
-	  payload.Vp = _NODATAVAL;
-	  payload.Vs = _NODATAVAL;
-	  payload.Density = _NODATAVAL;
-	  payload.Qp = _NODATAVAL;
-	  payload.Qs = _NODATAVAL;
-	  payload.DepthFreeSurf = _NODATAVAL;
-	  payload.FaultBlock = _NODATABLOCK;
-	  payload.Zone = _NODATAZONE;
-	} else if (payload.Vs < _minVs)
-	  payload.Vs = _minVs;
-
-	dbNew.insert(payload, lon, lat, elev, resHoriz, _pGeom);
+  cencalvm::storage::CacheStatsStruct stats;
+  if (0 != _pTelemetry) {
+    dbOrig.cacheStats(&stats);
+    _pTelemetry->beginPhase("extract", uint64_t(numLen)*numWidth*numHt);
+    _pTelemetry->cacheSize(stats.cacheSize);
+  } // if
+  for (int lenBegin=0; lenBegin < numLen; lenBegin += pGrid->slabLen) {
+    const int lenEnd = (lenBegin + pGrid->slabLen < numLen) ?
+      lenBegin + pGrid->slabLen : numLen;
+    _loadSlab(pGrid, lenBegin, lenEnd, 0, numWidth, false);
+    cencalvm::storage::PayloadStruct* pPayload = &pGrid->slab[0];
+    for (int iLen=lenBegin; iLen < lenEnd; ++iLen) {
+      for (int iWidth=0; iWidth < numWidth; ++iWidth) {
+	const size_t iColumn = size_t(iLen)*numWidth + iWidth;
+	double lon = 0;
+	double lat = 0;
+	_indexToLonLat(&lon, &lat, iLen, iWidth);
+	pGrid->lon[iColumn] = lon;
+	pGrid->lat[iColumn] = lat;
+	for (int iHt=0; iHt < numHt; ++iHt, ++pPayload) {
+	  const double elev = _indexToElev(iHt);
+	  dbOrig.query(&pVals, numVals, lon, lat, elev);
+	  pPayload->Vp = pVals[0];
+	  pPayload->Vs = pVals[1];
+	  pPayload->Density = pVals[2];
+	  pPayload->Qp = pVals[3];
+	  pPayload->Qs = pVals[4];
+	  pPayload->DepthFreeSurf = pVals[5];
+	  pPayload->FaultBlock = int16_t(pVals[6]);
+	  pPayload->Zone = int16_t(pVals[7]);
+	  if (pPayload->Vs < 0) {
+	    pPayload->Vp = _NODATAVAL;
+	    pPayload->Vs = _NODATAVAL;
+	    pPayload->Density = _NODATAVAL;
+	    pPayload->Qp = _NODATAVAL;
+	    pPayload->Qs = _NODATAVAL;
+	    pPayload->DepthFreeSurf = _NODATAVAL;
+	    pPayload->FaultBlock = _NODATABLOCK;
+	    pPayload->Zone = _NODATAZONE;
+	  } else if (pPayload->Vs < _minVs)
+	    pPayload->Vs = _minVs;
+	} // for
+	if (0 != _pTelemetry)
+	  _pTelemetry->addOctants(numHt);
       } // for
     } // for
+    _storeSlab(pGrid);
   } // for
   delete[] pVals; pVals = 0;
-  
-  dbNew.closeDB();
+
+  dbOrig.cacheStats(&stats);
+  if (!_quiet && stats.numSearches > 0)
+    std::cout
+      << "Cache of '" << _filenameIn << "': " << stats.cacheSize << " MB, "
+      << stats.numResizes << " resize(s), " << stats.numHits << " hits, "
+      << stats.numMisses << " misses, " << stats.numEvictions
+      << " evictions" << ((stats.isEstimate) ? " (estimated)." : ".")
+      << std::endl;
   dbOrig.close();
+  if (0 != _pTelemetry)
+    _pTelemetry->endPhase();
 
   if (!_quiet)
     std::cout << "Done extracting." << std::endl;
 } // _extract
 
 // ----------------------------------------------------------------------
-// Pack database.
+// Limit gradient in grid.
 void
-cencalvm::vsgrader::VsGrader::_pack(void) const
-{ // _pack
-  cencalvm::create::VMCreator creator;
-  creator.quiet(_quiet);
-  creator.packDB(_filenameOut.c_str(), _filenameTmp.c_str(), _cacheSize);
-} // _pack
-
-// ----------------------------------------------------------------------
-// Limit gradient in database.
-void
-cencalvm::vsgrader::VsGrader::_grade(void) const
+cencalvm::vsgrader::VsGrader::_grade(GridStruct* pGrid) const
 { // _grade
-  assert(0 != _pGeom);
+  assert(0 != pGrid);
 
   if (!_quiet)
     std::cout << "Starting grading of database." << std::endl;
 
-  // Open database for reading/writing
-  const int cacheSize = 512;
-  const int numDims = 3;
-  const int payloadSize = sizeof(cencalvm::storage::PayloadStruct);
-  etree_t* db = etree_open(_filenameOut.c_str(), O_RDWR,
-			       cacheSize, payloadSize, numDims);
-  if (0 == db)
-    throw std::runtime_error("Could not open etree database.");
-
-  const double resHoriz = _resVert * _pGeom->vertExag();
-  const int numLen = int(1 + _domainLen / resHoriz);
-  const int numWidth = int(1 + _domainWidth / resHoriz);
-  const int numHt = int(1 + _domainHt / _resVert);
-  
-  int dataLen = 0;
-  cencalvm::storage::PayloadStruct* pData = 0;
-  bool* pIsChanged = 0;
+  const int numLen = pGrid->numLen;
+  const int numWidth = pGrid->numWidth;
+  if (0 != _pTelemetry)
+    _pTelemetry->beginPhase("grade",
+			    3*uint64_t(numLen)*numWidth*pGrid->numHt);
 
   // Limit gradient in vertical direction
   if (!_quiet)
     std::cout << "Grading database in vertical direction." << std::endl;
-  dataLen = (numHt > 0) ? numHt : 0;
-  pData = (dataLen > 0) ? new cencalvm::storage::PayloadStruct[dataLen] : 0;
-  pIsChanged = (dataLen > 0) ? new bool[dataLen] : 0;
-  for (int iLen=0; iLen < numLen; ++iLen)
-    for (int iWidth=0; iWidth < numWidth; ++iWidth) {
-      double lon = 0;
-      double lat = 0;
-      _indexToLonLat(&lon, &lat, iLen, iWidth);
-      for (int iHt=0; iHt < numHt; ++iHt) {
-	const double elev = _indexToElev(iHt);
-	_pullData(&pData[iHt], lon, lat, elev, db);
-      } // for
-      const double maxdiff = _gradientMaxVs * _resVert;
-      _limitDiff(&pData, &pIsChanged, dataLen, maxdiff);
-      
-      for (int iHt=0; iHt < numHt; ++iHt)
-	if (pIsChanged[iHt]) {
-	  const double elev = _indexToElev(iHt);
-	  _pushData(db, pData[iHt], lon, lat, elev);
-	} // for
-    } // for
-  delete[] pData; pData = 0;
-  delete[] pIsChanged; pIsChanged = 0;
-  dataLen = 0;
+  for (int lenBegin=0; lenBegin < numLen; lenBegin += pGrid->slabLen) {
+    const int lenEnd = (lenBegin + pGrid->slabLen < numLen) ?
+      lenBegin + pGrid->slabLen : numLen;
+    _loadSlab(pGrid, lenBegin, lenEnd, 0, numWidth, true);
+    _gradeSlab(pGrid, VERTICAL);
+    _storeSlab(pGrid);
+    if (0 != _pTelemetry)
+      _pTelemetry->addOctants(pGrid->slab.size());
+  } // for
 
   // Limit gradient in length direction
   if (!_quiet)
     std::cout << "Grading database in length direction." << std::endl;
-  dataLen = (numLen > 0) ? numLen : 0;
-  pData = (dataLen > 0) ? new cencalvm::storage::PayloadStruct[dataLen] : 0;
-  pIsChanged = (dataLen > 0) ? new bool[dataLen] : 0;
-  for (int iHt=0; iHt < numHt; ++iHt) {
-    const double elev = _indexToElev(iHt);
-    double lon = 0;
-    double lat = 0;
-    for (int iWidth=0; iWidth < numWidth; ++iWidth) {
-      for (int iLen=0; iLen < numLen; ++iLen) {
-	_indexToLonLat(&lon, &lat, iLen, iWidth);
-	_pullData(&pData[iLen], lon, lat, elev, db);
-      } // for
-      const double maxdiff = _gradientMaxVs * resHoriz;
-      _limitDiff(&pData, &pIsChanged, dataLen, maxdiff);
-      
-      for (int iLen=0; iLen < numLen; ++iLen)
-	if (pIsChanged[iLen]) {
-	  _indexToLonLat(&lon, &lat, iLen, iWidth);
-	  _pushData(db, pData[iLen], lon, lat, elev);
-	} // for
-    } // for
+  for (int widthBegin=0; widthBegin < numWidth; 
+       widthBegin += pGrid->slabWidth) {
+    const int widthEnd = (widthBegin + pGrid->slabWidth < numWidth) ?
+      widthBegin + pGrid->slabWidth : numWidth;
+    _loadSlab(pGrid, 0, numLen, widthBegin, widthEnd, true);
+    _gradeSlab(pGrid, LENGTH);
+    _storeSlab(pGrid);
+    if (0 != _pTelemetry)
+      _pTelemetry->addOctants(pGrid->slab.size());
   } // for
-  delete[] pData; pData = 0;
-  delete[] pIsChanged; pIsChanged = 0;
-  dataLen = 0;
-      
+
   // Limit gradient in width direction
   if (!_quiet)
     std::cout << "Grading database in width direction." << std::endl;
-  dataLen = (numWidth > 0) ? numWidth : 0;
-  pData = (dataLen > 0) ? new cencalvm::storage::PayloadStruct[dataLen] : 0;
-  pIsChanged = (dataLen > 0) ? new bool[dataLen] : 0;
-  for (int iHt=0; iHt < numHt; ++iHt) {
-    const double elev = _indexToElev(iHt);
-    double lon = 0;
-    double lat = 0;
-    for (int iLen=0; iLen < numLen; ++iLen) {
-      for (int iWidth=0; iWidth < numWidth; ++iWidth) {
-	_indexToLonLat(&lon, &lat, iLen, iWidth);
-	_pullData(&pData[iWidth], lon, lat, elev, db);
-      } // for
-      const double maxdiff = _gradientMaxVs * resHoriz;
-      _limitDiff(&pData, &pIsChanged, dataLen, maxdiff);
-      
-      for (int iWidth=0; iWidth < numWidth; ++iWidth)
-	if (pIsChanged[iWidth]) {
-	  _indexToLonLat(&lon, &lat, iLen, iWidth);
-	  _pushData(db, pData[iWidth], lon, lat, elev);
-	} // for
-    } // for
+  for (int lenBegin=0; lenBegin < numLen; lenBegin += pGrid->slabLen) {
+    const int lenEnd = (lenBegin + pGrid->slabLen < numLen) ?
+      lenBegin + pGrid->slabLen : numLen;
+    _loadSlab(pGrid, lenBegin, lenEnd, 0, numWidth, true);
+    _gradeSlab(pGrid, WIDTH);
+    _storeSlab(pGrid);
+    if (0 != _pTelemetry)
+      _pTelemetry->addOctants(pGrid->slab.size());
   } // for
-  delete[] pData; pData = 0;
-  delete[] pIsChanged; pIsChanged = 0;
-  dataLen = 0;
 
-  // close database
-  if (0 != etree_close(db))
-    throw std::runtime_error(etree_strerror(etree_errno(db)));
+  if (0 != _pTelemetry)
+    _pTelemetry->endPhase();
 
   if (!_quiet)
     std::cout << "Done grading database." << std::endl;
 } // _grade
 
+// ----------------------------------------------------------------------
+// Write grid to new database.
+void
+cencalvm::vsgrader::VsGrader::_pack(GridStruct* pGrid) const
+{ // _pack
+  assert(0 != pGrid);
+  assert(0 != _pGeom);
+
+  std::ostringstream description;
+  description << _pGeom->metadata() << "\n"
+	      << "Gradient in Vs limited to " << _gradientMaxVs << ".";
+
+  // Octants are sorted into etree order and appended when the
+  // database is closed.
+  const int sortSize = (_memorySize > 1024*1024) ?
+    int(_memorySize / (1024*1024)) : 1;
+  int cacheSize = _cacheSize;
+  if (cencalvm::storage::CacheMonitor::AUTOSIZE == cacheSize) {
+    // Output database is about the size of the input database.
+    cacheSize = cencalvm::storage::CacheMonitor::maxSize(_filenameIn.c_str(),
+							 _AUTOFRACTION);
+    if (!_quiet)
+      std::cout << "Using automatic etree cache of " << cacheSize
+		<< " MB for '" << _filenameOut << "'." << std::endl;
+  } // if
+  create::VMCreator dbNew;
+  dbNew.quiet(_quiet);
+  dbNew.telemetry(_pTelemetry);
+  dbNew.openSortedDB(_filenameOut.c_str(), cacheSize,
+		     description.str().c_str(), _filenameTmp.c_str(),
+		     sortSize);
+
+  const int numLen = pGrid->numLen;
+  const int numWidth = pGrid->numWidth;
+  const int numHt = pGrid->numHt;
+
+  const double resHoriz = _resVert * _pGeom->vertExag();
+  etree_addr_t addr;
+  addr.type = ETREE_LEAF;
+  addr.level = _pGeom->level(resHoriz);
+  if (0 != _pTelemetry)
+    _pTelemetry->beginPhase("insert", uint64_t(numLen)*numWidth*numHt);
+  for (int lenBegin=0; lenBegin < numLen; lenBegin += pGrid->slabLen) {
+    const int lenEnd = (lenBegin + pGrid->slabLen < numLen) ?
+      lenBegin + pGrid->slabLen : numLen;
+    _loadSlab(pGrid, lenBegin, lenEnd, 0, numWidth, true);
+    const cencalvm::storage::PayloadStruct* pPayload = &pGrid->slab[0];
+    for (int iLen=lenBegin; iLen < lenEnd; ++iLen)
+      for (int iWidth=0; iWidth < numWidth; ++iWidth) {
+	const size_t iColumn = size_t(iLen)*numWidth + iWidth;
+	for (int iHt=0; iHt < numHt; ++iHt, ++pPayload)
+	  if (0 == _pGeom->lonLatElevToAddr(&addr, pGrid->lon[iColumn],
+					    pGrid->lat[iColumn],
+					    _indexToElev(iHt)))
+	    dbNew.insert(*pPayload, addr);
+      } // for
+  } // for
+  if (0 != _pTelemetry)
+    _pTelemetry->endPhase();
+
+  dbNew.closeDB();
+} // _pack
+
+// ----------------------------------------------------------------------
+// Make slab current, reading it from scratch file if grid is tiled.
+void
+cencalvm::vsgrader::VsGrader::_loadSlab(GridStruct* pGrid,
+					const int lenBegin,
+					const int lenEnd,
+					const int widthBegin,
+					const int widthEnd,
+					const bool isRead) const
+{ // _loadSlab
+  assert(0 != pGrid);
+  assert(0 <= lenBegin && lenBegin <= lenEnd && lenEnd <= pGrid->numLen);
+  assert(0 <= widthBegin && widthBegin <= widthEnd && 
+	 widthEnd <= pGrid->numWidth);
+
+  pGrid->lenBegin = lenBegin;
+  pGrid->lenEnd = lenEnd;
+  pGrid->widthBegin = widthBegin;
+  pGrid->widthEnd = widthEnd;
+  const size_t planeSize = size_t(widthEnd - widthBegin) * pGrid->numHt;
+  pGrid->slab.resize((lenEnd - lenBegin) * planeSize);
+
+  // Slab is entire grid when grid is not tiled.
+  if (!pGrid->isTiled || !isRead || 0 == planeSize)
+    return;
+
+  assert(0 != pGrid->fileTmp);
+  const size_t payloadSize = sizeof(cencalvm::storage::PayloadStruct);
+  for (int iLen=lenBegin; iLen < lenEnd; ++iLen) {
+    const off_t offset = 
+      off_t((size_t(iLen)*pGrid->numWidth + widthBegin) * pGrid->numHt) *
+      payloadSize;
+    if (0 != fseeko(pGrid->fileTmp, offset, SEEK_SET) ||
+	planeSize != fread(&pGrid->slab[(iLen-lenBegin)*planeSize], 
+			   payloadSize, planeSize, pGrid->fileTmp)) {
+      std::ostringstream msg;
+      msg << "Could not read grid from scratch file '" << _filenameTmp
+	  << "'.";
+      throw std::runtime_error(msg.str());
+    } // if
+  } // for
+  if (0 != _pTelemetry)
+    _pTelemetry->addBytesRead((lenEnd - lenBegin)*planeSize*payloadSize);
+} // _loadSlab
+
+// ----------------------------------------------------------------------
+// Write current slab to scratch file if grid is tiled.
+void
+cencalvm::vsgrader::VsGrader::_storeSlab(GridStruct* pGrid) const
+{ // _storeSlab
+  assert(0 != pGrid);
+
+  const size_t planeSize = 
+    size_t(pGrid->widthEnd - pGrid->widthBegin) * pGrid->numHt;
+  if (!pGrid->isTiled || 0 == planeSize)
+    return;
+
+  assert(0 != pGrid->fileTmp);
+  const size_t payloadSize = sizeof(cencalvm::storage::PayloadStruct);
+  for (int iLen=pGrid->lenBegin; iLen < pGrid->lenEnd; ++iLen) {
+    const off_t offset = 
+      off_t((size_t(iLen)*pGrid->numWidth + pGrid->widthBegin) * 
+	    pGrid->numHt) * payloadSize;
+    if (0 != fseeko(pGrid->fileTmp, offset, SEEK_SET) ||
+	planeSize != fwrite(&pGrid->slab[(iLen-pGrid->lenBegin)*planeSize],
+			    payloadSize, planeSize, pGrid->fileTmp)) {
+      std::ostringstream msg;
+      msg << "Could not write grid to scratch file '" << _filenameTmp
+	  << "'.";
+      throw std::runtime_error(msg.str());
+    } // if
+  } // for
+  if (0 != _pTelemetry)
+    _pTelemetry->addBytesWritten((pGrid->lenEnd - pGrid->lenBegin)*planeSize*
+				 payloadSize);
+} // _storeSlab
+
+// ----------------------------------------------------------------------
+// Limit gradient along all lines in a direction of current slab.
+void
+cencalvm::vsgrader::VsGrader::_gradeSlab(GridStruct* pGrid,
+					 const DirectionEnum dir) const
+{ // _gradeSlab
+  assert(0 != pGrid);
+
+  const int numLen = pGrid->lenEnd - pGrid->lenBegin;
+  const int numWidth = pGrid->widthEnd - pGrid->widthBegin;
+  const int numHt = pGrid->numHt;
+  int numLines = 0;
+  switch (dir)
+    { // switch
+    case VERTICAL :
+      numLines = numLen * numWidth;
+      break;
+    case LENGTH :
+      numLines = numWidth * numHt;
+      break;
+    case WIDTH :
+      numLines = numLen * numHt;
+      break;
+    default :
+      assert(0);
+    } // switch
+  if (numLines <= 0)
+    return;
+
+  int numThreads = _numThreads;
+  if (numThreads <= 0)
+    numThreads = std::thread::hardware_concurrency();
+  if (numThreads <= 0)
+    numThreads = 1;
+  if (numThreads > numLines)
+    numThreads = numLines;
+
+  if (1 == numThreads) {
+    _gradeLines(pGrid, dir, 0, numLines);
+    return;
+  } // if
+
+  // Lines are independent, so each thread grades a contiguous range.
+  std::vector<std::thread> threads;
+  for (int iThread=0; iThread < numThreads; ++iThread) {
+    const int lineBegin = int(long(numLines) * iThread / numThreads);
+    const int lineEnd = int(long(numLines) * (iThread+1) / numThreads);
+    threads.push_back(std::thread(&VsGrader::_gradeLines, this, pGrid, dir,
+				  lineBegin, lineEnd));
+  } // for
+  for (int iThread=0; iThread < numThreads; ++iThread)
+    threads[iThread].join();
+} // _gradeSlab
+
+// ----------------------------------------------------------------------
+// Limit gradient along range of lines of current slab.
+void
+cencalvm::vsgrader::VsGrader::_gradeLines(GridStruct* pGrid,
+					  const DirectionEnum dir,
+					  const int lineBegin,
+					  const int lineEnd) const
+{ // _gradeLines
+  assert(0 != pGrid);
+  assert(0 != _pGeom);
+
+  const int numWidth = pGrid->widthEnd - pGrid->widthBegin;
+  const int numHt = pGrid->numHt;
+  const double resHoriz = _resVert * _pGeom->vertExag();
+
+  int dataLen = 0;
+  size_t stride = 0;
+  double maxdiff = 0.0;
+  switch (dir)
+    { // switch
+    case VERTICAL :
+      dataLen = numHt;
+      stride = 1;
+      maxdiff = _gradientMaxVs * _resVert;
+      break;
+    case LENGTH :
+      assert(pGrid->lenEnd - pGrid->lenBegin == pGrid->numLen);
+      dataLen = pGrid->numLen;
+      stride = size_t(numWidth) * numHt;
+      maxdiff = _gradientMaxVs * resHoriz;
+      break;
+    case WIDTH :
+      assert(numWidth == pGrid->numWidth);
+      dataLen = numWidth;
+      stride = numHt;
+      maxdiff = _gradientMaxVs * resHoriz;
+      break;
+    default :
+      assert(0);
+    } // switch
+
+  cencalvm::storage::PayloadStruct* pData = 
+    (dataLen > 0) ? new cencalvm::storage::PayloadStruct[dataLen] : 0;
+  bool* pIsChanged = (dataLen > 0) ? new bool[dataLen] : 0;
+  for (int iLine=lineBegin; iLine < lineEnd; ++iLine) {
+    size_t start = 0;
+    switch (dir)
+      { // switch
+      case VERTICAL :
+	start = size_t(iLine) * numHt;
+	break;
+      case LENGTH : // lines are ordered by width, then height
+	start = iLine;
+	break;
+      case WIDTH :
+	start = size_t(iLine / numHt) * numWidth * numHt + iLine % numHt;
+	break;
+      default :
+	assert(0);
+      } // switch
+    cencalvm::storage::PayloadStruct* pLine = &pGrid->slab[start];
+
+    for (int i=0; i < dataLen; ++i)
+      pData[i] = pLine[i*stride];
+    _limitDiff(&pData, &pIsChanged, dataLen, maxdiff);
+    for (int i=0; i < dataLen; ++i)
+      if (pIsChanged[i])
+	pLine[i*stride] = pData[i];
+  } // for
+  delete[] pData; pData = 0;
+  delete[] pIsChanged; pIsChanged = 0;
+} // _gradeLines
+
 // ----------------------------------------------------------------------
 // Compute longitude and latitude given length and width
 void
@@ -495,57 +800,6 @@ cencalvm::vsgrader::VsGrader::_indexToLonLat(double* pLon,
   pProj->invProject(pLon, pLat, x, y);
 } // _indexToLonLat
 
-// ----------------------------------------------------------------------
-// Get data from database. Payload is returned through the parameters.
-void
-cencalvm::vsgrader::VsGrader::_pullData(cencalvm::storage::PayloadStruct* pPayload,
-					const double lon,
-					const double lat,
-					const double elev,
-					etree_t* pDB) const
-{ // _pullData
-  assert(0 != pPayload);
-  assert(0 != pDB);
-  assert(0 != _pGeom);
-
-  etree_addr_t addr;
-  addr.type = ETREE_LEAF;
-
-  const double resHoriz = _resVert * _pGeom->vertExag();
-  addr.level = _pGeom->level(resHoriz);
-
-  _pGeom->lonLatElevToAddr(&addr, lon, lat, elev);
-  
-  etree_addr_t resAddr;
-  int err = etree_search(pDB, addr, &resAddr, "*", pPayload);
-  if (0 != err)
-    throw std::runtime_error("Could not find octant in database.");
-} // _pullData
-
-// ----------------------------------------------------------------------
-// Update data in database.
-void
-cencalvm::vsgrader::VsGrader::_pushData(etree_t* pDB,
-			      const cencalvm::storage::PayloadStruct& payload,
-					const double lon,
-					const double lat,
-					const double elev) const
-{ // _pushData
-  assert(0 != pDB);
-  assert(0 != _pGeom);
-
-  etree_addr_t addr;
-  addr.type = ETREE_LEAF;
-
-  const double resHoriz = _resVert * _pGeom->vertExag();
-  addr.level = _pGeom->level(resHoriz);
-
-  _pGeom->lonLatElevToAddr(&addr, lon, lat, elev);
-  int err = etree_update(pDB, addr, &payload);
-  if (0 != err)
-    throw std::runtime_error("Could not update octant in database.");
-} // _pushData
-
 // ----------------------------------------------------------------------
 // Limit maximum difference in Vs. Other material properties are
 void
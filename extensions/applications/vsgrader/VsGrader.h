@@ -14,15 +14,26 @@
  *
  * @brief C++ manager for limiting gradient in shear wave speed in
  * velocity model stored as an Etree database.
+ *
+ * The box is extracted into a dense grid of payloads that is graded
+ * in memory. Lines in the vertical, length, and width directions are
+ * graded in parallel. If the grid does not fit in the memory budget,
+ * it is stored in a scratch file and graded in slabs spanning the
+ * direction being graded. The graded grid is written to the output
+ * database with a single sequential append.
  */
 
 #if !defined(cencalvm_vsgrader_vsgrader_h)
 #define cencalvm_vsgrader_vsgrader_h
 
 #include <string> // HASA std::string
+#include <vector> // HASA std::vector
 #include "cencalvm/query/VMQuery.h" // HASA QueryEnum
+#include "cencalvm/storage/Payload.h" // HASA PayloadStruct
+#include "cencalvm/storage/CacheMonitor.h" // USES CacheMonitor::AUTOSIZE
 
-#include "cencalvm/storage/etreefwd.h" // USES etree_t
+#include <stdio.h> // HOLDSA FILE
+#include <sys/types.h> // USES size_t
 
 namespace cencalvm {
   namespace vsgrader {
@@ -32,7 +43,7 @@ namespace cencalvm {
   namespace storage {
     class Geometry; // HOLDSA Geometry
     class Projector; // HOLDSA Projector
-    class PayloadStruct; // forward declaration
+    class Telemetry; // HOLDSA Telemetry
   } // namespace storage
 } // namespace vsgrader
 
@@ -63,7 +74,11 @@ public :
    */
   void filenameOut(const char* filename);
 
-  /** Set filename of temporary database.
+  /** Set filename of scratch file.
+   *
+   * The scratch file holds the grid when it does not fit in memory
+   * and is the root name of the temporary files used to sort the
+   * octants of the output database.
    *
    * @param filename Name of file
    */
@@ -77,10 +92,30 @@ public :
 
   /** Set cache size.
    *
-   * @param size of cache in MB
+   * With storage::CacheMonitor::AUTOSIZE the cache of the input
+   * database is sized automatically while querying (see
+   * query::VMQuery::cacheSize()) and the cache of the output database
+   * is sized from the available memory and the size of the input
+   * database.
+   *
+   * @param size of cache in MB or storage::CacheMonitor::AUTOSIZE
    */
   void cacheSize(const int size);
 
+  /** Set size of memory used for the grid and for sorting octants.
+   *
+   * @param size Size of memory in MB
+   */
+  void memorySize(const int size);
+
+  /** Set number of threads used to grade lines.
+   *
+   * Default behavior is to use one thread per processor.
+   *
+   * @param num Number of threads (0 to use number of processors)
+   */
+  void numThreads(const int num);
+
   /** Set velocity model geometry.
    *
    * @param pGeometry Pointer to geometry
@@ -95,9 +130,50 @@ public :
    */
   void quiet(const bool flag);
 
+  /** Set telemetry for reporting progress of extracting ("extract"),
+   * grading ("grade"), and inserting ("insert") points and merging
+   * them into the new database ("merge").
+   *
+   * @param pTelemetry Pointer to telemetry (0 for none)
+   */
+  void telemetry(storage::Telemetry* pTelemetry);
+
   /// Create Etree database with maximum gradient.
   void run(void);
 
+ private :
+  // PRIVATE ENUMS //////////////////////////////////////////////////////
+
+  /// Direction of lines in grid
+  enum DirectionEnum {
+    VERTICAL=0, ///< Lines along height
+    LENGTH=1, ///< Lines along length
+    WIDTH=2 ///< Lines along width
+  }; // DirectionEnum
+
+ private :
+  // PRIVATE STRUCTS ////////////////////////////////////////////////////
+
+  /// Dense grid of payloads and current slab.
+  struct GridStruct {
+    int numLen; ///< Number of points in length direction
+    int numWidth; ///< Number of points in width direction
+    int numHt; ///< Number of points in vertical direction
+    int slabLen; ///< Number of length indices in slabs across length
+    int slabWidth; ///< Number of width indices in slabs across width
+    bool isTiled; ///< True if grid is stored in scratch file
+    FILE* fileTmp; ///< Scratch file holding grid
+    std::vector<double> lon; ///< Longitude of vertical columns
+    std::vector<double> lat; ///< Latitude of vertical columns
+
+    /// Payloads of current slab ordered by length, width, then height
+    std::vector<storage::PayloadStruct> slab;
+    int lenBegin; ///< First length index of current slab
+    int lenEnd; ///< Length index past end of current slab
+    int widthBegin; ///< First width index of current slab
+    int widthEnd; ///< Width index past end of current slab
+  }; // GridStruct
+
  private :
   // PRIVATE METHODS ////////////////////////////////////////////////////
 
@@ -107,14 +183,81 @@ public :
   /// Initialize.
   void _initialize(void);
 
-  /// Extract database.
-  void _extract(void) const;
+  /** Set dimensions of grid and size of slabs, and open scratch file
+   * if grid does not fit in memory.
+   *
+   * @param pGrid Pointer to grid
+   */
+  void _initGrid(GridStruct* pGrid) const;
 
-  /// Pack new database.
-  void _pack(void) const;
+  /** Close and remove scratch file.
+   *
+   * @param pGrid Pointer to grid
+   */
+  void _closeGrid(GridStruct* pGrid) const;
 
-  /// Limit gradient in database.
-  void _grade(void) const;
+  /** Extract grid from database.
+   *
+   * @param pGrid Pointer to grid
+   */
+  void _extract(GridStruct* pGrid) const;
+
+  /** Limit gradient in grid.
+   *
+   * @param pGrid Pointer to grid
+   */
+  void _grade(GridStruct* pGrid) const;
+
+  /** Write grid to new database.
+   *
+   * @param pGrid Pointer to grid
+   */
+  void _pack(GridStruct* pGrid) const;
+
+  /** Make slab current, reading it from scratch file if grid is tiled.
+   *
+   * Slab spans all heights.
+   *
+   * @param pGrid Pointer to grid
+   * @param lenBegin First length index of slab
+   * @param lenEnd Length index past end of slab
+   * @param widthBegin First width index of slab
+   * @param widthEnd Width index past end of slab
+   * @param isRead True if values should be read
+   */
+  void _loadSlab(GridStruct* pGrid,
+		 const int lenBegin,
+		 const int lenEnd,
+		 const int widthBegin,
+		 const int widthEnd,
+		 const bool isRead) const;
+
+  /** Write current slab to scratch file if grid is tiled.
+   *
+   * @param pGrid Pointer to grid
+   */
+  void _storeSlab(GridStruct* pGrid) const;
+
+  /** Limit gradient along all lines in a direction of current slab
+   * using several threads.
+   *
+   * @param pGrid Pointer to grid
+   * @param dir Direction of lines
+   */
+  void _gradeSlab(GridStruct* pGrid,
+		  const DirectionEnum dir) const;
+
+  /** Limit gradient along range of lines of current slab.
+   *
+   * @param pGrid Pointer to grid
+   * @param dir Direction of lines
+   * @param lineBegin Index of first line
+   * @param lineEnd Index of line past end of range
+   */
+  void _gradeLines(GridStruct* pGrid,
+		   const DirectionEnum dir,
+		   const int lineBegin,
+		   const int lineEnd) const;
 
   /** Compute elevation given height index.
    *
@@ -137,34 +280,6 @@ public :
 		      const int indexL,
 		      const int indexW) const;
 
-  /** Get data from database. Payload is returned through the parameters.
-   *
-   * @param pPayload Pointer to payload
-   * @param lon Longitude of location
-   * @param lat Latitude of location
-   * @param elev Elevation of location
-   * @param pDB Pointer to database
-   */
-  void _pullData(cencalvm::storage::PayloadStruct* pPayload,
-		 const double lon,
-		 const double lat,
-		 const double elev,
-		 etree_t* db) const;
-
-  /** Update data in database.
-   *
-   * @param pDB Pointer to database to update
-   * @param pPayload Pointer to payload
-   * @param lon Longitude of location
-   * @param lat Latitude of location
-   * @param elev Elevation of location
-   */
-  void _pushData(etree_t* pDB,
-		 const cencalvm::storage::PayloadStruct& payload,
-		 const double lon,
-		 const double lat,
-		 const double elev) const;
-
   /** Limit maximum difference in Vs. Other material properties are
    * changed proportionally.
    *
@@ -205,13 +320,16 @@ private :
 
   std::string _filenameIn; ///< Filename for input database
   std::string _filenameOut; ///< Filename for output database
-  std::string _filenameTmp; ///< Filename for temporary database
+  std::string _filenameTmp; ///< Filename for scratch file
   std::string _filenameParams; ///< Filename for parameters
 
+  size_t _memorySize; ///< Size of memory for grid and sorting in bytes
   int _cacheSize; ///< Database cache size in MB
+  int _numThreads; ///< Number of threads used to grade lines
   query::VMQuery::QueryEnum _queryType; ///< Type of query in extraction
 
   cencalvm::storage::Geometry* _pGeom; ///< Velocity model geometry
+  cencalvm::storage::Telemetry* _pTelemetry; ///< Pointer to telemetry
 
   bool _quiet; ///< Flag to eliminate progress reports
 
@@ -226,6 +344,8 @@ private :
   /// Zone for locations not in input database
   static const int16_t _NODATAZONE;
 
+  static const double _AUTOFRACTION; ///< Fraction of memory for output cache
+
 }; // VsGrader
 
 #include "VsGrader.icc" // inline methods
@@ -14,9 +14,12 @@
 // velocity model.
 
 #include "VsGrader.h" // USES VMCreator
+#include "cencalvm/storage/Telemetry.h" // USES Telemetry
+#include "cencalvm/storage/CacheMonitor.h" // USES CacheMonitor
 
 #include <stdlib.h> // USES exit()
 #include <stdio.h> // USES EOF
+#include <strings.h> // USES strcasecmp()
 #include <unistd.h> // USES getopt()
 
 #include <iostream> // USES std::cerr
@@ -29,10 +32,20 @@ usage(void)
 { // usage
   std::cerr
     << "usage: gradecencalvm [-h] -p paramFile -i inFile -o outFile -t tmpFile\n"
+    << "                     [-c cacheSize] [-m memorySize] [-j numThreads]\n"
+    << "                     [-w jsonFile]\n"
     << "  -p paramFile  Parameter file with list of grid input files\n"
     << "  -i inFile     Input Etree database file.\n"
     << "  -o outFile    Output Etree database file.\n"
     << "  -t tmpFile    Name of scratch file used in database construction.\n"
+    << "  -c cacheSize  Size of cache in MB for each database or 'auto' to\n"
+    << "                size caches from available memory and queries.\n"
+    << "  -m memorySize Size of memory in MB for grid (default is 1024); larger\n"
+    << "                grids are graded in slabs stored in the scratch file.\n"
+    << "  -j numThreads Number of threads used to grade lines (default is\n"
+    << "                number of processors).\n"
+    << "  -w jsonFile   Write telemetry of each phase (octants/s, bytes read\n"
+    << "                and written, ETA) to jsonFile as JSON lines.\n"
     << "  -h            Display usage and exit.\n"
     << "\n"
     << "Parameter file is list of grid input files, one per line.\n";
@@ -46,6 +59,9 @@ parseArgs(std::string* pFilenameParams,
 	  std::string* pFilenameOut,
 	  std::string* pFilenameTmp,
 	  int* pCacheSize,
+	  int* pMemorySize,
+	  int* pNumThreads,
+	  std::string* pFilenameTelemetry,
 	  int argc,
 	  char** argv)
 { // parseArgs
@@ -54,6 +70,9 @@ parseArgs(std::string* pFilenameParams,
   assert(0 != pFilenameOut);
   assert(0 != pFilenameTmp);
   assert(0 != pCacheSize);
+  assert(0 != pMemorySize);
+  assert(0 != pNumThreads);
+  assert(0 != pFilenameTelemetry);
 
   extern char* optarg;
 
@@ -62,12 +81,14 @@ parseArgs(std::string* pFilenameParams,
   *pFilenameIn = "";
   *pFilenameOut = "";
   *pFilenameTmp = "";
+  *pFilenameTelemetry = "";
   int c = EOF;
-  while ( (c = getopt(argc, argv, "c:hi:o:p:t:") ) != EOF) {
+  while ( (c = getopt(argc, argv, "c:hi:j:m:o:p:t:w:") ) != EOF) {
     switch (c)
       { // switch
 	case 'c' : // process -c option
-	  *pCacheSize = atoi(optarg);
+	  *pCacheSize = (0 == strcasecmp(optarg, "auto")) ?
+	    cencalvm::storage::CacheMonitor::AUTOSIZE : atoi(optarg);
 	  nparsed += 2;
 	  break;
 	case 'h' : // process -h option
@@ -79,6 +100,14 @@ parseArgs(std::string* pFilenameParams,
 	  *pFilenameIn = optarg;
 	  nparsed += 2;
 	  break;
+	case 'j' : // process -j option
+	  *pNumThreads = atoi(optarg);
+	  nparsed += 2;
+	  break;
+	case 'm' : // process -m option
+	  *pMemorySize = atoi(optarg);
+	  nparsed += 2;
+	  break;
 	case 'o' : // process -o option
 	  *pFilenameOut = optarg;
 	  nparsed += 2;
@@ -91,6 +120,10 @@ parseArgs(std::string* pFilenameParams,
 	  *pFilenameTmp = optarg;
 	  nparsed += 2;
 	  break;
+	case 'w' : // process -w option
+	  *pFilenameTelemetry = optarg;
+	  nparsed += 2;
+	  break;
 	default :
 	  usage();
 	} // switch
@@ -113,12 +146,18 @@ main(int argc,
   std::string filenameOut = "";
   std::string filenameTmp = "";
   int cacheSize = 128;
+  int memorySize = 1024;
+  int numThreads = 0;
+  std::string filenameTelemetry = "";
   
   try {
     parseArgs(&filenameParams, &filenameIn, &filenameOut, &filenameTmp,
-	      &cacheSize,
+	      &cacheSize, &memorySize, &numThreads, &filenameTelemetry,
 	      argc, argv);
 
+    cencalvm::storage::Telemetry telemetry;
+    telemetry.filename(filenameTelemetry.c_str());
+
     cencalvm::vsgrader::VsGrader grader;
 
     grader.filenameParams(filenameParams.c_str());
@@ -126,6 +165,9 @@ main(int argc,
     grader.filenameOut(filenameOut.c_str());
     grader.filenameTmp(filenameTmp.c_str());
     grader.cacheSize(cacheSize);
+    grader.memorySize(memorySize);
+    grader.numThreads(numThreads);
+    grader.telemetry(&telemetry);
     grader.run();
   } catch (const std::exception& err) {
     std::cerr << err.what();
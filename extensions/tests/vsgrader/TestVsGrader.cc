@@ -21,6 +21,8 @@ extern "C" {
 #include "etree.h"
 }
 
+#include <stdexcept> // USES std::runtime_error
+
 // ----------------------------------------------------------------------
 CPPUNIT_TEST_SUITE_REGISTRATION( cencalvm::vsgrader::TestVsGrader );
 
@@ -111,6 +113,33 @@ cencalvm::vsgrader::TestVsGrader::testCacheSize(void)
   CPPUNIT_ASSERT_EQUAL(cacheSize, grader._cacheSize);
 } // testCacheSize
 
+// ----------------------------------------------------------------------
+// Test memorySize()
+void
+cencalvm::vsgrader::TestVsGrader::testMemorySize(void)
+{ // testMemorySize
+  const int memorySize = 12;
+
+  VsGrader grader;
+  grader.memorySize(memorySize);
+  CPPUNIT_ASSERT_EQUAL(size_t(memorySize)*1024*1024, grader._memorySize);
+  grader.memorySize(0);
+  CPPUNIT_ASSERT_EQUAL(size_t(memorySize)*1024*1024, grader._memorySize);
+} // testMemorySize
+
+// ----------------------------------------------------------------------
+// Test numThreads()
+void
+cencalvm::vsgrader::TestVsGrader::testNumThreads(void)
+{ // testNumThreads
+  VsGrader grader;
+  CPPUNIT_ASSERT_EQUAL(0, grader._numThreads); // default is all processors
+  grader.numThreads(3);
+  CPPUNIT_ASSERT_EQUAL(3, grader._numThreads);
+  grader.numThreads(-1);
+  CPPUNIT_ASSERT_EQUAL(3, grader._numThreads);
+} // testNumThreads
+
 // ----------------------------------------------------------------------
 // Test quiet()
 void
@@ -216,78 +245,6 @@ cencalvm::vsgrader::TestVsGrader::testIndexToLonLat(void)
   CPPUNIT_ASSERT_DOUBLES_EQUAL(latE, lat, fabs(latE)*tolerance);
 } // testindexToLonLat
 
-// ----------------------------------------------------------------------
-// Test pullData()
-void
-cencalvm::vsgrader::TestVsGrader::testPullData(void)
-{ // testPullData
-  _createDB();
-
-  etree_t* db = etree_open(_FILENAMEDB, O_RDONLY, 0, 0, 3);
-  CPPUNIT_ASSERT(0 != db);
-  
-  VsGrader grader;
-  grader._resVert = _RESVERT;
-  cencalvm::storage::PayloadStruct payload;
-  grader._pullData(&payload, _SWCORNERLON, _SWCORNERLAT, _SWCORNERELEV, db);
-
-  const double tolerance = 1.0e-06;
-  CPPUNIT_ASSERT_DOUBLES_EQUAL(_DBVS, payload.Vs, _DBVS*tolerance);
-  CPPUNIT_ASSERT_DOUBLES_EQUAL(0.1, payload.Vp, 0.1*tolerance);
-  CPPUNIT_ASSERT_DOUBLES_EQUAL(0.2, payload.Density, 0.2*tolerance);
-  CPPUNIT_ASSERT_DOUBLES_EQUAL(0.3, payload.Qp, 0.3*tolerance);
-  CPPUNIT_ASSERT_DOUBLES_EQUAL(0.4, payload.Qs, 0.4*tolerance);
-  CPPUNIT_ASSERT_DOUBLES_EQUAL(0.5, payload.DepthFreeSurf, 0.5*tolerance);
-  CPPUNIT_ASSERT_EQUAL(int16_t(6), payload.FaultBlock);
-  CPPUNIT_ASSERT_EQUAL(int16_t(7), payload.Zone);
-
-  int err = etree_close(db);
-  CPPUNIT_ASSERT(0 == err);
-} // testPullData
-
-// ----------------------------------------------------------------------
-// Test pushData()
-void
-cencalvm::vsgrader::TestVsGrader::testPushPull(void)
-{ // testPushPull
-  _createDB();
-
-  etree_t* db = etree_open(_FILENAMEDB, O_RDWR, 0, 0, 3);
-  CPPUNIT_ASSERT(0 != db);
-  
-  VsGrader grader;
-  cencalvm::storage::PayloadStruct payload;
-  payload.Vs = _DBVS+1.0;
-  payload.Vp = -0.1;
-  payload.Density = -0.2;
-  payload.Qp = -0.3;
-  payload.Qs = -0.4;
-  payload.DepthFreeSurf = -0.5;
-  payload.FaultBlock = -6;
-  payload.Zone = -7;
-  grader._resVert = _RESVERT;
-  grader._pushData(db, payload, _SWCORNERLON, _SWCORNERLAT, _SWCORNERELEV);
-  
-  cencalvm::storage::PayloadStruct payloadN;
-  grader._pullData(&payloadN, _SWCORNERLON, _SWCORNERLAT, _SWCORNERELEV, db);
-
-  const double tolerance = 1.0e-06;
-  CPPUNIT_ASSERT_DOUBLES_EQUAL(1.0, payloadN.Vs/payload.Vs, tolerance);
-  CPPUNIT_ASSERT_DOUBLES_EQUAL(1.0, payloadN.Vp/payload.Vp, tolerance);
-  CPPUNIT_ASSERT_DOUBLES_EQUAL(1.0, payloadN.Density/payload.Density, 
-			       tolerance);
-  CPPUNIT_ASSERT_DOUBLES_EQUAL(1.0, payloadN.Qp/payload.Qp, tolerance);
-  CPPUNIT_ASSERT_DOUBLES_EQUAL(1.0, payloadN.Qs/payload.Qs, tolerance);
-  CPPUNIT_ASSERT_DOUBLES_EQUAL(1.0, payloadN.DepthFreeSurf/payload.DepthFreeSurf, 
-			       tolerance);
-  CPPUNIT_ASSERT_DOUBLES_EQUAL(1.0, payloadN.FaultBlock/payload.FaultBlock, 
-			       tolerance);
-  CPPUNIT_ASSERT_DOUBLES_EQUAL(1.0, payloadN.Zone/payload.Zone, tolerance);
-
-  int err = etree_close(db);
-  CPPUNIT_ASSERT(0 == err);
-} // testPushPull
-
 // ----------------------------------------------------------------------
 // Test limitDiff()
 void
@@ -342,40 +299,280 @@ cencalvm::vsgrader::TestVsGrader::testLimitDiff(void)
 } // testLimitDiff
 
 // ----------------------------------------------------------------------
-// Create etree to test push/pull.
+// Test grade() with grid in memory
+void
+cencalvm::vsgrader::TestVsGrader::testGrade(void)
+{ // testGrade
+  VsGrader grader;
+  _setupGrader(&grader);
+  grader.numThreads(3);
+
+  VsGrader::GridStruct grid;
+  grader._initGrid(&grid);
+  CPPUNIT_ASSERT(!grid.isTiled);
+  CPPUNIT_ASSERT_EQUAL(_NUMLEN, grid.numLen);
+  CPPUNIT_ASSERT_EQUAL(_NUMWIDTH, grid.numWidth);
+  CPPUNIT_ASSERT_EQUAL(_NUMHT, grid.numHt);
+  CPPUNIT_ASSERT_EQUAL(_NUMLEN, grid.slabLen);
+  CPPUNIT_ASSERT_EQUAL(_NUMWIDTH, grid.slabWidth);
+
+  _fillGrid(grader, &grid);
+  grader._grade(&grid);
+  _checkGrade(grader, &grid);
+  grader._closeGrid(&grid);
+} // testGrade
+
+// ----------------------------------------------------------------------
+// Test grade() with grid tiled in scratch file
+void
+cencalvm::vsgrader::TestVsGrader::testGradeTiled(void)
+{ // testGradeTiled
+  VsGrader grader;
+  _setupGrader(&grader);
+  grader.numThreads(2);
+  grader.filenameTmp(_FILENAMETMP);
+
+  // Memory for two planes across length
+  const int numSlabLen = 2;
+  grader._memorySize = 
+    numSlabLen * _NUMLEN * _NUMHT * sizeof(storage::PayloadStruct);
+
+  VsGrader::GridStruct grid;
+  grader._initGrid(&grid);
+  CPPUNIT_ASSERT(grid.isTiled);
+  CPPUNIT_ASSERT(0 != grid.fileTmp);
+  CPPUNIT_ASSERT_EQUAL(numSlabLen*_NUMLEN/_NUMWIDTH, grid.slabLen);
+  CPPUNIT_ASSERT_EQUAL(numSlabLen, grid.slabWidth);
+
+  _fillGrid(grader, &grid);
+  grader._grade(&grid);
+  _checkGrade(grader, &grid);
+  grader._closeGrid(&grid);
+  CPPUNIT_ASSERT(0 == grid.fileTmp);
+
+  // Too little memory for a slab
+  grader._memorySize = sizeof(storage::PayloadStruct);
+  VsGrader::GridStruct gridSmall;
+  CPPUNIT_ASSERT_THROW(grader._initGrid(&gridSmall), std::runtime_error);
+} // testGradeTiled
+
+// ----------------------------------------------------------------------
+// Test pack()
 void
-cencalvm::vsgrader::TestVsGrader::_createDB(void) const
-{ // _createDB
+cencalvm::vsgrader::TestVsGrader::testPack(void)
+{ // testPack
   CPPUNIT_ASSERT(0 != _pGeom);
 
-  etree_t* db = etree_open(_FILENAMEDB, O_CREAT|O_RDWR|O_TRUNC, 0, 0, 3);
-  CPPUNIT_ASSERT(0 != db);
+  VsGrader grader;
+  _setupGrader(&grader);
+  grader.filenameOut(_FILENAMEDB);
+  grader.filenameTmp(_FILENAMETMP);
+  grader._swcornerLon = _SWCORNERLON;
+  grader._swcornerLat = _SWCORNERLAT;
+  grader._swcornerElev = _SWCORNERELEV;
+  grader._initialize();
 
-  int err = etree_registerschema(db, cencalvm::storage::Payload::SCHEMA);
-  CPPUNIT_ASSERT(0 == err);
+  VsGrader::GridStruct grid;
+  grader._initGrid(&grid);
+  _fillGrid(grader, &grid);
+  for (int iLen=0; iLen < _NUMLEN; ++iLen)
+    for (int iWidth=0; iWidth < _NUMWIDTH; ++iWidth) {
+      const int iColumn = iLen*_NUMWIDTH + iWidth;
+      grader._indexToLonLat(&grid.lon[iColumn], &grid.lat[iColumn], 
+			    iLen, iWidth);
+    } // for
+  grader._pack(&grid);
+  grader._closeGrid(&grid);
+
+  etree_t* db = etree_open(_FILENAMEDB, O_RDONLY, 0, 0, 3);
+  CPPUNIT_ASSERT(0 != db);
 
   etree_addr_t addr;
   addr.type = ETREE_LEAF;
-  const double vertExag = _pGeom->vertExag();
   addr.level = _pGeom->level(_RESVERT*_pGeom->vertExag());
-  _pGeom->lonLatElevToAddr(&addr, _SWCORNERLON, _SWCORNERLAT, _SWCORNERELEV);
-  
-  cencalvm::storage::PayloadStruct payload;
-  payload.Vp = 0.1;
-  payload.Vs = _DBVS;
-  payload.Density = 0.2;
-  payload.Qp = 0.3;
-  payload.Qs = 0.4;
-  payload.DepthFreeSurf = 0.5;
-  payload.FaultBlock = 6;
-  payload.Zone = 7;
-
-  err = etree_insert(db, addr, &payload);
-  CPPUNIT_ASSERT(0 == err);
-  
-  err = etree_close(db);
+  const double tolerance = 1.0e-06;
+  for (int iLen=0; iLen < _NUMLEN; ++iLen)
+    for (int iWidth=0; iWidth < _NUMWIDTH; ++iWidth) {
+      const int iColumn = iLen*_NUMWIDTH + iWidth;
+      for (int iHt=0; iHt < _NUMHT; ++iHt) {
+	_pGeom->lonLatElevToAddr(&addr, grid.lon[iColumn], grid.lat[iColumn],
+				 grader._indexToElev(iHt));
+	etree_addr_t resAddr;
+	storage::PayloadStruct payload;
+	int err = etree_search(db, addr, &resAddr, "*", &payload);
+	CPPUNIT_ASSERT(0 == err);
+	CPPUNIT_ASSERT_EQUAL(addr.level, resAddr.level);
+
+	storage::PayloadStruct payloadE;
+	_payload(&payloadE, iLen, iWidth, iHt);
+	CPPUNIT_ASSERT_DOUBLES_EQUAL(1.0, payload.Vs/payloadE.Vs, tolerance);
+	CPPUNIT_ASSERT_DOUBLES_EQUAL(1.0, payload.Vp/payloadE.Vp, tolerance);
+	CPPUNIT_ASSERT_EQUAL(payloadE.FaultBlock, payload.FaultBlock);
+      } // for
+    } // for
+
+  int err = etree_close(db);
   CPPUNIT_ASSERT(0 == err);
-} // _createDB
+} // testPack
+
+// ----------------------------------------------------------------------
+// Setup grader with small test grid.
+void
+cencalvm::vsgrader::TestVsGrader::_setupGrader(VsGrader* pGrader)
+{ // _setupGrader
+  CPPUNIT_ASSERT(0 != pGrader);
+
+  pGrader->quiet(true);
+  pGrader->_resVert = _RESVERT;
+  pGrader->_gradientMaxVs = _VSGRADIENTMAX;
+  const double resHoriz = _RESVERT * pGrader->_pGeom->vertExag();
+  pGrader->_domainLen = (_NUMLEN-1) * resHoriz;
+  pGrader->_domainWidth = (_NUMWIDTH-1) * resHoriz;
+  pGrader->_domainHt = (_NUMHT-1) * _RESVERT;
+} // _setupGrader
+
+// ----------------------------------------------------------------------
+// Get payload of point in test grid.
+void
+cencalvm::vsgrader::TestVsGrader::_payload(storage::PayloadStruct* pPayload,
+					   const int iLen,
+					   const int iWidth,
+					   const int iHt)
+{ // _payload
+  CPPUNIT_ASSERT(0 != pPayload);
+
+  // Jumps in Vs exceed maximum gradient in all directions.
+  const double vs = 100.0 + 150.0 * ((7*iLen + 13*iWidth + 5*iHt) % 11);
+  pPayload->Vs = vs;
+  pPayload->Vp = 1.7*vs;
+  pPayload->Density = 2.0*vs;
+  pPayload->Qp = 0.1*vs;
+  pPayload->Qs = 0.05*vs;
+  pPayload->DepthFreeSurf = iHt*_RESVERT;
+  pPayload->FaultBlock = int16_t(iLen);
+  pPayload->Zone = int16_t(iWidth);
+} // _payload
+
+// ----------------------------------------------------------------------
+// Fill test grid, one slab across length at a time.
+void
+cencalvm::vsgrader::TestVsGrader::_fillGrid(const VsGrader& grader,
+					    VsGrader::GridStruct* pGrid)
+{ // _fillGrid
+  CPPUNIT_ASSERT(0 != pGrid);
+
+  for (int lenBegin=0; lenBegin < _NUMLEN; lenBegin += pGrid->slabLen) {
+    const int lenEnd = (lenBegin + pGrid->slabLen < _NUMLEN) ?
+      lenBegin + pGrid->slabLen : _NUMLEN;
+    grader._loadSlab(pGrid, lenBegin, lenEnd, 0, _NUMWIDTH, false);
+    int index = 0;
+    for (int iLen=lenBegin; iLen < lenEnd; ++iLen)
+      for (int iWidth=0; iWidth < _NUMWIDTH; ++iWidth)
+	for (int iHt=0; iHt < _NUMHT; ++iHt)
+	  _payload(&pGrid->slab[index++], iLen, iWidth, iHt);
+    grader._storeSlab(pGrid);
+  } // for
+} // _fillGrid
+
+// ----------------------------------------------------------------------
+// Limit gradient in test grid one line at a time.
+void
+cencalvm::vsgrader::TestVsGrader::_gradeSerial(
+			       std::vector<storage::PayloadStruct>* pData,
+			       const VsGrader& grader,
+			       const VsGrader::GridStruct& grid)
+{ // _gradeSerial
+  CPPUNIT_ASSERT(0 != pData);
+
+  const int numLen = grid.numLen;
+  const int numWidth = grid.numWidth;
+  const int numHt = grid.numHt;
+  const double resHoriz = grader._resVert * grader._pGeom->vertExag();
+  std::vector<storage::PayloadStruct>& data = *pData;
+
+  const int maxLen = numLen + numWidth + numHt;
+  storage::PayloadStruct* pLine = new storage::PayloadStruct[maxLen];
+  bool* pIsChanged = new bool[maxLen];
+
+  // Vertical
+  for (int iLen=0; iLen < numLen; ++iLen)
+    for (int iWidth=0; iWidth < numWidth; ++iWidth) {
+      const int start = (iLen*numWidth + iWidth)*numHt;
+      for (int iHt=0; iHt < numHt; ++iHt)
+	pLine[iHt] = data[start+iHt];
+      grader._limitDiff(&pLine, &pIsChanged, numHt,
+			grader._gradientMaxVs*grader._resVert);
+      for (int iHt=0; iHt < numHt; ++iHt)
+	data[start+iHt] = pLine[iHt];
+    } // for
+
+  // Length
+  for (int iHt=0; iHt < numHt; ++iHt)
+    for (int iWidth=0; iWidth < numWidth; ++iWidth) {
+      for (int iLen=0; iLen < numLen; ++iLen)
+	pLine[iLen] = data[(iLen*numWidth + iWidth)*numHt + iHt];
+      grader._limitDiff(&pLine, &pIsChanged, numLen,
+			grader._gradientMaxVs*resHoriz);
+      for (int iLen=0; iLen < numLen; ++iLen)
+	data[(iLen*numWidth + iWidth)*numHt + iHt] = pLine[iLen];
+    } // for
+
+  // Width
+  for (int iHt=0; iHt < numHt; ++iHt)
+    for (int iLen=0; iLen < numLen; ++iLen) {
+      for (int iWidth=0; iWidth < numWidth; ++iWidth)
+	pLine[iWidth] = data[(iLen*numWidth + iWidth)*numHt + iHt];
+      grader._limitDiff(&pLine, &pIsChanged, numWidth,
+			grader._gradientMaxVs*resHoriz);
+      for (int iWidth=0; iWidth < numWidth; ++iWidth)
+	data[(iLen*numWidth + iWidth)*numHt + iHt] = pLine[iWidth];
+    } // for
+
+  delete[] pLine; pLine = 0;
+  delete[] pIsChanged; pIsChanged = 0;
+} // _gradeSerial
+
+// ----------------------------------------------------------------------
+// Check grid against expected result of grading.
+void
+cencalvm::vsgrader::TestVsGrader::_checkGrade(const VsGrader& grader,
+					      VsGrader::GridStruct* pGrid)
+{ // _checkGrade
+  CPPUNIT_ASSERT(0 != pGrid);
+
+  const int numCells = _NUMLEN*_NUMWIDTH*_NUMHT;
+  std::vector<storage::PayloadStruct> dataE(numCells);
+  int index = 0;
+  for (int iLen=0; iLen < _NUMLEN; ++iLen)
+    for (int iWidth=0; iWidth < _NUMWIDTH; ++iWidth)
+      for (int iHt=0; iHt < _NUMHT; ++iHt)
+	_payload(&dataE[index++], iLen, iWidth, iHt);
+  _gradeSerial(&dataE, grader, *pGrid);
+
+  grader._loadSlab(pGrid, 0, _NUMLEN, 0, _NUMWIDTH, true);
+  CPPUNIT_ASSERT_EQUAL(size_t(numCells), pGrid->slab.size());
+  int numChanged = 0;
+  const double tolerance = 1.0e-06;
+  for (int i=0; i < numCells; ++i) {
+    const storage::PayloadStruct& payload = pGrid->slab[i];
+    const storage::PayloadStruct& payloadE = dataE[i];
+    CPPUNIT_ASSERT_DOUBLES_EQUAL(1.0, payload.Vs/payloadE.Vs, tolerance);
+    CPPUNIT_ASSERT_DOUBLES_EQUAL(1.0, payload.Vp/payloadE.Vp, tolerance);
+    CPPUNIT_ASSERT_DOUBLES_EQUAL(1.0, payload.Density/payloadE.Density,
+				 tolerance);
+    CPPUNIT_ASSERT_DOUBLES_EQUAL(1.0, payload.Qp/payloadE.Qp, tolerance);
+    CPPUNIT_ASSERT_DOUBLES_EQUAL(1.0, payload.Qs/payloadE.Qs, tolerance);
+    CPPUNIT_ASSERT_EQUAL(payloadE.FaultBlock, payload.FaultBlock);
+    CPPUNIT_ASSERT_EQUAL(payloadE.Zone, payload.Zone);
+
+    storage::PayloadStruct payloadOrig;
+    _payload(&payloadOrig, i / (_NUMWIDTH*_NUMHT), (i / _NUMHT) % _NUMWIDTH,
+	     i % _NUMHT);
+    if (payload.Vs != payloadOrig.Vs)
+      ++numChanged;
+  } // for
+  CPPUNIT_ASSERT(numChanged > 0);
+} // _checkGrade
 
 // version
 // $Id$
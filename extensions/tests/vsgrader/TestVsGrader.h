@@ -22,6 +22,10 @@
 
 #include <cppunit/extensions/HelperMacros.h>
 
+#include "VsGrader.h" // USES VsGrader::GridStruct
+
+#include <vector> // USES std::vector
+
 namespace cencalvm {
   namespace vsgrader {
     class TestVsGrader;
@@ -43,14 +47,17 @@ class cencalvm::vsgrader::TestVsGrader : public CppUnit::TestFixture
   CPPUNIT_TEST( testFilenameOut );
   CPPUNIT_TEST( testFilenameTmp );
   CPPUNIT_TEST( testCacheSize );
+  CPPUNIT_TEST( testMemorySize );
+  CPPUNIT_TEST( testNumThreads );
   CPPUNIT_TEST( testQuiet );
   CPPUNIT_TEST( testReadParams );
   CPPUNIT_TEST( testInitialize );
   CPPUNIT_TEST( testIndexToElev );
   CPPUNIT_TEST( testIndexToLonLat );
-  CPPUNIT_TEST( testPullData );
-  CPPUNIT_TEST( testPushPull );
   CPPUNIT_TEST( testLimitDiff );
+  CPPUNIT_TEST( testGrade );
+  CPPUNIT_TEST( testGradeTiled );
+  CPPUNIT_TEST( testPack );
   CPPUNIT_TEST_SUITE_END();
 
   // PUBLIC METHODS /////////////////////////////////////////////////////
@@ -80,6 +87,12 @@ public :
   /// Test cacheSize()
   void testCacheSize(void);
 
+  /// Test memorySize()
+  void testMemorySize(void);
+
+  /// Test numThreads()
+  void testNumThreads(void);
+
   /// Test quiet()
   void testQuiet(void);
 
@@ -95,20 +108,65 @@ public :
   /// Test indexToLonLat()
   void testIndexToLonLat(void);
 
-  /// Test pullData()
-  void testPullData(void);
-
-  /// Test push() and pull()
-  void testPushPull(void);
-
   /// Test limitDiff()
   void testLimitDiff(void);
 
+  /// Test grade() with grid in memory
+  void testGrade(void);
+
+  /// Test grade() with grid tiled in scratch file
+  void testGradeTiled(void);
+
+  /// Test pack()
+  void testPack(void);
+
   // PRIVATE METHODS ////////////////////////////////////////////////////
 private :
 
-  /// Create test database
-  void _createDB(void) const;
+  /** Setup grader with small test grid.
+   *
+   * @param pGrader Pointer to grader
+   */
+  static void _setupGrader(VsGrader* pGrader);
+
+  /** Get payload of point in test grid.
+   *
+   * @param pPayload Pointer to payload
+   * @param iLen Index in length direction
+   * @param iWidth Index in width direction
+   * @param iHt Index in vertical direction
+   */
+  static void _payload(storage::PayloadStruct* pPayload,
+		       const int iLen,
+		       const int iWidth,
+		       const int iHt);
+
+  /** Fill test grid, one slab across length at a time.
+   *
+   * @param grader Grader
+   * @param pGrid Pointer to grid
+   */
+  static void _fillGrid(const VsGrader& grader,
+			VsGrader::GridStruct* pGrid);
+
+  /** Limit gradient in test grid one line at a time as expected
+   * result of grading.
+   *
+   * @param pData Pointer to payloads ordered by length, width, height
+   * @param grader Grader
+   * @param grid Grid
+   */
+  static void _gradeSerial(std::vector<storage::PayloadStruct>* pData,
+			   const VsGrader& grader,
+			   const VsGrader::GridStruct& grid);
+
+  /** Check grid against expected result of grading.
+   *
+   * @param grader Grader
+   * @param pGrid Pointer to grid
+   */
+  static void _checkGrade(const VsGrader& grader,
+			  VsGrader::GridStruct* pGrid);
 
   // PRIVATE MEMBERS ////////////////////////////////////////////////////
 private :
@@ -128,10 +186,13 @@ private :
   static const double _SWCORNERX; ///< Projected x coordinate of SW top corner
   static const double _SWCORNERY; ///< Projected y coordinate of SW top corner
 
-  static const double _DBVS; ///< Vs value in test database
+  static const int _NUMLEN; ///< Number of points along length of test grid
+  static const int _NUMWIDTH; ///< Number of points along width of test grid
+  static const int _NUMHT; ///< Number of points along height of test grid
 
   static const char* _FILENAMEPARAMS; ///< Name of sample parameter file
   static const char* _FILENAMEDB; ///< Name of test database
+  static const char* _FILENAMETMP; ///< Name of scratch file
 
 }; // class TestVsGrader
 
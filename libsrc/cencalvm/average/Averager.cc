@@ -13,19 +13,37 @@
 #include "Averager.h" // implementation of class methods
 
 #include "cencalvm/storage/Payload.h" // USES PayloadStruct
+#include "cencalvm/storage/Telemetry.h" // USES Telemetry
+#include "cencalvm/storage/DBSnapshot.h" // USES DBSnapshot
 #include "AvgEngine.h" // USES AvgEngine
+#include "DirtyList.h" // USES DirtyList
 
 extern "C" {
 #include "etree.h"
 }
 
+#include <iostream> // USES std::cout
+#include <stdio.h> // USES remove()
+#include <stdlib.h> // USES free()
+
 #include <stdexcept> // USES std::runtime_error
 #include <sstream> // USES std::ostringstream
 #include <iomanip> // USES setw(), setiosflags(), resetiosflags()
 #include <assert.h> // USES assert()
-#include <string.h> // USES strcmp()
+#include <string.h> // USES strcmp(), memcmp()
 #include <time.h> // USES time_t
 
+// ----------------------------------------------------------------------
+namespace {
+  /// Identifier at start of checkpoint file.
+  const char CHECKPOINTMAGIC[8] = { 'C', 'V', 'M', 'A', 'V', 'G', 'C', 'P' };
+  /// Version of checkpoint file format.
+  const int32_t CHECKPOINTVERSION = 2;
+} // namespace
+
+// ----------------------------------------------------------------------
+const double cencalvm::average::Averager::_AUTOFRACTION = 0.25;
+
 // ----------------------------------------------------------------------
 // Default constructor
 cencalvm::average::Averager::Averager(void) :
@@ -33,6 +51,14 @@ cencalvm::average::Averager::Averager(void) :
   _dbAvg(0),
   _filenameIn(""),
   _filenameOut(""),
+  _bufferSize(AvgEngine::DEFAULTBUFFERSIZE),
+  _cacheSize(512),
+  _cacheSizeUsed(512),
+  _checkpointInterval(0),
+  _maxInput(0),
+  _resume(false),
+  _checkpointSlot(-1),
+  _pTelemetry(0),
   _quiet(false)
 { // constructor
 } // constructor
@@ -58,7 +84,8 @@ void
 cencalvm::average::Averager::average(void)
 { // average
   // Open input database
-  const int cacheSize = 512;
+  _cacheSizeUsed = _chooseCacheSize(_filenameIn.c_str());
+  const int cacheSize = _cacheSizeUsed;
   const int numDims = 3;
   const int payloadSize = sizeof(cencalvm::storage::PayloadStruct);
   _dbIn = etree_open(_filenameIn.c_str(), O_RDONLY,
@@ -94,22 +121,391 @@ cencalvm::average::Averager::average(void)
   } // if
 
   // Open avg database for output
-  _dbAvg = etree_open(_filenameOut.c_str(),
-		      O_CREAT|O_RDWR|O_TRUNC, cacheSize, payloadSize, numDims);
+  if (_resume) {
+    // Restore octants appended before the checkpoint.
+    _restoreCheckpointDB();
+    _dbAvg = etree_open(_filenameOut.c_str(), O_RDWR, cacheSize, 0, 0);
+    if (0 == _dbAvg) {
+      std::ostringstream msg;
+      msg
+	<< "Could not open etree database '" << _filenameOut
+	<< "' to resume averaging.";
+      throw std::runtime_error(msg.str());
+    } // if
+    if (etree_getpayloadsize(_dbAvg) != payloadSize) {
+      std::ostringstream msg;
+      msg
+	<< "Payload size of averaged etree database '" << _filenameOut
+	<< "' doesn't match the expected payload size.";
+      throw std::runtime_error(msg.str());
+    } // if
+  } else {
+    _dbAvg = etree_open(_filenameOut.c_str(),
+			O_CREAT|O_RDWR|O_TRUNC, cacheSize, payloadSize, numDims);
+    if (0 == _dbAvg) {
+      std::ostringstream msg;
+      msg
+	<< "Could not open etree database '" << _filenameOut
+	<< "' for output of averaged etree database .";
+      throw std::runtime_error(msg.str());
+    } // if
+
+    // Register schema in output database
+    if (0 != etree_registerschema(_dbAvg, cencalvm::storage::Payload::SCHEMA))
+      throw std::runtime_error(etree_strerror(etree_errno(_dbAvg)));
+
+    // Set database metadata if input etree has metadata
+    char* appmeta = etree_getappmeta(_dbIn);
+    if (0 != appmeta) {
+      const int maxLen = 128;
+      char hostname[maxLen];
+      gethostname(hostname, maxLen);
+      time_t rawTime = time(0);
+      const char* datetime = ctime(&rawTime);
+      std::ostringstream metainfo;
+      metainfo
+	<< appmeta << "\n"
+	<< "spatially averaged on: " << datetime
+	<< "host: "  << hostname;
+      if (0 != etree_setappmeta(_dbAvg, metainfo.str().c_str()))
+	throw std::runtime_error(etree_strerror(etree_errno(_dbAvg)));
+    } // if
+  } // if/else
+
+  if (0 != _pTelemetry) {
+    _pTelemetry->beginPhase("average", etree_gettotalcount(_dbIn));
+    _pTelemetry->cacheSize(cacheSize);
+  } // if
+  AvgEngine engine(_dbAvg, _dbIn, _bufferSize);
+  engine.telemetry(_pTelemetry);
+  if (0 == _checkpointInterval && 0 == _maxInput && !_resume) {
+    engine.fillOctants();
+    if (!_quiet)
+      engine.printOctantInfo();
+  } else if (_fillOctants(&engine)) {
+    if (!_quiet)
+      engine.printOctantInfo();
+    const std::string filenameCheckpoint = _filenameOut + ".checkpoint";
+    remove(filenameCheckpoint.c_str());
+    storage::DBSnapshot::remove(_filenameOut.c_str());
+  } // if/else
+  if (0 != _pTelemetry)
+    _pTelemetry->endPhase();
+
+  etree_close(_dbIn); _dbIn = 0;
+  etree_close(_dbAvg); _dbAvg = 0;
+} // average
+
+// ----------------------------------------------------------------------
+// Fill in octants of output database while reading input database
+// with a cursor, writing checkpoints at regular intervals.
+bool
+cencalvm::average::Averager::_fillOctants(AvgEngine* pEngine)
+{ // _fillOctants
+  assert(0 != pEngine);
+  assert(0 != _dbIn);
+  assert(0 != _dbAvg);
+
+  etree_addr_t cursor;
+  cursor.x = 0;
+  cursor.y = 0;
+  cursor.z = 0;
+  cursor.t = 0;
+  cursor.level = ETREE_MAXLEVEL;
+
+  cencalvm::storage::PayloadStruct payload;
+  bool more = false;
+  if (_resume) {
+    _readCheckpoint(&cursor, pEngine);
+    pEngine->resumeFill(_dbAvg);
+    if (!_quiet)
+      std::cout << "Resuming averaging of etree database '" << _filenameIn
+		<< "' from checkpoint." << std::endl;
+
+    // Cursor starts at last octant averaged before the checkpoint.
+    etree_addr_t addr = cursor;
+    more = (0 == etree_initcursor(_dbIn, cursor));
+    if (more && 0 != etree_getcursor(_dbIn, &addr, 0, &payload))
+      throw std::runtime_error(etree_strerror(etree_errno(_dbIn)));
+    if (!more ||
+	addr.x != cursor.x || addr.y != cursor.y || addr.z != cursor.z ||
+	addr.level != cursor.level) {
+      std::ostringstream msg;
+      msg
+	<< "Etree database '" << _filenameIn << "' does not contain the "
+	<< "last octant averaged before the checkpoint.";
+      throw std::runtime_error(msg.str());
+    } // if
+    more = (0 == etree_advcursor(_dbIn));
+  } else {
+    pEngine->beginFill();
+    more = (0 == etree_initcursor(_dbIn, cursor));
+  } // if/else
+
+  size_t numInput = 0;
+  size_t numSinceCheckpoint = 0;
+  while (more) {
+    if (0 != etree_getcursor(_dbIn, &cursor, 0, &payload))
+      throw std::runtime_error("Error occurred while trying to get payload at "
+			       "current cursor position.");
+    if (0 != _pTelemetry)
+      _pTelemetry->addBytesRead(sizeof(payload));
+    pEngine->addOctant(&cursor, payload);
+    more = (0 == etree_advcursor(_dbIn));
+
+    ++numInput;
+    ++numSinceCheckpoint;
+    const bool stop = _maxInput > 0 && numInput >= _maxInput;
+    if (more && (stop || (_checkpointInterval > 0 &&
+			  numSinceCheckpoint >= _checkpointInterval))) {
+      _writeCheckpoint(cursor, pEngine);
+      if (stop)
+	return false;
+      pEngine->resumeFill(_dbAvg);
+      numSinceCheckpoint = 0;
+    } // if
+  } // while
+
+  pEngine->endFill();
+  return true;
+} // _fillOctants
+
+// ----------------------------------------------------------------------
+// Write checkpoint.
+void
+cencalvm::average::Averager::_writeCheckpoint(const etree_addr_t& addrInput,
+					      AvgEngine* pEngine)
+{ // _writeCheckpoint
+  assert(0 != pEngine);
+  assert(0 != _dbAvg);
+
+  // Etree has no sync operation, so closing the database is the only
+  // way to flush its cache. The closed database is copied to a
+  // snapshot, because a process killed after the checkpoint can
+  // leave a database that is not a valid tree.
+  pEngine->suspendFill();
+  const int cacheSize = _cacheSizeUsed;
+  const int closeErr = etree_close(_dbAvg);
+  _dbAvg = 0;
+  if (0 != closeErr) {
+    std::ostringstream msg;
+    msg
+      << "Could not close etree database '" << _filenameOut
+      << "' at checkpoint.";
+    throw std::runtime_error(msg.str());
+  } // if
+  const int32_t slot = (_checkpointSlot + 1) % storage::DBSnapshot::NUMSLOTS;
+  const uint64_t length = storage::DBSnapshot::save(_filenameOut.c_str(), slot);
+  _dbAvg = etree_open(_filenameOut.c_str(), O_RDWR, cacheSize, 0, 0);
+  if (0 == _dbAvg) {
+    std::ostringstream msg;
+    msg
+      << "Could not reopen etree database '" << _filenameOut
+      << "' at checkpoint.";
+    throw std::runtime_error(msg.str());
+  } // if
+
+  // Replace checkpoint file only after new one is complete.
+  const std::string filename = _filenameOut + ".checkpoint";
+  const std::string filenameTmp = filename + ".tmp";
+  FILE* fp = fopen(filenameTmp.c_str(), "wb");
+  if (0 == fp) {
+    std::ostringstream msg;
+    msg << "Could not open checkpoint file '" << filenameTmp
+	<< "' for writing.";
+    throw std::runtime_error(msg.str());
+  } // if
+  bool isOkay =
+    1 == fwrite(CHECKPOINTMAGIC, sizeof(CHECKPOINTMAGIC), 1, fp) &&
+    1 == fwrite(&CHECKPOINTVERSION, sizeof(CHECKPOINTVERSION), 1, fp) &&
+    1 == fwrite(&slot, sizeof(slot), 1, fp) &&
+    1 == fwrite(&length, sizeof(length), 1, fp) &&
+    1 == fwrite(&addrInput, sizeof(addrInput), 1, fp);
+  try {
+    if (isOkay)
+      pEngine->saveState(fp);
+  } catch (const std::exception&) {
+    isOkay = false;
+  } // try/catch
+  if (0 != fclose(fp))
+    isOkay = false;
+  if (!isOkay || 0 != rename(filenameTmp.c_str(), filename.c_str())) {
+    std::ostringstream msg;
+    msg << "Could not write checkpoint file '" << filename << "'.";
+    throw std::runtime_error(msg.str());
+  } // if
+  _checkpointSlot = slot;
+} // _writeCheckpoint
+
+// ----------------------------------------------------------------------
+// Choose size of etree cache of databases.
+int
+cencalvm::average::Averager::_chooseCacheSize(const char* filename) const
+{ // _chooseCacheSize
+  assert(0 != filename);
+
+  if (storage::CacheMonitor::AUTOSIZE != _cacheSize)
+    return _cacheSize;
+
+  // Averaging reads the input database in order and appends to the
+  // output database, so the working set is the whole database.
+  const int cacheSize = storage::CacheMonitor::maxSize(filename, _AUTOFRACTION);
+  if (!_quiet)
+    std::cout
+      << "Using automatic etree cache of " << cacheSize << " MB for each "
+      << "database (" << storage::CacheMonitor::availableMemory() / 1048576
+      << " MB of memory available, database '" << filename << "')."
+      << std::endl;
+  return cacheSize;
+} // _chooseCacheSize
+
+// ----------------------------------------------------------------------
+// Read checkpoint.
+void
+cencalvm::average::Averager::_readCheckpoint(etree_addr_t* pAddrInput,
+					     AvgEngine* pEngine)
+{ // _readCheckpoint
+  assert(0 != pAddrInput);
+  assert(0 != pEngine);
+
+  const std::string filename = _filenameOut + ".checkpoint";
+  int32_t slot = 0;
+  uint64_t length = 0;
+  FILE* fp = _openCheckpoint(&slot, &length);
+  bool isOkay = 1 == fread(pAddrInput, sizeof(etree_addr_t), 1, fp);
+  try {
+    if (isOkay)
+      pEngine->loadState(fp);
+  } catch (const std::exception&) {
+    isOkay = false;
+  } // try/catch
+  fclose(fp);
+  if (!isOkay) {
+    std::ostringstream msg;
+    msg << "File '" << filename << "' is not a valid checkpoint of "
+	<< "averaging.";
+    throw std::runtime_error(msg.str());
+  } // if
+  _checkpointSlot = slot;
+} // _readCheckpoint
+
+// ----------------------------------------------------------------------
+// Replace output database with its snapshot at the checkpoint.
+void
+cencalvm::average::Averager::_restoreCheckpointDB(void) const
+{ // _restoreCheckpointDB
+  int32_t slot = 0;
+  uint64_t length = 0;
+  FILE* fp = _openCheckpoint(&slot, &length);
+  fclose(fp);
+  storage::DBSnapshot::restore(_filenameOut.c_str(), slot, length);
+} // _restoreCheckpointDB
+
+// ----------------------------------------------------------------------
+// Open checkpoint file and read its header.
+FILE*
+cencalvm::average::Averager::_openCheckpoint(int32_t* pSlot,
+					     uint64_t* pLength) const
+{ // _openCheckpoint
+  assert(0 != pSlot);
+  assert(0 != pLength);
+
+  const std::string filename = _filenameOut + ".checkpoint";
+  FILE* fp = fopen(filename.c_str(), "rb");
+  if (0 == fp) {
+    std::ostringstream msg;
+    msg << "Could not open checkpoint file '" << filename
+	<< "' for reading.";
+    throw std::runtime_error(msg.str());
+  } // if
+  char magic[sizeof(CHECKPOINTMAGIC)];
+  int32_t version = 0;
+  const bool isOkay =
+    1 == fread(magic, sizeof(magic), 1, fp) &&
+    0 == memcmp(magic, CHECKPOINTMAGIC, sizeof(magic)) &&
+    1 == fread(&version, sizeof(version), 1, fp) &&
+    CHECKPOINTVERSION == version &&
+    1 == fread(pSlot, sizeof(int32_t), 1, fp) &&
+    *pSlot >= 0 && *pSlot < storage::DBSnapshot::NUMSLOTS &&
+    1 == fread(pLength, sizeof(uint64_t), 1, fp);
+  if (!isOkay) {
+    fclose(fp);
+    std::ostringstream msg;
+    msg << "File '" << filename << "' is not a valid checkpoint of "
+	<< "averaging.";
+    throw std::runtime_error(msg.str());
+  } // if
+
+  return fp;
+} // _openCheckpoint
+
+// ----------------------------------------------------------------------
+// Update spatially averaged database in place using its dirty list.
+void
+cencalvm::average::Averager::update(void)
+{ // update
+  const std::string filenameDirty = DirtyList::filename(_filenameOut.c_str());
+  DirtyList dirty;
+  dirty.read(filenameDirty.c_str());
+  update(dirty);
+  remove(filenameDirty.c_str());
+} // update
+
+// ----------------------------------------------------------------------
+// Update spatially averaged database in place using given dirty octants.
+void
+cencalvm::average::Averager::update(const DirtyList& dirty)
+{ // update
+  _cacheSizeUsed = _chooseCacheSize(_filenameOut.c_str());
+  const int cacheSize = _cacheSizeUsed;
+  const int numDims = 3;
+  const int payloadSize = sizeof(cencalvm::storage::PayloadStruct);
+  _dbAvg = etree_open(_filenameOut.c_str(), O_RDWR,
+		      cacheSize, payloadSize, numDims);
   if (0 == _dbAvg) {
     std::ostringstream msg;
     msg
       << "Could not open etree database '" << _filenameOut
-      << "' for output of averaged etree database .";
+      << "' for updating averages.";
     throw std::runtime_error(msg.str());
   } // if
 
-  // Register schema in output database
-  if (0 != etree_registerschema(_dbAvg, cencalvm::storage::Payload::SCHEMA))
-    throw std::runtime_error(etree_strerror(etree_errno(_dbAvg)));
+  // Check compatibility of database
+  if (etree_getpayloadsize(_dbAvg) != payloadSize) {
+    std::ostringstream msg;
+    msg
+      << "Payload size of averaged etree database '" << _filenameOut
+      << "' doesn't match the expected payload size.\n"
+      << "Expected payload size is " << payloadSize
+      << ", and database payload size is " << etree_getpayloadsize(_dbAvg)
+      << ".";
+    throw std::runtime_error(msg.str());
+  } // if
+  char* schema = etree_getschema(_dbAvg);
+  const bool isSchemaOkay =
+    0 != schema && 0 == strcmp(schema, cencalvm::storage::Payload::SCHEMA);
+  free(schema);
+  if (!isSchemaOkay) {
+    std::ostringstream msg;
+    msg
+      << "Schema of averaged etree database '" << _filenameOut
+      << "' doesn't match the expected schema.";
+    throw std::runtime_error(msg.str());
+  } // if
 
-  // Set database metadata if input etree has metadata
-  char* appmeta = etree_getappmeta(_dbIn);
+  if (!_quiet)
+    std::cout
+      << "Updating averages of " << dirty.size() << " dirty octants in "
+      << "etree database '" << _filenameOut << "'." << std::endl;
+
+  // Write-behind buffer is not used when updating in place.
+  AvgEngine engine(_dbAvg, 0, 1);
+  const size_t numUpdated = engine.updateOctants(dirty);
+  if (!_quiet)
+    std::cout << "Recomputed " << numUpdated << " interior octants."
+	      << std::endl;
+
+  char* appmeta = etree_getappmeta(_dbAvg);
   if (0 != appmeta) {
     const int maxLen = 128;
     char hostname[maxLen];
@@ -119,20 +515,15 @@ cencalvm::average::Averager::average(void)
     std::ostringstream metainfo;
     metainfo
       << appmeta << "\n"
-      << "spatially averaged on: " << datetime
+      << "incrementally averaged on: " << datetime
       << "host: "  << hostname;
+    free(appmeta);
     if (0 != etree_setappmeta(_dbAvg, metainfo.str().c_str()))
       throw std::runtime_error(etree_strerror(etree_errno(_dbAvg)));
   } // if
 
-  AvgEngine engine(_dbAvg, _dbIn);
-  engine.fillOctants();
-  if (!_quiet)
-    engine.printOctantInfo();
-
-  etree_close(_dbIn); _dbIn = 0;
   etree_close(_dbAvg); _dbAvg = 0;
-} // average
+} // update
   
 // version
 // $Id$
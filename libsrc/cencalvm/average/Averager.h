@@ -23,18 +23,29 @@
 #define cencalvm_average_averager_h
 
 #include <string> // HASA std::string
+#include <sys/types.h> // USES size_t
+#include <inttypes.h> // USES int32_t, uint64_t
+#include <stdio.h> // USES FILE
 #include "cencalvm/storage/etreefwd.h" // HOLDSA etree_t
+#include "cencalvm/storage/CacheMonitor.h" // USES CacheMonitor::AUTOSIZE
 
 namespace cencalvm {
   namespace average {
     class Averager;
+    class AvgEngine; // USES AvgEngine
+    class DirtyList; // USES DirtyList
+    class TestAverager; // friend
   } // namespace average
+  namespace storage {
+    class Telemetry; // HOLDSA Telemetry
+  } // namespace storage
 } // namespace cencalvm
 
 /// C++ manager for spatial averaging of an etree database containing
 /// the USGS central CA velocity model
 class cencalvm::average::Averager
 { // Projector
+  friend class TestAverager; // unit testing
 
 public :
   // PUBLIC METHODS /////////////////////////////////////////////////////
@@ -57,11 +68,70 @@ public :
    */
   void filenameOut(const char* filename);
 
+  /** Set maximum number of octants held in the write-behind buffer
+   * while averaging.
+   *
+   * Interior octants with more descendants than fit in the buffer are
+   * appended before their averages are known and updated afterwards.
+   *
+   * @param size Number of octants
+   */
+  void bufferSize(const int size);
+
+  /** Set size of etree cache of each database.
+   *
+   * With storage::CacheMonitor::AUTOSIZE the cache is sized from the
+   * available memory and the size of the database (see
+   * storage::CacheMonitor::maxSize()) and the size chosen is reported.
+   * Default is 512 MB.
+   *
+   * @param size Size of cache in MB or storage::CacheMonitor::AUTOSIZE
+   */
+  void cacheSize(const int size);
+
+  /** Set number of input octants averaged between checkpoints.
+   *
+   * Each checkpoint appends the octants in the write-behind buffer,
+   * closes the output database to flush it to disk, copies it to a
+   * snapshot (see storage::DBSnapshot), reopens it, and records the
+   * snapshot, the last input octant, and the pending interior
+   * octants in the file filenameOut.checkpoint. Resuming restores
+   * the output database from the snapshot, so the interval should be
+   * large enough that copying the output database is a small part of
+   * averaging. Default behavior (0) is no checkpoints.
+   *
+   * @param numOctants Number of input octants between checkpoints
+   */
+  void checkpointInterval(const size_t numOctants);
+
+  /** Set flag indicating averaging should resume from the last
+   * checkpoint of an interrupted run with the same input database.
+   *
+   * @param flag True to resume from checkpoint, false to start at
+   * beginning
+   */
+  void resume(const bool flag);
+
   /** Spatially average etree database by filling in etree octants
    * with average of their children.
    */
   void average(void);
 
+  /** Update spatially averaged database (output database) in place by
+   * recomputing only the interior octants affected by the octants in
+   * its dirty list (see DirtyList::filename()). The dirty list is
+   * removed once the database has been updated.
+   */
+  void update(void);
+
+  /** Update spatially averaged database (output database) in place by
+   * recomputing only the interior octants affected by the given dirty
+   * octants.
+   *
+   * @param dirty List of octants whose payloads changed
+   */
+  void update(const DirtyList& dirty);
+
   /** Set flag indicating creation should be quiet (no progress reports).
    *
    * Default behavior is for to give progress reports.
@@ -70,6 +140,13 @@ public :
    */
   void quiet(const bool flag);
 
+  /** Set telemetry for reporting progress of averaging (phase
+   * "average").
+   *
+   * @param pTelemetry Pointer to telemetry (0 for none)
+   */
+  void telemetry(storage::Telemetry* pTelemetry);
+
 private :
   // PRIVATE METHODS ////////////////////////////////////////////////////
 
@@ -79,6 +156,56 @@ private :
 private :
   // PRIVATE METHODS ////////////////////////////////////////////////////
 
+  /** Fill in octants of output database while reading input database
+   * with a cursor, writing checkpoints at regular intervals.
+   *
+   * @param pEngine Pointer to averaging engine
+   *
+   * @returns True if all octants were averaged, false if averaging
+   * stopped at a checkpoint
+   */
+  bool _fillOctants(AvgEngine* pEngine);
+
+  /** Write checkpoint.
+   *
+   * @param addrInput Address of last input octant averaged
+   * @param pEngine Pointer to averaging engine
+   */
+  void _writeCheckpoint(const etree_addr_t& addrInput,
+			AvgEngine* pEngine);
+
+  /** Choose size of etree cache of databases.
+   *
+   * @param filename Name of database used to size automatic cache
+   *
+   * @returns Size of cache in MB
+   */
+  int _chooseCacheSize(const char* filename) const;
+
+  /** Read checkpoint.
+   *
+   * @param pAddrInput Pointer to address of last input octant averaged
+   * @param pEngine Pointer to averaging engine
+   */
+  void _readCheckpoint(etree_addr_t* pAddrInput,
+		       AvgEngine* pEngine);
+
+  /** Replace output database with its snapshot at the checkpoint, so
+   * that octants written after the checkpoint (possibly only in part)
+   * are discarded.
+   */
+  void _restoreCheckpointDB(void) const;
+
+  /** Open checkpoint file and read its header.
+   *
+   * @param pSlot Pointer to slot of snapshot of output database
+   * @param pLength Pointer to length of output database in bytes
+   *
+   * @returns Checkpoint file positioned after the header
+   */
+  FILE* _openCheckpoint(int32_t* pSlot,
+			uint64_t* pLength) const;
+
 private :
   // PRIVATE MEMBERS ////////////////////////////////////////////////////
 
@@ -87,9 +214,22 @@ private :
 
   std::string _filenameIn; ///< Filename of input database
   std::string _filenameOut; ///< Filename of output database
+
+  int _bufferSize; ///< Number of octants in write-behind buffer
+  int _cacheSize; ///< Size of etree cache in MB (or AUTOSIZE)
+  int _cacheSizeUsed; ///< Size of etree cache of open databases in MB
+  size_t _checkpointInterval; ///< Number of octants between checkpoints
+  /// Number of input octants after which averaging stops at a
+  /// checkpoint (0 for no limit; used to test resuming)
+  size_t _maxInput;
+  bool _resume; ///< Flag to resume from checkpoint
+  int32_t _checkpointSlot; ///< Snapshot slot of last checkpoint (-1 if none)
+  storage::Telemetry* _pTelemetry; ///< Pointer to telemetry
   
   bool _quiet; ///< Flag to eliminate progress reports
 
+  static const double _AUTOFRACTION; ///< Fraction of memory for each cache
+
 }; // Averager
 
 #include "Averager.icc" // inline methods
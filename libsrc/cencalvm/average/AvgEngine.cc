@@ -12,13 +12,19 @@
 
 #include "AvgEngine.h" // implementation of class methods
 
+#include "DirtyList.h" // USES DirtyList
+
 #include "cencalvm/storage/Payload.h" // USES PayloadStruct
 #include "cencalvm/storage/Geometry.h" // USES Geometry
+#include "cencalvm/storage/Telemetry.h" // USES Telemetry
 
 extern "C" {
 #include "etree.h"
 }
 
+#include <vector> // USES std::vector
+#include <set> // USES std::set
+
 #include <stdexcept> // USES std::runtime_error
 #include <sstream> // USES std::ostringstream
 #include <assert.h> // USES assert()
@@ -27,16 +33,25 @@ extern "C" {
 // ----------------------------------------------------------------------
 const etree_tick_t cencalvm::average::AvgEngine::_LEFTMOSTONE =
   ~(~((etree_tick_t)0) >> 1);
+const int cencalvm::average::AvgEngine::DEFAULTBUFFERSIZE = 1048576;
 
 // ----------------------------------------------------------------------
 // Default constructor
 cencalvm::average::AvgEngine::AvgEngine(etree_t* dbOut,
-					etree_t* dbIn) :
+					etree_t* dbIn,
+					const int bufferSize) :
   _dbAvg(dbOut),
   _dbIn(dbIn),
   _pPendingOctants(0),
   _pendingSize(0),
-  _pendingCursor(-1)
+  _pendingCursor(-1),
+  _pBuffer(0),
+  _bufferSize(0),
+  _bufferHead(0),
+  _bufferCount(0),
+  _pLastAppended(new etree_addr_t),
+  _numAppended(0),
+  _pTelemetry(0)
 { // constructor
   const int pendingSize = ETREE_MAXLEVEL + 1;
   _pPendingOctants = new OctantPendingStruct[pendingSize];
@@ -49,14 +64,27 @@ cencalvm::average::AvgEngine::AvgEngine(etree_t* dbOut,
     _pPendingOctants[i].pAddr->z = 0;
     _pPendingOctants[i].pAddr->t = 0;
     _pPendingOctants[i].pAddr->level = 0;
+    _pPendingOctants[i].bufferSlot = -1;
     _pPendingOctants[i].processedChildren = 0x00;
     _pPendingOctants[i].isValid = false;
   } // if
   _pendingSize = pendingSize;
+
+  // Buffer must be able to hold at least one octant
+  _bufferSize = (bufferSize > 0) ? bufferSize : 1;
+  _pBuffer = new OctantBufferedStruct[_bufferSize];
+  etree_addr_t* pAddrs = new etree_addr_t[_bufferSize];
+  storage::PayloadStruct* pPayloads = new storage::PayloadStruct[_bufferSize];
+  for (int i=0; i < _bufferSize; ++i) {
+    _pBuffer[i].pAddr = &pAddrs[i];
+    _pBuffer[i].pPayload = &pPayloads[i];
+    _pBuffer[i].isFinal = false;
+  } // for
   
   _octantCounter.input = 0;
   _octantCounter.output = 0;
   _octantCounter.interior = 0;
+  _octantCounter.updated = 0;
   _octantCounter.inc_x = 0;
   _octantCounter.inc_y = 0;
   _octantCounter.inc_z = 0;
@@ -65,6 +93,12 @@ cencalvm::average::AvgEngine::AvgEngine(etree_t* dbOut,
   _octantCounter.inc_xz = 0;
   _octantCounter.inc_xyz = 0;
   _octantCounter.inc_invalid = 0;  
+
+  _pLastAppended->x = 0;
+  _pLastAppended->y = 0;
+  _pLastAppended->z = 0;
+  _pLastAppended->t = 0;
+  _pLastAppended->level = 0;
 } // constructor
   
 // ----------------------------------------------------------------------
@@ -78,6 +112,17 @@ cencalvm::average::AvgEngine::~AvgEngine(void)
     } // for
   delete[] _pPendingOctants; _pPendingOctants = 0;
   _pendingSize = 0;
+
+  if (0 != _pBuffer) {
+    // Addresses and payloads of all slots are allocated as one array each
+    delete[] _pBuffer[0].pAddr;
+    delete[] _pBuffer[0].pPayload;
+  } // if
+  delete[] _pBuffer; _pBuffer = 0;
+  _bufferSize = 0;
+  _bufferCount = 0;
+
+  delete _pLastAppended; _pLastAppended = 0;
 } // destructor
 
 // ----------------------------------------------------------------------
@@ -99,10 +144,7 @@ cencalvm::average::AvgEngine::fillOctants(void)
   if (eof)
     throw std::runtime_error("Error occurred while initializing etree cursor.");
 
-  int err = etree_beginappend(_dbAvg, 1.0);
-  if (0 != err)
-    throw std::runtime_error("Error occurred while trying to initiate appending "
-			     "of etree.");
+  beginFill();
 
   storage::PayloadStruct payload;
   while (!eof) {
@@ -110,17 +152,287 @@ cencalvm::average::AvgEngine::fillOctants(void)
     if (eof)
       throw std::runtime_error("Error occurred while trying to get payload at "
 			       "current cursor position.");
+    if (0 != _pTelemetry)
+      _pTelemetry->addBytesRead(sizeof(payload));
     _averageOctant(&cursor, payload);
     eof = etree_advcursor(_dbIn);
   } // while
 
+  endFill();
+} // fillOctants
+
+// ----------------------------------------------------------------------
+// Prepare to add octants to the averaged database.
+void
+cencalvm::average::AvgEngine::beginFill(void)
+{ // beginFill
+  assert(0 != _dbAvg);
+
+  int err = etree_beginappend(_dbAvg, 1.0);
+  if (0 != err)
+    throw std::runtime_error("Error occurred while trying to initiate appending "
+			     "of etree.");
+} // beginFill
+
+// ----------------------------------------------------------------------
+// Add octant whose values are final and include its contribution in
+// the averages of its ancestors.
+void
+cencalvm::average::AvgEngine::addOctant(etree_addr_t* pAddr,
+				       const storage::PayloadStruct& payload)
+{ // addOctant
+  _averageOctant(pAddr, payload);
+} // addOctant
+
+// ----------------------------------------------------------------------
+// Append descendant of a subtree that has already been averaged.
+void
+cencalvm::average::AvgEngine::copyOctant(etree_addr_t* pAddr,
+					const storage::PayloadStruct& payload)
+{ // copyOctant
+  assert(0 != pAddr);
+  assert(_pendingCursor < pAddr->level);
+
+  _pushBuffer(pAddr, payload, true);
+  _flushBuffer();
+  ++_octantCounter.input;
+  ++_octantCounter.output;
+  if (0 != _pTelemetry)
+    _pTelemetry->addOctants();
+} // copyOctant
+
+// ----------------------------------------------------------------------
+// Finish averaging and appending octants.
+void
+cencalvm::average::AvgEngine::endFill(void)
+{ // endFill
+  assert(0 != _dbAvg);
+
   _finishProcessing();
+  _flushBuffer();
+  assert(0 == _bufferCount);
 
-  err = etree_endappend(_dbAvg);
+  int err = etree_endappend(_dbAvg);
   if (0 != err)
     throw std::runtime_error("Error occurred while trying to terminate appending "
 			     "of etree.");
-} // fillOctants
+} // endFill
+
+// ----------------------------------------------------------------------
+// Append all octants in the write-behind buffer and stop appending.
+void
+cencalvm::average::AvgEngine::suspendFill(void)
+{ // suspendFill
+  assert(0 != _dbAvg);
+
+  while (_bufferCount > 0)
+    _flushBuffer(true);
+
+  int err = etree_endappend(_dbAvg);
+  if (0 != err)
+    throw std::runtime_error("Error occurred while trying to terminate appending "
+			     "of etree.");
+} // suspendFill
+
+// ----------------------------------------------------------------------
+// Resume appending octants after suspendFill() or loadState().
+void
+cencalvm::average::AvgEngine::resumeFill(etree_t* dbOut)
+{ // resumeFill
+  assert(0 != dbOut);
+  assert(0 == _bufferCount);
+
+  _dbAvg = dbOut;
+
+  etree_addr_t addr;
+  if (_numAppended > 0)
+    addr = *_pLastAppended;
+  else {
+    addr.x = 0;
+    addr.y = 0;
+    addr.z = 0;
+    addr.t = 0;
+    addr.level = ETREE_MAXLEVEL;
+  } // if/else
+
+  // The database must end at the last octant appended before the
+  // state was saved.
+  storage::PayloadStruct payload;
+  bool more = (0 == etree_initcursor(_dbAvg, addr));
+  if (_numAppended > 0) {
+    if (more && 0 != etree_getcursor(_dbAvg, &addr, "*", &payload))
+      throw std::runtime_error(etree_strerror(etree_errno(_dbAvg)));
+    if (!more || !_sameAddr(&addr, _pLastAppended))
+      throw std::runtime_error("Averaged database does not contain the last "
+			       "octant appended before averaging was "
+			       "suspended.");
+    more = (0 == etree_advcursor(_dbAvg));
+  } // if
+  if (more)
+    throw std::runtime_error("Averaged database contains octants appended "
+			     "after averaging was suspended.");
+
+  beginFill();
+} // resumeFill
+
+// ----------------------------------------------------------------------
+// Save state of averaging after suspendFill().
+void
+cencalvm::average::AvgEngine::saveState(FILE* fp) const
+{ // saveState
+  assert(0 != fp);
+  assert(0 == _bufferCount);
+
+  bool isOkay = 
+    1 == fwrite(&_octantCounter, sizeof(_octantCounter), 1, fp) &&
+    1 == fwrite(&_numAppended, sizeof(_numAppended), 1, fp) &&
+    1 == fwrite(_pLastAppended, sizeof(etree_addr_t), 1, fp) &&
+    1 == fwrite(&_pendingCursor, sizeof(_pendingCursor), 1, fp);
+  for (int level=0; isOkay && level <= _pendingCursor; ++level) {
+    const OctantPendingStruct& pending = _pPendingOctants[level];
+    assert(-1 == pending.bufferSlot);
+    isOkay = 
+      1 == fwrite(pending.pAddr, sizeof(etree_addr_t), 1, fp) &&
+      1 == fwrite(&pending.processedChildren,
+		  sizeof(pending.processedChildren), 1, fp) &&
+      1 == fwrite(&pending.isValid, sizeof(pending.isValid), 1, fp) &&
+      1 == fwrite(&pending.data.numChildren,
+		  sizeof(pending.data.numChildren), 1, fp) &&
+      1 == fwrite(pending.data.pSum, sizeof(storage::PayloadStruct), 1, fp);
+  } // for
+  if (!isOkay)
+    throw std::runtime_error("Could not write state of averaging.");
+} // saveState
+
+// ----------------------------------------------------------------------
+// Load state of averaging saved with saveState().
+void
+cencalvm::average::AvgEngine::loadState(FILE* fp)
+{ // loadState
+  assert(0 != fp);
+  assert(0 == _bufferCount);
+
+  int pendingCursor = -1;
+  bool isOkay = 
+    1 == fread(&_octantCounter, sizeof(_octantCounter), 1, fp) &&
+    1 == fread(&_numAppended, sizeof(_numAppended), 1, fp) &&
+    1 == fread(_pLastAppended, sizeof(etree_addr_t), 1, fp) &&
+    1 == fread(&pendingCursor, sizeof(pendingCursor), 1, fp) &&
+    pendingCursor >= -1 && pendingCursor < _pendingSize;
+  for (int level=0; level < _pendingSize; ++level) {
+    OctantPendingStruct& pending = _pPendingOctants[level];
+    pending.bufferSlot = -1;
+    pending.isValid = false;
+    if (isOkay && level <= pendingCursor)
+      isOkay = 
+	1 == fread(pending.pAddr, sizeof(etree_addr_t), 1, fp) &&
+	1 == fread(&pending.processedChildren,
+		   sizeof(pending.processedChildren), 1, fp) &&
+	1 == fread(&pending.isValid, sizeof(pending.isValid), 1, fp) &&
+	1 == fread(&pending.data.numChildren,
+		   sizeof(pending.data.numChildren), 1, fp) &&
+	1 == fread(pending.data.pSum, sizeof(storage::PayloadStruct), 1, fp) &&
+	pending.pAddr->level == level;
+  } // for
+  if (!isOkay) {
+    for (int level=0; level < _pendingSize; ++level)
+      _pPendingOctants[level].isValid = false;
+    _pendingCursor = -1;
+    _numAppended = 0;
+    throw std::runtime_error("Could not read state of averaging.");
+  } // if
+  _pendingCursor = pendingCursor;
+} // loadState
+
+// ----------------------------------------------------------------------
+// Recompute interior octants affected by changes to octants of the
+// averaged database.
+size_t
+cencalvm::average::AvgEngine::updateOctants(const DirtyList& dirty)
+{ // updateOctants
+  assert(0 != _dbAvg);
+
+  typedef bool (*precedes_fn)(const etree_addr_t&, const etree_addr_t&);
+  typedef std::set<etree_addr_t, precedes_fn> addr_set;
+  std::vector<addr_set> dirtyLevels(_pendingSize,
+				    addr_set(storage::Geometry::precedes));
+
+  const size_t numDirty = dirty.size();
+  for (size_t iDirty=0; iDirty < numDirty; ++iDirty) {
+    etree_addr_t addrDirty;
+    dirty.octant(&addrDirty, iDirty);
+
+    // Interior octants within the subtree of the dirty octant are
+    // contiguous in the database, starting at the dirty octant.
+    const etree_tick_t tickLen = _LEFTMOSTONE >> addrDirty.level;
+    etree_addr_t addr = addrDirty;
+    storage::PayloadStruct payload;
+    bool more = (0 == etree_initcursor(_dbAvg, addr));
+    while (more) {
+      if (0 != etree_getcursor(_dbAvg, &addr, "*", &payload))
+	throw std::runtime_error(etree_strerror(etree_errno(_dbAvg)));
+      if (addr.level < addrDirty.level ||
+	  addr.x - addrDirty.x >= tickLen ||
+	  addr.y - addrDirty.y >= tickLen ||
+	  addr.z - addrDirty.z >= tickLen)
+	break;
+      if (ETREE_INTERIOR == addr.type)
+	dirtyLevels[addr.level].insert(addr);
+      more = (0 == etree_advcursor(_dbAvg));
+    } // while
+
+    // Ancestors of an octant already in the set were added with it.
+    for (int level=addrDirty.level-1; level >= 0; --level) {
+      storage::Geometry::findAncestor(&addr, addrDirty, level);
+      addr.type = ETREE_INTERIOR;
+      if (!dirtyLevels[level].insert(addr).second)
+	break;
+    } // for
+  } // for
+
+  // Recompute deepest levels first so children are final before
+  // their parents are averaged. Children are added in etree order,
+  // like in fillOctants(), so the sums are identical.
+  storage::PayloadStruct sum;
+  OctantPendingStruct pending;
+  pending.data.pSum = &sum;
+  size_t numUpdated = 0;
+  pending.bufferSlot = -1;
+  for (int level=_pendingSize-2; level >= 0; --level) {
+    const etree_tick_t tickLenChild = _LEFTMOSTONE >> (level+1);
+    const addr_set::const_iterator end = dirtyLevels[level].end();
+    for (addr_set::const_iterator iter=dirtyLevels[level].begin();
+	 iter != end;
+	 ++iter) {
+      etree_addr_t addr = *iter;
+      storage::PayloadStruct payload;
+      if (!_getOctant(&addr, &payload) || ETREE_INTERIOR != addr.type)
+	continue;
+
+      pending.pAddr = &addr;
+      pending.processedChildren = 0x00;
+      pending.isValid = true;
+      _clearSum(&pending.data);
+      for (int iChild=0; iChild < 8; ++iChild) {
+	etree_addr_t addrChild;
+	addrChild.x = addr.x + tickLenChild * (iChild & 1);
+	addrChild.y = addr.y + tickLenChild * ((iChild >> 1) & 1);
+	addrChild.z = addr.z + tickLenChild * ((iChild >> 2) & 1);
+	addrChild.t = 0;
+	addrChild.level = level + 1;
+	storage::PayloadStruct payloadChild;
+	if (_getOctant(&addrChild, &payloadChild))
+	  _addToParent(&pending, &addrChild, payloadChild);
+      } // for
+      _averageSum(&payload, pending.data);
+      _updateOctant(&addr, payload);
+      ++numUpdated;
+    } // for
+    dirtyLevels[level+1].clear();
+  } // for
+
+  return numUpdated;
+} // updateOctants
 
 // ----------------------------------------------------------------------
 // Print octant counting information to stream.
@@ -133,6 +445,7 @@ cencalvm::average::AvgEngine::printOctantInfo(void) const
     << "  IN: " << _octantCounter.input << "\n"
     << "  OUT total: " << _octantCounter.output
     << ", interior: " << _octantCounter.interior << "\n"
+    << "  interior updated after append: " << _octantCounter.updated << "\n"
     << "Incomplete octants\n"
     << "  x: " << _octantCounter.inc_x << "\n"
     << "  y: " << _octantCounter.inc_y << "\n"
@@ -145,6 +458,15 @@ cencalvm::average::AvgEngine::printOctantInfo(void) const
     << std::endl;
 } // printOctantInfo
 
+// ----------------------------------------------------------------------
+// Set telemetry for reporting octants averaged and bytes read and
+// written.
+void
+cencalvm::average::AvgEngine::telemetry(storage::Telemetry* pTelemetry)
+{ // telemetry
+  _pTelemetry = pTelemetry;
+} // telemetry
+
 // ----------------------------------------------------------------------
 // Do average processing on octant.
 void
@@ -155,19 +477,28 @@ cencalvm::average::AvgEngine::_averageOctant(etree_addr_t* pAddr,
   assert(0 != _dbAvg);
   assert(0 != _pPendingOctants);
 
-  // if at root, we are done
-  if (pAddr->level <= 0)
+  if (0 != _pTelemetry)
+    _pTelemetry->addOctants();
+
+  // Octant at root has no ancestors to average, so just append it.
+  if (pAddr->level <= 0) {
+    assert(-1 == _pendingCursor);
+    _pushBuffer(pAddr, payload, true);
+    _flushBuffer();
+    ++_octantCounter.input;
+    ++_octantCounter.output;
     return;
+  } // if
 
   int pendingLevel = _findParent(pAddr);
   assert(pendingLevel == pAddr->level-1);
   assert(pendingLevel >= 0 && pendingLevel == pAddr->level-1);
   assert(pendingLevel <=_pendingCursor);
 
-  int err = etree_append(_dbAvg, *pAddr, &payload);
-  if (0 != err)
-    throw std::runtime_error("Error occurred while trying to append octant "
-			     "to etree.");
+  // Leaf octants are final, but they must wait behind any pending
+  // ancestors in the buffer to preserve the Morton pre-order.
+  _pushBuffer(pAddr, payload, true);
+  _flushBuffer();
   ++_octantCounter.input;
   ++_octantCounter.output;
 
@@ -256,6 +587,80 @@ cencalvm::average::AvgEngine::_addToParent(OctantPendingStruct* pPendingParent,
   } // else
 } // _addToParent
 		    
+// ----------------------------------------------------------------------
+// Set sums of pending octant to values of octant without any children.
+void
+cencalvm::average::AvgEngine::_clearSum(PendingDataStruct* pData)
+{ // _clearSum
+  assert(0 != pData);
+  assert(0 != pData->pSum);
+
+  pData->numChildren = 0;
+  pData->pSum->Vp = 0;
+  pData->pSum->Vs = 0;
+  pData->pSum->Density = 0;
+  pData->pSum->Qp = 0;
+  pData->pSum->Qs = 0;
+  pData->pSum->DepthFreeSurf = 0;
+  pData->pSum->FaultBlock = storage::Payload::INTERIORBLOCK;
+  pData->pSum->Zone = storage::Payload::INTERIORZONE;
+} // _clearSum
+
+// ----------------------------------------------------------------------
+// Compute average of children of pending octant.
+void
+cencalvm::average::AvgEngine::_averageSum(storage::PayloadStruct* pPayload,
+					  const PendingDataStruct& data)
+{ // _averageSum
+  assert(0 != pPayload);
+  assert(0 != data.pSum);
+
+  const int numChildren = data.numChildren;
+  if (numChildren > 0) {
+    pPayload->Vp = data.pSum->Vp / numChildren;
+    pPayload->Vs = data.pSum->Vs / numChildren;
+    pPayload->Density = data.pSum->Density / numChildren;
+    pPayload->Qp = data.pSum->Qp / numChildren;
+    pPayload->Qs = data.pSum->Qs / numChildren;
+    pPayload->DepthFreeSurf = data.pSum->DepthFreeSurf / numChildren;
+  } else {
+    // If there are no contributing children, then set payload
+    // values to 'NODATA' values
+
+    pPayload->Vp = storage::Payload::NODATAVAL;
+    pPayload->Vs = storage::Payload::NODATAVAL;
+    pPayload->Density = storage::Payload::NODATAVAL;
+    pPayload->Qp = storage::Payload::NODATAVAL;
+    pPayload->Qs = storage::Payload::NODATAVAL;
+    pPayload->DepthFreeSurf = storage::Payload::NODATAVAL;
+  } // if/else
+  pPayload->FaultBlock = storage::Payload::INTERIORBLOCK;
+  pPayload->Zone = storage::Payload::INTERIORZONE;
+} // _averageSum
+
+// ----------------------------------------------------------------------
+// Get octant in averaged database.
+bool
+cencalvm::average::AvgEngine::_getOctant(etree_addr_t* pAddr,
+					 storage::PayloadStruct* pPayload)
+{ // _getOctant
+  assert(0 != pAddr);
+  assert(0 != pPayload);
+  assert(0 != _dbAvg);
+
+  // Cursor starts at the octant or the first octant after it.
+  if (0 != etree_initcursor(_dbAvg, *pAddr))
+    return false;
+  etree_addr_t addr;
+  if (0 != etree_getcursor(_dbAvg, &addr, "*", pPayload))
+    throw std::runtime_error(etree_strerror(etree_errno(_dbAvg)));
+  if (addr.x != pAddr->x || addr.y != pAddr->y || addr.z != pAddr->z ||
+      addr.level != pAddr->level)
+    return false;
+  pAddr->type = addr.type;
+  return true;
+} // _getOctant
+
 // ----------------------------------------------------------------------
 // Update pending octant.
 void 
@@ -268,6 +673,8 @@ cencalvm::average::AvgEngine::_updateOctant(etree_addr_t* pAddr,
   int err = etree_update(_dbAvg, *pAddr, &childPayload);
   if (0 != err)
     throw std::runtime_error("Could not update octant in etree database.");
+  if (0 != _pTelemetry)
+    _pTelemetry->addBytesWritten(sizeof(childPayload));
 } // _updateOctant
 
 // ----------------------------------------------------------------------
@@ -328,30 +735,20 @@ cencalvm::average::AvgEngine::_processOctant(const int pendingLevel)
     } // switch
 
   storage::PayloadStruct payload;
-  const int numChildren = pendingOctant.data.numChildren;
-  if (numChildren > 0) {
-    payload.Vp = pendingOctant.data.pSum->Vp / numChildren;
-    payload.Vs = pendingOctant.data.pSum->Vs / numChildren;
-    payload.Density = pendingOctant.data.pSum->Density / numChildren;
-    payload.Qp = pendingOctant.data.pSum->Qp / numChildren;
-    payload.Qs = pendingOctant.data.pSum->Qs / numChildren;
-    payload.DepthFreeSurf = 
-      pendingOctant.data.pSum->DepthFreeSurf / numChildren;
+  _averageSum(&payload, pendingOctant.data);
+
+  if (pendingOctant.bufferSlot >= 0) {
+    // Octant is still in the buffer, so store final values there.
+    OctantBufferedStruct& buffered = _pBuffer[pendingOctant.bufferSlot];
+    assert(_sameAddr(buffered.pAddr, pendingOctant.pAddr));
+    *buffered.pPayload = payload;
+    buffered.isFinal = true;
+    pendingOctant.bufferSlot = -1;
   } else {
-    // If there are no contributing children, then set payload
-    // values to 'NODATA' values
-
-    payload.Vp = storage::Payload::NODATAVAL;
-    payload.Vs = storage::Payload::NODATAVAL;
-    payload.Density = storage::Payload::NODATAVAL;
-    payload.Qp = storage::Payload::NODATAVAL;
-    payload.Qs = storage::Payload::NODATAVAL;
-    payload.DepthFreeSurf = storage::Payload::NODATAVAL;
+    // Placeholder was already appended, so we must update it.
+    _updateOctant(pendingOctant.pAddr, payload);
+    ++_octantCounter.updated;
   } // if/else
-  payload.FaultBlock = storage::Payload::INTERIORBLOCK;
-  payload.Zone = storage::Payload::INTERIORZONE;
-
-  _updateOctant(pendingOctant.pAddr, payload);
   if (pendingLevel > 0) {
     assert(_pPendingOctants[pendingLevel-1].pAddr->level == 
 	   pendingOctant.pAddr->level-1);
@@ -363,6 +760,8 @@ cencalvm::average::AvgEngine::_processOctant(const int pendingLevel)
   pendingOctant.isValid = false;
   assert(pendingLevel ==_pendingCursor);
   _pendingCursor = pendingLevel - 1;
+
+  _flushBuffer();
 } // _processOctant
 
 // ----------------------------------------------------------------------
@@ -445,6 +844,7 @@ cencalvm::average::AvgEngine::_finishProcessing(void)
   
 // ----------------------------------------------------------------------
 // Create a new octant in the average database and append it to the
+// array of pending octants.
 void
 cencalvm::average::AvgEngine::_createOctant(etree_addr_t* pAddr)
 { // _createOctant
@@ -456,31 +856,89 @@ cencalvm::average::AvgEngine::_createOctant(etree_addr_t* pAddr)
   assert(!_pPendingOctants[pendingLevel].isValid);
   assert(pendingLevel == _pendingCursor+1);  
 
+  // Reserve the octant's position in the output; its values are
+  // filled in when all of its children have been processed.
   storage::PayloadStruct payload;
-  int err = etree_append(_dbAvg, *pAddr, &payload);
-  if (0 != err)
-    throw std::runtime_error("Error occurred while appending new octant to etree.");
+  payload.Vp = 0;
+  payload.Vs = 0;
+  payload.Density = 0;
+  payload.Qp = 0;
+  payload.Qs = 0;
+  payload.DepthFreeSurf = 0;
+  payload.FaultBlock = storage::Payload::INTERIORBLOCK;
+  payload.Zone = storage::Payload::INTERIORZONE;
+  _pPendingOctants[pendingLevel].bufferSlot = 
+    _pushBuffer(pAddr, payload, false);
 
   *_pPendingOctants[pendingLevel].pAddr = *pAddr;
   _pPendingOctants[pendingLevel].processedChildren = 0x00;
   _pPendingOctants[pendingLevel].isValid = true;
-  _pPendingOctants[pendingLevel].data.numChildren = 0;
-  _pPendingOctants[pendingLevel].data.pSum->Vp = 0;
-  _pPendingOctants[pendingLevel].data.pSum->Vs = 0;
-  _pPendingOctants[pendingLevel].data.pSum->Density = 0;
-  _pPendingOctants[pendingLevel].data.pSum->Qp = 0;
-  _pPendingOctants[pendingLevel].data.pSum->Qs = 0;
-  _pPendingOctants[pendingLevel].data.pSum->DepthFreeSurf = 0;
-  _pPendingOctants[pendingLevel].data.pSum->FaultBlock = 
-    storage::Payload::INTERIORBLOCK;
-  _pPendingOctants[pendingLevel].data.pSum->Zone = 
-    storage::Payload::INTERIORZONE;
+  _clearSum(&_pPendingOctants[pendingLevel].data);
   _pendingCursor = pendingLevel;
 
   ++_octantCounter.output;
   ++_octantCounter.interior;
 } // _createOctant
 
+// ----------------------------------------------------------------------
+// Add octant to the end of the write-behind buffer.
+int
+cencalvm::average::AvgEngine::_pushBuffer(etree_addr_t* pAddr,
+					  const storage::PayloadStruct& payload,
+					  const bool isFinal)
+{ // _pushBuffer
+  assert(0 != pAddr);
+  assert(0 != _pBuffer);
+
+  // Make room by appending the oldest octant. If it is a pending
+  // interior octant, it will be updated when it is processed.
+  while (_bufferCount >= _bufferSize)
+    _flushBuffer(true);
+
+  const int slot = (_bufferHead + _bufferCount) % _bufferSize;
+  *_pBuffer[slot].pAddr = *pAddr;
+  *_pBuffer[slot].pPayload = payload;
+  _pBuffer[slot].isFinal = isFinal;
+  ++_bufferCount;
+
+  return slot;
+} // _pushBuffer
+
+// ----------------------------------------------------------------------
+// Append octants at the front of the write-behind buffer to the
+// database.
+void
+cencalvm::average::AvgEngine::_flushBuffer(const bool force)
+{ // _flushBuffer
+  assert(0 != _pBuffer);
+  assert(0 != _dbAvg);
+
+  bool forceNext = force;
+  while (_bufferCount > 0 && (_pBuffer[_bufferHead].isFinal || forceNext)) {
+    OctantBufferedStruct& buffered = _pBuffer[_bufferHead];
+    if (!buffered.isFinal) {
+      // Only pending interior octants are not final; the octant's
+      // level is its index in the array of pending octants.
+      const int pendingLevel = buffered.pAddr->level;
+      assert(0 <= pendingLevel && pendingLevel < _pendingSize);
+      assert(_pPendingOctants[pendingLevel].bufferSlot == _bufferHead);
+      _pPendingOctants[pendingLevel].bufferSlot = -1;
+    } // if
+    forceNext = false;
+
+    if (0 != etree_append(_dbAvg, *buffered.pAddr, buffered.pPayload))
+      throw std::runtime_error("Error occurred while trying to append octant "
+			       "to etree.");
+    *_pLastAppended = *buffered.pAddr;
+    ++_numAppended;
+    if (0 != _pTelemetry)
+      _pTelemetry->addBytesWritten(sizeof(*buffered.pPayload));
+    
+    _bufferHead = (_bufferHead + 1) % _bufferSize;
+    --_bufferCount;
+  } // while
+} // _flushBuffer
+
 // ----------------------------------------------------------------------
 // Get bit associated with child's location relative to parent.
 unsigned char
@@ -14,11 +14,19 @@
  *
  * @brief C++ engine for doing averaging over an etree database.
  *
+ * The averaged database is written using only sequential appends.
+ * Interior octants are held in a bounded write-behind buffer until
+ * the averages of their children are known, so that they can be
+ * appended in their final form in Morton pre-order. Only interior
+ * octants with subtrees too large to fit in the buffer are appended
+ * as placeholders and updated later.
+ *
  * This C++ code is based on the C convertdb application written by
  * Julio Lopez (Carnegie Mellon University).
  */
 
 #include <sys/types.h> // USES size_t
+#include <stdio.h> // USES FILE
 #include <iosfwd> // USES std::ostream
 
 #if !defined(cencalvm_average_avgengine_h)
@@ -29,9 +37,11 @@
 namespace cencalvm {
   namespace average {
     class AvgEngine;
+    class DirtyList; // USES DirtyList
   } // namespace average
   namespace storage {
     struct PayloadStruct; // USES PayloadStruct
+    class Telemetry; // HOLDSA Telemetry
   } // namespace storage
 } // namespace cencalvm
 
@@ -45,10 +55,12 @@ public :
   /** Constructor
    *
    * @param dbOut Output database
-   * @param dbIn Input database
+   * @param dbIn Input database (0 if octants are added with addOctant())
+   * @param bufferSize Maximum number of octants in write-behind buffer
    */
   AvgEngine(etree_t* dbOut,
-	    etree_t* dbIn);
+	    etree_t* dbIn,
+	    const int bufferSize =DEFAULTBUFFERSIZE);
 
   /// Destructor
   ~AvgEngine(void);
@@ -56,9 +68,107 @@ public :
   /// Fill in octants with averages of their children
   void fillOctants(void);
 
+  /** Prepare to add octants to the averaged database.
+   *
+   * Octants may then be added with addOctant() and copyOctant() in
+   * Morton pre-order instead of being read from the input database.
+   */
+  void beginFill(void);
+
+  /** Add octant whose values are final and include its contribution
+   * in the averages of its ancestors.
+   *
+   * The octant is either a leaf octant or the root of a subtree that
+   * has already been averaged.
+   *
+   * @param pAddr Pointer to address of octant
+   * @param payload Payload of octant
+   */
+  void addOctant(etree_addr_t* pAddr,
+		 const storage::PayloadStruct& payload);
+
+  /** Append descendant of a subtree that has already been averaged.
+   *
+   * The octant does not contribute to the averages of any pending
+   * ancestors, so it must follow the root of its subtree (added with
+   * addOctant()) or another descendant of that root.
+   *
+   * @param pAddr Pointer to address of octant
+   * @param payload Payload of octant
+   */
+  void copyOctant(etree_addr_t* pAddr,
+		  const storage::PayloadStruct& payload);
+
+  /// Finish averaging and appending octants.
+  void endFill(void);
+
+  /** Append all octants in the write-behind buffer and stop
+   * appending, so that the averaged database can be closed and
+   * reopened at a checkpoint.
+   *
+   * Pending interior octants are appended as placeholders and
+   * updated when all of their children have been processed, so the
+   * averaged database is identical to one filled without
+   * interruption.
+   */
+  void suspendFill(void);
+
+  /** Resume appending octants after suspendFill() or loadState().
+   *
+   * The averaged database must be the database when the state was
+   * saved; after a crash it is restored from the snapshot taken at
+   * the checkpoint (see storage::DBSnapshot).
+   *
+   * @param dbOut Output database (reopened)
+   */
+  void resumeFill(etree_t* dbOut);
+
+  /** Save state of averaging (pending octants and counters) after
+   * suspendFill().
+   *
+   * @param fp File to write state to
+   */
+  void saveState(FILE* fp) const;
+
+  /** Load state of averaging saved with saveState().
+   *
+   * @param fp File to read state from
+   */
+  void loadState(FILE* fp);
+
+  /** Recompute interior octants affected by changes to octants of
+   * the averaged database, updating them in place.
+   *
+   * The interior octants in the subtrees of the dirty octants and
+   * their ancestors are recomputed level by level, starting at the
+   * deepest level, from the current payloads of their children. The
+   * structure of the database must not have changed since it was
+   * averaged; only payloads of existing octants may change. The
+   * result is identical to averaging the whole database with
+   * fillOctants().
+   *
+   * @param dirty List of octants whose payloads changed
+   *
+   * @returns Number of interior octants recomputed
+   */
+  size_t updateOctants(const DirtyList& dirty);
+
   /// Print octant counting information to stream.
   void printOctantInfo(void) const;
 
+  /** Set telemetry for reporting octants averaged and bytes read and
+   * written.
+   *
+   * @param pTelemetry Pointer to telemetry (0 for none)
+   */
+  void telemetry(storage::Telemetry* pTelemetry);
+
+public :
+  // PUBLIC MEMBERS /////////////////////////////////////////////////////
+
+  /// Default number of octants in write-behind buffer.
+  static const int DEFAULTBUFFERSIZE;
+
 private :
   // PRIVATE METHODS ////////////////////////////////////////////////////
 
@@ -81,14 +191,23 @@ private :
   struct OctantPendingStruct {
     PendingDataStruct data;
     etree_addr_t* pAddr;
+    int bufferSlot; ///< Slot in write-behind buffer (-1 if appended)
     unsigned char processedChildren;
     bool isValid;
   }; // OctantPendingStruct
 
+  /// Octant in write-behind buffer waiting to be appended.
+  struct OctantBufferedStruct {
+    etree_addr_t* pAddr;
+    cencalvm::storage::PayloadStruct* pPayload;
+    bool isFinal; ///< True if payload holds final values
+  }; // OctantBufferedStruct
+
   struct CounterStruct {
     uint64_t input;
     uint64_t output;
     uint64_t interior;
+    uint64_t updated;
     uint64_t inc_x;
     uint64_t inc_y;
     uint64_t inc_z;
@@ -120,6 +239,31 @@ private :
 		    etree_addr_t* pAddrChild,
 		    const storage::PayloadStruct& childPayload);
 
+  /** Set sums of pending octant to values of octant without any
+   * children.
+   *
+   * @param pData Pointer to pending octant data
+   */
+  static void _clearSum(PendingDataStruct* pData);
+
+  /** Compute average of children of pending octant.
+   *
+   * @param pPayload Pointer to payload of octant
+   * @param data Pending octant data
+   */
+  static void _averageSum(storage::PayloadStruct* pPayload,
+			  const PendingDataStruct& data);
+
+  /** Get octant in averaged database.
+   *
+   * @param pAddr Pointer to address of octant (type is set on return)
+   * @param pPayload Pointer to payload of octant
+   *
+   * @returns True if octant is in database, false otherwise
+   */
+  bool _getOctant(etree_addr_t* pAddr,
+		  storage::PayloadStruct* pPayload);
+
   /** Update pending octant.
    *
    * @param pAddr Pointer to octant address
@@ -152,6 +296,28 @@ private :
    */
   void _createOctant(etree_addr_t* pAddr);
 
+  /** Add octant to the end of the write-behind buffer.
+   *
+   * If the buffer is full, the octant at the front of the buffer is
+   * appended to the database even if it is not final.
+   *
+   * @param pAddr Pointer to address of octant
+   * @param payload Payload of octant
+   * @param isFinal True if payload holds final values
+   *
+   * @returns Slot in buffer holding octant
+   */
+  int _pushBuffer(etree_addr_t* pAddr,
+		  const storage::PayloadStruct& payload,
+		  const bool isFinal);
+
+  /** Append octants at the front of the write-behind buffer to the
+   * database.
+   *
+   * @param force Append the first octant even if it is not final
+   */
+  void _flushBuffer(const bool force =false);
+
   /** Get bit associated with child's location relative to parent.
    *
    * @param pAddr Pointer to address of child.
@@ -186,7 +352,15 @@ private :
   int _pendingSize; ///< Number of pending octants
   int _pendingCursor;
 
+  OctantBufferedStruct* _pBuffer; ///< Circular write-behind buffer
+  int _bufferSize; ///< Capacity of write-behind buffer
+  int _bufferHead; ///< Slot of first octant in write-behind buffer
+  int _bufferCount; ///< Number of octants in write-behind buffer
+
   CounterStruct _octantCounter;
+  etree_addr_t* _pLastAppended; ///< Address of last octant appended
+  uint64_t _numAppended; ///< Number of octants appended
+  storage::Telemetry* _pTelemetry; ///< Pointer to telemetry
 
   static const etree_tick_t _LEFTMOSTONE; ///< first bit is 1, others 0
 
@@ -0,0 +1,139 @@
+// -*- C++ -*-
+//
+// ======================================================================
+//
+//                           Brad T. Aagaard
+//                        U.S. Geological Survey
+//
+// {LicenseText}
+//
+// ======================================================================
+//
+
+#include "DirtyList.h" // implementation of class methods
+
+extern "C" {
+#include "etree.h"
+}
+
+#include <fstream> // USES std::ifstream, std::ofstream
+
+#include <stdexcept> // USES std::runtime_error
+#include <sstream> // USES std::ostringstream
+#include <assert.h> // USES assert()
+
+// ----------------------------------------------------------------------
+// Constructor
+cencalvm::average::DirtyList::DirtyList(void)
+{ // constructor
+} // constructor
+
+// ----------------------------------------------------------------------
+// Destructor
+cencalvm::average::DirtyList::~DirtyList(void)
+{ // destructor
+} // destructor
+
+// ----------------------------------------------------------------------
+// Get name of dirty list file of database.
+std::string
+cencalvm::average::DirtyList::filename(const char* filenameDB)
+{ // filename
+  assert(0 != filenameDB);
+  return std::string(filenameDB) + ".dirty";
+} // filename
+
+// ----------------------------------------------------------------------
+// Read list from file.
+void
+cencalvm::average::DirtyList::read(const char* filename)
+{ // read
+  assert(0 != filename);
+
+  _octants.clear();
+
+  std::ifstream fin(filename);
+  if (!fin.is_open()) {
+    std::ostringstream msg;
+    msg << "Could not open dirty list '" << filename << "' for reading.";
+    throw std::runtime_error(msg.str());
+  } // if
+
+  OctantStruct octant;
+  while (fin >> octant.x >> octant.y >> octant.z >> octant.level) {
+    if (octant.level < 0 || octant.level > ETREE_MAXLEVEL) {
+      std::ostringstream msg;
+      msg << "Level " << octant.level << " of octant " << _octants.size()
+	  << " in dirty list '" << filename << "' is out of range.";
+      _octants.clear();
+      throw std::runtime_error(msg.str());
+    } // if
+    _octants.push_back(octant);
+  } // while
+  if (!fin.eof()) {
+    std::ostringstream msg;
+    msg << "Could not parse octant " << _octants.size() << " in dirty list '"
+	<< filename << "'.";
+    _octants.clear();
+    throw std::runtime_error(msg.str());
+  } // if
+} // read
+
+// ----------------------------------------------------------------------
+// Write list to file.
+void
+cencalvm::average::DirtyList::write(const char* filename) const
+{ // write
+  assert(0 != filename);
+
+  std::ofstream fout(filename);
+  if (!fout.is_open()) {
+    std::ostringstream msg;
+    msg << "Could not open dirty list '" << filename << "' for writing.";
+    throw std::runtime_error(msg.str());
+  } // if
+
+  const size_t size = _octants.size();
+  for (size_t i=0; i < size; ++i)
+    fout
+      << _octants[i].x << " " << _octants[i].y << " " << _octants[i].z
+      << " " << _octants[i].level << "\n";
+  fout.close();
+  if (!fout.good()) {
+    std::ostringstream msg;
+    msg << "Could not write dirty list '" << filename << "'.";
+    throw std::runtime_error(msg.str());
+  } // if
+} // write
+
+// ----------------------------------------------------------------------
+// Add octant to list.
+void
+cencalvm::average::DirtyList::add(const etree_addr_t& addr)
+{ // add
+  OctantStruct octant;
+  octant.x = addr.x;
+  octant.y = addr.y;
+  octant.z = addr.z;
+  octant.level = addr.level;
+  _octants.push_back(octant);
+} // add
+
+// ----------------------------------------------------------------------
+// Get octant in list.
+void
+cencalvm::average::DirtyList::octant(etree_addr_t* pAddr,
+				     const size_t index) const
+{ // octant
+  assert(0 != pAddr);
+  assert(index < _octants.size());
+
+  pAddr->x = _octants[index].x;
+  pAddr->y = _octants[index].y;
+  pAddr->z = _octants[index].z;
+  pAddr->t = 0;
+  pAddr->level = _octants[index].level;
+  pAddr->type = ETREE_LEAF;
+} // octant
+
+// End of file 
@@ -0,0 +1,132 @@
+// -*- C++ -*-
+//
+// ======================================================================
+//
+//                           Brad T. Aagaard
+//                        U.S. Geological Survey
+//
+// {LicenseText}
+//
+// ======================================================================
+//
+
+/** @file libsrc/average/DirtyList.h
+ *
+ * @brief C++ manager of lists of octants whose payloads were changed
+ * in a spatially averaged etree database.
+ *
+ * Tools that edit leaf octants of an averaged database in place
+ * record the edited octants in a dirty list, so that only the
+ * interior octants affected by the edits are recomputed (see
+ * Averager::update()). An octant in the list marks its whole subtree
+ * as dirty, so a range of edited leaves can be recorded by their
+ * common ancestor.
+ *
+ * The list is stored in a text file next to the database (see
+ * filename()) with one octant per line given by the x, y, and z
+ * ticks of its corner and its level.
+ */
+
+#if !defined(cencalvm_average_dirtylist_h)
+#define cencalvm_average_dirtylist_h
+
+#include "cencalvm/storage/etreefwd.h" // USES etree_addr_t, etree_tick_t
+
+#include <string> // USES std::string
+#include <vector> // HASA std::vector
+#include <sys/types.h> // USES size_t
+
+namespace cencalvm {
+  namespace average {
+    class DirtyList;
+    class TestDirtyList; // friend
+  } // namespace average
+} // namespace cencalvm
+
+/// C++ manager of lists of octants whose payloads were changed in a
+/// spatially averaged etree database.
+class cencalvm::average::DirtyList
+{ // DirtyList
+  friend class TestDirtyList; // unit testing
+
+public :
+  // PUBLIC METHODS /////////////////////////////////////////////////////
+
+  /// Constructor
+  DirtyList(void);
+
+  /// Destructor
+  ~DirtyList(void);
+
+  /** Get name of dirty list file of database.
+   *
+   * @param filenameDB Name of etree database
+   *
+   * @returns Name of dirty list file
+   */
+  static std::string filename(const char* filenameDB);
+
+  /** Read list from file.
+   *
+   * @param filename Name of file
+   */
+  void read(const char* filename);
+
+  /** Write list to file.
+   *
+   * @param filename Name of file
+   */
+  void write(const char* filename) const;
+
+  /** Add octant to list.
+   *
+   * @param addr Address of octant
+   */
+  void add(const etree_addr_t& addr);
+
+  /// Remove all octants from list.
+  void clear(void);
+
+  /** Get number of octants in list.
+   *
+   * @returns Number of octants
+   */
+  size_t size(void) const;
+
+  /** Get octant in list.
+   *
+   * @param pAddr Pointer to address of octant
+   * @param index Index of octant in list
+   */
+  void octant(etree_addr_t* pAddr,
+	      const size_t index) const;
+
+private :
+  // PRIVATE STRUCTS ////////////////////////////////////////////////////
+
+  /// Octant in list.
+  struct OctantStruct {
+    etree_tick_t x; ///< x tick of corner of octant
+    etree_tick_t y; ///< y tick of corner of octant
+    etree_tick_t z; ///< z tick of corner of octant
+    int level; ///< Level of octant
+  }; // OctantStruct
+
+private :
+  // NOT IMPLEMENTED ////////////////////////////////////////////////////
+
+  DirtyList(const DirtyList& l); ///< Not implemented
+  const DirtyList& operator=(const DirtyList& l); ///< Not implemented
+
+private :
+  // PRIVATE MEMBERS ////////////////////////////////////////////////////
+
+  std::vector<OctantStruct> _octants; ///< Octants in list
+
+}; // DirtyList
+
+#include "DirtyList.icc" // inline methods
+
+#endif // cencalvm_average_dirtylist_h
+
+// End of file 
@@ -0,0 +1,414 @@
+// -*- C++ -*-
+//
+// ======================================================================
+//
+//                           Brad T. Aagaard
+//                        U.S. Geological Survey
+//
+// {LicenseText}
+//
+// ======================================================================
+//
+
+#include "MergeEngine.h" // implementation of class methods
+
+#include "AvgEngine.h" // USES AvgEngine
+
+#include "cencalvm/storage/Payload.h" // USES PayloadStruct
+#include "cencalvm/storage/Geometry.h" // USES Geometry
+
+extern "C" {
+#include "etree.h"
+}
+
+#include <stdexcept> // USES std::runtime_error
+#include <assert.h> // USES assert()
+#include <iostream> // USES std::cout
+
+// ----------------------------------------------------------------------
+// Address and payload of octant.
+struct cencalvm::average::MergeEngine::OctantStruct {
+  etree_addr_t addr;
+  storage::PayloadStruct payload;
+}; // OctantStruct
+
+// ----------------------------------------------------------------------
+// Cursor over octants of a database.
+struct cencalvm::average::MergeEngine::StreamStruct {
+  etree_t* db;
+  OctantStruct octant; ///< Octant at current cursor position
+  bool isValid; ///< True if cursor is at an octant
+}; // StreamStruct
+
+// ----------------------------------------------------------------------
+// Constructor
+cencalvm::average::MergeEngine::MergeEngine(etree_t* dbOut,
+					    etree_t* dbDetailed,
+					    etree_t* dbExt,
+					    storage::Geometry* pGeom,
+					    const int bufferSize) :
+  _dbOut(dbOut),
+  _pDetailed(new StreamStruct),
+  _pExt(new StreamStruct),
+  _pGeom(pGeom),
+  _pAvgEngine(0),
+  _bufferSize(bufferSize)
+{ // constructor
+  _pDetailed->db = dbDetailed;
+  _pDetailed->isValid = false;
+  _pExt->db = dbExt;
+  _pExt->isValid = false;
+
+  _octantCounter.detailed = 0;
+  _octantCounter.extended = 0;
+  _octantCounter.split = 0;
+  _octantCounter.dropped = 0;
+} // constructor
+
+// ----------------------------------------------------------------------
+// Destructor
+cencalvm::average::MergeEngine::~MergeEngine(void)
+{ // destructor
+  delete _pDetailed; _pDetailed = 0;
+  delete _pExt; _pExt = 0;
+  delete _pAvgEngine; _pAvgEngine = 0;
+} // destructor
+
+// ----------------------------------------------------------------------
+// Merge octants of detailed and extended databases.
+void
+cencalvm::average::MergeEngine::mergeOctants(void)
+{ // mergeOctants
+  assert(0 != _dbOut);
+  assert(0 != _pDetailed->db);
+  assert(0 != _pExt->db);
+  assert(0 != _pGeom);
+
+  etree_addr_t cursor;
+  cursor.x = 0;
+  cursor.y = 0;
+  cursor.z = 0;
+  cursor.t = 0;
+  cursor.level = ETREE_MAXLEVEL;
+
+  StreamStruct* streams[2] = { _pDetailed, _pExt };
+  for (int i=0; i < 2; ++i) {
+    StreamStruct* pStream = streams[i];
+    pStream->isValid = (0 == etree_initcursor(pStream->db, cursor));
+    if (pStream->isValid &&
+	0 != etree_getcursor(pStream->db, &pStream->octant.addr, 0,
+			     &pStream->octant.payload))
+      throw std::runtime_error("Error occurred while trying to get payload at "
+			       "current cursor position.");
+  } // for
+
+  // An averaged database starts with the interior octant at the root.
+  const bool averagedD = 
+    _pDetailed->isValid && ETREE_INTERIOR == _pDetailed->octant.addr.type;
+  const bool averagedE = 
+    _pExt->isValid && ETREE_INTERIOR == _pExt->octant.addr.type;
+  if (_pDetailed->isValid && _pExt->isValid && averagedD != averagedE)
+    throw std::runtime_error("Etree databases for detailed and extended "
+			     "models must either both be averaged or both "
+			     "not be averaged.");
+
+  delete _pAvgEngine; _pAvgEngine = 0;
+  if (averagedD || averagedE) {
+    _pAvgEngine = new AvgEngine(_dbOut, _pDetailed->db, _bufferSize);
+    _pAvgEngine->beginFill();
+  } else if (0 != etree_beginappend(_dbOut, 1.0))
+    throw std::runtime_error("Error occurred while trying to initiate appending "
+			     "of etree.");
+
+  etree_addr_t root;
+  root.x = 0;
+  root.y = 0;
+  root.z = 0;
+  root.t = 0;
+  root.level = 0;
+  root.type = ETREE_INTERIOR;
+  _mergeRegion(root, 0, 0);
+
+  if (0 != _pAvgEngine)
+    _pAvgEngine->endFill();
+  else if (0 != etree_endappend(_dbOut))
+    throw std::runtime_error("Error occurred while trying to terminate appending "
+			     "of etree.");
+} // mergeOctants
+
+// ----------------------------------------------------------------------
+// Print octant counting information to stream.
+void
+cencalvm::average::MergeEngine::printOctantInfo(void) const
+{ // printOctantInfo
+  std::cout
+    << "Summary of etree merging\n"
+    << "Number of octants\n"
+    << "  detailed: " << _octantCounter.detailed << "\n"
+    << "  extended: " << _octantCounter.extended << "\n"
+    << "  subdivided leaves: " << _octantCounter.split << "\n"
+    << "  replaced or averaged again: " << _octantCounter.dropped << "\n"
+    << std::endl;
+  if (0 != _pAvgEngine)
+    _pAvgEngine->printOctantInfo();
+} // printOctantInfo
+
+// ----------------------------------------------------------------------
+// Merge octants of both databases within region.
+void
+cencalvm::average::MergeEngine::_mergeRegion(const etree_addr_t& region,
+					     const OctantStruct* pCoverD,
+					     const OctantStruct* pCoverE)
+{ // _mergeRegion
+  OctantStruct octD;
+  const bool atD = _octantAt(&octD, _pDetailed, region);
+  if (atD && ETREE_LEAF == octD.addr.type)
+    pCoverD = &octD;
+
+  OctantStruct octE;
+  const bool atE = _octantAt(&octE, _pExt, region);
+  if (atE && ETREE_LEAF == octE.addr.type)
+    pCoverE = &octE;
+
+  // Leaf of detailed model with data takes precedence over everything.
+  if (0 != pCoverD && 
+      storage::Payload::NODATABLOCK != pCoverD->payload.FaultBlock) {
+    if (atD) {
+      _addOctant(&octD.addr, octD.payload);
+      ++_octantCounter.detailed;
+    } // if
+    if (atE)
+      ++_octantCounter.dropped;
+    _skipRegion(_pExt, region);
+    return;
+  } // if
+
+  const bool hasD = 
+    _pDetailed->isValid &&
+    storage::Geometry::contains(region, _pDetailed->octant.addr);
+  const bool hasE = 
+    _pExt->isValid &&
+    storage::Geometry::contains(region, _pExt->octant.addr);
+
+  if (0 != pCoverE) {
+    // Leaf of extended model takes precedence over leaf of detailed
+    // model without data.
+    if (atD)
+      ++_octantCounter.dropped;
+    if (hasD) {
+      if (atE)
+	++_octantCounter.dropped;
+      _mergeChildren(region, pCoverD, pCoverE);
+    } else if (atE) {
+      _addOctant(&octE.addr, octE.payload);
+      ++_octantCounter.extended;
+    } else
+      _splitLeaf(region, *pCoverE);
+  } else if (0 != pCoverD) {
+    // Leaf of detailed model without data fills gaps in extended model.
+    if (atE)
+      ++_octantCounter.dropped;
+    if (hasE) {
+      if (atD)
+	++_octantCounter.dropped;
+      _mergeChildren(region, pCoverD, pCoverE);
+    } else if (atD) {
+      _addOctant(&octD.addr, octD.payload);
+      ++_octantCounter.detailed;
+    } else
+      _splitLeaf(region, *pCoverD);
+  } else if (!hasE) {
+    // Only detailed model covers region.
+    if (atE)
+      ++_octantCounter.dropped;
+    _octantCounter.detailed += 
+      _copyRegion(_pDetailed, region, atD ? &octD : 0);
+  } else if (!hasD) {
+    // Only extended model covers region.
+    if (atD)
+      ++_octantCounter.dropped;
+    _octantCounter.extended += 
+      _copyRegion(_pExt, region, atE ? &octE : 0);
+  } else {
+    // Both models cover region, so interior octants are averaged again.
+    if (atD)
+      ++_octantCounter.dropped;
+    if (atE)
+      ++_octantCounter.dropped;
+    _mergeChildren(region, 0, 0);
+  } // if/else
+} // _mergeRegion
+
+// ----------------------------------------------------------------------
+// Merge octants of both databases within children of region.
+void
+cencalvm::average::MergeEngine::_mergeChildren(const etree_addr_t& region,
+					       const OctantStruct* pCoverD,
+					       const OctantStruct* pCoverE)
+{ // _mergeChildren
+  assert(region.level < ETREE_MAXLEVEL);
+
+  etree_addr_t child;
+  child.t = 0;
+  child.level = region.level + 1;
+  child.type = ETREE_INTERIOR;
+  const etree_tick_t tickLen = ((etree_tick_t) 0x80000000) >> child.level;
+  // Children in Morton pre-order (x varies fastest, z slowest).
+  for (int iChild=0; iChild < 8; ++iChild) {
+    child.x = region.x + ((iChild & 1) ? tickLen : 0);
+    child.y = region.y + ((iChild & 2) ? tickLen : 0);
+    child.z = region.z + ((iChild & 4) ? tickLen : 0);
+    _mergeRegion(child, pCoverD, pCoverE);
+  } // for
+} // _mergeChildren
+
+// ----------------------------------------------------------------------
+// Copy all octants of database within region.
+uint64_t
+cencalvm::average::MergeEngine::_copyRegion(StreamStruct* pStream,
+					    const etree_addr_t& region,
+					    const OctantStruct* pRoot)
+{ // _copyRegion
+  assert(0 != pStream);
+
+  uint64_t numCopied = 0;
+  OctantStruct octant;
+  etree_addr_t addrRoot; // root of last subtree copied
+  bool haveRoot = false;
+  if (0 != pRoot) {
+    octant = *pRoot;
+    _addOctant(&octant.addr, octant.payload);
+    addrRoot = pRoot->addr;
+    haveRoot = true;
+    ++numCopied;
+  } // if
+  while (pStream->isValid &&
+	 storage::Geometry::contains(region, pStream->octant.addr)) {
+    octant = pStream->octant;
+    if (haveRoot && storage::Geometry::contains(addrRoot, octant.addr))
+      _copyOctant(&octant.addr, octant.payload);
+    else {
+      _addOctant(&octant.addr, octant.payload);
+      addrRoot = pStream->octant.addr;
+      haveRoot = true;
+    } // else
+    ++numCopied;
+    _advance(pStream);
+  } // while
+
+  return numCopied;
+} // _copyRegion
+
+// ----------------------------------------------------------------------
+// Skip all octants of database within region.
+void
+cencalvm::average::MergeEngine::_skipRegion(StreamStruct* pStream,
+					    const etree_addr_t& region)
+{ // _skipRegion
+  assert(0 != pStream);
+
+  while (pStream->isValid &&
+	 storage::Geometry::contains(region, pStream->octant.addr)) {
+    ++_octantCounter.dropped;
+    _advance(pStream);
+  } // while
+} // _skipRegion
+
+// ----------------------------------------------------------------------
+// Append leaf octant filling region with values of leaf octant
+// containing region.
+void
+cencalvm::average::MergeEngine::_splitLeaf(const etree_addr_t& region,
+					   const OctantStruct& cover)
+{ // _splitLeaf
+  assert(0 != _pGeom);
+
+  OctantStruct leaf = cover;
+  leaf.addr = region;
+  leaf.addr.type = ETREE_LEAF;
+
+  // Depth of free surface is relative to the octant centroid.
+  if (storage::Payload::NODATAVAL != leaf.payload.DepthFreeSurf) {
+    etree_addr_t addrCover = cover.addr;
+    double lon = 0.0;
+    double lat = 0.0;
+    double elevCover = 0.0;
+    _pGeom->addrToLonLatElev(&lon, &lat, &elevCover, &addrCover);
+    double elevLeaf = 0.0;
+    _pGeom->addrToLonLatElev(&lon, &lat, &elevLeaf, &leaf.addr);
+    leaf.payload.DepthFreeSurf += elevCover - elevLeaf;
+  } // if
+
+  _addOctant(&leaf.addr, leaf.payload);
+  ++_octantCounter.split;
+} // _splitLeaf
+
+// ----------------------------------------------------------------------
+// Get octant at cursor of stream if it is at region.
+bool
+cencalvm::average::MergeEngine::_octantAt(OctantStruct* pOctant,
+					  StreamStruct* pStream,
+					  const etree_addr_t& region)
+{ // _octantAt
+  assert(0 != pOctant);
+  assert(0 != pStream);
+
+  if (!pStream->isValid ||
+      region.level != pStream->octant.addr.level ||
+      region.x != pStream->octant.addr.x ||
+      region.y != pStream->octant.addr.y ||
+      region.z != pStream->octant.addr.z)
+    return false;
+
+  *pOctant = pStream->octant;
+  _advance(pStream);
+  return true;
+} // _octantAt
+
+// ----------------------------------------------------------------------
+// Advance cursor of stream to next octant.
+void
+cencalvm::average::MergeEngine::_advance(StreamStruct* pStream)
+{ // _advance
+  assert(0 != pStream);
+
+  pStream->isValid = (0 == etree_advcursor(pStream->db));
+  if (pStream->isValid &&
+      0 != etree_getcursor(pStream->db, &pStream->octant.addr, 0, 
+			   &pStream->octant.payload))
+    throw std::runtime_error("Error occurred while trying to get payload at "
+			     "current cursor position.");
+} // _advance
+
+// ----------------------------------------------------------------------
+// Append octant that is final to merged database.
+void
+cencalvm::average::MergeEngine::_addOctant(etree_addr_t* pAddr,
+				      const storage::PayloadStruct& payload)
+{ // _addOctant
+  assert(0 != pAddr);
+
+  if (0 != _pAvgEngine)
+    _pAvgEngine->addOctant(pAddr, payload);
+  else if (0 != etree_append(_dbOut, *pAddr, &payload))
+    throw std::runtime_error("Error occurred while trying to append octant "
+			     "to etree.");
+} // _addOctant
+
+// ----------------------------------------------------------------------
+// Append descendant of subtree copied from input database to merged
+// database.
+void
+cencalvm::average::MergeEngine::_copyOctant(etree_addr_t* pAddr,
+				       const storage::PayloadStruct& payload)
+{ // _copyOctant
+  assert(0 != pAddr);
+
+  if (0 != _pAvgEngine)
+    _pAvgEngine->copyOctant(pAddr, payload);
+  else if (0 != etree_append(_dbOut, *pAddr, &payload))
+    throw std::runtime_error("Error occurred while trying to append octant "
+			     "to etree.");
+} // _copyOctant
+
+// End of file
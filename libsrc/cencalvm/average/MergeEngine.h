@@ -0,0 +1,212 @@
+// -*- C++ -*-
+//
+// ======================================================================
+//
+//                           Brad T. Aagaard
+//                        U.S. Geological Survey
+//
+// {LicenseText}
+//
+// ======================================================================
+//
+
+/** @file libsrc/average/MergeEngine.h
+ *
+ * @brief C++ engine for merging the etree databases of the detailed
+ * and extended models into a single etree database.
+ *
+ * The octants of both databases are streamed with cursors in Morton
+ * pre-order and the merged database is written using only sequential
+ * appends. Leaf octants of the detailed model that contain data take
+ * precedence over octants of the extended model. Leaf octants of the
+ * extended model (or leaf octants of the detailed model without data)
+ * that are only partially covered are subdivided into leaf octants
+ * that fill the gaps.
+ *
+ * If the databases have been averaged, only the interior octants in
+ * regions where the models overlap are averaged again. Subtrees
+ * covered by only one of the models are copied without modification.
+ */
+
+#if !defined(cencalvm_average_mergeengine_h)
+#define cencalvm_average_mergeengine_h
+
+#include "cencalvm/storage/etreefwd.h" // HOLDSA etree_t
+
+#include <inttypes.h> // USES uint64_t
+
+namespace cencalvm {
+  namespace average {
+    class MergeEngine;
+    class AvgEngine; // HOLDSA AvgEngine
+  } // namespace average
+  namespace storage {
+    class Geometry; // HOLDSA Geometry
+    struct PayloadStruct; // USES PayloadStruct
+  } // namespace storage
+} // namespace cencalvm
+
+/// C++ engine for merging the etree databases of the detailed and
+/// extended models into a single etree database.
+class cencalvm::average::MergeEngine
+{ // MergeEngine
+
+public :
+  // PUBLIC METHODS /////////////////////////////////////////////////////
+
+  /** Constructor
+   *
+   * @param dbOut Output database
+   * @param dbDetailed Database for detailed model
+   * @param dbExt Database for extended model
+   * @param pGeom Pointer to geometry of velocity model
+   * @param bufferSize Maximum number of octants in write-behind buffer
+   */
+  MergeEngine(etree_t* dbOut,
+	      etree_t* dbDetailed,
+	      etree_t* dbExt,
+	      storage::Geometry* pGeom,
+	      const int bufferSize);
+
+  /// Destructor
+  ~MergeEngine(void);
+
+  /// Merge octants of detailed and extended databases.
+  void mergeOctants(void);
+
+  /// Print octant counting information to stream.
+  void printOctantInfo(void) const;
+
+private :
+  // PRIVATE METHODS ////////////////////////////////////////////////////
+
+  MergeEngine(const MergeEngine& e); ///< Not implemented
+  const MergeEngine& operator=(const MergeEngine& e); ///< Not implemented
+
+private :
+  // PRIVATE STRUCTS ////////////////////////////////////////////////////
+
+  struct OctantStruct; ///< Address and payload of octant
+  struct StreamStruct; ///< Cursor over octants of a database
+
+  struct CounterStruct {
+    uint64_t detailed; ///< Number of octants copied from detailed model
+    uint64_t extended; ///< Number of octants copied from extended model
+    uint64_t split; ///< Number of leaf octants created by subdivision
+    uint64_t dropped; ///< Number of octants replaced or averaged again
+  }; // CounterStruct
+
+private :
+  // PRIVATE METHODS ////////////////////////////////////////////////////
+
+  /** Merge octants of both databases within region.
+   *
+   * The cursors of both databases must be positioned at the first
+   * octant that does not precede the region.
+   *
+   * @param region Address of octant defining region
+   * @param pCoverD Leaf octant of detailed model containing region
+   *   (0 if none)
+   * @param pCoverE Leaf octant of extended model containing region
+   *   (0 if none)
+   */
+  void _mergeRegion(const etree_addr_t& region,
+		    const OctantStruct* pCoverD,
+		    const OctantStruct* pCoverE);
+
+  /** Merge octants of both databases within children of region.
+   *
+   * @param region Address of octant defining region
+   * @param pCoverD Leaf octant of detailed model containing region
+   *   (0 if none)
+   * @param pCoverE Leaf octant of extended model containing region
+   *   (0 if none)
+   */
+  void _mergeChildren(const etree_addr_t& region,
+		      const OctantStruct* pCoverD,
+		      const OctantStruct* pCoverE);
+
+  /** Copy all octants of database within region.
+   *
+   * @param pStream Pointer to stream of database
+   * @param region Address of octant defining region
+   * @param pRoot Octant at region (0 if none)
+   *
+   * @returns Number of octants copied
+   */
+  uint64_t _copyRegion(StreamStruct* pStream,
+		       const etree_addr_t& region,
+		       const OctantStruct* pRoot);
+
+  /** Skip all octants of database within region.
+   *
+   * @param pStream Pointer to stream of database
+   * @param region Address of octant defining region
+   */
+  void _skipRegion(StreamStruct* pStream,
+		   const etree_addr_t& region);
+
+  /** Append leaf octant filling region with values of leaf octant
+   * containing region.
+   *
+   * @param region Address of octant defining region
+   * @param cover Leaf octant containing region
+   */
+  void _splitLeaf(const etree_addr_t& region,
+		  const OctantStruct& cover);
+
+  /** Get octant at cursor of stream if it is at region.
+   *
+   * @param pOctant Pointer to octant
+   * @param pStream Pointer to stream of database
+   * @param region Address of octant defining region
+   *
+   * @returns True if octant is at region, false otherwise
+   */
+  bool _octantAt(OctantStruct* pOctant,
+		 StreamStruct* pStream,
+		 const etree_addr_t& region);
+
+  /** Advance cursor of stream to next octant.
+   *
+   * @param pStream Pointer to stream of database
+   */
+  void _advance(StreamStruct* pStream);
+
+  /** Append octant that is final (leaf octant or root of subtree
+   * copied from input database) to merged database.
+   *
+   * @param pAddr Pointer to address of octant
+   * @param payload Payload of octant
+   */
+  void _addOctant(etree_addr_t* pAddr,
+		  const storage::PayloadStruct& payload);
+
+  /** Append descendant of subtree copied from input database to
+   * merged database.
+   *
+   * @param pAddr Pointer to address of octant
+   * @param payload Payload of octant
+   */
+  void _copyOctant(etree_addr_t* pAddr,
+		   const storage::PayloadStruct& payload);
+
+private :
+  // PRIVATE MEMBERS ////////////////////////////////////////////////////
+
+  etree_t* _dbOut; ///< Merged database
+
+  StreamStruct* _pDetailed; ///< Stream of octants in detailed model
+  StreamStruct* _pExt; ///< Stream of octants in extended model
+
+  storage::Geometry* _pGeom; ///< Geometry of velocity model
+  AvgEngine* _pAvgEngine; ///< Averaging engine (0 if not averaged)
+  int _bufferSize; ///< Number of octants in write-behind buffer
+
+  CounterStruct _octantCounter;
+
+}; // MergeEngine
+
+#endif // cencalvm_average_mergeengine_h
+
+// End of file
@@ -0,0 +1,212 @@
+// -*- C++ -*-
+//
+// ======================================================================
+//
+//                           Brad T. Aagaard
+//                        U.S. Geological Survey
+//
+// {LicenseText}
+//
+// ======================================================================
+//
+
+#include "Merger.h" // implementation of class methods
+
+#include "cencalvm/storage/Payload.h" // USES PayloadStruct
+#include "AvgEngine.h" // USES AvgEngine::DEFAULTBUFFERSIZE
+#include "MergeEngine.h" // USES MergeEngine
+
+#include "cencalvm/storage/Geometry.h" // USES Geometry
+#include "cencalvm/storage/GeomCenCA.h" // USES GeomCenCA
+
+extern "C" {
+#include "etree.h"
+}
+
+#include <stdexcept> // USES std::runtime_error
+#include <sstream> // USES std::ostringstream
+#include <assert.h> // USES assert()
+#include <string.h> // USES strcmp()
+#include <time.h> // USES time_t
+#include <unistd.h> // USES gethostname()
+#include <iostream> // USES std::cout
+
+// ----------------------------------------------------------------------
+const double cencalvm::average::Merger::_AUTOFRACTION = 0.25;
+
+// ----------------------------------------------------------------------
+// Default constructor
+cencalvm::average::Merger::Merger(void) :
+  _dbIn(0),
+  _dbExt(0),
+  _dbOut(0),
+  _filenameIn(""),
+  _filenameExt(""),
+  _filenameOut(""),
+  _pGeom(new storage::GeomCenCA),
+  _bufferSize(AvgEngine::DEFAULTBUFFERSIZE),
+  _cacheSize(512),
+  _quiet(false)
+{ // constructor
+} // constructor
+  
+// ----------------------------------------------------------------------
+// Default destructor.
+cencalvm::average::Merger::~Merger(void)
+{ // destructor
+  if (0 != _dbIn) {
+    etree_close(_dbIn);
+    _dbIn = 0;
+  } // if
+  if (0 != _dbExt) {
+    etree_close(_dbExt);
+    _dbExt = 0;
+  } // if
+  if (0 != _dbOut) {
+    etree_close(_dbOut);
+    _dbOut = 0;
+  } // if
+  delete _pGeom; _pGeom = 0;
+} // destructor
+
+// ----------------------------------------------------------------------
+// Set geometry of velocity model.
+void
+cencalvm::average::Merger::geometry(const storage::Geometry* pGeom)
+{ // geometry
+  delete _pGeom; _pGeom = (0 != pGeom) ? pGeom->clone() : 0;
+} // geometry
+
+// ----------------------------------------------------------------------
+// Merge databases for detailed and extended models.
+void
+cencalvm::average::Merger::merge(void)
+{ // merge
+  if (0 == _pGeom)
+    throw std::runtime_error("Geometry of velocity model must be set "
+			     "before merging.");
+
+  _dbIn = _openDB(_filenameIn, "detailed model");
+  _dbExt = _openDB(_filenameExt, "extended model");
+
+  // Open merged database for output, which is dominated by the
+  // detailed model.
+  const int cacheSize = _chooseCacheSize(_filenameIn.c_str(), "output");
+  const int numDims = 3;
+  const int payloadSize = sizeof(cencalvm::storage::PayloadStruct);
+  _dbOut = etree_open(_filenameOut.c_str(),
+		      O_CREAT|O_RDWR|O_TRUNC, cacheSize, payloadSize, numDims);
+  if (0 == _dbOut) {
+    std::ostringstream msg;
+    msg
+      << "Could not open etree database '" << _filenameOut
+      << "' for output of merged etree database.";
+    throw std::runtime_error(msg.str());
+  } // if
+
+  // Register schema in output database
+  if (0 != etree_registerschema(_dbOut, cencalvm::storage::Payload::SCHEMA))
+    throw std::runtime_error(etree_strerror(etree_errno(_dbOut)));
+
+  // Set database metadata if detailed model etree has metadata
+  char* appmeta = etree_getappmeta(_dbIn);
+  if (0 != appmeta) {
+    const int maxLen = 128;
+    char hostname[maxLen];
+    gethostname(hostname, maxLen);
+    time_t rawTime = time(0);
+    const char* datetime = ctime(&rawTime);
+    std::ostringstream metainfo;
+    metainfo
+      << appmeta << "\n"
+      << "merged with extended model '" << _filenameExt << "' on: "
+      << datetime
+      << "host: "  << hostname;
+    if (0 != etree_setappmeta(_dbOut, metainfo.str().c_str()))
+      throw std::runtime_error(etree_strerror(etree_errno(_dbOut)));
+  } // if
+
+  MergeEngine engine(_dbOut, _dbIn, _dbExt, _pGeom, _bufferSize);
+  engine.mergeOctants();
+  if (!_quiet)
+    engine.printOctantInfo();
+
+  etree_close(_dbIn); _dbIn = 0;
+  etree_close(_dbExt); _dbExt = 0;
+  etree_close(_dbOut); _dbOut = 0;
+} // merge
+
+// ----------------------------------------------------------------------
+// Open existing database and check its compatibility.
+etree_t*
+cencalvm::average::Merger::_openDB(const std::string& filename,
+				    const char* description) const
+{ // _openDB
+  assert(0 != description);
+
+  const int cacheSize = _chooseCacheSize(filename.c_str(), description);
+  const int numDims = 3;
+  const int payloadSize = sizeof(cencalvm::storage::PayloadStruct);
+  etree_t* db = etree_open(filename.c_str(), O_RDONLY,
+			   cacheSize, payloadSize, numDims);
+  if (0 == db) {
+    std::ostringstream msg;
+    msg
+      << "Could not open " << description << " etree database '" << filename
+      << "' for merging.";
+    throw std::runtime_error(msg.str());
+  } // if
+
+  if (etree_getpayloadsize(db) != payloadSize) {
+    std::ostringstream msg;
+    msg
+      << "Payload size of " << description << " etree database '" << filename
+      << "' doesn't match the expected payload size.\n"
+      << "Expected payload size is " << payloadSize
+      << ", and database payload size is " << etree_getpayloadsize(db)
+      << ".";
+    etree_close(db);
+    throw std::runtime_error(msg.str());
+  } // if
+  const char* schema = etree_getschema(db);
+  if (0 != strcmp(schema, cencalvm::storage::Payload::SCHEMA)) {
+    std::ostringstream msg;
+    msg
+      << "Schema of " << description << " etree database '" << filename
+      << "' doesn't match the expected schema.\n"
+      << "Expected schema is\n'" << cencalvm::storage::Payload::SCHEMA
+      << "'\nand database schema is\n'" << schema << "'";
+    etree_close(db);
+    throw std::runtime_error(msg.str());
+  } // if
+
+  return db;
+} // _openDB
+
+// ----------------------------------------------------------------------
+// Choose size of etree cache of database.
+int
+cencalvm::average::Merger::_chooseCacheSize(const char* filename,
+					    const char* description) const
+{ // _chooseCacheSize
+  assert(0 != filename);
+  assert(0 != description);
+
+  if (storage::CacheMonitor::AUTOSIZE != _cacheSize)
+    return _cacheSize;
+
+  // Merging reads both databases in order and appends to the output
+  // database, so the working set is the whole database.
+  const int cacheSize =
+    storage::CacheMonitor::maxSize(filename, _AUTOFRACTION);
+  if (!_quiet)
+    std::cout
+      << "Using automatic etree cache of " << cacheSize << " MB for "
+      << description << " database ("
+      << storage::CacheMonitor::availableMemory() / 1048576
+      << " MB of memory available, database '" << filename << "')."
+      << std::endl;
+  return cacheSize;
+} // _chooseCacheSize
+
+// End of file
@@ -0,0 +1,170 @@
+// -*- C++ -*-
+//
+// ======================================================================
+//
+//                           Brad T. Aagaard
+//                        U.S. Geological Survey
+//
+// {LicenseText}
+//
+// ======================================================================
+//
+
+/** @file libsrc/average/Merger.h
+ *
+ * @brief C++ manager for merging the etree databases of the detailed
+ * and extended USGS central CA velocity models into a single etree
+ * database.
+ *
+ * Queries of the merged database need only one search (and one
+ * cache), whereas queries of the separate databases search the
+ * extended model whenever the detailed model has no data.
+ */
+
+#if !defined(cencalvm_average_merger_h)
+#define cencalvm_average_merger_h
+
+#include <string> // HASA std::string
+#include "cencalvm/storage/etreefwd.h" // HOLDSA etree_t
+#include "cencalvm/storage/CacheMonitor.h" // USES CacheMonitor::AUTOSIZE
+
+namespace cencalvm {
+  namespace average {
+    class Merger;
+  } // namespace average
+  namespace storage {
+    class Geometry; // HOLDSA Geometry
+  } // namespace storage
+} // namespace cencalvm
+
+/// C++ manager for merging the etree databases of the detailed and
+/// extended models into a single etree database
+class cencalvm::average::Merger
+{ // Merger
+
+public :
+  // PUBLIC METHODS /////////////////////////////////////////////////////
+
+  /// Constructor.
+  Merger(void);
+
+  /// Destructor
+  ~Merger(void);
+
+  /** Set filename of database for detailed model.
+   *
+   * @param filename Name of file
+   */
+  void filenameIn(const char* filename);
+
+  /** Set filename of database for extended model.
+   *
+   * @param filename Name of file
+   */
+  void filenameExt(const char* filename);
+
+  /** Set filename of output (merged) database.
+   *
+   * @param filename Name of file
+   */
+  void filenameOut(const char* filename);
+
+  /** Set maximum number of octants held in the write-behind buffer
+   * while averaging.
+   *
+   * @param size Number of octants
+   */
+  void bufferSize(const int size);
+
+  /** Set size of etree cache of each database.
+   *
+   * With storage::CacheMonitor::AUTOSIZE the cache of each database
+   * is sized from the available memory and the size of the database
+   * (the detailed model for the output database; see
+   * storage::CacheMonitor::maxSize()) and the size chosen is
+   * reported. Default is 512 MB.
+   *
+   * @param size Size of cache in MB or storage::CacheMonitor::AUTOSIZE
+   */
+  void cacheSize(const int size);
+
+  /** Set geometry of velocity model.
+   *
+   * Default is GeomCenCA.
+   *
+   * @param pGeom Pointer to geometry
+   */
+  void geometry(const storage::Geometry* pGeom);
+
+  /** Merge databases for detailed and extended models.
+   *
+   * Leaf octants of the detailed model with data take precedence
+   * over octants of the extended model. Either both databases or
+   * neither database must be averaged.
+   */
+  void merge(void);
+
+  /** Set flag indicating merging should be quiet (no progress reports).
+   *
+   * Default behavior is for to give progress reports.
+   *
+   * @param flag True for quiet operation, false to give progress reports
+   */
+  void quiet(const bool flag);
+
+private :
+  // PRIVATE METHODS ////////////////////////////////////////////////////
+
+  Merger(const Merger& p); ///< Not implemented
+  const Merger& operator=(const Merger& p); ///< Not implemented
+  
+private :
+  // PRIVATE METHODS ////////////////////////////////////////////////////
+
+  /** Open existing database and check its compatibility.
+   *
+   * @param filename Name of database file
+   * @param description Description of database used in error messages
+   *
+   * @returns Database
+   */
+  etree_t* _openDB(const std::string& filename,
+		   const char* description) const;
+
+  /** Choose size of etree cache of database.
+   *
+   * @param filename Name of database used to size automatic cache
+   * @param description Description of database used in progress report
+   *
+   * @returns Size of cache in MB
+   */
+  int _chooseCacheSize(const char* filename,
+		       const char* description) const;
+
+private :
+  // PRIVATE MEMBERS ////////////////////////////////////////////////////
+
+  etree_t* _dbIn; ///< Database for detailed model
+  etree_t* _dbExt; ///< Database for extended model
+  etree_t* _dbOut; ///< Merged database
+
+  std::string _filenameIn; ///< Filename of database for detailed model
+  std::string _filenameExt; ///< Filename of database for extended model
+  std::string _filenameOut; ///< Filename of output database
+
+  storage::Geometry* _pGeom; ///< Geometry of velocity model
+
+  int _bufferSize; ///< Number of octants in write-behind buffer
+  int _cacheSize; ///< Size of etree cache in MB (or AUTOSIZE)
+  
+  bool _quiet; ///< Flag to eliminate progress reports
+
+  static const double _AUTOFRACTION; ///< Fraction of memory for each cache
+
+}; // Merger
+
+#include "Merger.icc" // inline methods
+
+#endif // cencalvm_average_merger_h
+
+// End of file 
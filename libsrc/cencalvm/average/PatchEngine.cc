@@ -0,0 +1,227 @@
+// -*- C++ -*-
+//
+// ======================================================================
+//
+//                           Brad T. Aagaard
+//                        U.S. Geological Survey
+//
+// {LicenseText}
+//
+// ======================================================================
+//
+
+#include "PatchEngine.h" // implementation of class methods
+
+#include "AvgEngine.h" // USES AvgEngine
+
+#include "cencalvm/storage/Payload.h" // USES PayloadStruct
+#include "cencalvm/storage/Geometry.h" // USES Geometry::precedes(), contains()
+
+extern "C" {
+#include "etree.h"
+}
+
+#include <stdexcept> // USES std::runtime_error
+#include <sstream> // USES std::ostringstream
+#include <assert.h> // USES assert()
+#include <iostream> // USES std::cout
+
+// ----------------------------------------------------------------------
+// Constructor
+cencalvm::average::PatchEngine::PatchEngine(etree_t* dbOut,
+					    etree_t* dbBase,
+					    etree_t* dbPatch,
+					    const int bufferSize) :
+  _dbOut(dbOut),
+  _dbBase(dbBase),
+  _dbPatch(dbPatch),
+  _pAvgEngine(0),
+  _bufferSize(bufferSize)
+{ // constructor
+  _octantCounter.patch = 0;
+  _octantCounter.copied = 0;
+  _octantCounter.replaced = 0;
+  _octantCounter.averaged = 0;
+} // constructor
+
+// ----------------------------------------------------------------------
+// Destructor
+cencalvm::average::PatchEngine::~PatchEngine(void)
+{ // destructor
+  delete _pAvgEngine; _pAvgEngine = 0;
+} // destructor
+
+// ----------------------------------------------------------------------
+// Merge octants of patch database into base database.
+void
+cencalvm::average::PatchEngine::mergeOctants(void)
+{ // mergeOctants
+  assert(0 != _dbOut);
+  assert(0 != _dbBase);
+  assert(0 != _dbPatch);
+
+  etree_addr_t cursor;
+  cursor.x = 0;
+  cursor.y = 0;
+  cursor.z = 0;
+  cursor.t = 0;
+  cursor.level = ETREE_MAXLEVEL;
+
+  etree_addr_t addrBase;
+  storage::PayloadStruct payloadBase;
+  bool haveBase = (0 == etree_initcursor(_dbBase, cursor));
+  if (haveBase)
+    _getOctant(_dbBase, &addrBase, &payloadBase);
+
+  etree_addr_t addrPatch;
+  storage::PayloadStruct payloadPatch;
+  bool havePatch = (0 == etree_initcursor(_dbPatch, cursor));
+  if (havePatch)
+    _getOctant(_dbPatch, &addrPatch, &payloadPatch);
+
+  // An averaged database starts with the interior octant at the root.
+  delete _pAvgEngine; _pAvgEngine = 0;
+  if (haveBase && ETREE_INTERIOR == addrBase.type) {
+    _pAvgEngine = new AvgEngine(_dbOut, _dbBase, _bufferSize);
+    _pAvgEngine->beginFill();
+  } else if (0 != etree_beginappend(_dbOut, 1.0))
+    throw std::runtime_error("Error occurred while trying to initiate appending "
+			     "of etree.");
+
+  etree_addr_t addrReplaced; // last octant added from patch
+  bool haveReplaced = false;
+  etree_addr_t addrCopied; // root of last subtree copied from base
+  bool haveCopied = false;
+  while (haveBase || havePatch) {
+    if (havePatch &&
+	(!haveBase || !storage::Geometry::precedes(addrBase, addrPatch))) {
+      if (haveReplaced &&
+	  storage::Geometry::contains(addrReplaced, addrPatch)) {
+	char bufA[ETREE_MAXBUF];
+	char bufB[ETREE_MAXBUF];
+	std::ostringstream msg;
+	msg
+	  << "Patch etree database must contain only leaf octants, but octant "
+	  << etree_straddr(_dbPatch, bufA, addrPatch) << " is contained in "
+	  << "octant " << etree_straddr(_dbPatch, bufB, addrReplaced) << ".";
+	throw std::runtime_error(msg.str());
+      } // if
+      _addOctant(&addrPatch, payloadPatch);
+      addrReplaced = addrPatch;
+      haveReplaced = true;
+      ++_octantCounter.patch;
+      havePatch = (0 == etree_advcursor(_dbPatch));
+      if (havePatch)
+	_getOctant(_dbPatch, &addrPatch, &payloadPatch);
+    } else {
+      if (haveReplaced &&
+	  storage::Geometry::contains(addrReplaced, addrBase)) {
+	// Octant is covered by patch, so drop it.
+	++_octantCounter.replaced;
+      } else if (haveCopied &&
+		 storage::Geometry::contains(addrCopied, addrBase)) {
+	// Octant is in subtree not touched by patch.
+	_copyOctant(&addrBase, payloadBase);
+	++_octantCounter.copied;
+      } else if (havePatch &&
+		 storage::Geometry::contains(addrBase, addrPatch)) {
+	// Octant is an ancestor of patch octant.
+	if (ETREE_LEAF == addrBase.type) {
+	  char bufA[ETREE_MAXBUF];
+	  char bufB[ETREE_MAXBUF];
+	  std::ostringstream msg;
+	  msg
+	    << "Patch octant " << etree_straddr(_dbPatch, bufA, addrPatch)
+	    << " is smaller than leaf octant "
+	    << etree_straddr(_dbBase, bufB, addrBase)
+	    << " of the base etree database. Patches cannot refine leaf "
+	    << "octants of the base database.";
+	  throw std::runtime_error(msg.str());
+	} // if
+	// Drop interior octant; it is averaged again from its children.
+	++_octantCounter.averaged;
+      } else {
+	// Octant is the root of a subtree not touched by patch.
+	_addOctant(&addrBase, payloadBase);
+	addrCopied = addrBase;
+	haveCopied = true;
+	++_octantCounter.copied;
+      } // if/else
+      haveBase = (0 == etree_advcursor(_dbBase));
+      if (haveBase)
+	_getOctant(_dbBase, &addrBase, &payloadBase);
+    } // if/else
+  } // while
+
+  if (0 != _pAvgEngine)
+    _pAvgEngine->endFill();
+  else if (0 != etree_endappend(_dbOut))
+    throw std::runtime_error("Error occurred while trying to terminate appending "
+			     "of etree.");
+} // mergeOctants
+
+// ----------------------------------------------------------------------
+// Print octant counting information to stream.
+void
+cencalvm::average::PatchEngine::printOctantInfo(void) const
+{ // printOctantInfo
+  std::cout
+    << "Summary of etree patching\n"
+    << "Number of octants\n"
+    << "  patch: " << _octantCounter.patch << "\n"
+    << "  base copied: " << _octantCounter.copied
+    << ", replaced: " << _octantCounter.replaced
+    << ", averaged again: " << _octantCounter.averaged << "\n"
+    << std::endl;
+  if (0 != _pAvgEngine)
+    _pAvgEngine->printOctantInfo();
+} // printOctantInfo
+
+// ----------------------------------------------------------------------
+// Get octant at current cursor position.
+void
+cencalvm::average::PatchEngine::_getOctant(etree_t* db,
+					   etree_addr_t* pAddr,
+					   storage::PayloadStruct* pPayload)
+{ // _getOctant
+  assert(0 != db);
+  assert(0 != pAddr);
+  assert(0 != pPayload);
+
+  if (0 != etree_getcursor(db, pAddr, 0, pPayload))
+    throw std::runtime_error("Error occurred while trying to get payload at "
+			     "current cursor position.");
+} // _getOctant
+
+// ----------------------------------------------------------------------
+// Append octant that is final to merged database.
+void
+cencalvm::average::PatchEngine::_addOctant(etree_addr_t* pAddr,
+				      const storage::PayloadStruct& payload)
+{ // _addOctant
+  assert(0 != pAddr);
+
+  if (0 != _pAvgEngine)
+    _pAvgEngine->addOctant(pAddr, payload);
+  else if (0 != etree_append(_dbOut, *pAddr, &payload))
+    throw std::runtime_error("Error occurred while trying to append octant "
+			     "to etree.");
+} // _addOctant
+
+// ----------------------------------------------------------------------
+// Append descendant of subtree copied from base database to merged
+// database.
+void
+cencalvm::average::PatchEngine::_copyOctant(etree_addr_t* pAddr,
+				       const storage::PayloadStruct& payload)
+{ // _copyOctant
+  assert(0 != pAddr);
+
+  if (0 != _pAvgEngine)
+    _pAvgEngine->copyOctant(pAddr, payload);
+  else if (0 != etree_append(_dbOut, *pAddr, &payload))
+    throw std::runtime_error("Error occurred while trying to append octant "
+			     "to etree.");
+} // _copyOctant
+
+// End of file
@@ -0,0 +1,138 @@
+// -*- C++ -*-
+//
+// ======================================================================
+//
+//                           Brad T. Aagaard
+//                        U.S. Geological Survey
+//
+// {LicenseText}
+//
+// ======================================================================
+//
+
+/** @file libsrc/average/PatchEngine.h
+ *
+ * @brief C++ engine for merging a patch etree database into a base
+ * etree database.
+ *
+ * The octants of the base and patch databases are streamed with
+ * cursors in Morton pre-order and the merged database is written
+ * using only sequential appends. Leaf octants in the patch replace
+ * the octants in the base database at the same location, along with
+ * any of their descendants.
+ *
+ * If the base database has been averaged, only the interior octants
+ * that are ancestors of patch octants are averaged again. All other
+ * subtrees of the base database are copied without modification.
+ */
+
+#if !defined(cencalvm_average_patchengine_h)
+#define cencalvm_average_patchengine_h
+
+#include "cencalvm/storage/etreefwd.h" // HOLDSA etree_t
+
+#include <inttypes.h> // USES uint64_t
+
+namespace cencalvm {
+  namespace average {
+    class PatchEngine;
+    class AvgEngine; // HOLDSA AvgEngine
+  } // namespace average
+  namespace storage {
+    struct PayloadStruct; // USES PayloadStruct
+  } // namespace storage
+} // namespace cencalvm
+
+/// C++ engine for merging a patch etree database into a base etree
+/// database.
+class cencalvm::average::PatchEngine
+{ // PatchEngine
+
+public :
+  // PUBLIC METHODS /////////////////////////////////////////////////////
+
+  /** Constructor
+   *
+   * @param dbOut Output database
+   * @param dbBase Base database
+   * @param dbPatch Patch database (leaf octants only)
+   * @param bufferSize Maximum number of octants in write-behind buffer
+   */
+  PatchEngine(etree_t* dbOut,
+	      etree_t* dbBase,
+	      etree_t* dbPatch,
+	      const int bufferSize);
+
+  /// Destructor
+  ~PatchEngine(void);
+
+  /// Merge octants of patch database into base database.
+  void mergeOctants(void);
+
+  /// Print octant counting information to stream.
+  void printOctantInfo(void) const;
+
+private :
+  // PRIVATE METHODS ////////////////////////////////////////////////////
+
+  PatchEngine(const PatchEngine& e); ///< Not implemented
+  const PatchEngine& operator=(const PatchEngine& e); ///< Not implemented
+
+private :
+  // PRIVATE STRUCTS ////////////////////////////////////////////////////
+
+  struct CounterStruct {
+    uint64_t patch; ///< Number of octants from patch
+    uint64_t copied; ///< Number of octants copied from base
+    uint64_t replaced; ///< Number of base octants replaced by patch
+    uint64_t averaged; ///< Number of base interior octants averaged again
+  }; // CounterStruct
+
+private :
+  // PRIVATE METHODS ////////////////////////////////////////////////////
+
+  /** Get octant at current cursor position.
+   *
+   * @param db Database
+   * @param pAddr Pointer to address of octant
+   * @param pPayload Pointer to payload of octant
+   */
+  void _getOctant(etree_t* db,
+		  etree_addr_t* pAddr,
+		  storage::PayloadStruct* pPayload);
+
+  /** Append octant that is final (leaf octant or root of subtree
+   * copied from base database) to merged database.
+   *
+   * @param pAddr Pointer to address of octant
+   * @param payload Payload of octant
+   */
+  void _addOctant(etree_addr_t* pAddr,
+		  const storage::PayloadStruct& payload);
+
+  /** Append descendant of subtree copied from base database to merged
+   * database.
+   *
+   * @param pAddr Pointer to address of octant
+   * @param payload Payload of octant
+   */
+  void _copyOctant(etree_addr_t* pAddr,
+		   const storage::PayloadStruct& payload);
+
+private :
+  // PRIVATE MEMBERS ////////////////////////////////////////////////////
+
+  etree_t* _dbOut; ///< Merged database
+  etree_t* _dbBase; ///< Base database
+  etree_t* _dbPatch; ///< Patch database
+
+  AvgEngine* _pAvgEngine; ///< Averaging engine (0 if base not averaged)
+  int _bufferSize; ///< Number of octants in write-behind buffer
+
+  CounterStruct _octantCounter;
+
+}; // PatchEngine
+
+#endif // cencalvm_average_patchengine_h
+
+// End of file
@@ -0,0 +1,160 @@
+// -*- C++ -*-
+//
+// ======================================================================
+//
+//                           Brad T. Aagaard
+//                        U.S. Geological Survey
+//
+// {LicenseText}
+//
+// ======================================================================
+//
+
+/** @file libsrc/average/Patcher.h
+ *
+ * @brief C++ manager for merging a patch etree database for a revised
+ * region into an etree database containing the USGS central CA
+ * velocity model.
+ *
+ * The patch database is created from the grids of the revised region
+ * with the same tools as the full model (without averaging). If the
+ * base database has been averaged, only the interior octants above
+ * the patched region are averaged again, so the merged database does
+ * not need to be averaged from scratch.
+ */
+
+#if !defined(cencalvm_average_patcher_h)
+#define cencalvm_average_patcher_h
+
+#include <string> // HASA std::string
+#include "cencalvm/storage/etreefwd.h" // HOLDSA etree_t
+#include "cencalvm/storage/CacheMonitor.h" // USES CacheMonitor::AUTOSIZE
+
+namespace cencalvm {
+  namespace average {
+    class Patcher;
+  } // namespace average
+} // namespace cencalvm
+
+/// C++ manager for merging a patch etree database into an etree
+/// database containing the USGS central CA velocity model
+class cencalvm::average::Patcher
+{ // Patcher
+
+public :
+  // PUBLIC METHODS /////////////////////////////////////////////////////
+
+  /// Constructor.
+  Patcher(void);
+
+  /// Destructor
+  ~Patcher(void);
+
+  /** Set filename of base database.
+   *
+   * @param filename Name of file
+   */
+  void filenameIn(const char* filename);
+
+  /** Set filename of patch database.
+   *
+   * @param filename Name of file
+   */
+  void filenamePatch(const char* filename);
+
+  /** Set filename of output (merged) database.
+   *
+   * @param filename Name of file
+   */
+  void filenameOut(const char* filename);
+
+  /** Set maximum number of octants held in the write-behind buffer
+   * while averaging.
+   *
+   * @param size Number of octants
+   */
+  void bufferSize(const int size);
+
+  /** Set size of etree cache of each database.
+   *
+   * With storage::CacheMonitor::AUTOSIZE the cache of each database
+   * is sized from the available memory and the size of the database
+   * (the base database for the output database; see
+   * storage::CacheMonitor::maxSize()) and the size chosen is
+   * reported. Default is 512 MB.
+   *
+   * @param size Size of cache in MB or storage::CacheMonitor::AUTOSIZE
+   */
+  void cacheSize(const int size);
+
+  /** Merge patch database into base database.
+   *
+   * Leaf octants in the patch replace the octants of the base
+   * database at the same location and any of their descendants. A
+   * patch octant may not be smaller than the leaf octant of the base
+   * database it falls within.
+   */
+  void patch(void);
+
+  /** Set flag indicating patching should be quiet (no progress reports).
+   *
+   * Default behavior is for to give progress reports.
+   *
+   * @param flag True for quiet operation, false to give progress reports
+   */
+  void quiet(const bool flag);
+
+private :
+  // PRIVATE METHODS ////////////////////////////////////////////////////
+
+  Patcher(const Patcher& p); ///< Not implemented
+  const Patcher& operator=(const Patcher& p); ///< Not implemented
+  
+private :
+  // PRIVATE METHODS ////////////////////////////////////////////////////
+
+  /** Open existing database and check its compatibility.
+   *
+   * @param filename Name of database file
+   * @param description Description of database used in error messages
+   *
+   * @returns Database
+   */
+  etree_t* _openDB(const std::string& filename,
+		   const char* description) const;
+
+  /** Choose size of etree cache of database.
+   *
+   * @param filename Name of database used to size automatic cache
+   * @param description Description of database used in progress report
+   *
+   * @returns Size of cache in MB
+   */
+  int _chooseCacheSize(const char* filename,
+		       const char* description) const;
+
+private :
+  // PRIVATE MEMBERS ////////////////////////////////////////////////////
+
+  etree_t* _dbIn; ///< Base database
+  etree_t* _dbPatch; ///< Patch database
+  etree_t* _dbOut; ///< Merged database
+
+  std::string _filenameIn; ///< Filename of base database
+  std::string _filenamePatch; ///< Filename of patch database
+  std::string _filenameOut; ///< Filename of output database
+
+  int _bufferSize; ///< Number of octants in write-behind buffer
+  int _cacheSize; ///< Size of etree cache in MB (or AUTOSIZE)
+  
+  bool _quiet; ///< Flag to eliminate progress reports
+
+  static const double _AUTOFRACTION; ///< Fraction of memory for each cache
+
+}; // Patcher
+
+#include "Patcher.icc" // inline methods
+
+#endif // cencalvm_average_patcher_h
+
+// End of file 
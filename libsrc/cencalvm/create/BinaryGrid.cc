@@ -0,0 +1,134 @@
+// -*- C++ -*-
+//
+// ======================================================================
+//
+//                           Brad T. Aagaard
+//                        U.S. Geological Survey
+//
+// {LicenseText}
+//
+// ======================================================================
+//
+
+#include "BinaryGrid.h" // implementation of class methods
+
+#include <fstream> // USES std::ifstream
+#include <stdio.h> // USES fopen(), fwrite(), fclose()
+#include <string.h> // USES memcmp(), memcpy(), memset()
+
+#include <stdexcept> // USES std::runtime_error
+#include <sstream> // USES std::ostringstream
+#include <assert.h> // USES assert()
+
+// ----------------------------------------------------------------------
+const char* cencalvm::create::BinaryGrid::MAGIC = "CVMGRID";
+const int32_t cencalvm::create::BinaryGrid::VERSION = 1;
+const int32_t cencalvm::create::BinaryGrid::BYTEORDER = 0x01020304;
+
+// ----------------------------------------------------------------------
+// Get header of binary grid held in memory.
+const cencalvm::create::BinaryGridHeaderStruct*
+cencalvm::create::BinaryGrid::header(const char* pData,
+				     const size_t size)
+{ // header
+  const size_t magicSize = sizeof(BinaryGridHeaderStruct().magic);
+  if (0 == pData || size < sizeof(BinaryGridHeaderStruct) ||
+      0 != memcmp(pData, MAGIC, magicSize))
+    return 0;
+
+  const BinaryGridHeaderStruct* pHeader =
+    (const BinaryGridHeaderStruct*) pData;
+  if (BYTEORDER != pHeader->byteOrder)
+    throw std::runtime_error("Binary grid was written on a machine with "
+			     "a different byte order.");
+  if (VERSION != pHeader->version) {
+    std::ostringstream msg;
+    msg << "Unknown version " << pHeader->version
+	<< " of binary grid format. Expected version " << VERSION << ".";
+    throw std::runtime_error(msg.str());
+  } // if
+
+  return pHeader;
+} // header
+
+// ----------------------------------------------------------------------
+// Convert ASCII grid file to binary grid file.
+void
+cencalvm::create::BinaryGrid::convert(const char* filenameIn,
+				      const char* filenameOut)
+{ // convert
+  assert(0 != filenameIn);
+  assert(0 != filenameOut);
+
+  std::ifstream fin(filenameIn);
+  if (!fin.is_open()) {
+    std::ostringstream msg;
+    msg << "Could not open grid file '" << filenameIn << "' for reading.";
+    throw std::runtime_error(msg.str());
+  } // if
+
+  BinaryGridHeaderStruct header;
+  memset(&header, 0, sizeof(header));
+  memcpy(header.magic, MAGIC, sizeof(header.magic));
+  header.version = VERSION;
+  header.byteOrder = BYTEORDER;
+  fin >> header.resHoriz >> header.resVert
+      >> header.numX >> header.numY >> header.numZ >> header.numTotal;
+  if (fin.fail()) {
+    std::ostringstream msg;
+    msg << "Could not read header of grid file '" << filenameIn << "'.";
+    throw std::runtime_error(msg.str());
+  } // if
+
+  FILE* fout = fopen(filenameOut, "wb");
+  if (0 == fout) {
+    std::ostringstream msg;
+    msg << "Could not open binary grid file '" << filenameOut
+	<< "' for writing.";
+    throw std::runtime_error(msg.str());
+  } // if
+  bool writeError = (1 != fwrite(&header, sizeof(header), 1, fout));
+
+  const int bufferSize = 4096;
+  BinaryGridRecordStruct* pBuffer = new BinaryGridRecordStruct[bufferSize];
+  memset(pBuffer, 0, bufferSize*sizeof(BinaryGridRecordStruct));
+  int numBuffered = 0;
+  int numRead = 0;
+  for (numRead=0; numRead < header.numTotal && !writeError; ++numRead) {
+    BinaryGridRecordStruct& record = pBuffer[numBuffered];
+    fin
+      >> record.lon >> record.lat >> record.elev
+      >> record.vp >> record.vs >> record.density
+      >> record.qp >> record.qs >> record.depthFreeSurf
+      >> record.faultBlock >> record.zone >> record.volID;
+    if (fin.fail())
+      break;
+    if (++numBuffered == bufferSize) {
+      writeError =
+	(size_t(numBuffered) != fwrite(pBuffer, sizeof(BinaryGridRecordStruct),
+				       numBuffered, fout));
+      numBuffered = 0;
+    } // if
+  } // for
+  if (numBuffered > 0 && !writeError)
+    writeError =
+      (size_t(numBuffered) != fwrite(pBuffer, sizeof(BinaryGridRecordStruct),
+				     numBuffered, fout));
+  delete[] pBuffer; pBuffer = 0;
+  writeError = (0 != fclose(fout)) || writeError;
+  fin.close();
+
+  if (writeError) {
+    std::ostringstream msg;
+    msg << "Error while writing binary grid file '" << filenameOut << "'.";
+    throw std::runtime_error(msg.str());
+  } // if
+  if (numRead != header.numTotal) {
+    std::ostringstream msg;
+    msg << "Could not parse point " << numRead << " in grid file '"
+	<< filenameIn << "'. Expected " << header.numTotal << " points.";
+    throw std::runtime_error(msg.str());
+  } // if
+} // convert
+
+// End of file
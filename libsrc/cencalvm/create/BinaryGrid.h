@@ -0,0 +1,117 @@
+// -*- C++ -*-
+//
+// ======================================================================
+//
+//                           Brad T. Aagaard
+//                        U.S. Geological Survey
+//
+// {LicenseText}
+//
+// ======================================================================
+//
+
+/** @file libsrc/create/BinaryGrid.h
+ *
+ * @brief C++ manager of the binary input grid format.
+ *
+ * A binary grid file holds the same information as an ASCII grid
+ * file in the same units (km, km/s, g/cm^3). The file starts with a
+ * BinaryGridHeaderStruct followed by numTotal packed
+ * BinaryGridRecordStruct records. Values are stored in the byte order
+ * of the machine that wrote the file; the header contains a byte
+ * order mark so that files written on a machine with a different byte
+ * order are rejected.
+ *
+ * The header and records are laid out so that they can be accessed
+ * directly in a memory mapped file.
+ */
+
+#if !defined(cencalvm_create_binarygrid_h)
+#define cencalvm_create_binarygrid_h
+
+#include <inttypes.h> // USES int32_t, int16_t
+#include <sys/types.h> // USES size_t
+
+namespace cencalvm {
+  namespace create {
+    struct BinaryGridHeaderStruct;
+    struct BinaryGridRecordStruct;
+    class BinaryGrid;
+    class TestBinaryGrid; // friend
+  } // namespace create
+} // namespace cencalvm
+
+/// Header of binary grid file.
+struct cencalvm::create::BinaryGridHeaderStruct {
+  char magic[8]; ///< File identifier (BinaryGrid::MAGIC)
+  int32_t version; ///< Version of file format
+  int32_t byteOrder; ///< Byte order mark (BinaryGrid::BYTEORDER)
+  double resHoriz; ///< Horizontal resolution in km
+  double resVert; ///< Vertical resolution in km
+  int32_t numX; ///< Number of points in x direction
+  int32_t numY; ///< Number of points in y direction
+  int32_t numZ; ///< Number of points in z direction
+  int32_t numTotal; ///< Total number of points (records) in file
+}; // BinaryGridHeaderStruct
+
+/// Point in binary grid file.
+struct cencalvm::create::BinaryGridRecordStruct {
+  double lon; ///< Longitude in degrees
+  double lat; ///< Latitude in degrees
+  double elev; ///< Elevation in km
+  float vp; ///< P wave speed in km/s
+  float vs; ///< S wave speed in km/s
+  float density; ///< Density in g/cm^3
+  float qp; ///< Q for P waves
+  float qs; ///< Q for S waves
+  float depthFreeSurf; ///< Depth wrt free surface in km
+  int16_t faultBlock; ///< Fault block identifier
+  int16_t zone; ///< Zone identifier
+  int32_t volID; ///< Volume identifier
+}; // BinaryGridRecordStruct
+
+/// C++ manager of the binary input grid format.
+class cencalvm::create::BinaryGrid
+{ // BinaryGrid
+  friend class TestBinaryGrid;
+
+public :
+  // PUBLIC METHODS /////////////////////////////////////////////////////
+
+  /** Get header of binary grid held in memory.
+   *
+   * @param pData Pointer to contents of file
+   * @param size Size of contents in bytes
+   *
+   * @returns Pointer to header if contents are a binary grid, 0 otherwise
+   */
+  static const BinaryGridHeaderStruct* header(const char* pData,
+					      const size_t size);
+
+  /** Convert ASCII grid file to binary grid file.
+   *
+   * @param filenameIn Name of ASCII grid file
+   * @param filenameOut Name of binary grid file
+   */
+  static void convert(const char* filenameIn,
+		      const char* filenameOut);
+
+public :
+  // PUBLIC MEMBERS /////////////////////////////////////////////////////
+
+  static const char* MAGIC; ///< File identifier
+  static const int32_t VERSION; ///< Current version of file format
+  static const int32_t BYTEORDER; ///< Byte order mark
+
+private :
+  // NOT IMPLEMENTED ////////////////////////////////////////////////////
+
+  BinaryGrid(void); ///< Not implemented
+  BinaryGrid(const BinaryGrid& g); ///< Not implemented
+  const BinaryGrid& operator=(const BinaryGrid& g); ///< Not implemented
+
+}; // BinaryGrid
+
+#endif // cencalvm_create_binarygrid_h
+
+// End of file
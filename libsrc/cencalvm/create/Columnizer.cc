@@ -0,0 +1,202 @@
+// -*- C++ -*-
+//
+// ======================================================================
+//
+//                           Brad T. Aagaard
+//                        U.S. Geological Survey
+//
+// {LicenseText}
+//
+// ======================================================================
+//
+
+#include "Columnizer.h" // implementation of class methods
+
+#include "cencalvm/storage/ColumnDB.h" // USES ColumnDB
+#include "cencalvm/storage/Payload.h" // USES PayloadStruct
+
+extern "C" {
+#include "etree.h"
+}
+
+#include <stdio.h> // USES fopen(), fwrite(), fclose()
+#include <stdlib.h> // USES free()
+#include <string.h> // USES memset(), memcpy(), strcmp()
+#include <time.h> // USES time_t
+#include <unistd.h> // USES gethostname()
+#include <iostream> // USES std::cout
+#include <vector> // USES std::vector
+
+#include <stdexcept> // USES std::runtime_error
+#include <sstream> // USES std::ostringstream
+#include <assert.h> // USES assert()
+
+// ----------------------------------------------------------------------
+// Constructor
+cencalvm::create::Columnizer::Columnizer(void) :
+  _filenameIn(""),
+  _filenameOut(""),
+  _cacheSize(64),
+  _quiet(false)
+{ // constructor
+} // constructor
+
+// ----------------------------------------------------------------------
+// Destructor
+cencalvm::create::Columnizer::~Columnizer(void)
+{ // destructor
+} // destructor
+
+// ----------------------------------------------------------------------
+// Convert database to column-split database.
+void
+cencalvm::create::Columnizer::columnize(void)
+{ // columnize
+  typedef storage::ColumnDB ColumnDB;
+
+  if (!_quiet)
+    std::cout
+      << "Splitting etree database '" << _filenameIn
+      << "' into column-split etree database '" << _filenameOut << "'."
+      << std::endl;
+
+  etree_t* dbIn = etree_open(_filenameIn.c_str(), O_RDONLY, _cacheSize, 0, 0);
+  if (0 == dbIn) {
+    std::ostringstream msg;
+    msg
+      << "Could not open etree database '" << _filenameIn
+      << "' for splitting into columns.";
+    throw std::runtime_error(msg.str());
+  } // if
+
+  char* schemaIn = etree_getschema(dbIn);
+  const std::string schema = (0 != schemaIn) ? schemaIn : "";
+  free(schemaIn);
+  if (schema != storage::Payload::SCHEMA ||
+      sizeof(storage::PayloadStruct) != etree_getpayloadsize(dbIn)) {
+    etree_close(dbIn);
+    std::ostringstream msg;
+    msg
+      << "Etree database '" << _filenameIn << "' does not use the full "
+      << "payload. Only databases with full payloads can be split into "
+      << "columns.";
+    throw std::runtime_error(msg.str());
+  } // if
+
+  const int maxLen = 128;
+  char hostname[maxLen];
+  gethostname(hostname, maxLen);
+  time_t rawTime = time(0);
+  const char* datetime = ctime(&rawTime);
+  std::ostringstream metainfo;
+  char* appmetaIn = etree_getappmeta(dbIn);
+  if (0 != appmetaIn)
+    metainfo << appmetaIn << "\n";
+  free(appmetaIn);
+  metainfo
+    << "split into columns from '" << _filenameIn << "' on: " << datetime
+    << "host: " << hostname;
+  const std::string appmeta = metainfo.str();
+
+  // Keys start at multiple of size of key after header, schema, and
+  // metadata, so that they are aligned when the file is mapped.
+  const int64_t keySize = sizeof(storage::ColumnDBKeyStruct);
+  const int64_t metaEnd =
+    sizeof(storage::ColumnDBHeaderStruct) + schema.length() + appmeta.length();
+  const int64_t keysOffset = keySize * ((metaEnd + keySize - 1) / keySize);
+
+  FILE* fout = fopen(_filenameOut.c_str(), "wb");
+  std::vector<FILE*> fcolumns(ColumnDB::NUMCOLUMNS, (FILE*) 0);
+  bool openError = (0 == fout);
+  for (int i=0; i < ColumnDB::NUMCOLUMNS && !openError; ++i) {
+    const std::string filename =
+      ColumnDB::columnFilename(_filenameOut.c_str(), i);
+    fcolumns[i] = fopen(filename.c_str(), "wb");
+    openError = (0 == fcolumns[i]);
+  } // for
+  if (openError) {
+    etree_close(dbIn);
+    if (0 != fout)
+      fclose(fout);
+    for (int i=0; i < ColumnDB::NUMCOLUMNS; ++i)
+      if (0 != fcolumns[i])
+	fclose(fcolumns[i]);
+    std::ostringstream msg;
+    msg
+      << "Could not open column-split etree database '" << _filenameOut
+      << "' for writing.";
+    throw std::runtime_error(msg.str());
+  } // if
+
+  storage::ColumnDBHeaderStruct header;
+  memset(&header, 0, sizeof(header));
+  memcpy(header.magic, ColumnDB::MAGIC, sizeof(header.magic));
+  header.version = ColumnDB::VERSION;
+  header.byteOrder = ColumnDB::BYTEORDER;
+  header.keysOffset = keysOffset;
+  header.schemaLength = schema.length();
+  header.appmetaLength = appmeta.length();
+  const std::string padding(keysOffset - metaEnd, '\0');
+  bool writeError =
+    (1 != fwrite(&header, sizeof(header), 1, fout)) ||
+    (schema.length() != fwrite(schema.data(), 1, schema.length(), fout)) ||
+    (appmeta.length() != fwrite(appmeta.data(), 1, appmeta.length(), fout)) ||
+    (padding.length() != fwrite(padding.data(), 1, padding.length(), fout));
+
+  int64_t numOctants = 0;
+  etree_addr_t addr;
+  addr.x = 0;
+  addr.y = 0;
+  addr.z = 0;
+  addr.t = 0;
+  addr.level = ETREE_MAXLEVEL;
+  bool more = (0 == etree_initcursor(dbIn, addr));
+  while (more) {
+    storage::PayloadStruct payload;
+    if (0 != etree_getcursor(dbIn, &addr, "*", &payload))
+      throw std::runtime_error(etree_strerror(etree_errno(dbIn)));
+
+    storage::ColumnDBKeyStruct key;
+    key.x = addr.x;
+    key.y = addr.y;
+    key.z = addr.z;
+    key.level = addr.level;
+    key.type = addr.type;
+    writeError = writeError || (1 != fwrite(&key, sizeof(key), 1, fout));
+
+    const float* pFloats = &payload.Vp;
+    for (int i=0; i < 6; ++i)
+      writeError = writeError ||
+	(1 != fwrite(&pFloats[i], sizeof(float), 1, fcolumns[i]));
+    writeError = writeError ||
+      (1 != fwrite(&payload.FaultBlock, sizeof(int16_t), 1, fcolumns[6])) ||
+      (1 != fwrite(&payload.Zone, sizeof(int16_t), 1, fcolumns[7]));
+
+    ++numOctants;
+    more = (0 == etree_advcursor(dbIn));
+  } // while
+
+  if (0 != etree_close(dbIn))
+    throw std::runtime_error(etree_strerror(etree_errno(dbIn)));
+
+  header.numOctants = numOctants;
+  writeError = writeError ||
+    0 != fseek(fout, 0, SEEK_SET) ||
+    1 != fwrite(&header, sizeof(header), 1, fout);
+  writeError = (0 != fclose(fout)) || writeError;
+  for (int i=0; i < ColumnDB::NUMCOLUMNS; ++i)
+    writeError = (0 != fclose(fcolumns[i])) || writeError;
+  if (writeError) {
+    std::ostringstream msg;
+    msg << "Error while writing column-split etree database '"
+	<< _filenameOut << "'.";
+    throw std::runtime_error(msg.str());
+  } // if
+
+  if (!_quiet)
+    std::cout
+      << "Done splitting etree database.\n"
+      << "Number of octants: " << numOctants << std::endl;
+} // columnize
+
+// End of file
@@ -0,0 +1,105 @@
+// -*- C++ -*-
+//
+// ======================================================================
+//
+//                           Brad T. Aagaard
+//                        U.S. Geological Survey
+//
+// {LicenseText}
+//
+// ======================================================================
+//
+
+/** @file libsrc/create/Columnizer.h
+ *
+ * @brief C++ object for converting a packed etree database to a
+ * read-only column-split database.
+ *
+ * The octants of the input database are streamed with a cursor in
+ * Morton pre-order and their addresses and payload fields are written
+ * to separate files (see storage::ColumnDB). The column-split database
+ * can be queried with VMQuery in place of the etree database.
+ */
+
+#if !defined(cencalvm_create_columnizer_h)
+#define cencalvm_create_columnizer_h
+
+#include <string> // HASA std::string
+
+namespace cencalvm {
+  namespace create {
+    class Columnizer;
+    class TestColumnizer; // friend
+  } // namespace create
+} // namespace cencalvm
+
+/// C++ object for converting a packed etree database to a read-only
+/// column-split database.
+class cencalvm::create::Columnizer
+{ // Columnizer
+  friend class TestColumnizer;
+
+public :
+  // PUBLIC METHODS /////////////////////////////////////////////////////
+
+  /// Constructor
+  Columnizer(void);
+
+  /// Destructor
+  ~Columnizer(void);
+
+  /** Set filename of input (etree) database.
+   *
+   * @param filename Name of file
+   */
+  void filenameIn(const char* filename);
+
+  /** Set filename of output (column-split) database. This is the
+   * name of the key file; value files are named by appending the name
+   * of the payload field.
+   *
+   * @param filename Name of file
+   */
+  void filenameOut(const char* filename);
+
+  /** Set database cache size.
+   *
+   * @param size Size of cache in MB
+   */
+  void cacheSize(const int size);
+
+  /// Convert database to column-split database.
+  void columnize(void);
+
+  /** Set flag indicating conversion should be quiet (no progress
+   * reports).
+   *
+   * Default behavior is for to give progress reports.
+   *
+   * @param flag True for quiet operation, false to give progress reports
+   */
+  void quiet(const bool flag);
+
+private :
+  // NOT IMPLEMENTED ////////////////////////////////////////////////////
+
+  Columnizer(const Columnizer& c); ///< Not implemented
+  const Columnizer& operator=(const Columnizer& c); ///< Not implemented
+
+private :
+  // PRIVATE MEMBERS ////////////////////////////////////////////////////
+
+  std::string _filenameIn; ///< Filename of input database
+  std::string _filenameOut; ///< Filename of output database
+
+  int _cacheSize; ///< Size of database cache in MB
+
+  bool _quiet; ///< Flag to eliminate progress reports
+
+}; // Columnizer
+
+#include "Columnizer.icc" // inline methods
+
+#endif // cencalvm_create_columnizer_h
+
+// End of file
@@ -0,0 +1,634 @@
+// -*- C++ -*-
+//
+// ======================================================================
+//
+//                           Brad T. Aagaard
+//                        U.S. Geological Survey
+//
+// {LicenseText}
+//
+// ======================================================================
+//
+
+#include "Compactor.h" // implementation of class methods
+
+#include "cencalvm/storage/Geometry.h" // USES Geometry
+#include "cencalvm/storage/GeomCenCA.h" // USES GeomCenCA
+#include "cencalvm/storage/PayloadCodec.h" // HASA PayloadCodec
+
+extern "C" {
+#include "etree.h"
+}
+
+#include <stdlib.h> // USES free()
+#include <stdio.h> // USES remove()
+#include <stddef.h> // USES offsetof()
+#include <string.h> // USES memcpy(), memcmp()
+#include <math.h> // USES fabs()
+#include <float.h> // USES FLT_EPSILON
+#include <time.h> // USES time_t
+#include <unistd.h> // USES gethostname()
+#include <iostream> // USES std::cout
+
+#include <stdexcept> // USES std::runtime_error
+#include <sstream> // USES std::ostringstream
+#include <assert.h> // USES assert()
+
+// ----------------------------------------------------------------------
+// Constructor
+cencalvm::create::Compactor::Compactor(void) :
+  _filenameIn(""),
+  _filenameOut(""),
+  _cacheSize(64),
+  _payloadSize(0),
+  _dbSearch(0),
+  _pGeom(new storage::GeomCenCA),
+  _pCodec(new storage::PayloadCodec),
+  _isCompact(false),
+  _depthError(0.0),
+  _quiet(false)
+{ // constructor
+} // constructor
+
+// ----------------------------------------------------------------------
+// Destructor
+cencalvm::create::Compactor::~Compactor(void)
+{ // destructor
+  delete _pGeom; _pGeom = 0;
+  delete _pCodec; _pCodec = 0;
+} // destructor
+
+// ----------------------------------------------------------------------
+// Set geometry of velocity model.
+void
+cencalvm::create::Compactor::geometry(const storage::Geometry* pGeom)
+{ // geometry
+  delete _pGeom; _pGeom = (0 != pGeom) ? pGeom->clone() : 0;
+} // geometry
+
+// ----------------------------------------------------------------------
+// Collapse homogeneous subtrees of database.
+void
+cencalvm::create::Compactor::compact(void)
+{ // compact
+  if (0 == _pGeom)
+    throw std::runtime_error("Geometry of velocity model must be set "
+			     "before compaction.");
+
+  if (!_quiet)
+    std::cout
+      << "Compacting etree database '" << _filenameIn
+      << "' to etree database '" << _filenameOut << "'."
+      << std::endl;
+
+  etree_t* dbIn = etree_open(_filenameIn.c_str(), O_RDONLY, _cacheSize, 0, 0);
+  if (0 == dbIn) {
+    std::ostringstream msg;
+    msg
+      << "Could not open etree database '" << _filenameIn
+      << "' for compaction.";
+    throw std::runtime_error(msg.str());
+  } // if
+
+  // Payloads are compared byte for byte, except for the depth of the
+  // free surface, so only the depth in compact payloads is decoded.
+  char* schemaIn = etree_getschema(dbIn);
+  const std::string schema = (0 != schemaIn) ? schemaIn : "";
+  free(schemaIn);
+  if (schema != storage::Payload::SCHEMA &&
+      schema != storage::Payload::SCHEMACOMPACT) {
+    etree_close(dbIn);
+    std::ostringstream msg;
+    msg
+      << "Etree database '" << _filenameIn << "' does not use the full "
+      << "or compact payload.";
+    throw std::runtime_error(msg.str());
+  } // if
+  _payloadSize = etree_getpayloadsize(dbIn);
+  assert(_payloadSize <= int(sizeof(storage::PayloadStruct)));
+  _isCompact = (schema == storage::Payload::SCHEMACOMPACT);
+  _depthError = 0.0;
+  if (_isCompact) {
+    char* appmetaIn = etree_getappmeta(dbIn);
+    try {
+      _pCodec->parseMetadata(appmetaIn);
+    } catch (...) {
+      free(appmetaIn);
+      etree_close(dbIn);
+      throw;
+    } // try/catch
+    free(appmetaIn);
+    _depthError = _pCodec->errorBound("DepthFreeSurf");
+  } // if
+
+  // First pass: find largest homogeneous subtrees. Searches at the
+  // free surface use a separate handle, so they do not disturb the
+  // cursor.
+  _dbSearch = etree_open(_filenameIn.c_str(), O_RDONLY, _cacheSize, 0, 0);
+  if (0 == _dbSearch) {
+    etree_close(dbIn);
+    std::ostringstream msg;
+    msg
+      << "Could not open etree database '" << _filenameIn
+      << "' for compaction.";
+    throw std::runtime_error(msg.str());
+  } // if
+  try {
+    _findCollapsed(dbIn);
+  } catch (...) {
+    etree_close(_dbSearch); _dbSearch = 0;
+    etree_close(dbIn);
+    throw;
+  } // try/catch
+  etree_close(_dbSearch); _dbSearch = 0;
+
+  const int numDims = 3;
+  etree_t* dbOut = etree_open(_filenameOut.c_str(), O_CREAT|O_TRUNC|O_RDWR,
+			      _cacheSize, _payloadSize, numDims);
+  if (0 == dbOut) {
+    etree_close(dbIn);
+    std::ostringstream msg;
+    msg
+      << "Could not open etree database '" << _filenameOut
+      << "' for output of compacted database.";
+    throw std::runtime_error(msg.str());
+  } // if
+
+  // Close both databases and remove partial output on failure.
+  const int numCollapsed = _collapsed.size();
+  long numOctantsIn = 0;
+  long numOctantsOut = 0;
+  try {
+    if (0 != etree_registerschema(dbOut, schema.c_str()))
+      throw std::runtime_error(etree_strerror(etree_errno(dbOut)));
+
+    // Keep metadata of input database (including quantization
+    // parameters of compact payloads) and flag database as compacted.
+    const int maxLen = 128;
+    char hostname[maxLen];
+    gethostname(hostname, maxLen);
+    time_t rawTime = time(0);
+    const char* datetime = ctime(&rawTime);
+    std::ostringstream metainfo;
+    char* appmeta = etree_getappmeta(dbIn);
+    if (0 != appmeta)
+      metainfo << appmeta << "\n";
+    free(appmeta);
+    metainfo
+      << storage::Payload::COMPACTEDTAG << " of '" << _filenameIn
+      << "' on: " << datetime
+      << "host: " << hostname;
+    if (0 != etree_setappmeta(dbOut, metainfo.str().c_str()))
+      throw std::runtime_error(etree_strerror(etree_errno(dbOut)));
+
+    // Second pass: append octants, replacing each homogeneous subtree
+    // with a leaf octant at the level of its root.
+    etree_addr_t addr;
+    addr.x = 0;
+    addr.y = 0;
+    addr.z = 0;
+    addr.t = 0;
+    addr.level = ETREE_MAXLEVEL;
+    if (0 != etree_beginappend(dbOut, 1))
+      throw std::runtime_error(etree_strerror(etree_errno(dbOut)));
+
+    int iCollapsed = 0;
+    bool isAppended = false;
+    etree_addr_t rootAddr;
+    rootAddr.t = 0;
+    rootAddr.type = ETREE_LEAF;
+    bool more = (0 == etree_initcursor(dbIn, addr));
+    while (more) {
+      storage::PayloadStruct payload;
+      if (0 != etree_getcursor(dbIn, &addr, "*", &payload))
+	throw std::runtime_error(etree_strerror(etree_errno(dbIn)));
+      ++numOctantsIn;
+
+      // Skip over collapsed subtrees that come before octant.
+      while (iCollapsed < numCollapsed) {
+	const CollapsedStruct& collapsed = _collapsed[iCollapsed];
+	rootAddr.x = collapsed.x;
+	rootAddr.y = collapsed.y;
+	rootAddr.z = collapsed.z;
+	rootAddr.level = collapsed.level;
+	if (storage::Geometry::contains(rootAddr, addr) ||
+	    !storage::Geometry::precedes(rootAddr, addr))
+	  break;
+	++iCollapsed;
+	isAppended = false;
+      } // while
+
+      if (iCollapsed < numCollapsed &&
+	  storage::Geometry::contains(rootAddr, addr)) {
+	if (!isAppended) {
+	  if (0 != etree_append(dbOut, rootAddr,
+				&_collapsed[iCollapsed].payload))
+	    throw std::runtime_error(etree_strerror(etree_errno(dbOut)));
+	  isAppended = true;
+	  ++numOctantsOut;
+	} // if
+      } else {
+	if (0 != etree_append(dbOut, addr, &payload))
+	  throw std::runtime_error(etree_strerror(etree_errno(dbOut)));
+	++numOctantsOut;
+      } // if/else
+      more = (0 == etree_advcursor(dbIn));
+    } // while
+
+    if (0 != etree_endappend(dbOut))
+      throw std::runtime_error(etree_strerror(etree_errno(dbOut)));
+  } catch (...) {
+    etree_close(dbOut);
+    etree_close(dbIn);
+    remove(_filenameOut.c_str());
+    throw;
+  } // try/catch
+
+  if (0 != etree_close(dbIn))
+    throw std::runtime_error(etree_strerror(etree_errno(dbIn)));
+
+  if (0 != etree_close(dbOut))
+    throw std::runtime_error(etree_strerror(etree_errno(dbOut)));
+
+  if (!_quiet)
+    std::cout
+      << "Done compacting etree database.\n"
+      << "Number of homogeneous subtrees collapsed: " << numCollapsed << "\n"
+      << "Number of octants reduced from " << numOctantsIn << " to "
+      << numOctantsOut << "." << std::endl;
+} // compact
+
+// ----------------------------------------------------------------------
+// Find largest homogeneous subtrees.
+void
+cencalvm::create::Compactor::_findCollapsed(etree_t* db)
+{ // _findCollapsed
+  assert(0 != db);
+
+  _collapsed.clear();
+  _subtrees.resize(ETREE_MAXLEVEL+1);
+  for (int level=0; level <= ETREE_MAXLEVEL; ++level)
+    _subtrees[level].isOpen = false;
+
+  etree_addr_t addr;
+  addr.x = 0;
+  addr.y = 0;
+  addr.z = 0;
+  addr.t = 0;
+  addr.level = ETREE_MAXLEVEL;
+
+  etree_addr_t ancestorAddr;
+  bool more = (0 == etree_initcursor(db, addr));
+  while (more) {
+    storage::PayloadStruct payload;
+    if (0 != etree_getcursor(db, &addr, "*", &payload))
+      throw std::runtime_error(etree_strerror(etree_errno(db)));
+
+    // Find coarsest level where current path leaves ancestors of
+    // octant and close subtrees at or below that level.
+    int level = 0;
+    for (; level < addr.level; ++level) {
+      const SubtreeStruct& subtree = _subtrees[level];
+      if (!subtree.isOpen)
+	break;
+      storage::Geometry::findAncestor(&ancestorAddr, addr, level);
+      if (ancestorAddr.x != subtree.x ||
+	  ancestorAddr.y != subtree.y ||
+	  ancestorAddr.z != subtree.z)
+	break;
+    } // for
+    _closeSubtrees(level);
+
+    // Open subtrees of ancestors not on current path. Ancestors
+    // without interior octants (for example, before averaging) are
+    // treated as if they were present.
+    for (; level <= addr.level; ++level) {
+      if (level == addr.level && ETREE_LEAF == addr.type)
+	break;
+      SubtreeStruct& subtree = _subtrees[level];
+      if (level < addr.level) {
+	storage::Geometry::findAncestor(&ancestorAddr, addr, level);
+	subtree.x = ancestorAddr.x;
+	subtree.y = ancestorAddr.y;
+	subtree.z = ancestorAddr.z;
+      } else {
+	subtree.x = addr.x;
+	subtree.y = addr.y;
+	subtree.z = addr.z;
+      } // if/else
+      subtree.numFilled = 0;
+      subtree.isOpen = true;
+      subtree.isUniform = true;
+      subtree.hasPayload = false;
+      subtree.elevSurfMin = 0.0;
+      subtree.elevSurfMax = 0.0;
+      subtree.elevSurfError = 0.0;
+    } // for
+
+    if (ETREE_LEAF == addr.type && addr.level > 0) {
+      double elevSurfMin = 0.0;
+      double elevSurfMax = 0.0;
+      _surfaceRange(&elevSurfMin, &elevSurfMax, addr, payload);
+      _addChild(addr.level-1, true, true, payload, elevSurfMin, elevSurfMax,
+		0.5*(elevSurfMax - elevSurfMin));
+    } // if
+
+    more = (0 == etree_advcursor(db));
+  } // while
+  _closeSubtrees(0);
+} // _findCollapsed
+
+// ----------------------------------------------------------------------
+// Close subtrees of octants on current path at or below level.
+void
+cencalvm::create::Compactor::_closeSubtrees(const int level)
+{ // _closeSubtrees
+  for (int iLevel=ETREE_MAXLEVEL; iLevel >= level; --iLevel) {
+    SubtreeStruct& subtree = _subtrees[iLevel];
+    if (!subtree.isOpen)
+      continue;
+    subtree.isOpen = false;
+
+    const int numChildren = 8;
+    const bool isFilled = (numChildren == subtree.numFilled);
+    const bool isUniform = isFilled && subtree.isUniform &&
+      subtree.hasPayload && _surfaceInData(subtree, iLevel);
+    if (isUniform) {
+      // Subtree replaces collapsed subtrees it contains, which are at
+      // the end of the list because octants are in pre-order.
+      etree_addr_t rootAddr;
+      rootAddr.x = subtree.x;
+      rootAddr.y = subtree.y;
+      rootAddr.z = subtree.z;
+      rootAddr.t = 0;
+      rootAddr.level = iLevel;
+      rootAddr.type = ETREE_LEAF;
+      while (!_collapsed.empty()) {
+	const CollapsedStruct& last = _collapsed.back();
+	etree_addr_t lastAddr;
+	lastAddr.x = last.x;
+	lastAddr.y = last.y;
+	lastAddr.z = last.z;
+	lastAddr.t = 0;
+	lastAddr.level = last.level;
+	lastAddr.type = ETREE_LEAF;
+	if (!storage::Geometry::contains(rootAddr, lastAddr))
+	  break;
+	_collapsed.pop_back();
+      } // while
+
+      CollapsedStruct collapsed;
+      collapsed.x = subtree.x;
+      collapsed.y = subtree.y;
+      collapsed.z = subtree.z;
+      collapsed.level = iLevel;
+      memcpy(&collapsed.payload, &subtree.payload, sizeof(collapsed.payload));
+      _recenterDepth(&collapsed.payload, rootAddr,
+		     0.5*(subtree.elevSurfMin + subtree.elevSurfMax));
+      _collapsed.push_back(collapsed);
+    } // if
+
+    if (iLevel > 0)
+      _addChild(iLevel-1, isFilled, isUniform, subtree.payload,
+		subtree.elevSurfMin, subtree.elevSurfMax, subtree.elevSurfError);
+  } // for
+} // _closeSubtrees
+
+// ----------------------------------------------------------------------
+// Add child to subtree of octant on current path.
+void
+cencalvm::create::Compactor::_addChild(const int level,
+				       const bool isFilled,
+				       const bool isUniform,
+				       const storage::PayloadStruct& payload,
+				       const double elevSurfMin,
+				       const double elevSurfMax,
+				       const double elevSurfError)
+{ // _addChild
+  assert(0 <= level && level <= ETREE_MAXLEVEL);
+
+  SubtreeStruct& subtree = _subtrees[level];
+  assert(subtree.isOpen);
+
+  if (isFilled)
+    ++subtree.numFilled;
+  if (!isUniform)
+    subtree.isUniform = false;
+  else if (!subtree.hasPayload) {
+    memcpy(&subtree.payload, &payload, sizeof(subtree.payload));
+    subtree.elevSurfMin = elevSurfMin;
+    subtree.elevSurfMax = elevSurfMax;
+    subtree.elevSurfError = elevSurfError;
+    subtree.hasPayload = true;
+  } else if (!_sameValues(subtree.payload, payload))
+    subtree.isUniform = false;
+  else {
+    // Leaves share a free surface if the ranges of elevations
+    // consistent with their depths overlap.
+    if (elevSurfMin > subtree.elevSurfMin)
+      subtree.elevSurfMin = elevSurfMin;
+    if (elevSurfMax < subtree.elevSurfMax)
+      subtree.elevSurfMax = elevSurfMax;
+    if (subtree.elevSurfMin > subtree.elevSurfMax)
+      subtree.isUniform = false;
+    if (elevSurfError > subtree.elevSurfError)
+      subtree.elevSurfError = elevSurfError;
+  } // if/else
+} // _addChild
+
+// ----------------------------------------------------------------------
+// Check whether payloads have identical values, except for depth of
+// free surface.
+bool
+cencalvm::create::Compactor::_sameValues(
+				 const storage::PayloadStruct& payloadA,
+				 const storage::PayloadStruct& payloadB) const
+{ // _sameValues
+  const size_t offset = (_isCompact) ?
+    offsetof(storage::PayloadCompactStruct, DepthFreeSurf) :
+    offsetof(storage::PayloadStruct, DepthFreeSurf);
+  const size_t size = (_isCompact) ?
+    sizeof(storage::PayloadCompactStruct().DepthFreeSurf) :
+    sizeof(storage::PayloadStruct().DepthFreeSurf);
+  const size_t offsetEnd = offset + size;
+  assert(offsetEnd <= size_t(_payloadSize));
+
+  const char* bytesA = (const char*) &payloadA;
+  const char* bytesB = (const char*) &payloadB;
+  if (0 != memcmp(bytesA, bytesB, offset) ||
+      0 != memcmp(bytesA+offsetEnd, bytesB+offsetEnd, _payloadSize-offsetEnd))
+    return false;
+
+  return (storage::Payload::NODATAVAL == _depthFreeSurf(payloadA)) ==
+    (storage::Payload::NODATAVAL == _depthFreeSurf(payloadB));
+} // _sameValues
+
+// ----------------------------------------------------------------------
+// Get depth of free surface in payload.
+double
+cencalvm::create::Compactor::_depthFreeSurf(
+				  const storage::PayloadStruct& payload) const
+{ // _depthFreeSurf
+  if (!_isCompact)
+    return payload.DepthFreeSurf;
+
+  storage::PayloadStruct payloadFull;
+  _pCodec->decode(&payloadFull,
+		(const storage::PayloadCompactStruct&) payload);
+  return payloadFull.DepthFreeSurf;
+} // _depthFreeSurf
+
+// ----------------------------------------------------------------------
+// Get range of elevations of free surface consistent with depth of
+// free surface in payload of octant.
+void
+cencalvm::create::Compactor::_surfaceRange(double* pElevMin,
+					   double* pElevMax,
+					   const etree_addr_t& addr,
+					   const storage::PayloadStruct& payload)
+{ // _surfaceRange
+  assert(0 != pElevMin);
+  assert(0 != pElevMax);
+  assert(0 != _pGeom);
+
+  const double depth = _depthFreeSurf(payload);
+  if (storage::Payload::NODATAVAL == depth) {
+    *pElevMin = 0.0;
+    *pElevMax = 0.0;
+    return;
+  } // if
+
+  // Depth is relative to centroid of octant and is either quantized
+  // or rounded to single precision.
+  etree_addr_t addrO = addr;
+  double lon = 0.0;
+  double lat = 0.0;
+  double elevO = 0.0;
+  _pGeom->addrToLonLatElev(&lon, &lat, &elevO, &addrO);
+  const double error = _depthError + FLT_EPSILON*fabs(depth);
+  *pElevMin = elevO + depth - error;
+  *pElevMax = elevO + depth + error;
+} // _surfaceRange
+
+// ----------------------------------------------------------------------
+// Set depth of free surface in payload of collapsed subtree.
+void
+cencalvm::create::Compactor::_recenterDepth(storage::PayloadStruct* pPayload,
+					    const etree_addr_t& addr,
+					    const double elevSurf)
+{ // _recenterDepth
+  assert(0 != pPayload);
+  assert(0 != _pGeom);
+
+  if (storage::Payload::NODATAVAL == _depthFreeSurf(*pPayload))
+    return;
+
+  etree_addr_t addrO = addr;
+  double lon = 0.0;
+  double lat = 0.0;
+  double elevO = 0.0;
+  _pGeom->addrToLonLatElev(&lon, &lat, &elevO, &addrO);
+  const double depth = elevSurf - elevO;
+
+  if (!_isCompact)
+    pPayload->DepthFreeSurf = depth;
+  else {
+    storage::PayloadCompactStruct* pCompact =
+      (storage::PayloadCompactStruct*) pPayload;
+    storage::PayloadStruct payloadFull;
+    _pCodec->decode(&payloadFull, *pCompact);
+    payloadFull.DepthFreeSurf = depth;
+    storage::PayloadCompactStruct compact;
+    _pCodec->encode(&compact, payloadFull);
+    pCompact->DepthFreeSurf = compact.DepthFreeSurf;
+  } // if/else
+} // _recenterDepth
+
+// ----------------------------------------------------------------------
+// Check whether free surface of subtree lies in leaf octants with data.
+bool
+cencalvm::create::Compactor::_surfaceInData(const SubtreeStruct& subtree,
+					    const int level)
+{ // _surfaceInData
+  assert(0 != _pGeom);
+
+  // Without a free surface, queries relative to it depend on the
+  // elevation of the octant centroid.
+  if (storage::Payload::NODATAVAL == _depthFreeSurf(subtree.payload))
+    return false;
+
+  etree_addr_t rootAddr;
+  rootAddr.x = subtree.x;
+  rootAddr.y = subtree.y;
+  rootAddr.z = subtree.z;
+  rootAddr.t = 0;
+  rootAddr.level = level;
+  rootAddr.type = ETREE_LEAF;
+  double lon = 0.0;
+  double lat = 0.0;
+  double elevO = 0.0;
+  _pGeom->addrToLonLatElev(&lon, &lat, &elevO, &rootAddr);
+
+  // Queries use the free surface of the leaf or collapsed octant
+  // containing them, which is within the error of the range common
+  // to the leaves, so check both ends of the widened range.
+  const int numElevs = 2;
+  const double elevs[] = { subtree.elevSurfMin - subtree.elevSurfError,
+			   subtree.elevSurfMax + subtree.elevSurfError };
+  for (int iElev=0; iElev < numElevs; ++iElev) {
+    etree_addr_t surfAddr;
+    surfAddr.level = ETREE_MAXLEVEL;
+    surfAddr.type = ETREE_LEAF;
+    if (0 != _pGeom->lonLatElevToAddr(&surfAddr, lon, lat, elevs[iElev]) ||
+	!_regionInData(subtree.x, subtree.y, surfAddr.z, level))
+      return false;
+  } // for
+
+  return true;
+} // _surfaceInData
+
+// ----------------------------------------------------------------------
+// Check whether horizontal region lies in leaf octants with data.
+bool
+cencalvm::create::Compactor::_regionInData(const etree_tick_t x,
+					   const etree_tick_t y,
+					   const etree_tick_t z,
+					   const int level)
+{ // _regionInData
+  assert(0 != _dbSearch);
+
+  etree_addr_t addr;
+  addr.x = x;
+  addr.y = y;
+  addr.z = z;
+  addr.t = 0;
+  addr.level = ETREE_MAXLEVEL;
+  addr.type = ETREE_LEAF;
+
+  etree_addr_t resAddr;
+  storage::PayloadStruct payload;
+  if (0 != etree_search(_dbSearch, addr, &resAddr, "*", &payload) ||
+      ETREE_LEAF != resAddr.type)
+    return false;
+  if (_isCompact) {
+    storage::PayloadCompactStruct compact;
+    memcpy(&compact, &payload, sizeof(compact));
+    _pCodec->decode(&payload, compact);
+  } // if
+  if (storage::Payload::NODATAVAL == payload.Vs)
+    return false;
+
+  // Leaf containing corner of region covers region if it is at least
+  // as large as region; otherwise check quadrants of region.
+  if (resAddr.level <= level)
+    return true;
+
+  const etree_tick_t tickLen = 0x80000000 >> (level+1);
+  return
+    _regionInData(x, y, z, level+1) &&
+    _regionInData(x+tickLen, y, z, level+1) &&
+    _regionInData(x, y+tickLen, z, level+1) &&
+    _regionInData(x+tickLen, y+tickLen, z, level+1);
+} // _regionInData
+
+// End of file
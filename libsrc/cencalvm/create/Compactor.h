@@ -0,0 +1,290 @@
+// -*- C++ -*-
+//
+// ======================================================================
+//
+//                           Brad T. Aagaard
+//                        U.S. Geological Survey
+//
+// {LicenseText}
+//
+// ======================================================================
+//
+
+/** @file libsrc/create/Compactor.h
+ *
+ * @brief C++ object for collapsing homogeneous subtrees of a packed
+ * etree database into single leaf octants.
+ *
+ * A subtree is homogeneous if its leaf octants fill the volume of its
+ * root octant and all have identical payloads, except for the depth
+ * of the free surface. Because the depth of the free surface is
+ * relative to the octant centroid, leaves at different elevations
+ * have different depths; they are homogeneous if their depths put
+ * the free surface at the same elevation (within the precision of
+ * the stored depths). The largest such subtrees are replaced by a
+ * leaf octant at the level of their root with the depth of the free
+ * surface relative to the centroid of the root. Interior octants
+ * elsewhere are copied without modification, so the database does
+ * not need to be averaged again.
+ *
+ * Maximum resolution queries within a collapsed subtree return the
+ * same values, except for the depth of the free surface, which is
+ * relative to the centroid of the collapsed octant. When the free
+ * surface does not lie in a leaf octant with data, queries relative
+ * to the free surface move the surface down by the height of the
+ * octant containing the query location, which differs once a
+ * subtree is collapsed. Subtrees are therefore collapsed only if the
+ * free surface above them lies in leaf octants with data, so these
+ * queries also return the same values (within the precision of the
+ * stored depths).
+ *
+ * The metadata of the compacted database includes
+ * Payload::COMPACTEDTAG, because leaf octants no longer all sit at
+ * the resolution of the data.
+ *
+ * The input database is streamed twice with a cursor in Morton
+ * pre-order: the first pass finds the homogeneous subtrees and the
+ * second pass appends the compacted database.
+ */
+
+#if !defined(cencalvm_create_compactor_h)
+#define cencalvm_create_compactor_h
+
+#include "cencalvm/storage/etreefwd.h" // USES etree_t, etree_tick_t
+#include "cencalvm/storage/Payload.h" // HASA PayloadStruct
+
+#include <string> // HASA std::string
+#include <vector> // HASA std::vector
+
+namespace cencalvm {
+  namespace create {
+    class Compactor;
+    class TestCompactor; // friend
+  } // namespace create
+  namespace storage {
+    class Geometry; // HOLDSA Geometry
+    class PayloadCodec; // HASA PayloadCodec
+  } // namespace storage
+} // namespace cencalvm
+
+/// C++ object for collapsing homogeneous subtrees of a packed etree
+/// database into single leaf octants.
+class cencalvm::create::Compactor
+{ // Compactor
+  friend class TestCompactor;
+
+public :
+  // PUBLIC METHODS /////////////////////////////////////////////////////
+
+  /// Constructor
+  Compactor(void);
+
+  /// Destructor
+  ~Compactor(void);
+
+  /** Set filename of input database.
+   *
+   * @param filename Name of file
+   */
+  void filenameIn(const char* filename);
+
+  /** Set filename of output (compacted) database.
+   *
+   * @param filename Name of file
+   */
+  void filenameOut(const char* filename);
+
+  /** Set database cache size.
+   *
+   * @param size Size of cache in MB
+   */
+  void cacheSize(const int size);
+
+  /** Set geometry of velocity model.
+   *
+   * Default is GeomCenCA.
+   *
+   * @param pGeom Pointer to geometry
+   */
+  void geometry(const storage::Geometry* pGeom);
+
+  /// Collapse homogeneous subtrees of database.
+  void compact(void);
+
+  /** Set flag indicating compaction should be quiet (no progress
+   * reports).
+   *
+   * Default behavior is for to give progress reports.
+   *
+   * @param flag True for quiet operation, false to give progress reports
+   */
+  void quiet(const bool flag);
+
+private :
+  // PRIVATE STRUCTS ////////////////////////////////////////////////////
+
+  /// Subtree of octant on path from root to current octant.
+  struct SubtreeStruct {
+    etree_tick_t x; ///< X coordinate of root octant
+    etree_tick_t y; ///< Y coordinate of root octant
+    etree_tick_t z; ///< Z coordinate of root octant
+    int numFilled; ///< Number of children whose leaves fill them
+    bool isOpen; ///< True if octant is on current path
+    bool isUniform; ///< True if all leaves have identical payloads
+    bool hasPayload; ///< True if payload of leaves has been set
+    storage::PayloadStruct payload; ///< Payload of leaves
+    double elevSurfMin; ///< Minimum elevation of free surface of leaves
+    double elevSurfMax; ///< Maximum elevation of free surface of leaves
+    double elevSurfError; ///< Largest error in elevation of free surface
+  }; // SubtreeStruct
+
+  /// Homogeneous subtree collapsed into a leaf octant.
+  struct CollapsedStruct {
+    etree_tick_t x; ///< X coordinate of root octant
+    etree_tick_t y; ///< Y coordinate of root octant
+    etree_tick_t z; ///< Z coordinate of root octant
+    int level; ///< Level of root octant
+    storage::PayloadStruct payload; ///< Payload of leaves
+  }; // CollapsedStruct
+
+private :
+  // PRIVATE METHODS ////////////////////////////////////////////////////
+
+  /** Find largest homogeneous subtrees.
+   *
+   * @param db Input database
+   */
+  void _findCollapsed(etree_t* db);
+
+  /** Close subtrees of octants on current path at or below level and
+   * pass their state to their parents.
+   *
+   * @param level Coarsest level to close
+   */
+  void _closeSubtrees(const int level);
+
+  /** Add child to subtree of octant on current path.
+   *
+   * @param level Level of octant
+   * @param isFilled True if leaves of child fill it
+   * @param isUniform True if leaves of child have identical payloads
+   * @param payload Payload of leaves of child
+   * @param elevSurfMin Minimum elevation of free surface of leaves of child
+   * @param elevSurfMax Maximum elevation of free surface of leaves of child
+   * @param elevSurfError Largest error in elevation of free surface
+   * of leaves of child
+   */
+  void _addChild(const int level,
+		 const bool isFilled,
+		 const bool isUniform,
+		 const storage::PayloadStruct& payload,
+		 const double elevSurfMin,
+		 const double elevSurfMax,
+		 const double elevSurfError);
+
+  /** Check whether payloads have identical values, except for depth
+   * of free surface, and both have or both lack depth of free
+   * surface.
+   *
+   * @param payloadA Payload in schema of input database
+   * @param payloadB Payload in schema of input database
+   *
+   * @returns True if values are identical, false otherwise
+   */
+  bool _sameValues(const storage::PayloadStruct& payloadA,
+		   const storage::PayloadStruct& payloadB) const;
+
+  /** Get depth of free surface in payload.
+   *
+   * @param payload Payload in schema of input database
+   *
+   * @returns Depth of free surface wrt centroid of octant
+   */
+  double _depthFreeSurf(const storage::PayloadStruct& payload) const;
+
+  /** Get range of elevations of free surface consistent with depth of
+   * free surface in payload of octant.
+   *
+   * @param pElevMin Pointer to minimum elevation
+   * @param pElevMax Pointer to maximum elevation
+   * @param addr Address of octant
+   * @param payload Payload in schema of input database
+   */
+  void _surfaceRange(double* pElevMin,
+		     double* pElevMax,
+		     const etree_addr_t& addr,
+		     const storage::PayloadStruct& payload);
+
+  /** Set depth of free surface in payload of collapsed subtree
+   * relative to centroid of root octant.
+   *
+   * @param pPayload Pointer to payload in schema of input database
+   * @param addr Address of root octant
+   * @param elevSurf Elevation of free surface
+   */
+  void _recenterDepth(storage::PayloadStruct* pPayload,
+		      const etree_addr_t& addr,
+		      const double elevSurf);
+
+  /** Check whether free surface of subtree lies in leaf octants with
+   * data, so queries relative to the free surface do not depend on
+   * the height of the octants in the subtree.
+   *
+   * @param subtree Subtree of octant on current path
+   * @param level Level of root octant of subtree
+   *
+   * @returns True if free surface lies in leaf octants with data
+   */
+  bool _surfaceInData(const SubtreeStruct& subtree,
+		      const int level);
+
+  /** Check whether horizontal region lies in leaf octants with data.
+   *
+   * @param x X coordinate of region
+   * @param y Y coordinate of region
+   * @param z Z coordinate of region
+   * @param level Level of octants with horizontal extent of region
+   *
+   * @returns True if region lies in leaf octants with data
+   */
+  bool _regionInData(const etree_tick_t x,
+		     const etree_tick_t y,
+		     const etree_tick_t z,
+		     const int level);
+
+private :
+  // NOT IMPLEMENTED ////////////////////////////////////////////////////
+
+  Compactor(const Compactor& c); ///< Not implemented
+  const Compactor& operator=(const Compactor& c); ///< Not implemented
+
+private :
+  // PRIVATE MEMBERS ////////////////////////////////////////////////////
+
+  std::string _filenameIn; ///< Filename of input database
+  std::string _filenameOut; ///< Filename of output database
+
+  /// Subtrees of octants on current path (index is level)
+  std::vector<SubtreeStruct> _subtrees;
+
+  /// Collapsed subtrees in Morton pre-order
+  std::vector<CollapsedStruct> _collapsed;
+
+  int _cacheSize; ///< Size of database cache in MB
+  int _payloadSize; ///< Size of payload in input database
+
+  etree_t* _dbSearch; ///< Input database for searches at free surface
+  storage::Geometry* _pGeom; ///< Geometry of velocity model
+  storage::PayloadCodec* _pCodec; ///< Quantization of compact payloads
+  bool _isCompact; ///< True if input database uses compact payload
+  double _depthError; ///< Error in depth of free surface from quantization
+
+  bool _quiet; ///< Flag to eliminate progress reports
+
+}; // Compactor
+
+#include "Compactor.icc" // inline methods
+
+#endif // cencalvm_create_compactor_h
+
+// End of file
@@ -0,0 +1,224 @@
+// -*- C++ -*-
+//
+// ======================================================================
+//
+//                           Brad T. Aagaard
+//                        U.S. Geological Survey
+//
+// {LicenseText}
+//
+// ======================================================================
+//
+
+#include "Compressor.h" // implementation of class methods
+
+#include "cencalvm/storage/CompressedDB.h" // USES CompressedDB
+#include "cencalvm/storage/Payload.h" // USES Payload
+#include "cencalvm/storage/PayloadDictionary.h" // USES PayloadDictionary
+
+extern "C" {
+#include "etree.h"
+}
+
+#include <stdio.h> // USES fopen(), fwrite(), fclose()
+#include <stdlib.h> // USES free()
+#include <string.h> // USES memset(), memcpy()
+#include <time.h> // USES time_t
+#include <unistd.h> // USES gethostname()
+#include <iostream> // USES std::cout
+#include <vector> // USES std::vector
+
+#include <stdexcept> // USES std::runtime_error
+#include <sstream> // USES std::ostringstream
+#include <assert.h> // USES assert()
+
+// ----------------------------------------------------------------------
+// Constructor
+cencalvm::create::Compressor::Compressor(void) :
+  _filenameIn(""),
+  _filenameOut(""),
+  _cacheSize(64),
+  _blockSize(4096),
+  _quiet(false)
+{ // constructor
+} // constructor
+
+// ----------------------------------------------------------------------
+// Destructor
+cencalvm::create::Compressor::~Compressor(void)
+{ // destructor
+} // destructor
+
+// ----------------------------------------------------------------------
+// Convert database to compressed container.
+void
+cencalvm::create::Compressor::compress(void)
+{ // compress
+  assert(_blockSize > 0);
+
+  if (!_quiet)
+    std::cout
+      << "Compressing etree database '" << _filenameIn
+      << "' to compressed etree database '" << _filenameOut << "'."
+      << std::endl;
+
+  etree_t* dbIn = etree_open(_filenameIn.c_str(), O_RDONLY, _cacheSize, 0, 0);
+  if (0 == dbIn) {
+    std::ostringstream msg;
+    msg
+      << "Could not open etree database '" << _filenameIn
+      << "' for compression.";
+    throw std::runtime_error(msg.str());
+  } // if
+  const int payloadSize = etree_getpayloadsize(dbIn);
+  if (payloadSize <= 0 || 0 != payloadSize % 4) {
+    std::ostringstream msg;
+    msg
+      << "Payload size " << payloadSize << " of etree database '"
+      << _filenameIn << "' is not a multiple of 4 bytes.";
+    etree_close(dbIn);
+    throw std::runtime_error(msg.str());
+  } // if
+
+  char* schemaIn = etree_getschema(dbIn);
+  const std::string schema = (0 != schemaIn) ? schemaIn : "";
+  free(schemaIn);
+
+  const int maxLen = 128;
+  char hostname[maxLen];
+  gethostname(hostname, maxLen);
+  time_t rawTime = time(0);
+  const char* datetime = ctime(&rawTime);
+  std::ostringstream metainfo;
+  char* appmetaIn = etree_getappmeta(dbIn);
+  const std::string metaIn = (0 != appmetaIn) ? appmetaIn : "";
+  free(appmetaIn);
+  if (metaIn.length() > 0)
+    metainfo << metaIn << "\n";
+  metainfo
+    << "compressed from '" << _filenameIn << "' on: " << datetime
+    << "host: " << hostname;
+
+  // Queries of a dictionary-encoded database need its dictionary, so
+  // the dictionary is copied next to the compressed database.
+  const bool isIndexed = (schema == storage::Payload::SCHEMAINDEX);
+  const std::string filenameDictOut =
+    storage::PayloadDictionary::filename(_filenameOut.c_str());
+  storage::PayloadDictionary dictionary;
+  if (isIndexed) {
+    const std::string filenameDictIn =
+      storage::PayloadDictionary::find(_filenameIn.c_str(), metaIn.c_str());
+    try {
+      dictionary.read(filenameDictIn.c_str());
+    } catch (...) {
+      etree_close(dbIn);
+      throw;
+    } // try/catch
+    metainfo
+      << "\n" << storage::PayloadDictionary::metadata(filenameDictOut.c_str());
+  } // if
+  const std::string appmeta = metainfo.str();
+
+  FILE* fout = fopen(_filenameOut.c_str(), "wb");
+  if (0 == fout) {
+    etree_close(dbIn);
+    std::ostringstream msg;
+    msg
+      << "Could not open compressed etree database '" << _filenameOut
+      << "' for writing.";
+    throw std::runtime_error(msg.str());
+  } // if
+
+  storage::CompressedDBHeaderStruct header;
+  memset(&header, 0, sizeof(header));
+  memcpy(header.magic, storage::CompressedDB::MAGIC, sizeof(header.magic));
+  header.version = storage::CompressedDB::VERSION;
+  header.byteOrder = storage::CompressedDB::BYTEORDER;
+  header.payloadSize = payloadSize;
+  header.blockSize = _blockSize;
+  header.schemaLength = schema.length();
+  header.appmetaLength = appmeta.length();
+  bool writeError =
+    (1 != fwrite(&header, sizeof(header), 1, fout)) ||
+    (schema.length() != fwrite(schema.data(), 1, schema.length(), fout)) ||
+    (appmeta.length() != fwrite(appmeta.data(), 1, appmeta.length(), fout));
+  int64_t offset = sizeof(header) + schema.length() + appmeta.length();
+
+  std::vector<storage::CompressedDBIndexStruct> index;
+  std::vector<etree_addr_t> addrs(_blockSize);
+  std::vector<char> payloads(size_t(_blockSize)*payloadSize);
+  std::string buffer;
+  int64_t numOctants = 0;
+  int numBuffered = 0;
+
+  etree_addr_t addr;
+  addr.x = 0;
+  addr.y = 0;
+  addr.z = 0;
+  addr.t = 0;
+  addr.level = ETREE_MAXLEVEL;
+  bool more = (0 == etree_initcursor(dbIn, addr));
+  while (more || numBuffered > 0) {
+    if (more) {
+      if (0 != etree_getcursor(dbIn, &addrs[numBuffered], "*",
+			       &payloads[size_t(numBuffered)*payloadSize]))
+	throw std::runtime_error(etree_strerror(etree_errno(dbIn)));
+      ++numBuffered;
+      ++numOctants;
+      more = (0 == etree_advcursor(dbIn));
+    } // if
+    if (numBuffered > 0 && (numBuffered == _blockSize || !more)) {
+      storage::CompressedDB::encodeBlock(&buffer, &addrs[0], &payloads[0],
+					 numBuffered, payloadSize);
+      storage::CompressedDBIndexStruct entry;
+      entry.x = addrs[0].x;
+      entry.y = addrs[0].y;
+      entry.z = addrs[0].z;
+      entry.level = addrs[0].level;
+      entry.offset = offset;
+      entry.size = buffer.length();
+      entry.numOctants = numBuffered;
+      index.push_back(entry);
+      writeError = writeError ||
+	(buffer.length() != fwrite(buffer.data(), 1, buffer.length(), fout));
+      offset += buffer.length();
+      numBuffered = 0;
+    } // if
+  } // while
+
+  if (0 != etree_close(dbIn))
+    throw std::runtime_error(etree_strerror(etree_errno(dbIn)));
+
+  header.numOctants = numOctants;
+  header.numBlocks = index.size();
+  header.indexOffset = offset;
+  if (index.size() > 0)
+    writeError = writeError ||
+      (index.size() != fwrite(&index[0], sizeof(index[0]), index.size(), fout));
+  writeError = writeError ||
+    0 != fseek(fout, 0, SEEK_SET) ||
+    1 != fwrite(&header, sizeof(header), 1, fout);
+  writeError = (0 != fclose(fout)) || writeError;
+  if (writeError) {
+    std::ostringstream msg;
+    msg << "Error while writing compressed etree database '"
+	<< _filenameOut << "'.";
+    throw std::runtime_error(msg.str());
+  } // if
+
+  if (isIndexed)
+    dictionary.write(filenameDictOut.c_str());
+
+  if (!_quiet) {
+    const int64_t sizeIn = numOctants * (sizeof(etree_addr_t) + payloadSize);
+    const int64_t sizeOut = offset + index.size()*sizeof(index[0]);
+    std::cout
+      << "Done compressing etree database.\n"
+      << "Number of octants: " << numOctants
+      << ", blocks: " << index.size() << "\n"
+      << "Size of octants: " << sizeIn << " bytes, compressed size: "
+      << sizeOut << " bytes." << std::endl;
+  } // if
+} // compress
+
+// End of file
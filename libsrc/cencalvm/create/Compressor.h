@@ -0,0 +1,116 @@
+// -*- C++ -*-
+//
+// ======================================================================
+//
+//                           Brad T. Aagaard
+//                        U.S. Geological Survey
+//
+// {LicenseText}
+//
+// ======================================================================
+//
+
+/** @file libsrc/create/Compressor.h
+ *
+ * @brief C++ object for converting a packed etree database to a
+ * read-only compressed container.
+ *
+ * The octants of the input database are streamed with a cursor in
+ * Morton pre-order and written in compressed blocks (see
+ * storage::CompressedDB). The compressed container can be queried
+ * with VMQuery in place of the etree database. The dictionary of a
+ * dictionary-encoded database is copied next to the compressed
+ * container (see storage::PayloadDictionary).
+ */
+
+#if !defined(cencalvm_create_compressor_h)
+#define cencalvm_create_compressor_h
+
+#include <string> // HASA std::string
+
+namespace cencalvm {
+  namespace create {
+    class Compressor;
+    class TestCompressor; // friend
+  } // namespace create
+} // namespace cencalvm
+
+/// C++ object for converting a packed etree database to a read-only
+/// compressed container.
+class cencalvm::create::Compressor
+{ // Compressor
+  friend class TestCompressor;
+
+public :
+  // PUBLIC METHODS /////////////////////////////////////////////////////
+
+  /// Constructor
+  Compressor(void);
+
+  /// Destructor
+  ~Compressor(void);
+
+  /** Set filename of input (etree) database.
+   *
+   * @param filename Name of file
+   */
+  void filenameIn(const char* filename);
+
+  /** Set filename of output (compressed) database.
+   *
+   * @param filename Name of file
+   */
+  void filenameOut(const char* filename);
+
+  /** Set database cache size.
+   *
+   * @param size Size of cache in MB
+   */
+  void cacheSize(const int size);
+
+  /** Set number of octants in each block.
+   *
+   * Larger blocks compress better, but each query that misses the
+   * cache of decompressed blocks must decompress a whole block.
+   * Default is 4096.
+   *
+   * @param size Number of octants
+   */
+  void blockSize(const int size);
+
+  /// Convert database to compressed container.
+  void compress(void);
+
+  /** Set flag indicating compression should be quiet (no progress
+   * reports).
+   *
+   * Default behavior is for to give progress reports.
+   *
+   * @param flag True for quiet operation, false to give progress reports
+   */
+  void quiet(const bool flag);
+
+private :
+  // NOT IMPLEMENTED ////////////////////////////////////////////////////
+
+  Compressor(const Compressor& c); ///< Not implemented
+  const Compressor& operator=(const Compressor& c); ///< Not implemented
+
+private :
+  // PRIVATE MEMBERS ////////////////////////////////////////////////////
+
+  std::string _filenameIn; ///< Filename of input database
+  std::string _filenameOut; ///< Filename of output database
+
+  int _cacheSize; ///< Size of database cache in MB
+  int _blockSize; ///< Number of octants in each block
+
+  bool _quiet; ///< Flag to eliminate progress reports
+
+}; // Compressor
+
+#include "Compressor.icc" // inline methods
+
+#endif // cencalvm_create_compressor_h
+
+// End of file
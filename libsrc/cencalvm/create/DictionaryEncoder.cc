@@ -0,0 +1,200 @@
+// -*- C++ -*-
+//
+// ======================================================================
+//
+//                           Brad T. Aagaard
+//                        U.S. Geological Survey
+//
+// {LicenseText}
+//
+// ======================================================================
+//
+
+#include "DictionaryEncoder.h" // implementation of class methods
+
+#include "cencalvm/storage/Payload.h" // USES PayloadStruct
+#include "cencalvm/storage/PayloadCodec.h" // USES PayloadCodec
+#include "cencalvm/storage/PayloadDictionary.h" // USES PayloadDictionary
+
+extern "C" {
+#include "etree.h"
+}
+
+#include <stdlib.h> // USES free()
+#include <string.h> // USES memcmp()
+#include <time.h> // USES time_t
+#include <unistd.h> // USES gethostname()
+#include <iostream> // USES std::cout
+#include <map> // USES std::map
+
+#include <stdexcept> // USES std::runtime_error
+#include <sstream> // USES std::ostringstream
+#include <assert.h> // USES assert()
+
+// ----------------------------------------------------------------------
+namespace {
+  /// Byte-wise ordering of payloads for lookup of duplicates.
+  struct PayloadLess {
+    bool operator()(const cencalvm::storage::PayloadStruct& a,
+		    const cencalvm::storage::PayloadStruct& b) const {
+      return memcmp(&a, &b, sizeof(a)) < 0;
+    }
+  }; // PayloadLess
+} // namespace
+
+// ----------------------------------------------------------------------
+// Constructor
+cencalvm::create::DictionaryEncoder::DictionaryEncoder(void) :
+  _filenameIn(""),
+  _filenameOut(""),
+  _cacheSize(64),
+  _quiet(false)
+{ // constructor
+} // constructor
+
+// ----------------------------------------------------------------------
+// Destructor
+cencalvm::create::DictionaryEncoder::~DictionaryEncoder(void)
+{ // destructor
+} // destructor
+
+// ----------------------------------------------------------------------
+// Convert database to dictionary-encoded database.
+void
+cencalvm::create::DictionaryEncoder::encode(void)
+{ // encode
+  if (!_quiet)
+    std::cout
+      << "Encoding etree database '" << _filenameIn
+      << "' to dictionary-encoded etree database '" << _filenameOut << "'."
+      << std::endl;
+
+  etree_t* dbIn = etree_open(_filenameIn.c_str(), O_RDONLY, _cacheSize, 0, 0);
+  if (0 == dbIn) {
+    std::ostringstream msg;
+    msg
+      << "Could not open etree database '" << _filenameIn
+      << "' for dictionary encoding.";
+    throw std::runtime_error(msg.str());
+  } // if
+
+  // Compact payloads are decoded so the dictionary holds the values
+  // returned by queries.
+  storage::PayloadCodec codec;
+  char* schemaIn = etree_getschema(dbIn);
+  const std::string schema = (0 != schemaIn) ? schemaIn : "";
+  free(schemaIn);
+  const bool isCompact = (schema == storage::Payload::SCHEMACOMPACT);
+  char* appmeta = etree_getappmeta(dbIn);
+  const std::string metaIn = (0 != appmeta) ? appmeta : "";
+  free(appmeta);
+  if (isCompact) {
+    try {
+      codec.parseMetadata(metaIn.c_str());
+    } catch (...) {
+      etree_close(dbIn);
+      throw;
+    } // try/catch
+  } else if (schema != storage::Payload::SCHEMA) {
+    etree_close(dbIn);
+    std::ostringstream msg;
+    msg
+      << "Etree database '" << _filenameIn << "' does not use the full "
+      << "or compact payload.";
+    throw std::runtime_error(msg.str());
+  } // if/else
+
+  const int numDims = 3;
+  const int payloadSizeOut = sizeof(storage::PayloadIndexStruct);
+  etree_t* dbOut = etree_open(_filenameOut.c_str(), O_CREAT|O_TRUNC|O_RDWR,
+			      _cacheSize, payloadSizeOut, numDims);
+  if (0 == dbOut) {
+    etree_close(dbIn);
+    std::ostringstream msg;
+    msg
+      << "Could not open etree database '" << _filenameOut
+      << "' for output of dictionary-encoded database.";
+    throw std::runtime_error(msg.str());
+  } // if
+
+  if (0 != etree_registerschema(dbOut, storage::Payload::SCHEMAINDEX))
+    throw std::runtime_error(etree_strerror(etree_errno(dbOut)));
+
+  const int maxLen = 128;
+  char hostname[maxLen];
+  gethostname(hostname, maxLen);
+  time_t rawTime = time(0);
+  const char* datetime = ctime(&rawTime);
+  const std::string filenameDict =
+    storage::PayloadDictionary::filename(_filenameOut.c_str());
+  std::ostringstream metainfo;
+  if (metaIn.length() > 0)
+    metainfo << metaIn << "\n";
+  metainfo
+    << "dictionary encoded from '" << _filenameIn << "' on: " << datetime
+    << "host: " << hostname << "\n"
+    << storage::PayloadDictionary::metadata(filenameDict.c_str());
+  if (0 != etree_setappmeta(dbOut, metainfo.str().c_str()))
+    throw std::runtime_error(etree_strerror(etree_errno(dbOut)));
+
+  // Single pass: add new payloads to dictionary and append octants
+  // with index of payload.
+  etree_addr_t addr;
+  addr.x = 0;
+  addr.y = 0;
+  addr.z = 0;
+  addr.t = 0;
+  addr.level = ETREE_MAXLEVEL;
+  if (0 != etree_beginappend(dbOut, 1))
+    throw std::runtime_error(etree_strerror(etree_errno(dbOut)));
+
+  storage::PayloadDictionary dictionary;
+  typedef std::map<storage::PayloadStruct, uint32_t, PayloadLess> index_map;
+  index_map indices;
+  long numOctants = 0;
+  bool more = (0 == etree_initcursor(dbIn, addr));
+  while (more) {
+    storage::PayloadStruct payload;
+    if (0 != etree_getcursor(dbIn, &addr, "*", &payload))
+      throw std::runtime_error(etree_strerror(etree_errno(dbIn)));
+    if (isCompact) {
+      const storage::PayloadCompactStruct compact =
+	*(storage::PayloadCompactStruct*) &payload;
+      codec.decode(&payload, compact);
+    } // if
+
+    storage::PayloadIndexStruct index;
+    const index_map::const_iterator iter = indices.find(payload);
+    if (iter != indices.end())
+      index.Index = iter->second;
+    else {
+      index.Index = dictionary.append(payload);
+      indices[payload] = index.Index;
+    } // if/else
+
+    if (0 != etree_append(dbOut, addr, &index))
+      throw std::runtime_error(etree_strerror(etree_errno(dbOut)));
+    ++numOctants;
+    more = (0 == etree_advcursor(dbIn));
+  } // while
+
+  if (0 != etree_endappend(dbOut))
+    throw std::runtime_error(etree_strerror(etree_errno(dbOut)));
+
+  if (0 != etree_close(dbIn))
+    throw std::runtime_error(etree_strerror(etree_errno(dbIn)));
+
+  if (0 != etree_close(dbOut))
+    throw std::runtime_error(etree_strerror(etree_errno(dbOut)));
+
+  dictionary.write(filenameDict.c_str());
+
+  if (!_quiet)
+    std::cout
+      << "Done encoding etree database.\n"
+      << "Number of octants: " << numOctants << "\n"
+      << "Number of unique payloads in dictionary '" << filenameDict
+      << "': " << dictionary.size() << std::endl;
+} // encode
+
+// End of file
@@ -0,0 +1,107 @@
+// -*- C++ -*-
+//
+// ======================================================================
+//
+//                           Brad T. Aagaard
+//                        U.S. Geological Survey
+//
+// {LicenseText}
+//
+// ======================================================================
+//
+
+/** @file libsrc/create/DictionaryEncoder.h
+ *
+ * @brief C++ object for converting an etree database to a
+ * dictionary-encoded etree database.
+ *
+ * The octants of the input database are streamed once with a
+ * cursor. Each payload not seen before is added to the dictionary,
+ * and an octant holding the index of the payload in the dictionary is
+ * appended to the output database. The dictionary is written next to
+ * the output database (see PayloadDictionary::filename()), and its
+ * name is recorded in the metadata of the output database. Compact
+ * (quantized) payloads are decoded, so the dictionary holds the
+ * values returned by queries.
+ */
+
+#if !defined(cencalvm_create_dictionaryencoder_h)
+#define cencalvm_create_dictionaryencoder_h
+
+#include <string> // HASA std::string
+
+namespace cencalvm {
+  namespace create {
+    class DictionaryEncoder;
+    class TestDictionaryEncoder; // friend
+  } // namespace create
+} // namespace cencalvm
+
+/// C++ object for converting an etree database to a dictionary-encoded
+/// etree database.
+class cencalvm::create::DictionaryEncoder
+{ // DictionaryEncoder
+  friend class TestDictionaryEncoder;
+
+public :
+  // PUBLIC METHODS /////////////////////////////////////////////////////
+
+  /// Constructor
+  DictionaryEncoder(void);
+
+  /// Destructor
+  ~DictionaryEncoder(void);
+
+  /** Set filename of input database.
+   *
+   * @param filename Name of file
+   */
+  void filenameIn(const char* filename);
+
+  /** Set filename of output (dictionary-encoded) database.
+   *
+   * @param filename Name of file
+   */
+  void filenameOut(const char* filename);
+
+  /** Set database cache size.
+   *
+   * @param size Size of cache in MB
+   */
+  void cacheSize(const int size);
+
+  /// Convert database to dictionary-encoded database.
+  void encode(void);
+
+  /** Set flag indicating conversion should be quiet (no progress
+   * reports).
+   *
+   * Default behavior is for to give progress reports.
+   *
+   * @param flag True for quiet operation, false to give progress reports
+   */
+  void quiet(const bool flag);
+
+private :
+  // NOT IMPLEMENTED ////////////////////////////////////////////////////
+
+  DictionaryEncoder(const DictionaryEncoder& e); ///< Not implemented
+  const DictionaryEncoder& operator=(const DictionaryEncoder& e); ///< Not implemented
+
+private :
+  // PRIVATE MEMBERS ////////////////////////////////////////////////////
+
+  std::string _filenameIn; ///< Filename of input database
+  std::string _filenameOut; ///< Filename of output database
+
+  int _cacheSize; ///< Size of database cache in MB
+
+  bool _quiet; ///< Flag to eliminate progress reports
+
+}; // DictionaryEncoder
+
+#include "DictionaryEncoder.icc" // inline methods
+
+#endif // cencalvm_create_dictionaryencoder_h
+
+// End of file
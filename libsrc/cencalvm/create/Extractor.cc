@@ -0,0 +1,335 @@
+// -*- C++ -*-
+//
+// ======================================================================
+//
+//                           Brad T. Aagaard
+//                        U.S. Geological Survey
+//
+// {LicenseText}
+//
+// ======================================================================
+//
+
+#include "Extractor.h" // implementation of class methods
+
+#include "cencalvm/storage/Payload.h" // USES PayloadStruct
+#include "cencalvm/storage/Geometry.h" // USES Geometry
+
+extern "C" {
+#include "etree.h"
+}
+
+#include <stdlib.h> // USES free()
+#include <time.h> // USES time_t
+#include <unistd.h> // USES gethostname()
+#include <iostream> // USES std::cout
+
+#include <stdexcept> // USES std::runtime_error
+#include <sstream> // USES std::ostringstream
+#include <assert.h> // USES assert()
+
+// ----------------------------------------------------------------------
+// Constructor
+cencalvm::create::Extractor::Extractor(void) :
+  _filenameIn(""),
+  _filenameOut(""),
+  _cacheSize(64),
+  _maxLevel(-1),
+  _lonMin(0.0),
+  _lonMax(0.0),
+  _latMin(0.0),
+  _latMax(0.0),
+  _elevMin(0.0),
+  _elevMax(0.0),
+  _pGeom(0),
+  _quiet(false)
+{ // constructor
+  for (int i=0; i < 3; ++i) {
+    _tickMin[i] = 0;
+    _tickMax[i] = 0;
+  } // for
+} // constructor
+
+// ----------------------------------------------------------------------
+// Destructor
+cencalvm::create::Extractor::~Extractor(void)
+{ // destructor
+  delete _pGeom; _pGeom = 0;
+} // destructor
+
+// ----------------------------------------------------------------------
+// Set velocity model geometry
+void
+cencalvm::create::Extractor::geometry(const storage::Geometry* pGeom)
+{ // geometry
+  delete _pGeom; _pGeom = (0 != pGeom) ? pGeom->clone() : 0;
+} // geometry
+
+// ----------------------------------------------------------------------
+// Extract octants intersecting region of interest.
+void
+cencalvm::create::Extractor::extract(void)
+{ // extract
+  if (0 == _pGeom)
+    throw std::runtime_error("Geometry of velocity model must be set "
+			     "before extracting region.");
+  _regionTicks();
+
+  if (!_quiet)
+    std::cout 
+      << "Extracting region of etree database '" << _filenameIn
+      << "' to etree database '" << _filenameOut << "'." << std::endl;
+
+  const int numDims = 3;
+  const int payloadSize = sizeof(cencalvm::storage::PayloadStruct);
+  etree_t* dbIn = etree_open(_filenameIn.c_str(), O_RDONLY,
+			     _cacheSize, payloadSize, numDims);
+  if (0 == dbIn) {
+    std::ostringstream msg;
+    msg
+      << "Could not open etree database '" << _filenameIn
+      << "' for extraction.";
+    throw std::runtime_error(msg.str());
+  } // if
+  if (etree_getpayloadsize(dbIn) != payloadSize) {
+    std::ostringstream msg;
+    msg
+      << "Payload size of input etree database '" << _filenameIn
+      << "' doesn't match the expected payload size.\n"
+      << "Expected payload size is " << payloadSize
+      << ", and database payload size is " << etree_getpayloadsize(dbIn)
+      << ".";
+    etree_close(dbIn);
+    throw std::runtime_error(msg.str());
+  } // if
+
+  etree_t* dbOut = etree_open(_filenameOut.c_str(), O_CREAT|O_TRUNC|O_RDWR,
+			      _cacheSize, payloadSize, numDims);
+  if (0 == dbOut) {
+    etree_close(dbIn);
+    std::ostringstream msg;
+    msg
+      << "Could not open etree database '" << _filenameOut
+      << "' for output of extracted region.";
+    throw std::runtime_error(msg.str());
+  } // if
+  
+  if (0 != etree_registerschema(dbOut, cencalvm::storage::Payload::SCHEMA))
+    throw std::runtime_error(etree_strerror(etree_errno(dbOut)));
+
+  // Record region in metadata
+  const int maxLen = 128;
+  char hostname[maxLen];
+  gethostname(hostname, maxLen);
+  time_t rawTime = time(0);
+  const char* datetime = ctime(&rawTime);
+  std::ostringstream metainfo;
+  char* appmeta = etree_getappmeta(dbIn);
+  if (0 != appmeta)
+    metainfo << appmeta << "\n";
+  free(appmeta);
+  metainfo
+    << "extracted region: lon " << _lonMin << " to " << _lonMax
+    << ", lat " << _latMin << " to " << _latMax
+    << ", elev " << _elevMin << " to " << _elevMax << " m";
+  if (_maxLevel >= 0)
+    metainfo << ", max level " << _maxLevel;
+  metainfo
+    << "\n"
+    << "extracted from '" << _filenameIn << "' on: " << datetime
+    << "host: " << hostname;
+  if (0 != etree_setappmeta(dbOut, metainfo.str().c_str()))
+    throw std::runtime_error(etree_strerror(etree_errno(dbOut)));
+
+  etree_addr_t addr;
+  addr.x = 0;
+  addr.y = 0;
+  addr.z = 0;
+  addr.t = 0;
+  addr.level = 0;
+  if (0 != etree_initcursor(dbIn, addr))
+    throw std::runtime_error(etree_strerror(etree_errno(dbIn)));
+  
+  if (0 != etree_beginappend(dbOut, 1))
+    throw std::runtime_error(etree_strerror(etree_errno(dbOut)));
+
+  long numRead = 0;
+  long numWritten = 0;
+  long numSkipped = 0;
+  bool more = true;
+  while (more) {
+    cencalvm::storage::PayloadStruct payload;
+    if (0 != etree_getcursor(dbIn, &addr, "*", &payload))
+      throw std::runtime_error(etree_strerror(etree_errno(dbIn)));
+    ++numRead;
+
+    bool skipSubtree = false;
+    if (!_intersects(addr)) {
+      skipSubtree = (ETREE_INTERIOR == addr.type);
+      if (skipSubtree)
+	++numSkipped;
+    } else {
+      if (_maxLevel >= 0 && addr.level > _maxLevel) {
+	char buf[ETREE_MAXBUF];
+	std::ostringstream msg;
+	msg
+	  << "Octant " << etree_straddr(dbIn, buf, addr)
+	  << " is below the maximum level " << _maxLevel
+	  << " and has no interior ancestor at the maximum level.\n"
+	  << "Etree database '" << _filenameIn << "' must be averaged "
+	  << "before extracting a region with a maximum level.";
+	throw std::runtime_error(msg.str());
+      } else if (_maxLevel >= 0 && addr.level == _maxLevel &&
+		 ETREE_INTERIOR == addr.type) {
+	// Average of subtree becomes leaf in extracted database.
+	addr.type = ETREE_LEAF;
+	skipSubtree = true;
+      } // if/else
+      if (0 != etree_append(dbOut, addr, &payload))
+	throw std::runtime_error(etree_strerror(etree_errno(dbOut)));
+      ++numWritten;
+    } // if/else
+
+    if (skipSubtree) {
+      // Restart cursor at first octant at or after the octant
+      // following the subtree.
+      etree_addr_t addrNext;
+      more = _nextSubtree(&addrNext, addr) &&
+	0 == etree_initcursor(dbIn, addrNext);
+    } else
+      more = (0 == etree_advcursor(dbIn));
+  } // while
+  
+  if (0 != etree_endappend(dbOut))
+    throw std::runtime_error(etree_strerror(etree_errno(dbOut)));
+  
+  if (0 != etree_close(dbIn))
+    throw std::runtime_error(etree_strerror(etree_errno(dbIn)));
+  
+  if (0 != etree_close(dbOut))
+    throw std::runtime_error(etree_strerror(etree_errno(dbOut)));
+
+  if (!_quiet)
+    std::cout
+      << "Done extracting region.\n"
+      << "Number of octants\n"
+      << "  read: " << numRead << ", extracted: " << numWritten
+      << ", subtrees skipped: " << numSkipped << std::endl;
+} // extract
+
+// ----------------------------------------------------------------------
+// Compute bounding box of region in etree ticks.
+void
+cencalvm::create::Extractor::_regionTicks(void)
+{ // _regionTicks
+  assert(0 != _pGeom);
+
+  if (_lonMin > _lonMax || _latMin > _latMax || _elevMin > _elevMax) {
+    std::ostringstream msg;
+    msg
+      << "Bad region for extraction. Minimum values must not be larger "
+      << "than maximum values.\n"
+      << "lon: " << _lonMin << " to " << _lonMax
+      << ", lat: " << _latMin << " to " << _latMax
+      << ", elev: " << _elevMin << " to " << _elevMax;
+    throw std::runtime_error(msg.str());
+  } // if
+
+  // The edges of the region are not straight lines in etree
+  // coordinates, so we sample the region and pad the bounding box by
+  // a fraction of the sample spacing.
+  const int numSamples = 16;
+  double tickMin[3];
+  double tickMax[3];
+  for (int iSample=0; iSample <= numSamples; ++iSample)
+    for (int jSample=0; jSample <= numSamples; ++jSample)
+      for (int kSample=0; kSample <= numSamples; ++kSample) {
+	const double lon = 
+	  _lonMin + (_lonMax - _lonMin) * iSample / numSamples;
+	const double lat = 
+	  _latMin + (_latMax - _latMin) * jSample / numSamples;
+	const double elev = 
+	  _elevMin + (_elevMax - _elevMin) * kSample / numSamples;
+	etree_addr_t addr;
+	addr.level = ETREE_MAXLEVEL;
+	if (0 != _pGeom->lonLatElevToAddr(&addr, lon, lat, elev)) {
+	  std::ostringstream msg;
+	  msg
+	    << "Region for extraction is not within the domain of the "
+	    << "velocity model.\n"
+	    << "Point (" << lon << ", " << lat << ", " << elev
+	    << ") is outside the domain.";
+	  throw std::runtime_error(msg.str());
+	} // if
+	const double ticks[3] = { double(addr.x), double(addr.y), 
+				  double(addr.z) };
+	for (int i=0; i < 3; ++i)
+	  if (0 == iSample + jSample + kSample) {
+	    tickMin[i] = ticks[i];
+	    tickMax[i] = ticks[i];
+	  } else {
+	    tickMin[i] = (ticks[i] < tickMin[i]) ? ticks[i] : tickMin[i];
+	    tickMax[i] = (ticks[i] > tickMax[i]) ? ticks[i] : tickMax[i];
+	  } // if/else
+      } // for
+
+  const double tickRoot = double(0x80000000);
+  for (int i=0; i < 3; ++i) {
+    const double pad = 0.25 * (tickMax[i] - tickMin[i]) / numSamples + 1.0;
+    const double tMin = tickMin[i] - pad;
+    const double tMax = tickMax[i] + pad;
+    _tickMin[i] = (tMin > 0.0) ? etree_tick_t(tMin) : 0;
+    _tickMax[i] = (tMax < tickRoot-1.0) ? 
+      etree_tick_t(tMax) : etree_tick_t(tickRoot-1.0);
+  } // for
+} // _regionTicks
+
+// ----------------------------------------------------------------------
+// Check whether octant intersects bounding box of region.
+bool
+cencalvm::create::Extractor::_intersects(const etree_addr_t& addr) const
+{ // _intersects
+  const etree_tick_t tickLen = ((etree_tick_t) 0x80000000) >> addr.level;
+  const etree_tick_t ticks[3] = { addr.x, addr.y, addr.z };
+  for (int i=0; i < 3; ++i)
+    if (ticks[i] > _tickMax[i] || ticks[i] + (tickLen-1) < _tickMin[i])
+      return false;
+  return true;
+} // _intersects
+
+// ----------------------------------------------------------------------
+// Compute address of first octant following subtree of octant in
+// Morton pre-order.
+bool
+cencalvm::create::Extractor::_nextSubtree(etree_addr_t* pNextAddr,
+					  const etree_addr_t& addr)
+{ // _nextSubtree
+  assert(0 != pNextAddr);
+
+  *pNextAddr = addr;
+  for (int level=addr.level; level > 0; --level) {
+    // Move to next sibling at this level if there is one; otherwise
+    // move up to the parent and try its next sibling.
+    const etree_tick_t bit = ((etree_tick_t) 0x80000000) >> level;
+    pNextAddr->level = level;
+    if (0 == (pNextAddr->x & bit)) {
+      pNextAddr->x |= bit;
+      return true;
+    } // if
+    pNextAddr->x &= ~bit;
+    if (0 == (pNextAddr->y & bit)) {
+      pNextAddr->y |= bit;
+      return true;
+    } // if
+    pNextAddr->y &= ~bit;
+    if (0 == (pNextAddr->z & bit)) {
+      pNextAddr->z |= bit;
+      return true;
+    } // if
+    pNextAddr->z &= ~bit;
+  } // for
+
+  return false;
+} // _nextSubtree
+
+// End of file 
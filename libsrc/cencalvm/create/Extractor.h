@@ -0,0 +1,181 @@
+// -*- C++ -*-
+//
+// ======================================================================
+//
+//                           Brad T. Aagaard
+//                        U.S. Geological Survey
+//
+// {LicenseText}
+//
+// ======================================================================
+//
+
+/** @file libsrc/create/Extractor.h
+ *
+ * @brief C++ object for extracting the octants of an etree database
+ * that intersect a region of interest into a packed sub-database.
+ *
+ * The region is a box in longitude, latitude, and elevation. The
+ * octants of the input database are streamed with a cursor in Morton
+ * pre-order and octants intersecting the region are appended to the
+ * output database. Subtrees of interior octants that do not intersect
+ * the region are skipped by moving the cursor past them. Queries of
+ * the sub-database return the same values as queries of the full
+ * database at locations inside the region.
+ */
+
+#if !defined(cencalvm_create_extractor_h)
+#define cencalvm_create_extractor_h
+
+#include "cencalvm/storage/etreefwd.h" // USES etree_addr_t
+
+#include <string> // HASA std::string
+
+namespace cencalvm {
+  namespace create {
+    class Extractor;
+    class TestExtractor; // friend
+  } // namespace create
+  namespace storage {
+    class Geometry; // HOLDSA Geometry
+  } // namespace storage
+} // namespace cencalvm
+
+/// C++ object for extracting the octants of an etree database that
+/// intersect a region of interest into a packed sub-database.
+class cencalvm::create::Extractor
+{ // Extractor
+  friend class TestExtractor;
+
+public :
+  // PUBLIC METHODS /////////////////////////////////////////////////////
+
+  /// Constructor
+  Extractor(void);
+
+  /// Destructor
+  ~Extractor(void);
+
+  /** Set filename of input database.
+   *
+   * @param filename Name of file
+   */
+  void filenameIn(const char* filename);
+
+  /** Set filename of output (extracted) database.
+   *
+   * @param filename Name of file
+   */
+  void filenameOut(const char* filename);
+
+  /** Set database cache size.
+   *
+   * @param size Size of cache in MB
+   */
+  void cacheSize(const int size);
+
+  /** Set geometry of velocity model.
+   *
+   * @param pGeom Pointer to velocity model geometry
+   */
+  void geometry(const storage::Geometry* pGeom);
+
+  /** Set region of interest.
+   *
+   * @param lonMin Minimum longitude in degrees
+   * @param lonMax Maximum longitude in degrees
+   * @param latMin Minimum latitude in degrees
+   * @param latMax Maximum latitude in degrees
+   * @param elevMin Minimum elevation wrt MSL in meters
+   * @param elevMax Maximum elevation wrt MSL in meters
+   */
+  void region(const double lonMin,
+	      const double lonMax,
+	      const double latMin,
+	      const double latMax,
+	      const double elevMin,
+	      const double elevMax);
+
+  /** Set maximum level of octants in extracted database.
+   *
+   * Interior octants at the maximum level become leaf octants in the
+   * extracted database, so the input database must have been
+   * averaged. Default behavior is to keep octants at all levels.
+   *
+   * @param level Maximum level (negative for no maximum)
+   */
+  void maxLevel(const int level);
+
+  /// Extract octants intersecting region of interest.
+  void extract(void);
+
+  /** Set flag indicating extraction should be quiet (no progress
+   * reports).
+   *
+   * Default behavior is for to give progress reports.
+   *
+   * @param flag True for quiet operation, false to give progress reports
+   */
+  void quiet(const bool flag);
+
+private :
+  // PRIVATE METHODS ////////////////////////////////////////////////////
+
+  /// Compute bounding box of region in etree ticks.
+  void _regionTicks(void);
+
+  /** Check whether octant intersects bounding box of region.
+   *
+   * @param addr Address of octant
+   *
+   * @returns True if octant intersects region, false otherwise
+   */
+  bool _intersects(const etree_addr_t& addr) const;
+
+  /** Compute address of first octant following subtree of octant in
+   * Morton pre-order.
+   *
+   * @param pNextAddr Pointer to address of next octant
+   * @param addr Address of root of subtree
+   *
+   * @returns True if there is a following octant, false otherwise
+   */
+  static bool _nextSubtree(etree_addr_t* pNextAddr,
+			   const etree_addr_t& addr);
+
+private :
+  // NOT IMPLEMENTED ////////////////////////////////////////////////////
+
+  Extractor(const Extractor& e); ///< Not implemented
+  const Extractor& operator=(const Extractor& e); ///< Not implemented
+
+private :
+  // PRIVATE MEMBERS ////////////////////////////////////////////////////
+
+  std::string _filenameIn; ///< Filename of input database
+  std::string _filenameOut; ///< Filename of output database
+
+  int _cacheSize; ///< Size of database cache in MB
+  int _maxLevel; ///< Maximum level of octants (negative for no maximum)
+
+  double _lonMin; ///< Minimum longitude of region in degrees
+  double _lonMax; ///< Maximum longitude of region in degrees
+  double _latMin; ///< Minimum latitude of region in degrees
+  double _latMax; ///< Maximum latitude of region in degrees
+  double _elevMin; ///< Minimum elevation of region in meters
+  double _elevMax; ///< Maximum elevation of region in meters
+
+  etree_tick_t _tickMin[3]; ///< Minimum x, y, z ticks of region
+  etree_tick_t _tickMax[3]; ///< Maximum x, y, z ticks of region
+
+  storage::Geometry* _pGeom; ///< Pointer to velocity model geometry
+
+  bool _quiet; ///< Flag to eliminate progress reports
+
+}; // Extractor
+
+#include "Extractor.icc" // inline methods
+
+#endif // cencalvm_create_extractor_h
+
+// End of file 
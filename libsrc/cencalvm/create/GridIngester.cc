@@ -13,21 +13,21 @@
 #include "GridIngester.h" // implementation of class methods
 
 #include "VMCreator.h" // USES VMCreator
-#include "cencalvm/storage/Payload.h" // USES PayloadStruct
+#include "GridParser.h" // USES GridParser
 #include "cencalvm/storage/Geometry.h" // USES Geometry
-
-extern "C" {
-#include "etree.h"
-}
+#include "cencalvm/storage/Telemetry.h" // USES Telemetry
+#include "cencalvm/storage/DBSnapshot.h" // USES DBSnapshot
+#include "cencalvm/average/AvgEngine.h" // USES AvgEngine
 
 #include <vector> // USES std::vector
-#include <math.h> // USES fabs()
+
+#include <stdio.h> // USES remove()
+#include <sys/stat.h> // USES stat()
 
 #include <fstream> // USES std::ifstream
 #include <iostream> // USES std::cout
 #include <stdexcept> // USES std::runtime_error
 #include <sstream> // USES std::ostringstream
-#include <iomanip> // USES std::resetiosflags(), std::setprecision()
 #include <assert.h> // USES assert()
 
 // ----------------------------------------------------------------------
@@ -39,6 +39,12 @@ cencalvm::create::GridIngester::GridIngester(void) :
   _cacheSize(64),
   _description(""),
   _pGeom(0),
+  _pTelemetry(0),
+  _numThreads(0),
+  _sortSize(0),
+  _average(false),
+  _checkpointInterval(0),
+  _resume(false),
   _quiet(false)
 { // constructor
 } // constructor
@@ -67,24 +73,82 @@ cencalvm::create::GridIngester::run(void) const
   assert(std::string("") != _filenameTmp);
   assert(std::string("") != _filenameOut);
 
+  if (_average && 0 == _sortSize)
+    throw std::runtime_error("Averaging while building the database "
+			     "requires sorting the points.");
+
   VMCreator creator;
   creator.quiet(_quiet);
+  creator.numThreads(_numThreads);
+  creator.telemetry(_pTelemetry);
 
   std::string* pGridFilenames = 0;
   int numGrids = 0;
   _readParams(&pGridFilenames, &numGrids);
   
-  creator.openDB(_filenameTmp.c_str(),
-		 _cacheSize,
-		 _description.c_str());
-
-  for (int iGrid=0; iGrid < numGrids; ++iGrid)
-    _addGrid(&creator, pGridFilenames[iGrid].c_str());
+  const std::string filenameCheckpoint = _filenameOut + ".checkpoint";
+  GridParser parser;
+  parser.geometry(_pGeom);
+  parser.numThreads(_numThreads);
+  parser.checkpoint(filenameCheckpoint.c_str(), _checkpointInterval);
+  parser.resume(_resume);
+  parser.quiet(_quiet);
+  parser.telemetry(_pTelemetry);
+
+  if (_average)
+    creator.openAveragedDB(_filenameOut.c_str(),
+			   _cacheSize,
+			   _description.c_str(),
+			   _filenameTmp.c_str(),
+			   _sortSize,
+			   cencalvm::average::AvgEngine::DEFAULTBUFFERSIZE);
+  else if (_sortSize > 0)
+    creator.openSortedDB(_filenameOut.c_str(),
+			 _cacheSize,
+			 _description.c_str(),
+			 _filenameTmp.c_str(),
+			 _sortSize);
+  else if (_resume) {
+    parser.restoreDB(_filenameTmp.c_str());
+    creator.reopenDB(_filenameTmp.c_str(),
+		     _cacheSize);
+  } else
+    creator.openDB(_filenameTmp.c_str(),
+		   _cacheSize,
+		   _description.c_str());
+
+  if (0 != _pTelemetry) {
+    // Progress of ingesting is measured by bytes of grid files read.
+    uint64_t numBytesTotal = 0;
+    for (int iGrid=0; iGrid < numGrids; ++iGrid) {
+      struct stat fileInfo;
+      if (0 == stat(pGridFilenames[iGrid].c_str(), &fileInfo))
+	numBytesTotal += fileInfo.st_size;
+    } // for
+    _pTelemetry->beginPhase("ingest", 0, numBytesTotal);
+    if (0 == _sortSize)
+      _pTelemetry->cacheSize(_cacheSize);
+  } // if
+  try {
+    parser.ingest(&creator, pGridFilenames, numGrids);
+  } catch (...) {
+    delete[] pGridFilenames; pGridFilenames = 0;
+    throw;
+  } // try/catch
+  delete[] pGridFilenames; pGridFilenames = 0;
+  if (0 != _pTelemetry)
+    _pTelemetry->endPhase();
 
   creator.closeDB();
 
-  creator.packDB(_filenameOut.c_str(), _filenameTmp.c_str(),
-		 _cacheSize);
+  if (0 == _sortSize)
+    creator.packDB(_filenameOut.c_str(), _filenameTmp.c_str(),
+		   _cacheSize);
+
+  if (_checkpointInterval > 0 || _resume) {
+    remove(filenameCheckpoint.c_str());
+    storage::DBSnapshot::remove(_filenameTmp.c_str());
+  } // if
 } // run
 
 // ----------------------------------------------------------------------
@@ -132,155 +196,6 @@ cencalvm::create::GridIngester::_readParams(std::string** ppGridFilenames,
   *pNumGrids = numGrids;
 } // _readParams
 
-// ----------------------------------------------------------------------
-// Add gridded data to database.
-void
-cencalvm::create::GridIngester::_addGrid(VMCreator* pCreator,
-					 const char* filename) const
-{ // addGrid
-  assert(0 != pCreator);
-  assert(0 != _pGeom);
-
-  std::ifstream fin(filename);
-  if (!fin.is_open()) {
-    std::ostringstream msg;
-    msg << "Could not open grid file '" << filename
-	<< "' for reading.";
-    throw std::runtime_error(msg.str());
-  } // if
-
-  if (!_quiet)
-    std::cout
-      << "Beginning processing of '" << filename << "'..." << std::endl;
-  
-  int numAdded = 0;
-  int numIgnored = 0;
-  try {
-    double resHoriz = 0.0;
-    double resVert = 0.0;
-    int numX = 0;
-    int numY = 0;
-    int numZ = 0;
-    int numTotal = 0;
-    fin >> resHoriz >> resVert >> numX >> numY >> numZ >> numTotal;
-    if (0.0 == resHoriz ||
-	0.0 == resVert) {
-      std::ostringstream msg;
-      msg << "Could not read horizontal and vertical resolution in '"
-	  << filename << "'.";
-      std::runtime_error(msg.str());
-    } // if
-    // convert resHoriz and resVert from km to m
-    resHoriz *= 1.0e+3;
-    resVert *= 1.0e+3;
-  
-    const double tolerance = 1.0e-6;
-    const double vertExag = resHoriz / resVert;
-    const double vertExagE = _pGeom->vertExag();
-    if (fabs(1.0 - vertExag/vertExagE) > tolerance) {
-      std::ostringstream msg;
-      msg << "Vertical exaggeration of " << vertExag << " in '" << filename
-	  << "' does not match velocity model vertical exaggeration of "
-	  << vertExagE << ".";
-      throw std::runtime_error(msg.str());
-    } // if
-
-    const etree_tick_t level = _pGeom->level(resHoriz);
-    const double edgeLen = _pGeom->edgeLen(level);
-    if ( fabs(1.0 - resHoriz/edgeLen) > tolerance) {
-      std::ostringstream msg;
-      msg << "Horizontal resolution of " << resHoriz << " in '" << filename
-	  << "' does not fit resolution of nearest level in database of "
-	  << edgeLen << ".";
-      throw std::runtime_error(msg.str());
-    } // if    
-
-    for (int i=0; i < numTotal; ++i) {
-      double lon = 0.0;
-      double lat = 0.0;
-      double elev = 0.0;
-      int volID = 0;
-      storage::PayloadStruct payload;
-      fin
-	>> lon
-	>> lat
-	>> elev
-	>> payload.Vp
-	>> payload.Vs
-	>> payload.Density
-	>> payload.Qp
-	>> payload.Qs
-	>> payload.DepthFreeSurf
-	>> payload.FaultBlock
-	>> payload.Zone
-	>> volID;
-      if (!fin.good())
-	throw std::runtime_error("Couldn't parse line.");
-      if (payload.FaultBlock != cencalvm::storage::Payload::NODATABLOCK &&
-	  payload.Zone != cencalvm::storage::Payload::NODATAZONE) {
-	// convert elev and depth from km to m
-	if (elev != cencalvm::storage::Payload::NODATAVAL)
-	  elev *= 1.0e+3;
-	if (payload.DepthFreeSurf != cencalvm::storage::Payload::NODATAVAL)
-	  payload.DepthFreeSurf *= 1.0e+3;
-      
-	// convert Vp & Vs from km/s to m/s
-	if (payload.Vp != cencalvm::storage::Payload::NODATAVAL)
-	  payload.Vp *= 1.0e+3;
-	if (payload.Vs != cencalvm::storage::Payload::NODATAVAL)
-	  payload.Vs *= 1.0e+3;
-      
-	// convert Density from g/cm^3 to kg/m^3
-	if (payload.Density != cencalvm::storage::Payload::NODATAVAL)
-	  payload.Density *= 1.0e+3;
-    
-	pCreator->insert(payload, lon, lat, elev, resHoriz, _pGeom);
-	numAdded++;
-      } else {
-	// convert elev and depth from km to m
-	if (elev != cencalvm::storage::Payload::NODATAVAL)
-	  elev *= 1.0e+3;
-	if (payload.DepthFreeSurf != cencalvm::storage::Payload::NODATAVAL)
-	  payload.DepthFreeSurf *= 1.0e+3;
-
-	if (payload.FaultBlock != cencalvm::storage::Payload::NODATABLOCK) {
-	  if (!_quiet)
-	    std::cerr 
-	      << std::resetiosflags(std::ios::fixed)
-	      << std::setiosflags(std::ios::scientific)
-	      << std::setprecision(6)
-	      << lon << ", " << lat << ", " << elev << ", No fault block\n";
-	  numIgnored++;
-	} else {
-	  if (!_quiet)
-	    std::cerr
-	      << std::resetiosflags(std::ios::fixed)
-	      << std::setiosflags(std::ios::scientific)
-	      << std::setprecision(6)
-	      << lon << ", " << lat << ", " << elev << ", Ignoring\n";
-	  numIgnored++;
-	} // if/else
-      
-      } // if/else
-    } // for
-
-    fin.close();
-  } catch (const std::exception& err) {
-    std::cerr
-      << "Caught error while reading grid from '" << filename << "'.\n"
-      << "Successfully added " << numAdded << " points and ignored "
-      << numIgnored << " others.\n"
-      << "Error message: " << err.what();
-    throw std::runtime_error(err.what());
-  } // if
-
-  if (!_quiet)
-    std::cout << "Done procesing '" << filename << "'."
-	      << "  # points added: " << numAdded
-	      << ",  # points ignored: " << numIgnored
-	      << std::endl;
-} // addGrid
-
 // version
 // $Id$
 
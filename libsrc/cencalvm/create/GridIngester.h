@@ -20,6 +20,7 @@
 #define cencalvm_create_gridingester_h
 
 #include <string> // HASA std::string
+#include <sys/types.h> // USES size_t
 
 namespace cencalvm {
   namespace create {
@@ -29,6 +30,7 @@ namespace cencalvm {
   } // namespace create
   namespace storage {
     class Geometry; // HOLDSA Geometry
+    class Telemetry; // HOLDSA Telemetry
   } // namespace storage
 } // namespace cencalvm
 
@@ -83,6 +85,71 @@ public :
    */
   void geometry(const storage::Geometry* pGeom);
 
+  /** Set number of threads used to parse grids and to read the
+   * unpacked database when packing it.
+   *
+   * Default behavior is to use one thread per processor.
+   *
+   * @param num Number of threads (0 to use number of processors)
+   */
+  void numThreads(const int num);
+
+  /** Set size of memory used to sort points when building the packed
+   * database directly.
+   *
+   * Default behavior (size of 0) is to insert the points into the
+   * temporary database and then pack it. With a positive size, the
+   * points are sorted into etree order and appended to the packed
+   * database; the temporary filename is used as the root name for
+   * sorted runs that do not fit in memory.
+   *
+   * @param size Size of memory in MB
+   */
+  void sortSize(const int size);
+
+  /** Set flag indicating the database should be spatially averaged
+   * while it is built.
+   *
+   * Averaging requires sorting the points (positive sort size). The
+   * sorted points are averaged as they are appended, so the averaged
+   * database is written directly without an unaveraged database.
+   *
+   * @param flag True to average database, false otherwise
+   */
+  void average(const bool flag);
+
+  /** Set number of points ingested between checkpoints.
+   *
+   * Checkpoints record the grid file and the number of its points
+   * that have been ingested in the file filenameOut.checkpoint after
+   * making the points inserted so far durable. Sorted databases write
+   * the points in memory as a sorted run at each checkpoint, so the
+   * interval should be large compared to the number of points that
+   * fit in the sorting memory. Unpacked databases are copied to a
+   * snapshot at each checkpoint, so the interval should be large
+   * enough that copying the database is a small part of ingesting.
+   * Default behavior (0) is no checkpoints.
+   *
+   * @param numPoints Number of points between checkpoints
+   */
+  void checkpointInterval(const size_t numPoints);
+
+  /** Set flag indicating creation should resume from the last
+   * checkpoint of an interrupted run with the same parameters.
+   *
+   * @param flag True to resume from checkpoint, false to start at
+   * beginning
+   */
+  void resume(const bool flag);
+
+  /** Set telemetry for reporting progress of ingesting the grids
+   * (phase "ingest") and of merging, averaging, or packing the
+   * database.
+   *
+   * @param pTelemetry Pointer to telemetry (0 for none)
+   */
+  void telemetry(storage::Telemetry* pTelemetry);
+
   /// Create the database by ingesting the grids
   void run(void) const;
 
@@ -105,14 +172,6 @@ private :
   void _readParams(std::string** pGridFilenames,
 		   int* pNumGrids) const;
 
-  /** Add gridded data to database.
-   *
-   * @param pCreator Pointer to database creator
-   * @param filename Filename of gridded data
-   */
-  void _addGrid(VMCreator* pCreator,
-		const char* filename) const;
-
 private :
   // PRIVATE MEMBERS ////////////////////////////////////////////////////
 
@@ -124,6 +183,13 @@ private :
   std::string _description; ///< Description of database
 
   storage::Geometry* _pGeom; ///< Pointer to velocity model geometry
+  storage::Telemetry* _pTelemetry; ///< Pointer to telemetry
+
+  int _numThreads; ///< Number of threads used to parse grids and pack
+  int _sortSize; ///< Size of memory used to sort points in MB
+  bool _average; ///< Flag to average database while building it
+  size_t _checkpointInterval; ///< Number of points between checkpoints
+  bool _resume; ///< Flag to resume from checkpoint
 
   bool _quiet; ///< Flag to eliminate progress reports
 
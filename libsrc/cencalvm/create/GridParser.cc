@@ -0,0 +1,979 @@
+// -*- C++ -*-
+//
+// ======================================================================
+//
+//                           Brad T. Aagaard
+//                        U.S. Geological Survey
+//
+// {LicenseText}
+//
+// ======================================================================
+//
+
+#include <portinfo>
+
+#include "GridParser.h" // implementation of class methods
+
+#include "VMCreator.h" // USES VMCreator
+#include "BinaryGrid.h" // USES BinaryGrid
+#include "cencalvm/storage/Payload.h" // USES PayloadStruct
+#include "cencalvm/storage/Geometry.h" // USES Geometry
+#include "cencalvm/storage/Telemetry.h" // USES Telemetry
+#include "cencalvm/storage/DBSnapshot.h" // USES DBSnapshot
+
+extern "C" {
+#include "etree.h"
+}
+
+#include <vector> // USES std::vector
+#include <deque> // USES std::deque
+#include <thread> // USES std::thread
+#include <mutex> // USES std::mutex
+#include <condition_variable> // USES std::condition_variable
+#if defined(HAVE_FLOAT_FROM_CHARS)
+#include <charconv> // USES std::from_chars()
+#endif
+
+#include <sys/mman.h> // USES mmap(), munmap(), madvise()
+#include <sys/stat.h> // USES fstat()
+#include <fcntl.h> // USES open()
+#include <unistd.h> // USES close()
+#include <stdlib.h> // USES strtod()
+#include <ctype.h> // USES isspace()
+#include <math.h> // USES fabs()
+
+#include <stdio.h> // USES rename()
+
+#include <iostream> // USES std::cout
+#include <fstream> // USES std::ifstream, std::ofstream
+#include <stdexcept> // USES std::runtime_error
+#include <sstream> // USES std::ostringstream
+#include <iomanip> // USES std::resetiosflags(), std::setprecision()
+#include <assert.h> // USES assert()
+
+// ----------------------------------------------------------------------
+// Memory mapped grid file.
+struct cencalvm::create::GridParser::GridFileStruct {
+  std::string filename; ///< Name of file
+  std::string error; ///< Error detected while opening file
+  std::vector<size_t> chunkOffsets; ///< Offsets of chunks (plus end of file)
+  const char* pData; ///< Mapped contents of file
+  size_t size; ///< Size of file in bytes
+  int fd; ///< File descriptor
+  bool isOpen; ///< True if file was opened
+  bool isBinary; ///< True if file is a binary grid
+  double resHoriz; ///< Horizontal resolution in m
+  int numTotal; ///< Number of points in file
+  int level; ///< Level of octants in etree
+}; // GridFileStruct
+
+// ----------------------------------------------------------------------
+// Chunk of grid file and parsed points.
+struct cencalvm::create::GridParser::ChunkStruct {
+  GridFileStruct* pFile; ///< File containing chunk
+  int index; ///< Index of chunk in file
+  bool isLast; ///< True if last chunk in file
+  bool isDone; ///< True if chunk has been parsed
+  std::string error; ///< Error detected while parsing chunk
+  int numPoints; ///< Number of points successfully parsed
+  const BinaryGridRecordStruct* pRecords; ///< Mapped records (binary grid)
+
+  std::vector<double> lon;
+  std::vector<double> lat;
+  std::vector<double> elev;
+  std::vector<float> vp;
+  std::vector<float> vs;
+  std::vector<float> density;
+  std::vector<float> qp;
+  std::vector<float> qs;
+  std::vector<float> depthFreeSurf;
+  std::vector<int16_t> faultBlock;
+  std::vector<int16_t> zone;
+  std::vector<etree_addr_t> addrs;
+}; // ChunkStruct
+
+// ----------------------------------------------------------------------
+// Work queue shared with parsing threads.
+struct cencalvm::create::GridParser::WorkStruct {
+  std::mutex mutex; ///< Mutex protecting queue and chunk status
+  std::condition_variable chunkQueued; ///< Signal chunk added to queue
+  std::condition_variable chunkDone; ///< Signal chunk parsed
+  std::deque<ChunkStruct*> queue; ///< Chunks waiting to be parsed
+  bool isFinished; ///< True if threads should exit
+}; // WorkStruct
+
+// ----------------------------------------------------------------------
+// Constructor
+cencalvm::create::GridParser::GridParser(void) :
+  _pGeom(0),
+  _pTelemetry(0),
+  _chunkSize(16*1024*1024),
+  _numThreads(0),
+  _filenameCheckpoint(""),
+  _checkpointInterval(0),
+  _resume(false),
+  _checkpointSlot(-1),
+  _quiet(false)
+{ // constructor
+} // constructor
+
+// ----------------------------------------------------------------------
+// Destructor
+cencalvm::create::GridParser::~GridParser(void)
+{ // destructor
+  delete _pGeom; _pGeom = 0;
+} // destructor
+
+// ----------------------------------------------------------------------
+// Set velocity model geometry
+void
+cencalvm::create::GridParser::geometry(const storage::Geometry* pGeom)
+{ // geometry
+  delete _pGeom; _pGeom = (0 != pGeom) ? pGeom->clone() : 0;
+} // geometry
+
+// ----------------------------------------------------------------------
+// Set number of threads used to parse grids.
+void
+cencalvm::create::GridParser::numThreads(const int num)
+{ // numThreads
+  if (num >= 0)
+    _numThreads = num;
+} // numThreads
+
+// ----------------------------------------------------------------------
+// Set approximate size of chunks of grid files parsed by each thread.
+void
+cencalvm::create::GridParser::chunkSize(const size_t size)
+{ // chunkSize
+  if (size > 0)
+    _chunkSize = size;
+} // chunkSize
+
+// ----------------------------------------------------------------------
+// Set flag indicating parsing should be quiet (no progress reports).
+void
+cencalvm::create::GridParser::quiet(const bool flag)
+{ // quiet
+  _quiet = flag;
+} // quiet
+
+// ----------------------------------------------------------------------
+// Set telemetry for reporting bytes of grid files read.
+void
+cencalvm::create::GridParser::telemetry(storage::Telemetry* pTelemetry)
+{ // telemetry
+  _pTelemetry = pTelemetry;
+} // telemetry
+
+// ----------------------------------------------------------------------
+// Set file and interval for checkpoints.
+void
+cencalvm::create::GridParser::checkpoint(const char* filename,
+					 const size_t numPoints)
+{ // checkpoint
+  assert(0 != filename);
+
+  _filenameCheckpoint = filename;
+  _checkpointInterval = numPoints;
+} // checkpoint
+
+// ----------------------------------------------------------------------
+// Set flag indicating ingestion should resume from the checkpoint file.
+void
+cencalvm::create::GridParser::resume(const bool flag)
+{ // resume
+  _resume = flag;
+} // resume
+
+// ----------------------------------------------------------------------
+// Replace unpacked database with its snapshot at the checkpoint.
+void
+cencalvm::create::GridParser::restoreDB(const char* filenameDB) const
+{ // restoreDB
+  assert(0 != filenameDB);
+
+  int iGrid = 0;
+  int numPoints = 0;
+  int numRuns = 0;
+  size_t numOctants = 0;
+  int slot = 0;
+  uint64_t length = 0;
+  _readCheckpoint(&iGrid, &numPoints, &numRuns, &numOctants, &slot, &length);
+  storage::DBSnapshot::restore(filenameDB, slot, length);
+} // restoreDB
+
+// ----------------------------------------------------------------------
+// Parse grid files and insert the points into the database.
+void
+cencalvm::create::GridParser::ingest(VMCreator* pCreator,
+				     const std::string* filenames,
+				     const int numGrids)
+{ // ingest
+  assert(0 != pCreator);
+  assert(0 != _pGeom);
+  assert(0 != filenames || 0 == numGrids);
+
+  int iGridStart = 0;
+  int numSkip = 0; // points of first grid inserted before resuming
+  if (_resume) {
+    int numRuns = 0;
+    size_t numOctants = 0;
+    uint64_t length = 0;
+    _readCheckpoint(&iGridStart, &numSkip, &numRuns, &numOctants,
+		    &_checkpointSlot, &length);
+    if (iGridStart > numGrids) {
+      std::ostringstream msg;
+      msg << "Checkpoint file '" << _filenameCheckpoint << "' refers to grid "
+	  << "file " << iGridStart << ", but there are only " << numGrids
+	  << " grid files.";
+      throw std::runtime_error(msg.str());
+    } // if
+    pCreator->resume(numRuns, numOctants);
+    if (!_quiet && iGridStart < numGrids)
+      std::cout
+	<< "Resuming after point " << numSkip << " of '"
+	<< filenames[iGridStart] << "'." << std::endl;
+  } // if
+
+  int numThreads = _numThreads;
+  if (numThreads <= 0)
+    numThreads = std::thread::hardware_concurrency();
+  if (numThreads <= 0)
+    numThreads = 1;
+  // Keep enough chunks in flight for each thread to have one waiting.
+  const size_t maxInFlight = 2*numThreads;
+
+  // Start parsing threads; each thread needs its own geometry
+  // because projections are not thread safe.
+  WorkStruct work;
+  work.isFinished = false;
+  std::vector<storage::Geometry*> threadGeoms(numThreads);
+  std::vector<std::thread> threads;
+  for (int iThread=0; iThread < numThreads; ++iThread) {
+    threadGeoms[iThread] = _pGeom->clone();
+    threads.push_back(std::thread(&GridParser::_work, &work,
+				  threadGeoms[iThread]));
+  } // for
+
+  std::vector<GridFileStruct> files(numGrids);
+  for (int iGrid=0; iGrid < numGrids; ++iGrid) {
+    files[iGrid].filename = filenames[iGrid];
+    files[iGrid].pData = 0;
+    files[iGrid].size = 0;
+    files[iGrid].fd = -1;
+    files[iGrid].isOpen = false;
+    files[iGrid].isBinary = false;
+    files[iGrid].resHoriz = 0.0;
+    files[iGrid].numTotal = 0;
+    files[iGrid].level = 0;
+  } // for
+
+  std::deque<ChunkStruct*> inFlight;
+  std::string errorMsg = "";
+  bool isError = false;
+  try {
+    int iFileNext = iGridStart; // file of next chunk to parse
+    int iChunkNext = 0; // index of next chunk to parse in file
+    int numAdded = 0;
+    int numIgnored = 0;
+    int numRemaining = 0;
+    size_t numSinceCheckpoint = 0;
+    while (true) {
+      // Queue chunks for parsing
+      while (inFlight.size() < maxInFlight && iFileNext < numGrids) {
+	GridFileStruct& file = files[iFileNext];
+	if (0 == iChunkNext)
+	  _openGrid(&file);
+	const int numChunks = (file.error.empty()) ?
+	  file.chunkOffsets.size() - 1 : 1;
+
+	ChunkStruct* pChunk = new ChunkStruct;
+	pChunk->pFile = &file;
+	pChunk->index = iChunkNext;
+	pChunk->isLast = (iChunkNext+1 == numChunks);
+	pChunk->numPoints = 0;
+	pChunk->pRecords = 0;
+	pChunk->isDone = !file.error.empty();
+	inFlight.push_back(pChunk);
+	if (!pChunk->isDone) {
+	  { // scope for lock
+	    std::lock_guard<std::mutex> lock(work.mutex);
+	    work.queue.push_back(pChunk);
+	  } // scope for lock
+	  work.chunkQueued.notify_one();
+	} // if
+
+	if (++iChunkNext >= numChunks) {
+	  ++iFileNext;
+	  iChunkNext = 0;
+	} // if
+      } // while
+      if (inFlight.empty())
+	break;
+
+      // Wait for next chunk in insertion order
+      ChunkStruct* pChunk = inFlight.front();
+      { // scope for lock
+	std::unique_lock<std::mutex> lock(work.mutex);
+	while (!pChunk->isDone)
+	  work.chunkDone.wait(lock);
+      } // scope for lock
+      inFlight.pop_front();
+
+      GridFileStruct& file = *pChunk->pFile;
+      if (0 == pChunk->index) {
+	if (!file.isOpen) {
+	  delete pChunk; pChunk = 0;
+	  throw std::runtime_error(file.error);
+	} // if
+	if (!_quiet)
+	  std::cout
+	    << "Beginning processing of '" << file.filename << "'..."
+	    << std::endl;
+	numAdded = 0;
+	numIgnored = 0;
+	numRemaining = file.numTotal;
+	if (numSkip > file.numTotal) {
+	  delete pChunk; pChunk = 0;
+	  std::ostringstream msg;
+	  msg << "Checkpoint file '" << _filenameCheckpoint << "' refers to "
+	      << "point " << numSkip << " of '" << file.filename
+	      << "', but the file has only " << file.numTotal << " points.";
+	  throw std::runtime_error(msg.str());
+	} // if
+      } // if
+
+      const int numInsert = (pChunk->numPoints < numRemaining) ?
+	pChunk->numPoints : numRemaining;
+      try {
+	if (!file.error.empty())
+	  throw std::runtime_error(file.error);
+	const int numResumed = (numSkip < numInsert) ? numSkip : numInsert;
+	_insertChunk(pCreator, *pChunk, numResumed, numInsert,
+		     &numAdded, &numIgnored);
+	numSkip -= numResumed;
+	numRemaining -= numInsert;
+	if (numRemaining > 0 && !pChunk->error.empty())
+	  throw std::runtime_error(pChunk->error);
+	if (numRemaining > 0 && pChunk->isLast)
+	  throw std::runtime_error("Couldn't parse line.");
+      } catch (const std::exception& err) {
+	std::cerr
+	  << "Caught error while reading grid from '" << file.filename
+	  << "'.\n"
+	  << "Successfully added " << numAdded << " points and ignored "
+	  << numIgnored << " others.\n"
+	  << "Error message: " << err.what();
+	delete pChunk; pChunk = 0;
+	throw std::runtime_error(err.what());
+      } // catch
+      if (0 != _pTelemetry)
+	_pTelemetry->addBytesRead(file.chunkOffsets[pChunk->index+1] -
+				  file.chunkOffsets[pChunk->index]);
+
+      if (pChunk->isLast) {
+	_closeGrid(&file);
+	if (!_quiet)
+	  std::cout << "Done procesing '" << file.filename << "'."
+		    << "  # points added: " << numAdded
+		    << ",  # points ignored: " << numIgnored
+		    << std::endl;
+      } // if
+      const int iGrid = pChunk->pFile - &files[0];
+      delete pChunk; pChunk = 0;
+
+      numSinceCheckpoint += numInsert;
+      if (_checkpointInterval > 0 &&
+	  numSinceCheckpoint >= _checkpointInterval) {
+	_writeCheckpoint(pCreator, iGrid, file.numTotal - numRemaining);
+	numSinceCheckpoint = 0;
+      } // if
+    } // while
+  } catch (const std::exception& err) {
+    isError = true;
+    errorMsg = err.what();
+  } // catch
+
+  // Stop parsing threads
+  { // scope for lock
+    std::lock_guard<std::mutex> lock(work.mutex);
+    work.queue.clear();
+    work.isFinished = true;
+  } // scope for lock
+  work.chunkQueued.notify_all();
+  for (int iThread=0; iThread < numThreads; ++iThread) {
+    threads[iThread].join();
+    delete threadGeoms[iThread]; threadGeoms[iThread] = 0;
+  } // for
+
+  while (!inFlight.empty()) {
+    delete inFlight.front();
+    inFlight.pop_front();
+  } // while
+  for (int iGrid=0; iGrid < numGrids; ++iGrid)
+    _closeGrid(&files[iGrid]);
+
+  if (isError)
+    throw std::runtime_error(errorMsg);
+} // ingest
+
+// ----------------------------------------------------------------------
+// Open and memory map grid file, read and check header, and divide
+// body of file into chunks.
+void
+cencalvm::create::GridParser::_openGrid(GridFileStruct* pFile) const
+{ // _openGrid
+  assert(0 != pFile);
+  assert(0 != _pGeom);
+
+  const char* filename = pFile->filename.c_str();
+
+  pFile->fd = open(filename, O_RDONLY);
+  struct stat fileInfo;
+  if (pFile->fd < 0 || 0 != fstat(pFile->fd, &fileInfo)) {
+    std::ostringstream msg;
+    msg << "Could not open grid file '" << filename
+	<< "' for reading.";
+    pFile->error = msg.str();
+    return;
+  } // if
+  pFile->size = fileInfo.st_size;
+  if (pFile->size > 0) {
+    void* pData = mmap(0, pFile->size, PROT_READ, MAP_PRIVATE, pFile->fd, 0);
+    if (MAP_FAILED == pData) {
+      std::ostringstream msg;
+      msg << "Could not open grid file '" << filename
+	  << "' for reading.";
+      pFile->error = msg.str();
+      return;
+    } // if
+    madvise(pData, pFile->size, MADV_SEQUENTIAL);
+    pFile->pData = (const char*) pData;
+  } // if
+  pFile->isOpen = true;
+
+  const BinaryGridHeaderStruct* pHeader = 0;
+  try {
+    pHeader = BinaryGrid::header(pFile->pData, pFile->size);
+  } catch (const std::exception& err) {
+    pFile->error = err.what();
+    return;
+  } // try/catch
+  pFile->isBinary = (0 != pHeader);
+
+  const char* cur = pFile->pData;
+  const char* end = pFile->pData + pFile->size;
+  double resHoriz = 0.0;
+  double resVert = 0.0;
+  int numX = 0;
+  int numY = 0;
+  int numZ = 0;
+  int numTotal = 0;
+  if (pFile->isBinary) {
+    resHoriz = pHeader->resHoriz;
+    resVert = pHeader->resVert;
+    numTotal = pHeader->numTotal;
+    cur += sizeof(BinaryGridHeaderStruct);
+  } else if (!_parseValue(&cur, end, &resHoriz) ||
+	     !_parseValue(&cur, end, &resVert) ||
+	     !_parseValue(&cur, end, &numX) ||
+	     !_parseValue(&cur, end, &numY) ||
+	     !_parseValue(&cur, end, &numZ) ||
+	     !_parseValue(&cur, end, &numTotal)) {
+    resHoriz = 0.0;
+  } // if/else
+  if (0.0 == resHoriz ||
+      0.0 == resVert) {
+    std::ostringstream msg;
+    msg << "Could not read horizontal and vertical resolution in '"
+	<< filename << "'.";
+    pFile->error = msg.str();
+    return;
+  } // if
+  // convert resHoriz and resVert from km to m
+  resHoriz *= 1.0e+3;
+  resVert *= 1.0e+3;
+
+  const double tolerance = 1.0e-6;
+  const double vertExag = resHoriz / resVert;
+  const double vertExagE = _pGeom->vertExag();
+  if (fabs(1.0 - vertExag/vertExagE) > tolerance) {
+    std::ostringstream msg;
+    msg << "Vertical exaggeration of " << vertExag << " in '" << filename
+	<< "' does not match velocity model vertical exaggeration of "
+	<< vertExagE << ".";
+    pFile->error = msg.str();
+    return;
+  } // if
+
+  const etree_tick_t level = _pGeom->level(resHoriz);
+  const double edgeLen = _pGeom->edgeLen(level);
+  if ( fabs(1.0 - resHoriz/edgeLen) > tolerance) {
+    std::ostringstream msg;
+    msg << "Horizontal resolution of " << resHoriz << " in '" << filename
+	<< "' does not fit resolution of nearest level in database of "
+	<< edgeLen << ".";
+    pFile->error = msg.str();
+    return;
+  } // if
+  pFile->resHoriz = resHoriz;
+  pFile->numTotal = numTotal;
+  pFile->level = level;
+
+  const size_t bodyOffset = cur - pFile->pData;
+  pFile->chunkOffsets.clear();
+  pFile->chunkOffsets.push_back(bodyOffset);
+
+  if (pFile->isBinary) {
+    // Divide records into chunks; records beyond numTotal are ignored.
+    const size_t recordSize = sizeof(BinaryGridRecordStruct);
+    if (numTotal < 0 ||
+	(pFile->size - bodyOffset) / recordSize < size_t(numTotal)) {
+      std::ostringstream msg;
+      msg << "Binary grid file '" << filename << "' is truncated. "
+	  << "Expected " << numTotal << " points.";
+      pFile->error = msg.str();
+      return;
+    } // if
+    const size_t bodyEnd = bodyOffset + numTotal*recordSize;
+    const size_t chunkRecords = (_chunkSize > recordSize) ?
+      _chunkSize / recordSize : 1;
+    size_t offset = bodyOffset;
+    while (bodyEnd - offset > chunkRecords*recordSize) {
+      offset += chunkRecords*recordSize;
+      pFile->chunkOffsets.push_back(offset);
+    } // while
+    pFile->chunkOffsets.push_back(bodyEnd);
+    return;
+  } // if
+
+  // Divide body of file into chunks that end at line breaks.
+  size_t offset = bodyOffset;
+  while (pFile->size - offset > _chunkSize) {
+    offset += _chunkSize;
+    while (offset < pFile->size && '\n' != pFile->pData[offset])
+      ++offset;
+    if (offset < pFile->size)
+      ++offset;
+    pFile->chunkOffsets.push_back(offset);
+  } // while
+  if (pFile->chunkOffsets.back() != pFile->size ||
+      1 == pFile->chunkOffsets.size())
+    pFile->chunkOffsets.push_back(pFile->size);
+} // _openGrid
+
+// ----------------------------------------------------------------------
+// Unmap and close grid file.
+void
+cencalvm::create::GridParser::_closeGrid(GridFileStruct* pFile)
+{ // _closeGrid
+  assert(0 != pFile);
+
+  if (0 != pFile->pData) {
+    munmap((void*) pFile->pData, pFile->size);
+    pFile->pData = 0;
+  } // if
+  if (pFile->fd >= 0) {
+    close(pFile->fd);
+    pFile->fd = -1;
+  } // if
+} // _closeGrid
+
+// ----------------------------------------------------------------------
+// Parse chunk of grid file, convert units, and compute addresses.
+void
+cencalvm::create::GridParser::_parseChunk(ChunkStruct* pChunk,
+					  storage::Geometry* pGeom)
+{ // _parseChunk
+  assert(0 != pChunk);
+  assert(0 != pChunk->pFile);
+  assert(0 != pGeom);
+
+  const GridFileStruct& file = *pChunk->pFile;
+  const char* cur = file.pData + file.chunkOffsets[pChunk->index];
+  const char* end = file.pData + file.chunkOffsets[pChunk->index+1];
+
+  if (file.isBinary) {
+    // Records are used in place; only the addresses are computed.
+    pChunk->pRecords = (const BinaryGridRecordStruct*) cur;
+    const int numRecords = (end - cur) / sizeof(BinaryGridRecordStruct);
+    pChunk->addrs.resize(numRecords);
+    int iRecord = 0;
+    try {
+      for (iRecord=0; iRecord < numRecords; ++iRecord) {
+	const BinaryGridRecordStruct& record = pChunk->pRecords[iRecord];
+	if (record.faultBlock != storage::Payload::NODATABLOCK &&
+	    record.zone != storage::Payload::NODATAZONE) {
+	  etree_addr_t& addr = pChunk->addrs[iRecord];
+	  addr.level = file.level;
+	  addr.type = ETREE_LEAF;
+	  pGeom->lonLatElevToAddr(&addr, record.lon, record.lat,
+				  _kmToM(record.elev));
+	} // if
+      } // for
+    } catch (const std::exception& err) {
+      pChunk->error = err.what();
+    } // try/catch
+    pChunk->numPoints = iRecord;
+    return;
+  } // if
+
+  // Lines are roughly 100 characters long.
+  const size_t sizeEstimate = (end - cur) / 96 + 1;
+  pChunk->lon.reserve(sizeEstimate);
+  pChunk->lat.reserve(sizeEstimate);
+  pChunk->elev.reserve(sizeEstimate);
+  pChunk->vp.reserve(sizeEstimate);
+  pChunk->vs.reserve(sizeEstimate);
+  pChunk->density.reserve(sizeEstimate);
+  pChunk->qp.reserve(sizeEstimate);
+  pChunk->qs.reserve(sizeEstimate);
+  pChunk->depthFreeSurf.reserve(sizeEstimate);
+  pChunk->faultBlock.reserve(sizeEstimate);
+  pChunk->zone.reserve(sizeEstimate);
+
+  while (true) {
+    while (cur < end && isspace(*cur))
+      ++cur;
+    if (cur >= end)
+      break;
+
+    double lon = 0.0;
+    double lat = 0.0;
+    double elev = 0.0;
+    int volID = 0;
+    storage::PayloadStruct payload;
+    if (!_parseValue(&cur, end, &lon) ||
+	!_parseValue(&cur, end, &lat) ||
+	!_parseValue(&cur, end, &elev) ||
+	!_parseValue(&cur, end, &payload.Vp) ||
+	!_parseValue(&cur, end, &payload.Vs) ||
+	!_parseValue(&cur, end, &payload.Density) ||
+	!_parseValue(&cur, end, &payload.Qp) ||
+	!_parseValue(&cur, end, &payload.Qs) ||
+	!_parseValue(&cur, end, &payload.DepthFreeSurf) ||
+	!_parseValue(&cur, end, &payload.FaultBlock) ||
+	!_parseValue(&cur, end, &payload.Zone) ||
+	!_parseValue(&cur, end, &volID)) {
+      pChunk->error = "Couldn't parse line.";
+      break;
+    } // if
+    pChunk->lon.push_back(lon);
+    pChunk->lat.push_back(lat);
+    pChunk->elev.push_back(elev);
+    pChunk->vp.push_back(payload.Vp);
+    pChunk->vs.push_back(payload.Vs);
+    pChunk->density.push_back(payload.Density);
+    pChunk->qp.push_back(payload.Qp);
+    pChunk->qs.push_back(payload.Qs);
+    pChunk->depthFreeSurf.push_back(payload.DepthFreeSurf);
+    pChunk->faultBlock.push_back(payload.FaultBlock);
+    pChunk->zone.push_back(payload.Zone);
+  } // while
+  const int numPoints = pChunk->lon.size();
+
+  // Convert units using branch-free loops over the columns so the
+  // compiler can vectorize them. Values flagged as NODATA are not
+  // converted.
+  const double noDataD = storage::Payload::NODATAVAL;
+  const float noData = storage::Payload::NODATAVAL;
+  const float scale = 1.0e+3;
+
+  // convert elev and depth from km to m
+  double* pElev = pChunk->elev.data();
+  for (int i=0; i < numPoints; ++i)
+    pElev[i] = (pElev[i] != noDataD) ? pElev[i]*1.0e+3 : pElev[i];
+  float* pDepth = pChunk->depthFreeSurf.data();
+  for (int i=0; i < numPoints; ++i)
+    pDepth[i] = (pDepth[i] != noData) ? pDepth[i]*scale : pDepth[i];
+
+  // convert Vp & Vs from km/s to m/s
+  float* pVp = pChunk->vp.data();
+  for (int i=0; i < numPoints; ++i)
+    pVp[i] = (pVp[i] != noData) ? pVp[i]*scale : pVp[i];
+  float* pVs = pChunk->vs.data();
+  for (int i=0; i < numPoints; ++i)
+    pVs[i] = (pVs[i] != noData) ? pVs[i]*scale : pVs[i];
+
+  // convert Density from g/cm^3 to kg/m^3
+  float* pDensity = pChunk->density.data();
+  for (int i=0; i < numPoints; ++i)
+    pDensity[i] = (pDensity[i] != noData) ? pDensity[i]*scale : pDensity[i];
+
+  // Compute addresses of points that will be inserted
+  pChunk->addrs.resize(numPoints);
+  int iPoint = 0;
+  try {
+    for (iPoint=0; iPoint < numPoints; ++iPoint)
+      if (pChunk->faultBlock[iPoint] != storage::Payload::NODATABLOCK &&
+	  pChunk->zone[iPoint] != storage::Payload::NODATAZONE) {
+	etree_addr_t& addr = pChunk->addrs[iPoint];
+	addr.level = file.level;
+	addr.type = ETREE_LEAF;
+	pGeom->lonLatElevToAddr(&addr, pChunk->lon[iPoint],
+				pChunk->lat[iPoint], pChunk->elev[iPoint]);
+      } // if
+  } catch (const std::exception& err) {
+    pChunk->error = err.what();
+  } // try/catch
+  pChunk->numPoints = iPoint;
+} // _parseChunk
+
+// ----------------------------------------------------------------------
+// Insert points parsed from chunk into database.
+void
+cencalvm::create::GridParser::_insertChunk(VMCreator* pCreator,
+					   const ChunkStruct& chunk,
+					   const int firstPoint,
+					   const int maxPoints,
+					   int* pNumAdded,
+					   int* pNumIgnored) const
+{ // _insertChunk
+  assert(0 != pCreator);
+  assert(0 != pNumAdded);
+  assert(0 != pNumIgnored);
+  assert(maxPoints <= chunk.numPoints);
+  assert(firstPoint >= 0);
+
+  for (int i=firstPoint; i < maxPoints; ++i) {
+    double lon = 0.0;
+    double lat = 0.0;
+    double elev = 0.0;
+    storage::PayloadStruct payload;
+    if (0 != chunk.pRecords) {
+      // Binary records have not been converted to SI units yet.
+      const BinaryGridRecordStruct& record = chunk.pRecords[i];
+      lon = record.lon;
+      lat = record.lat;
+      elev = _kmToM(record.elev);
+      payload.Vp = _kmToM(record.vp);
+      payload.Vs = _kmToM(record.vs);
+      payload.Density = _kmToM(record.density);
+      payload.Qp = record.qp;
+      payload.Qs = record.qs;
+      payload.DepthFreeSurf = _kmToM(record.depthFreeSurf);
+      payload.FaultBlock = record.faultBlock;
+      payload.Zone = record.zone;
+    } else {
+      lon = chunk.lon[i];
+      lat = chunk.lat[i];
+      elev = chunk.elev[i];
+      payload.Vp = chunk.vp[i];
+      payload.Vs = chunk.vs[i];
+      payload.Density = chunk.density[i];
+      payload.Qp = chunk.qp[i];
+      payload.Qs = chunk.qs[i];
+      payload.DepthFreeSurf = chunk.depthFreeSurf[i];
+      payload.FaultBlock = chunk.faultBlock[i];
+      payload.Zone = chunk.zone[i];
+    } // if/else
+
+    if (payload.FaultBlock != cencalvm::storage::Payload::NODATABLOCK &&
+	payload.Zone != cencalvm::storage::Payload::NODATAZONE) {
+      pCreator->insert(payload, chunk.addrs[i]);
+      ++(*pNumAdded);
+    } else {
+      if (payload.FaultBlock != cencalvm::storage::Payload::NODATABLOCK) {
+	if (!_quiet)
+	  std::cerr
+	    << std::resetiosflags(std::ios::fixed)
+	    << std::setiosflags(std::ios::scientific)
+	    << std::setprecision(6)
+	    << lon << ", " << lat << ", " << elev
+	    << ", No fault block\n";
+      } else {
+	if (!_quiet)
+	  std::cerr
+	    << std::resetiosflags(std::ios::fixed)
+	    << std::setiosflags(std::ios::scientific)
+	    << std::setprecision(6)
+	    << lon << ", " << lat << ", " << elev
+	    << ", Ignoring\n";
+      } // if/else
+      ++(*pNumIgnored);
+    } // if/else
+  } // for
+} // _insertChunk
+
+// ----------------------------------------------------------------------
+// Make inserted points durable and write checkpoint file.
+void
+cencalvm::create::GridParser::_writeCheckpoint(VMCreator* pCreator,
+					       const int iGrid,
+					       const int numPoints)
+{ // _writeCheckpoint
+  assert(0 != pCreator);
+
+  // Alternate snapshot slots, so the snapshot of the last checkpoint
+  // is kept until the new checkpoint file replaces it.
+  const int slot = (_checkpointSlot + 1) % storage::DBSnapshot::NUMSLOTS;
+  const uint64_t length = pCreator->checkpoint(slot);
+
+  // Replace checkpoint file only after new one is complete.
+  const std::string filenameTmp = _filenameCheckpoint + ".tmp";
+  std::ofstream fout(filenameTmp.c_str());
+  if (!fout.is_open()) {
+    std::ostringstream msg;
+    msg << "Could not open checkpoint file '" << filenameTmp
+	<< "' for writing.";
+    throw std::runtime_error(msg.str());
+  } // if
+  fout
+    << "grid " << iGrid << "\n"
+    << "points " << numPoints << "\n"
+    << "runs " << pCreator->numRuns() << "\n"
+    << "octants " << pCreator->numOctants() << "\n"
+    << "snapshot " << slot << " " << length << "\n";
+  fout.close();
+  if (!fout.good() ||
+      0 != rename(filenameTmp.c_str(), _filenameCheckpoint.c_str())) {
+    std::ostringstream msg;
+    msg << "Could not write checkpoint file '" << _filenameCheckpoint
+	<< "'.";
+    throw std::runtime_error(msg.str());
+  } // if
+  _checkpointSlot = slot;
+
+  if (!_quiet)
+    std::cout << "Wrote checkpoint after point " << numPoints
+	      << " of grid file " << iGrid << "." << std::endl;
+} // _writeCheckpoint
+
+// ----------------------------------------------------------------------
+// Read checkpoint file.
+void
+cencalvm::create::GridParser::_readCheckpoint(int* pGrid,
+					      int* pNumPoints,
+					      int* pNumRuns,
+					      size_t* pNumOctants,
+					      int* pSlot,
+					      uint64_t* pLength) const
+{ // _readCheckpoint
+  assert(0 != pGrid);
+  assert(0 != pNumPoints);
+  assert(0 != pNumRuns);
+  assert(0 != pNumOctants);
+  assert(0 != pSlot);
+  assert(0 != pLength);
+
+  std::ifstream fin(_filenameCheckpoint.c_str());
+  if (!fin.is_open()) {
+    std::ostringstream msg;
+    msg << "Could not open checkpoint file '" << _filenameCheckpoint
+	<< "' for reading.";
+    throw std::runtime_error(msg.str());
+  } // if
+
+  std::string gridName;
+  std::string pointsName;
+  std::string runsName;
+  std::string octantsName;
+  std::string snapshotName;
+  fin
+    >> gridName >> *pGrid
+    >> pointsName >> *pNumPoints
+    >> runsName >> *pNumRuns
+    >> octantsName >> *pNumOctants
+    >> snapshotName >> *pSlot >> *pLength;
+  if (fin.fail() ||
+      "grid" != gridName || "points" != pointsName ||
+      "runs" != runsName || "octants" != octantsName ||
+      "snapshot" != snapshotName ||
+      *pGrid < 0 || *pNumPoints < 0 || *pNumRuns < 0 ||
+      *pSlot < 0 || *pSlot >= storage::DBSnapshot::NUMSLOTS) {
+    std::ostringstream msg;
+    msg << "Could not parse checkpoint file '" << _filenameCheckpoint
+	<< "'.";
+    throw std::runtime_error(msg.str());
+  } // if
+} // _readCheckpoint
+
+// ----------------------------------------------------------------------
+// Convert value from km (or g/cm^3) to m (or kg/m^3), leaving values
+// flagged as NODATA unchanged.
+template<typename T>
+T
+cencalvm::create::GridParser::_kmToM(const T value)
+{ // _kmToM
+  return (value != T(storage::Payload::NODATAVAL)) ? value*T(1.0e+3) : value;
+} // _kmToM
+
+// ----------------------------------------------------------------------
+// Parsing thread loop.
+void
+cencalvm::create::GridParser::_work(WorkStruct* pWork,
+				    storage::Geometry* pGeom)
+{ // _work
+  assert(0 != pWork);
+  assert(0 != pGeom);
+
+  while (true) {
+    ChunkStruct* pChunk = 0;
+    { // scope for lock
+      std::unique_lock<std::mutex> lock(pWork->mutex);
+      while (pWork->queue.empty() && !pWork->isFinished)
+	pWork->chunkQueued.wait(lock);
+      if (pWork->queue.empty())
+	return;
+      pChunk = pWork->queue.front();
+      pWork->queue.pop_front();
+    } // scope for lock
+
+    _parseChunk(pChunk, pGeom);
+
+    { // scope for lock
+      std::lock_guard<std::mutex> lock(pWork->mutex);
+      pChunk->isDone = true;
+    } // scope for lock
+    pWork->chunkDone.notify_all();
+  } // while
+} // _work
+
+// ----------------------------------------------------------------------
+// Parse value delimited by whitespace.
+template<typename T>
+bool
+cencalvm::create::GridParser::_parseValue(const char** ppCur,
+					  const char* end,
+					  T* pValue)
+{ // _parseValue
+  assert(0 != ppCur);
+  assert(0 != pValue);
+
+  const char* cur = *ppCur;
+  while (cur < end && isspace(*cur))
+    ++cur;
+  if (cur < end && '+' == *cur)
+    ++cur;
+  if (cur >= end)
+    return false;
+
+#if defined(HAVE_FLOAT_FROM_CHARS)
+  const std::from_chars_result result = std::from_chars(cur, end, *pValue);
+  if (std::errc() != result.ec)
+    return false;
+  *ppCur = result.ptr;
+#else
+  // Mapped file is not null terminated, so copy token.
+  const int maxLen = 64;
+  char token[maxLen];
+  int len = 0;
+  while (cur+len < end && len < maxLen-1 && !isspace(cur[len]))
+    ++len;
+  for (int i=0; i < len; ++i)
+    token[i] = cur[i];
+  token[len] = '\0';
+  char* tokenEnd = 0;
+  const double value = strtod(token, &tokenEnd);
+  if (tokenEnd == token)
+    return false;
+  *pValue = T(value);
+  *ppCur = cur + (tokenEnd - token);
+#endif
+
+  return true;
+} // _parseValue
+
+
+// End of file
@@ -0,0 +1,275 @@
+// -*- C++ -*-
+//
+// ======================================================================
+//
+//                           Brad T. Aagaard
+//                        U.S. Geological Survey
+//
+// {LicenseText}
+//
+// ======================================================================
+//
+
+/** @file libsrc/create/GridParser.h
+ *
+ * @brief C++ object for parsing ASCII input grids in parallel and
+ * inserting the points into the database.
+ *
+ * Each grid file is memory mapped and split into line-aligned
+ * chunks. Worker threads parse the chunks, convert units, and
+ * compute etree addresses. Chunks from consecutive files are parsed
+ * concurrently, but points are inserted into the database in the
+ * order in which they appear in the files.
+ *
+ * Grid files start with a header line containing the horizontal
+ * resolution (km), vertical resolution (km), number of points in the
+ * x, y, and z directions, and the total number of points. Each
+ * following line holds one point: lon, lat, elev (km), Vp (km/s), Vs
+ * (km/s), density (g/cm^3), Qp, Qs, depth from free surface (km),
+ * fault block, zone, and volume id.
+ *
+ * Binary grid files (see BinaryGrid.h) are recognized by their header
+ * and their records are used in place without parsing.
+ *
+ * Long ingestions can write checkpoints with the index of the grid
+ * file and the number of points of that file that have been inserted
+ * (see checkpoint()). An interrupted ingestion continues from the last
+ * checkpoint when resume() is set.
+ */
+
+#if !defined(cencalvm_create_gridparser_h)
+#define cencalvm_create_gridparser_h
+
+#include <string> // HASA std::string
+#include <sys/types.h> // USES size_t
+#include <inttypes.h> // USES uint64_t
+
+namespace cencalvm {
+  namespace create {
+    class GridParser;
+    class VMCreator; // USES VMCreator
+  } // namespace create
+  namespace storage {
+    class Geometry; // HOLDSA Geometry
+    class Telemetry; // HOLDSA Telemetry
+  } // namespace storage
+} // namespace cencalvm
+
+/// C++ object for parsing ASCII input grids in parallel and inserting
+/// the points into the database.
+class cencalvm::create::GridParser
+{ // GridParser
+
+public :
+  // PUBLIC METHODS /////////////////////////////////////////////////////
+
+  /// Constructor
+  GridParser(void);
+
+  /// Destructor
+  ~GridParser(void);
+
+  /** Set geometry of velocity model.
+   *
+   * @param pGeom Pointer to velocity model geometry
+   */
+  void geometry(const storage::Geometry* pGeom);
+
+  /** Set number of threads used to parse grids.
+   *
+   * @param num Number of threads (0 to use number of processors)
+   */
+  void numThreads(const int num);
+
+  /** Set approximate size of chunks of grid files parsed by each thread.
+   *
+   * @param size Size of chunks in bytes
+   */
+  void chunkSize(const size_t size);
+
+  /** Set flag indicating parsing should be quiet (no progress reports).
+   *
+   * @param flag True for quiet operation, false to give progress reports
+   */
+  void quiet(const bool flag);
+
+  /** Set telemetry for reporting bytes of grid files read.
+   *
+   * @param pTelemetry Pointer to telemetry (0 for none)
+   */
+  void telemetry(storage::Telemetry* pTelemetry);
+
+  /** Set file and interval for checkpoints.
+   *
+   * A checkpoint is written after the first chunk that brings the
+   * number of points processed since the last checkpoint to the
+   * interval. The database creator makes the inserted points durable
+   * before the checkpoint file is replaced.
+   *
+   * @param filename Name of checkpoint file
+   * @param numPoints Number of points between checkpoints (0 for no
+   * checkpoints)
+   */
+  void checkpoint(const char* filename,
+		  const size_t numPoints);
+
+  /** Set flag indicating ingestion should resume from the checkpoint
+   * file.
+   *
+   * The database creator must hold the database at the checkpoint
+   * (see restoreDB() and VMCreator::reopenDB()).
+   *
+   * @param flag True to resume from checkpoint, false to start at
+   * beginning
+   */
+  void resume(const bool flag);
+
+  /** Replace unpacked database with its snapshot at the checkpoint,
+   * discarding points inserted after the checkpoint, which may have
+   * left the database in an inconsistent state.
+   *
+   * @param filenameDB Name of unpacked database
+   */
+  void restoreDB(const char* filenameDB) const;
+
+  /** Parse grid files and insert the points into the database.
+   *
+   * @param pCreator Pointer to database creator
+   * @param filenames Array of names of grid files
+   * @param numGrids Number of grid files
+   */
+  void ingest(VMCreator* pCreator,
+	      const std::string* filenames,
+	      const int numGrids);
+
+private :
+  // PRIVATE STRUCTS ////////////////////////////////////////////////////
+
+  struct GridFileStruct; ///< Memory mapped grid file
+  struct ChunkStruct; ///< Chunk of grid file and parsed points
+  struct WorkStruct; ///< Work queue shared with parsing threads
+
+private :
+  // PRIVATE METHODS ////////////////////////////////////////////////////
+
+  /** Open and memory map grid file, read and check header, and divide
+   * body of file into chunks.
+   *
+   * Errors are stored in the file rather than thrown, so they can be
+   * reported when the file is reached in the insertion order.
+   *
+   * @param pFile Pointer to grid file
+   */
+  void _openGrid(GridFileStruct* pFile) const;
+
+  /** Unmap and close grid file.
+   *
+   * @param pFile Pointer to grid file
+   */
+  static void _closeGrid(GridFileStruct* pFile);
+
+  /** Parse chunk of grid file, convert units, and compute addresses.
+   *
+   * @param pChunk Pointer to chunk
+   * @param pGeom Pointer to geometry used by calling thread
+   */
+  static void _parseChunk(ChunkStruct* pChunk,
+			  storage::Geometry* pGeom);
+
+  /** Insert points parsed from chunk into database.
+   *
+   * @param pCreator Pointer to database creator
+   * @param chunk Chunk with parsed points
+   * @param firstPoint Index of first point to insert
+   * @param maxPoints Maximum number of points to insert
+   * @param pNumAdded Pointer to number of points added
+   * @param pNumIgnored Pointer to number of points ignored
+   */
+  void _insertChunk(VMCreator* pCreator,
+		    const ChunkStruct& chunk,
+		    const int firstPoint,
+		    const int maxPoints,
+		    int* pNumAdded,
+		    int* pNumIgnored) const;
+
+  /** Make inserted points durable and write checkpoint file.
+   *
+   * @param pCreator Pointer to database creator
+   * @param iGrid Index of grid file being ingested
+   * @param numPoints Number of points of grid file processed
+   */
+  void _writeCheckpoint(VMCreator* pCreator,
+			const int iGrid,
+			const int numPoints);
+
+  /** Read checkpoint file.
+   *
+   * @param pGrid Pointer to index of grid file being ingested
+   * @param pNumPoints Pointer to number of points of grid file processed
+   * @param pNumRuns Pointer to number of sorted run files
+   * @param pNumOctants Pointer to number of octants sorted
+   * @param pSlot Pointer to slot of snapshot of unpacked database
+   * @param pLength Pointer to length of unpacked database in bytes
+   */
+  void _readCheckpoint(int* pGrid,
+		       int* pNumPoints,
+		       int* pNumRuns,
+		       size_t* pNumOctants,
+		       int* pSlot,
+		       uint64_t* pLength) const;
+
+  /** Parsing thread loop.
+   *
+   * @param pWork Pointer to work queue
+   * @param pGeom Pointer to geometry used by thread
+   */
+  static void _work(WorkStruct* pWork,
+		    storage::Geometry* pGeom);
+
+  /** Parse value delimited by whitespace.
+   *
+   * @param ppCur Pointer to current position (updated)
+   * @param end End of buffer
+   * @param pValue Pointer to value
+   *
+   * @returns True if successful, false otherwise
+   */
+  template<typename T>
+  static bool _parseValue(const char** ppCur,
+			  const char* end,
+			  T* pValue);
+
+  /** Convert value from km (or g/cm^3) to m (or kg/m^3), leaving
+   * values flagged as NODATA unchanged.
+   *
+   * @param value Value to convert
+   *
+   * @returns Converted value
+   */
+  template<typename T>
+  static T _kmToM(const T value);
+
+private :
+  // NOT IMPLEMENTED ////////////////////////////////////////////////////
+
+  GridParser(const GridParser& p); ///< Not implemented
+  const GridParser& operator=(const GridParser& p); ///< Not implemented
+
+private :
+  // PRIVATE MEMBERS ////////////////////////////////////////////////////
+
+  storage::Geometry* _pGeom; ///< Pointer to velocity model geometry
+  storage::Telemetry* _pTelemetry; ///< Pointer to telemetry
+  size_t _chunkSize; ///< Approximate size of chunks in bytes
+  int _numThreads; ///< Number of parsing threads
+  std::string _filenameCheckpoint; ///< Name of checkpoint file
+  size_t _checkpointInterval; ///< Number of points between checkpoints
+  bool _resume; ///< Flag to resume from checkpoint
+  int _checkpointSlot; ///< Snapshot slot of last checkpoint (-1 if none)
+  bool _quiet; ///< Flag to eliminate progress reports
+
+}; // GridParser
+
+#endif // cencalvm_create_gridparser_h
+
+// End of file
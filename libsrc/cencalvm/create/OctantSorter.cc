@@ -0,0 +1,367 @@
+// -*- C++ -*-
+//
+// ======================================================================
+//
+//                           Brad T. Aagaard
+//                        U.S. Geological Survey
+//
+// {LicenseText}
+//
+// ======================================================================
+//
+
+#include "OctantSorter.h" // implementation of class methods
+
+#include "cencalvm/storage/Payload.h" // USES PayloadStruct
+#include "cencalvm/storage/Geometry.h" // USES Geometry::precedes()
+
+extern "C" {
+#include "etree.h"
+}
+
+#include <algorithm> // USES std::sort(), std::push_heap(), std::pop_heap()
+
+#include <stdexcept> // USES std::runtime_error
+#include <sstream> // USES std::ostringstream
+#include <assert.h> // USES assert()
+
+// ----------------------------------------------------------------------
+// Address and payload of octant.
+struct cencalvm::create::OctantSorter::OctantStruct {
+  etree_addr_t addr; ///< Address of octant
+  storage::PayloadStruct payload; ///< Payload of octant
+}; // OctantStruct
+
+// ----------------------------------------------------------------------
+// Sorted run of octants stored in file.
+struct cencalvm::create::OctantSorter::RunStruct {
+  std::string filename; ///< Name of run file
+  FILE* fp; ///< Run file
+  size_t numRemaining; ///< Number of octants in file not yet read
+  OctantStruct* pBuffer; ///< Buffer of octants read from file
+  size_t bufferSize; ///< Size of buffer
+  size_t numBuffered; ///< Number of octants in buffer
+  size_t index; ///< Index of current octant in buffer
+}; // RunStruct
+
+// ----------------------------------------------------------------------
+// Constructor
+cencalvm::create::OctantSorter::OctantSorter(const char* filenameRoot,
+					     const size_t memorySize) :
+  _filenameRoot(filenameRoot),
+  _pOctants(0),
+  _capacity(memorySize / sizeof(OctantStruct)),
+  _numInMemory(0),
+  _numOctants(0),
+  _ppRuns(0),
+  _numRuns(0),
+  _heapSize(0),
+  _nextInMemory(0),
+  _isSorted(false),
+  _keepRuns(false)
+{ // constructor
+  assert(0 != filenameRoot);
+
+  if (_capacity < 1)
+    _capacity = 1;
+  _pOctants = new OctantStruct[_capacity];
+} // constructor
+
+// ----------------------------------------------------------------------
+// Destructor
+cencalvm::create::OctantSorter::~OctantSorter(void)
+{ // destructor
+  _cleanup();
+} // destructor
+
+// ----------------------------------------------------------------------
+// Add octant.
+void
+cencalvm::create::OctantSorter::add(const etree_addr_t& addr,
+				    const storage::PayloadStruct& payload)
+{ // add
+  assert(!_isSorted);
+
+  if (_numInMemory == _capacity)
+    _writeRun();
+  assert(_numInMemory < _capacity);
+
+  _pOctants[_numInMemory].addr = addr;
+  _pOctants[_numInMemory].payload = payload;
+  ++_numInMemory;
+  ++_numOctants;
+} // add
+
+// ----------------------------------------------------------------------
+// Write octants held in memory to a run file.
+void
+cencalvm::create::OctantSorter::checkpoint(void)
+{ // checkpoint
+  assert(!_isSorted);
+
+  if (_numInMemory > 0)
+    _writeRun();
+  _keepRuns = true;
+} // checkpoint
+
+// ----------------------------------------------------------------------
+// Continue from run files written before the last checkpoint.
+void
+cencalvm::create::OctantSorter::resume(const int numRuns,
+				       const size_t numOctants)
+{ // resume
+  assert(!_isSorted);
+  assert(0 == _numOctants);
+  assert(numRuns >= 0);
+
+  _keepRuns = true;
+  size_t numInRuns = 0;
+  for (int iRun=0; iRun < numRuns; ++iRun) {
+    const std::string filename = _runFilename(iRun);
+    FILE* fp = fopen(filename.c_str(), "rb");
+    if (0 == fp) {
+      std::ostringstream msg;
+      msg << "Could not open run file '" << filename
+	  << "' to resume sorting.";
+      throw std::runtime_error(msg.str());
+    } // if
+    const bool seekError = (0 != fseek(fp, 0, SEEK_END));
+    const long size = ftell(fp);
+    fclose(fp);
+    if (seekError || size < 0 || 0 != size % sizeof(OctantStruct)) {
+      std::ostringstream msg;
+      msg << "Run file '" << filename << "' is not a complete run.";
+      throw std::runtime_error(msg.str());
+    } // if
+    _addRun(filename, size / sizeof(OctantStruct));
+    numInRuns += size / sizeof(OctantStruct);
+  } // for
+  if (numInRuns != numOctants) {
+    std::ostringstream msg;
+    msg << "Run files with root name '" << _filenameRoot << "' contain "
+	<< numInRuns << " octants, but " << numOctants
+	<< " octants were added before the checkpoint.";
+    throw std::runtime_error(msg.str());
+  } // if
+  _numOctants = numOctants;
+
+  // Remove runs written after the checkpoint.
+  for (int iRun=numRuns; 0 == remove(_runFilename(iRun).c_str()); ++iRun)
+    ;
+} // resume
+
+// ----------------------------------------------------------------------
+// Finish adding octants and prepare to return them in sorted order.
+void
+cencalvm::create::OctantSorter::sort(void)
+{ // sort
+  assert(!_isSorted);
+  _isSorted = true;
+
+  if (0 == _numRuns) {
+    // Everything fits in memory, so no merge is needed.
+    std::sort(_pOctants, _pOctants+_numInMemory, _octantBefore);
+    _nextInMemory = 0;
+    return;
+  } // if
+
+  if (_numInMemory > 0)
+    _writeRun();
+
+  // Reuse memory for octants as read buffers for the runs.
+  size_t bufferSize = _capacity / _numRuns;
+  if (bufferSize < 1)
+    bufferSize = 1;
+  if (bufferSize*_numRuns > _capacity) {
+    delete[] _pOctants;
+    _capacity = bufferSize*_numRuns;
+    _pOctants = new OctantStruct[_capacity];
+  } // if
+
+  _heapSize = 0;
+  for (int iRun=0; iRun < _numRuns; ++iRun) {
+    RunStruct* pRun = _ppRuns[iRun];
+    pRun->fp = fopen(pRun->filename.c_str(), "rb");
+    if (0 == pRun->fp) {
+      std::ostringstream msg;
+      msg << "Could not open run file '" << pRun->filename
+	  << "' for reading.";
+      throw std::runtime_error(msg.str());
+    } // if
+    pRun->pBuffer = &_pOctants[iRun*bufferSize];
+    pRun->bufferSize = bufferSize;
+    _readRun(pRun);
+    if (pRun->numBuffered > 0) {
+      _ppRuns[_heapSize++] = pRun;
+      std::push_heap(_ppRuns, _ppRuns+_heapSize, _runAfter);
+    } // if
+  } // for
+} // sort
+
+// ----------------------------------------------------------------------
+// Get next octant in sorted order.
+bool
+cencalvm::create::OctantSorter::next(etree_addr_t* pAddr,
+				     storage::PayloadStruct* pPayload)
+{ // next
+  assert(_isSorted);
+  assert(0 != pAddr);
+  assert(0 != pPayload);
+
+  if (0 == _numRuns) {
+    if (_nextInMemory >= _numInMemory)
+      return false;
+    *pAddr = _pOctants[_nextInMemory].addr;
+    *pPayload = _pOctants[_nextInMemory].payload;
+    ++_nextInMemory;
+    return true;
+  } // if
+
+  if (0 == _heapSize) {
+    _keepRuns = false;
+    return false;
+  } // if
+
+  std::pop_heap(_ppRuns, _ppRuns+_heapSize, _runAfter);
+  RunStruct* pRun = _ppRuns[_heapSize-1];
+  *pAddr = pRun->pBuffer[pRun->index].addr;
+  *pPayload = pRun->pBuffer[pRun->index].payload;
+  if (++pRun->index == pRun->numBuffered)
+    _readRun(pRun);
+  if (pRun->numBuffered > 0)
+    std::push_heap(_ppRuns, _ppRuns+_heapSize, _runAfter);
+  else
+    --_heapSize;
+
+  return true;
+} // next
+
+// ----------------------------------------------------------------------
+// Sort octants in memory and write them to a new run file.
+void
+cencalvm::create::OctantSorter::_writeRun(void)
+{ // _writeRun
+  std::sort(_pOctants, _pOctants+_numInMemory, _octantBefore);
+
+  _addRun(_runFilename(_numRuns), _numInMemory);
+  RunStruct* pRun = _ppRuns[_numRuns-1];
+
+  FILE* fp = fopen(pRun->filename.c_str(), "wb");
+  if (0 == fp) {
+    std::ostringstream msg;
+    msg << "Could not open run file '" << pRun->filename
+	<< "' for writing.";
+    throw std::runtime_error(msg.str());
+  } // if
+  const size_t numWritten =
+    fwrite(_pOctants, sizeof(OctantStruct), _numInMemory, fp);
+  const bool writeError = (0 != fclose(fp)) || numWritten != _numInMemory;
+  if (writeError) {
+    std::ostringstream msg;
+    msg << "Error while writing run file '" << pRun->filename << "'.";
+    throw std::runtime_error(msg.str());
+  } // if
+
+  _numInMemory = 0;
+} // _writeRun
+
+// ----------------------------------------------------------------------
+// Add run to array of runs.
+void
+cencalvm::create::OctantSorter::_addRun(const std::string& filename,
+					const size_t numOctants)
+{ // _addRun
+  RunStruct* pRun = new RunStruct;
+  pRun->filename = filename;
+  pRun->fp = 0;
+  pRun->numRemaining = numOctants;
+  pRun->pBuffer = 0;
+  pRun->bufferSize = 0;
+  pRun->numBuffered = 0;
+  pRun->index = 0;
+
+  RunStruct** ppRuns = new RunStruct*[_numRuns+1];
+  for (int iRun=0; iRun < _numRuns; ++iRun)
+    ppRuns[iRun] = _ppRuns[iRun];
+  ppRuns[_numRuns] = pRun;
+  delete[] _ppRuns; _ppRuns = ppRuns;
+  ++_numRuns;
+} // _addRun
+
+// ----------------------------------------------------------------------
+// Get name of run file.
+std::string
+cencalvm::create::OctantSorter::_runFilename(const int index) const
+{ // _runFilename
+  std::ostringstream filename;
+  filename << _filenameRoot << ".run" << index;
+  return filename.str();
+} // _runFilename
+
+// ----------------------------------------------------------------------
+// Refill buffer of run from its file.
+void
+cencalvm::create::OctantSorter::_readRun(RunStruct* pRun)
+{ // _readRun
+  assert(0 != pRun);
+  assert(0 != pRun->fp);
+
+  const size_t numRead = (pRun->numRemaining < pRun->bufferSize) ?
+    pRun->numRemaining : pRun->bufferSize;
+  if (numRead > 0 &&
+      numRead != fread(pRun->pBuffer, sizeof(OctantStruct), numRead,
+		       pRun->fp)) {
+    std::ostringstream msg;
+    msg << "Error while reading run file '" << pRun->filename << "'.";
+    throw std::runtime_error(msg.str());
+  } // if
+  pRun->numRemaining -= numRead;
+  pRun->numBuffered = numRead;
+  pRun->index = 0;
+} // _readRun
+
+// ----------------------------------------------------------------------
+// Check whether run comes after another run in heap order.
+bool
+cencalvm::create::OctantSorter::_runAfter(const RunStruct* pRunA,
+					  const RunStruct* pRunB)
+{ // _runAfter
+  assert(0 != pRunA);
+  assert(0 != pRunB);
+
+  return _octantBefore(pRunB->pBuffer[pRunB->index],
+		       pRunA->pBuffer[pRunA->index]);
+} // _runAfter
+
+// ----------------------------------------------------------------------
+// Check whether octant comes before another in etree order.
+bool
+cencalvm::create::OctantSorter::_octantBefore(const OctantStruct& a,
+					      const OctantStruct& b)
+{ // _octantBefore
+  return storage::Geometry::precedes(a.addr, b.addr);
+} // _octantBefore
+
+// ----------------------------------------------------------------------
+// Close and remove run files and deallocate buffers.
+void
+cencalvm::create::OctantSorter::_cleanup(void)
+{ // _cleanup
+  for (int iRun=0; iRun < _numRuns; ++iRun) {
+    RunStruct* pRun = _ppRuns[iRun];
+    if (0 != pRun->fp)
+      fclose(pRun->fp);
+    if (!_keepRuns)
+      remove(pRun->filename.c_str());
+    delete pRun; _ppRuns[iRun] = 0;
+  } // for
+  delete[] _ppRuns; _ppRuns = 0;
+  _numRuns = 0;
+  _heapSize = 0;
+
+  delete[] _pOctants; _pOctants = 0;
+  _capacity = 0;
+  _numInMemory = 0;
+} // _cleanup
+
+// End of file
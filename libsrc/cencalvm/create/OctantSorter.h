@@ -0,0 +1,211 @@
+// -*- C++ -*-
+//
+// ======================================================================
+//
+//                           Brad T. Aagaard
+//                        U.S. Geological Survey
+//
+// {LicenseText}
+//
+// ======================================================================
+//
+
+/** @file libsrc/create/OctantSorter.h
+ *
+ * @brief C++ object for sorting octants into etree storage order using
+ * an external-memory merge sort.
+ *
+ * Octants are accumulated in memory until the memory budget is
+ * exhausted, at which point they are sorted and written to a
+ * temporary run file. Once all octants have been added, the runs are
+ * merged and the octants are returned one at a time in the order
+ * required by etree_append().
+ *
+ * The octants added so far can be made durable with checkpoint(),
+ * which writes the octants held in memory as a run and keeps the run
+ * files if the sorter is destroyed before the merge finishes. A new
+ * sorter can continue from the run files with resume().
+ */
+
+#if !defined(cencalvm_create_octantsorter_h)
+#define cencalvm_create_octantsorter_h
+
+#include "cencalvm/storage/etreefwd.h" // USES etree_addr_t
+
+#include <string> // HASA std::string
+#include <stdio.h> // HOLDSA FILE
+#include <sys/types.h> // USES size_t
+
+namespace cencalvm {
+  namespace create {
+    class OctantSorter;
+    class TestOctantSorter; // friend
+  } // namespace create
+  namespace storage {
+    struct PayloadStruct; // USES PayloadStruct
+  } // namespace storage
+} // namespace cencalvm
+
+/// C++ object for sorting octants into etree storage order using an
+/// external-memory merge sort.
+class cencalvm::create::OctantSorter
+{ // OctantSorter
+  friend class TestOctantSorter;
+
+public :
+  // PUBLIC METHODS /////////////////////////////////////////////////////
+
+  /** Constructor
+   *
+   * @param filenameRoot Root name for temporary run files
+   * @param memorySize Amount of memory used for sorting in bytes
+   */
+  OctantSorter(const char* filenameRoot,
+	       const size_t memorySize);
+
+  /// Destructor
+  ~OctantSorter(void);
+
+  /** Add octant.
+   *
+   * @param addr Address of octant
+   * @param payload Payload of octant
+   */
+  void add(const etree_addr_t& addr,
+	   const storage::PayloadStruct& payload);
+
+  /** Write octants held in memory to a run file, so that all octants
+   * added so far are stored in run files.
+   *
+   * Run files are kept until all octants have been returned by
+   * next(), so an interrupted run can continue from them. Each
+   * checkpoint adds a run, so checkpoints should be much less
+   * frequent than filling the sorting memory.
+   */
+  void checkpoint(void);
+
+  /** Continue from run files written before the last checkpoint by
+   * another sorter with the same root name. Run files written after
+   * the checkpoint are removed.
+   *
+   * @param numRuns Number of run files at checkpoint
+   * @param numOctants Number of octants added at checkpoint
+   */
+  void resume(const int numRuns,
+	      const size_t numOctants);
+
+  /// Finish adding octants and prepare to return them in sorted order.
+  void sort(void);
+
+  /** Get next octant in sorted order.
+   *
+   * @param pAddr Pointer to address of octant
+   * @param pPayload Pointer to payload of octant
+   *
+   * @returns True if octant was returned, false if no octants remain
+   */
+  bool next(etree_addr_t* pAddr,
+	    storage::PayloadStruct* pPayload);
+
+  /** Get number of octants added.
+   *
+   * @returns Number of octants
+   */
+  size_t numOctants(void) const;
+
+  /** Get number of temporary run files written.
+   *
+   * @returns Number of run files
+   */
+  int numRuns(void) const;
+
+private :
+  // PRIVATE STRUCTS ////////////////////////////////////////////////////
+
+  struct OctantStruct; ///< Address and payload of octant
+  struct RunStruct; ///< Sorted run of octants stored in file
+
+private :
+  // PRIVATE METHODS ////////////////////////////////////////////////////
+
+  /// Sort octants in memory and write them to a new run file.
+  void _writeRun(void);
+
+  /** Add run to array of runs.
+   *
+   * @param filename Name of run file
+   * @param numOctants Number of octants in run file
+   */
+  void _addRun(const std::string& filename,
+	       const size_t numOctants);
+
+  /** Get name of run file.
+   *
+   * @param index Index of run
+   *
+   * @returns Name of run file
+   */
+  std::string _runFilename(const int index) const;
+
+  /** Refill buffer of run from its file.
+   *
+   * @param pRun Pointer to run
+   */
+  void _readRun(RunStruct* pRun);
+
+  /** Check whether run comes after another run in heap order (used
+   * to keep run with next octant at front of heap).
+   *
+   * @param pRunA Pointer to first run
+   * @param pRunB Pointer to second run
+   *
+   * @returns True if current octant of first run comes after that of
+   * second run
+   */
+  static bool _runAfter(const RunStruct* pRunA,
+			const RunStruct* pRunB);
+
+  /** Check whether octant comes before another in etree order.
+   *
+   * @param a First octant
+   * @param b Second octant
+   *
+   * @returns True if first octant comes before second octant
+   */
+  static bool _octantBefore(const OctantStruct& a,
+			    const OctantStruct& b);
+
+  /// Close and remove run files and deallocate buffers.
+  void _cleanup(void);
+
+private :
+  // NOT IMPLEMENTED ////////////////////////////////////////////////////
+
+  OctantSorter(const OctantSorter& s); ///< Not implemented
+  const OctantSorter& operator=(const OctantSorter& s); ///< Not implemented
+
+private :
+  // PRIVATE MEMBERS ////////////////////////////////////////////////////
+
+  std::string _filenameRoot; ///< Root name for temporary run files
+
+  OctantStruct* _pOctants; ///< Array of octants held in memory
+  size_t _capacity; ///< Number of octants that fit in memory
+  size_t _numInMemory; ///< Number of octants currently in memory
+  size_t _numOctants; ///< Total number of octants added
+
+  RunStruct** _ppRuns; ///< Array of runs
+  int _numRuns; ///< Number of runs
+  int _heapSize; ///< Number of runs with octants remaining in merge
+
+  size_t _nextInMemory; ///< Index of next octant when no runs written
+  bool _isSorted; ///< True if sort() has been called
+  bool _keepRuns; ///< True if run files are kept for resuming
+
+}; // OctantSorter
+
+#include "OctantSorter.icc" // inline methods
+
+#endif // cencalvm_create_octantsorter_h
+
+// End of file
@@ -0,0 +1,342 @@
+// -*- C++ -*-
+//
+// ======================================================================
+//
+//                           Brad T. Aagaard
+//                        U.S. Geological Survey
+//
+// {LicenseText}
+//
+// ======================================================================
+//
+
+#include "PyramidBuilder.h" // implementation of class methods
+
+#include "cencalvm/storage/BrickDB.h" // USES BrickDB
+#include "cencalvm/storage/Payload.h" // USES PayloadStruct
+#include "cencalvm/storage/PayloadCodec.h" // USES PayloadCodec
+
+extern "C" {
+#include "etree.h"
+}
+
+#include <stdlib.h> // USES free()
+#include <string.h> // USES memset(), memcpy()
+#include <iostream> // USES std::cout
+#include <vector> // USES std::vector
+#include <map> // USES std::map
+
+#include <stdexcept> // USES std::runtime_error
+#include <sstream> // USES std::ostringstream
+#include <assert.h> // USES assert()
+
+// ----------------------------------------------------------------------
+// Constructor
+cencalvm::create::PyramidBuilder::PyramidBuilder(void) :
+  _filenameIn(""),
+  _filenameOut(""),
+  _cacheSize(64),
+  _minLevel(-1),
+  _maxLevel(-1),
+  _quiet(false)
+{ // constructor
+} // constructor
+
+// ----------------------------------------------------------------------
+// Destructor
+cencalvm::create::PyramidBuilder::~PyramidBuilder(void)
+{ // destructor
+} // destructor
+
+// ----------------------------------------------------------------------
+// Build brick pyramid.
+void
+cencalvm::create::PyramidBuilder::build(void)
+{ // build
+  typedef storage::BrickDB BrickDB;
+
+  if (_minLevel < 0 || _minLevel > _maxLevel ||
+      _maxLevel > BrickDB::MAXLEVEL) {
+    std::ostringstream msg;
+    msg
+      << "Levels of brick pyramid must satisfy 0 <= minimum level <= "
+      << "maximum level <= " << BrickDB::MAXLEVEL << ". Levels given are "
+      << _minLevel << " and " << _maxLevel << ".";
+    throw std::runtime_error(msg.str());
+  } // if
+
+  if (!_quiet)
+    std::cout
+      << "Building brick pyramid '" << _filenameOut
+      << "' with levels " << _minLevel << " to " << _maxLevel
+      << " from etree database '" << _filenameIn << "'."
+      << std::endl;
+
+  etree_t* dbIn = etree_open(_filenameIn.c_str(), O_RDONLY, _cacheSize, 0, 0);
+  if (0 == dbIn) {
+    std::ostringstream msg;
+    msg
+      << "Could not open etree database '" << _filenameIn
+      << "' for building brick pyramid.";
+    throw std::runtime_error(msg.str());
+  } // if
+
+  // Compact payloads are decoded so the pyramid holds the values
+  // returned by queries.
+  storage::PayloadCodec* pCodec = 0;
+  char* schemaIn = etree_getschema(dbIn);
+  const std::string schema = (0 != schemaIn) ? schemaIn : "";
+  free(schemaIn);
+  if (schema == storage::Payload::SCHEMACOMPACT) {
+    char* appmeta = etree_getappmeta(dbIn);
+    pCodec = new storage::PayloadCodec;
+    try {
+      pCodec->parseMetadata((0 != appmeta) ? appmeta : "");
+    } catch (...) {
+      free(appmeta);
+      delete pCodec; pCodec = 0;
+      etree_close(dbIn);
+      throw;
+    } // try/catch
+    free(appmeta);
+  } else if (schema != storage::Payload::SCHEMA) {
+    etree_close(dbIn);
+    std::ostringstream msg;
+    msg
+      << "Etree database '" << _filenameIn << "' does not use the full "
+      << "or compact payload.";
+    throw std::runtime_error(msg.str());
+  } // if/else
+
+  FILE* fout = fopen(_filenameOut.c_str(), "wb");
+  if (0 == fout) {
+    delete pCodec; pCodec = 0;
+    etree_close(dbIn);
+    std::ostringstream msg;
+    msg
+      << "Could not open brick pyramid '" << _filenameOut
+      << "' for writing.";
+    throw std::runtime_error(msg.str());
+  } // if
+
+  // Header and descriptions of levels are written again once the
+  // tables of bricks are known.
+  const int numLevels = _maxLevel - _minLevel + 1;
+  storage::BrickDBHeaderStruct header;
+  memset(&header, 0, sizeof(header));
+  memcpy(header.magic, BrickDB::MAGIC, sizeof(header.magic));
+  header.version = BrickDB::VERSION;
+  header.byteOrder = BrickDB::BYTEORDER;
+  header.brickSize = BrickDB::BRICKSIZE;
+  header.numLevels = numLevels;
+  std::vector<storage::BrickDBLevelStruct> levels(numLevels);
+  memset(&levels[0], 0, numLevels*sizeof(storage::BrickDBLevelStruct));
+  bool writeError =
+    (1 != fwrite(&header, sizeof(header), 1, fout)) ||
+    (numLevels != int(fwrite(&levels[0], sizeof(levels[0]), numLevels,
+			     fout)));
+  int64_t offset = sizeof(header) + numLevels*sizeof(levels[0]);
+
+  try {
+    for (int iLevel=0; iLevel < numLevels && !writeError; ++iLevel) {
+      _buildLevel(&levels[iLevel], &offset, fout, dbIn, pCodec,
+		  _minLevel+iLevel);
+      if (!_quiet)
+	std::cout
+	  << "  Level " << levels[iLevel].level << ": "
+	  << levels[iLevel].numBricks << " bricks with data" << std::endl;
+    } // for
+  } catch (...) {
+    fclose(fout);
+    delete pCodec; pCodec = 0;
+    etree_close(dbIn);
+    throw;
+  } // try/catch
+  delete pCodec; pCodec = 0;
+
+  if (0 != etree_close(dbIn))
+    throw std::runtime_error(etree_strerror(etree_errno(dbIn)));
+
+  writeError = writeError ||
+    0 != fseek(fout, sizeof(header), SEEK_SET) ||
+    numLevels != int(fwrite(&levels[0], sizeof(levels[0]), numLevels, fout));
+  writeError = (0 != fclose(fout)) || writeError;
+  if (writeError) {
+    std::ostringstream msg;
+    msg << "Error while writing brick pyramid '" << _filenameOut << "'.";
+    throw std::runtime_error(msg.str());
+  } // if
+
+  if (!_quiet)
+    std::cout
+      << "Done building brick pyramid.\n"
+      << "Size of pyramid: " << offset << " bytes" << std::endl;
+} // build
+
+// ----------------------------------------------------------------------
+// Build level of pyramid and write it to file.
+void
+cencalvm::create::PyramidBuilder::_buildLevel(
+				      storage::BrickDBLevelStruct* pInfo,
+				      int64_t* pOffset,
+				      FILE* fout,
+				      etree_t* db,
+				      const storage::PayloadCodec* pCodec,
+				      const int level)
+{ // _buildLevel
+  typedef storage::BrickDB BrickDB;
+  typedef std::map<int64_t, std::vector<storage::PayloadStruct> > brickmap_t;
+
+  assert(0 != pInfo);
+  assert(0 != pOffset);
+  assert(0 != fout);
+  assert(0 != db);
+  assert(0 <= level && level <= BrickDB::MAXLEVEL);
+
+  const int brickSize = BrickDB::BRICKSIZE;
+  const int cellsPerBrick = brickSize*brickSize*brickSize;
+  const int shift = ETREE_MAXLEVEL - level;
+
+  // Bricks are keyed by their indices, with z varying slowest, so
+  // that the map holds them in the order of the table of bricks.
+  const int keyBits = 21;
+  assert(BrickDB::MAXLEVEL - 4 <= keyBits);
+  brickmap_t bricks;
+
+  storage::PayloadStruct noData;
+  noData.Vp = storage::Payload::NODATAVAL;
+  noData.Vs = storage::Payload::NODATAVAL;
+  noData.Density = storage::Payload::NODATAVAL;
+  noData.Qp = storage::Payload::NODATAVAL;
+  noData.Qs = storage::Payload::NODATAVAL;
+  noData.DepthFreeSurf = storage::Payload::NODATAVAL;
+  noData.FaultBlock = storage::Payload::NODATABLOCK;
+  noData.Zone = storage::Payload::NODATAZONE;
+
+  // A cell gets the payload of the octant at its level or of the
+  // leaf octant at a coarser level that contains it, consistent with
+  // fixed resolution queries. Octants in pre-order never overwrite
+  // cells, because leaf octants have no descendants and descendants
+  // of octants at this level are finer than the cells.
+  etree_addr_t addr;
+  addr.x = 0;
+  addr.y = 0;
+  addr.z = 0;
+  addr.t = 0;
+  addr.level = ETREE_MAXLEVEL;
+  bool more = (0 == etree_initcursor(db, addr));
+  while (more) {
+    storage::PayloadStruct payload;
+    if (0 != etree_getcursor(db, &addr, "*", &payload))
+      throw std::runtime_error(etree_strerror(etree_errno(db)));
+    more = (0 == etree_advcursor(db));
+    if (addr.level > level ||
+	(ETREE_LEAF != addr.type && addr.level < level))
+      continue;
+    if (0 != pCodec) {
+      const storage::PayloadCompactStruct compact =
+	*(storage::PayloadCompactStruct*) &payload;
+      pCodec->decode(&payload, compact);
+    } // if
+
+    const int64_t numCells = int64_t(1) << (level - addr.level);
+    const int64_t cellMin[3] = {
+      addr.x >> shift, addr.y >> shift, addr.z >> shift };
+    int64_t brickMin[3];
+    int64_t brickMax[3];
+    for (int i=0; i < 3; ++i) {
+      brickMin[i] = cellMin[i] / brickSize;
+      brickMax[i] = (cellMin[i] + numCells - 1) / brickSize;
+    } // for
+    for (int64_t bz=brickMin[2]; bz <= brickMax[2]; ++bz)
+      for (int64_t by=brickMin[1]; by <= brickMax[1]; ++by)
+	for (int64_t bx=brickMin[0]; bx <= brickMax[0]; ++bx) {
+	  const int64_t key = (((bz << keyBits) | by) << keyBits) | bx;
+	  std::vector<storage::PayloadStruct>& brick = bricks[key];
+	  if (0 == brick.size())
+	    brick.resize(cellsPerBrick, noData);
+
+	  // Range of cells of octant within brick
+	  const int64_t brickOrigin[3] = {
+	    bx*brickSize, by*brickSize, bz*brickSize };
+	  int64_t lower[3];
+	  int64_t upper[3];
+	  for (int i=0; i < 3; ++i) {
+	    lower[i] = cellMin[i] - brickOrigin[i];
+	    if (lower[i] < 0)
+	      lower[i] = 0;
+	    upper[i] = cellMin[i] + numCells - brickOrigin[i];
+	    if (upper[i] > brickSize)
+	      upper[i] = brickSize;
+	  } // for
+	  for (int64_t z=lower[2]; z < upper[2]; ++z)
+	    for (int64_t y=lower[1]; y < upper[1]; ++y)
+	      for (int64_t x=lower[0]; x < upper[0]; ++x)
+		brick[(z*brickSize + y)*brickSize + x] = payload;
+	} // for
+  } // while
+
+  // Table of bricks covers bounding box of bricks with data.
+  memset(pInfo, 0, sizeof(*pInfo));
+  pInfo->level = level;
+  pInfo->numBricks = bricks.size();
+  const int64_t keyMask = (int64_t(1) << keyBits) - 1;
+  int64_t brickMin[3] = { 0, 0, 0 };
+  int64_t brickMax[3] = { -1, -1, -1 };
+  for (brickmap_t::const_iterator iter=bricks.begin();
+       iter != bricks.end();
+       ++iter) {
+    for (int i=0; i < 3; ++i) {
+      const int64_t index = (iter->first >> (i*keyBits)) & keyMask;
+      if (iter == bricks.begin() || index < brickMin[i])
+	brickMin[i] = index;
+      if (iter == bricks.begin() || index > brickMax[i])
+	brickMax[i] = index;
+    } // for
+  } // for
+  int64_t tableSize = 1;
+  for (int i=0; i < 3; ++i) {
+    pInfo->origin[i] = brickMin[i];
+    pInfo->dims[i] = brickMax[i] - brickMin[i] + 1;
+    tableSize *= pInfo->dims[i];
+  } // for
+
+  const int alignment = BrickDB::ALIGNMENT;
+  const int64_t brickBytes = cellsPerBrick*sizeof(storage::PayloadStruct);
+  pInfo->tableOffset = *pOffset;
+  const int64_t tableEnd = *pOffset + tableSize*sizeof(int64_t);
+  const int64_t bricksOffset =
+    alignment * ((tableEnd + alignment - 1) / alignment);
+  std::vector<int64_t> table(tableSize, -1);
+  int64_t brickOffset = bricksOffset;
+  for (brickmap_t::const_iterator iter=bricks.begin();
+       iter != bricks.end();
+       ++iter, brickOffset += brickBytes) {
+    int64_t index = 0;
+    for (int i=2; i >= 0; --i)
+      index = index*pInfo->dims[i] +
+	((iter->first >> (i*keyBits)) & keyMask) - pInfo->origin[i];
+    table[index] = brickOffset;
+  } // for
+
+  const std::string padding(bricksOffset - tableEnd, '\0');
+  bool writeError =
+    (tableSize > 0 &&
+     tableSize != int64_t(fwrite(&table[0], sizeof(int64_t), tableSize,
+				 fout))) ||
+    (padding.length() != fwrite(padding.data(), 1, padding.length(), fout));
+  for (brickmap_t::const_iterator iter=bricks.begin();
+       iter != bricks.end() && !writeError;
+       ++iter)
+    writeError = (1 != fwrite(&iter->second[0], brickBytes, 1, fout));
+  if (writeError) {
+    std::ostringstream msg;
+    msg
+      << "Error while writing level " << level << " of brick pyramid '"
+      << _filenameOut << "'.";
+    throw std::runtime_error(msg.str());
+  } // if
+  *pOffset = brickOffset;
+} // _buildLevel
+
+// End of file
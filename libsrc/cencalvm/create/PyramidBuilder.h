@@ -0,0 +1,141 @@
+// -*- C++ -*-
+//
+// ======================================================================
+//
+//                           Brad T. Aagaard
+//                        U.S. Geological Survey
+//
+// {LicenseText}
+//
+// ======================================================================
+//
+
+/** @file libsrc/create/PyramidBuilder.h
+ *
+ * @brief C++ object for building a multi-resolution brick pyramid of
+ * a packed etree database.
+ *
+ * Each level of the pyramid is built with one pass of a cursor over
+ * the database in Morton pre-order (see storage::BrickDB). Only the
+ * bricks with data at the level being built are held in memory, so
+ * the memory required is set by the volume with data at the finest
+ * level. Databases with full or compact payloads may be used.
+ */
+
+#if !defined(cencalvm_create_pyramidbuilder_h)
+#define cencalvm_create_pyramidbuilder_h
+
+#include "cencalvm/storage/etreefwd.h" // USES etree_t
+
+#include <stdio.h> // USES FILE
+#include <string> // HASA std::string
+
+namespace cencalvm {
+  namespace create {
+    class PyramidBuilder;
+    class TestPyramidBuilder; // friend
+  } // namespace create
+
+  namespace storage {
+    struct BrickDBLevelStruct; // USES BrickDBLevelStruct
+    class PayloadCodec; // USES PayloadCodec
+  } // namespace storage
+} // namespace cencalvm
+
+/// C++ object for building a multi-resolution brick pyramid of a
+/// packed etree database.
+class cencalvm::create::PyramidBuilder
+{ // PyramidBuilder
+  friend class TestPyramidBuilder;
+
+public :
+  // PUBLIC METHODS /////////////////////////////////////////////////////
+
+  /// Constructor
+  PyramidBuilder(void);
+
+  /// Destructor
+  ~PyramidBuilder(void);
+
+  /** Set filename of input (etree) database.
+   *
+   * @param filename Name of file
+   */
+  void filenameIn(const char* filename);
+
+  /** Set filename of output (brick pyramid) database.
+   *
+   * @param filename Name of file
+   */
+  void filenameOut(const char* filename);
+
+  /** Set database cache size.
+   *
+   * @param size Size of cache in MB
+   */
+  void cacheSize(const int size);
+
+  /** Set range of levels in pyramid.
+   *
+   * @param minLevel Coarsest level
+   * @param maxLevel Finest level
+   */
+  void levels(const int minLevel,
+	      const int maxLevel);
+
+  /// Build brick pyramid.
+  void build(void);
+
+  /** Set flag indicating building should be quiet (no progress
+   * reports).
+   *
+   * Default behavior is for to give progress reports.
+   *
+   * @param flag True for quiet operation, false to give progress reports
+   */
+  void quiet(const bool flag);
+
+private :
+  // PRIVATE METHODS ////////////////////////////////////////////////////
+
+  /** Build level of pyramid and write it to file.
+   *
+   * @param pInfo Pointer to description of level
+   * @param pOffset Pointer to current offset in file
+   * @param fout Output file
+   * @param db Input database
+   * @param pCodec Decoder for compact payloads (0 for full payloads)
+   * @param level Octant level
+   */
+  void _buildLevel(storage::BrickDBLevelStruct* pInfo,
+		   int64_t* pOffset,
+		   FILE* fout,
+		   etree_t* db,
+		   const storage::PayloadCodec* pCodec,
+		   const int level);
+
+private :
+  // NOT IMPLEMENTED ////////////////////////////////////////////////////
+
+  PyramidBuilder(const PyramidBuilder& b); ///< Not implemented
+  const PyramidBuilder& operator=(const PyramidBuilder& b); ///< Not implemented
+
+private :
+  // PRIVATE MEMBERS ////////////////////////////////////////////////////
+
+  std::string _filenameIn; ///< Filename of input database
+  std::string _filenameOut; ///< Filename of output database
+
+  int _cacheSize; ///< Size of database cache in MB
+  int _minLevel; ///< Coarsest level in pyramid
+  int _maxLevel; ///< Finest level in pyramid
+
+  bool _quiet; ///< Flag to eliminate progress reports
+
+}; // PyramidBuilder
+
+#include "PyramidBuilder.icc" // inline methods
+
+#endif // cencalvm_create_pyramidbuilder_h
+
+// End of file
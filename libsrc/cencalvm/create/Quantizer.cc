@@ -0,0 +1,188 @@
+// -*- C++ -*-
+//
+// ======================================================================
+//
+//                           Brad T. Aagaard
+//                        U.S. Geological Survey
+//
+// {LicenseText}
+//
+// ======================================================================
+//
+
+#include "Quantizer.h" // implementation of class methods
+
+#include "cencalvm/storage/Payload.h" // USES PayloadStruct
+#include "cencalvm/storage/PayloadCodec.h" // HASA PayloadCodec
+
+extern "C" {
+#include "etree.h"
+}
+
+#include <stdlib.h> // USES free()
+#include <time.h> // USES time_t
+#include <unistd.h> // USES gethostname()
+#include <iostream> // USES std::cout
+
+#include <stdexcept> // USES std::runtime_error
+#include <sstream> // USES std::ostringstream
+#include <assert.h> // USES assert()
+
+// ----------------------------------------------------------------------
+// Constructor
+cencalvm::create::Quantizer::Quantizer(void) :
+  _filenameIn(""),
+  _filenameOut(""),
+  _pCodec(new storage::PayloadCodec),
+  _cacheSize(64),
+  _quiet(false)
+{ // constructor
+} // constructor
+
+// ----------------------------------------------------------------------
+// Destructor
+cencalvm::create::Quantizer::~Quantizer(void)
+{ // destructor
+  delete _pCodec; _pCodec = 0;
+} // destructor
+
+// ----------------------------------------------------------------------
+// Set maximum error in quantized value.
+void
+cencalvm::create::Quantizer::errorBound(const char* name,
+					const double bound)
+{ // errorBound
+  assert(0 != _pCodec);
+  _pCodec->errorBound(name, bound);
+} // errorBound
+
+// ----------------------------------------------------------------------
+// Convert database to compact database.
+void
+cencalvm::create::Quantizer::quantize(void)
+{ // quantize
+  assert(0 != _pCodec);
+
+  if (!_quiet)
+    std::cout
+      << "Quantizing etree database '" << _filenameIn
+      << "' to compact etree database '" << _filenameOut << "'."
+      << std::endl;
+
+  const int numDims = 3;
+  const int payloadSize = sizeof(cencalvm::storage::PayloadStruct);
+  etree_t* dbIn = etree_open(_filenameIn.c_str(), O_RDONLY,
+			     _cacheSize, payloadSize, numDims);
+  if (0 == dbIn) {
+    std::ostringstream msg;
+    msg
+      << "Could not open etree database '" << _filenameIn
+      << "' for quantization.";
+    throw std::runtime_error(msg.str());
+  } // if
+  if (etree_getpayloadsize(dbIn) != payloadSize) {
+    std::ostringstream msg;
+    msg
+      << "Payload size of input etree database '" << _filenameIn
+      << "' doesn't match the expected payload size.\n"
+      << "Expected payload size is " << payloadSize
+      << ", and database payload size is " << etree_getpayloadsize(dbIn)
+      << ".";
+    etree_close(dbIn);
+    throw std::runtime_error(msg.str());
+  } // if
+
+  etree_addr_t addr;
+  addr.x = 0;
+  addr.y = 0;
+  addr.z = 0;
+  addr.t = 0;
+  addr.level = ETREE_MAXLEVEL;
+
+  // First pass: find range of values.
+  _pCodec->resetRange();
+  long numOctants = 0;
+  bool more = (0 == etree_initcursor(dbIn, addr));
+  while (more) {
+    cencalvm::storage::PayloadStruct payload;
+    if (0 != etree_getcursor(dbIn, &addr, "*", &payload))
+      throw std::runtime_error(etree_strerror(etree_errno(dbIn)));
+    _pCodec->updateRange(payload);
+    ++numOctants;
+    more = (0 == etree_advcursor(dbIn));
+  } // while
+  _pCodec->initialize();
+
+  const int payloadSizeOut = sizeof(cencalvm::storage::PayloadCompactStruct);
+  etree_t* dbOut = etree_open(_filenameOut.c_str(), O_CREAT|O_TRUNC|O_RDWR,
+			      _cacheSize, payloadSizeOut, numDims);
+  if (0 == dbOut) {
+    etree_close(dbIn);
+    std::ostringstream msg;
+    msg
+      << "Could not open etree database '" << _filenameOut
+      << "' for output of compact database.";
+    throw std::runtime_error(msg.str());
+  } // if
+
+  if (0 != etree_registerschema(dbOut,
+				cencalvm::storage::Payload::SCHEMACOMPACT))
+    throw std::runtime_error(etree_strerror(etree_errno(dbOut)));
+
+  // Record quantization parameters in metadata
+  const int maxLen = 128;
+  char hostname[maxLen];
+  gethostname(hostname, maxLen);
+  time_t rawTime = time(0);
+  const char* datetime = ctime(&rawTime);
+  std::ostringstream metainfo;
+  char* appmeta = etree_getappmeta(dbIn);
+  if (0 != appmeta)
+    metainfo << appmeta << "\n";
+  free(appmeta);
+  metainfo
+    << _pCodec->metadata() << "\n"
+    << "quantized from '" << _filenameIn << "' on: " << datetime
+    << "host: " << hostname;
+  if (0 != etree_setappmeta(dbOut, metainfo.str().c_str()))
+    throw std::runtime_error(etree_strerror(etree_errno(dbOut)));
+
+  // Second pass: append quantized octants.
+  addr.x = 0;
+  addr.y = 0;
+  addr.z = 0;
+  addr.level = ETREE_MAXLEVEL;
+  if (0 != etree_beginappend(dbOut, 1))
+    throw std::runtime_error(etree_strerror(etree_errno(dbOut)));
+
+  more = (0 == etree_initcursor(dbIn, addr));
+  while (more) {
+    cencalvm::storage::PayloadStruct payload;
+    if (0 != etree_getcursor(dbIn, &addr, "*", &payload))
+      throw std::runtime_error(etree_strerror(etree_errno(dbIn)));
+    cencalvm::storage::PayloadCompactStruct compact;
+    _pCodec->encode(&compact, payload);
+    if (0 != etree_append(dbOut, addr, &compact))
+      throw std::runtime_error(etree_strerror(etree_errno(dbOut)));
+    more = (0 == etree_advcursor(dbIn));
+  } // while
+
+  if (0 != etree_endappend(dbOut))
+    throw std::runtime_error(etree_strerror(etree_errno(dbOut)));
+
+  if (0 != etree_close(dbIn))
+    throw std::runtime_error(etree_strerror(etree_errno(dbIn)));
+
+  if (0 != etree_close(dbOut))
+    throw std::runtime_error(etree_strerror(etree_errno(dbOut)));
+
+  if (!_quiet)
+    std::cout
+      << "Done quantizing etree database.\n"
+      << "Number of octants: " << numOctants << "\n"
+      << "Payload size reduced from " << payloadSize << " to "
+      << payloadSizeOut << " bytes.\n"
+      << _pCodec->metadata() << std::endl;
+} // quantize
+
+// End of file
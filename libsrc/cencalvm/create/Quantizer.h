@@ -0,0 +1,118 @@
+// -*- C++ -*-
+//
+// ======================================================================
+//
+//                           Brad T. Aagaard
+//                        U.S. Geological Survey
+//
+// {LicenseText}
+//
+// ======================================================================
+//
+
+/** @file libsrc/create/Quantizer.h
+ *
+ * @brief C++ object for converting an etree database to a compact
+ * etree database with quantized payloads.
+ *
+ * The octants of the input database are streamed twice with a
+ * cursor. The first pass finds the range of each value and the second
+ * pass appends the quantized octants to the output database. The
+ * compact database has the same octants as the input database and can
+ * be queried with VMQuery, which restores the values to within the
+ * error bounds.
+ */
+
+#if !defined(cencalvm_create_quantizer_h)
+#define cencalvm_create_quantizer_h
+
+#include <string> // HASA std::string
+
+namespace cencalvm {
+  namespace create {
+    class Quantizer;
+    class TestQuantizer; // friend
+  } // namespace create
+  namespace storage {
+    class PayloadCodec; // HASA PayloadCodec
+  } // namespace storage
+} // namespace cencalvm
+
+/// C++ object for converting an etree database to a compact etree
+/// database with quantized payloads.
+class cencalvm::create::Quantizer
+{ // Quantizer
+  friend class TestQuantizer;
+
+public :
+  // PUBLIC METHODS /////////////////////////////////////////////////////
+
+  /// Constructor
+  Quantizer(void);
+
+  /// Destructor
+  ~Quantizer(void);
+
+  /** Set filename of input database.
+   *
+   * @param filename Name of file
+   */
+  void filenameIn(const char* filename);
+
+  /** Set filename of output (compact) database.
+   *
+   * @param filename Name of file
+   */
+  void filenameOut(const char* filename);
+
+  /** Set database cache size.
+   *
+   * @param size Size of cache in MB
+   */
+  void cacheSize(const int size);
+
+  /** Set maximum error in quantized value.
+   *
+   * @param name Name of value in payload
+   * @param bound Maximum absolute error
+   */
+  void errorBound(const char* name,
+		  const double bound);
+
+  /// Convert database to compact database.
+  void quantize(void);
+
+  /** Set flag indicating conversion should be quiet (no progress
+   * reports).
+   *
+   * Default behavior is for to give progress reports.
+   *
+   * @param flag True for quiet operation, false to give progress reports
+   */
+  void quiet(const bool flag);
+
+private :
+  // NOT IMPLEMENTED ////////////////////////////////////////////////////
+
+  Quantizer(const Quantizer& q); ///< Not implemented
+  const Quantizer& operator=(const Quantizer& q); ///< Not implemented
+
+private :
+  // PRIVATE MEMBERS ////////////////////////////////////////////////////
+
+  std::string _filenameIn; ///< Filename of input database
+  std::string _filenameOut; ///< Filename of output database
+
+  storage::PayloadCodec* _pCodec; ///< Quantization of payloads
+
+  int _cacheSize; ///< Size of database cache in MB
+
+  bool _quiet; ///< Flag to eliminate progress reports
+
+}; // Quantizer
+
+#include "Quantizer.icc" // inline methods
+
+#endif // cencalvm_create_quantizer_h
+
+// End of file
@@ -0,0 +1,585 @@
+// -*- C++ -*-
+//
+// ======================================================================
+//
+//                           Brad T. Aagaard
+//                        U.S. Geological Survey
+//
+// {LicenseText}
+//
+// ======================================================================
+//
+
+#include "SynthGenerator.h" // implementation of class methods
+
+#include "VMCreator.h" // USES VMCreator
+#include "cencalvm/storage/Payload.h" // USES PayloadStruct
+#include "cencalvm/storage/Geometry.h" // USES Geometry
+#include "cencalvm/storage/Telemetry.h" // USES Telemetry
+#include "cencalvm/average/AvgEngine.h" // USES AvgEngine
+
+extern "C" {
+#include "etree.h"
+}
+
+#include <random> // USES std::mt19937
+
+#include <math.h> // USES sin(), exp(), ceil(), floor(), sqrt(), fabs()
+
+#include <iostream> // USES std::cout
+#include <stdexcept> // USES std::runtime_error
+#include <sstream> // USES std::ostringstream
+#include <assert.h> // USES assert()
+
+// ----------------------------------------------------------------------
+const double cencalvm::create::SynthGenerator::_ORIGINX = 0.25;
+const double cencalvm::create::SynthGenerator::_ORIGINY = 0.125;
+const double cencalvm::create::SynthGenerator::_MAXDEPTH = 45000.0;
+const int cencalvm::create::SynthGenerator::_LAYEROCTANTS = 64;
+const int cencalvm::create::SynthGenerator::_NUMWAVES = 4;
+const double cencalvm::create::SynthGenerator::_WAVELENGTH = 40000.0;
+const double cencalvm::create::SynthGenerator::_MAXBASINDEPTH = 4000.0;
+const double cencalvm::create::SynthGenerator::_PERTURBATION = 0.02;
+
+
+// ----------------------------------------------------------------------
+// Constructor
+cencalvm::create::SynthGenerator::SynthGenerator(void) :
+  _filenameOut(""),
+  _filenameTmp(""),
+  _cacheSize(64),
+  _description(""),
+  _pGeom(0),
+  _pTelemetry(0),
+  _numThreads(0),
+  _sortSize(0),
+  _average(false),
+  _numOctants(1000000),
+  _resolution(100.0),
+  _numLayers(4),
+  _topography(1500.0),
+  _water(500.0),
+  _numFaultBlocks(6),
+  _seed(1),
+  _quiet(false)
+{ // constructor
+} // constructor
+
+// ----------------------------------------------------------------------
+// Destructor
+cencalvm::create::SynthGenerator::~SynthGenerator(void)
+{ // destructor
+  delete _pGeom; _pGeom = 0;
+} // destructor
+
+// ----------------------------------------------------------------------
+// Set velocity model geometry
+void
+cencalvm::create::SynthGenerator::geometry(const storage::Geometry* pGeom)
+{ // geometry
+  delete _pGeom; _pGeom = (0 != pGeom) ? pGeom->clone() : 0;
+} // geometry
+
+// ----------------------------------------------------------------------
+// Get number of octants in column of top layer.
+int
+cencalvm::create::SynthGenerator::ModelStruct::numColumnOctants(
+					    const double surface) const
+{ // numColumnOctants
+  const LayerStruct& layer = layers[0];
+  const double zMaterial = z((surface < 0.0) ? 0.0 : surface);
+  const int maxOctants = (layer.zTop - layer.zBottom) / layer.tickLen;
+  const int num =
+    int(ceil((zMaterial - layer.zBottom) / layer.tickLen - 0.5));
+  return (num < 0) ? 0 : (num > maxOctants) ? maxOctants : num;
+} // numColumnOctants
+
+// ----------------------------------------------------------------------
+// Generate the database.
+void
+cencalvm::create::SynthGenerator::run(void) const
+{ // run
+  assert(std::string("") != _filenameTmp);
+  assert(std::string("") != _filenameOut);
+
+  if (0 == _pGeom)
+    throw std::runtime_error("Geometry of synthetic model not set.");
+  if (_average && 0 == _sortSize)
+    throw std::runtime_error("Averaging while building the database "
+			     "requires sorting the points.");
+
+  ModelStruct model;
+  _setupModel(&model);
+  _sizeModel(&model);
+
+  if (!_quiet)
+    std::cout
+      << "Generating synthetic model with " << model.numOctants
+      << " octants in region " << model.length/1.0e+3 << " km long and "
+      << model.width/1.0e+3 << " km wide with " << model.layers.size()
+      << " layers and resolution of " << _resolution << " m at surface."
+      << std::endl;
+
+  VMCreator creator;
+  creator.quiet(_quiet);
+  creator.numThreads(_numThreads);
+  creator.telemetry(_pTelemetry);
+
+  if (_average)
+    creator.openAveragedDB(_filenameOut.c_str(),
+			   _cacheSize,
+			   _description.c_str(),
+			   _filenameTmp.c_str(),
+			   _sortSize,
+			   cencalvm::average::AvgEngine::DEFAULTBUFFERSIZE);
+  else if (_sortSize > 0)
+    creator.openSortedDB(_filenameOut.c_str(),
+			 _cacheSize,
+			 _description.c_str(),
+			 _filenameTmp.c_str(),
+			 _sortSize);
+  else
+    creator.openDB(_filenameTmp.c_str(),
+		   _cacheSize,
+		   _description.c_str());
+
+  if (0 != _pTelemetry) {
+    _pTelemetry->beginPhase("generate", model.numOctants);
+    if (0 == _sortSize)
+      _pTelemetry->cacheSize(_cacheSize);
+  } // if
+  const size_t numOctants = _generate(&creator, model);
+  assert(numOctants == model.numOctants);
+  if (0 != _pTelemetry)
+    _pTelemetry->endPhase();
+
+  creator.closeDB();
+
+  if (0 == _sortSize)
+    creator.packDB(_filenameOut.c_str(), _filenameTmp.c_str(),
+		   _cacheSize);
+
+  if (!_quiet)
+    std::cout << "Done generating synthetic model." << std::endl;
+} // run
+
+// ----------------------------------------------------------------------
+// Get region covered by the model in etree address space.
+void
+cencalvm::create::SynthGenerator::region(etree_tick_t* pX0,
+					 etree_tick_t* pY0,
+					 etree_tick_t* pLenX,
+					 etree_tick_t* pLenY) const
+{ // region
+  assert(0 != pX0);
+  assert(0 != pY0);
+  assert(0 != pLenX);
+  assert(0 != pLenY);
+
+  if (0 == _pGeom)
+    throw std::runtime_error("Geometry of synthetic model not set.");
+
+  ModelStruct model;
+  _setupModel(&model);
+  _sizeModel(&model);
+
+  const etree_tick_t tickCoarse = model.layers.back().tickLen;
+  *pX0 = model.x0;
+  *pY0 = model.y0;
+  *pLenX = model.numX * tickCoarse;
+  *pLenY = model.numY * tickCoarse;
+} // region
+
+// ----------------------------------------------------------------------
+// Setup layers and features of model.
+void
+cencalvm::create::SynthGenerator::_setupModel(ModelStruct* pModel) const
+{ // _setupModel
+  assert(0 != pModel);
+  assert(0 != _pGeom);
+
+  const int levelTop = _pGeom->level(_resolution);
+  const double tolerance = 1.0e-6;
+  if (levelTop < 0 || levelTop >= ETREE_MAXLEVEL ||
+      fabs(1.0 - _resolution / _pGeom->edgeLen(levelTop)) > tolerance) {
+    std::ostringstream msg;
+    msg << "Resolution of " << _resolution << " m is not the edge length "
+	<< "of octants at any level in the geometry.";
+    throw std::runtime_error(msg.str());
+  } // if
+  const int levelBottom = levelTop - (_numLayers - 1);
+  if (levelBottom < 1) {
+    std::ostringstream msg;
+    msg << "Too many layers (" << _numLayers << ") for resolution of "
+	<< _resolution << " m.";
+    throw std::runtime_error(msg.str());
+  } // if
+
+  // Vertical extent of root octant from elevation of its centroid.
+  const etree_tick_t rootLen = 0x80000000;
+  etree_addr_t addr;
+  addr.x = 0;
+  addr.y = 0;
+  addr.z = 0;
+  addr.t = 0;
+  addr.level = 0;
+  addr.type = ETREE_LEAF;
+  double lon = 0.0;
+  double lat = 0.0;
+  double elevCentroid = 0.0;
+  _pGeom->addrToLonLatElev(&lon, &lat, &elevCentroid, &addr);
+  const double vertExag = _pGeom->vertExag();
+  const double heightRoot = _pGeom->edgeLen(0) / vertExag;
+  pModel->elevBase = elevCentroid - 0.5*heightRoot;
+  pModel->elevPerTick = heightRoot / rootLen;
+
+  // Boundaries of layers are aligned with the coarsest octants, so
+  // octants in different layers never overlap.
+  const etree_tick_t tickCoarse = rootLen >> levelBottom;
+  const double surfaceMin = -_water;
+  const double zTop =
+    ceil(pModel->z(_topography) / tickCoarse) * tickCoarse;
+  if (zTop > rootLen) {
+    std::ostringstream msg;
+    msg << "Topography of " << _topography << " m is above the top of "
+	<< "the geometry.";
+    throw std::runtime_error(msg.str());
+  } // if
+  const double heightTop = _resolution / vertExag;
+  pModel->layers.resize(_numLayers);
+  for (int iLayer=0; iLayer < _numLayers; ++iLayer) {
+    ModelStruct::LayerStruct& layer = pModel->layers[iLayer];
+    layer.level = levelTop - iLayer;
+    layer.tickLen = rootLen >> layer.level;
+    layer.edgeLen = _pGeom->edgeLen(layer.level);
+    layer.zTop = (0 == iLayer) ?
+      etree_tick_t(zTop) : pModel->layers[iLayer-1].zBottom;
+
+    // Thickness of layers doubles with the size of the octants.
+    const double elevBottom = (iLayer+1 < _numLayers) ?
+      surfaceMin - _LAYEROCTANTS * heightTop * ((2 << iLayer) - 1) :
+      -_MAXDEPTH;
+    double zBottom = floor(pModel->z(elevBottom) / tickCoarse) * tickCoarse;
+    if (zBottom > double(layer.zTop) - tickCoarse)
+      zBottom = double(layer.zTop) - tickCoarse;
+    if (zBottom < 0.0) {
+      std::ostringstream msg;
+      msg << "Layer " << iLayer << " of synthetic model extends below the "
+	  << "bottom of the geometry.";
+      throw std::runtime_error(msg.str());
+    } // if
+    layer.zBottom = etree_tick_t(zBottom);
+  } // for
+
+  pModel->x0 = etree_tick_t(_ORIGINX * rootLen / tickCoarse) * tickCoarse;
+  pModel->y0 = etree_tick_t(_ORIGINY * rootLen / tickCoarse) * tickCoarse;
+  pModel->numX = 0;
+  pModel->numY = 0;
+  pModel->length = 0.0;
+  pModel->width = 0.0;
+  pModel->numOctants = 0;
+
+  // Use raw output of generator, which is the same on all platforms.
+  std::mt19937 generator(_seed);
+  const double scale = 1.0 / 4294967296.0;
+
+  pModel->waves.resize(_NUMWAVES);
+  pModel->amplitudeTotal = 0.0;
+  for (int iWave=0; iWave < _NUMWAVES; ++iWave) {
+    ModelStruct::WaveStruct& wave = pModel->waves[iWave];
+    const double wavenumber = 2.0*M_PI * (1 << iWave) / _WAVELENGTH;
+    const double angle = M_PI * scale * generator();
+    wave.kp = wavenumber * cos(angle);
+    wave.kq = wavenumber * sin(angle);
+    wave.phase = 2.0*M_PI * scale * generator();
+    wave.amplitude = 1.0 / (1 << iWave);
+    pModel->amplitudeTotal += wave.amplitude;
+  } // for
+  pModel->coastPhase = 2.0*M_PI * scale * generator();
+
+  pModel->blocks.resize(_numFaultBlocks);
+  for (int iBlock=0; iBlock < _numFaultBlocks; ++iBlock) {
+    pModel->blocks[iBlock].basinDepth =
+      _MAXBASINDEPTH * scale * generator();
+    pModel->blocks[iBlock].vpScale = 0.95 + 0.1 * scale * generator();
+  } // for
+  pModel->faultPhases.resize(_numFaultBlocks-1);
+  for (int iFault=0; iFault+1 < _numFaultBlocks; ++iFault)
+    pModel->faultPhases[iFault] = 2.0*M_PI * scale * generator();
+} // _setupModel
+
+// ----------------------------------------------------------------------
+// Set size of region to give target number of octants.
+void
+cencalvm::create::SynthGenerator::_sizeModel(ModelStruct* pModel) const
+{ // _sizeModel
+  assert(0 != pModel);
+  assert(pModel->layers.size() > 0);
+
+  const etree_tick_t rootLen = 0x80000000;
+  const ModelStruct::LayerStruct& layerBottom = pModel->layers.back();
+  const etree_tick_t maxY = (rootLen - pModel->y0) / layerBottom.tickLen;
+  const etree_tick_t maxX = (rootLen - pModel->x0) / layerBottom.tickLen;
+
+  // Choose the number of columns across the width for a region twice
+  // as long as it is wide and then the number of columns along the
+  // length to match the target. The topography does not scale with
+  // the region, so iterate.
+  const int maxIterations = 8;
+  double numY = 1.0;
+  double numX = 2.0;
+  for (int iter=0; iter < maxIterations; ++iter) {
+    if (numX > maxX || numY > maxY) {
+      std::ostringstream msg;
+      msg << "Target number of octants (" << _numOctants << ") is too "
+	  << "large for the geometry with a resolution of " << _resolution
+	  << " m.";
+      throw std::runtime_error(msg.str());
+    } // if
+    pModel->numX = etree_tick_t(numX);
+    pModel->numY = etree_tick_t(numY);
+    pModel->length = pModel->numX * layerBottom.edgeLen;
+    pModel->width = pModel->numY * layerBottom.edgeLen;
+    pModel->numOctants = _countOctants(*pModel);
+
+    const double numPerColumn =
+      double(pModel->numOctants) / (pModel->numX * pModel->numY);
+    const double numYNew =
+      floor(0.5 + sqrt(0.5 * _numOctants / numPerColumn));
+    numY = (numYNew > 1.0) ? numYNew : 1.0;
+    const double numXNew = floor(0.5 + _numOctants / (numPerColumn * numY));
+    numX = (numXNew > 1.0) ? numXNew : 1.0;
+    if (numX == pModel->numX && numY == pModel->numY)
+      break;
+  } // for
+} // _sizeModel
+
+// ----------------------------------------------------------------------
+// Count number of octants in model.
+size_t
+cencalvm::create::SynthGenerator::_countOctants(const ModelStruct& model) const
+{ // _countOctants
+  size_t count = 0;
+
+  const int numLayers = model.layers.size();
+  const etree_tick_t tickCoarse = model.layers[numLayers-1].tickLen;
+  for (int iLayer=0; iLayer < numLayers; ++iLayer) {
+    const ModelStruct::LayerStruct& layer = model.layers[iLayer];
+    const etree_tick_t numPerCoarse = tickCoarse / layer.tickLen;
+    const size_t numX = model.numX * numPerCoarse;
+    const size_t numY = model.numY * numPerCoarse;
+    if (0 == iLayer)
+      for (size_t iY=0; iY < numY; ++iY) {
+	const double q = (iY + 0.5) * layer.edgeLen;
+	for (size_t iX=0; iX < numX; ++iX) {
+	  const double p = (iX + 0.5) * layer.edgeLen;
+	  count += model.numColumnOctants(_surface(model, p, q));
+	} // for
+      } // for
+    else
+      count += numX * numY * ((layer.zTop - layer.zBottom) / layer.tickLen);
+  } // for
+
+  return count;
+} // _countOctants
+
+// ----------------------------------------------------------------------
+// Generate octants of model and insert them into database.
+size_t
+cencalvm::create::SynthGenerator::_generate(VMCreator* pCreator,
+					    const ModelStruct& model) const
+{ // _generate
+  assert(0 != pCreator);
+
+  size_t count = 0;
+  storage::PayloadStruct payload;
+  etree_addr_t addr;
+  addr.t = 0;
+  addr.type = ETREE_LEAF;
+
+  const int numLayers = model.layers.size();
+  const etree_tick_t tickCoarse = model.layers[numLayers-1].tickLen;
+  for (int iLayer=0; iLayer < numLayers; ++iLayer) {
+    const ModelStruct::LayerStruct& layer = model.layers[iLayer];
+    const etree_tick_t numPerCoarse = tickCoarse / layer.tickLen;
+    const etree_tick_t numX = model.numX * numPerCoarse;
+    const etree_tick_t numY = model.numY * numPerCoarse;
+    const int maxZ = (layer.zTop - layer.zBottom) / layer.tickLen;
+    addr.level = layer.level;
+    for (etree_tick_t iY=0; iY < numY; ++iY) {
+      const double q = (iY + 0.5) * layer.edgeLen;
+      addr.y = model.y0 + iY * layer.tickLen;
+      for (etree_tick_t iX=0; iX < numX; ++iX) {
+	const double p = (iX + 0.5) * layer.edgeLen;
+	addr.x = model.x0 + iX * layer.tickLen;
+	const double surface = _surface(model, p, q);
+	const int iBlock = _faultBlock(model, p, q);
+	const int numZ = (0 == iLayer) ?
+	  model.numColumnOctants(surface) : maxZ;
+	for (int iZ=0; iZ < numZ; ++iZ) {
+	  addr.z = layer.zBottom + iZ * layer.tickLen;
+	  const double elev = model.elev(addr.z + 0.5*layer.tickLen);
+	  if (elev < surface)
+	    _solidPayload(&payload, model, iBlock, surface - elev,
+			  _perturbation(addr.x, addr.y, addr.z));
+	  else
+	    _waterPayload(&payload, iBlock, -elev);
+	  pCreator->insert(payload, addr);
+	} // for
+	count += numZ;
+      } // for
+    } // for
+  } // for
+
+  return count;
+} // _generate
+
+// ----------------------------------------------------------------------
+// Get elevation of ground surface.
+double
+cencalvm::create::SynthGenerator::_surface(const ModelStruct& model,
+					   const double p,
+					   const double q) const
+{ // _surface
+  // Relief from sum of sinusoids, scaled to [0,1].
+  double relief = 0.0;
+  const int numWaves = model.waves.size();
+  for (int iWave=0; iWave < numWaves; ++iWave) {
+    const ModelStruct::WaveStruct& wave = model.waves[iWave];
+    relief += wave.amplitude * sin(wave.kp*p + wave.kq*q + wave.phase);
+  } // for
+  relief = 0.5 + 0.5 * relief / model.amplitudeTotal;
+
+  if (_water <= 0.0)
+    return _topography * relief;
+
+  // Coastline runs along the length of the region at three quarters
+  // of its width. Topography rises over a fifth of the width inland
+  // and the sea floor falls over a tenth of the width offshore.
+  const double u = q / model.width;
+  const double v = p / model.length;
+  const double coast = 0.75 + 0.05 * sin(4.0*M_PI*v + model.coastPhase);
+  if (u < coast) {
+    const double taper = (coast - u) / 0.2;
+    return _topography * relief * ((taper < 1.0) ? taper : 1.0);
+  } // if
+  const double taper = (u - coast) / 0.1;
+  return -_water * ((taper < 1.0) ? taper : 1.0);
+} // _surface
+
+// ----------------------------------------------------------------------
+// Get fault block.
+int
+cencalvm::create::SynthGenerator::_faultBlock(const ModelStruct& model,
+					      const double p,
+					      const double q) const
+{ // _faultBlock
+  // Fault traces run along the length of the region and are evenly
+  // spaced across its width. They wiggle by less than half the
+  // spacing, so they never cross.
+  const double u = q / model.width;
+  const double v = p / model.length;
+  const int numFaults = model.faultPhases.size();
+  const double spacing = 1.0 / (numFaults + 1);
+  int iBlock = 0;
+  for (int iFault=0; iFault < numFaults; ++iFault) {
+    const double trace = spacing * (iFault + 1 +
+      0.25 * sin(3.0*M_PI*v + model.faultPhases[iFault]));
+    if (u > trace)
+      ++iBlock;
+  } // for
+  return iBlock;
+} // _faultBlock
+
+// ----------------------------------------------------------------------
+// Compute payload of solid octant.
+void
+cencalvm::create::SynthGenerator::_solidPayload(
+				       storage::PayloadStruct* pPayload,
+				       const ModelStruct& model,
+				       const int iBlock,
+				       const double depth,
+				       const double perturbation)
+{ // _solidPayload
+  assert(0 != pPayload);
+  assert(0 <= iBlock && iBlock < int(model.blocks.size()));
+
+  const ModelStruct::BlockStruct& block = model.blocks[iBlock];
+  const int zoneBasin = 2;
+  const int zoneBasement = 3;
+
+  double vp = 0.0;
+  int zone = 0;
+  if (depth < block.basinDepth) {
+    vp = 1700.0 + 0.8 * depth;
+    zone = zoneBasin;
+  } else {
+    vp = 5000.0 + 1800.0 * (1.0 - exp(-(depth - block.basinDepth)/15000.0));
+    zone = zoneBasement;
+  } // if/else
+  vp *= block.vpScale * (1.0 + _PERTURBATION * perturbation);
+
+  // Vs, density, and Q from Brocher (2005, 2008) with wave speeds in
+  // km/s and density in g/cm^3.
+  const double vpK = vp / 1.0e+3;
+  const double vsK =
+    0.7858 + vpK*(-1.2344 + vpK*(0.7949 + vpK*(-0.1238 + vpK*0.0064)));
+  const double density =
+    vpK*(1.6612 + vpK*(-0.4721 + vpK*(0.0671 + vpK*(-0.0043 +
+							vpK*0.000106))));
+  const double qs = -16.0 + vsK*(104.13 + vsK*(-25.225 + vsK*8.2184));
+
+  pPayload->Vp = vp;
+  pPayload->Vs = vsK * 1.0e+3;
+  pPayload->Density = density * 1.0e+3;
+  pPayload->Qp = 2.0 * qs;
+  pPayload->Qs = qs;
+  pPayload->DepthFreeSurf = depth;
+  pPayload->FaultBlock = iBlock + 1;
+  pPayload->Zone = zone;
+} // _solidPayload
+
+// ----------------------------------------------------------------------
+// Compute payload of water octant.
+void
+cencalvm::create::SynthGenerator::_waterPayload(
+				       storage::PayloadStruct* pPayload,
+				       const int iBlock,
+				       const double depth)
+{ // _waterPayload
+  assert(0 != pPayload);
+
+  const int zoneWater = 1;
+
+  pPayload->Vp = 1480.0;
+  pPayload->Vs = 0.0;
+  pPayload->Density = 1000.0;
+  pPayload->Qp = 1000.0;
+  pPayload->Qs = 1000.0;
+  pPayload->DepthFreeSurf = depth;
+  pPayload->FaultBlock = iBlock + 1;
+  pPayload->Zone = zoneWater;
+} // _waterPayload
+
+// ----------------------------------------------------------------------
+// Get random perturbation of octant.
+double
+cencalvm::create::SynthGenerator::_perturbation(const etree_tick_t x,
+						const etree_tick_t y,
+						const etree_tick_t z) const
+{ // _perturbation
+  // Hash of seed and address (splitmix64 finalizer), so the
+  // perturbation does not depend on the order of generation.
+  uint64_t hash = _seed;
+  const etree_tick_t coords[] = { x, y, z };
+  for (int i=0; i < 3; ++i) {
+    hash ^= coords[i];
+    hash += 0x9e3779b97f4a7c15ULL;
+    hash = (hash ^ (hash >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    hash = (hash ^ (hash >> 27)) * 0x94d049bb133111ebULL;
+    hash ^= hash >> 31;
+  } // for
+  return 2.0 * (hash >> 11) / 9007199254740992.0 - 1.0;
+} // _perturbation
+
+// End of file
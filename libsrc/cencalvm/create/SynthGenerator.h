@@ -0,0 +1,417 @@
+// -*- C++ -*-
+//
+// ======================================================================
+//
+//                           Brad T. Aagaard
+//                        U.S. Geological Survey
+//
+// {LicenseText}
+//
+// ======================================================================
+//
+
+/** @file libsrc/create/SynthGenerator.h
+ *
+ * @brief C++ object for generating a synthetic velocity model
+ * database with the size and structure of the real model.
+ *
+ * The synthetic model covers a region at the location of the detailed
+ * region of the model with a length about twice its width. The region
+ * extends from the top of the topography to a depth of 45 km. Octants
+ * are finest near the surface and their size doubles in each deeper
+ * layer, so that the top layer holds most of the octants as in the
+ * real model. The top layer covers the topography, which rises
+ * inland and falls below sea level to a water layer offshore.
+ *
+ * Faults running along the length of the region divide it into fault
+ * blocks. Each block has a sedimentary basin (zone 2) above
+ * crystalline basement (zone 3); water octants are in zone 1. Wave
+ * speeds increase with depth below the ground surface, and density
+ * and Q follow from the wave speeds. Each octant has a small random
+ * perturbation of its wave speeds.
+ *
+ * The size of the region is chosen to give approximately the target
+ * number of octants. The model depends only on its parameters and
+ * the seed of the random number generator, so it can be regenerated
+ * exactly. The octants are inserted through VMCreator as the grids
+ * are by GridIngester.
+ */
+
+#if !defined(cencalvm_create_synthgenerator_h)
+#define cencalvm_create_synthgenerator_h
+
+#include <string> // HASA std::string
+#include <vector> // HASA std::vector
+#include <sys/types.h> // USES size_t
+
+#include "cencalvm/storage/etreefwd.h" // USES etree_tick_t
+
+namespace cencalvm {
+  namespace create {
+    class SynthGenerator;
+    class VMCreator; // USES VMCreator
+    class TestSynthGenerator; // friend
+  } // namespace create
+  namespace storage {
+    class Geometry; // HOLDSA Geometry
+    class Telemetry; // HOLDSA Telemetry
+    struct PayloadStruct; // USES PayloadStruct
+  } // namespace storage
+} // namespace cencalvm
+
+/// C++ object for generating a synthetic velocity model database.
+class cencalvm::create::SynthGenerator
+{ // SynthGenerator
+  friend class TestSynthGenerator;
+
+public :
+  // PUBLIC METHODS /////////////////////////////////////////////////////
+
+  /// Constructor
+  SynthGenerator(void);
+
+  /// Destructor
+  ~SynthGenerator(void);
+
+  /** Set filename for output file.
+   *
+   * @param filename Name of file
+   */
+  void filenameOut(const char* filename);
+
+  /** Set filename for temporary (scratch) file.
+   *
+   * @param filename Name of file
+   */
+  void filenameTmp(const char* filename);
+
+  /** Set database cache size.
+   *
+   * @param size Size of cache in MB
+   */
+  void cacheSize(const int size);
+
+  /** Set description of database.
+   *
+   * @param text Description of database
+   */
+  void description(const char* text);
+
+  /** Set geometry of velocity model.
+   *
+   * @param pGeom Pointer to velocity model geometry
+   */
+  void geometry(const storage::Geometry* pGeom);
+
+  /** Set number of threads used to read the unpacked database when
+   * packing it.
+   *
+   * @param num Number of threads (0 to use number of processors)
+   */
+  void numThreads(const int num);
+
+  /** Set size of memory used to sort octants when building the packed
+   * database directly (see GridIngester::sortSize()).
+   *
+   * @param size Size of memory in MB (0 to pack temporary database)
+   */
+  void sortSize(const int size);
+
+  /** Set flag indicating the database should be spatially averaged
+   * while it is built (requires sorting).
+   *
+   * @param flag True to average database, false otherwise
+   */
+  void average(const bool flag);
+
+  /** Set target number of octants in model.
+   *
+   * Default is 1,000,000 octants.
+   *
+   * @param num Number of octants
+   */
+  void numOctants(const size_t num);
+
+  /** Set horizontal resolution of octants at the surface.
+   *
+   * The resolution must be the edge length of octants at some level
+   * of the geometry. Default is 100 m.
+   *
+   * @param res Horizontal edge length of octants in m
+   */
+  void resolution(const double res);
+
+  /** Set number of layers with different sizes of octants.
+   *
+   * The size of the octants doubles in each deeper layer. Default is
+   * 4 layers.
+   *
+   * @param num Number of layers
+   */
+  void numLayers(const int num);
+
+  /** Set maximum elevation of topography.
+   *
+   * Default is 1500 m.
+   *
+   * @param elev Maximum elevation in m (0 for flat ground surface)
+   */
+  void topography(const double elev);
+
+  /** Set maximum depth of water offshore.
+   *
+   * Default is 500 m.
+   *
+   * @param depth Maximum depth in m (0 for no water)
+   */
+  void water(const double depth);
+
+  /** Set number of fault blocks.
+   *
+   * Default is 6 fault blocks.
+   *
+   * @param num Number of fault blocks
+   */
+  void numFaultBlocks(const int num);
+
+  /** Set seed of random number generator.
+   *
+   * @param seed Seed
+   */
+  void seed(const unsigned long seed);
+
+  /** Set telemetry for reporting progress of generating the octants
+   * (phase "generate") and of merging, averaging, or packing the
+   * database.
+   *
+   * @param pTelemetry Pointer to telemetry (0 for none)
+   */
+  void telemetry(storage::Telemetry* pTelemetry);
+
+  /// Generate the database
+  void run(void) const;
+
+  /** Get region covered by the model in etree address space.
+   *
+   * The region is the one run() generates with the current
+   * parameters; it spans the full height of the model.
+   *
+   * @param pX0 Pointer to x coordinate of origin of region
+   * @param pY0 Pointer to y coordinate of origin of region
+   * @param pLenX Pointer to length of region along x in ticks
+   * @param pLenY Pointer to length of region along y in ticks
+   */
+  void region(etree_tick_t* pX0,
+	      etree_tick_t* pY0,
+	      etree_tick_t* pLenX,
+	      etree_tick_t* pLenY) const;
+
+  /** Set flag indicating generation should be quiet (no progress
+   * reports).
+   *
+   * @param flag True for quiet operation, false to give progress reports
+   */
+  void quiet(const bool flag);
+
+private :
+  // PRIVATE STRUCTS ////////////////////////////////////////////////////
+
+  /// Layers, region, and features of model.
+  struct ModelStruct {
+    /// Layer with octants of one size.
+    struct LayerStruct {
+      int level; ///< Level of octants in etree
+      etree_tick_t tickLen; ///< Length of octants in ticks
+      etree_tick_t zBottom; ///< Z coordinate of bottom of layer
+      etree_tick_t zTop; ///< Z coordinate of top of layer
+      double edgeLen; ///< Horizontal edge length of octants in m
+    }; // LayerStruct
+
+    /// Sinusoid in topography.
+    struct WaveStruct {
+      double kp; ///< Wavenumber along length of region
+      double kq; ///< Wavenumber along width of region
+      double phase; ///< Phase
+      double amplitude; ///< Relative amplitude
+    }; // WaveStruct
+
+    /// Properties of fault block.
+    struct BlockStruct {
+      double basinDepth; ///< Depth of sedimentary basin in m
+      double vpScale; ///< Scale factor for Vp
+    }; // BlockStruct
+
+    std::vector<LayerStruct> layers; ///< Layers from top to bottom
+    std::vector<WaveStruct> waves; ///< Sinusoids in topography
+    std::vector<BlockStruct> blocks; ///< Fault blocks
+    std::vector<double> faultPhases; ///< Phases of fault traces
+    double coastPhase; ///< Phase of coastline
+    double amplitudeTotal; ///< Sum of amplitudes of sinusoids
+
+    etree_tick_t x0; ///< X coordinate of origin of region
+    etree_tick_t y0; ///< Y coordinate of origin of region
+    etree_tick_t numX; ///< Number of coarsest columns along length
+    etree_tick_t numY; ///< Number of coarsest columns along width
+    double length; ///< Length of region in m
+    double width; ///< Width of region in m
+
+    double elevBase; ///< Elevation of bottom of root octant in m
+    double elevPerTick; ///< Vertical length of tick in m
+    size_t numOctants; ///< Number of octants in model
+
+    /// Get elevation in m of z coordinate.
+    double elev(const double z) const
+    { return elevBase + z * elevPerTick; }
+
+    /// Get z coordinate of elevation in m.
+    double z(const double elev) const
+    { return (elev - elevBase) / elevPerTick; }
+
+    /** Get number of octants in column of top layer.
+     *
+     * Octants with centroids below the ground surface are solid and
+     * octants with centroids between the ground surface and sea level
+     * are water.
+     *
+     * @param surface Elevation of ground surface in m
+     * @returns Number of octants
+     */
+    int numColumnOctants(const double surface) const;
+  }; // ModelStruct
+
+private :
+  // PRIVATE METHODS ////////////////////////////////////////////////////
+
+  /** Setup layers and features of model.
+   *
+   * @param pModel Pointer to model
+   */
+  void _setupModel(ModelStruct* pModel) const;
+
+  /** Set size of region to give target number of octants.
+   *
+   * @param pModel Pointer to model
+   */
+  void _sizeModel(ModelStruct* pModel) const;
+
+  /** Count number of octants in model.
+   *
+   * @param model Model
+   * @returns Number of octants
+   */
+  size_t _countOctants(const ModelStruct& model) const;
+
+  /** Generate octants of model and insert them into database.
+   *
+   * @param pCreator Pointer to creator of database
+   * @param model Model
+   * @returns Number of octants
+   */
+  size_t _generate(VMCreator* pCreator,
+		   const ModelStruct& model) const;
+
+  /** Get elevation of ground surface.
+   *
+   * @param model Model
+   * @param p Distance along length of region in m
+   * @param q Distance along width of region in m
+   * @returns Elevation in m
+   */
+  double _surface(const ModelStruct& model,
+		  const double p,
+		  const double q) const;
+
+  /** Get fault block.
+   *
+   * @param model Model
+   * @param p Distance along length of region in m
+   * @param q Distance along width of region in m
+   * @returns Index of fault block (0 based)
+   */
+  int _faultBlock(const ModelStruct& model,
+		  const double p,
+		  const double q) const;
+
+  /** Compute payload of solid octant.
+   *
+   * @param pPayload Pointer to payload
+   * @param model Model
+   * @param iBlock Index of fault block
+   * @param depth Depth below ground surface in m
+   * @param perturbation Relative perturbation of wave speeds
+   */
+  static void _solidPayload(storage::PayloadStruct* pPayload,
+			    const ModelStruct& model,
+			    const int iBlock,
+			    const double depth,
+			    const double perturbation);
+
+  /** Compute payload of water octant.
+   *
+   * @param pPayload Pointer to payload
+   * @param iBlock Index of fault block
+   * @param depth Depth below sea level in m
+   */
+  static void _waterPayload(storage::PayloadStruct* pPayload,
+			    const int iBlock,
+			    const double depth);
+
+  /** Get random perturbation of octant.
+   *
+   * @param x X coordinate of octant address
+   * @param y Y coordinate of octant address
+   * @param z Z coordinate of octant address
+   * @returns Perturbation in [-1, 1]
+   */
+  double _perturbation(const etree_tick_t x,
+		       const etree_tick_t y,
+		       const etree_tick_t z) const;
+
+  SynthGenerator(const SynthGenerator& g); ///< Not implemented
+  const SynthGenerator& operator=(const SynthGenerator& g); ///< Not implemented
+
+private :
+  // PRIVATE MEMBERS ////////////////////////////////////////////////////
+
+  std::string _filenameOut; ///< Filename for output file
+  std::string _filenameTmp; ///< Filename for temporary file
+
+  int _cacheSize; ///< Size of database cache in MB
+  std::string _description; ///< Description of database
+
+  storage::Geometry* _pGeom; ///< Pointer to velocity model geometry
+  storage::Telemetry* _pTelemetry; ///< Pointer to telemetry
+
+  int _numThreads; ///< Number of threads used to pack
+  int _sortSize; ///< Size of memory used to sort octants in MB
+  bool _average; ///< Flag to average database while building it
+
+  size_t _numOctants; ///< Target number of octants
+  double _resolution; ///< Horizontal resolution at surface in m
+  int _numLayers; ///< Number of layers with different octant sizes
+  double _topography; ///< Maximum elevation of topography in m
+  double _water; ///< Maximum depth of water in m
+  int _numFaultBlocks; ///< Number of fault blocks
+  unsigned long _seed; ///< Seed of random number generator
+
+  bool _quiet; ///< Flag to eliminate progress reports
+
+  /// Origin of region along x and y as fraction of root octant (NW
+  /// corner of detailed region of GeomCenCA)
+  static const double _ORIGINX;
+  static const double _ORIGINY;
+  static const double _MAXDEPTH; ///< Depth of bottom of model in m
+  /// Thickness of top layer below lowest ground surface in octants
+  static const int _LAYEROCTANTS;
+  static const int _NUMWAVES; ///< Number of sinusoids in topography
+  static const double _WAVELENGTH; ///< Longest wavelength of topography
+  static const double _MAXBASINDEPTH; ///< Maximum depth of basins in m
+  static const double _PERTURBATION; ///< Amplitude of perturbations
+
+}; // SynthGenerator
+
+#include "SynthGenerator.icc" // inline methods
+
+#endif // cencalvm_create_synthgenerator_h
+
+// End of file
@@ -12,13 +12,26 @@
 
 #include "VMCreator.h" // implementation of class methods
 
+#include "OctantSorter.h" // USES OctantSorter
+
 #include "cencalvm/storage/Payload.h" // USES SCHEMA
 #include "cencalvm/storage/Geometry.h" // USES Geometry
+#include "cencalvm/storage/Telemetry.h" // USES Telemetry
+#include "cencalvm/storage/DBSnapshot.h" // USES DBSnapshot
+#include "cencalvm/average/AvgEngine.h" // USES AvgEngine
 
 extern "C" {
 #include "etree.h"
 }
 
+#include <vector> // USES std::vector
+#include <deque> // USES std::deque
+#include <algorithm> // USES std::sort()
+#include <thread> // USES std::thread
+#include <mutex> // USES std::mutex
+#include <condition_variable> // USES std::condition_variable
+#include <chrono> // USES std::chrono
+
 #include <iostream> // USES std::cout
 
 #include <time.h> // USES strftime(), gettimeofday(), localtime()
@@ -29,11 +42,50 @@ extern "C" {
 #include <sstream> // USES std::ostringstream
 #include <assert.h> // USES assert()
 
+// ----------------------------------------------------------------------
+// Block of octants read from unpacked database.
+struct cencalvm::create::VMCreator::PackBlockStruct {
+  std::vector<etree_addr_t> addrs; ///< Addresses of octants
+  std::vector<storage::PayloadStruct> payloads; ///< Payloads of octants
+}; // PackBlockStruct
+
+// ----------------------------------------------------------------------
+// Range of keys of unpacked database read by one thread.
+struct cencalvm::create::VMCreator::PackRangeStruct {
+  etree_addr_t begin; ///< First key in range
+  etree_addr_t end; ///< First key after range
+  bool hasEnd; ///< False if range extends to end of database
+  bool isDone; ///< True if all octants in range have been read
+  std::string error; ///< Error detected while reading range
+  std::deque<PackBlockStruct*> blocks; ///< Blocks waiting to be appended
+}; // PackRangeStruct
+
+// ----------------------------------------------------------------------
+// Work shared with threads reading unpacked database.
+struct cencalvm::create::VMCreator::PackWorkStruct {
+  std::mutex mutex; ///< Mutex protecting ranges and their blocks
+  std::condition_variable blockQueued; ///< Signal block read or range done
+  std::condition_variable blockTaken; ///< Signal block or range appended
+  std::vector<PackRangeStruct> ranges; ///< Ranges in etree order
+  size_t iRangeNext; ///< Index of next range to read
+  size_t iRangeAppend; ///< Index of range being appended
+  size_t maxInFlight; ///< Maximum number of ranges read at once
+  size_t maxBlocks; ///< Maximum number of blocks queued in a range
+  size_t blockSize; ///< Number of octants in a block
+  bool isFinished; ///< True if threads should exit
+}; // PackWorkStruct
+
 // ----------------------------------------------------------------------
 // Constructor
 cencalvm::create::VMCreator::VMCreator(void) :
   _filename(""),
   _pDB(0),
+  _pSorter(0),
+  _pTelemetry(0),
+  _cacheSize(0),
+  _bufferSize(0),
+  _numThreads(1),
+  _isResumed(false),
   _quiet(false)
 { // constructor
 } // constructor
@@ -42,6 +94,7 @@ cencalvm::create::VMCreator::VMCreator(void) :
 // Destructor
 cencalvm::create::VMCreator::~VMCreator(void)
 { // destructor
+  delete _pSorter; _pSorter = 0;
   if (0 != _pDB) {
     etree_close(_pDB); _pDB = 0;
   } // if
@@ -88,16 +141,165 @@ cencalvm::create::VMCreator::openDB(const char* filename,
     throw std::runtime_error(etree_strerror(etree_errno(_pDB)));
 
   _filename = filename;
+  _cacheSize = cacheSize;
+  _isResumed = false;
   
   if (!_quiet)
     std::cout << "Finished preparing database." << std::endl;
 } // openDB
 
+// ----------------------------------------------------------------------
+// Open an existing unpacked database to continue inserting data.
+void
+cencalvm::create::VMCreator::reopenDB(const char* filename,
+				      const int cacheSize)
+{ // reopenDB
+  assert(0 != filename);
+
+  if (!_quiet)
+    std::cout << "Reopening etree database '" << filename << "'."
+	      << std::endl;
+
+  _pDB = etree_open(filename, O_RDWR, cacheSize, 0, 0);
+  if (0 == _pDB) {
+    std::ostringstream msg;
+    msg << "Could not open etree database '" << filename
+	<< "' to resume creation.";
+    throw std::runtime_error(msg.str());
+  } // if
+  const int payloadSize = sizeof(storage::PayloadStruct);
+  if (etree_getpayloadsize(_pDB) != payloadSize) {
+    etree_close(_pDB); _pDB = 0;
+    std::ostringstream msg;
+    msg << "Etree database '" << filename << "' does not use the "
+	<< "payload of the velocity model.";
+    throw std::runtime_error(msg.str());
+  } // if
+
+  delete _pSorter; _pSorter = 0;
+  _bufferSize = 0;
+  _filename = filename;
+  _cacheSize = cacheSize;
+  _isResumed = false;
+} // reopenDB
+
+// ----------------------------------------------------------------------
+// Open a new packed database built by sorting the inserted octants.
+void
+cencalvm::create::VMCreator::openSortedDB(const char* filename,
+					  const int cacheSize,
+					  const char* description,
+					  const char* filenameTmp,
+					  const int sortSize)
+{ // openSortedDB
+  assert(0 != filenameTmp);
+  assert(sortSize > 0);
+
+  openDB(filename, cacheSize, description);
+
+  delete _pSorter;
+  _pSorter = new OctantSorter(filenameTmp, size_t(sortSize)*1024*1024);
+  _bufferSize = 0;
+} // openSortedDB
+
+// ----------------------------------------------------------------------
+// Open a new packed, spatially averaged database built by sorting the
+// inserted octants.
+void
+cencalvm::create::VMCreator::openAveragedDB(const char* filename,
+					    const int cacheSize,
+					    const char* description,
+					    const char* filenameTmp,
+					    const int sortSize,
+					    const int bufferSize)
+{ // openAveragedDB
+  assert(bufferSize > 0);
+
+  openSortedDB(filename, cacheSize, description, filenameTmp, sortSize);
+  _bufferSize = bufferSize;
+} // openAveragedDB
+
 // ----------------------------------------------------------------------
 // Close the database
 void
 cencalvm::create::VMCreator::closeDB(void)
 { // openDB
+  if (0 != _pSorter && 0 != _pDB) {
+    if (!_quiet)
+      std::cout << "Sorting " << _pSorter->numOctants() << " octants."
+		<< std::endl;
+    _pSorter->sort();
+
+    etree_addr_t addr;
+    storage::PayloadStruct payload;
+    if (0 == _bufferSize) {
+      if (!_quiet)
+	std::cout << "Appending sorted octants to database '" << _filename
+		  << "' (merged " << _pSorter->numRuns() << " runs)."
+		  << std::endl;
+      if (0 != _pTelemetry) {
+	_pTelemetry->beginPhase("merge", _pSorter->numOctants());
+	_pTelemetry->cacheSize(_cacheSize);
+      } // if
+      if (0 != etree_beginappend(_pDB, 1))
+	throw std::runtime_error(etree_strerror(etree_errno(_pDB)));
+      while (_pSorter->next(&addr, &payload)) {
+	if (0 != etree_append(_pDB, addr, &payload))
+	  throw std::runtime_error(etree_strerror(etree_errno(_pDB)));
+	if (0 != _pTelemetry) {
+	  _pTelemetry->addBytesWritten(sizeof(payload));
+	  _pTelemetry->addOctants();
+	} // if
+      } // while
+      if (0 != etree_endappend(_pDB))
+	throw std::runtime_error(etree_strerror(etree_errno(_pDB)));
+      if (0 != _pTelemetry)
+	_pTelemetry->endPhase();
+    } else {
+      if (!_quiet)
+	std::cout << "Averaging sorted octants into database '" << _filename
+		  << "' (merged " << _pSorter->numRuns() << " runs)."
+		  << std::endl;
+
+      char* appmeta = etree_getappmeta(_pDB);
+      if (0 != appmeta) {
+	const int maxLen = 128;
+	char hostname[maxLen];
+	gethostname(hostname, maxLen);
+	time_t rawTime = time(0);
+	const char* datetime = ctime(&rawTime);
+	std::ostringstream metainfo;
+	metainfo
+	  << appmeta << "\n"
+	  << "spatially averaged on: " << datetime
+	  << "host: "  << hostname;
+	free(appmeta);
+	if (0 != etree_setappmeta(_pDB, metainfo.str().c_str()))
+	  throw std::runtime_error(etree_strerror(etree_errno(_pDB)));
+      } // if
+
+      // Sorted octants are leaves in etree order, so the engine can
+      // average them as they stream past without an input database.
+      if (0 != _pTelemetry) {
+	_pTelemetry->beginPhase("average", _pSorter->numOctants());
+	_pTelemetry->cacheSize(_cacheSize);
+      } // if
+      average::AvgEngine engine(_pDB, 0, _bufferSize);
+      engine.telemetry(_pTelemetry);
+      engine.beginFill();
+      while (_pSorter->next(&addr, &payload))
+	engine.addOctant(&addr, payload);
+      engine.endFill();
+      if (0 != _pTelemetry)
+	_pTelemetry->endPhase();
+      if (!_quiet)
+	engine.printOctantInfo();
+    } // if/else
+  } // if
+  delete _pSorter; _pSorter = 0;
+  _bufferSize = 0;
+  _isResumed = false;
+
   if (!_quiet)
     std::cout << "Closing database '" << _filename << "'." << std::endl;
 
@@ -106,6 +308,74 @@ cencalvm::create::VMCreator::closeDB(void)
   } // if
 } // closeDB
 
+// ----------------------------------------------------------------------
+// Make data inserted so far durable.
+uint64_t
+cencalvm::create::VMCreator::checkpoint(const int slot)
+{ // checkpoint
+  assert(0 != _pDB);
+
+  uint64_t length = 0;
+  if (0 != _pSorter)
+    _pSorter->checkpoint();
+  else {
+    // Etree has no sync operation, so closing the database is the
+    // only way to flush its cache. The closed database is copied to a
+    // snapshot, because a process killed after the checkpoint can
+    // leave a database that is not a valid tree.
+    if (0 != etree_close(_pDB)) {
+      _pDB = 0;
+      std::ostringstream msg;
+      msg << "Could not close etree database '" << _filename
+	  << "' at checkpoint.";
+      throw std::runtime_error(msg.str());
+    } // if
+    _pDB = 0;
+    length = storage::DBSnapshot::save(_filename.c_str(), slot);
+    _pDB = etree_open(_filename.c_str(), O_RDWR, _cacheSize, 0, 0);
+    if (0 == _pDB) {
+      std::ostringstream msg;
+      msg << "Could not reopen etree database '" << _filename
+	  << "' at checkpoint.";
+      throw std::runtime_error(msg.str());
+    } // if
+  } // if/else
+
+  return length;
+} // checkpoint
+
+// ----------------------------------------------------------------------
+// Resume creation from the state at a checkpoint.
+void
+cencalvm::create::VMCreator::resume(const int numRuns,
+				    const size_t numOctants)
+{ // resume
+  assert(0 != _pDB);
+
+  if (0 != _pSorter)
+    _pSorter->resume(numRuns, numOctants);
+  else if (numRuns > 0 || numOctants > 0)
+    throw std::runtime_error("Checkpoint of sorted database cannot be "
+			     "used to resume creating unpacked database.");
+  _isResumed = true;
+} // resume
+
+// ----------------------------------------------------------------------
+// Get number of run files written when sorting.
+int
+cencalvm::create::VMCreator::numRuns(void) const
+{ // numRuns
+  return (0 != _pSorter) ? _pSorter->numRuns() : 0;
+} // numRuns
+
+// ----------------------------------------------------------------------
+// Get number of octants inserted into sorter.
+size_t
+cencalvm::create::VMCreator::numOctants(void) const
+{ // numOctants
+  return (0 != _pSorter) ? _pSorter->numOctants() : 0;
+} // numOctants
+
 // ----------------------------------------------------------------------
 // Create packed etree database from unpacked etree database
 void
@@ -119,59 +389,203 @@ cencalvm::create::VMCreator::packDB(const char* filenamePacked,
       << "' from unpacked etree database '" << filenameUnpacked
       << "'." << std::endl;
 
+  int numThreads = _numThreads;
+  if (numThreads <= 0)
+    numThreads = std::thread::hardware_concurrency();
+  if (numThreads <= 0)
+    numThreads = 1;
+  const int threadCacheSize = (cacheSize > numThreads) ?
+    cacheSize / numThreads : 1;
+
+  // Each reading thread needs its own cursor, so each thread gets
+  // its own handle to the unpacked database.
   const int numDims = 3;
   const int payloadSize = sizeof(cencalvm::storage::PayloadStruct);
-  etree_t* unpackeddb = etree_open(filenameUnpacked, O_RDONLY,
-				   cacheSize, payloadSize, numDims);
-  if (0 == unpackeddb)
-    throw std::runtime_error("Could not open unpacked etree database.");
+  std::vector<etree_t*> unpackeddbs(numThreads);
+  for (int iThread=0; iThread < numThreads; ++iThread) {
+    unpackeddbs[iThread] = etree_open(filenameUnpacked, O_RDONLY,
+				      threadCacheSize, payloadSize, numDims);
+    if (0 == unpackeddbs[iThread]) {
+      for (int i=0; i < iThread; ++i)
+	etree_close(unpackeddbs[i]);
+      throw std::runtime_error("Could not open unpacked etree database.");
+    } // if
+  } // for
   
   etree_t* packeddb = etree_open(filenamePacked, O_CREAT | O_TRUNC | O_RDWR,
 				 cacheSize, payloadSize, numDims);
-  if (0 == packeddb)
+  if (0 == packeddb) {
+    for (int iThread=0; iThread < numThreads; ++iThread)
+      etree_close(unpackeddbs[iThread]);
     throw std::runtime_error("Could not open packed etree database.");
+  } // if
   
-  if (0 != etree_registerschema(packeddb, cencalvm::storage::Payload::SCHEMA))
-    throw std::runtime_error(etree_strerror(etree_errno(packeddb)));
-  
-  char* appmeta = 0;
-  if (0 != (appmeta = etree_getappmeta(unpackeddb)))
-    if (0 != etree_setappmeta(packeddb, appmeta))
+  // Keep enough ranges for each thread to read several of them, so
+  // threads reading small ranges do not wait on threads reading
+  // large ones.
+  const size_t numRangesPerThread = 16;
+  std::vector<etree_addr_t> corners;
+  try {
+    if (0 != etree_registerschema(packeddb,
+				  cencalvm::storage::Payload::SCHEMA))
       throw std::runtime_error(etree_strerror(etree_errno(packeddb)));
-  free(appmeta);
-  
-  etree_addr_t addr;
-  addr.x = 0;
-  addr.y = 0;
-  addr.z = 0;
-  addr.level = 0;
-  if (0 != etree_initcursor(unpackeddb, addr))
-    throw std::runtime_error(etree_strerror(etree_errno(unpackeddb)));
-  
-  if (0 != etree_beginappend(packeddb, 1))
-    throw std::runtime_error(etree_strerror(etree_errno(packeddb)));
-  
-  do {
-    cencalvm::storage::PayloadStruct payload;
-    
-    if (0 != etree_getcursor(unpackeddb, &addr, "*", &payload))
-      throw std::runtime_error(etree_strerror(etree_errno(unpackeddb)));
-    
-    if (0 != etree_append(packeddb, addr, &payload))
+
+    char* appmeta = etree_getappmeta(unpackeddbs[0]);
+    if (0 != appmeta && 0 != etree_setappmeta(packeddb, appmeta)) {
+      free(appmeta);
       throw std::runtime_error(etree_strerror(etree_errno(packeddb)));
-  } while (0 == etree_advcursor(unpackeddb));
-  
-  if (0 != etree_endappend(packeddb))
-    throw std::runtime_error(etree_strerror(etree_errno(packeddb)));
-  
-  if (0 != etree_close(unpackeddb))
-    throw std::runtime_error(etree_strerror(etree_errno(unpackeddb)));
+    } // if
+    free(appmeta);
+
+    _splitKeys(&corners, unpackeddbs[0], numRangesPerThread*numThreads);
+
+    if (0 != etree_beginappend(packeddb, 1))
+      throw std::runtime_error(etree_strerror(etree_errno(packeddb)));
+  } catch (...) {
+    etree_close(packeddb);
+    for (int iThread=0; iThread < numThreads; ++iThread)
+      etree_close(unpackeddbs[iThread]);
+    throw;
+  } // try/catch
+
+  PackWorkStruct work;
+  const size_t numRanges = corners.size();
+  work.ranges.resize(numRanges);
+  for (size_t iRange=0; iRange < numRanges; ++iRange) {
+    PackRangeStruct& range = work.ranges[iRange];
+    range.begin = corners[iRange];
+    range.hasEnd = (iRange+1 < numRanges);
+    range.end = (range.hasEnd) ? corners[iRange+1] : corners[iRange];
+    range.isDone = false;
+  } // for
+  work.iRangeNext = 0;
+  work.iRangeAppend = 0;
+  // Keep enough ranges in flight for each thread to have one waiting
+  // and double buffer the blocks of each range.
+  work.maxInFlight = 2*numThreads;
+  work.maxBlocks = 2;
+  work.blockSize = 4096;
+  work.isFinished = false;
+
+  if (0 != _pTelemetry) {
+    _pTelemetry->beginPhase("pack", etree_gettotalcount(unpackeddbs[0]));
+    _pTelemetry->cacheSize(cacheSize);
+  } // if
+
+  std::vector<std::thread> threads;
+  for (int iThread=0; iThread < numThreads; ++iThread)
+    threads.push_back(std::thread(&VMCreator::_packWork, &work,
+				  unpackeddbs[iThread]));
+
+  // Append blocks in etree order.
+  const std::chrono::steady_clock::time_point timeStart =
+    std::chrono::steady_clock::now();
+  const long progressInterval = 4194304;
+  long numOctants = 0;
+  long numOctantsProgress = progressInterval;
+  std::string errorMsg = "";
+  bool isError = false;
+  try {
+    for (size_t iRange=0; iRange < numRanges; ++iRange) {
+      PackRangeStruct& range = work.ranges[iRange];
+      while (true) {
+	PackBlockStruct* pBlock = 0;
+	{ // scope for lock
+	  std::unique_lock<std::mutex> lock(work.mutex);
+	  while (range.blocks.empty() && !range.isDone)
+	    work.blockQueued.wait(lock);
+	  if (!range.blocks.empty()) {
+	    pBlock = range.blocks.front();
+	    range.blocks.pop_front();
+	  } // if
+	} // scope for lock
+	if (0 == pBlock)
+	  break;
+	work.blockTaken.notify_all();
+
+	const size_t numInBlock = pBlock->addrs.size();
+	for (size_t i=0; i < numInBlock; ++i)
+	  if (0 != etree_append(packeddb, pBlock->addrs[i],
+				&pBlock->payloads[i])) {
+	    delete pBlock; pBlock = 0;
+	    throw std::runtime_error(etree_strerror(etree_errno(packeddb)));
+	  } // if
+	numOctants += numInBlock;
+	delete pBlock; pBlock = 0;
+	if (0 != _pTelemetry) {
+	  _pTelemetry->addBytesRead(numInBlock*payloadSize);
+	  _pTelemetry->addBytesWritten(numInBlock*payloadSize);
+	  _pTelemetry->addOctants(numInBlock);
+	} // if
+
+	if (!_quiet && numOctants >= numOctantsProgress) {
+	  const double elapsed = std::chrono::duration<double>(
+	    std::chrono::steady_clock::now() - timeStart).count();
+	  std::cout
+	    << "  Packed " << numOctants << " octants ("
+	    << long(numOctants / elapsed) << " octants/s)." << std::endl;
+	  numOctantsProgress += progressInterval;
+	} // if
+      } // while
+      if (!range.error.empty())
+	throw std::runtime_error(range.error);
+
+      { // scope for lock
+	std::lock_guard<std::mutex> lock(work.mutex);
+	++work.iRangeAppend;
+      } // scope for lock
+      work.blockTaken.notify_all();
+    } // for
+  } catch (const std::exception& err) {
+    isError = true;
+    errorMsg = err.what();
+  } // catch
+
+  // Stop reading threads
+  { // scope for lock
+    std::lock_guard<std::mutex> lock(work.mutex);
+    work.isFinished = true;
+  } // scope for lock
+  work.blockTaken.notify_all();
+  for (int iThread=0; iThread < numThreads; ++iThread) {
+    threads[iThread].join();
+    etree_close(unpackeddbs[iThread]); unpackeddbs[iThread] = 0;
+  } // for
+  for (size_t iRange=0; iRange < numRanges; ++iRange)
+    while (!work.ranges[iRange].blocks.empty()) {
+      delete work.ranges[iRange].blocks.front();
+      work.ranges[iRange].blocks.pop_front();
+    } // while
+
+  if (isError) {
+    etree_close(packeddb);
+    throw std::runtime_error(errorMsg);
+  } // if
+
+  if (0 != etree_endappend(packeddb)) {
+    const std::string msg = etree_strerror(etree_errno(packeddb));
+    etree_close(packeddb);
+    throw std::runtime_error(msg);
+  } // if
   
   if (0 != etree_close(packeddb))
     throw std::runtime_error(etree_strerror(etree_errno(packeddb)));
+
+  if (0 != _pTelemetry)
+    _pTelemetry->endPhase();
   
-  if (!_quiet)
-    std::cout << "Done packing etree database." << std::endl;
+  if (!_quiet) {
+    const double elapsed = std::chrono::duration<double>(
+      std::chrono::steady_clock::now() - timeStart).count();
+    std::cout
+      << "Done packing etree database.\n"
+      << "Number of octants: " << numOctants
+      << ", reading threads: " << numThreads
+      << ", time: " << elapsed << " s";
+    if (elapsed > 0.0)
+      std::cout << ", rate: " << long(numOctants / elapsed) << " octants/s";
+    std::cout << std::endl;
+  } // if
 } // packDB
   
 // ----------------------------------------------------------------------
@@ -192,10 +606,183 @@ cencalvm::create::VMCreator::insert(const storage::PayloadStruct& payload,
   addr.type = ETREE_LEAF;
   pGeom->lonLatElevToAddr(&addr, lon, lat, elev);
 
-  if (0 != etree_insert(_pDB, addr, &payload))
-    throw std::runtime_error(etree_strerror(etree_errno(_pDB)));
+  insert(payload, addr);
+} // insert
+
+// ----------------------------------------------------------------------
+// Insert data into database at precomputed address.
+void
+cencalvm::create::VMCreator::insert(const storage::PayloadStruct& payload,
+				    const etree_addr_t& addr)
+{ // insert
+  assert(0 != _pDB);
+
+  if (0 != _pSorter)
+    _pSorter->add(addr, payload);
+  else {
+    if (0 != etree_insert(_pDB, addr, &payload)) {
+      // Data inserted after the checkpoint may already be in the
+      // database when resuming.
+      if (!_isResumed || 0 != etree_update(_pDB, addr, &payload))
+	throw std::runtime_error(etree_strerror(etree_errno(_pDB)));
+    } // if
+    if (0 != _pTelemetry)
+      _pTelemetry->addBytesWritten(sizeof(payload));
+  } // if/else
+  if (0 != _pTelemetry)
+    _pTelemetry->addOctants();
 } // insert
 
+// ----------------------------------------------------------------------
+// Thread loop reading ranges of unpacked database when packing.
+void
+cencalvm::create::VMCreator::_packWork(PackWorkStruct* pWork,
+				       etree_t* db)
+{ // _packWork
+  assert(0 != pWork);
+  assert(0 != db);
+
+  while (true) {
+    PackRangeStruct* pRange = 0;
+    { // scope for lock
+      std::unique_lock<std::mutex> lock(pWork->mutex);
+      while (!pWork->isFinished &&
+	     pWork->iRangeNext < pWork->ranges.size() &&
+	     pWork->iRangeNext >= pWork->iRangeAppend + pWork->maxInFlight)
+	pWork->blockTaken.wait(lock);
+      if (pWork->isFinished || pWork->iRangeNext >= pWork->ranges.size())
+	return;
+      pRange = &pWork->ranges[pWork->iRangeNext++];
+    } // scope for lock
+
+    std::string error = "";
+    try {
+      etree_addr_t addr = pRange->begin;
+      bool more = (0 == etree_initcursor(db, addr));
+      while (more) {
+	PackBlockStruct* pBlock = new PackBlockStruct;
+	pBlock->addrs.reserve(pWork->blockSize);
+	pBlock->payloads.reserve(pWork->blockSize);
+	while (more && pBlock->addrs.size() < pWork->blockSize) {
+	  storage::PayloadStruct payload;
+	  if (0 != etree_getcursor(db, &addr, "*", &payload)) {
+	    delete pBlock; pBlock = 0;
+	    throw std::runtime_error(etree_strerror(etree_errno(db)));
+	  } // if
+	  if (pRange->hasEnd && !storage::Geometry::precedes(addr, pRange->end))
+	    more = false;
+	  else {
+	    pBlock->addrs.push_back(addr);
+	    pBlock->payloads.push_back(payload);
+	    more = (0 == etree_advcursor(db));
+	  } // if/else
+	} // while
+	if (pBlock->addrs.empty()) {
+	  delete pBlock; pBlock = 0;
+	  break;
+	} // if
+
+	{ // scope for lock
+	  std::unique_lock<std::mutex> lock(pWork->mutex);
+	  while (!pWork->isFinished && pRange->blocks.size() >= pWork->maxBlocks)
+	    pWork->blockTaken.wait(lock);
+	  if (pWork->isFinished) {
+	    delete pBlock; pBlock = 0;
+	    return;
+	  } // if
+	  pRange->blocks.push_back(pBlock);
+	} // scope for lock
+	pWork->blockQueued.notify_one();
+      } // while
+    } catch (const std::exception& err) {
+      error = err.what();
+    } // catch
+
+    { // scope for lock
+      std::lock_guard<std::mutex> lock(pWork->mutex);
+      pRange->error = error;
+      pRange->isDone = true;
+    } // scope for lock
+    pWork->blockQueued.notify_one();
+  } // while
+} // _packWork
+
+// ----------------------------------------------------------------------
+// Split key space of database into ranges containing octants.
+void
+cencalvm::create::VMCreator::_splitKeys(std::vector<etree_addr_t>* pSplits,
+					etree_t* db,
+					const size_t numRanges)
+{ // _splitKeys
+  assert(0 != pSplits);
+  assert(0 != db);
+
+  // Octants are split in order of level (coarsest first), so the
+  // ranges have similar extents. Splitting stops at the maximum
+  // partition level, because a range containing a single coarse leaf
+  // octant cannot be split.
+  const int maxPartitionLevel = 16;
+
+  etree_addr_t root;
+  root.x = 0;
+  root.y = 0;
+  root.z = 0;
+  root.t = 0;
+  root.level = 0;
+  root.type = ETREE_INTERIOR;
+
+  std::deque<etree_addr_t> octants;
+  octants.push_back(root);
+  std::vector<etree_addr_t> octantsFinal;
+  while (!octants.empty() &&
+	 octants.size() + octantsFinal.size() < numRanges) {
+    const etree_addr_t parent = octants.front();
+    octants.pop_front();
+    if (parent.level >= maxPartitionLevel) {
+      octantsFinal.push_back(parent);
+      continue;
+    } // if
+
+    // Child contains data if the first key at or after its corner is
+    // inside it or at its corner (coarser octants at the same corner
+    // come first in the range of the child).
+    const etree_tick_t tickLen = 0x80000000 >> (parent.level+1);
+    for (int iChild=0; iChild < 8; ++iChild) {
+      etree_addr_t child = parent;
+      child.x += (iChild & 1) ? tickLen : 0;
+      child.y += (iChild & 2) ? tickLen : 0;
+      child.z += (iChild & 4) ? tickLen : 0;
+      child.level = parent.level + 1;
+
+      etree_addr_t key = child;
+      key.level = 0;
+      if (0 != etree_initcursor(db, key))
+	continue;
+      storage::PayloadStruct payload;
+      if (0 != etree_getcursor(db, &key, "*", &payload))
+	throw std::runtime_error(etree_strerror(etree_errno(db)));
+      if ((key.x == child.x && key.y == child.y && key.z == child.z) ||
+	  storage::Geometry::contains(child, key))
+	octants.push_back(child);
+    } // for
+  } // while
+
+  pSplits->clear();
+  pSplits->insert(pSplits->end(), octantsFinal.begin(), octantsFinal.end());
+  pSplits->insert(pSplits->end(), octants.begin(), octants.end());
+  const size_t numSplits = pSplits->size();
+  for (size_t i=0; i < numSplits; ++i)
+    (*pSplits)[i].level = 0;
+  std::sort(pSplits->begin(), pSplits->end(), storage::Geometry::precedes);
+
+  // First range begins at first key, so an empty database has one
+  // empty range.
+  if (pSplits->empty())
+    pSplits->push_back(root);
+  else
+    (*pSplits)[0] = root;
+} // _splitKeys
+
 // version
 // $Id$
 
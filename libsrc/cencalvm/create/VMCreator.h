@@ -20,17 +20,22 @@
 #define cencalvm_create_vmcreator_h
 
 #include <string> // HASA std::string
+#include <vector> // USES std::vector
+#include <sys/types.h> // USES size_t
+#include <inttypes.h> // USES uint64_t
 
 #include "cencalvm/storage/etreefwd.h" // HOLDSA etree_t
 
 namespace cencalvm {
   namespace create {
     class VMCreator;
+    class OctantSorter; // HOLDSA OctantSorter
     class TestVMCreator; // friend
   } // namespace create
   namespace storage {
     class Geometry; // USES Geometry
     struct PayloadStruct; // USES PayloadStruct
+    class Telemetry; // HOLDSA Telemetry
   } // namespace storage
 } // namespace cencalvm
 
@@ -62,10 +67,110 @@ public :
 	      const int cacheSize,
 	      const char* description);
 
+  /** Open a new packed database that is built by sorting the
+   * inserted octants and appending them in etree order when the
+   * database is closed.
+   *
+   * This avoids creating a temporary unpacked database and then
+   * packing it. Octants that do not fit in the sorting memory are
+   * written to temporary run files and merged when the database is
+   * closed.
+   *
+   * @param filename Name of file
+   * @param cacheSize Size of cache in MB
+   * @param description Description of database
+   * @param filenameTmp Root name for temporary run files
+   * @param sortSize Size of memory used for sorting in MB
+   */
+  void openSortedDB(const char* filename,
+		    const int cacheSize,
+		    const char* description,
+		    const char* filenameTmp,
+		    const int sortSize);
+
+  /** Open a new packed, spatially averaged database that is built by
+   * sorting the inserted octants and averaging them as they are
+   * appended in etree order when the database is closed.
+   *
+   * This fuses creating, packing, and averaging the database into a
+   * single sequential write of the averaged database without any
+   * intermediate databases.
+   *
+   * @param filename Name of file
+   * @param cacheSize Size of cache in MB
+   * @param description Description of database
+   * @param filenameTmp Root name for temporary run files
+   * @param sortSize Size of memory used for sorting in MB
+   * @param bufferSize Maximum number of octants in write-behind
+   * buffer used in averaging
+   */
+  void openAveragedDB(const char* filename,
+		      const int cacheSize,
+		      const char* description,
+		      const char* filenameTmp,
+		      const int sortSize,
+		      const int bufferSize);
+
+  /** Open an existing unpacked database created with openDB() to
+   * continue inserting data after a checkpoint.
+   *
+   * @param filename Name of file
+   * @param cacheSize Size of cache in MB
+   */
+  void reopenDB(const char* filename,
+		const int cacheSize);
+
   /// Close the database
   void closeDB(void);
 
+  /** Make data inserted so far durable, so that creation can resume
+   * from this point.
+   *
+   * Sorted databases write the octants held in memory to a run file.
+   * Unpacked databases are closed to flush them to disk, copied to a
+   * snapshot (see storage::DBSnapshot), and reopened.
+   *
+   * @param slot Index of snapshot slot
+   *
+   * @returns Length of snapshot of unpacked database in bytes (0 for
+   * sorted databases)
+   */
+  uint64_t checkpoint(const int slot);
+
+  /** Resume creation from the state at a checkpoint.
+   *
+   * Sorted databases adopt the run files written before the
+   * checkpoint. Unpacked databases (restored from the snapshot at the
+   * checkpoint and reopened with reopenDB()) accept data inserted
+   * again at addresses already in the database.
+   *
+   * @param numRuns Number of run files at checkpoint
+   * @param numOctants Number of octants sorted at checkpoint
+   */
+  void resume(const int numRuns,
+	      const size_t numOctants);
+
+  /** Get number of run files written when sorting.
+   *
+   * @returns Number of run files (0 for unpacked databases)
+   */
+  int numRuns(void) const;
+
+  /** Get number of octants inserted into sorter.
+   *
+   * @returns Number of octants (0 for unpacked databases)
+   */
+  size_t numOctants(void) const;
+
   /** Create packed etree database from unpacked etree database.
+   *
+   * The key space of the unpacked database is split into ranges that
+   * are read by separate threads, each with its own cursor. Octants
+   * containing data are split recursively, so the ranges cover the
+   * occupied part of the key space rather than the whole root
+   * octant. The octants are appended to the packed database in etree
+   * order as the ranges are read. The cache of the unpacked database
+   * is divided among the reading threads.
    *
    * @param filenamePacked Filename of packed database
    * @param filenameUnpacked Filename of unpacked database
@@ -91,6 +196,14 @@ public :
 	      const double resHoriz,
 	      storage::Geometry* pGeom);
 
+  /** Insert data into database at precomputed address.
+   *
+   * @param payload Data to insert
+   * @param addr Address of octant
+   */
+  void insert(const storage::PayloadStruct& payload,
+	      const etree_addr_t& addr);
+
   /** Set flag indicating creation should be quiet (no progress reports).
    *
    * Default behavior is for to give progress reports.
@@ -99,9 +212,60 @@ public :
    */
   void quiet(const bool flag);
 
+  /** Set number of threads used to read unpacked database when packing.
+   *
+   * Default behavior is to use one thread.
+   *
+   * @param num Number of threads (0 to use number of processors)
+   */
+  void numThreads(const int num);
+
+  /** Set telemetry for reporting progress of inserting, merging,
+   * averaging, and packing octants.
+   *
+   * Phases for merging sorted octants ("merge"), averaging them
+   * ("average"), and packing ("pack") are begun and ended by
+   * closeDB() and packDB(). Inserted octants are added to the
+   * current phase of the caller.
+   *
+   * @param pTelemetry Pointer to telemetry (0 for none)
+   */
+  void telemetry(storage::Telemetry* pTelemetry);
+
+private :
+  // PRIVATE STRUCTS ////////////////////////////////////////////////////
+
+  struct PackBlockStruct; ///< Block of octants read from unpacked database
+  struct PackRangeStruct; ///< Range of keys read by one thread
+  struct PackWorkStruct; ///< Work shared with reading threads
+
  private :
   // PRIVATE METHODS ////////////////////////////////////////////////////
 
+  /** Thread loop reading ranges of unpacked database when packing.
+   *
+   * @param pWork Pointer to work shared with reading threads
+   * @param db Unpacked database opened by thread
+   */
+  static void _packWork(PackWorkStruct* pWork,
+			etree_t* db);
+
+  /** Split key space of database into ranges containing octants.
+   *
+   * Starting with the root octant, the coarsest octants containing
+   * data are split into their children, and children without data
+   * are dropped, until there are enough octants or the octants reach
+   * the maximum partition level.
+   *
+   * @param pSplits Pointer to first keys of ranges in etree order
+   * @param db Database
+   * @param numRanges Minimum number of ranges (if database has enough
+   * octants)
+   */
+  static void _splitKeys(std::vector<etree_addr_t>* pSplits,
+			 etree_t* db,
+			 const size_t numRanges);
+
   VMCreator(const VMCreator& c); ///< Not implemented
   const VMCreator& operator=(const VMCreator& c); ///< Not implemented
   
@@ -110,6 +274,12 @@ private :
 
   std::string _filename; ///< Name of database file
   etree_t* _pDB; ///< Pointer to database
+  OctantSorter* _pSorter; ///< Sorter for octants in sorted database
+  storage::Telemetry* _pTelemetry; ///< Pointer to telemetry
+  int _cacheSize; ///< Size of cache in MB
+  int _bufferSize; ///< Size of averaging buffer (0 if not averaged)
+  int _numThreads; ///< Number of threads used to read unpacked database
+  bool _isResumed; ///< True if creation resumed from a checkpoint
   bool _quiet; ///< Flag to eliminate progress reports
 
 }; // VMCreator
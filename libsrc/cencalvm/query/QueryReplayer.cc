@@ -0,0 +1,470 @@
+// -*- C++ -*-
+//
+// ======================================================================
+//
+//                           Brad T. Aagaard
+//                        U.S. Geological Survey
+//
+// {LicenseText}
+//
+// ======================================================================
+//
+
+#include "QueryReplayer.h" // implementation of class methods
+
+#include "VMQuery.h" // USES VMQuery
+#include "cencalvm/storage/ErrorHandler.h" // USES ErrorHandler
+
+#include <thread> // USES std::thread
+#include <chrono> // USES std::chrono::steady_clock
+#include <algorithm> // USES std::sort()
+
+#include <time.h> // USES time()
+
+#include <iostream> // USES std::cout
+#include <iomanip> // USES std::setprecision()
+#include <fstream> // USES std::ofstream
+#include <stdexcept> // USES std::runtime_error
+#include <sstream> // USES std::ostringstream
+#include <string.h> // USES memset()
+#include <assert.h> // USES assert()
+
+// ----------------------------------------------------------------------
+/// Portion of trace replayed by a thread.
+struct cencalvm::query::QueryReplayer::WorkStruct {
+  const QueryReplayer* pReplayer; ///< Replayer holding trace
+  VMQuery* pQuery; ///< Query manager used by thread
+  size_t begin; ///< Index of first query
+  size_t end; ///< Index one past last query
+  double* pSamples; ///< Times of queries in ns
+  size_t numNoData; ///< Number of queries without data
+  std::string error; ///< Error message ("" if no error)
+}; // WorkStruct
+
+// ----------------------------------------------------------------------
+// Constructor
+cencalvm::query::QueryReplayer::QueryReplayer(void) :
+  _filenameTrace(""),
+  _filename(""),
+  _filenameExt(""),
+  _filenamePyramid(""),
+  _filenamePyramidExt(""),
+  _filenameJSON(""),
+  _cacheSize(128),
+  _cacheSizeExt(128),
+  _numThreads(1),
+  _quiet(false)
+{ // constructor
+} // constructor
+
+// ----------------------------------------------------------------------
+// Destructor
+cencalvm::query::QueryReplayer::~QueryReplayer(void)
+{ // destructor
+} // destructor
+
+// ----------------------------------------------------------------------
+// Load the trace, replay the queries, and write results.
+void
+cencalvm::query::QueryReplayer::run(void)
+{ // run
+  typedef std::chrono::steady_clock clock;
+  typedef std::chrono::duration<double> seconds;
+
+  _load();
+  const size_t numQueries = _queries.size();
+  if (0 == numQueries) {
+    std::ostringstream msg;
+    msg << "Query trace '" << _filenameTrace << "' does not contain any "
+	<< "queries.";
+    throw std::runtime_error(msg.str());
+  } // if
+
+  int numThreads = _numThreads;
+  if (numThreads <= 0)
+    numThreads = std::thread::hardware_concurrency();
+  if (numThreads <= 0)
+    numThreads = 1;
+  if (size_t(numThreads) > numQueries)
+    numThreads = numQueries;
+
+  // Open the databases before timing starts; each thread needs its
+  // own query manager because etree handles and projections are not
+  // thread safe.
+  std::vector<double> samples(numQueries);
+  std::vector<WorkStruct> work(numThreads);
+  for (int iThread=0; iThread < numThreads; ++iThread) {
+    WorkStruct& w = work[iThread];
+    w.pReplayer = this;
+    w.pQuery = 0;
+    w.begin = iThread * numQueries / numThreads;
+    w.end = (iThread+1) * numQueries / numThreads;
+    w.pSamples = &samples[0];
+    w.numNoData = 0;
+  } // for
+  try {
+    for (int iThread=0; iThread < numThreads; ++iThread)
+      work[iThread].pQuery = _createQuery();
+  } catch (...) {
+    for (int iThread=0; iThread < numThreads; ++iThread) {
+      delete work[iThread].pQuery; work[iThread].pQuery = 0;
+    } // for
+    throw;
+  } // try/catch
+
+  const clock::time_point t0 = clock::now();
+  if (1 == numThreads)
+    _work(&work[0]);
+  else {
+    std::vector<std::thread> threads;
+    for (int iThread=0; iThread < numThreads; ++iThread)
+      threads.push_back(std::thread(&QueryReplayer::_work, &work[iThread]));
+    for (int iThread=0; iThread < numThreads; ++iThread)
+      threads[iThread].join();
+  } // else
+  const double sWall = seconds(clock::now() - t0).count();
+
+  std::string error;
+  size_t numNoData = 0;
+  memset(&_result.cache, 0, sizeof(_result.cache));
+  memset(&_result.cacheExt, 0, sizeof(_result.cacheExt));
+  for (int iThread=0; iThread < numThreads; ++iThread) {
+    WorkStruct& w = work[iThread];
+    storage::CacheStatsStruct stats;
+    w.pQuery->cacheStats(&stats);
+    _addCacheStats(&_result.cache, stats);
+    w.pQuery->cacheStatsExt(&stats);
+    _addCacheStats(&_result.cacheExt, stats);
+    w.pQuery->close();
+    delete w.pQuery; w.pQuery = 0;
+    numNoData += w.numNoData;
+    if (error.empty())
+      error = w.error;
+  } // for
+  if (!error.empty())
+    throw std::runtime_error(error);
+
+  _result.numQueries = numQueries;
+  _result.numNoData = numNoData;
+  _result.numThreads = numThreads;
+  _result.sWall = sWall;
+  _result.sTrace = 1.0e-9 * (_queries[numQueries-1].time - _queries[0].time);
+  _statistics(&samples);
+
+  if (!_quiet)
+    _writeSummary();
+  _writeJSON();
+} // run
+
+// ----------------------------------------------------------------------
+// Load queries and their states from the trace.
+void
+cencalvm::query::QueryReplayer::_load(void)
+{ // _load
+  _queries.clear();
+  _states.clear();
+  _stateIndex.clear();
+
+  QueryTrace trace;
+  trace.open(_filenameTrace.c_str());
+
+  QueryTraceQueryStruct query;
+  QueryTraceStateStruct state;
+  bool hasState = false;
+  while (trace.read(&query, &state)) {
+    if (!hasState || state.vals != _states.back().vals ||
+	state.queryType != _states.back().queryType ||
+	state.squash != _states.back().squash ||
+	state.queryRes != _states.back().queryRes ||
+	state.squashLimit != _states.back().squashLimit) {
+      _states.push_back(state);
+      hasState = true;
+    } // if
+    _queries.push_back(query);
+    _stateIndex.push_back(_states.size()-1);
+  } // while
+  trace.close();
+} // _load
+
+// ----------------------------------------------------------------------
+// Create query and open databases.
+cencalvm::query::VMQuery*
+cencalvm::query::QueryReplayer::_createQuery(void) const
+{ // _createQuery
+  VMQuery* pQuery = new VMQuery;
+  storage::ErrorHandler* pErrHandler = pQuery->errorHandler();
+  assert(0 != pErrHandler);
+
+  pQuery->filename(_filename.c_str());
+  pQuery->cacheSize(_cacheSize);
+  pQuery->filenameExt(_filenameExt.c_str());
+  pQuery->cacheSizeExt(_cacheSizeExt);
+  pQuery->filenamePyramid(_filenamePyramid.c_str());
+  pQuery->filenamePyramidExt(_filenamePyramidExt.c_str());
+  pQuery->open();
+  if (storage::ErrorHandler::OK != pErrHandler->status()) {
+    const std::string msg = pErrHandler->message();
+    delete pQuery; pQuery = 0;
+    throw std::runtime_error(msg);
+  } // if
+
+  return pQuery;
+} // _createQuery
+
+// ----------------------------------------------------------------------
+// Replay thread.
+void
+cencalvm::query::QueryReplayer::_work(WorkStruct* pWork)
+{ // _work
+  assert(0 != pWork);
+  assert(0 != pWork->pReplayer);
+  assert(0 != pWork->pQuery);
+  assert(0 != pWork->pSamples);
+
+  typedef std::chrono::steady_clock clock;
+  typedef std::chrono::duration<double, std::nano> nanoseconds;
+
+  const QueryReplayer& replayer = *pWork->pReplayer;
+  VMQuery* pQuery = pWork->pQuery;
+  storage::ErrorHandler* pErrHandler = pQuery->errorHandler();
+
+  const int maxVals = 9;
+  double* pVals = new double[maxVals];
+  int numVals = 0;
+  size_t stateIndex = replayer._states.size();
+  for (size_t i=pWork->begin; i < pWork->end; ++i) {
+    if (replayer._stateIndex[i] != stateIndex) {
+      stateIndex = replayer._stateIndex[i];
+      const QueryTraceStateStruct& state = replayer._states[stateIndex];
+      _setState(pQuery, state);
+      if (storage::ErrorHandler::OK != pErrHandler->status()) {
+	pWork->error = pErrHandler->message();
+	break;
+      } // if
+      numVals = (state.vals.size() > 0) ? state.vals.size() : maxVals;
+      if (numVals > maxVals) {
+	delete[] pVals; pVals = new double[numVals];
+      } // if
+    } // if
+
+    const QueryTraceQueryStruct& query = replayer._queries[i];
+    const clock::time_point t0 = clock::now();
+    pQuery->query(&pVals, numVals, query.lon, query.lat, query.elev);
+    pWork->pSamples[i] = nanoseconds(clock::now() - t0).count();
+
+    if (storage::ErrorHandler::OK != pErrHandler->status()) {
+      if (storage::ErrorHandler::ERROR == pErrHandler->status()) {
+	pWork->error = pErrHandler->message();
+	break;
+      } // if
+      ++pWork->numNoData;
+      pErrHandler->resetStatus();
+    } // if
+  } // for
+  delete[] pVals; pVals = 0;
+} // _work
+
+// ----------------------------------------------------------------------
+// Set query type, resolution, squashing, and values of queries.
+void
+cencalvm::query::QueryReplayer::_setState(VMQuery* pQuery,
+					  const QueryTraceStateStruct& state)
+{ // _setState
+  assert(0 != pQuery);
+  storage::ErrorHandler* pErrHandler = pQuery->errorHandler();
+
+  const int numVals = state.vals.size();
+  if (numVals > 0) {
+    std::vector<const char*> names(numVals);
+    for (int iVal=0; iVal < numVals; ++iVal) {
+      names[iVal] = QueryTrace::valName(state.vals[iVal]);
+      if (0 == names[iVal]) {
+	std::ostringstream msg;
+	msg << "Unknown value " << state.vals[iVal] << " in query trace.";
+	pErrHandler->error(msg.str().c_str());
+	return;
+      } // if
+    } // for
+    pQuery->queryVals(&names[0], numVals);
+  } // if
+  pQuery->squash(1 == state.squash, state.squashLimit);
+  pQuery->queryRes(state.queryRes);
+  pQuery->queryType(VMQuery::QueryEnum(state.queryType));
+} // _setState
+
+// ----------------------------------------------------------------------
+// Compute statistics of times.
+void
+cencalvm::query::QueryReplayer::_statistics(std::vector<double>* pSamples)
+{ // _statistics
+  assert(0 != pSamples);
+  assert(pSamples->size() > 0);
+
+  std::vector<double>& samples = *pSamples;
+  const size_t numSamples = samples.size();
+  std::sort(samples.begin(), samples.end());
+
+  double sum = 0.0;
+  for (size_t i=0; i < numSamples; ++i)
+    sum += samples[i];
+
+  _result.nsMean = sum / numSamples;
+  _result.nsMin = samples[0];
+  _result.nsP50 = samples[size_t(0.5 * (numSamples-1) + 0.5)];
+  _result.nsP90 = samples[size_t(0.9 * (numSamples-1) + 0.5)];
+  _result.nsP99 = samples[size_t(0.99 * (numSamples-1) + 0.5)];
+  _result.nsP999 = samples[size_t(0.999 * (numSamples-1) + 0.5)];
+  _result.nsMax = samples[numSamples-1];
+} // _statistics
+
+// ----------------------------------------------------------------------
+// Add statistics of cache of a thread to total.
+void
+cencalvm::query::QueryReplayer::_addCacheStats(
+				     storage::CacheStatsStruct* pTotal,
+				     const storage::CacheStatsStruct& stats)
+{ // _addCacheStats
+  assert(0 != pTotal);
+
+  pTotal->numSearches += stats.numSearches;
+  pTotal->numHits += stats.numHits;
+  pTotal->numMisses += stats.numMisses;
+  pTotal->numReads += stats.numReads;
+  pTotal->numEvictions += stats.numEvictions;
+  pTotal->numResident += stats.numResident;
+  pTotal->capacity += stats.capacity;
+  pTotal->bytesRead += stats.bytesRead;
+  pTotal->cacheSize += stats.cacheSize;
+  pTotal->numResizes += stats.numResizes;
+  pTotal->isEstimate = pTotal->isEstimate || stats.isEstimate;
+} // _addCacheStats
+
+// ----------------------------------------------------------------------
+// Write summary of cache to stdout.
+void
+cencalvm::query::QueryReplayer::_writeCacheSummary(
+				     const char* name,
+				     const storage::CacheStatsStruct& stats)
+{ // _writeCacheSummary
+  if (0 == stats.numSearches)
+    return;
+
+  const double hitRate = 100.0 * stats.numHits / stats.numSearches;
+  std::cout
+    << std::fixed << std::setprecision(1)
+    << "  Cache of " << name << ": " << stats.cacheSize << " MB, "
+    << stats.numResizes << " resize(s), hits " << hitRate << "%, "
+    << stats.numMisses << " misses, " << stats.numReads << " reads, "
+    << stats.numEvictions << " evictions"
+    << ((stats.isEstimate) ? " (estimated)" : "") << "\n";
+} // _writeCacheSummary
+
+// ----------------------------------------------------------------------
+// Write statistics of cache as JSON members.
+void
+cencalvm::query::QueryReplayer::_writeCacheJSON(
+				     std::ostream& fout,
+				     const char* suffix,
+				     const storage::CacheStatsStruct& stats)
+{ // _writeCacheJSON
+  fout
+    << "  \"cacheSizeUsed" << suffix << "\": " << stats.cacheSize << ",\n"
+    << "  \"cacheResizes" << suffix << "\": " << stats.numResizes << ",\n"
+    << "  \"cacheSearches" << suffix << "\": " << stats.numSearches << ",\n"
+    << "  \"cacheHits" << suffix << "\": " << stats.numHits << ",\n"
+    << "  \"cacheMisses" << suffix << "\": " << stats.numMisses << ",\n"
+    << "  \"cacheReads" << suffix << "\": " << stats.numReads << ",\n"
+    << "  \"cacheEvictions" << suffix << "\": " << stats.numEvictions << ",\n"
+    << "  \"cacheEstimated" << suffix << "\": "
+    << ((stats.isEstimate) ? "true" : "false") << ",\n";
+} // _writeCacheJSON
+
+// ----------------------------------------------------------------------
+// Write summary of results to stdout.
+void
+cencalvm::query::QueryReplayer::_writeSummary(void) const
+{ // _writeSummary
+  const double rate = (_result.sWall > 0.0) ?
+    _result.numQueries / _result.sWall : 0.0;
+  const double rateTrace = (_result.sTrace > 0.0) ?
+    _result.numQueries / _result.sTrace : 0.0;
+
+  std::cout
+    << std::fixed << std::setprecision(1)
+    << "Replayed " << _result.numQueries << " queries from '"
+    << _filenameTrace << "' with " << _result.numThreads << " thread(s).\n"
+    << "  Throughput: " << rate << " queries/s ("
+    << std::setprecision(3) << _result.sWall << " s)\n"
+    << std::setprecision(1)
+    << "  Original:   " << rateTrace << " queries/s ("
+    << std::setprecision(3) << _result.sTrace << " s)\n"
+    << std::setprecision(1)
+    << "  Time per query (ns): mean " << _result.nsMean
+    << ", min " << _result.nsMin
+    << ", p50 " << _result.nsP50
+    << ", p90 " << _result.nsP90
+    << ", p99 " << _result.nsP99
+    << ", p99.9 " << _result.nsP999
+    << ", max " << _result.nsMax << "\n"
+    << "  Queries without data: " << _result.numNoData << "\n";
+  _writeCacheSummary("detailed model", _result.cache);
+  _writeCacheSummary("extended model", _result.cacheExt);
+  std::cout << std::flush;
+} // _writeSummary
+
+// ----------------------------------------------------------------------
+// Write results as JSON.
+void
+cencalvm::query::QueryReplayer::_writeJSON(void) const
+{ // _writeJSON
+  if (_filenameJSON.empty())
+    return;
+
+  std::ofstream fout(_filenameJSON.c_str());
+  if (!fout.is_open()) {
+    std::ostringstream msg;
+    msg << "Could not open replay results file '" << _filenameJSON
+	<< "' for writing.";
+    throw std::runtime_error(msg.str());
+  } // if
+
+  const double rate = (_result.sWall > 0.0) ?
+    _result.numQueries / _result.sWall : 0.0;
+  const double rateTrace = (_result.sTrace > 0.0) ?
+    _result.numQueries / _result.sTrace : 0.0;
+  fout
+    << "{\n"
+    << "  \"benchmark\": \"replay\",\n"
+    << "  \"time\": " << time(0) << ",\n"
+    << "  \"trace\": \"" << _filenameTrace << "\",\n"
+    << "  \"filename\": \"" << _filename << "\",\n"
+    << "  \"filenameExt\": \"" << _filenameExt << "\",\n"
+    << "  \"cacheSize\": " << _cacheSize << ",\n"
+    << "  \"cacheSizeExt\": " << _cacheSizeExt << ",\n"
+    << "  \"numThreads\": " << _result.numThreads << ",\n"
+    << "  \"numQueries\": " << _result.numQueries << ",\n"
+    << "  \"numNoData\": " << _result.numNoData << ",\n";
+  _writeCacheJSON(fout, "", _result.cache);
+  _writeCacheJSON(fout, "Ext", _result.cacheExt);
+  fout
+    << "  \"wallTime\": " << _result.sWall << ",\n"
+    << "  \"queriesPerSecond\": " << rate << ",\n"
+    << "  \"traceTime\": " << _result.sTrace << ",\n"
+    << "  \"traceQueriesPerSecond\": " << rateTrace << ",\n"
+    << "  \"nsPerQuery\": " << _result.nsMean << ",\n"
+    << "  \"nsMin\": " << _result.nsMin << ",\n"
+    << "  \"nsP50\": " << _result.nsP50 << ",\n"
+    << "  \"nsP90\": " << _result.nsP90 << ",\n"
+    << "  \"nsP99\": " << _result.nsP99 << ",\n"
+    << "  \"nsP999\": " << _result.nsP999 << ",\n"
+    << "  \"nsMax\": " << _result.nsMax << "\n"
+    << "}\n";
+  if (!fout.good()) {
+    std::ostringstream msg;
+    msg << "Error while writing replay results file '" << _filenameJSON
+	<< "'.";
+    throw std::runtime_error(msg.str());
+  } // if
+} // _writeJSON
+
+// End of file
@@ -0,0 +1,244 @@
+// -*- C++ -*-
+//
+// ======================================================================
+//
+//                           Brad T. Aagaard
+//                        U.S. Geological Survey
+//
+// {LicenseText}
+//
+// ======================================================================
+//
+
+/** @file libsrc/query/QueryReplayer.h
+ *
+ * @brief C++ replay of a trace of queries against a database.
+ *
+ * The trace (see QueryTrace) is loaded into memory and the queries
+ * are replayed as fast as possible with VMQuery, with the query type,
+ * resolution, squashing, and values of each query restored from the
+ * trace. With more than one thread, each thread has its own VMQuery
+ * and replays a contiguous portion of the trace, so the access
+ * pattern within each portion is the same as in the trace. Databases
+ * are opened before timing starts.
+ *
+ * Each query is timed individually. The results give the throughput
+ * (queries per second of wall clock time over all threads), the mean
+ * and percentiles of the time per query, and the number of queries
+ * without data, along with the duration and throughput of the
+ * original run. The statistics of the caches of the databases (see
+ * VMQuery::cacheStats()) are summed over the threads.
+ */
+
+#if !defined(cencalvm_query_queryreplayer_h)
+#define cencalvm_query_queryreplayer_h
+
+#include <string> // HASA std::string
+#include <vector> // HASA std::vector
+
+#include "QueryTrace.h" // HASA QueryTraceQueryStruct, QueryTraceStateStruct
+#include "cencalvm/storage/CacheMonitor.h" // HASA CacheStatsStruct
+
+#include <iosfwd> // USES std::ostream
+
+namespace cencalvm {
+  namespace query {
+    class QueryReplayer;
+    class VMQuery; // USES VMQuery
+  } // namespace query
+} // namespace cencalvm
+
+/// C++ replay of a trace of queries against a database.
+class cencalvm::query::QueryReplayer
+{ // QueryReplayer
+
+public :
+  // PUBLIC METHODS /////////////////////////////////////////////////////
+
+  /// Constructor
+  QueryReplayer(void);
+
+  /// Destructor
+  ~QueryReplayer(void);
+
+  /** Set filename of trace of queries.
+   *
+   * @param filename Name of trace file
+   */
+  void filenameTrace(const char* filename);
+
+  /** Set filename of database for detailed model.
+   *
+   * @param filename Name of database file
+   */
+  void filename(const char* filename);
+
+  /** Set filename of database for extended model.
+   *
+   * @param filename Name of database file ("" for none)
+   */
+  void filenameExt(const char* filename);
+
+  /** Set filename of pyramid for detailed model.
+   *
+   * @param filename Name of pyramid file ("" for none)
+   */
+  void filenamePyramid(const char* filename);
+
+  /** Set filename of pyramid for extended model.
+   *
+   * @param filename Name of pyramid file ("" for none)
+   */
+  void filenamePyramidExt(const char* filename);
+
+  /** Set size of etree cache of detailed model in each thread.
+   *
+   * @param size Size of cache in MB or storage::CacheMonitor::AUTOSIZE
+   */
+  void cacheSize(const int size);
+
+  /** Set size of etree cache of extended model in each thread.
+   *
+   * @param size Size of cache in MB or storage::CacheMonitor::AUTOSIZE
+   */
+  void cacheSizeExt(const int size);
+
+  /** Set number of threads replaying queries.
+   *
+   * @param num Number of threads (0 for number of hardware threads)
+   */
+  void numThreads(const int num);
+
+  /** Set name of file for JSON results.
+   *
+   * @param filename Name of file ("" for none)
+   */
+  void filenameJSON(const char* filename);
+
+  /** Set flag indicating replay should be quiet (no summary).
+   *
+   * @param flag True for quiet operation, false to write summary
+   */
+  void quiet(const bool flag);
+
+  /// Load the trace, replay the queries, and write results.
+  void run(void);
+
+private :
+  // PRIVATE STRUCTS ////////////////////////////////////////////////////
+
+  struct WorkStruct; ///< Portion of trace replayed by a thread
+
+  /// Result of replay.
+  struct ResultStruct {
+    size_t numQueries; ///< Number of queries
+    size_t numNoData; ///< Number of queries without data
+    int numThreads; ///< Number of threads
+    double sWall; ///< Wall clock time of replay in s
+    double sTrace; ///< Duration of original run in s
+    double nsMean; ///< Mean time per query in ns
+    double nsMin; ///< Minimum time per query in ns
+    double nsP50; ///< Median time per query in ns
+    double nsP90; ///< 90th percentile of time per query in ns
+    double nsP99; ///< 99th percentile of time per query in ns
+    double nsP999; ///< 99.9th percentile of time per query in ns
+    double nsMax; ///< Maximum time per query in ns
+    storage::CacheStatsStruct cache; ///< Cache of detailed model
+    storage::CacheStatsStruct cacheExt; ///< Cache of extended model
+  }; // ResultStruct
+
+private :
+  // PRIVATE METHODS ////////////////////////////////////////////////////
+
+  /// Load queries and their states from the trace.
+  void _load(void);
+
+  /** Create query and open databases.
+   *
+   * @returns Query manager
+   */
+  VMQuery* _createQuery(void) const;
+
+  /** Replay thread.
+   *
+   * @param pWork Pointer to portion of trace replayed by thread
+   */
+  static void _work(WorkStruct* pWork);
+
+  /** Set query type, resolution, squashing, and values of queries.
+   *
+   * @param pQuery Pointer to query manager
+   * @param state State of queries
+   */
+  static void _setState(VMQuery* pQuery,
+			const QueryTraceStateStruct& state);
+
+  /** Compute statistics of times.
+   *
+   * @param pSamples Pointer to times of queries in ns (sorted)
+   */
+  void _statistics(std::vector<double>* pSamples);
+
+  /** Add statistics of cache of a thread to total.
+   *
+   * @param pTotal Pointer to statistics over threads
+   * @param stats Statistics of cache of thread
+   */
+  static void _addCacheStats(storage::CacheStatsStruct* pTotal,
+			     const storage::CacheStatsStruct& stats);
+
+  /** Write summary of cache to stdout.
+   *
+   * @param name Name of database
+   * @param stats Statistics of cache
+   */
+  static void _writeCacheSummary(const char* name,
+				 const storage::CacheStatsStruct& stats);
+
+  /** Write statistics of cache as JSON members.
+   *
+   * @param fout Output stream
+   * @param suffix Suffix of names of members
+   * @param stats Statistics of cache
+   */
+  static void _writeCacheJSON(std::ostream& fout,
+			      const char* suffix,
+			      const storage::CacheStatsStruct& stats);
+
+  /// Write summary of results to stdout.
+  void _writeSummary(void) const;
+
+  /// Write results as JSON.
+  void _writeJSON(void) const;
+
+  QueryReplayer(const QueryReplayer& r); ///< Not implemented
+  const QueryReplayer& operator=(const QueryReplayer& r); ///< Not implemented
+
+private :
+  // PRIVATE MEMBERS ////////////////////////////////////////////////////
+
+  std::string _filenameTrace; ///< Name of trace file
+  std::string _filename; ///< Name of database for detailed model
+  std::string _filenameExt; ///< Name of database for extended model
+  std::string _filenamePyramid; ///< Name of pyramid for detailed model
+  std::string _filenamePyramidExt; ///< Name of pyramid for extended model
+  std::string _filenameJSON; ///< Name of file for JSON results
+
+  std::vector<QueryTraceQueryStruct> _queries; ///< Queries in trace
+  std::vector<QueryTraceStateStruct> _states; ///< States in trace
+  std::vector<size_t> _stateIndex; ///< Index of state of each query
+
+  ResultStruct _result; ///< Result of replay
+
+  int _cacheSize; ///< Size of cache for detailed model in MB
+  int _cacheSizeExt; ///< Size of cache for extended model in MB
+  int _numThreads; ///< Number of threads (0 for hardware threads)
+  bool _quiet; ///< True if not writing summary
+
+}; // QueryReplayer
+
+#include "QueryReplayer.icc" // inline methods
+
+#endif // cencalvm_query_queryreplayer_h
+
+// End of file
@@ -0,0 +1,283 @@
+// -*- C++ -*-
+//
+// ======================================================================
+//
+//                           Brad T. Aagaard
+//                        U.S. Geological Survey
+//
+// {LicenseText}
+//
+// ======================================================================
+//
+
+#include "QueryTrace.h" // implementation of class methods
+
+#include <time.h> // USES time()
+#include <string.h> // USES memcpy(), memcmp(), memset()
+
+#include <stdexcept> // USES std::runtime_error
+#include <sstream> // USES std::ostringstream
+#include <assert.h> // USES assert()
+
+// ----------------------------------------------------------------------
+const char* cencalvm::query::QueryTrace::MAGIC = "CVMTRCE";
+const int32_t cencalvm::query::QueryTrace::VERSION = 1;
+const int32_t cencalvm::query::QueryTrace::BYTEORDER = 0x01020304;
+
+// ----------------------------------------------------------------------
+// Constructor
+cencalvm::query::QueryTrace::QueryTrace(void) :
+  _filename(""),
+  _fp(0),
+  _isWriting(false),
+  _hasState(false)
+{ // constructor
+  memset(&_header, 0, sizeof(_header));
+  _state.queryType = 0;
+  _state.squash = 0;
+  _state.queryRes = 0.0;
+  _state.squashLimit = 0.0;
+} // constructor
+
+// ----------------------------------------------------------------------
+// Destructor
+cencalvm::query::QueryTrace::~QueryTrace(void)
+{ // destructor
+  try {
+    close();
+  } catch (...) {
+  } // try/catch
+} // destructor
+
+// ----------------------------------------------------------------------
+// Create trace for writing.
+void
+cencalvm::query::QueryTrace::create(const char* filename)
+{ // create
+  assert(0 != filename);
+
+  close();
+
+  _filename = filename;
+  _fp = fopen(filename, "wb");
+  if (0 == _fp) {
+    std::ostringstream msg;
+    msg << "Could not open query trace file '" << filename
+	<< "' for writing.";
+    throw std::runtime_error(msg.str());
+  } // if
+  _isWriting = true;
+  _hasState = false;
+
+  memset(&_header, 0, sizeof(_header));
+  memcpy(_header.magic, MAGIC, sizeof(_header.magic));
+  _header.version = VERSION;
+  _header.byteOrder = BYTEORDER;
+  _header.startTime = time(0);
+  _timeStart = std::chrono::steady_clock::now();
+  if (1 != fwrite(&_header, sizeof(_header), 1, _fp))
+    _writeError();
+} // create
+
+// ----------------------------------------------------------------------
+// Open trace for reading.
+void
+cencalvm::query::QueryTrace::open(const char* filename)
+{ // open
+  assert(0 != filename);
+
+  close();
+
+  _filename = filename;
+  _fp = fopen(filename, "rb");
+  if (0 == _fp) {
+    std::ostringstream msg;
+    msg << "Could not open query trace file '" << filename
+	<< "' for reading.";
+    throw std::runtime_error(msg.str());
+  } // if
+  _isWriting = false;
+
+  if (!_read(&_header, sizeof(_header)) ||
+      0 != memcmp(_header.magic, MAGIC, sizeof(_header.magic))) {
+    close();
+    std::ostringstream msg;
+    msg << "File '" << filename << "' is not a query trace.";
+    throw std::runtime_error(msg.str());
+  } // if
+  if (BYTEORDER != _header.byteOrder) {
+    close();
+    throw std::runtime_error("Query trace was written on a machine with "
+			     "a different byte order.");
+  } // if
+  if (VERSION != _header.version) {
+    close();
+    std::ostringstream msg;
+    msg << "Unknown version " << _header.version
+	<< " of query trace format. Expected version " << VERSION << ".";
+    throw std::runtime_error(msg.str());
+  } // if
+} // open
+
+// ----------------------------------------------------------------------
+// Close trace.
+void
+cencalvm::query::QueryTrace::close(void)
+{ // close
+  if (0 == _fp)
+    return;
+
+  const bool writeError = (0 != fclose(_fp)) && _isWriting;
+  _fp = 0;
+  _isWriting = false;
+  if (writeError)
+    _writeError();
+} // close
+
+// ----------------------------------------------------------------------
+// Write query, preceded by its state if it has changed.
+void
+cencalvm::query::QueryTrace::write(const QueryTraceStateStruct& state,
+				   const double lon,
+				   const double lat,
+				   const double elev)
+{ // write
+  assert(0 != _fp);
+  assert(_isWriting);
+
+  const uint64_t time = std::chrono::duration_cast<std::chrono::nanoseconds>(
+    std::chrono::steady_clock::now() - _timeStart).count();
+
+  if (!_hasState || !_sameState(state, _state)) {
+    _state = state;
+    _hasState = true;
+    const char tag = 'S';
+    const int32_t numVals = state.vals.size();
+    bool writeError =
+      1 != fwrite(&tag, sizeof(tag), 1, _fp) ||
+      1 != fwrite(&state.queryType, sizeof(state.queryType), 1, _fp) ||
+      1 != fwrite(&state.squash, sizeof(state.squash), 1, _fp) ||
+      1 != fwrite(&state.queryRes, sizeof(state.queryRes), 1, _fp) ||
+      1 != fwrite(&state.squashLimit, sizeof(state.squashLimit), 1, _fp) ||
+      1 != fwrite(&numVals, sizeof(numVals), 1, _fp);
+    if (!writeError && numVals > 0)
+      writeError = size_t(numVals) !=
+	fwrite(&state.vals[0], sizeof(int32_t), numVals, _fp);
+    if (writeError)
+      _writeError();
+  } // if
+
+  const char tag = 'Q';
+  QueryTraceQueryStruct query;
+  query.time = time;
+  query.lon = lon;
+  query.lat = lat;
+  query.elev = elev;
+  if (1 != fwrite(&tag, sizeof(tag), 1, _fp) ||
+      1 != fwrite(&query, sizeof(query), 1, _fp))
+    _writeError();
+} // write
+
+// ----------------------------------------------------------------------
+// Read next query.
+bool
+cencalvm::query::QueryTrace::read(QueryTraceQueryStruct* pQuery,
+				  QueryTraceStateStruct* pState)
+{ // read
+  assert(0 != pQuery);
+  assert(0 != pState);
+  assert(0 != _fp);
+  assert(!_isWriting);
+
+  char tag = 0;
+  while (_read(&tag, sizeof(tag))) {
+    switch (tag)
+      { // switch
+      case 'S' : {
+	QueryTraceStateStruct state;
+	int32_t numVals = 0;
+	if (!_read(&state.queryType, sizeof(state.queryType)) ||
+	    !_read(&state.squash, sizeof(state.squash)) ||
+	    !_read(&state.queryRes, sizeof(state.queryRes)) ||
+	    !_read(&state.squashLimit, sizeof(state.squashLimit)) ||
+	    !_read(&numVals, sizeof(numVals)))
+	  return false;
+	if (numVals < 0) {
+	  std::ostringstream msg;
+	  msg << "Corrupt state record in query trace '" << _filename << "'.";
+	  throw std::runtime_error(msg.str());
+	} // if
+	state.vals.resize(numVals);
+	if (numVals > 0 && !_read(&state.vals[0], numVals*sizeof(int32_t)))
+	  return false;
+	*pState = state;
+	break;
+      } // 'S'
+      case 'Q' :
+	return _read(pQuery, sizeof(QueryTraceQueryStruct));
+      default : {
+	std::ostringstream msg;
+	msg << "Unknown record '" << tag << "' in query trace '"
+	    << _filename << "'.";
+	throw std::runtime_error(msg.str());
+      } // default
+      } // switch
+  } // while
+  return false;
+} // read
+
+// ----------------------------------------------------------------------
+// Get name of value in queries.
+const char*
+cencalvm::query::QueryTrace::valName(const int index)
+{ // valName
+  const char* names[] = {
+    "Vp", "Vs", "Density", "Qp", "Qs", "DepthFreeSurf", "FaultBlock", "Zone",
+    "elevation"
+  };
+  const int numNames = sizeof(names) / sizeof(const char*);
+  return (index >= 0 && index < numNames) ? names[index] : 0;
+} // valName
+
+// ----------------------------------------------------------------------
+// Check whether states are the same.
+bool
+cencalvm::query::QueryTrace::_sameState(const QueryTraceStateStruct& a,
+					const QueryTraceStateStruct& b)
+{ // _sameState
+  return a.queryType == b.queryType &&
+    a.squash == b.squash &&
+    a.queryRes == b.queryRes &&
+    a.squashLimit == b.squashLimit &&
+    a.vals == b.vals;
+} // _sameState
+
+// ----------------------------------------------------------------------
+// Read bytes from trace.
+bool
+cencalvm::query::QueryTrace::_read(void* pData,
+				   const size_t size)
+{ // _read
+  assert(0 != _fp);
+
+  if (1 == fread(pData, size, 1, _fp))
+    return true;
+  if (ferror(_fp)) {
+    std::ostringstream msg;
+    msg << "Error while reading query trace '" << _filename << "'.";
+    throw std::runtime_error(msg.str());
+  } // if
+  return false;
+} // _read
+
+// ----------------------------------------------------------------------
+// Throw exception for error while writing trace.
+void
+cencalvm::query::QueryTrace::_writeError(void) const
+{ // _writeError
+  std::ostringstream msg;
+  msg << "Error while writing query trace '" << _filename << "'.";
+  throw std::runtime_error(msg.str());
+} // _writeError
+
+// End of file
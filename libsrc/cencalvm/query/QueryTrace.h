@@ -0,0 +1,202 @@
+// -*- C++ -*-
+//
+// ======================================================================
+//
+//                           Brad T. Aagaard
+//                        U.S. Geological Survey
+//
+// {LicenseText}
+//
+// ======================================================================
+//
+
+/** @file libsrc/query/QueryTrace.h
+ *
+ * @brief C++ reader and writer of binary traces of queries.
+ *
+ * A trace records the stream of queries made with a VMQuery object,
+ * so that it can be replayed against any database (see
+ * QueryReplayer). The file starts with a QueryTraceHeaderStruct
+ * followed by records, each starting with a one byte tag:
+ *
+ *   @li 'S' State of the queries that follow: query type (int32),
+ *     squashing flag (int32), resolution (double), minimum elevation
+ *     of squashing (double), number of values (int32), and the
+ *     indices of the values returned (int32 each, see valName()). A
+ *     state record is written before the first query and whenever the
+ *     state changes.
+ *   @li 'Q' Query: QueryTraceQueryStruct with the time of the query
+ *     since the start of the trace and its location.
+ *
+ * Values are stored in the byte order of the machine that wrote the
+ * file; the header contains a byte order mark so that files written
+ * on a machine with a different byte order are rejected. A record cut
+ * off at the end of the file (e.g., by a run that was killed) is
+ * treated as the end of the trace.
+ */
+
+#if !defined(cencalvm_query_querytrace_h)
+#define cencalvm_query_querytrace_h
+
+#include <inttypes.h> // USES int32_t, int64_t, uint64_t
+#include <stdio.h> // HASA FILE
+#include <string> // HASA std::string
+#include <vector> // HASA std::vector
+#include <chrono> // HASA std::chrono::steady_clock
+
+namespace cencalvm {
+  namespace query {
+    struct QueryTraceHeaderStruct;
+    struct QueryTraceStateStruct;
+    struct QueryTraceQueryStruct;
+    class QueryTrace;
+    class TestQueryTrace; // friend
+  } // namespace query
+} // namespace cencalvm
+
+/// Header of query trace file.
+struct cencalvm::query::QueryTraceHeaderStruct {
+  char magic[8]; ///< File identifier (QueryTrace::MAGIC)
+  int32_t version; ///< Version of file format
+  int32_t byteOrder; ///< Byte order mark (QueryTrace::BYTEORDER)
+  int64_t startTime; ///< Wall clock time at start of trace (s since epoch)
+}; // QueryTraceHeaderStruct
+
+/// State of queries in trace.
+struct cencalvm::query::QueryTraceStateStruct {
+  int32_t queryType; ///< Type of query (VMQuery::QueryEnum)
+  int32_t squash; ///< 1 if squashing topography, 0 otherwise
+  double queryRes; ///< Resolution of query
+  double squashLimit; ///< Minimum elevation of squashing
+  std::vector<int32_t> vals; ///< Indices of values returned
+}; // QueryTraceStateStruct
+
+/// Query in trace.
+struct cencalvm::query::QueryTraceQueryStruct {
+  uint64_t time; ///< Time of query since start of trace in ns
+  double lon; ///< Longitude in degrees
+  double lat; ///< Latitude in degrees
+  double elev; ///< Elevation wrt MSL in m
+}; // QueryTraceQueryStruct
+
+/// C++ reader and writer of binary traces of queries.
+class cencalvm::query::QueryTrace
+{ // QueryTrace
+  friend class TestQueryTrace; // unit testing
+
+public :
+  // PUBLIC METHODS /////////////////////////////////////////////////////
+
+  /// Constructor
+  QueryTrace(void);
+
+  /// Destructor
+  ~QueryTrace(void);
+
+  /** Create trace for writing.
+   *
+   * @param filename Name of trace file
+   */
+  void create(const char* filename);
+
+  /** Open trace for reading.
+   *
+   * @param filename Name of trace file
+   */
+  void open(const char* filename);
+
+  /// Close trace.
+  void close(void);
+
+  /** Write query, preceded by its state if the state differs from the
+   * state of the previous query.
+   *
+   * @param state State of query
+   * @param lon Longitude of query in degrees
+   * @param lat Latitude of query in degrees
+   * @param elev Elevation of query wrt MSL in m
+   */
+  void write(const QueryTraceStateStruct& state,
+	     const double lon,
+	     const double lat,
+	     const double elev);
+
+  /** Read next query.
+   *
+   * @param pQuery Pointer to query
+   * @param pState Pointer to state of queries (updated if the state
+   *   changes before the query)
+   *
+   * @returns True if a query was read, false at end of trace
+   */
+  bool read(QueryTraceQueryStruct* pQuery,
+	    QueryTraceStateStruct* pState);
+
+  /** Get header of trace open for reading.
+   *
+   * @returns Header
+   */
+  const QueryTraceHeaderStruct& header(void) const;
+
+  /** Get name of value in queries (see VMQuery::queryVals()).
+   *
+   * @param index Index of value
+   *
+   * @returns Name of value (0 if index is not valid)
+   */
+  static const char* valName(const int index);
+
+public :
+  // PUBLIC MEMBERS /////////////////////////////////////////////////////
+
+  static const char* MAGIC; ///< File identifier
+  static const int32_t VERSION; ///< Current version of file format
+  static const int32_t BYTEORDER; ///< Byte order mark
+
+private :
+  // PRIVATE METHODS ////////////////////////////////////////////////////
+
+  /** Check whether states are the same.
+   *
+   * @param a First state
+   * @param b Second state
+   *
+   * @returns True if states are the same, false otherwise
+   */
+  static bool _sameState(const QueryTraceStateStruct& a,
+			 const QueryTraceStateStruct& b);
+
+  /** Read bytes from trace.
+   *
+   * @param pData Pointer to data
+   * @param size Number of bytes
+   *
+   * @returns True if all bytes were read, false at end of file
+   */
+  bool _read(void* pData,
+	     const size_t size);
+
+  /// Throw exception for error while writing trace.
+  void _writeError(void) const;
+
+  QueryTrace(const QueryTrace& t); ///< Not implemented
+  const QueryTrace& operator=(const QueryTrace& t); ///< Not implemented
+
+private :
+  // PRIVATE MEMBERS ////////////////////////////////////////////////////
+
+  std::string _filename; ///< Name of trace file
+  FILE* _fp; ///< Trace file
+  QueryTraceHeaderStruct _header; ///< Header of trace
+  QueryTraceStateStruct _state; ///< State of previous query written
+  std::chrono::steady_clock::time_point _timeStart; ///< Start of trace
+  bool _isWriting; ///< True if trace is open for writing
+  bool _hasState; ///< True if a state has been written
+
+}; // QueryTrace
+
+#include "QueryTrace.icc" // inline methods
+
+#endif // cencalvm_query_querytrace_h
+
+// End of file
@@ -0,0 +1,468 @@
+// -*- C++ -*-
+//
+// ======================================================================
+//
+//                           Brad T. Aagaard
+//                        U.S. Geological Survey
+//
+// {LicenseText}
+//
+// ======================================================================
+//
+
+#include "VMDiff.h" // implementation of class methods
+
+#include "cencalvm/storage/Payload.h" // USES PayloadStruct
+#include "cencalvm/storage/Geometry.h" // USES Geometry
+#include "cencalvm/storage/GeomCenCA.h" // USES GeomCenCA
+
+extern "C" {
+#include "etree.h"
+}
+
+#include <stdexcept> // USES std::runtime_error
+#include <sstream> // USES std::ostringstream
+#include <fstream> // USES std::ofstream
+#include <iostream> // USES std::cout
+#include <iomanip> // USES std::setw()
+#include <math.h> // USES fabs()
+#include <string.h> // USES strcmp(), strcasecmp()
+#include <assert.h> // USES assert()
+
+// ----------------------------------------------------------------------
+const int cencalvm::query::VMDiff::_NUMVALS = 8;
+const char* cencalvm::query::VMDiff::_NAMES[] = {
+  "Vp", "Vs", "Density", "Qp", "Qs", "DepthFreeSurf", "FaultBlock", "Zone"
+};
+
+// ----------------------------------------------------------------------
+// Default constructor
+cencalvm::query::VMDiff::VMDiff(void) :
+  _filenameOld(""),
+  _filenameNew(""),
+  _filenameReport(""),
+  _pTolerance(new double[_NUMVALS]),
+  _pMaxDiff(new double[_NUMVALS]),
+  _pFieldCount(new uint64_t[_NUMVALS+1]),
+  _pLevelCount(new uint64_t[4*(ETREE_MAXLEVEL+1)]),
+  _haveRegion(false),
+  _pGeom(new storage::GeomCenCA),
+  _pReport(0),
+  _cacheSize(64),
+  _regionLevel(4),
+  _quiet(false)
+{ // constructor
+  for (int i=0; i < _NUMVALS; ++i)
+    _pTolerance[i] = 0.0;
+} // constructor
+
+// ----------------------------------------------------------------------
+// Default destructor
+cencalvm::query::VMDiff::~VMDiff(void)
+{ // destructor
+  delete[] _pTolerance; _pTolerance = 0;
+  delete[] _pMaxDiff; _pMaxDiff = 0;
+  delete[] _pFieldCount; _pFieldCount = 0;
+  delete[] _pLevelCount; _pLevelCount = 0;
+  delete _pGeom; _pGeom = 0;
+  delete _pReport; _pReport = 0;
+} // destructor
+
+// ----------------------------------------------------------------------
+// Set tolerance for value.
+void
+cencalvm::query::VMDiff::tolerance(const char* name,
+				   const double tolerance)
+{ // tolerance
+  assert(0 != name);
+
+  for (int i=0; i < _NUMVALS; ++i)
+    if (0 == strcasecmp(_NAMES[i], name)) {
+      _pTolerance[i] = fabs(tolerance);
+      return;
+    } // if
+
+  std::ostringstream msg;
+  msg << "Value name '" << name << "' does not match any "
+      << "of the values in the velocity database.\n"
+      << "Values in database are:\n"
+      << "  Vp, Vs, Density, Qp, Qs, DepthFreeSurf, FaultBlock, Zone.";
+  throw std::runtime_error(msg.str());
+} // tolerance
+
+// ----------------------------------------------------------------------
+// Set geometry of velocity model.
+void
+cencalvm::query::VMDiff::geometry(const storage::Geometry* pGeom)
+{ // geometry
+  delete _pGeom; _pGeom = (0 != pGeom) ? pGeom->clone() : 0;
+} // geometry
+
+// ----------------------------------------------------------------------
+// Find differences between old and new databases.
+void
+cencalvm::query::VMDiff::diff(void)
+{ // diff
+  if (0 == _pGeom)
+    throw std::runtime_error("Geometry of velocity model must be set "
+			     "before finding differences.");
+  if (_regionLevel > ETREE_MAXLEVEL)
+    _regionLevel = ETREE_MAXLEVEL;
+
+  for (int i=0; i < _NUMVALS; ++i)
+    _pMaxDiff[i] = 0.0;
+  for (int i=0; i <= _NUMVALS; ++i)
+    _pFieldCount[i] = 0;
+  for (int i=0; i < 4*(ETREE_MAXLEVEL+1); ++i)
+    _pLevelCount[i] = 0;
+  _regions.clear();
+  _haveRegion = false;
+
+  etree_t* dbOld = _openDB(_filenameOld, "old");
+  etree_t* dbNew = 0;
+  try {
+    dbNew = _openDB(_filenameNew, "new");
+
+    delete _pReport; _pReport = 0;
+    if (_filenameReport.length() > 0) {
+      std::ofstream* pFout = new std::ofstream(_filenameReport.c_str());
+      _pReport = pFout;
+      if (!pFout->is_open()) {
+	std::ostringstream msg;
+	msg << "Could not open report file '" << _filenameReport 
+	    << "' for writing.";
+	throw std::runtime_error(msg.str());
+      } // if
+      *_pReport
+	<< "# Differences between old etree database '" << _filenameOld
+	<< "'\n# and new etree database '" << _filenameNew << "'.\n"
+	<< "# type level x y z lon lat elev values\n"
+	<< std::resetiosflags(std::ios::fixed)
+	<< std::setiosflags(std::ios::scientific)
+	<< std::setprecision(6);
+      } // if
+
+    etree_addr_t cursor;
+    cursor.x = 0;
+    cursor.y = 0;
+    cursor.z = 0;
+    cursor.t = 0;
+    cursor.level = ETREE_MAXLEVEL;
+
+    etree_addr_t addrOld;
+    storage::PayloadStruct payloadOld;
+    bool haveOld = 
+      0 == etree_initcursor(dbOld, cursor) &&
+      _getOctant(dbOld, &addrOld, &payloadOld);
+
+    etree_addr_t addrNew;
+    storage::PayloadStruct payloadNew;
+    bool haveNew = 
+      0 == etree_initcursor(dbNew, cursor) &&
+      _getOctant(dbNew, &addrNew, &payloadNew);
+
+    while (haveOld || haveNew) {
+      const bool sameAddr = haveOld && haveNew &&
+	addrOld.level == addrNew.level &&
+	addrOld.x == addrNew.x &&
+	addrOld.y == addrNew.y &&
+	addrOld.z == addrNew.z;
+      if (sameAddr) {
+	const int fields = 
+	  _compare(_pMaxDiff, addrOld, payloadOld, addrNew, payloadNew);
+	_record((0 != fields) ? CHANGED : UNCHANGED, addrNew, fields);
+	haveOld = 0 == etree_advcursor(dbOld) &&
+	  _getOctant(dbOld, &addrOld, &payloadOld);
+	haveNew = 0 == etree_advcursor(dbNew) &&
+	  _getOctant(dbNew, &addrNew, &payloadNew);
+      } else if (haveOld && 
+		 (!haveNew || storage::Geometry::precedes(addrOld, addrNew))) {
+	_record(REMOVED, addrOld, 0);
+	haveOld = 0 == etree_advcursor(dbOld) &&
+	  _getOctant(dbOld, &addrOld, &payloadOld);
+      } else {
+	_record(ADDED, addrNew, 0);
+	haveNew = 0 == etree_advcursor(dbNew) &&
+	  _getOctant(dbNew, &addrNew, &payloadNew);
+      } // if/else
+    } // while
+    if (_haveRegion)
+      _regions.push_back(_curRegion);
+    _haveRegion = false;
+  } catch (...) {
+    etree_close(dbOld);
+    if (0 != dbNew)
+      etree_close(dbNew);
+    delete _pReport; _pReport = 0;
+    throw;
+  } // try/catch
+
+  etree_close(dbOld);
+  etree_close(dbNew);
+  delete _pReport; _pReport = 0;
+
+  if (!_quiet)
+    printSummary(std::cout);
+} // diff
+
+// ----------------------------------------------------------------------
+// Get number of octants with given type of difference.
+uint64_t
+cencalvm::query::VMDiff::count(const DiffEnum type,
+			       const int level) const
+{ // count
+  if (level > ETREE_MAXLEVEL)
+    return 0;
+  if (level >= 0)
+    return _pLevelCount[4*level+type];
+
+  uint64_t total = 0;
+  for (int iLevel=0; iLevel <= ETREE_MAXLEVEL; ++iLevel)
+    total += _pLevelCount[4*iLevel+type];
+  return total;
+} // count
+
+// ----------------------------------------------------------------------
+// Print summary of differences per level and per region.
+void
+cencalvm::query::VMDiff::printSummary(std::ostream& sout) const
+{ // printSummary
+  assert(0 != _pGeom);
+
+  sout
+    << "Summary of etree differences\n"
+    << "Number of octants\n"
+    << "  level, added, removed, changed, unchanged\n";
+  for (int iLevel=0; iLevel <= ETREE_MAXLEVEL; ++iLevel) {
+    const uint64_t* pCount = &_pLevelCount[4*iLevel];
+    if (0 == pCount[ADDED] + pCount[REMOVED] + pCount[CHANGED] +
+	pCount[UNCHANGED])
+      continue;
+    sout
+      << "  " << std::setw(5) << iLevel
+      << ", " << pCount[ADDED]
+      << ", " << pCount[REMOVED]
+      << ", " << pCount[CHANGED]
+      << ", " << pCount[UNCHANGED] << "\n";
+  } // for
+  sout
+    << "  total, " << count(ADDED)
+    << ", " << count(REMOVED)
+    << ", " << count(CHANGED)
+    << ", " << count(UNCHANGED) << "\n";
+
+  sout << "Changed values (number of octants, maximum difference)\n";
+  for (int i=0; i < _NUMVALS; ++i)
+    sout
+      << "  " << _NAMES[i] << ": " << _pFieldCount[i]
+      << ", " << _pMaxDiff[i] << "\n";
+  sout << "  octant type: " << _pFieldCount[_NUMVALS] << "\n";
+
+  sout
+    << "Regions with differences (octants at level " << _regionLevel
+    << "): " << _regions.size() << "\n";
+  const int numRegions = _regions.size();
+  for (int iRegion=0; iRegion < numRegions; ++iRegion) {
+    const RegionStruct& region = _regions[iRegion];
+    etree_addr_t addr;
+    addr.x = region.x;
+    addr.y = region.y;
+    addr.z = region.z;
+    addr.t = 0;
+    addr.level = _regionLevel;
+    double lon = 0.0;
+    double lat = 0.0;
+    double elev = 0.0;
+    _pGeom->addrToLonLatElev(&lon, &lat, &elev, &addr);
+    sout
+      << "  centroid (" << lon << ", " << lat << ", " << elev << ")"
+      << ": added " << region.count[ADDED]
+      << ", removed " << region.count[REMOVED]
+      << ", changed " << region.count[CHANGED] << "\n";
+  } // for
+  sout << std::endl;
+} // printSummary
+
+// ----------------------------------------------------------------------
+// Open existing database and check its compatibility.
+etree_t*
+cencalvm::query::VMDiff::_openDB(const std::string& filename,
+				 const char* description) const
+{ // _openDB
+  assert(0 != description);
+
+  etree_t* db = etree_open(filename.c_str(), O_RDONLY, _cacheSize, 0, 0);
+  if (0 == db) {
+    std::ostringstream msg;
+    msg
+      << "Could not open " << description << " etree database '" << filename
+      << "'.";
+    throw std::runtime_error(msg.str());
+  } // if
+
+  const int payloadSize = sizeof(storage::PayloadStruct);
+  if (etree_getpayloadsize(db) != payloadSize) {
+    std::ostringstream msg;
+    msg
+      << "Payload size of " << description << " etree database '" << filename
+      << "' doesn't match the expected payload size.\n"
+      << "Expected payload size is " << payloadSize
+      << ", and database payload size is " << etree_getpayloadsize(db)
+      << ".";
+    etree_close(db);
+    throw std::runtime_error(msg.str());
+  } // if
+  const char* schema = etree_getschema(db);
+  if (0 != strcmp(schema, storage::Payload::SCHEMA)) {
+    std::ostringstream msg;
+    msg
+      << "Schema of " << description << " etree database '" << filename
+      << "' doesn't match the expected schema.\n"
+      << "Expected schema is\n'" << storage::Payload::SCHEMA
+      << "'\nand database schema is\n'" << schema << "'";
+    etree_close(db);
+    throw std::runtime_error(msg.str());
+  } // if
+
+  return db;
+} // _openDB
+
+// ----------------------------------------------------------------------
+// Get octant at current cursor position.
+bool
+cencalvm::query::VMDiff::_getOctant(etree_t* db,
+				    etree_addr_t* pAddr,
+				    storage::PayloadStruct* pPayload) const
+{ // _getOctant
+  assert(0 != db);
+  assert(0 != pAddr);
+  assert(0 != pPayload);
+
+  if (0 != etree_getcursor(db, pAddr, 0, pPayload))
+    throw std::runtime_error("Error occurred while trying to get payload at "
+			     "current cursor position.");
+  return true;
+} // _getOctant
+
+// ----------------------------------------------------------------------
+// Compare values of octant in old and new databases.
+int
+cencalvm::query::VMDiff::_compare(double* pMaxDiff,
+				  const etree_addr_t& addrOld,
+				  const storage::PayloadStruct& payloadOld,
+				  const etree_addr_t& addrNew,
+				  const storage::PayloadStruct& payloadNew) const
+{ // _compare
+  assert(0 != pMaxDiff);
+
+  int fields = 0;
+  for (int i=0; i < _NUMVALS; ++i) {
+    const double diff = fabs(_value(payloadNew, i) - _value(payloadOld, i));
+    if (diff > _pTolerance[i]) {
+      fields |= 1 << i;
+      if (diff > pMaxDiff[i])
+	pMaxDiff[i] = diff;
+    } // if
+  } // for
+  if (addrOld.type != addrNew.type)
+    fields |= 1 << _NUMVALS;
+
+  return fields;
+} // _compare
+
+// ----------------------------------------------------------------------
+// Record difference.
+void
+cencalvm::query::VMDiff::_record(const DiffEnum type,
+				 const etree_addr_t& addr,
+				 const int fields)
+{ // _record
+  ++_pLevelCount[4*addr.level+type];
+  if (UNCHANGED == type)
+    return;
+
+  for (int i=0; i <= _NUMVALS; ++i)
+    if (fields & (1 << i))
+      ++_pFieldCount[i];
+
+  // Octants are visited in Morton order, so octants within a region
+  // are contiguous. Octants coarser than the regions are only counted
+  // per level.
+  if (addr.level >= _regionLevel) {
+    etree_addr_t addrRegion = addr;
+    if (addr.level > _regionLevel)
+      storage::Geometry::findAncestor(&addrRegion, addr, _regionLevel);
+    if (!_haveRegion ||
+	addrRegion.x != _curRegion.x ||
+	addrRegion.y != _curRegion.y ||
+	addrRegion.z != _curRegion.z) {
+      if (_haveRegion)
+	_regions.push_back(_curRegion);
+      _curRegion.x = addrRegion.x;
+      _curRegion.y = addrRegion.y;
+      _curRegion.z = addrRegion.z;
+      _curRegion.count[ADDED] = 0;
+      _curRegion.count[REMOVED] = 0;
+      _curRegion.count[CHANGED] = 0;
+      _haveRegion = true;
+    } // if
+    ++_curRegion.count[type];
+  } // if
+
+  if (0 != _pReport) {
+    assert(0 != _pGeom);
+    const char* typeNames[] = { "added", "removed", "changed" };
+    etree_addr_t addrC = addr;
+    double lon = 0.0;
+    double lat = 0.0;
+    double elev = 0.0;
+    _pGeom->addrToLonLatElev(&lon, &lat, &elev, &addrC);
+    *_pReport
+      << typeNames[type] << " " << addr.level
+      << " " << addr.x << " " << addr.y << " " << addr.z
+      << " " << lon << " " << lat << " " << elev << " ";
+    if (CHANGED == type) {
+      bool first = true;
+      for (int i=0; i <= _NUMVALS; ++i)
+	if (fields & (1 << i)) {
+	  *_pReport 
+	    << (first ? "" : ",") << ((i < _NUMVALS) ? _NAMES[i] : "type");
+	  first = false;
+	} // if
+    } else
+      *_pReport << "-";
+    *_pReport << "\n";
+  } // if
+} // _record
+
+// ----------------------------------------------------------------------
+// Get value from payload.
+double
+cencalvm::query::VMDiff::_value(const storage::PayloadStruct& payload,
+				const int index)
+{ // _value
+  switch (index)
+    { // switch
+    case 0 :
+      return payload.Vp;
+    case 1 :
+      return payload.Vs;
+    case 2 :
+      return payload.Density;
+    case 3 :
+      return payload.Qp;
+    case 4 :
+      return payload.Qs;
+    case 5 :
+      return payload.DepthFreeSurf;
+    case 6 :
+      return payload.FaultBlock;
+    case 7 :
+      return payload.Zone;
+    default :
+      assert(0);
+    } // switch
+  return 0.0;
+} // _value
+
+// End of file 
@@ -0,0 +1,265 @@
+// -*- C++ -*-
+//
+// ======================================================================
+//
+//                           Brad T. Aagaard
+//                        U.S. Geological Survey
+//
+// {LicenseText}
+//
+// ======================================================================
+//
+
+/** @file libsrc/query/VMDiff.h
+ *
+ * @brief C++ manager for finding the differences between two etree
+ * databases of the USGS central CA velocity model.
+ *
+ * Cursors over both databases advance in lockstep in Morton
+ * pre-order (a merge-join), so each database is read once
+ * sequentially. Octants present only in the new database are added,
+ * octants present only in the old database are removed, and octants
+ * present in both are changed if any value differs by more than the
+ * tolerance for that value (default is 0).
+ *
+ * Differences are summarized for each level of the etree and for
+ * each region, where a region is an octant at the region level
+ * (default is 4). Individual differences are optionally written to a
+ * report file.
+ */
+
+#if !defined(cencalvm_query_vmdiff_h)
+#define cencalvm_query_vmdiff_h
+
+#include "cencalvm/storage/etreefwd.h" // USES etree_t
+
+#include <string> // HASA std::string
+#include <vector> // HASA std::vector
+#include <iosfwd> // USES std::ostream
+#include <inttypes.h> // USES uint64_t
+
+namespace cencalvm {
+  namespace query {
+    class VMDiff;
+    class TestVMDiff; // friend
+  } // query
+  namespace storage {
+    class Geometry; // HOLDSA Geometry
+    struct PayloadStruct; // USES PayloadStruct
+  } // storage
+} // cencalvm
+
+/// C++ manager for finding the differences between two etree
+/// databases of the USGS central CA velocity model.
+class cencalvm::query::VMDiff
+{ // class VMDiff
+  friend class TestVMDiff; // unit testing
+
+ public :
+  // PUBLIC ENUM ////////////////////////////////////////////////////////
+
+  /// Type of difference
+  enum DiffEnum {
+    ADDED=0, ///< Octant only in new database
+    REMOVED=1, ///< Octant only in old database
+    CHANGED=2, ///< Octant in both databases with different values
+    UNCHANGED=3 ///< Octant in both databases with same values
+  };
+
+ public :
+  // PUBLIC METHODS /////////////////////////////////////////////////////
+
+  /// Default constructor.
+  VMDiff(void);
+
+  /// Default destructor.
+  ~VMDiff(void);
+
+  /** Set filename of old database.
+   *
+   * @param filename Name of file
+   */
+  void filenameOld(const char* filename);
+
+  /** Set filename of new database.
+   *
+   * @param filename Name of file
+   */
+  void filenameNew(const char* filename);
+
+  /** Set filename of report listing each difference (default is no
+   * report).
+   *
+   * @param filename Name of file
+   */
+  void filenameReport(const char* filename);
+
+  /** Set size of cache for each database.
+   *
+   * @param size Size of cache in MB
+   */
+  void cacheSize(const int size);
+
+  /** Set level of octants defining regions in summary.
+   *
+   * @param level Level in etree
+   */
+  void regionLevel(const int level);
+
+  /** Set tolerance for value.
+   *
+   * @param name Name of value (Vp, Vs, Density, Qp, Qs,
+   *   DepthFreeSurf, FaultBlock, Zone)
+   * @param tolerance Largest absolute difference of unchanged value
+   */
+  void tolerance(const char* name,
+		 const double tolerance);
+
+  /** Set geometry of velocity model (default is GeomCenCA).
+   *
+   * @param pGeom Pointer to geometry
+   */
+  void geometry(const storage::Geometry* pGeom);
+
+  /** Set flag indicating diff should be quiet (no summary).
+   *
+   * @param flag True for quiet operation, false to print summary
+   */
+  void quiet(const bool flag);
+
+  /// Find differences between old and new databases.
+  void diff(void);
+
+  /** Get number of octants with given type of difference.
+   *
+   * @param type Type of difference
+   * @param level Level in etree (-1 for all levels)
+   *
+   * @returns Number of octants
+   */
+  uint64_t count(const DiffEnum type,
+		 const int level =-1) const;
+
+  /** Get number of regions with differences.
+   *
+   * @returns Number of regions
+   */
+  int numRegions(void) const;
+
+  /** Print summary of differences per level and per region.
+   *
+   * @param sout Output stream
+   */
+  void printSummary(std::ostream& sout) const;
+
+ private :
+  // PRIVATE STRUCTS ////////////////////////////////////////////////////
+
+  /// Differences within a region
+  struct RegionStruct {
+    etree_tick_t x; ///< x coordinate of region octant
+    etree_tick_t y; ///< y coordinate of region octant
+    etree_tick_t z; ///< z coordinate of region octant
+    uint64_t count[3]; ///< Number of added, removed, and changed octants
+  }; // RegionStruct
+
+ private :
+  // PRIVATE METHODS ////////////////////////////////////////////////////
+
+  /** Open existing database and check its compatibility.
+   *
+   * @param filename Name of database file
+   * @param description Description of database used in error messages
+   *
+   * @returns Database
+   */
+  etree_t* _openDB(const std::string& filename,
+		   const char* description) const;
+
+  /** Get octant at current cursor position.
+   *
+   * @param db Database
+   * @param pAddr Pointer to address of octant
+   * @param pPayload Pointer to payload of octant
+   *
+   * @returns True if cursor is at an octant, false at end of database
+   */
+  bool _getOctant(etree_t* db,
+		  etree_addr_t* pAddr,
+		  storage::PayloadStruct* pPayload) const;
+
+  /** Compare values of octant in old and new databases.
+   *
+   * @param pMaxDiff Array of maximum differences for each value
+   *   (updated)
+   * @param addrOld Address of octant in old database
+   * @param payloadOld Payload of octant in old database
+   * @param addrNew Address of octant in new database
+   * @param payloadNew Payload of octant in new database
+   *
+   * @returns Bitmask of values that differ (bit NUMVALS for type)
+   */
+  int _compare(double* pMaxDiff,
+	       const etree_addr_t& addrOld,
+	       const storage::PayloadStruct& payloadOld,
+	       const etree_addr_t& addrNew,
+	       const storage::PayloadStruct& payloadNew) const;
+
+  /** Record difference.
+   *
+   * @param type Type of difference
+   * @param addr Address of octant
+   * @param fields Bitmask of values that differ
+   */
+  void _record(const DiffEnum type,
+	       const etree_addr_t& addr,
+	       const int fields);
+
+  /** Get value from payload.
+   *
+   * @param payload Payload of octant
+   * @param index Index of value
+   *
+   * @returns Value
+   */
+  static double _value(const storage::PayloadStruct& payload,
+		       const int index);
+
+  VMDiff(const VMDiff& d); ///< Not implemented
+  const VMDiff& operator=(const VMDiff& d); ///< Not implemented
+
+ private :
+  // PRIVATE MEMBERS ////////////////////////////////////////////////////
+
+  static const int _NUMVALS; ///< Number of values in payload
+  static const char* _NAMES[]; ///< Names of values in payload
+
+  std::string _filenameOld; ///< Filename of old database
+  std::string _filenameNew; ///< Filename of new database
+  std::string _filenameReport; ///< Filename of report
+
+  double* _pTolerance; ///< Array of tolerances for values
+  double* _pMaxDiff; ///< Array of maximum differences of changed values
+  uint64_t* _pFieldCount; ///< Array of number of changes for each value
+
+  /// Number of octants for each type of difference and level
+  uint64_t* _pLevelCount;
+
+  std::vector<RegionStruct> _regions; ///< Regions with differences
+  RegionStruct _curRegion; ///< Current region
+  bool _haveRegion; ///< True if current region is valid
+
+  storage::Geometry* _pGeom; ///< Geometry of velocity model
+  std::ostream* _pReport; ///< Report stream (0 if no report)
+
+  int _cacheSize; ///< Size of cache in MB for each database
+  int _regionLevel; ///< Level of octants defining regions
+  bool _quiet; ///< Flag to eliminate summary
+
+}; // class VMDiff
+
+#include "VMDiff.icc" // inline methods
+
+#endif // cencalvm_query_vmdiff_h
+
+// End of file
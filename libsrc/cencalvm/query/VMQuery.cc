@@ -16,6 +16,12 @@
 #include "cencalvm/storage/Geometry.h" // USES Geometry
 #include "cencalvm/storage/GeomCenCA.h" // USES GeomCenCA
 #include "cencalvm/storage/ErrorHandler.h" // USES ErrorHandler
+#include "cencalvm/storage/PayloadCodec.h" // USES PayloadCodec
+#include "cencalvm/storage/PayloadDictionary.h" // USES PayloadDictionary
+#include "cencalvm/storage/CompressedDB.h" // USES CompressedDB
+#include "cencalvm/storage/ColumnDB.h" // USES ColumnDB
+#include "cencalvm/storage/BrickDB.h" // USES BrickDB
+#include "QueryTrace.h" // USES QueryTrace
 
 extern "C" {
 #include "etree.h"
@@ -25,8 +31,27 @@ extern "C" {
 #include <iomanip> // USES setw(), setiosflags(), resetiosflags()
 #include <strings.h> // USES strcasecmp()
 #include <string.h> // USES strcmp()
+#include <stdlib.h> // USES free()
+#include <stdexcept> // USES std::exception
 #include <assert.h> // USES assert()
 
+// ----------------------------------------------------------------------
+/// Cache of database.
+struct cencalvm::query::VMQuery::CacheStruct {
+  /// Monitor of buffer cache (etree databases)
+  cencalvm::storage::CacheMonitor monitor;
+  /// Statistics at start of batch of queries
+  cencalvm::storage::CacheStatsStruct batch;
+  /// Statistics when cache was last resized
+  cencalvm::storage::CacheStatsStruct resized;
+  int size; ///< Size of cache in MB
+  int sizeMax; ///< Maximum size of automatic cache in MB (0 if fixed)
+}; // CacheStruct
+
+// ----------------------------------------------------------------------
+const int cencalvm::query::VMQuery::_AUTOBATCH = 65536;
+const double cencalvm::query::VMQuery::_AUTOFRACTION = 0.25;
+
 // ----------------------------------------------------------------------
 /// Default constructor
 cencalvm::query::VMQuery::VMQuery(void) :
@@ -34,12 +59,31 @@ cencalvm::query::VMQuery::VMQuery(void) :
   _squashLimit(-2000.0),
   _db(0),
   _dbExt(0),
+  _pCompressed(0),
+  _pCompressedExt(0),
+  _pCache(0),
+  _pCacheExt(0),
+  _pColumns(0),
+  _pColumnsExt(0),
+  _pPyramid(0),
+  _pPyramidExt(0),
+  _pCodec(0),
+  _pCodecExt(0),
+  _pDictionary(0),
+  _pDictionaryExt(0),
   _pQueryVals(0),
   _pGeom(new cencalvm::storage::GeomCenCA),
   _pErrHandler(new cencalvm::storage::ErrorHandler),
   _filename(""),
   _filenameExt(""),
+  _filenamePyramid(""),
+  _filenamePyramidExt(""),
+  _filenameTrace(""),
+  _pTrace(0),
+  _pTraceState(0),
   _queryFn(&cencalvm::query::VMQuery::_queryMax),
+  _queryType(MAXRES),
+  _numQueries(0),
   _querySize(0),
   _cacheSize(128),
   _cacheSizeExt(128),
@@ -56,10 +100,10 @@ cencalvm::query::VMQuery::VMQuery(void) :
 // Default destructor.
 cencalvm::query::VMQuery::~VMQuery(void)
 { // destructor
+  close();
   delete[] _pQueryVals; _pQueryVals = 0;
   delete _pGeom; _pGeom = 0;
   delete _pErrHandler; _pErrHandler = 0;
-  close();
 } // destructor
 
 // ----------------------------------------------------------------------
@@ -76,26 +120,62 @@ cencalvm::query::VMQuery::geometry(const storage::Geometry* pGeom)
 void
 cencalvm::query::VMQuery::open(void)
 { // open
-  if (0 == _db) { // database is not already open
-    assert(_cacheSize > 0);
-    _db = etree_open(_filename.c_str(), O_RDONLY, _cacheSize, 0, 0);
-    if (0 == _db) {
-      std::ostringstream msg;
-      msg << "Could not open the etree database '" << _filename
-	  << "' for querying.";
-      _pErrHandler->error(msg.str().c_str());
-    } // if
+  if (!_isOpen(DETAILED)) { // database is not already open
+    if (cencalvm::storage::CompressedDB::isCompressed(_filename.c_str())) {
+      _pCache = _createCache(_filename.c_str(), _cacheSize);
+      _pCompressed = _openCompressed(_filename.c_str(), _pCache->size);
+    } else if (cencalvm::storage::ColumnDB::isColumnar(_filename.c_str()))
+      _pColumns = _openColumns(_filename.c_str());
+    else {
+      _pCache = _createCache(_filename.c_str(), _cacheSize);
+      _db = etree_open(_filename.c_str(), O_RDONLY, _pCache->size, 0, 0);
+      if (0 == _db) {
+	std::ostringstream msg;
+	msg << "Could not open the etree database '" << _filename
+	    << "' for querying.";
+	_pErrHandler->error(msg.str().c_str());
+      } // if
+    } // if/else
+    _pCodec = _createCodec(DETAILED, _filename.c_str());
+    _pDictionary = _createDictionary(DETAILED, _filename.c_str());
   } // if
 
-  if (0 != strcmp(_filenameExt.c_str(), "") && 0 == _dbExt) {
-    assert(_cacheSizeExt > 0);
-    _dbExt = etree_open(_filenameExt.c_str(), O_RDONLY, _cacheSizeExt, 0, 0);
-    if (0 == _dbExt) {
-      std::ostringstream msg;
-      msg << "Could not open the etree (regional) database '"
-	  << _filenameExt << "' for querying.";
-      _pErrHandler->error(msg.str().c_str());
-    } // if
+  if (0 != strcmp(_filenameExt.c_str(), "") && !_isOpen(EXTENDED)) {
+    if (cencalvm::storage::CompressedDB::isCompressed(_filenameExt.c_str())) {
+      _pCacheExt = _createCache(_filenameExt.c_str(), _cacheSizeExt);
+      _pCompressedExt = _openCompressed(_filenameExt.c_str(), _pCacheExt->size);
+    } else if (cencalvm::storage::ColumnDB::isColumnar(_filenameExt.c_str()))
+      _pColumnsExt = _openColumns(_filenameExt.c_str());
+    else {
+      _pCacheExt = _createCache(_filenameExt.c_str(), _cacheSizeExt);
+      _dbExt = etree_open(_filenameExt.c_str(), O_RDONLY, _pCacheExt->size,
+			  0, 0);
+      if (0 == _dbExt) {
+	std::ostringstream msg;
+	msg << "Could not open the etree (regional) database '"
+	    << _filenameExt << "' for querying.";
+	_pErrHandler->error(msg.str().c_str());
+      } // if
+    } // if/else
+    _pCodecExt = _createCodec(EXTENDED, _filenameExt.c_str());
+    _pDictionaryExt = _createDictionary(EXTENDED, _filenameExt.c_str());
+  } // if
+
+  if (0 != strcmp(_filenamePyramid.c_str(), "") && 0 == _pPyramid)
+    _pPyramid = _openPyramid(_filenamePyramid.c_str());
+  if (0 != strcmp(_filenamePyramidExt.c_str(), "") && 0 == _pPyramidExt)
+    _pPyramidExt = _openPyramid(_filenamePyramidExt.c_str());
+
+  if (0 != strcmp(_filenameTrace.c_str(), "") && 0 == _pTrace) {
+    _pTrace = new QueryTrace;
+    _pTraceState = new QueryTraceStateStruct;
+    try {
+      _pTrace->create(_filenameTrace.c_str());
+    } catch (const std::exception& err) {
+      _pErrHandler->error(err.what());
+      delete _pTrace; _pTrace = 0;
+      delete _pTraceState; _pTraceState = 0;
+    } // try/catch
   } // if
 } // open
   
@@ -110,6 +190,12 @@ cencalvm::query::VMQuery::close(void)
     _pErrHandler->error(msg.str().c_str());
   } // if
   _db = 0;
+  delete _pCompressed; _pCompressed = 0;
+  delete _pCache; _pCache = 0;
+  delete _pColumns; _pColumns = 0;
+  delete _pPyramid; _pPyramid = 0;
+  delete _pCodec; _pCodec = 0;
+  delete _pDictionary; _pDictionary = 0;
 
   if (0 != _dbExt && 0 != etree_close(_dbExt)) {
     std::ostringstream msg;
@@ -117,6 +203,23 @@ cencalvm::query::VMQuery::close(void)
     _pErrHandler->error(msg.str().c_str());
   } // if
   _dbExt = 0;
+  delete _pCompressedExt; _pCompressedExt = 0;
+  delete _pCacheExt; _pCacheExt = 0;
+  delete _pColumnsExt; _pColumnsExt = 0;
+  delete _pPyramidExt; _pPyramidExt = 0;
+  delete _pCodecExt; _pCodecExt = 0;
+  delete _pDictionaryExt; _pDictionaryExt = 0;
+
+  if (0 != _pTrace) {
+    try {
+      _pTrace->close();
+    } catch (const std::exception& err) {
+      _pErrHandler->error(err.what());
+    } // try/catch
+  } // if
+  delete _pTrace; _pTrace = 0;
+  delete _pTraceState; _pTraceState = 0;
+  _numQueries = 0;
 } // close
   
 // ----------------------------------------------------------------------
@@ -128,12 +231,15 @@ cencalvm::query::VMQuery::queryType(const QueryEnum queryType)
     { // switch
     case MAXRES :
       _queryFn = &cencalvm::query::VMQuery::_queryMax;
+      _queryType = queryType;
       break;
     case FIXEDRES :
       _queryFn = &cencalvm::query::VMQuery::_queryFixed;
+      _queryType = queryType;
       break;
     case WAVERES :
       _queryFn = &cencalvm::query::VMQuery::_queryWave;
+      _queryType = queryType;
       break;
     default :
       _pErrHandler->error("Could not find query function for requested "
@@ -185,6 +291,24 @@ cencalvm::query::VMQuery::queryVals(const char* const* names,
   } // if
 } // queryVals
 
+// ----------------------------------------------------------------------
+// Get statistics of cache of the database.
+void
+cencalvm::query::VMQuery::cacheStats(
+			      cencalvm::storage::CacheStatsStruct* pStats) const
+{ // cacheStats
+  _cacheStats(pStats, DETAILED);
+} // cacheStats
+
+// ----------------------------------------------------------------------
+// Get statistics of cache of the database for the extended model.
+void
+cencalvm::query::VMQuery::cacheStatsExt(
+			      cencalvm::storage::CacheStatsStruct* pStats) const
+{ // cacheStatsExt
+  _cacheStats(pStats, EXTENDED);
+} // cacheStatsExt
+
 // ----------------------------------------------------------------------
 // Query the database.
 void
@@ -199,6 +323,13 @@ cencalvm::query::VMQuery::query(double** ppVals,
   assert(numVals == _querySize);
   assert(0 != _pGeom);
   
+  if (0 != _pTrace)
+    _trace(lon, lat, elev);
+  if (0 == ++_numQueries % _AUTOBATCH) {
+    _adjustCache(DETAILED);
+    _adjustCache(EXTENDED);
+  } // if
+
   etree_addr_t addr;
   double elevRef = 0.0;
 
@@ -213,12 +344,12 @@ cencalvm::query::VMQuery::query(double** ppVals,
         elevQuery = elev + elevRef;
       } // if
     } // if
-    (this->*_queryFn)(&payload, &addr, _db, lon, lat, elevQuery, useAddr);
+    (this->*_queryFn)(&payload, &addr, DETAILED, lon, lat, elevQuery, useAddr);
 
     // If not found in detailed model, query the regional model
-    if (cencalvm::storage::Payload::NODATABLOCK == payload.FaultBlock && 0 != _dbExt) {
+    if (cencalvm::storage::Payload::NODATABLOCK == payload.FaultBlock && _isOpen(EXTENDED)) {
       useAddr = true;
-      (this->*_queryFn)(&payload, &addr, _dbExt, lon, lat, elevQuery, useAddr);
+      (this->*_queryFn)(&payload, &addr, EXTENDED, lon, lat, elevQuery, useAddr);
     } // if
   } catch (const std::exception& err) {
       _pErrHandler->error(err.what());
@@ -294,14 +425,13 @@ cencalvm::query::VMQuery::query(double** ppVals,
 void
 cencalvm::query::VMQuery::_queryMax(cencalvm::storage::PayloadStruct* pPayload,
 				    etree_addr_t* pAddr,
-				    etree_t* pDB,
+				    const DBEnum db,
 				    const double lon,
 				    const double lat,
 				    const double elev,
 				    const bool useAddr)
 { // _queryMax
   assert(0 != pPayload);
-  assert(0 != pDB);
   assert(0 != pAddr);
 
   if (!useAddr) {
@@ -315,11 +445,13 @@ cencalvm::query::VMQuery::_queryMax(cencalvm::storage::PayloadStruct* pPayload,
   } // if
 
   etree_addr_t resAddr;
-  int err = etree_search(pDB, *pAddr, &resAddr, "*", pPayload);
+  int err = _search(db, *pAddr, &resAddr, pPayload);
   // If search returned interior octant (averaged), return no data
   // instead of averaged values since query request is for maximum
   // resolution and we don't have a leaf octant (data) at that
-  // location.
+  // location. A leaf octant coarser than the data (homogeneous
+  // subtree collapsed by compaction) holds the exact value anywhere
+  // within it, so it is returned like any other leaf octant.
   if (err || ETREE_INTERIOR == resAddr.type)
     _setNoData(pPayload);
 } // _queryMax
@@ -329,14 +461,13 @@ cencalvm::query::VMQuery::_queryMax(cencalvm::storage::PayloadStruct* pPayload,
 void
 cencalvm::query::VMQuery::_queryFixed(cencalvm::storage::PayloadStruct* pPayload,
 				    etree_addr_t* pAddr,
-				    etree_t* pDB,
+				    const DBEnum db,
 				    const double lon,
 				    const double lat,
 				    const double elev,
 				    const bool useAddr)
 { // _queryFixed
   assert(0 != pPayload);
-  assert(0 != pDB);
   assert(0 != pAddr);
   assert(0 != _pGeom);
 
@@ -351,8 +482,15 @@ cencalvm::query::VMQuery::_queryFixed(cencalvm::storage::PayloadStruct* pPayload
     } // if
   } // if
 
+  // Pyramid holds results of fixed resolution queries, so the query
+  // reduces to a lookup in a dense brick.
+  const cencalvm::storage::BrickDB* pPyramid =
+    (DETAILED == db) ? _pPyramid : _pPyramidExt;
+  if (0 != pPyramid && 0 == pPyramid->search(pPayload, *pAddr))
+    return;
+
   etree_addr_t resAddr;
-  const int err = etree_search(pDB, *pAddr, &resAddr, "*", pPayload);
+  const int err = _search(db, *pAddr, &resAddr, pPayload);
   // if search returned interior octant at coarser resolution than
   // what we want, return no data instead of averaged octant since
   // query request was for a given resolution and we don't have a leaf
@@ -367,14 +505,13 @@ cencalvm::query::VMQuery::_queryFixed(cencalvm::storage::PayloadStruct* pPayload
 void
 cencalvm::query::VMQuery::_queryWave(cencalvm::storage::PayloadStruct* pPayload,
 				    etree_addr_t* pAddr,
-				    etree_t* pDB,
+				    const DBEnum db,
 				    const double lon,
 				    const double lat,
 				    const double elev,
 				    const bool useAddr)
 { // _queryWave
   assert(0 != pPayload);
-  assert(0 != pDB);
   assert(0 != pAddr);
   assert(0 != _pGeom);
 
@@ -389,7 +526,7 @@ cencalvm::query::VMQuery::_queryWave(cencalvm::storage::PayloadStruct* pPayload,
   } // if
 
   etree_addr_t resAddr;
-  const int err = etree_search(pDB, *pAddr, &resAddr, "*", pPayload);
+  const int err = _search(db, *pAddr, &resAddr, pPayload);
 
   const double vertExag = _pGeom->vertExag();
   const double minPeriod = vertExag * _queryRes;
@@ -409,17 +546,19 @@ cencalvm::query::VMQuery::_queryWave(cencalvm::storage::PayloadStruct* pPayload,
     childPayload = *pPayload;
     etree_addr_t parentAddr;
     _pGeom->findAncestor(&parentAddr, resAddr, resAddr.level-1);
-    if (0 != etree_search(pDB, parentAddr, &resAddr, "*", pPayload)) {
-      char buf[ETREE_MAXBUF];
+    if (0 != _search(db, parentAddr, &resAddr, pPayload)) {
       std::ostringstream msg;
       msg
-	<< "Could not find parent octant " << 
-	etree_straddr(pDB, buf, parentAddr)
-	<< "\nof child octant " << etree_straddr(pDB, buf, resAddr) << "\n"
+	<< "Could not find parent octant ("
+	<< parentAddr.x << ", " << parentAddr.y << ", " << parentAddr.z
+	<< ", " << parentAddr.level << ")"
+	<< "\nof child octant ("
+	<< resAddr.x << ", " << resAddr.y << ", " << resAddr.z
+	<< ", " << resAddr.level << ")\n"
 	<< "for location " << lon << ", " << lat << ", " << elev
 	<< ".\nUsing values from child octant.";
       _pErrHandler->warning(msg.str().c_str());
-      etree_search(pDB, *pAddr, &resAddr, "*", pPayload);
+      _search(db, *pAddr, &resAddr, pPayload);
       return;
     } // if
   } // while
@@ -459,15 +598,15 @@ cencalvm::query::VMQuery::_queryElev(etree_addr_t* pAddr,
 
   cencalvm::storage::PayloadStruct payload;
   etree_addr_t resAddr;
-  int err = etree_search(_db, *pAddr, &resAddr, "*", &payload);
-  etree_t* dbElev = _db;
+  int err = _search(DETAILED, *pAddr, &resAddr, &payload);
+  DBEnum dbElev = DETAILED;
 
   // If not found in detailed model, query the regional model
   bool found = (!err && ETREE_INTERIOR != resAddr.type);
-  if (!found && 0 != _dbExt) {
-    err = etree_search(_dbExt, *pAddr, &resAddr, "*", &payload);
+  if (!found && _isOpen(EXTENDED)) {
+    err = _search(EXTENDED, *pAddr, &resAddr, &payload);
     found = 0 == err;
-    dbElev = _dbExt;
+    dbElev = EXTENDED;
   } // if
 
   if (found) {
@@ -485,7 +624,7 @@ cencalvm::query::VMQuery::_queryElev(etree_addr_t* pAddr,
     // octant (which will not exist in etree).
     _pGeom->lonLatElevToAddr(pAddr, lon, lat, elevRef);
     etree_addr_t resAddrElev;
-    err = etree_search(dbElev, *pAddr, &resAddrElev, "*", &payload);
+    err = _search(dbElev, *pAddr, &resAddrElev, &payload);
     if ((err || ETREE_INTERIOR == resAddrElev.type || payload.Vs == cencalvm::storage::Payload::NODATAVAL) && allowAdjustment) {
       const etree_tick_t tickLen = 0x80000000 >> resAddr.level;
       resAddr.z -= tickLen;
@@ -499,6 +638,395 @@ cencalvm::query::VMQuery::_queryElev(etree_addr_t* pAddr,
   return elevRef;
 } // _queryElev
 
+// ----------------------------------------------------------------------
+// Create cache of database.
+cencalvm::query::VMQuery::CacheStruct*
+cencalvm::query::VMQuery::_createCache(const char* filename,
+				       const int cacheSize)
+{ // _createCache
+  assert(0 != filename);
+
+  CacheStruct* pCache = new CacheStruct;
+  memset(&pCache->batch, 0, sizeof(pCache->batch));
+  memset(&pCache->resized, 0, sizeof(pCache->resized));
+  if (cencalvm::storage::CacheMonitor::AUTOSIZE == cacheSize) {
+    pCache->sizeMax =
+      cencalvm::storage::CacheMonitor::maxSize(filename, _AUTOFRACTION);
+    pCache->size =
+      (cencalvm::storage::CacheMonitor::INITIALSIZE < pCache->sizeMax) ?
+      cencalvm::storage::CacheMonitor::INITIALSIZE : pCache->sizeMax;
+    std::ostringstream msg;
+    msg << "Automatic cache of database '" << filename << "' starts at "
+	<< pCache->size << " MB (at most " << pCache->sizeMax << " MB).\n";
+    _pErrHandler->log(msg.str().c_str());
+  } else {
+    assert(cacheSize > 0);
+    pCache->sizeMax = 0;
+    pCache->size = cacheSize;
+  } // if/else
+  pCache->monitor.open(pCache->size);
+
+  return pCache;
+} // _createCache
+
+// ----------------------------------------------------------------------
+// Get statistics of cache of database.
+void
+cencalvm::query::VMQuery::_cacheStats(
+			      cencalvm::storage::CacheStatsStruct* pStats,
+			      const DBEnum db) const
+{ // _cacheStats
+  assert(0 != pStats);
+
+  const CacheStruct* pCache = (DETAILED == db) ? _pCache : _pCacheExt;
+  const cencalvm::storage::CompressedDB* pCompressed =
+    (DETAILED == db) ? _pCompressed : _pCompressedExt;
+  if (0 != pCompressed)
+    pCompressed->cacheStats(pStats);
+  else if (0 != pCache)
+    pCache->monitor.stats(pStats);
+  else
+    memset(pStats, 0, sizeof(*pStats));
+} // _cacheStats
+
+// ----------------------------------------------------------------------
+// Grow or shrink automatic cache of database after batch of queries.
+void
+cencalvm::query::VMQuery::_adjustCache(const DBEnum db)
+{ // _adjustCache
+  CacheStruct* pCache = (DETAILED == db) ? _pCache : _pCacheExt;
+  if (0 == pCache || 0 == pCache->sizeMax || !_isOpen(db))
+    return;
+
+  cencalvm::storage::CacheStatsStruct stats;
+  _cacheStats(&stats, db);
+  cencalvm::storage::CacheStatsStruct batch;
+  cencalvm::storage::CacheMonitor::difference(&batch, stats, pCache->batch);
+  std::string reason;
+  const int size = cencalvm::storage::CacheMonitor::chooseSize(&reason, stats,
+							      batch,
+							      pCache->sizeMax);
+  if (size != pCache->size) {
+    const int sizeOld = pCache->size;
+    const std::string& filename = (DETAILED == db) ? _filename : _filenameExt;
+    cencalvm::storage::CompressedDB* pCompressed =
+      (DETAILED == db) ? _pCompressed : _pCompressedExt;
+    if (0 != pCompressed)
+      pCompressed->cacheSize(size);
+    else {
+      // Etree sets the size of its buffer cache when the database is
+      // opened, so resizing discards the cache. The estimates must
+      // show a clear gain over refilling it.
+      cencalvm::storage::CacheStatsStruct sinceResize;
+      cencalvm::storage::CacheMonitor::difference(&sinceResize, stats,
+						  pCache->resized);
+      if (!cencalvm::storage::CacheMonitor::worthReopening(stats, sinceResize,
+							   size) ||
+	  !_reopenCache(db, size)) {
+	pCache->batch = stats;
+	return;
+      } // if
+    } // if/else
+    std::ostringstream msg;
+    msg << "Automatic cache of database '" << filename << "' changed from "
+	<< sizeOld << " MB to " << size << " MB: " << reason << ".\n";
+    _pErrHandler->log(msg.str().c_str());
+    pCache->size = size;
+    _cacheStats(&stats, db);
+    pCache->resized = stats;
+  } // if
+  pCache->batch = stats;
+} // _adjustCache
+
+// ----------------------------------------------------------------------
+// Reopen etree database with buffer cache of a different size.
+bool
+cencalvm::query::VMQuery::_reopenCache(const DBEnum db,
+				       const int cacheSize)
+{ // _reopenCache
+  CacheStruct* pCache = (DETAILED == db) ? _pCache : _pCacheExt;
+  etree_t** ppDB = (DETAILED == db) ? &_db : &_dbExt;
+  assert(0 != pCache);
+  assert(0 != *ppDB);
+
+  const std::string& filename = (DETAILED == db) ? _filename : _filenameExt;
+  etree_t* pDB = etree_open(filename.c_str(), O_RDONLY, cacheSize, 0, 0);
+  if (0 == pDB) {
+    std::ostringstream msg;
+    msg << "Could not reopen the etree database '" << filename
+	<< "' with a cache of " << cacheSize << " MB. Keeping the cache of "
+	<< pCache->size << " MB.\n";
+    _pErrHandler->log(msg.str().c_str());
+    return false;
+  } // if
+
+  etree_close(*ppDB);
+  *ppDB = pDB;
+  pCache->monitor.resize(cacheSize);
+  pCache->size = cacheSize;
+
+  return true;
+} // _reopenCache
+
+// ----------------------------------------------------------------------
+// Check whether database is open.
+bool
+cencalvm::query::VMQuery::_isOpen(const DBEnum db) const
+{ // _isOpen
+  return (DETAILED == db) ?
+    (0 != _db || 0 != _pCompressed || 0 != _pColumns) :
+    (0 != _dbExt || 0 != _pCompressedExt || 0 != _pColumnsExt);
+} // _isOpen
+
+// ----------------------------------------------------------------------
+// Search database for octant containing address.
+int
+cencalvm::query::VMQuery::_search(const DBEnum db,
+				  const etree_addr_t& addr,
+				  etree_addr_t* pResAddr,
+				  cencalvm::storage::PayloadStruct* pPayload)
+{ // _search
+  assert(0 != pPayload);
+
+  // Column-split databases only read the values needed.
+  cencalvm::storage::ColumnDB* pColumns =
+    (DETAILED == db) ? _pColumns : _pColumnsExt;
+  if (0 != pColumns)
+    return pColumns->search(pResAddr, pPayload, addr, _columnMask());
+
+  etree_t* pDB = (DETAILED == db) ? _db : _dbExt;
+  cencalvm::storage::CompressedDB* pCompressed =
+    (DETAILED == db) ? _pCompressed : _pCompressedExt;
+  const cencalvm::storage::PayloadCodec* pCodec =
+    (DETAILED == db) ? _pCodec : _pCodecExt;
+  const cencalvm::storage::PayloadDictionary* pDictionary =
+    (DETAILED == db) ? _pDictionary : _pDictionaryExt;
+
+  // Payload buffer large enough for full, compact, and index payloads.
+  cencalvm::storage::PayloadStruct raw;
+  void* pRaw = (0 == pCodec && 0 == pDictionary) ?
+    (void*) pPayload : (void*) &raw;
+  int err = 0;
+  if (0 != pCompressed)
+    err = pCompressed->search(pResAddr, pRaw, addr);
+  else {
+    cencalvm::storage::CacheMonitor& monitor =
+      ((DETAILED == db) ? _pCache : _pCacheExt)->monitor;
+    const bool isSampled = monitor.beginSearch();
+    err = etree_search(pDB, addr, pResAddr, "*", pRaw);
+    if (isSampled)
+      monitor.endSearch();
+  } // if/else
+  if (!err && 0 != pCodec)
+    pCodec->decode(pPayload,
+		   *(cencalvm::storage::PayloadCompactStruct*) &raw);
+  else if (!err && 0 != pDictionary) {
+    const cencalvm::storage::PayloadIndexStruct* pIndex =
+      (const cencalvm::storage::PayloadIndexStruct*) &raw;
+    err = pDictionary->lookup(pPayload, pIndex->Index);
+  } // if/else
+  return err;
+} // _search
+
+// ----------------------------------------------------------------------
+// Open compressed container.
+cencalvm::storage::CompressedDB*
+cencalvm::query::VMQuery::_openCompressed(const char* filename,
+					  const int cacheSize)
+{ // _openCompressed
+  cencalvm::storage::CompressedDB* pDB = new cencalvm::storage::CompressedDB;
+  try {
+    pDB->open(filename, cacheSize);
+  } catch (const std::exception& err) {
+    delete pDB; pDB = 0;
+    std::ostringstream msg;
+    msg << "Could not open the compressed etree database '" << filename
+	<< "' for querying.\n" << err.what();
+    _pErrHandler->error(msg.str().c_str());
+  } // try/catch
+  return pDB;
+} // _openCompressed
+
+// ----------------------------------------------------------------------
+// Open column-split database.
+cencalvm::storage::ColumnDB*
+cencalvm::query::VMQuery::_openColumns(const char* filename)
+{ // _openColumns
+  cencalvm::storage::ColumnDB* pDB = new cencalvm::storage::ColumnDB;
+  try {
+    pDB->open(filename);
+  } catch (const std::exception& err) {
+    delete pDB; pDB = 0;
+    std::ostringstream msg;
+    msg << "Could not open the column-split etree database '" << filename
+	<< "' for querying.\n" << err.what();
+    _pErrHandler->error(msg.str().c_str());
+  } // try/catch
+  return pDB;
+} // _openColumns
+
+// ----------------------------------------------------------------------
+// Open brick pyramid.
+cencalvm::storage::BrickDB*
+cencalvm::query::VMQuery::_openPyramid(const char* filename)
+{ // _openPyramid
+  cencalvm::storage::BrickDB* pDB = new cencalvm::storage::BrickDB;
+  try {
+    pDB->open(filename);
+  } catch (const std::exception& err) {
+    delete pDB; pDB = 0;
+    std::ostringstream msg;
+    msg << "Could not open the brick pyramid '" << filename
+	<< "' for querying.\n" << err.what();
+    _pErrHandler->error(msg.str().c_str());
+  } // try/catch
+  return pDB;
+} // _openPyramid
+
+// ----------------------------------------------------------------------
+// Get mask of payload fields needed for queries.
+int
+cencalvm::query::VMQuery::_columnMask(void) const
+{ // _columnMask
+  // Fault block identifies octants without data.
+  const int faultBlock = 1 << 6;
+  // Elevation of ground surface is computed from DepthFreeSurf and
+  // requires Vs to detect octants without data.
+  const int elevation = (1 << 1) | (1 << 5);
+
+  int mask = faultBlock;
+  for (int i=0; i < _querySize; ++i)
+    mask |= (8 == _pQueryVals[i]) ? elevation : (1 << _pQueryVals[i]);
+  if (_squashTopo)
+    mask |= elevation;
+  if (&cencalvm::query::VMQuery::_queryWave == _queryFn)
+    mask |= 1 << 1; // Resolution depends on Vs
+
+  return mask;
+} // _columnMask
+
+// ----------------------------------------------------------------------
+// Get schema and application metadata of database.
+void
+cencalvm::query::VMQuery::_metadata(std::string* pSchema,
+				    std::string* pAppmeta,
+				    const DBEnum db) const
+{ // _metadata
+  assert(0 != pSchema);
+  assert(0 != pAppmeta);
+
+  etree_t* pDB = (DETAILED == db) ? _db : _dbExt;
+  const cencalvm::storage::CompressedDB* pCompressed =
+    (DETAILED == db) ? _pCompressed : _pCompressedExt;
+  const cencalvm::storage::ColumnDB* pColumns =
+    (DETAILED == db) ? _pColumns : _pColumnsExt;
+
+  *pSchema = "";
+  *pAppmeta = "";
+  if (0 != pColumns) {
+    *pSchema = pColumns->schema();
+    *pAppmeta = pColumns->appmeta();
+  } else if (0 != pCompressed) {
+    *pSchema = pCompressed->schema();
+    *pAppmeta = pCompressed->appmeta();
+  } else {
+    char* value = etree_getschema(pDB);
+    if (0 != value)
+      *pSchema = value;
+    free(value);
+    value = etree_getappmeta(pDB);
+    if (0 != value)
+      *pAppmeta = value;
+    free(value);
+  } // if/else
+} // _metadata
+
+// ----------------------------------------------------------------------
+// Set up decoding of payload if database uses compact payloads.
+cencalvm::storage::PayloadCodec*
+cencalvm::query::VMQuery::_createCodec(const DBEnum db,
+				       const char* filename)
+{ // _createCodec
+  if (!_isOpen(db))
+    return 0;
+
+  std::string schema;
+  std::string appmeta;
+  _metadata(&schema, &appmeta, db);
+  if (schema != cencalvm::storage::Payload::SCHEMACOMPACT)
+    return 0;
+
+  cencalvm::storage::PayloadCodec* pCodec = 
+    new cencalvm::storage::PayloadCodec;
+  try {
+    pCodec->parseMetadata(appmeta.c_str());
+  } catch (const std::exception& err) {
+    delete pCodec; pCodec = 0;
+    std::ostringstream msg;
+    msg << "Could not set up decoding of compact etree database '"
+	<< filename << "'.\n" << err.what();
+    _pErrHandler->error(msg.str().c_str());
+  } // try/catch
+
+  return pCodec;
+} // _createCodec
+
+// ----------------------------------------------------------------------
+// Read dictionary of payloads if database is dictionary-encoded.
+cencalvm::storage::PayloadDictionary*
+cencalvm::query::VMQuery::_createDictionary(const DBEnum db,
+					    const char* filename)
+{ // _createDictionary
+  if (!_isOpen(db))
+    return 0;
+
+  std::string schema;
+  std::string appmeta;
+  _metadata(&schema, &appmeta, db);
+  if (schema != cencalvm::storage::Payload::SCHEMAINDEX)
+    return 0;
+
+  // Dictionary is kept in memory, so looking up payloads does not
+  // require reading from disk.
+  cencalvm::storage::PayloadDictionary* pDictionary =
+    new cencalvm::storage::PayloadDictionary;
+  const std::string filenameDict =
+    cencalvm::storage::PayloadDictionary::find(filename, appmeta.c_str());
+  try {
+    pDictionary->read(filenameDict.c_str());
+  } catch (const std::exception& err) {
+    delete pDictionary; pDictionary = 0;
+    std::ostringstream msg;
+    msg << "Could not read dictionary of dictionary-encoded etree database '"
+	<< filename << "'.\n" << err.what();
+    _pErrHandler->error(msg.str().c_str());
+  } // try/catch
+
+  return pDictionary;
+} // _createDictionary
+
+// ----------------------------------------------------------------------
+// Record query in trace.
+void
+cencalvm::query::VMQuery::_trace(const double lon,
+				 const double lat,
+				 const double elev)
+{ // _trace
+  assert(0 != _pTrace);
+  assert(0 != _pTraceState);
+
+  _pTraceState->queryType = _queryType;
+  _pTraceState->squash = (_squashTopo) ? 1 : 0;
+  _pTraceState->queryRes = _queryRes;
+  _pTraceState->squashLimit = _squashLimit;
+  _pTraceState->vals.assign(_pQueryVals, _pQueryVals+_querySize);
+  try {
+    _pTrace->write(*_pTraceState, lon, lat, elev);
+  } catch (const std::exception& err) {
+    _pErrHandler->error(err.what());
+  } // try/catch
+} // _trace
+
 // ----------------------------------------------------------------------
 // Set payload to NODATA values.
 void
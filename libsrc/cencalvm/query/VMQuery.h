@@ -43,6 +43,9 @@
 #define cencalvm_query_vmquery_h
 
 #include "cencalvm/storage/etreefwd.h" // USES etree_t
+#include "cencalvm/storage/CacheMonitor.h" // USES CacheMonitor::AUTOSIZE
+
+#include <stddef.h> // USES size_t
 
 #include <string> // USES std::string
 
@@ -50,10 +53,17 @@ namespace cencalvm {
   namespace query {
     class VMQuery;
     class TestVMQuery; // friend
+    class QueryTrace; // HOLDSA QueryTrace
+    struct QueryTraceStateStruct; // HOLDSA QueryTraceStateStruct
   } // query
   namespace storage {
     class Geometry; // HOLDSA geometry
     class ErrorHandler; // HOLDSA ErrorHandler
+    class PayloadCodec; // HOLDSA PayloadCodec
+    class PayloadDictionary; // HOLDSA PayloadDictionary
+    class CompressedDB; // HOLDSA CompressedDB
+    class ColumnDB; // HOLDSA ColumnDB
+    class BrickDB; // HOLDSA BrickDB
     struct PayloadStruct; // USES PayloadStruct
   } // storage
 } // cencalvm
@@ -132,6 +142,14 @@ class cencalvm::query::VMQuery
 		 const int numVals);
 
   /** Set the database filename.
+   *
+   * The database may be an etree database, a compressed container
+   * created with cencalvmcompress (storage::CompressedDB), or a
+   * column-split database created with cencalvmcolumnize
+   * (storage::ColumnDB); the type is detected when the database is
+   * opened. Queries of column-split databases read only the values
+   * requested with queryVals() and the values needed to perform the
+   * query.
    *
    * @param filename Name of database file
    */
@@ -143,18 +161,68 @@ class cencalvm::query::VMQuery
    */
   void filenameExt(const char* filename);
 
+  /** Set the filename of the brick pyramid (created with
+   * cencalvmpyramid) of the database. Fixed resolution queries at
+   * levels in the pyramid are answered from the pyramid instead of
+   * searching the database.
+   *
+   * @param filename Name of brick pyramid file
+   */
+  void filenamePyramid(const char* filename);
+
+  /** Set the filename of the brick pyramid of the database for the
+   * extended model.
+   *
+   * @param filename Name of brick pyramid file for the extended model
+   */
+  void filenamePyramidExt(const char* filename);
+
   /** Set size of cache during queries.
    *
-   * @param size Size of cache in MB
+   * With storage::CacheMonitor::AUTOSIZE the cache is sized from the
+   * available memory and the size of the database when the database
+   * is opened, and grown or shrunk between batches of queries depending
+   * on the misses and working set observed (see
+   * storage::CacheMonitor). Each decision is written to the log.
+   *
+   * @param size Size of cache in MB or storage::CacheMonitor::AUTOSIZE
    */
   void cacheSize(const int size);
 
   /** Set size of cache during queries in the extended model.
    *
-   * @param size Size of cache in MB for the extended model
+   * @param size Size of cache in MB for the extended model or
+   * storage::CacheMonitor::AUTOSIZE
    */
   void cacheSizeExt(const int size);
 
+  /** Get statistics of cache of the database since it was opened.
+   *
+   * Counts for etree databases are estimated by sampling (see
+   * storage::CacheMonitor); counts for compressed containers are
+   * exact. Column-split databases have no cache, so counts are zero.
+   *
+   * @param pStats Pointer to statistics
+   */
+  void cacheStats(cencalvm::storage::CacheStatsStruct* pStats) const;
+
+  /** Get statistics of cache of the database for the extended model
+   * since it was opened.
+   *
+   * @param pStats Pointer to statistics
+   */
+  void cacheStatsExt(cencalvm::storage::CacheStatsStruct* pStats) const;
+
+  /** Set the filename of the trace of queries. When set, every
+   * query between open() and close() is recorded (location, query
+   * type, resolution, values returned, and time) in a binary trace
+   * that can be replayed with cencalvmreplay (see QueryTrace). The
+   * trace is created when the database is opened.
+   *
+   * @param filename Name of trace file ("" for no trace)
+   */
+  void filenameTrace(const char* filename);
+
   /** Set squashed topography/bathymetry flag and minimum elevation of
    * squashing. Squashing is turned off by default.
    *
@@ -195,6 +263,20 @@ class cencalvm::query::VMQuery
    */
   cencalvm::storage::ErrorHandler* errorHandler(void);
 
+private :
+  // PRIVATE ENUMS //////////////////////////////////////////////////////
+
+  /// Databases that can be queried
+  enum DBEnum {
+    DETAILED=0, ///< Detailed model
+    EXTENDED=1 ///< Extended (regional) model
+  }; // DBEnum
+
+private :
+  // PRIVATE STRUCTS ////////////////////////////////////////////////////
+
+  struct CacheStruct; ///< Cache of database
+
 private :
   // PRIVATE METHODS ////////////////////////////////////////////////////
 
@@ -212,7 +294,7 @@ private :
    */
   void _queryMax(cencalvm::storage::PayloadStruct*,
 		 etree_addr_t* pAddr,
-		 etree_t* pDB,
+		 const DBEnum db,
 		 const double lon,
 		 const double lat,
 		 const double elev,
@@ -233,7 +315,7 @@ private :
    */
   void _queryFixed(cencalvm::storage::PayloadStruct*,
 		   etree_addr_t* pAddr,
-		   etree_t* pDB,
+		   const DBEnum db,
 		   const double lon,
 		   const double lat,
 		   const double elev,
@@ -254,7 +336,7 @@ private :
    */
   void _queryWave(cencalvm::storage::PayloadStruct*,
 		  etree_addr_t* pAddr,
-		  etree_t* pDB,
+		  const DBEnum db,
 		  const double lon,
 		  const double lat,
 		  const double elev,
@@ -276,6 +358,145 @@ private :
 		    const double elev,
 		    const bool allowAdjustment=false);
 
+  /** Search database for octant containing address.
+   *
+   * Payloads of compact databases are restored to full payloads.
+   *
+   * @param pDB Database to search
+   * @param addr Etree address to search for
+   * @param pResAddr Pointer to Etree address of octant found
+   * @param pPayload Pointer to database payload
+   *
+   * @returns 0 if octant found, nonzero otherwise
+   */
+  int _search(const DBEnum db,
+	      const etree_addr_t& addr,
+	      etree_addr_t* pResAddr,
+	      cencalvm::storage::PayloadStruct* pPayload);
+
+  /** Create cache of database, choosing initial size of automatic
+   * cache.
+   *
+   * @param filename Name of database file
+   * @param cacheSize Size of cache in MB or storage::CacheMonitor::AUTOSIZE
+   *
+   * @returns Cache of database
+   */
+  CacheStruct* _createCache(const char* filename,
+			    const int cacheSize);
+
+  /** Get statistics of cache of database.
+   *
+   * @param pStats Pointer to statistics
+   * @param db Database
+   */
+  void _cacheStats(cencalvm::storage::CacheStatsStruct* pStats,
+		   const DBEnum db) const;
+
+  /** Grow or shrink automatic cache of database after batch of
+   * queries.
+   *
+   * @param db Database
+   */
+  void _adjustCache(const DBEnum db);
+
+  /** Reopen etree database with a buffer cache of a different size.
+   *
+   * The new database is opened before the old one is closed, so the
+   * old database and cache are kept if the database cannot be
+   * reopened.
+   *
+   * @param db Database
+   * @param cacheSize Size of cache in MB
+   *
+   * @returns True if database was reopened, false otherwise
+   */
+  bool _reopenCache(const DBEnum db,
+		    const int cacheSize);
+
+  /** Check whether database is open.
+   *
+   * @param db Database
+   *
+   * @returns True if database is open as an etree database or a
+   *   compressed container, false otherwise
+   */
+  bool _isOpen(const DBEnum db) const;
+
+  /** Open compressed container.
+   *
+   * @param filename Name of database file
+   * @param cacheSize Size of cache of decompressed blocks in MB
+   *
+   * @returns Pointer to compressed container (0 if open failed)
+   */
+  cencalvm::storage::CompressedDB* _openCompressed(const char* filename,
+						   const int cacheSize);
+
+  /** Open column-split database.
+   *
+   * @param filename Name of key file of database
+   *
+   * @returns Pointer to column-split database (0 if open failed)
+   */
+  cencalvm::storage::ColumnDB* _openColumns(const char* filename);
+
+  /** Open brick pyramid.
+   *
+   * @param filename Name of brick pyramid file
+   *
+   * @returns Pointer to brick pyramid (0 if open failed)
+   */
+  cencalvm::storage::BrickDB* _openPyramid(const char* filename);
+
+  /** Get mask of payload fields needed for queries (bit i corresponds
+   * to field i in PayloadStruct). Depends on values requested, query
+   * type, and squashing.
+   *
+   * @returns Mask of payload fields
+   */
+  int _columnMask(void) const;
+
+  /** Get schema and application metadata of database.
+   *
+   * @param pSchema Pointer to schema
+   * @param pAppmeta Pointer to application metadata
+   * @param db Database
+   */
+  void _metadata(std::string* pSchema,
+		 std::string* pAppmeta,
+		 const DBEnum db) const;
+
+  /** Set up decoding of payload if database uses compact payloads.
+   *
+   * @param db Database
+   * @param filename Name of database file
+   *
+   * @returns Pointer to codec (0 if database uses full payloads)
+   */
+  cencalvm::storage::PayloadCodec* _createCodec(const DBEnum db,
+						const char* filename);
+
+  /** Read dictionary of payloads if database is dictionary-encoded.
+   *
+   * @param db Database
+   * @param filename Name of database file
+   *
+   * @returns Pointer to dictionary (0 if database holds payloads)
+   */
+  cencalvm::storage::PayloadDictionary* _createDictionary(const DBEnum db,
+							  const char* filename);
+
+  /** Record query in trace.
+   *
+   * @param lon Longitude of location for query in degrees
+   * @param lat Latitude of location for query in degrees
+   * @param elev Elevation of location wrt MSL in meters
+   */
+  void _trace(const double lon,
+	      const double lat,
+	      const double elev);
+
   /** Set payload to NODATA values.
    *
    * @param payload Pointer to database payload
@@ -292,7 +513,7 @@ private :
  // PRIVATE TYPEDEFS ///////////////////////////////////////////////////
   
   typedef void (cencalvm::query::VMQuery::*queryFn_t)
-    (cencalvm::storage::PayloadStruct*, etree_addr_t*, etree_t*, 
+    (cencalvm::storage::PayloadStruct*, etree_addr_t*, const DBEnum,
      double, double, double, bool);
 
 private :
@@ -304,6 +525,33 @@ private :
   etree_t* _db; ///< Database for detailed model
   etree_t* _dbExt; ///< Database for extended model
 
+  /// Compressed container for detailed model (0 if etree database)
+  cencalvm::storage::CompressedDB* _pCompressed;
+  /// Compressed container for extended model (0 if etree database)
+  cencalvm::storage::CompressedDB* _pCompressedExt;
+  /// Cache of detailed model (0 if column-split database)
+  CacheStruct* _pCache;
+  /// Cache of extended model (0 if column-split database)
+  CacheStruct* _pCacheExt;
+  /// Column-split database for detailed model (0 if etree database)
+  cencalvm::storage::ColumnDB* _pColumns;
+  /// Column-split database for extended model (0 if etree database)
+  cencalvm::storage::ColumnDB* _pColumnsExt;
+  /// Brick pyramid for detailed model (0 if no pyramid)
+  cencalvm::storage::BrickDB* _pPyramid;
+  /// Brick pyramid for extended model (0 if no pyramid)
+  cencalvm::storage::BrickDB* _pPyramidExt;
+
+  /// Decoder for compact payloads of detailed model (0 if full payloads)
+  cencalvm::storage::PayloadCodec* _pCodec;
+  /// Decoder for compact payloads of extended model (0 if full payloads)
+  cencalvm::storage::PayloadCodec* _pCodecExt;
+
+  /// Dictionary of payloads of detailed model (0 if not dictionary-encoded)
+  cencalvm::storage::PayloadDictionary* _pDictionary;
+  /// Dictionary of payloads of extended model (0 if not dictionary-encoded)
+  cencalvm::storage::PayloadDictionary* _pDictionaryExt;
+
   int* _pQueryVals; ///< Address offsets in payload for query values
 
   cencalvm::storage::Geometry* _pGeom; ///< Velocity model geometry
@@ -311,15 +559,26 @@ private :
 
   std::string _filename; ///< Name of database file for detailed model
   std::string _filenameExt; ///< Name of database file for extended model
+  std::string _filenamePyramid; ///< Name of pyramid for detailed model
+  std::string _filenamePyramidExt; ///< Name of pyramid for extended model
+  std::string _filenameTrace; ///< Name of trace of queries
+
+  QueryTrace* _pTrace; ///< Trace of queries (0 if not tracing)
+  QueryTraceStateStruct* _pTraceState; ///< State of queries for trace
 
   queryFn_t _queryFn; ///< Method to call for queries
+  QueryEnum _queryType; ///< Type of query
 
+  size_t _numQueries; ///< Number of queries since database was opened
   int _querySize; ///< Number of values requested to be return in queries
   int _cacheSize; ///< Size of query cache for detailed model
   int _cacheSizeExt; ///< Size of query cache for extended model
 
   bool _squashTopo; ///< True if squashing topography
 
+  static const int _AUTOBATCH; ///< Number of queries between resizing caches
+  static const double _AUTOFRACTION; ///< Fraction of memory for each cache
+
 }; // class VMQuery 
 
 #include "VMQuery.icc" // inline methods
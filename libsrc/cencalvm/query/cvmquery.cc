@@ -213,6 +213,25 @@ cencalvm_cacheSizeExt(void* handle,
   return pErrHandler->status();
 } // cacheSizeExt
 
+// ----------------------------------------------------------------------
+// Set the filename of the trace of queries.
+int
+cencalvm_filenameTrace(void* handle,
+		       const char* filename)
+{ // filenameTrace
+  if (0 == handle) {
+    std::cerr << "Null handle for query manager in call to filenameTrace()."
+	      << std::endl;
+    return cencalvm::storage::ErrorHandler::ERROR;
+  } // if
+
+  cencalvm::query::VMQuery* pQuery = (cencalvm::query::VMQuery*) handle;
+  pQuery->filenameTrace(filename);
+
+  const cencalvm::storage::ErrorHandler* pErrHandler = pQuery->errorHandler();
+  return pErrHandler->status();
+} // filenameTrace
+
 // ----------------------------------------------------------------------
 // Set squashed topography/bathymetry flag and minimum elevation of
 // squashing. Squashing is turned off by default.
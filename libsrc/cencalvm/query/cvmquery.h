@@ -146,7 +146,8 @@ int cencalvm_filename(void* handle,
 /** Set size of cache during queries.
  *
  * @param handle Pointer to query
- * @param size Size of cache in MB
+ * @param size Size of cache in MB (-1 to size the cache automatically
+ *   from the available memory and the queries)
  *
  * @returns Status of error handler
  */
@@ -166,13 +167,25 @@ int cencalvm_filenameExt(void* handle,
 /** Set size of cache during queries of extended database.
  *
  * @param handle Pointer to query
- * @param size Size of cache in MB
+ * @param size Size of cache in MB (-1 for automatic sizing)
  *
  * @returns Status of error handler
  */
 int cencalvm_cacheSizeExt(void* handle,
 			  const int size);
 
+/** Set the filename of the trace of queries. Every query between
+ * cencalvm_open() and cencalvm_close() is recorded in the trace,
+ * which can be replayed with cencalvmreplay.
+ *
+ * @param handle Pointer to query
+ * @param filename Name of trace file ("" for no trace)
+ *
+ * @returns Status of error handler
+ */
+int cencalvm_filenameTrace(void* handle,
+			   const char* filename);
+
 /** Set squashed topography/bathymetry flag and minimum elevation of
  * squashing. Squashing is turned off by default.
  *
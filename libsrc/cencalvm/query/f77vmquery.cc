@@ -151,6 +151,24 @@ cencalvm_cachesizeext_f(size_t* handleAddr,
   *err = cencalvm_cacheSizeExt((void*) *handleAddr, *size);
 } // cacheSizeExt
 
+// ----------------------------------------------------------------------
+// Set the filename of the trace of queries.
+void
+cencalvm_filenametrace_f(size_t* handleAddr,
+			 const char* filename,
+			 int* err,
+			 const int len)
+{ // filenameTrace
+  assert(0 != err);
+  assert(0 != filename);
+  assert(len > 0);
+
+  std::istringstream sin(filename);
+  std::string cfilename;
+  sin >> cfilename;
+  *err = cencalvm_filenameTrace((void*) *handleAddr, cfilename.c_str());
+} // filenameTrace
+
 // ----------------------------------------------------------------------
 // Set squashed topography/bathymetry flag and minimum elevation of
 // squashing. Squashing is turned off by default.
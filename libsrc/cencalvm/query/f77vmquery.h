@@ -211,6 +211,23 @@ void cencalvm_cachesizeext_f(size_t* handleAddr,
 			     const int* size,
 			     int* err);
 
+// ----------------------------------------------------------------------
+/** Fortran name mangling */
+#define cencalvm_filenametrace_f \
+  FC_FUNC_(cencalvm_filenametrace_f, CENCALVM_FILENAMETRACE_F)
+/** Set the filename of the trace of queries.
+ *
+ * @param handleAddr Address of handle to VMQuery object
+ * @param filename Name of trace file
+ * @param len Length of string (IMPLICIT IN FORTRAN)
+ * @param err Set to status of error handler
+ */
+extern "C"
+void cencalvm_filenametrace_f(size_t* handleAddr,
+			      const char* filename,
+			      int* err,
+			      const int len);
+
 // ----------------------------------------------------------------------
 /** Fortran name mangling */
 #define cencalvm_squash_f \
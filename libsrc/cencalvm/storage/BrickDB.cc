@@ -0,0 +1,227 @@
+// -*- C++ -*-
+//
+// ======================================================================
+//
+//                           Brad T. Aagaard
+//                        U.S. Geological Survey
+//
+// {LicenseText}
+//
+// ======================================================================
+//
+
+#include "BrickDB.h" // implementation of class methods
+
+#include "Payload.h" // USES PayloadStruct
+
+extern "C" {
+#include "etree.h"
+}
+
+#include <sys/mman.h> // USES mmap(), munmap()
+#include <sys/stat.h> // USES fstat()
+#include <fcntl.h> // USES open()
+#include <unistd.h> // USES close()
+#include <string.h> // USES memcmp(), memcpy(), memset()
+
+#include <stdexcept> // USES std::runtime_error
+#include <sstream> // USES std::ostringstream
+#include <assert.h> // USES assert()
+
+// ----------------------------------------------------------------------
+const char* cencalvm::storage::BrickDB::MAGIC = "CVMBRCK";
+const int32_t cencalvm::storage::BrickDB::VERSION = 1;
+const int32_t cencalvm::storage::BrickDB::BYTEORDER = 0x01020304;
+const int cencalvm::storage::BrickDB::BRICKSIZE = 16;
+const int cencalvm::storage::BrickDB::ALIGNMENT = 32;
+const int cencalvm::storage::BrickDB::MAXLEVEL = 25;
+
+// ----------------------------------------------------------------------
+// Constructor
+cencalvm::storage::BrickDB::BrickDB(void) :
+  _filename(""),
+  _pFile(0),
+  _fileSize(0),
+  _pLevels(0)
+{ // constructor
+  memset(&_header, 0, sizeof(_header));
+  for (int i=0; i < 32; ++i)
+    _levelIndex[i] = -1;
+} // constructor
+
+// ----------------------------------------------------------------------
+// Destructor
+cencalvm::storage::BrickDB::~BrickDB(void)
+{ // destructor
+  close();
+} // destructor
+
+// ----------------------------------------------------------------------
+// Open brick pyramid for querying.
+void
+cencalvm::storage::BrickDB::open(const char* filename)
+{ // open
+  assert(0 != filename);
+
+  close();
+  _filename = filename;
+  _pFile = _mapFile(&_fileSize, filename);
+
+  std::ostringstream msg;
+  if (_fileSize < sizeof(_header) ||
+      0 != memcmp(_pFile, MAGIC, sizeof(_header.magic)))
+    msg << "File '" << filename << "' is not a brick pyramid.";
+  else {
+    memcpy(&_header, _pFile, sizeof(_header));
+    if (BYTEORDER != _header.byteOrder)
+      msg << "Brick pyramid '" << filename << "' was written on a machine "
+	  << "with a different byte order.";
+    else if (VERSION != _header.version)
+      msg << "Unknown version " << _header.version << " of brick pyramid '"
+	  << filename << "'. Expected version " << VERSION << ".";
+    else if (BRICKSIZE != _header.brickSize ||
+	     _header.numLevels < 0 || _header.numLevels > MAXLEVEL+1 ||
+	     _fileSize < sizeof(_header) +
+	     _header.numLevels*sizeof(BrickDBLevelStruct))
+      msg << "Bad header in brick pyramid '" << filename << "'.";
+  } // else
+  if (0 == msg.str().length()) {
+    _pLevels = (const BrickDBLevelStruct*)((const char*) _pFile +
+					   sizeof(_header));
+
+    // Check levels and tables of bricks so that searches stay within
+    // the mapped file.
+    const int64_t brickBytes =
+      BRICKSIZE*BRICKSIZE*BRICKSIZE*sizeof(PayloadStruct);
+    for (int iLevel=0; iLevel < _header.numLevels; ++iLevel) {
+      const BrickDBLevelStruct& info = _pLevels[iLevel];
+      int64_t tableSize = 1;
+      for (int i=0; i < 3; ++i)
+	tableSize *= (info.dims[i] > 0) ? info.dims[i] : 0;
+      bool isBad = (info.level < 0 || info.level > MAXLEVEL ||
+		    _levelIndex[info.level] >= 0 ||
+		    info.tableOffset < 0 ||
+		    0 != info.tableOffset % sizeof(int64_t) ||
+		    info.tableOffset + tableSize*int64_t(sizeof(int64_t)) >
+		    int64_t(_fileSize));
+      for (int i=0; i < 3 && !isBad; ++i)
+	isBad = info.origin[i] < 0 || info.dims[i] < 0;
+      const int64_t* pTable = (const int64_t*)((const char*) _pFile +
+					       info.tableOffset);
+      for (int64_t iBrick=0; iBrick < tableSize && !isBad; ++iBrick)
+	isBad = pTable[iBrick] >= 0 &&
+	  (0 != pTable[iBrick] % ALIGNMENT ||
+	   pTable[iBrick] + brickBytes > int64_t(_fileSize));
+      if (isBad) {
+	msg << "Bad description of level " << info.level
+	    << " in brick pyramid '" << filename << "'.";
+	break;
+      } // if
+      _levelIndex[info.level] = iLevel;
+    } // for
+  } // if
+  if (msg.str().length() > 0) {
+    close();
+    throw std::runtime_error(msg.str());
+  } // if
+} // open
+
+// ----------------------------------------------------------------------
+// Close brick pyramid.
+void
+cencalvm::storage::BrickDB::close(void)
+{ // close
+  if (0 != _pFile)
+    munmap(_pFile, _fileSize);
+  _pFile = 0;
+  _fileSize = 0;
+  _pLevels = 0;
+  memset(&_header, 0, sizeof(_header));
+  for (int i=0; i < 32; ++i)
+    _levelIndex[i] = -1;
+} // close
+
+// ----------------------------------------------------------------------
+// Get payload of cell containing address at the level of the address.
+int
+cencalvm::storage::BrickDB::search(PayloadStruct* pPayload,
+				   const etree_addr_t& addr) const
+{ // search
+  assert(0 != pPayload);
+
+  if (!hasLevel(addr.level))
+    return -1;
+
+  const BrickDBLevelStruct& info = _pLevels[_levelIndex[addr.level]];
+
+  // Cell and brick indices follow directly from the address.
+  const int shift = ETREE_MAXLEVEL - addr.level;
+  const etree_tick_t cell[3] = {
+    addr.x >> shift, addr.y >> shift, addr.z >> shift };
+  int64_t iBrick = 0;
+  int iCell = 0;
+  for (int i=2; i >= 0; --i) {
+    const int64_t index = cell[i] / BRICKSIZE - info.origin[i];
+    if (index < 0 || index >= info.dims[i]) {
+      iBrick = -1;
+      break;
+    } // if
+    iBrick = iBrick*info.dims[i] + index;
+    iCell = iCell*BRICKSIZE + cell[i] % BRICKSIZE;
+  } // for
+
+  const char* pData = (const char*) _pFile;
+  const int64_t offset = (iBrick < 0) ? -1 :
+    ((const int64_t*)(pData + info.tableOffset))[iBrick];
+  if (offset < 0) {
+    pPayload->Vp = Payload::NODATAVAL;
+    pPayload->Vs = Payload::NODATAVAL;
+    pPayload->Density = Payload::NODATAVAL;
+    pPayload->Qp = Payload::NODATAVAL;
+    pPayload->Qs = Payload::NODATAVAL;
+    pPayload->DepthFreeSurf = Payload::NODATAVAL;
+    pPayload->FaultBlock = Payload::NODATABLOCK;
+    pPayload->Zone = Payload::NODATAZONE;
+  } else
+    *pPayload = ((const PayloadStruct*)(pData + offset))[iCell];
+
+  return 0;
+} // search
+
+// ----------------------------------------------------------------------
+// Map file into memory.
+void*
+cencalvm::storage::BrickDB::_mapFile(size_t* pSize,
+				     const char* filename)
+{ // _mapFile
+  assert(0 != pSize);
+  assert(0 != filename);
+
+  const int fd = ::open(filename, O_RDONLY);
+  struct stat info;
+  if (fd < 0 || 0 != fstat(fd, &info)) {
+    if (fd >= 0)
+      ::close(fd);
+    std::ostringstream msg;
+    msg << "Could not open brick pyramid '" << filename
+	<< "' for querying.";
+    throw std::runtime_error(msg.str());
+  } // if
+  *pSize = info.st_size;
+  void* pData = 0;
+  if (*pSize > 0) {
+    pData = mmap(0, *pSize, PROT_READ, MAP_SHARED, fd, 0);
+    if (MAP_FAILED == pData)
+      pData = 0;
+  } // if
+  ::close(fd);
+  if (0 == pData && *pSize > 0) {
+    std::ostringstream msg;
+    msg << "Could not map brick pyramid '" << filename << "' into memory.";
+    throw std::runtime_error(msg.str());
+  } // if
+
+  return pData;
+} // _mapFile
+
+// End of file
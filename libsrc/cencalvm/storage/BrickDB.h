@@ -0,0 +1,180 @@
+// -*- C++ -*-
+//
+// ======================================================================
+//
+//                           Brad T. Aagaard
+//                        U.S. Geological Survey
+//
+// {LicenseText}
+//
+// ======================================================================
+//
+
+/** @file libsrc/storage/BrickDB.h
+ *
+ * @brief C++ manager of read-only multi-resolution brick pyramids of
+ * etree databases.
+ *
+ * A pyramid holds the results of fixed resolution queries at a set of
+ * levels. At each level the octants form a uniform grid, which is
+ * stored as dense bricks of BRICKSIZE x BRICKSIZE x BRICKSIZE cells.
+ * A cell holds the payload of the octant at the level of the cell or
+ * of the leaf octant at a coarser level that contains it; cells
+ * without such an octant hold NODATA values. Bricks without any data
+ * are not stored.
+ *
+ * The file starts with a BrickDBHeaderStruct followed by one
+ * BrickDBLevelStruct per level. The table of bricks for each level
+ * covers the bounding box of the bricks with data and holds the file
+ * offset of each brick (-1 for empty bricks). Bricks start at
+ * multiples of ALIGNMENT bytes and the cells are stored with x
+ * varying fastest, so neighboring cells are contiguous in memory.
+ * Values are stored in the byte order of the machine that wrote the
+ * file.
+ */
+
+#if !defined(cencalvm_storage_brickdb_h)
+#define cencalvm_storage_brickdb_h
+
+#include "etreefwd.h" // USES etree_addr_t
+
+#include <inttypes.h> // USES int32_t, int64_t
+#include <stddef.h> // USES size_t
+#include <string> // HASA std::string
+
+namespace cencalvm {
+  namespace storage {
+    struct BrickDBHeaderStruct;
+    struct BrickDBLevelStruct;
+    struct PayloadStruct; // USES PayloadStruct
+    class BrickDB;
+    class TestBrickDB; // friend
+  } // namespace storage
+} // namespace cencalvm
+
+/// Header of brick pyramid.
+struct cencalvm::storage::BrickDBHeaderStruct {
+  char magic[8]; ///< File identifier (BrickDB::MAGIC)
+  int32_t version; ///< Version of file format
+  int32_t byteOrder; ///< Byte order mark (BrickDB::BYTEORDER)
+  int32_t brickSize; ///< Number of cells along each edge of brick
+  int32_t numLevels; ///< Number of levels in pyramid
+}; // BrickDBHeaderStruct
+
+/// Description of level in brick pyramid.
+struct cencalvm::storage::BrickDBLevelStruct {
+  int32_t level; ///< Octant level
+  int32_t numBricks; ///< Number of bricks with data
+  int32_t origin[3]; ///< Index of first brick in table along x, y, z
+  int32_t dims[3]; ///< Number of bricks in table along x, y, z
+  int64_t tableOffset; ///< Offset of table of bricks in file
+}; // BrickDBLevelStruct
+
+/// C++ manager of read-only multi-resolution brick pyramids of etree
+/// databases.
+class cencalvm::storage::BrickDB
+{ // BrickDB
+  friend class TestBrickDB; // unit testing
+
+public :
+  // PUBLIC MEMBERS /////////////////////////////////////////////////////
+
+  static const char* MAGIC; ///< File identifier
+  static const int32_t VERSION; ///< Current version of file format
+  static const int32_t BYTEORDER; ///< Byte order mark
+
+  /// Number of cells along each edge of brick
+  static const int BRICKSIZE;
+
+  /// Alignment of bricks in file in bytes
+  static const int ALIGNMENT;
+
+  /// Finest level allowed in pyramid
+  static const int MAXLEVEL;
+
+public :
+  // PUBLIC METHODS /////////////////////////////////////////////////////
+
+  /// Constructor
+  BrickDB(void);
+
+  /// Destructor
+  ~BrickDB(void);
+
+  /** Open brick pyramid for querying.
+   *
+   * @param filename Name of file
+   */
+  void open(const char* filename);
+
+  /// Close brick pyramid.
+  void close(void);
+
+  /** Check whether pyramid contains level.
+   *
+   * @param level Octant level
+   *
+   * @returns True if pyramid contains level, false otherwise
+   */
+  bool hasLevel(const int level) const;
+
+  /** Get payload of cell containing address at the level of the
+   * address.
+   *
+   * The payload matches the result of a fixed resolution query at
+   * the level of the address; cells without data give NODATA values.
+   *
+   * @param pPayload Pointer to payload of cell
+   * @param addr Address
+   *
+   * @returns 0 if pyramid contains level of address, nonzero otherwise
+   */
+  int search(PayloadStruct* pPayload,
+	     const etree_addr_t& addr) const;
+
+  /** Get number of levels in pyramid.
+   *
+   * @returns Number of levels
+   */
+  int numLevels(void) const;
+
+private :
+  // PRIVATE METHODS ////////////////////////////////////////////////////
+
+  /** Map file into memory.
+   *
+   * @param pSize Pointer to size of file
+   * @param filename Name of file
+   *
+   * @returns Pointer to mapped file
+   */
+  static void* _mapFile(size_t* pSize,
+			const char* filename);
+
+private :
+  // NOT IMPLEMENTED ////////////////////////////////////////////////////
+
+  BrickDB(const BrickDB& d); ///< Not implemented
+  const BrickDB& operator=(const BrickDB& d); ///< Not implemented
+
+private :
+  // PRIVATE MEMBERS ////////////////////////////////////////////////////
+
+  BrickDBHeaderStruct _header; ///< Header of pyramid
+
+  std::string _filename; ///< Name of file
+
+  void* _pFile; ///< Mapped file
+  size_t _fileSize; ///< Size of file
+  const BrickDBLevelStruct* _pLevels; ///< Array of levels in mapped file
+
+  /// Index of level in array of levels (-1 if level is not in pyramid)
+  int _levelIndex[32];
+
+}; // BrickDB
+
+#include "BrickDB.icc" // inline methods
+
+#endif // cencalvm_storage_brickdb_h
+
+// End of file
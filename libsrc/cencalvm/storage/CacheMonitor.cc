@@ -0,0 +1,322 @@
+// -*- C++ -*-
+//
+// ======================================================================
+//
+//                           Brad T. Aagaard
+//                        U.S. Geological Survey
+//
+// {LicenseText}
+//
+// ======================================================================
+//
+
+#include "CacheMonitor.h" // implementation of class methods
+
+#include <fcntl.h> // USES open()
+#include <unistd.h> // USES pread(), close(), sysconf()
+#include <string.h> // USES strstr(), strncmp()
+#include <stdio.h> // USES fopen(), fgets(), fclose()
+#include <stdlib.h> // USES strtoull()
+#include <limits.h> // USES INT_MAX
+#include <math.h> // USES ceil()
+#include <sys/stat.h> // USES stat()
+
+#include <sstream> // USES std::ostringstream
+#include <iomanip> // USES std::setprecision()
+#include <assert.h> // USES assert()
+
+// ----------------------------------------------------------------------
+const int cencalvm::storage::CacheMonitor::AUTOSIZE = -1;
+const int cencalvm::storage::CacheMonitor::INITIALSIZE = 128;
+const int cencalvm::storage::CacheMonitor::MINSIZE = 16;
+const int cencalvm::storage::CacheMonitor::PAGESIZE = 4096;
+const int cencalvm::storage::CacheMonitor::SAMPLEINTERVAL = 32;
+const double cencalvm::storage::CacheMonitor::_GROWMISSRATE = 0.05;
+const double cencalvm::storage::CacheMonitor::_REFILLFACTOR = 4.0;
+
+// ----------------------------------------------------------------------
+// Constructor
+cencalvm::storage::CacheMonitor::CacheMonitor(void) :
+  _numSearches(0),
+  _numSampled(0),
+  _numSampledMisses(0),
+  _sampledBytes(0),
+  _bytesBegin(0),
+  _countBytes(0),
+  _readsResize(0),
+  _evictionsResize(0),
+  _countdown(1),
+  _fd(-1),
+  _cacheSize(0),
+  _numResizes(0)
+{ // constructor
+} // constructor
+
+// ----------------------------------------------------------------------
+// Destructor
+cencalvm::storage::CacheMonitor::~CacheMonitor(void)
+{ // destructor
+  if (_fd >= 0)
+    close(_fd);
+  _fd = -1;
+} // destructor
+
+// ----------------------------------------------------------------------
+// Start monitoring cache of newly opened database.
+void
+cencalvm::storage::CacheMonitor::open(const int cacheSize)
+{ // open
+  _numSearches = 0;
+  _numSampled = 0;
+  _numSampledMisses = 0;
+  _sampledBytes = 0;
+  _readsResize = 0;
+  _evictionsResize = 0;
+  _countdown = 1;
+  _cacheSize = cacheSize;
+  _numResizes = 0;
+} // open
+
+// ----------------------------------------------------------------------
+// Continue monitoring cache after database was reopened.
+void
+cencalvm::storage::CacheMonitor::resize(const int cacheSize)
+{ // resize
+  CacheStatsStruct current;
+  stats(&current);
+  _readsResize = current.numReads;
+  _evictionsResize = current.numEvictions;
+  _cacheSize = cacheSize;
+  ++_numResizes;
+} // resize
+
+// ----------------------------------------------------------------------
+// Finish measurement of sampled search.
+void
+cencalvm::storage::CacheMonitor::endSearch(void)
+{ // endSearch
+  const uint64_t countBytes = _countBytes;
+  const uint64_t bytesEnd = _bytesRead(&_countBytes);
+
+  // Reading the counters at the start of the search counts as a read.
+  const uint64_t bytesBegin = _bytesBegin + countBytes;
+  const uint64_t numBytes = (bytesEnd > bytesBegin) ? bytesEnd - bytesBegin : 0;
+  ++_numSampled;
+  if (numBytes > 0)
+    ++_numSampledMisses;
+  _sampledBytes += numBytes;
+} // endSearch
+
+// ----------------------------------------------------------------------
+// Get statistics of cache.
+void
+cencalvm::storage::CacheMonitor::stats(CacheStatsStruct* pStats) const
+{ // stats
+  assert(0 != pStats);
+
+  pStats->numSearches = _numSearches;
+  pStats->numHits = 0;
+  pStats->numMisses = 0;
+  pStats->bytesRead = 0;
+  pStats->numReads = 0;
+  if (_numSampled > 0) {
+    const double scale = double(_numSearches) / _numSampled;
+    pStats->numMisses = uint64_t(_numSampledMisses * scale + 0.5);
+    if (pStats->numMisses > _numSearches)
+      pStats->numMisses = _numSearches;
+    pStats->numHits = _numSearches - pStats->numMisses;
+    pStats->bytesRead = uint64_t(_sampledBytes * scale + 0.5);
+    pStats->numReads = (pStats->bytesRead + PAGESIZE - 1) / PAGESIZE;
+  } // if
+
+  const uint64_t capacity = uint64_t(_cacheSize) * 1024 * 1024 / PAGESIZE;
+  const uint64_t numReads = (pStats->numReads > _readsResize) ?
+    pStats->numReads - _readsResize : 0;
+  pStats->capacity = capacity;
+  pStats->numResident = (numReads < capacity) ? numReads : capacity;
+  pStats->numEvictions = _evictionsResize +
+    ((numReads > capacity) ? numReads - capacity : 0);
+  pStats->cacheSize = _cacheSize;
+  pStats->numResizes = _numResizes;
+  pStats->isEstimate = true;
+} // stats
+
+// ----------------------------------------------------------------------
+// Get available memory.
+uint64_t
+cencalvm::storage::CacheMonitor::availableMemory(void)
+{ // availableMemory
+  FILE* fin = fopen("/proc/meminfo", "r");
+  if (0 != fin) {
+    uint64_t memory = 0;
+    const int maxLen = 128;
+    char line[maxLen];
+    while (0 != fgets(line, maxLen, fin))
+      if (0 == strncmp(line, "MemAvailable:", 13)) {
+	// Value is in kB.
+	memory = 1024 * strtoull(line+13, 0, 10);
+	break;
+      } // if
+    fclose(fin);
+    if (memory > 0)
+      return memory;
+  } // if
+
+  const long numPages = sysconf(_SC_AVPHYS_PAGES);
+  const long pageSize = sysconf(_SC_PAGESIZE);
+  return (numPages > 0 && pageSize > 0) ? uint64_t(numPages) * pageSize : 0;
+} // availableMemory
+
+// ----------------------------------------------------------------------
+// Get maximum size of automatic cache of database.
+int
+cencalvm::storage::CacheMonitor::maxSize(const char* filename,
+					 const double memoryFraction)
+{ // maxSize
+  assert(0 != filename);
+
+  const double MB = 1024.0 * 1024.0;
+  double size = memoryFraction * availableMemory() / MB;
+  struct stat fileInfo;
+  if (0 == stat(filename, &fileInfo)) {
+    const double sizeFile = ceil(fileInfo.st_size / MB) + 1.0;
+    if (sizeFile < size)
+      size = sizeFile;
+  } // if
+  if (size > INT_MAX)
+    size = INT_MAX;
+  return (size > MINSIZE) ? int(size) : MINSIZE;
+} // maxSize
+
+// ----------------------------------------------------------------------
+// Choose size of automatic cache between batches of searches.
+int
+cencalvm::storage::CacheMonitor::chooseSize(std::string* pReason,
+					    const CacheStatsStruct& stats,
+					    const CacheStatsStruct& batch,
+					    const int sizeMax)
+{ // chooseSize
+  assert(0 != pReason);
+
+  const int size = stats.cacheSize;
+  if (0 == batch.numSearches || 0 == stats.capacity)
+    return size;
+
+  const double missRate = double(batch.numMisses) / batch.numSearches;
+  std::ostringstream reason;
+  reason << std::fixed << std::setprecision(1);
+  if (batch.numEvictions > 0 && missRate > _GROWMISSRATE && size < sizeMax) {
+    // Working set does not fit in cache.
+    const int sizeNew = (2*size < sizeMax) ? 2*size : sizeMax;
+    reason << 100.0*missRate << "% of the last " << batch.numSearches
+	   << " searches missed and " << batch.numEvictions
+	   << " pages were evicted";
+    *pReason = reason.str();
+    return sizeNew;
+  } // if
+
+  if (0 == batch.numEvictions && missRate <= _GROWMISSRATE &&
+      4*stats.numResident < stats.capacity && size > MINSIZE) {
+    // Working set fills little of cache and is no longer growing quickly.
+    const double sizeWorking =
+      double(size) * stats.numResident / stats.capacity;
+    const int sizeNew = int(ceil(2.0*sizeWorking));
+    if (sizeNew < size) {
+      reason << "working set of " << sizeWorking << " MB fills less than "
+	     << "a quarter of the cache";
+      *pReason = reason.str();
+      return (sizeNew > MINSIZE) ? sizeNew : MINSIZE;
+    } // if
+  } // if
+
+  return size;
+} // chooseSize
+
+// ----------------------------------------------------------------------
+// Check whether reopening database with new size of cache is worth it.
+bool
+cencalvm::storage::CacheMonitor::worthReopening(
+				      const CacheStatsStruct& stats,
+				      const CacheStatsStruct& sinceResize,
+				      const int sizeNew)
+{ // worthReopening
+  // Every page in the cache is read again after reopening.
+  const double costRefill = _REFILLFACTOR * stats.numResident;
+  const uint64_t capacityNew = uint64_t(sizeNew) * 1024 * 1024 / PAGESIZE;
+  if (capacityNew > stats.capacity)
+    return sinceResize.numEvictions > costRefill;
+  else if (capacityNew < stats.capacity)
+    return stats.capacity - capacityNew > costRefill;
+  return false;
+} // worthReopening
+
+// ----------------------------------------------------------------------
+// Get difference of statistics.
+void
+cencalvm::storage::CacheMonitor::difference(CacheStatsStruct* pDiff,
+					    const CacheStatsStruct& stats,
+					    const CacheStatsStruct& statsBegin)
+{ // difference
+  assert(0 != pDiff);
+
+  *pDiff = stats;
+  pDiff->numSearches -= statsBegin.numSearches;
+  pDiff->numHits = (stats.numHits > statsBegin.numHits) ?
+    stats.numHits - statsBegin.numHits : 0;
+  pDiff->numMisses = (stats.numMisses > statsBegin.numMisses) ?
+    stats.numMisses - statsBegin.numMisses : 0;
+  pDiff->numReads = (stats.numReads > statsBegin.numReads) ?
+    stats.numReads - statsBegin.numReads : 0;
+  pDiff->numEvictions = (stats.numEvictions > statsBegin.numEvictions) ?
+    stats.numEvictions - statsBegin.numEvictions : 0;
+  pDiff->bytesRead = (stats.bytesRead > statsBegin.bytesRead) ?
+    stats.bytesRead - statsBegin.bytesRead : 0;
+} // difference
+
+// ----------------------------------------------------------------------
+// Start measurement of sampled search.
+bool
+cencalvm::storage::CacheMonitor::_beginSample(void)
+{ // _beginSample
+  _bytesBegin = _bytesRead(&_countBytes);
+  if (_fd < 0) {
+    // Without I/O counters, stop sampling.
+    _countdown = INT_MAX;
+    return false;
+  } // if
+  return true;
+} // _beginSample
+
+// ----------------------------------------------------------------------
+// Get bytes read by calling thread.
+uint64_t
+cencalvm::storage::CacheMonitor::_bytesRead(uint64_t* pNumBytes)
+{ // _bytesRead
+  assert(0 != pNumBytes);
+
+  *pNumBytes = 0;
+  if (_fd < 0 || std::this_thread::get_id() != _thread) {
+    // Counters of the thread are only available to the thread, so
+    // they are reopened if the database is searched by another thread.
+    if (_fd >= 0)
+      close(_fd);
+    _fd = ::open("/proc/thread-self/io", O_RDONLY);
+    if (_fd < 0)
+      _fd = ::open("/proc/self/io", O_RDONLY);
+    _thread = std::this_thread::get_id();
+    if (_fd < 0)
+      return 0;
+  } // if
+
+  const int maxLen = 512;
+  char buffer[maxLen];
+  const ssize_t numBytes = pread(_fd, buffer, maxLen-1, 0);
+  if (numBytes <= 0)
+    return 0;
+  buffer[numBytes] = '\0';
+  *pNumBytes = numBytes;
+  const char* rchar = strstr(buffer, "rchar:");
+  return (0 != rchar) ? strtoull(rchar+6, 0, 10) : 0;
+} // _bytesRead
+
+// End of file
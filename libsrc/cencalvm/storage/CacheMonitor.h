@@ -0,0 +1,232 @@
+// -*- C++ -*-
+//
+// ======================================================================
+//
+//                           Brad T. Aagaard
+//                        U.S. Geological Survey
+//
+// {LicenseText}
+//
+// ======================================================================
+//
+
+/** @file libsrc/storage/CacheMonitor.h
+ *
+ * @brief C++ monitor of the buffer cache of an etree database and
+ * policy for sizing caches automatically.
+ *
+ * Etree does not expose statistics of its buffer cache, but it reads
+ * a page from the file for every miss. The monitor samples one of
+ * every SAMPLEINTERVAL searches and measures the bytes read by the
+ * calling thread during the search from /proc/thread-self/io (or
+ * /proc/self/io). A sampled search that reads from the file is a
+ * miss. The number of hits, misses, and pages read are estimated by
+ * scaling the sampled counts by the number of searches. The cache is
+ * a fixed number of pages, so pages read beyond its capacity are
+ * evictions. Counts are zero on systems without /proc.
+ *
+ * With automatic sizing (AUTOSIZE), the cache starts at INITIALSIZE
+ * MB, limited by maxSize(), which allows at most the size of the
+ * database file and a fraction of the available memory. Between
+ * batches of searches chooseSize() doubles the cache if searches
+ * miss and pages are evicted, or shrinks it to twice the working set
+ * if the working set fills less than a quarter of the cache. Resizing
+ * an etree cache reopens the database with an empty cache, so
+ * worthReopening() only allows it when the pages reread (or freed) by
+ * the new size clearly outweigh refilling the pages in the cache.
+ *
+ * A monitor must be used by one thread at a time.
+ */
+
+#if !defined(cencalvm_storage_cachemonitor_h)
+#define cencalvm_storage_cachemonitor_h
+
+#include <inttypes.h> // USES uint64_t
+#include <string> // USES std::string
+#include <thread> // HASA std::thread::id
+
+namespace cencalvm {
+  namespace storage {
+    struct CacheStatsStruct;
+    class CacheMonitor;
+    class TestCacheMonitor; // friend
+  } // namespace storage
+} // namespace cencalvm
+
+/// Statistics of the cache of a database.
+struct cencalvm::storage::CacheStatsStruct {
+  uint64_t numSearches; ///< Number of searches
+  uint64_t numHits; ///< Number of searches served from the cache
+  uint64_t numMisses; ///< Number of searches that read from the file
+  uint64_t numReads; ///< Number of pages (or blocks) read from the file
+  uint64_t numEvictions; ///< Number of pages (or blocks) evicted
+  uint64_t numResident; ///< Number of pages (or blocks) in the cache
+  uint64_t capacity; ///< Number of pages (or blocks) the cache holds
+  uint64_t bytesRead; ///< Bytes read from the file
+  int cacheSize; ///< Size of cache in MB
+  int numResizes; ///< Number of times the cache was resized
+  bool isEstimate; ///< True if counts are estimated by sampling
+}; // CacheStatsStruct
+
+/// C++ monitor of the buffer cache of an etree database.
+class cencalvm::storage::CacheMonitor
+{ // CacheMonitor
+  friend class TestCacheMonitor; // unit testing
+
+public :
+  // PUBLIC MEMBERS /////////////////////////////////////////////////////
+
+  static const int AUTOSIZE; ///< Cache size requesting automatic sizing
+  static const int INITIALSIZE; ///< Initial size in MB of automatic cache
+  static const int MINSIZE; ///< Minimum size in MB of automatic cache
+  static const int PAGESIZE; ///< Size of etree pages in bytes
+  static const int SAMPLEINTERVAL; ///< Number of searches per sample
+
+public :
+  // PUBLIC METHODS /////////////////////////////////////////////////////
+
+  /// Constructor
+  CacheMonitor(void);
+
+  /// Destructor
+  ~CacheMonitor(void);
+
+  /** Start monitoring cache of newly opened database, clearing
+   * statistics.
+   *
+   * @param cacheSize Size of cache in MB
+   */
+  void open(const int cacheSize);
+
+  /** Continue monitoring cache after database was reopened with a
+   * different size of cache, which starts empty.
+   *
+   * @param cacheSize Size of cache in MB
+   */
+  void resize(const int cacheSize);
+
+  /** Count search, starting measurement if search is sampled.
+   *
+   * @returns True if search is sampled and endSearch() must be
+   * called after it
+   */
+  bool beginSearch(void);
+
+  /// Finish measurement of sampled search.
+  void endSearch(void);
+
+  /** Get statistics of cache.
+   *
+   * @param pStats Pointer to statistics
+   */
+  void stats(CacheStatsStruct* pStats) const;
+
+  /** Get available memory from MemAvailable in /proc/meminfo (free
+   * physical memory on systems without it).
+   *
+   * @returns Available memory in bytes
+   */
+  static uint64_t availableMemory(void);
+
+  /** Get maximum size of automatic cache of database.
+   *
+   * @param filename Name of database file
+   * @param memoryFraction Fraction of available memory for cache
+   *
+   * @returns Size of cache in MB (at least MINSIZE)
+   */
+  static int maxSize(const char* filename,
+		     const double memoryFraction);
+
+  /** Choose size of automatic cache between batches of searches.
+   *
+   * @param pReason Pointer to reason for new size (unchanged if size
+   * is unchanged)
+   * @param stats Statistics of cache
+   * @param batch Statistics of cache in last batch of searches
+   * @param sizeMax Maximum size of cache in MB
+   *
+   * @returns Size of cache in MB
+   */
+  static int chooseSize(std::string* pReason,
+			const CacheStatsStruct& stats,
+			const CacheStatsStruct& batch,
+			const int sizeMax);
+
+  /** Check whether reopening database with an empty cache of a new
+   * size is worth refilling the pages in the current cache.
+   *
+   * Growing is worth it when the pages evicted (and so reread) since
+   * the last resize exceed _REFILLFACTOR times the pages in the
+   * cache. Shrinking is worth it when the pages freed exceed
+   * _REFILLFACTOR times the pages in the cache.
+   *
+   * @param stats Statistics of cache
+   * @param sinceResize Statistics of cache since last resize
+   * @param sizeNew New size of cache in MB
+   *
+   * @returns True if database should be reopened with new size
+   */
+  static bool worthReopening(const CacheStatsStruct& stats,
+			     const CacheStatsStruct& sinceResize,
+			     const int sizeNew);
+
+  /** Get difference of statistics.
+   *
+   * @param pDiff Pointer to counts in stats and not in statsBegin
+   * @param stats Statistics of cache
+   * @param statsBegin Earlier statistics of cache
+   */
+  static void difference(CacheStatsStruct* pDiff,
+			 const CacheStatsStruct& stats,
+			 const CacheStatsStruct& statsBegin);
+
+private :
+  // PRIVATE METHODS ////////////////////////////////////////////////////
+
+  /** Start measurement of sampled search.
+   *
+   * @returns True if search is measured, false if I/O counters are
+   * unavailable
+   */
+  bool _beginSample(void);
+
+  /** Get bytes read by calling thread, opening I/O counters of thread
+   * if necessary.
+   *
+   * @param pNumBytes Pointer to bytes read from I/O counters
+   *
+   * @returns Bytes read by thread
+   */
+  uint64_t _bytesRead(uint64_t* pNumBytes);
+
+  CacheMonitor(const CacheMonitor& m); ///< Not implemented
+  const CacheMonitor& operator=(const CacheMonitor& m); ///< Not implemented
+
+private :
+  // PRIVATE MEMBERS ////////////////////////////////////////////////////
+
+  std::thread::id _thread; ///< Thread that opened I/O counters
+  uint64_t _numSearches; ///< Number of searches
+  uint64_t _numSampled; ///< Number of sampled searches
+  uint64_t _numSampledMisses; ///< Number of sampled searches that read
+  uint64_t _sampledBytes; ///< Bytes read in sampled searches
+  uint64_t _bytesBegin; ///< Bytes read at start of sampled search
+  uint64_t _countBytes; ///< Bytes read from I/O counters at start
+  uint64_t _readsResize; ///< Estimated pages read when last resized
+  uint64_t _evictionsResize; ///< Estimated evictions before last resize
+  int _countdown; ///< Number of searches until next sample
+  int _fd; ///< File descriptor of I/O counters (-1 if unavailable)
+  int _cacheSize; ///< Size of cache in MB
+  int _numResizes; ///< Number of times cache was resized
+
+  static const double _GROWMISSRATE; ///< Miss rate above which cache grows
+  static const double _REFILLFACTOR; ///< Gain over refill cost to reopen
+
+}; // CacheMonitor
+
+#include "CacheMonitor.icc" // inline methods
+
+#endif // cencalvm_storage_cachemonitor_h
+
+// End of file
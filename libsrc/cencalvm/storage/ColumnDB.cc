@@ -0,0 +1,355 @@
+// -*- C++ -*-
+//
+// ======================================================================
+//
+//                           Brad T. Aagaard
+//                        U.S. Geological Survey
+//
+// {LicenseText}
+//
+// ======================================================================
+//
+
+#include "ColumnDB.h" // implementation of class methods
+
+#include "Geometry.h" // USES Geometry::precedes(), Geometry::contains()
+#include "Payload.h" // USES PayloadStruct
+
+extern "C" {
+#include "etree.h"
+}
+
+#include <sys/mman.h> // USES mmap(), munmap()
+#include <sys/stat.h> // USES fstat()
+#include <fcntl.h> // USES open()
+#include <unistd.h> // USES close()
+#include <stdio.h> // USES fopen(), fread(), fclose()
+#include <string.h> // USES memcmp(), memcpy(), memset()
+
+#include <stdexcept> // USES std::runtime_error
+#include <sstream> // USES std::ostringstream
+#include <assert.h> // USES assert()
+
+// ----------------------------------------------------------------------
+const char* cencalvm::storage::ColumnDB::MAGIC = "CVMCOLS";
+const int32_t cencalvm::storage::ColumnDB::VERSION = 1;
+const int32_t cencalvm::storage::ColumnDB::BYTEORDER = 0x01020304;
+const int cencalvm::storage::ColumnDB::NUMCOLUMNS = 8;
+const char* cencalvm::storage::ColumnDB::NAMES[] = {
+  "Vp",
+  "Vs",
+  "Density",
+  "Qp",
+  "Qs",
+  "DepthFreeSurf",
+  "FaultBlock",
+  "Zone",
+};
+const int cencalvm::storage::ColumnDB::ALLCOLUMNS = 0xFF;
+
+// ----------------------------------------------------------------------
+// Constructor
+cencalvm::storage::ColumnDB::ColumnDB(void) :
+  _filename(""),
+  _schema(""),
+  _appmeta(""),
+  _pKeyFile(0),
+  _keyFileSize(0),
+  _pKeys(0)
+{ // constructor
+  memset(&_header, 0, sizeof(_header));
+  for (int i=0; i < NUMCOLUMNS; ++i) {
+    _pColumns[i] = 0;
+    _columnSizes[i] = 0;
+  } // for
+} // constructor
+
+// ----------------------------------------------------------------------
+// Destructor
+cencalvm::storage::ColumnDB::~ColumnDB(void)
+{ // destructor
+  close();
+} // destructor
+
+// ----------------------------------------------------------------------
+// Check whether file is the key file of a column-split database.
+bool
+cencalvm::storage::ColumnDB::isColumnar(const char* filename)
+{ // isColumnar
+  assert(0 != filename);
+
+  FILE* fin = fopen(filename, "rb");
+  if (0 == fin)
+    return false;
+  char magic[sizeof(ColumnDBHeaderStruct().magic)];
+  const bool isMatch = (1 == fread(magic, sizeof(magic), 1, fin) &&
+			0 == memcmp(magic, MAGIC, sizeof(magic)));
+  fclose(fin);
+  return isMatch;
+} // isColumnar
+
+// ----------------------------------------------------------------------
+// Get name of value file for column.
+std::string
+cencalvm::storage::ColumnDB::columnFilename(const char* filename,
+					    const int iColumn)
+{ // columnFilename
+  assert(0 != filename);
+  assert(0 <= iColumn && iColumn < NUMCOLUMNS);
+
+  return std::string(filename) + "." + NAMES[iColumn];
+} // columnFilename
+
+// ----------------------------------------------------------------------
+// Get size of values in column.
+size_t
+cencalvm::storage::ColumnDB::columnSize(const int iColumn)
+{ // columnSize
+  assert(0 <= iColumn && iColumn < NUMCOLUMNS);
+
+  // Floating point values followed by fault block and zone.
+  return (iColumn < 6) ? sizeof(float) : sizeof(int16_t);
+} // columnSize
+
+// ----------------------------------------------------------------------
+// Open column-split database for querying.
+void
+cencalvm::storage::ColumnDB::open(const char* filename)
+{ // open
+  assert(0 != filename);
+
+  close();
+  _filename = filename;
+  _pKeyFile = _mapFile(&_keyFileSize, filename);
+
+  std::ostringstream msg;
+  if (_keyFileSize < sizeof(_header) ||
+      0 != memcmp(_pKeyFile, MAGIC, sizeof(_header.magic)))
+    msg << "File '" << filename << "' is not a column-split etree database.";
+  else {
+    memcpy(&_header, _pKeyFile, sizeof(_header));
+    const int64_t keysSize = _header.numOctants * sizeof(ColumnDBKeyStruct);
+    if (BYTEORDER != _header.byteOrder)
+      msg << "Column-split etree database '" << filename << "' was written "
+	  << "on a machine with a different byte order.";
+    else if (VERSION != _header.version)
+      msg << "Unknown version " << _header.version << " of column-split "
+	  << "etree database '" << filename << "'. Expected version "
+	  << VERSION << ".";
+    else if (_header.numOctants < 0 ||
+	     _header.schemaLength < 0 || _header.appmetaLength < 0 ||
+	     _header.keysOffset < int64_t(sizeof(_header) +
+					  _header.schemaLength +
+					  _header.appmetaLength) ||
+	     0 != _header.keysOffset % sizeof(ColumnDBKeyStruct) ||
+	     _header.keysOffset + keysSize != int64_t(_keyFileSize))
+      msg << "Bad header in column-split etree database '" << filename
+	  << "'.";
+  } // else
+  if (msg.str().length() > 0) {
+    close();
+    throw std::runtime_error(msg.str());
+  } // if
+
+  const char* pData = (const char*) _pKeyFile;
+  _schema.assign(pData + sizeof(_header), _header.schemaLength);
+  _appmeta.assign(pData + sizeof(_header) + _header.schemaLength,
+		  _header.appmetaLength);
+  _pKeys = (const ColumnDBKeyStruct*) (pData + _header.keysOffset);
+} // open
+
+// ----------------------------------------------------------------------
+// Close column-split database.
+void
+cencalvm::storage::ColumnDB::close(void)
+{ // close
+  for (int i=0; i < NUMCOLUMNS; ++i) {
+    if (0 != _pColumns[i])
+      munmap(_pColumns[i], _columnSizes[i]);
+    _pColumns[i] = 0;
+    _columnSizes[i] = 0;
+  } // for
+  if (0 != _pKeyFile)
+    munmap(_pKeyFile, _keyFileSize);
+  _pKeyFile = 0;
+  _keyFileSize = 0;
+  _pKeys = 0;
+} // close
+
+// ----------------------------------------------------------------------
+// Search for octant containing address.
+int
+cencalvm::storage::ColumnDB::search(etree_addr_t* pResAddr,
+				    PayloadStruct* pPayload,
+				    const etree_addr_t& addr,
+				    const int columns)
+{ // search
+  assert(0 != _pKeys || 0 == _header.numOctants);
+  assert(0 != pPayload);
+
+  int64_t index = 0;
+  if (!_findLast(&index, addr))
+    return -1;
+
+  etree_addr_t found = _address(index);
+  if (!Geometry::contains(found, addr) ||
+      (ETREE_LEAF != addr.type && found.level != addr.level)) {
+    if (ETREE_LEAF != addr.type)
+      return -1;
+
+    // Octant containing address is a common ancestor of the address
+    // and the octant found, so search for ancestors of the address
+    // starting at the finest common level.
+    int level = (found.level < addr.level) ? found.level : addr.level;
+    for (; level >= 0; --level) {
+      etree_addr_t ancestor = addr;
+      if (level < addr.level)
+	Geometry::findAncestor(&ancestor, addr, level);
+      if (Geometry::contains(ancestor, found))
+	break;
+    } // for
+    bool isFound = false;
+    for (; level >= 0 && !isFound; --level) {
+      etree_addr_t ancestor = addr;
+      if (level < addr.level)
+	Geometry::findAncestor(&ancestor, addr, level);
+      if (_findLast(&index, ancestor)) {
+	found = _address(index);
+	isFound = (found.level == level && Geometry::contains(found, ancestor));
+      } // if
+    } // for
+    if (!isFound)
+      return -1;
+  } // if
+
+  if (0 != pResAddr)
+    *pResAddr = found;
+
+  float* pFloats = &pPayload->Vp;
+  for (int i=0; i < 6; ++i)
+    if (columns & (1 << i)) {
+      if (0 == _pColumns[i])
+	_mapColumn(i);
+      pFloats[i] = ((const float*) _pColumns[i])[index];
+    } else
+      pFloats[i] = Payload::NODATAVAL;
+  if (columns & (1 << 6)) {
+    if (0 == _pColumns[6])
+      _mapColumn(6);
+    pPayload->FaultBlock = ((const int16_t*) _pColumns[6])[index];
+  } else
+    pPayload->FaultBlock = Payload::NODATABLOCK;
+  if (columns & (1 << 7)) {
+    if (0 == _pColumns[7])
+      _mapColumn(7);
+    pPayload->Zone = ((const int16_t*) _pColumns[7])[index];
+  } else
+    pPayload->Zone = Payload::NODATAZONE;
+
+  return 0;
+} // search
+
+// ----------------------------------------------------------------------
+// Find last octant at or before address in Morton pre-order.
+bool
+cencalvm::storage::ColumnDB::_findLast(int64_t* pIndex,
+				       const etree_addr_t& addr) const
+{ // _findLast
+  assert(0 != pIndex);
+
+  int64_t lower = 0;
+  int64_t upper = _header.numOctants;
+  while (lower < upper) {
+    const int64_t middle = lower + (upper - lower) / 2;
+    if (Geometry::precedes(addr, _address(middle)))
+      upper = middle;
+    else
+      lower = middle + 1;
+  } // while
+  if (0 == lower)
+    return false;
+  *pIndex = lower - 1;
+
+  return true;
+} // _findLast
+
+// ----------------------------------------------------------------------
+// Get address of octant.
+etree_addr_t
+cencalvm::storage::ColumnDB::_address(const int64_t index) const
+{ // _address
+  assert(0 <= index && index < _header.numOctants);
+
+  const ColumnDBKeyStruct& key = _pKeys[index];
+  etree_addr_t addr;
+  addr.x = key.x;
+  addr.y = key.y;
+  addr.z = key.z;
+  addr.t = 0;
+  addr.level = key.level;
+  addr.type = (etree_type_t) key.type;
+  return addr;
+} // _address
+
+// ----------------------------------------------------------------------
+// Map value file of column into memory.
+void
+cencalvm::storage::ColumnDB::_mapColumn(const int iColumn)
+{ // _mapColumn
+  assert(0 <= iColumn && iColumn < NUMCOLUMNS);
+  assert(0 == _pColumns[iColumn]);
+
+  const std::string filename = columnFilename(_filename.c_str(), iColumn);
+  size_t size = 0;
+  void* pData = _mapFile(&size, filename.c_str());
+  if (size != _header.numOctants * columnSize(iColumn)) {
+    if (0 != pData)
+      munmap(pData, size);
+    std::ostringstream msg;
+    msg << "Size of value file '" << filename << "' does not match number "
+	<< "of octants in column-split etree database '" << _filename
+	<< "'.";
+    throw std::runtime_error(msg.str());
+  } // if
+  _pColumns[iColumn] = pData;
+  _columnSizes[iColumn] = size;
+} // _mapColumn
+
+// ----------------------------------------------------------------------
+// Map file into memory.
+void*
+cencalvm::storage::ColumnDB::_mapFile(size_t* pSize,
+				      const char* filename)
+{ // _mapFile
+  assert(0 != pSize);
+  assert(0 != filename);
+
+  const int fd = ::open(filename, O_RDONLY);
+  struct stat info;
+  if (fd < 0 || 0 != fstat(fd, &info)) {
+    if (fd >= 0)
+      ::close(fd);
+    std::ostringstream msg;
+    msg << "Could not open column-split etree database file '" << filename
+	<< "' for querying.";
+    throw std::runtime_error(msg.str());
+  } // if
+  *pSize = info.st_size;
+  void* pData = 0;
+  if (*pSize > 0) {
+    pData = mmap(0, *pSize, PROT_READ, MAP_SHARED, fd, 0);
+    if (MAP_FAILED == pData)
+      pData = 0;
+  } // if
+  ::close(fd);
+  if (0 == pData && *pSize > 0) {
+    std::ostringstream msg;
+    msg << "Could not map column-split etree database file '" << filename
+	<< "' into memory.";
+    throw std::runtime_error(msg.str());
+  } // if
+
+  return pData;
+} // _mapFile
+
+// End of file
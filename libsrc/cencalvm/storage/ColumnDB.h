@@ -0,0 +1,246 @@
+// -*- C++ -*-
+//
+// ======================================================================
+//
+//                           Brad T. Aagaard
+//                        U.S. Geological Survey
+//
+// {LicenseText}
+//
+// ======================================================================
+//
+
+/** @file libsrc/storage/ColumnDB.h
+ *
+ * @brief C++ manager of read-only column-split copies of packed etree
+ * databases.
+ *
+ * The octants are stored in Morton pre-order in a key file holding
+ * the addresses of the octants and one value file per payload field
+ * (Vp, Vs, Density, Qp, Qs, DepthFreeSurf, FaultBlock, Zone). The value
+ * file for a field is the name of the key file with '.' and the name of
+ * the field appended, e.g., model.col.Vs.
+ *
+ * Files are memory mapped and value files are mapped only when a
+ * search first requests the field, so queries for only a few values
+ * touch only the pages holding those values.
+ *
+ * The key file starts with a ColumnDBHeaderStruct followed by the
+ * schema and application metadata of the etree database and the
+ * array of ColumnDBKeyStruct. Values are stored in the byte order of
+ * the machine that wrote the file.
+ */
+
+#if !defined(cencalvm_storage_columndb_h)
+#define cencalvm_storage_columndb_h
+
+#include "etreefwd.h" // USES etree_addr_t
+
+#include <inttypes.h> // USES int32_t, int64_t
+#include <stddef.h> // USES size_t
+#include <string> // HASA std::string
+
+namespace cencalvm {
+  namespace storage {
+    struct ColumnDBHeaderStruct;
+    struct ColumnDBKeyStruct;
+    struct PayloadStruct; // USES PayloadStruct
+    class ColumnDB;
+    class TestColumnDB; // friend
+  } // namespace storage
+} // namespace cencalvm
+
+/// Header of key file of column-split database.
+struct cencalvm::storage::ColumnDBHeaderStruct {
+  char magic[8]; ///< File identifier (ColumnDB::MAGIC)
+  int32_t version; ///< Version of file format
+  int32_t byteOrder; ///< Byte order mark (ColumnDB::BYTEORDER)
+  int64_t numOctants; ///< Number of octants
+  int64_t keysOffset; ///< Offset of array of keys in file
+  int32_t schemaLength; ///< Length of schema that follows header
+  int32_t appmetaLength; ///< Length of metadata that follows schema
+}; // ColumnDBHeaderStruct
+
+/// Address of octant in key file of column-split database.
+struct cencalvm::storage::ColumnDBKeyStruct {
+  uint32_t x; ///< X coordinate of octant
+  uint32_t y; ///< Y coordinate of octant
+  uint32_t z; ///< Z coordinate of octant
+  int16_t level; ///< Level of octant
+  int16_t type; ///< Type of octant (ETREE_LEAF or ETREE_INTERIOR)
+}; // ColumnDBKeyStruct
+
+/// C++ manager of read-only column-split copies of packed etree
+/// databases.
+class cencalvm::storage::ColumnDB
+{ // ColumnDB
+  friend class TestColumnDB; // unit testing
+
+public :
+  // PUBLIC MEMBERS /////////////////////////////////////////////////////
+
+  static const char* MAGIC; ///< File identifier
+  static const int32_t VERSION; ///< Current version of file format
+  static const int32_t BYTEORDER; ///< Byte order mark
+
+  /// Number of columns (fields in payload)
+  static const int NUMCOLUMNS;
+
+  /// Names of columns in the order they appear in PayloadStruct
+  static const char* NAMES[];
+
+  /// Mask with all columns
+  static const int ALLCOLUMNS;
+
+public :
+  // PUBLIC METHODS /////////////////////////////////////////////////////
+
+  /// Constructor
+  ColumnDB(void);
+
+  /// Destructor
+  ~ColumnDB(void);
+
+  /** Check whether file is the key file of a column-split database.
+   *
+   * @param filename Name of file
+   *
+   * @returns True if file starts with the column-split database
+   *   identifier, false otherwise
+   */
+  static bool isColumnar(const char* filename);
+
+  /** Get name of value file for column.
+   *
+   * @param filename Name of key file
+   * @param iColumn Index of column in PayloadStruct
+   *
+   * @returns Name of value file
+   */
+  static std::string columnFilename(const char* filename,
+				    const int iColumn);
+
+  /** Get size of values in column.
+   *
+   * @param iColumn Index of column in PayloadStruct
+   *
+   * @returns Size of value in bytes
+   */
+  static size_t columnSize(const int iColumn);
+
+  /** Open column-split database for querying. Only the key file is
+   * mapped; value files are mapped when first needed.
+   *
+   * @param filename Name of key file
+   */
+  void open(const char* filename);
+
+  /// Close column-split database.
+  void close(void);
+
+  /** Search for octant containing address.
+   *
+   * If the address is a leaf address, the search returns the finest
+   * octant at or above the level of the address that contains it,
+   * consistent with etree_search(). Otherwise the octant must match
+   * the address.
+   *
+   * Fields not in the mask of columns are set to NODATA values.
+   *
+   * @param pResAddr Pointer to address of octant found
+   * @param pPayload Pointer to payload of octant found
+   * @param addr Address to search for
+   * @param columns Mask of columns to read (bit i is column i)
+   *
+   * @returns 0 if octant found, nonzero otherwise
+   */
+  int search(etree_addr_t* pResAddr,
+	     PayloadStruct* pPayload,
+	     const etree_addr_t& addr,
+	     const int columns =ALLCOLUMNS);
+
+  /** Get number of octants.
+   *
+   * @returns Number of octants
+   */
+  int64_t numOctants(void) const;
+
+  /** Get schema of payload.
+   *
+   * @returns Schema
+   */
+  const char* schema(void) const;
+
+  /** Get application metadata.
+   *
+   * @returns Metadata
+   */
+  const char* appmeta(void) const;
+
+private :
+  // PRIVATE METHODS ////////////////////////////////////////////////////
+
+  /** Find last octant at or before address in Morton pre-order.
+   *
+   * @param pIndex Pointer to index of octant
+   * @param addr Address
+   *
+   * @returns True if octant found, false if address precedes all
+   *   octants
+   */
+  bool _findLast(int64_t* pIndex,
+		 const etree_addr_t& addr) const;
+
+  /** Get address of octant.
+   *
+   * @param index Index of octant
+   *
+   * @returns Address of octant
+   */
+  etree_addr_t _address(const int64_t index) const;
+
+  /** Map value file of column into memory.
+   *
+   * @param iColumn Index of column
+   */
+  void _mapColumn(const int iColumn);
+
+  /** Map file into memory.
+   *
+   * @param pSize Pointer to size of file
+   * @param filename Name of file
+   *
+   * @returns Pointer to mapped file
+   */
+  static void* _mapFile(size_t* pSize,
+			const char* filename);
+
+private :
+  // NOT IMPLEMENTED ////////////////////////////////////////////////////
+
+  ColumnDB(const ColumnDB& d); ///< Not implemented
+  const ColumnDB& operator=(const ColumnDB& d); ///< Not implemented
+
+private :
+  // PRIVATE MEMBERS ////////////////////////////////////////////////////
+
+  ColumnDBHeaderStruct _header; ///< Header of key file
+
+  std::string _filename; ///< Name of key file
+  std::string _schema; ///< Schema of payload
+  std::string _appmeta; ///< Application metadata
+
+  void* _pKeyFile; ///< Mapped key file
+  size_t _keyFileSize; ///< Size of key file
+  const ColumnDBKeyStruct* _pKeys; ///< Array of keys in mapped key file
+
+  void* _pColumns[8]; ///< Mapped value files (0 if not mapped)
+  size_t _columnSizes[8]; ///< Sizes of value files
+
+}; // ColumnDB
+
+#include "ColumnDB.icc" // inline methods
+
+#endif // cencalvm_storage_columndb_h
+
+// End of file
@@ -0,0 +1,493 @@
+// -*- C++ -*-
+//
+// ======================================================================
+//
+//                           Brad T. Aagaard
+//                        U.S. Geological Survey
+//
+// {LicenseText}
+//
+// ======================================================================
+//
+
+#include "CompressedDB.h" // implementation of class methods
+
+#include "Geometry.h" // USES Geometry::precedes(), Geometry::contains()
+
+extern "C" {
+#include "etree.h"
+}
+
+#include <zlib.h> // USES compress2(), uncompress()
+#include <string.h> // USES memcmp(), memcpy()
+#include <sys/types.h> // USES off_t
+
+#include <stdexcept> // USES std::runtime_error
+#include <sstream> // USES std::ostringstream
+#include <assert.h> // USES assert()
+
+// ----------------------------------------------------------------------
+/// Decompressed block held in cache.
+struct cencalvm::storage::CompressedDB::BlockStruct {
+  std::vector<etree_addr_t> addrs; ///< Addresses of octants
+  std::vector<char> payloads; ///< Payloads of octants
+  std::list<int>::iterator lru; ///< Position in list of cached blocks
+}; // BlockStruct
+
+// ----------------------------------------------------------------------
+const char* cencalvm::storage::CompressedDB::MAGIC = "CVMZETR";
+const int32_t cencalvm::storage::CompressedDB::VERSION = 1;
+const int32_t cencalvm::storage::CompressedDB::BYTEORDER = 0x01020304;
+
+// ----------------------------------------------------------------------
+// Constructor
+cencalvm::storage::CompressedDB::CompressedDB(void) :
+  _filename(""),
+  _schema(""),
+  _appmeta(""),
+  _file(0),
+  _cacheCapacity(0)
+{ // constructor
+  memset(&_header, 0, sizeof(_header));
+  memset(&_stats, 0, sizeof(_stats));
+} // constructor
+
+// ----------------------------------------------------------------------
+// Destructor
+cencalvm::storage::CompressedDB::~CompressedDB(void)
+{ // destructor
+  close();
+} // destructor
+
+// ----------------------------------------------------------------------
+// Check whether file is a compressed container.
+bool
+cencalvm::storage::CompressedDB::isCompressed(const char* filename)
+{ // isCompressed
+  assert(0 != filename);
+
+  FILE* fin = fopen(filename, "rb");
+  if (0 == fin)
+    return false;
+  char magic[sizeof(CompressedDBHeaderStruct().magic)];
+  const bool isMatch = (1 == fread(magic, sizeof(magic), 1, fin) &&
+			0 == memcmp(magic, MAGIC, sizeof(magic)));
+  fclose(fin);
+  return isMatch;
+} // isCompressed
+
+// ----------------------------------------------------------------------
+// Open compressed container for querying.
+void
+cencalvm::storage::CompressedDB::open(const char* filename,
+				      const int cacheSize)
+{ // open
+  assert(0 != filename);
+
+  close();
+  _filename = filename;
+  _file = fopen(filename, "rb");
+  if (0 == _file) {
+    std::ostringstream msg;
+    msg << "Could not open compressed etree database '" << filename
+	<< "' for querying.";
+    throw std::runtime_error(msg.str());
+  } // if
+
+  std::ostringstream msg;
+  if (1 != fread(&_header, sizeof(_header), 1, _file) ||
+      0 != memcmp(_header.magic, MAGIC, sizeof(_header.magic)))
+    msg << "File '" << filename << "' is not a compressed etree database.";
+  else if (BYTEORDER != _header.byteOrder)
+    msg << "Compressed etree database '" << filename << "' was written "
+	<< "on a machine with a different byte order.";
+  else if (VERSION != _header.version)
+    msg << "Unknown version " << _header.version << " of compressed etree "
+	<< "database '" << filename << "'. Expected version " << VERSION
+	<< ".";
+  else if (_header.payloadSize <= 0 || 0 != _header.payloadSize % 4 ||
+	   _header.blockSize <= 0 || _header.numBlocks < 0 ||
+	   _header.schemaLength < 0 || _header.appmetaLength < 0)
+    msg << "Bad header in compressed etree database '" << filename << "'.";
+  else {
+    _schema.resize(_header.schemaLength);
+    _appmeta.resize(_header.appmetaLength);
+    _index.resize(_header.numBlocks);
+    if ((_header.schemaLength > 0 &&
+	 1 != fread(&_schema[0], _header.schemaLength, 1, _file)) ||
+	(_header.appmetaLength > 0 &&
+	 1 != fread(&_appmeta[0], _header.appmetaLength, 1, _file)) ||
+	0 != fseeko(_file, off_t(_header.indexOffset), SEEK_SET) ||
+	(_header.numBlocks > 0 &&
+	 size_t(_header.numBlocks) !=
+	 fread(&_index[0], sizeof(CompressedDBIndexStruct),
+	       _header.numBlocks, _file)))
+      msg << "Could not read index of compressed etree database '"
+	  << filename << "'.";
+  } // else
+  if (msg.str().length() > 0) {
+    close();
+    throw std::runtime_error(msg.str());
+  } // if
+
+  _cacheCapacity = _capacity(cacheSize);
+  _cache.assign(_index.size(), 0);
+  memset(&_stats, 0, sizeof(_stats));
+  _stats.cacheSize = cacheSize;
+} // open
+
+// ----------------------------------------------------------------------
+// Close compressed container.
+void
+cencalvm::storage::CompressedDB::close(void)
+{ // close
+  for (std::list<int>::const_iterator iter=_lru.begin();
+       iter != _lru.end();
+       ++iter) {
+    delete _cache[*iter]; _cache[*iter] = 0;
+  } // for
+  _lru.clear();
+  _cache.clear();
+  _index.clear();
+
+  if (0 != _file)
+    fclose(_file);
+  _file = 0;
+} // close
+
+// ----------------------------------------------------------------------
+// Search for octant containing address.
+int
+cencalvm::storage::CompressedDB::search(etree_addr_t* pResAddr,
+					void* pPayload,
+					const etree_addr_t& addr)
+{ // search
+  const uint64_t numReads = _stats.numReads;
+  const int err = _search(pResAddr, pPayload, addr);
+  ++_stats.numSearches;
+  if (_stats.numReads > numReads)
+    ++_stats.numMisses;
+  else
+    ++_stats.numHits;
+
+  return err;
+} // search
+
+// ----------------------------------------------------------------------
+// Change size of cache of decompressed blocks.
+void
+cencalvm::storage::CompressedDB::cacheSize(const int cacheSize)
+{ // cacheSize
+  _cacheCapacity = _capacity(cacheSize);
+  while (int(_lru.size()) > _cacheCapacity)
+    _evict();
+  _stats.cacheSize = cacheSize;
+  ++_stats.numResizes;
+} // cacheSize
+
+// ----------------------------------------------------------------------
+// Get statistics of cache of decompressed blocks.
+void
+cencalvm::storage::CompressedDB::cacheStats(CacheStatsStruct* pStats) const
+{ // cacheStats
+  assert(0 != pStats);
+
+  *pStats = _stats;
+  pStats->numResident = _lru.size();
+  pStats->capacity = _cacheCapacity;
+  pStats->isEstimate = false;
+} // cacheStats
+
+// ----------------------------------------------------------------------
+// Encode block of octants.
+void
+cencalvm::storage::CompressedDB::encodeBlock(std::string* pBuffer,
+					     const etree_addr_t* pAddrs,
+					     const char* pPayloads,
+					     const int numOctants,
+					     const int payloadSize)
+{ // encodeBlock
+  assert(0 != pBuffer);
+  assert(0 != pAddrs);
+  assert(0 != pPayloads);
+  assert(numOctants > 0);
+  assert(payloadSize > 0 && 0 == payloadSize % 4);
+
+  const int numWords = payloadSize / 4;
+  const int numCols = 3 + numWords;
+  std::vector<uint32_t> cols(numCols*numOctants);
+  std::vector<uint32_t> prev(numCols, 0);
+  for (int iOctant=0; iOctant < numOctants; ++iOctant) {
+    const etree_addr_t& addr = pAddrs[iOctant];
+    cols[0*numOctants+iOctant] = addr.x - prev[0];
+    cols[1*numOctants+iOctant] = addr.y - prev[1];
+    cols[2*numOctants+iOctant] = addr.z - prev[2];
+    prev[0] = addr.x;
+    prev[1] = addr.y;
+    prev[2] = addr.z;
+    for (int iWord=0, iCol=3; iWord < numWords; ++iWord, ++iCol) {
+      uint32_t word = 0;
+      memcpy(&word, pPayloads + iOctant*payloadSize + 4*iWord, 4);
+      cols[iCol*numOctants+iOctant] = word ^ prev[iCol];
+      prev[iCol] = word;
+    } // for
+  } // for
+
+  // Group bytes of each column by significance.
+  const size_t rawSize = size_t(numCols*4 + 2) * numOctants;
+  std::vector<unsigned char> raw(rawSize);
+  for (int iCol=0; iCol < numCols; ++iCol)
+    for (int iByte=0; iByte < 4; ++iByte) {
+      unsigned char* pDest = &raw[(iCol*4+iByte)*numOctants];
+      const uint32_t* pSrc = &cols[iCol*numOctants];
+      for (int iOctant=0; iOctant < numOctants; ++iOctant)
+	pDest[iOctant] = (unsigned char)(pSrc[iOctant] >> (8*iByte));
+    } // for
+  unsigned char* pLevels = &raw[numCols*4*numOctants];
+  unsigned char* pTypes = pLevels + numOctants;
+  for (int iOctant=0; iOctant < numOctants; ++iOctant) {
+    pLevels[iOctant] = (unsigned char) pAddrs[iOctant].level;
+    pTypes[iOctant] = (unsigned char) pAddrs[iOctant].type;
+  } // for
+
+  uLongf size = compressBound(rawSize);
+  pBuffer->resize(size);
+  if (Z_OK != compress2((Bytef*) &(*pBuffer)[0], &size, &raw[0], rawSize,
+			Z_DEFAULT_COMPRESSION))
+    throw std::runtime_error("Error occurred while compressing block of "
+			     "octants.");
+  pBuffer->resize(size);
+} // encodeBlock
+
+// ----------------------------------------------------------------------
+// Decode block of octants.
+void
+cencalvm::storage::CompressedDB::decodeBlock(etree_addr_t* pAddrs,
+					     char* pPayloads,
+					     const int numOctants,
+					     const int payloadSize,
+					     const char* pBuffer,
+					     const size_t size)
+{ // decodeBlock
+  assert(0 != pAddrs);
+  assert(0 != pPayloads);
+  assert(numOctants > 0);
+  assert(payloadSize > 0 && 0 == payloadSize % 4);
+  assert(0 != pBuffer);
+
+  const int numWords = payloadSize / 4;
+  const int numCols = 3 + numWords;
+  const size_t rawSize = size_t(numCols*4 + 2) * numOctants;
+  std::vector<unsigned char> raw(rawSize);
+  uLongf sizeOut = rawSize;
+  if (Z_OK != uncompress(&raw[0], &sizeOut, (const Bytef*) pBuffer, size) ||
+      sizeOut != rawSize)
+    throw std::runtime_error("Error occurred while decompressing block of "
+			     "octants.");
+
+  std::vector<uint32_t> prev(numCols, 0);
+  const unsigned char* pLevels = &raw[numCols*4*numOctants];
+  const unsigned char* pTypes = pLevels + numOctants;
+  for (int iOctant=0; iOctant < numOctants; ++iOctant) {
+    uint32_t vals[3];
+    for (int iCol=0; iCol < numCols; ++iCol) {
+      uint32_t val = 0;
+      for (int iByte=0; iByte < 4; ++iByte)
+	val |= uint32_t(raw[(iCol*4+iByte)*numOctants+iOctant]) << (8*iByte);
+      if (iCol < 3) {
+	prev[iCol] += val;
+	vals[iCol] = prev[iCol];
+      } else {
+	prev[iCol] ^= val;
+	memcpy(pPayloads + iOctant*payloadSize + 4*(iCol-3), &prev[iCol], 4);
+      } // if/else
+    } // for
+    etree_addr_t& addr = pAddrs[iOctant];
+    addr.x = vals[0];
+    addr.y = vals[1];
+    addr.z = vals[2];
+    addr.t = 0;
+    addr.level = pLevels[iOctant];
+    addr.type = (etree_type_t) pTypes[iOctant];
+  } // for
+} // decodeBlock
+
+// ----------------------------------------------------------------------
+// Search for octant containing address without counting search.
+int
+cencalvm::storage::CompressedDB::_search(etree_addr_t* pResAddr,
+					 void* pPayload,
+					 const etree_addr_t& addr)
+{ // _search
+  assert(0 != _file);
+  assert(0 != pPayload);
+
+  int iBlock = 0;
+  int iOctant = 0;
+  if (!_findLast(&iBlock, &iOctant, addr))
+    return -1;
+
+  const BlockStruct* pBlock = &_block(iBlock);
+  const etree_addr_t* pFound = &pBlock->addrs[iOctant];
+  const bool isMatch = (ETREE_LEAF == addr.type) ?
+    Geometry::contains(*pFound, addr) :
+    (Geometry::contains(*pFound, addr) && pFound->level == addr.level);
+  if (!isMatch) {
+    if (ETREE_LEAF != addr.type)
+      return -1;
+
+    // Octant containing address is a common ancestor of the address
+    // and the octant found, so search for ancestors of the address
+    // starting at the finest common level.
+    int level = (pFound->level < addr.level) ? pFound->level : addr.level;
+    for (; level >= 0; --level) {
+      const etree_tick_t mask = ~((((etree_tick_t) 0x80000000) >> level) - 1);
+      if ((pFound->x & mask) == (addr.x & mask) &&
+	  (pFound->y & mask) == (addr.y & mask) &&
+	  (pFound->z & mask) == (addr.z & mask))
+	break;
+    } // for
+    pFound = 0;
+    for (; level >= 0 && 0 == pFound; --level) {
+      const etree_tick_t mask = ~((((etree_tick_t) 0x80000000) >> level) - 1);
+      etree_addr_t ancestor = addr;
+      ancestor.x = addr.x & mask;
+      ancestor.y = addr.y & mask;
+      ancestor.z = addr.z & mask;
+      ancestor.level = level;
+      if (_findLast(&iBlock, &iOctant, ancestor)) {
+	pBlock = &_block(iBlock);
+	const etree_addr_t& octant = pBlock->addrs[iOctant];
+	if (octant.level == level && Geometry::contains(octant, ancestor))
+	  pFound = &octant;
+      } // if
+    } // for
+    if (0 == pFound)
+      return -1;
+  } // if
+
+  if (0 != pResAddr)
+    *pResAddr = *pFound;
+  const int payloadSize = _header.payloadSize;
+  memcpy(pPayload, &pBlock->payloads[(pFound - &pBlock->addrs[0])*payloadSize],
+	 payloadSize);
+
+  return 0;
+} // _search
+
+// ----------------------------------------------------------------------
+// Get number of decompressed blocks that fit in cache.
+int
+cencalvm::storage::CompressedDB::_capacity(const int cacheSize) const
+{ // _capacity
+  const double blockBytes =
+    double(_header.blockSize) * (sizeof(etree_addr_t) + _header.payloadSize);
+  const double cacheBytes = double(cacheSize) * 1024.0 * 1024.0;
+  return (cacheBytes > blockBytes) ? int(cacheBytes / blockBytes) : 1;
+} // _capacity
+
+// ----------------------------------------------------------------------
+// Evict least recently used block from cache.
+void
+cencalvm::storage::CompressedDB::_evict(void)
+{ // _evict
+  assert(!_lru.empty());
+
+  const int iEvict = _lru.back();
+  delete _cache[iEvict]; _cache[iEvict] = 0;
+  _lru.pop_back();
+  ++_stats.numEvictions;
+} // _evict
+
+// ----------------------------------------------------------------------
+// Get decompressed block, reading it if it is not in the cache.
+const cencalvm::storage::CompressedDB::BlockStruct&
+cencalvm::storage::CompressedDB::_block(const int iBlock)
+{ // _block
+  assert(0 <= iBlock && iBlock < int(_index.size()));
+
+  BlockStruct* pBlock = _cache[iBlock];
+  if (0 != pBlock) {
+    _lru.splice(_lru.begin(), _lru, pBlock->lru);
+    return *pBlock;
+  } // if
+
+  if (int(_lru.size()) >= _cacheCapacity)
+    _evict();
+
+  const CompressedDBIndexStruct& entry = _index[iBlock];
+  _buffer.resize(entry.size);
+  if (0 != fseeko(_file, off_t(entry.offset), SEEK_SET) ||
+      1 != fread(&_buffer[0], entry.size, 1, _file)) {
+    std::ostringstream msg;
+    msg << "Could not read block " << iBlock << " of compressed etree "
+	<< "database '" << _filename << "'.";
+    throw std::runtime_error(msg.str());
+  } // if
+  ++_stats.numReads;
+  _stats.bytesRead += entry.size;
+
+  pBlock = new BlockStruct;
+  pBlock->addrs.resize(entry.numOctants);
+  pBlock->payloads.resize(size_t(entry.numOctants)*_header.payloadSize);
+  try {
+    decodeBlock(&pBlock->addrs[0], &pBlock->payloads[0], entry.numOctants,
+		_header.payloadSize, _buffer.data(), _buffer.size());
+  } catch (...) {
+    delete pBlock; pBlock = 0;
+    throw;
+  } // try/catch
+  _lru.push_front(iBlock);
+  pBlock->lru = _lru.begin();
+  _cache[iBlock] = pBlock;
+
+  return *pBlock;
+} // _block
+
+// ----------------------------------------------------------------------
+// Find last octant at or before address in Morton pre-order.
+bool
+cencalvm::storage::CompressedDB::_findLast(int* pBlock,
+					   int* pOctant,
+					   const etree_addr_t& addr)
+{ // _findLast
+  assert(0 != pBlock);
+  assert(0 != pOctant);
+
+  // Last block whose first octant does not follow address.
+  int lower = 0;
+  int upper = _index.size();
+  while (lower < upper) {
+    const int middle = (lower + upper) / 2;
+    etree_addr_t first;
+    first.x = _index[middle].x;
+    first.y = _index[middle].y;
+    first.z = _index[middle].z;
+    first.level = _index[middle].level;
+    if (Geometry::precedes(addr, first))
+      upper = middle;
+    else
+      lower = middle + 1;
+  } // while
+  if (0 == lower)
+    return false;
+  *pBlock = lower - 1;
+
+  // Last octant in block that does not follow address.
+  const std::vector<etree_addr_t>& addrs = _block(*pBlock).addrs;
+  lower = 0;
+  upper = addrs.size();
+  while (lower < upper) {
+    const int middle = (lower + upper) / 2;
+    if (Geometry::precedes(addr, addrs[middle]))
+      upper = middle;
+    else
+      lower = middle + 1;
+  } // while
+  assert(lower > 0);
+  *pOctant = lower - 1;
+
+  return true;
+} // _findLast
+
+// End of file
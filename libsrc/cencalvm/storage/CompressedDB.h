@@ -0,0 +1,287 @@
+// -*- C++ -*-
+//
+// ======================================================================
+//
+//                           Brad T. Aagaard
+//                        U.S. Geological Survey
+//
+// {LicenseText}
+//
+// ======================================================================
+//
+
+/** @file libsrc/storage/CompressedDB.h
+ *
+ * @brief C++ manager of read-only compressed containers of packed
+ * etree databases.
+ *
+ * The octants of a packed etree database are stored in Morton
+ * pre-order in blocks of consecutive octants. Each block is
+ * compressed independently:
+ *
+ * @li The x, y, and z coordinates are stored as differences from the
+ *   previous octant in the block.
+ * @li Each 32-bit word of the payload is XOR'ed with the same word of
+ *   the previous octant, so that similar floating point values give
+ *   words with leading zero bytes.
+ * @li The bytes of each column are regrouped by significance and the
+ *   result is compressed with zlib.
+ *
+ * The file starts with a CompressedDBHeaderStruct followed by the
+ * schema and application metadata of the etree database and the
+ * compressed blocks. The index of blocks, with the first octant in
+ * each block, is at the end of the file. Decompressed blocks are held
+ * in a least recently used cache. Values are stored in the byte order
+ * of the machine that wrote the file.
+ */
+
+#if !defined(cencalvm_storage_compresseddb_h)
+#define cencalvm_storage_compresseddb_h
+
+#include "etreefwd.h" // USES etree_addr_t
+#include "CacheMonitor.h" // HASA CacheStatsStruct
+
+#include <inttypes.h> // USES int32_t, int64_t
+#include <stdio.h> // HOLDSA FILE
+#include <string> // HASA std::string
+#include <vector> // HASA std::vector
+#include <list> // HASA std::list
+
+namespace cencalvm {
+  namespace storage {
+    struct CompressedDBHeaderStruct;
+    struct CompressedDBIndexStruct;
+    class CompressedDB;
+    class TestCompressedDB; // friend
+  } // namespace storage
+} // namespace cencalvm
+
+/// Header of compressed container.
+struct cencalvm::storage::CompressedDBHeaderStruct {
+  char magic[8]; ///< File identifier (CompressedDB::MAGIC)
+  int32_t version; ///< Version of file format
+  int32_t byteOrder; ///< Byte order mark (CompressedDB::BYTEORDER)
+  int32_t payloadSize; ///< Size of payload in bytes
+  int32_t blockSize; ///< Maximum number of octants in a block
+  int64_t numOctants; ///< Total number of octants
+  int64_t numBlocks; ///< Number of blocks
+  int64_t indexOffset; ///< Offset of block index in file
+  int32_t schemaLength; ///< Length of schema that follows header
+  int32_t appmetaLength; ///< Length of metadata that follows schema
+}; // CompressedDBHeaderStruct
+
+/// Entry in index of blocks in compressed container.
+struct cencalvm::storage::CompressedDBIndexStruct {
+  uint32_t x; ///< X coordinate of first octant in block
+  uint32_t y; ///< Y coordinate of first octant in block
+  uint32_t z; ///< Z coordinate of first octant in block
+  int32_t level; ///< Level of first octant in block
+  int64_t offset; ///< Offset of compressed block in file
+  int32_t size; ///< Size of compressed block in bytes
+  int32_t numOctants; ///< Number of octants in block
+}; // CompressedDBIndexStruct
+
+/// C++ manager of read-only compressed containers of packed etree
+/// databases.
+class cencalvm::storage::CompressedDB
+{ // CompressedDB
+  friend class TestCompressedDB; // unit testing
+
+public :
+  // PUBLIC MEMBERS /////////////////////////////////////////////////////
+
+  static const char* MAGIC; ///< File identifier
+  static const int32_t VERSION; ///< Current version of file format
+  static const int32_t BYTEORDER; ///< Byte order mark
+
+public :
+  // PUBLIC METHODS /////////////////////////////////////////////////////
+
+  /// Constructor
+  CompressedDB(void);
+
+  /// Destructor
+  ~CompressedDB(void);
+
+  /** Check whether file is a compressed container.
+   *
+   * @param filename Name of file
+   *
+   * @returns True if file starts with the compressed container
+   *   identifier, false otherwise
+   */
+  static bool isCompressed(const char* filename);
+
+  /** Open compressed container for querying.
+   *
+   * @param filename Name of file
+   * @param cacheSize Size of cache of decompressed blocks in MB
+   */
+  void open(const char* filename,
+	    const int cacheSize);
+
+  /// Close compressed container.
+  void close(void);
+
+  /** Search for octant containing address.
+   *
+   * If the address is a leaf address, the search returns the finest
+   * octant at or above the level of the address that contains it,
+   * consistent with etree_search(). Otherwise the octant must match
+   * the address.
+   *
+   * @param pResAddr Pointer to address of octant found
+   * @param pPayload Pointer to payload of octant found
+   * @param addr Address to search for
+   *
+   * @returns 0 if octant found, nonzero otherwise
+   */
+  int search(etree_addr_t* pResAddr,
+	     void* pPayload,
+	     const etree_addr_t& addr);
+
+  /** Change size of cache of decompressed blocks, evicting least
+   * recently used blocks if the cache shrinks.
+   *
+   * @param cacheSize Size of cache of decompressed blocks in MB
+   */
+  void cacheSize(const int cacheSize);
+
+  /** Get statistics of cache of decompressed blocks since database
+   * was opened.
+   *
+   * @param pStats Pointer to statistics
+   */
+  void cacheStats(CacheStatsStruct* pStats) const;
+
+  /** Get size of payload.
+   *
+   * @returns Size of payload in bytes
+   */
+  int payloadSize(void) const;
+
+  /** Get schema of payload.
+   *
+   * @returns Schema
+   */
+  const char* schema(void) const;
+
+  /** Get application metadata.
+   *
+   * @returns Metadata
+   */
+  const char* appmeta(void) const;
+
+  /** Encode block of octants.
+   *
+   * @param pBuffer Pointer to compressed block
+   * @param pAddrs Array of addresses of octants
+   * @param pPayloads Array of payloads of octants
+   * @param numOctants Number of octants
+   * @param payloadSize Size of payload in bytes
+   */
+  static void encodeBlock(std::string* pBuffer,
+			  const etree_addr_t* pAddrs,
+			  const char* pPayloads,
+			  const int numOctants,
+			  const int payloadSize);
+
+  /** Decode block of octants.
+   *
+   * @param pAddrs Array of addresses of octants
+   * @param pPayloads Array of payloads of octants
+   * @param numOctants Number of octants
+   * @param payloadSize Size of payload in bytes
+   * @param pBuffer Compressed block
+   * @param size Size of compressed block in bytes
+   */
+  static void decodeBlock(etree_addr_t* pAddrs,
+			  char* pPayloads,
+			  const int numOctants,
+			  const int payloadSize,
+			  const char* pBuffer,
+			  const size_t size);
+
+private :
+  // PRIVATE STRUCTS ////////////////////////////////////////////////////
+
+  struct BlockStruct; ///< Decompressed block held in cache
+
+private :
+  // PRIVATE METHODS ////////////////////////////////////////////////////
+
+  /** Search for octant containing address without counting search.
+   *
+   * @param pResAddr Pointer to address of octant found
+   * @param pPayload Pointer to payload of octant found
+   * @param addr Address to search for
+   *
+   * @returns 0 if octant found, nonzero otherwise
+   */
+  int _search(etree_addr_t* pResAddr,
+	      void* pPayload,
+	      const etree_addr_t& addr);
+
+  /** Get number of decompressed blocks that fit in cache.
+   *
+   * @param cacheSize Size of cache of decompressed blocks in MB
+   *
+   * @returns Number of blocks (at least 1)
+   */
+  int _capacity(const int cacheSize) const;
+
+  /// Evict least recently used block from cache.
+  void _evict(void);
+
+  /** Get decompressed block, reading it if it is not in the cache.
+   *
+   * @param iBlock Index of block
+   *
+   * @returns Decompressed block
+   */
+  const BlockStruct& _block(const int iBlock);
+
+  /** Find last octant at or before address in Morton pre-order.
+   *
+   * @param pBlock Pointer to index of block containing octant
+   * @param pOctant Pointer to index of octant in block
+   * @param addr Address
+   *
+   * @returns True if octant found, false if address precedes all
+   *   octants
+   */
+  bool _findLast(int* pBlock,
+		 int* pOctant,
+		 const etree_addr_t& addr);
+
+private :
+  // NOT IMPLEMENTED ////////////////////////////////////////////////////
+
+  CompressedDB(const CompressedDB& d); ///< Not implemented
+  const CompressedDB& operator=(const CompressedDB& d); ///< Not implemented
+
+private :
+  // PRIVATE MEMBERS ////////////////////////////////////////////////////
+
+  CompressedDBHeaderStruct _header; ///< Header of container
+  std::vector<CompressedDBIndexStruct> _index; ///< Index of blocks
+
+  std::string _filename; ///< Name of file
+  std::string _schema; ///< Schema of payload
+  std::string _appmeta; ///< Application metadata
+
+  std::vector<BlockStruct*> _cache; ///< Cached blocks (0 if not cached)
+  std::list<int> _lru; ///< Cached blocks, most recently used first
+  std::string _buffer; ///< Buffer for compressed block
+  CacheStatsStruct _stats; ///< Statistics of cache
+
+  FILE* _file; ///< Handle to file
+  int _cacheCapacity; ///< Maximum number of cached blocks
+
+}; // CompressedDB
+
+#include "CompressedDB.icc" // inline methods
+
+#endif // cencalvm_storage_compresseddb_h
+
+// End of file
@@ -0,0 +1,135 @@
+// -*- C++ -*-
+//
+// ======================================================================
+//
+//                           Brad T. Aagaard
+//                        U.S. Geological Survey
+//
+// {LicenseText}
+//
+// ======================================================================
+//
+
+#include "DBSnapshot.h" // implementation of class methods
+
+#include <stdio.h> // USES fopen(), fread(), fwrite(), fclose(), rename()
+#include <unistd.h> // USES fsync()
+#include <sys/stat.h> // USES stat()
+#include <vector> // USES std::vector
+
+#include <stdexcept> // USES std::runtime_error
+#include <sstream> // USES std::ostringstream
+#include <assert.h> // USES assert()
+
+// ----------------------------------------------------------------------
+const int cencalvm::storage::DBSnapshot::NUMSLOTS = 2;
+
+// ----------------------------------------------------------------------
+// Get name of snapshot file of database.
+std::string
+cencalvm::storage::DBSnapshot::filename(const char* filenameDB,
+					const int slot)
+{ // filename
+  assert(0 != filenameDB);
+  assert(slot >= 0 && slot < NUMSLOTS);
+
+  std::ostringstream filename;
+  filename << filenameDB << ".snapshot" << slot;
+  return filename.str();
+} // filename
+
+// ----------------------------------------------------------------------
+// Copy closed database to snapshot.
+uint64_t
+cencalvm::storage::DBSnapshot::save(const char* filenameDB,
+				    const int slot)
+{ // save
+  const std::string filenameSnapshot = filename(filenameDB, slot);
+  return _copy(filenameSnapshot.c_str(), filenameDB);
+} // save
+
+// ----------------------------------------------------------------------
+// Replace database with snapshot.
+void
+cencalvm::storage::DBSnapshot::restore(const char* filenameDB,
+				       const int slot,
+				       const uint64_t length)
+{ // restore
+  const std::string filenameSnapshot = filename(filenameDB, slot);
+  struct stat fileInfo;
+  if (0 != stat(filenameSnapshot.c_str(), &fileInfo) ||
+      uint64_t(fileInfo.st_size) != length) {
+    std::ostringstream msg;
+    msg << "Snapshot '" << filenameSnapshot << "' of etree database '"
+	<< filenameDB << "' is missing or does not have the length of the "
+	<< "database at the checkpoint (" << length << " bytes).";
+    throw std::runtime_error(msg.str());
+  } // if
+  _copy(filenameDB, filenameSnapshot.c_str());
+} // restore
+
+// ----------------------------------------------------------------------
+// Remove snapshots of database.
+void
+cencalvm::storage::DBSnapshot::remove(const char* filenameDB)
+{ // remove
+  for (int slot=0; slot < NUMSLOTS; ++slot)
+    ::remove(filename(filenameDB, slot).c_str());
+} // remove
+
+// ----------------------------------------------------------------------
+// Copy file, replacing destination only after copy is complete.
+uint64_t
+cencalvm::storage::DBSnapshot::_copy(const char* filenameDest,
+				     const char* filenameSrc)
+{ // _copy
+  assert(0 != filenameDest);
+  assert(0 != filenameSrc);
+
+  FILE* fin = fopen(filenameSrc, "rb");
+  if (0 == fin) {
+    std::ostringstream msg;
+    msg << "Could not open '" << filenameSrc << "' for copying.";
+    throw std::runtime_error(msg.str());
+  } // if
+  const std::string filenameTmp = std::string(filenameDest) + ".tmp";
+  FILE* fout = fopen(filenameTmp.c_str(), "wb");
+  if (0 == fout) {
+    fclose(fin);
+    std::ostringstream msg;
+    msg << "Could not open '" << filenameTmp << "' for writing.";
+    throw std::runtime_error(msg.str());
+  } // if
+
+  const size_t bufferSize = 1024*1024;
+  std::vector<char> buffer(bufferSize);
+  uint64_t numBytes = 0;
+  bool isOkay = true;
+  while (isOkay) {
+    const size_t numRead = fread(&buffer[0], 1, bufferSize, fin);
+    if (numRead > 0)
+      isOkay = numRead == fwrite(&buffer[0], 1, numRead, fout);
+    numBytes += numRead;
+    if (numRead < bufferSize) {
+      isOkay = isOkay && !ferror(fin);
+      break;
+    } // if
+  } // while
+  fclose(fin);
+
+  // The copy must be on disk before it replaces the destination.
+  isOkay = isOkay && 0 == fflush(fout) && 0 == fsync(fileno(fout));
+  if (0 != fclose(fout))
+    isOkay = false;
+  if (!isOkay || 0 != rename(filenameTmp.c_str(), filenameDest)) {
+    ::remove(filenameTmp.c_str());
+    std::ostringstream msg;
+    msg << "Could not copy '" << filenameSrc << "' to '" << filenameDest
+	<< "'.";
+    throw std::runtime_error(msg.str());
+  } // if
+
+  return numBytes;
+} // _copy
+
+// End of file
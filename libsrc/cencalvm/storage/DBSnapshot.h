@@ -0,0 +1,116 @@
+// -*- C++ -*-
+//
+// ======================================================================
+//
+//                           Brad T. Aagaard
+//                        U.S. Geological Survey
+//
+// {LicenseText}
+//
+// ======================================================================
+//
+
+/** @file libsrc/storage/DBSnapshot.h
+ *
+ * @brief C++ manager of snapshots of etree databases written at
+ * checkpoints.
+ *
+ * Etree writes its metadata when a database is closed, and dirty
+ * pages evicted while a process appends or inserts octants overwrite
+ * pages of the file in place. A database left by a process that was
+ * killed after a checkpoint is therefore not necessarily the database
+ * at the checkpoint, or even a valid tree. At a checkpoint the
+ * database is closed and copied to a snapshot file, and resuming
+ * copies the snapshot back before the database is reopened.
+ *
+ * Snapshots alternate between two slots, so the snapshot referred to
+ * by the last complete checkpoint is never overwritten while the next
+ * checkpoint is written. Each snapshot is written to a temporary file
+ * and renamed when complete.
+ */
+
+#if !defined(cencalvm_storage_dbsnapshot_h)
+#define cencalvm_storage_dbsnapshot_h
+
+#include <inttypes.h> // USES uint64_t
+#include <string> // USES std::string
+
+namespace cencalvm {
+  namespace storage {
+    class DBSnapshot;
+    class TestDBSnapshot; // friend
+  } // namespace storage
+} // namespace cencalvm
+
+/// C++ manager of snapshots of etree databases written at checkpoints.
+class cencalvm::storage::DBSnapshot
+{ // DBSnapshot
+  friend class TestDBSnapshot; // unit testing
+
+public :
+  // PUBLIC MEMBERS /////////////////////////////////////////////////////
+
+  static const int NUMSLOTS; ///< Number of snapshot slots
+
+public :
+  // PUBLIC METHODS /////////////////////////////////////////////////////
+
+  /** Get name of snapshot file of database.
+   *
+   * @param filenameDB Name of etree database
+   * @param slot Index of snapshot slot
+   *
+   * @returns Name of snapshot file (filenameDB + ".snapshot" + slot)
+   */
+  static std::string filename(const char* filenameDB,
+			      const int slot);
+
+  /** Copy closed database to snapshot.
+   *
+   * @param filenameDB Name of etree database
+   * @param slot Index of snapshot slot
+   *
+   * @returns Length of database file in bytes
+   */
+  static uint64_t save(const char* filenameDB,
+		       const int slot);
+
+  /** Replace database with snapshot.
+   *
+   * @param filenameDB Name of etree database
+   * @param slot Index of snapshot slot
+   * @param length Length of database file in bytes when snapshot was
+   * saved
+   */
+  static void restore(const char* filenameDB,
+		      const int slot,
+		      const uint64_t length);
+
+  /** Remove snapshots of database.
+   *
+   * @param filenameDB Name of etree database
+   */
+  static void remove(const char* filenameDB);
+
+private :
+  // PRIVATE METHODS ////////////////////////////////////////////////////
+
+  /** Copy file, replacing destination only after copy is complete.
+   *
+   * @param filenameDest Name of destination file
+   * @param filenameSrc Name of source file
+   *
+   * @returns Number of bytes copied
+   */
+  static uint64_t _copy(const char* filenameDest,
+			const char* filenameSrc);
+
+  DBSnapshot(void); ///< Not implemented
+  DBSnapshot(const DBSnapshot& s); ///< Not implemented
+  const DBSnapshot& operator=(const DBSnapshot& s); ///< Not implemented
+
+}; // DBSnapshot
+
+#endif // cencalvm_storage_dbsnapshot_h
+
+// End of file
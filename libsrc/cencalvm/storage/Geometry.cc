@@ -51,6 +51,55 @@ cencalvm::storage::Geometry::findAncestor(etree_addr_t* pAncestorAddr,
   pAncestorAddr->type  = ETREE_INTERIOR;
 } // findParent
 
+// ----------------------------------------------------------------------
+// Check whether octant comes before another octant in etree order.
+bool
+cencalvm::storage::Geometry::precedes(const etree_addr_t& addrA,
+				      const etree_addr_t& addrB)
+{ // precedes
+  const etree_tick_t diffX = addrA.x ^ addrB.x;
+  const etree_tick_t diffY = addrA.y ^ addrB.y;
+  const etree_tick_t diffZ = addrA.z ^ addrB.z;
+
+  // Same corner, so coarser octant is the ancestor and comes first.
+  if (0 == (diffX | diffY | diffZ))
+    return addrA.level < addrB.level;
+
+  // Order is determined by the coordinate with the most significant
+  // differing bit; for bits at the same level z beats y beats x. The
+  // most significant bit of a is less than that of b if a < b and
+  // a < (a ^ b).
+  etree_tick_t diff = diffZ;
+  etree_tick_t coordA = addrA.z;
+  etree_tick_t coordB = addrB.z;
+  if (diff < diffY && diff < (diff ^ diffY)) {
+    diff = diffY;
+    coordA = addrA.y;
+    coordB = addrB.y;
+  } // if
+  if (diff < diffX && diff < (diff ^ diffX)) {
+    coordA = addrA.x;
+    coordB = addrB.x;
+  } // if
+
+  return coordA < coordB;
+} // precedes
+
+// ----------------------------------------------------------------------
+// Check whether octant contains another octant.
+bool
+cencalvm::storage::Geometry::contains(const etree_addr_t& addrA,
+				      const etree_addr_t& addrB)
+{ // contains
+  if (addrA.level > addrB.level)
+    return false;
+
+  const etree_tick_t mask = ((signed) _LEFTMOSTONE) >> addrA.level;
+  return ((addrB.x & mask) == addrA.x &&
+	  (addrB.y & mask) == addrA.y &&
+	  (addrB.z & mask) == addrA.z);
+} // contains
+
 // version
 // $Id$
 
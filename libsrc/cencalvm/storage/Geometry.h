@@ -114,6 +114,31 @@ public :
 			   const etree_addr_t& childAddr,
 			   const int ancestorLevel);
 
+  /** Check whether octant comes before another octant in the order
+   * in which octants are stored in the etree (preorder traversal,
+   * with z the most significant coordinate and x the least).
+   *
+   * Ancestors come before their descendants.
+   *
+   * @param addrA Address of first octant
+   * @param addrB Address of second octant
+   *
+   * @returns True if first octant comes before second octant
+   */
+  static bool precedes(const etree_addr_t& addrA,
+		       const etree_addr_t& addrB);
+
+  /** Check whether octant contains another octant.
+   *
+   * @param addrA Address of first octant
+   * @param addrB Address of second octant
+   *
+   * @returns True if first octant is the second octant or one of its
+   *   ancestors
+   */
+  static bool contains(const etree_addr_t& addrA,
+		       const etree_addr_t& addrB);
+
  private :
   // PRIVATE METHODS ////////////////////////////////////////////////////
 
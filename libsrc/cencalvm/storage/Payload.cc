@@ -23,6 +23,22 @@ const char* cencalvm::storage::Payload::SCHEMA =
   "int16_t FaultBlock; "
   "int16_t Zone;";
 
+const char* cencalvm::storage::Payload::SCHEMACOMPACT = 
+  "uint16_t Vp; "
+  "uint16_t Vs; "
+  "uint16_t Density; "
+  "uint16_t Qp; "
+  "uint16_t Qs; "
+  "uint16_t DepthFreeSurf; "
+  "int16_t FaultBlock; "
+  "int16_t Zone;";
+
+const char* cencalvm::storage::Payload::SCHEMAINDEX = 
+  "uint32_t Index;";
+
+const char* cencalvm::storage::Payload::COMPACTEDTAG =
+  "collapsed homogeneous subtrees";
+
 const float cencalvm::storage::Payload::NODATAVAL = -999.0;
 const short cencalvm::storage::Payload::NODATABLOCK = 0;
 const short cencalvm::storage::Payload::NODATAZONE = 0;
@@ -23,6 +23,8 @@
 namespace cencalvm {
   namespace storage {
     struct PayloadStruct;
+    struct PayloadCompactStruct;
+    struct PayloadIndexStruct;
     class Payload;
   } // namespace storage
 } // namespace cencalvm
@@ -55,6 +57,34 @@ struct cencalvm::storage::PayloadStruct {
   int16_t Zone;
 }; // struct PayloadStruct
 
+/** Quantized data stored in compact velocity model database.
+ *
+ * Each floating point value is stored as an unsigned 16-bit code
+ * using the quantization parameters of the database (see
+ * PayloadCodec). Fault block and zone identifiers are stored without
+ * modification.
+ */
+struct cencalvm::storage::PayloadCompactStruct {
+  uint16_t Vp; ///< Quantized P wave speed
+  uint16_t Vs; ///< Quantized S wave speed
+  uint16_t Density; ///< Quantized density
+  uint16_t Qp; ///< Quantized Q for P waves
+  uint16_t Qs; ///< Quantized Q for S waves
+  uint16_t DepthFreeSurf; ///< Quantized depth wrt free surface
+  int16_t FaultBlock; ///< Fault block identifier
+  int16_t Zone; ///< Zone identifier
+}; // struct PayloadCompactStruct
+
+/** Index of payload stored in dictionary-encoded velocity model
+ * database.
+ *
+ * The payload is entry Index in the dictionary of the database (see
+ * PayloadDictionary).
+ */
+struct cencalvm::storage::PayloadIndexStruct {
+  uint32_t Index; ///< Index of payload in dictionary
+}; // struct PayloadIndexStruct
+
 /// C++ manager of data structures for velocity model.
 class cencalvm::storage::Payload
 { // Payload
@@ -62,6 +92,12 @@ public :
   // PUBLIC MEMBERS /////////////////////////////////////////////////////
 
   static const char* SCHEMA; ///< Database schema
+  static const char* SCHEMACOMPACT; ///< Database schema for quantized payload
+  static const char* SCHEMAINDEX; ///< Database schema for dictionary index
+
+  /// Label in metadata of databases with homogeneous subtrees
+  /// collapsed into single leaf octants
+  static const char* COMPACTEDTAG;
 
   static const float NODATAVAL; ///< Database flags for no data
   static const short NODATABLOCK; ///< Database flags for no data
@@ -0,0 +1,260 @@
+// -*- C++ -*-
+//
+// ======================================================================
+//
+//                           Brad T. Aagaard
+//                        U.S. Geological Survey
+//
+// {LicenseText}
+//
+// ======================================================================
+//
+
+#include "PayloadCodec.h" // implementation of class methods
+
+#include "Payload.h" // USES PayloadStruct, PayloadCompactStruct
+
+#include <math.h> // USES floor()
+#include <stdlib.h> // USES strtod()
+#include <string.h> // USES strstr(), strchr(), strcmp(), strlen()
+#include <limits> // USES std::numeric_limits
+
+#include <stdexcept> // USES std::runtime_error
+#include <sstream> // USES std::ostringstream, std::istringstream
+#include <iomanip> // USES std::setprecision()
+#include <assert.h> // USES assert()
+
+// ----------------------------------------------------------------------
+namespace {
+  /// Code for values equal to Payload::NODATAVAL.
+  const uint16_t NODATACODE = 0xFFFF;
+  /// Maximum code for values with data.
+  const uint16_t MAXCODE = 0xFFFE;
+} // namespace
+
+const int cencalvm::storage::PayloadCodec::NUMVALUES = 6;
+const char* cencalvm::storage::PayloadCodec::NAMES[] = {
+  "Vp",
+  "Vs",
+  "Density",
+  "Qp",
+  "Qs",
+  "DepthFreeSurf",
+};
+const char* cencalvm::storage::PayloadCodec::METADATATAG =
+  "payload quantization:";
+
+// ----------------------------------------------------------------------
+// Constructor
+cencalvm::storage::PayloadCodec::PayloadCodec(void)
+{ // constructor
+  const double defaultBounds[] = { 0.5, 0.5, 0.5, 0.05, 0.05, 0.5 };
+  for (int i=0; i < NUMVALUES; ++i) {
+    _errorBound[i] = defaultBounds[i];
+    _offset[i] = 0.0;
+    _step[i] = 2.0*defaultBounds[i];
+  } // for
+  resetRange();
+} // constructor
+
+// ----------------------------------------------------------------------
+// Destructor
+cencalvm::storage::PayloadCodec::~PayloadCodec(void)
+{ // destructor
+} // destructor
+
+// ----------------------------------------------------------------------
+// Set maximum error in quantized value.
+void
+cencalvm::storage::PayloadCodec::errorBound(const char* name,
+					    const double bound)
+{ // errorBound
+  if (bound <= 0.0) {
+    std::ostringstream msg;
+    msg << "Error bound for '" << name << "' must be positive. Bound given "
+	<< "is " << bound << ".";
+    throw std::runtime_error(msg.str());
+  } // if
+  _errorBound[_index(name)] = bound;
+} // errorBound
+
+// ----------------------------------------------------------------------
+// Get maximum error in quantized value.
+double
+cencalvm::storage::PayloadCodec::errorBound(const char* name) const
+{ // errorBound
+  return _errorBound[_index(name)];
+} // errorBound
+
+// ----------------------------------------------------------------------
+// Clear range of values used to set quantization parameters.
+void
+cencalvm::storage::PayloadCodec::resetRange(void)
+{ // resetRange
+  for (int i=0; i < NUMVALUES; ++i) {
+    _valMin[i] = std::numeric_limits<double>::max();
+    _valMax[i] = -std::numeric_limits<double>::max();
+  } // for
+} // resetRange
+
+// ----------------------------------------------------------------------
+// Expand range of values to include values in payload.
+void
+cencalvm::storage::PayloadCodec::updateRange(const PayloadStruct& payload)
+{ // updateRange
+  const float* pVals = &payload.Vp;
+  for (int i=0; i < NUMVALUES; ++i) {
+    if (Payload::NODATAVAL == pVals[i])
+      continue;
+    if (pVals[i] < _valMin[i])
+      _valMin[i] = pVals[i];
+    if (pVals[i] > _valMax[i])
+      _valMax[i] = pVals[i];
+  } // for
+} // updateRange
+
+// ----------------------------------------------------------------------
+// Set quantization parameters from range of values and error bounds.
+void
+cencalvm::storage::PayloadCodec::initialize(void)
+{ // initialize
+  for (int i=0; i < NUMVALUES; ++i) {
+    _step[i] = 2.0*_errorBound[i];
+    _offset[i] = (_valMin[i] <= _valMax[i]) ? _valMin[i] : 0.0;
+    if (_valMin[i] <= _valMax[i] &&
+	floor((_valMax[i] - _offset[i]) / _step[i] + 0.5) > MAXCODE) {
+      std::ostringstream msg;
+      msg
+	<< "Range of values for '" << NAMES[i] << "' (" << _valMin[i]
+	<< " to " << _valMax[i] << ") is too large to quantize with an "
+	<< "error bound of " << _errorBound[i] << ".\n"
+	<< "Error bound must be at least "
+	<< 0.5*(_valMax[i] - _valMin[i]) / MAXCODE << ".";
+      throw std::runtime_error(msg.str());
+    } // if
+  } // for
+} // initialize
+
+// ----------------------------------------------------------------------
+// Quantize payload.
+void
+cencalvm::storage::PayloadCodec::encode(PayloadCompactStruct* pCompact,
+					const PayloadStruct& payload) const
+{ // encode
+  assert(0 != pCompact);
+
+  const float* pVals = &payload.Vp;
+  uint16_t* pCodes = &pCompact->Vp;
+  for (int i=0; i < NUMVALUES; ++i) {
+    if (Payload::NODATAVAL == pVals[i]) {
+      pCodes[i] = NODATACODE;
+      continue;
+    } // if
+    const double code = floor((pVals[i] - _offset[i]) / _step[i] + 0.5);
+    if (code < 0.0 || code > MAXCODE) {
+      std::ostringstream msg;
+      msg
+	<< "Value " << pVals[i] << " for '" << NAMES[i] << "' is outside "
+	<< "the range of values that can be represented with the "
+	<< "quantization parameters.";
+      throw std::runtime_error(msg.str());
+    } // if
+    pCodes[i] = uint16_t(code);
+  } // for
+  pCompact->FaultBlock = payload.FaultBlock;
+  pCompact->Zone = payload.Zone;
+} // encode
+
+// ----------------------------------------------------------------------
+// Restore payload from compact payload.
+void
+cencalvm::storage::PayloadCodec::decode(PayloadStruct* pPayload,
+					const PayloadCompactStruct& compact) const
+{ // decode
+  assert(0 != pPayload);
+
+  const uint16_t* pCodes = &compact.Vp;
+  float* pVals = &pPayload->Vp;
+  for (int i=0; i < NUMVALUES; ++i)
+    pVals[i] = (NODATACODE == pCodes[i]) ?
+      Payload::NODATAVAL : _offset[i] + _step[i]*pCodes[i];
+  pPayload->FaultBlock = compact.FaultBlock;
+  pPayload->Zone = compact.Zone;
+} // decode
+
+// ----------------------------------------------------------------------
+// Get quantization parameters as line of metadata.
+std::string
+cencalvm::storage::PayloadCodec::metadata(void) const
+{ // metadata
+  std::ostringstream info;
+  info << METADATATAG << std::setprecision(17);
+  for (int i=0; i < NUMVALUES; ++i)
+    info << " " << NAMES[i] << "=" << _offset[i] << "," << _step[i];
+  return info.str();
+} // metadata
+
+// ----------------------------------------------------------------------
+// Set quantization parameters from metadata of database.
+void
+cencalvm::storage::PayloadCodec::parseMetadata(const char* appmeta)
+{ // parseMetadata
+  const char* line = (0 != appmeta) ? strstr(appmeta, METADATATAG) : 0;
+  if (0 == line)
+    throw std::runtime_error("Could not find quantization parameters in "
+			     "metadata of compact etree database.");
+  line += strlen(METADATATAG);
+  const char* lineEnd = strchr(line, '\n');
+  std::istringstream sin((0 != lineEnd) ?
+			 std::string(line, lineEnd) : std::string(line));
+
+  bool found[6];
+  for (int i=0; i < NUMVALUES; ++i)
+    found[i] = false;
+  std::string token;
+  while (sin >> token) {
+    const size_t posEq = token.find('=');
+    const size_t posComma = token.find(',');
+    if (std::string::npos == posEq || std::string::npos == posComma ||
+	posComma < posEq) {
+      std::ostringstream msg;
+      msg << "Could not parse quantization parameters '" << token
+	  << "' in metadata of compact etree database.";
+      throw std::runtime_error(msg.str());
+    } // if
+    const int index = _index(token.substr(0, posEq).c_str());
+    _offset[index] = strtod(token.c_str()+posEq+1, 0);
+    _step[index] = strtod(token.c_str()+posComma+1, 0);
+    _errorBound[index] = 0.5*_step[index];
+    found[index] = true;
+  } // while
+
+  for (int i=0; i < NUMVALUES; ++i)
+    if (!found[i] || _step[i] <= 0.0) {
+      std::ostringstream msg;
+      msg << "Missing quantization parameters for '" << NAMES[i]
+	  << "' in metadata of compact etree database.";
+      throw std::runtime_error(msg.str());
+    } // if
+} // parseMetadata
+
+// ----------------------------------------------------------------------
+// Get index of value in payload.
+int
+cencalvm::storage::PayloadCodec::_index(const char* name)
+{ // _index
+  assert(0 != name);
+
+  for (int i=0; i < NUMVALUES; ++i)
+    if (0 == strcmp(name, NAMES[i]))
+      return i;
+
+  std::ostringstream msg;
+  msg << "Unknown payload value '" << name << "'. Known values are:";
+  for (int i=0; i < NUMVALUES; ++i)
+    msg << " " << NAMES[i];
+  msg << ".";
+  throw std::runtime_error(msg.str());
+} // _index
+
+// End of file
@@ -0,0 +1,154 @@
+// -*- C++ -*-
+//
+// ======================================================================
+//
+//                           Brad T. Aagaard
+//                        U.S. Geological Survey
+//
+// {LicenseText}
+//
+// ======================================================================
+//
+
+/** @file libsrc/storage/PayloadCodec.h
+ *
+ * @brief C++ object for quantizing payloads of velocity model into
+ * compact payloads and restoring them.
+ *
+ * Each floating point value is stored as an unsigned 16-bit code q
+ * with value = offset + step*q, where the step is twice the error
+ * bound for the value and the offset is the minimum value in the
+ * database. The code 0xFFFF is reserved for Payload::NODATAVAL. The
+ * quantization parameters are stored in the application metadata of
+ * the compact database, so queries can restore the values without
+ * any additional input.
+ */
+
+#if !defined(cencalvm_storage_payloadcodec_h)
+#define cencalvm_storage_payloadcodec_h
+
+#include <string> // USES std::string
+
+namespace cencalvm {
+  namespace storage {
+    class PayloadCodec;
+    class TestPayloadCodec; // friend
+
+    struct PayloadStruct; // USES PayloadStruct
+    struct PayloadCompactStruct; // USES PayloadCompactStruct
+  } // namespace storage
+} // namespace cencalvm
+
+/// C++ object for quantizing payloads of velocity model.
+class cencalvm::storage::PayloadCodec
+{ // PayloadCodec
+  friend class TestPayloadCodec; // unit testing
+
+public :
+  // PUBLIC MEMBERS /////////////////////////////////////////////////////
+
+  static const int NUMVALUES; ///< Number of quantized values in payload
+  static const char* NAMES[]; ///< Names of quantized values
+  static const char* METADATATAG; ///< Label for parameters in metadata
+
+public :
+  // PUBLIC METHODS /////////////////////////////////////////////////////
+
+  /// Constructor
+  PayloadCodec(void);
+
+  /// Destructor
+  ~PayloadCodec(void);
+
+  /** Set maximum error in quantized value.
+   *
+   * Default error bounds are 0.5 m/s for Vp and Vs, 0.5 kg/m^3 for
+   * Density, 0.05 for Qp and Qs, and 0.5 m for DepthFreeSurf.
+   *
+   * @param name Name of value in payload
+   * @param bound Maximum absolute error
+   */
+  void errorBound(const char* name,
+		  const double bound);
+
+  /** Get maximum error in quantized value.
+   *
+   * @param name Name of value in payload
+   *
+   * @returns Maximum absolute error
+   */
+  double errorBound(const char* name) const;
+
+  /// Clear range of values used to set quantization parameters.
+  void resetRange(void);
+
+  /** Expand range of values to include values in payload.
+   *
+   * @param payload Payload
+   */
+  void updateRange(const PayloadStruct& payload);
+
+  /** Set quantization parameters from range of values and error
+   * bounds.
+   */
+  void initialize(void);
+
+  /** Quantize payload.
+   *
+   * @param pCompact Pointer to compact payload
+   * @param payload Payload
+   */
+  void encode(PayloadCompactStruct* pCompact,
+	      const PayloadStruct& payload) const;
+
+  /** Restore payload from compact payload.
+   *
+   * @param pPayload Pointer to payload
+   * @param compact Compact payload
+   */
+  void decode(PayloadStruct* pPayload,
+	      const PayloadCompactStruct& compact) const;
+
+  /** Get quantization parameters as line of metadata.
+   *
+   * @returns Metadata
+   */
+  std::string metadata(void) const;
+
+  /** Set quantization parameters from metadata of database.
+   *
+   * @param appmeta Application metadata of compact database
+   */
+  void parseMetadata(const char* appmeta);
+
+private :
+  // PRIVATE METHODS ////////////////////////////////////////////////////
+
+  /** Get index of value in payload.
+   *
+   * @param name Name of value
+   *
+   * @returns Index of value
+   */
+  static int _index(const char* name);
+
+private :
+  // NOT IMPLEMENTED ////////////////////////////////////////////////////
+
+  PayloadCodec(const PayloadCodec& c); ///< Not implemented
+  const PayloadCodec& operator=(const PayloadCodec& c); ///< Not implemented
+
+private :
+  // PRIVATE MEMBERS ////////////////////////////////////////////////////
+
+  double _errorBound[6]; ///< Maximum error of each value
+  double _valMin[6]; ///< Minimum of each value
+  double _valMax[6]; ///< Maximum of each value
+  double _offset[6]; ///< Value corresponding to code 0
+  double _step[6]; ///< Change in value between codes
+
+}; // PayloadCodec
+
+#endif // cencalvm_storage_payloadcodec_h
+
+// End of file
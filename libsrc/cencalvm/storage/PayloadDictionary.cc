@@ -0,0 +1,207 @@
+// -*- C++ -*-
+//
+// ======================================================================
+//
+//                           Brad T. Aagaard
+//                        U.S. Geological Survey
+//
+// {LicenseText}
+//
+// ======================================================================
+//
+
+#include "PayloadDictionary.h" // implementation of class methods
+
+#include <stdio.h> // USES fopen(), fread(), fwrite(), fclose()
+#include <string.h> // USES memcmp(), memcpy(), memset(), strstr(), strchr()
+#include <sys/stat.h> // USES stat()
+
+#include <stdexcept> // USES std::runtime_error
+#include <sstream> // USES std::ostringstream
+#include <assert.h> // USES assert()
+
+// ----------------------------------------------------------------------
+const char* cencalvm::storage::PayloadDictionary::MAGIC = "CVMDICT";
+const int32_t cencalvm::storage::PayloadDictionary::VERSION = 1;
+const int32_t cencalvm::storage::PayloadDictionary::BYTEORDER = 0x01020304;
+const uint32_t cencalvm::storage::PayloadDictionary::MAXENTRIES = 0xffffffff;
+const char* cencalvm::storage::PayloadDictionary::METADATATAG =
+  "payload dictionary:";
+
+// ----------------------------------------------------------------------
+// Constructor
+cencalvm::storage::PayloadDictionary::PayloadDictionary(void)
+{ // constructor
+} // constructor
+
+// ----------------------------------------------------------------------
+// Destructor
+cencalvm::storage::PayloadDictionary::~PayloadDictionary(void)
+{ // destructor
+} // destructor
+
+// ----------------------------------------------------------------------
+// Get name of dictionary file of database.
+std::string
+cencalvm::storage::PayloadDictionary::filename(const char* filenameDB)
+{ // filename
+  assert(0 != filenameDB);
+  return std::string(filenameDB) + ".dict";
+} // filename
+
+// ----------------------------------------------------------------------
+// Get line of metadata recording dictionary file of database.
+std::string
+cencalvm::storage::PayloadDictionary::metadata(const char* filenameDict)
+{ // metadata
+  assert(0 != filenameDict);
+
+  const char* basename = strrchr(filenameDict, '/');
+  basename = (0 != basename) ? basename+1 : filenameDict;
+  return std::string(METADATATAG) + " " + basename;
+} // metadata
+
+// ----------------------------------------------------------------------
+// Find dictionary file of database.
+std::string
+cencalvm::storage::PayloadDictionary::find(const char* filenameDB,
+					   const char* appmeta)
+{ // find
+  assert(0 != filenameDB);
+
+  const std::string filenameDefault = filename(filenameDB);
+  struct stat fileInfo;
+  if (0 == stat(filenameDefault.c_str(), &fileInfo))
+    return filenameDefault;
+
+  // Later lines (for example, added when the database was
+  // compressed) take precedence over earlier ones.
+  const char* line = 0;
+  for (const char* next = (0 != appmeta) ? strstr(appmeta, METADATATAG) : 0;
+       0 != next;
+       next = strstr(next+1, METADATATAG))
+    line = next;
+  if (0 == line)
+    return filenameDefault;
+  line += strlen(METADATATAG);
+  while (' ' == *line)
+    ++line;
+  const char* lineEnd = strchr(line, '\n');
+  const std::string basename = (0 != lineEnd) ?
+    std::string(line, lineEnd) : std::string(line);
+  if (basename.empty())
+    return filenameDefault;
+
+  const char* dirEnd = strrchr(filenameDB, '/');
+  return (0 != dirEnd) ?
+    std::string(filenameDB, dirEnd+1) + basename : basename;
+} // find
+
+// ----------------------------------------------------------------------
+// Read dictionary from file.
+void
+cencalvm::storage::PayloadDictionary::read(const char* filename)
+{ // read
+  assert(0 != filename);
+
+  _entries.clear();
+
+  FILE* fin = fopen(filename, "rb");
+  if (0 == fin) {
+    std::ostringstream msg;
+    msg << "Could not open payload dictionary '" << filename
+	<< "' for reading.";
+    throw std::runtime_error(msg.str());
+  } // if
+
+  std::ostringstream msg;
+  PayloadDictionaryHeaderStruct header;
+  if (1 != fread(&header, sizeof(header), 1, fin) ||
+      0 != memcmp(header.magic, MAGIC, sizeof(header.magic)))
+    msg << "File '" << filename << "' is not a payload dictionary.";
+  else if (BYTEORDER != header.byteOrder)
+    msg << "Payload dictionary '" << filename << "' was written on a "
+	<< "machine with a different byte order.";
+  else if (VERSION != header.version)
+    msg << "Unknown version " << header.version << " of payload dictionary '"
+	<< filename << "'. Expected version " << VERSION << ".";
+  else if (int32_t(sizeof(PayloadStruct)) != header.payloadSize)
+    msg << "Payload size " << header.payloadSize << " of payload dictionary '"
+	<< filename << "' doesn't match the expected payload size "
+	<< sizeof(PayloadStruct) << ".";
+  else {
+    _entries.resize(header.numEntries);
+    if (header.numEntries > 0 &&
+	1 != fread(&_entries[0], header.numEntries*sizeof(PayloadStruct), 1,
+		   fin))
+      msg << "Could not read " << header.numEntries << " payloads from "
+	  << "payload dictionary '" << filename << "'.";
+  } // if/else
+  fclose(fin);
+
+  if (msg.str().length() > 0) {
+    _entries.clear();
+    throw std::runtime_error(msg.str());
+  } // if
+} // read
+
+// ----------------------------------------------------------------------
+// Write dictionary to file.
+void
+cencalvm::storage::PayloadDictionary::write(const char* filename) const
+{ // write
+  assert(0 != filename);
+
+  FILE* fout = fopen(filename, "wb");
+  if (0 == fout) {
+    std::ostringstream msg;
+    msg << "Could not open payload dictionary '" << filename
+	<< "' for writing.";
+    throw std::runtime_error(msg.str());
+  } // if
+
+  PayloadDictionaryHeaderStruct header;
+  memset(&header, 0, sizeof(header));
+  memcpy(header.magic, MAGIC, sizeof(header.magic));
+  header.version = VERSION;
+  header.byteOrder = BYTEORDER;
+  header.payloadSize = sizeof(PayloadStruct);
+  header.numEntries = _entries.size();
+
+  bool isOkay = (1 == fwrite(&header, sizeof(header), 1, fout));
+  if (isOkay && _entries.size() > 0)
+    isOkay = (1 == fwrite(&_entries[0], _entries.size()*sizeof(PayloadStruct),
+			  1, fout));
+  if (0 != fclose(fout))
+    isOkay = false;
+  if (!isOkay) {
+    std::ostringstream msg;
+    msg << "Could not write payload dictionary '" << filename << "'.";
+    throw std::runtime_error(msg.str());
+  } // if
+} // write
+
+// ----------------------------------------------------------------------
+// Add payload to end of dictionary.
+uint32_t
+cencalvm::storage::PayloadDictionary::append(const PayloadStruct& payload)
+{ // append
+  if (_entries.size() >= MAXENTRIES) {
+    std::ostringstream msg;
+    msg << "Number of payloads in payload dictionary exceeds maximum of "
+	<< MAXENTRIES << ".";
+    throw std::runtime_error(msg.str());
+  } // if
+  _entries.push_back(payload);
+  return _entries.size() - 1;
+} // append
+
+// ----------------------------------------------------------------------
+// Remove all payloads from dictionary.
+void
+cencalvm::storage::PayloadDictionary::clear(void)
+{ // clear
+  _entries.clear();
+} // clear
+
+// End of file
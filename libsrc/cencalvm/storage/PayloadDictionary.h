@@ -0,0 +1,170 @@
+// -*- C++ -*-
+//
+// ======================================================================
+//
+//                           Brad T. Aagaard
+//                        U.S. Geological Survey
+//
+// {LicenseText}
+//
+// ======================================================================
+//
+
+/** @file libsrc/storage/PayloadDictionary.h
+ *
+ * @brief C++ manager of dictionaries of unique payloads for
+ * dictionary-encoded etree databases.
+ *
+ * Octants of a dictionary-encoded database (schema
+ * Payload::SCHEMAINDEX) hold the index of their payload in the
+ * dictionary instead of the payload. The dictionary is stored in a
+ * file next to the database (see filename()) and is read into memory
+ * when the database is opened for querying. The name of the
+ * dictionary file is also recorded in the application metadata of
+ * the database (see metadata()), so the dictionary is found after
+ * the database is renamed (see find()).
+ *
+ * The file starts with a PayloadDictionaryHeaderStruct followed by
+ * the payloads. Values are stored in the byte order of the machine
+ * that wrote the file.
+ */
+
+#if !defined(cencalvm_storage_payloaddictionary_h)
+#define cencalvm_storage_payloaddictionary_h
+
+#include "Payload.h" // HASA PayloadStruct
+
+#include <inttypes.h> // USES int32_t, uint32_t
+#include <string> // USES std::string
+#include <vector> // HASA std::vector
+
+namespace cencalvm {
+  namespace storage {
+    struct PayloadDictionaryHeaderStruct;
+    class PayloadDictionary;
+    class TestPayloadDictionary; // friend
+  } // namespace storage
+} // namespace cencalvm
+
+/// Header of payload dictionary.
+struct cencalvm::storage::PayloadDictionaryHeaderStruct {
+  char magic[8]; ///< File identifier (PayloadDictionary::MAGIC)
+  int32_t version; ///< Version of file format
+  int32_t byteOrder; ///< Byte order mark (PayloadDictionary::BYTEORDER)
+  int32_t payloadSize; ///< Size of payload in bytes
+  uint32_t numEntries; ///< Number of payloads in dictionary
+}; // PayloadDictionaryHeaderStruct
+
+/// C++ manager of dictionaries of unique payloads for
+/// dictionary-encoded etree databases.
+class cencalvm::storage::PayloadDictionary
+{ // PayloadDictionary
+  friend class TestPayloadDictionary; // unit testing
+
+public :
+  // PUBLIC MEMBERS /////////////////////////////////////////////////////
+
+  static const char* MAGIC; ///< File identifier
+  static const int32_t VERSION; ///< Current version of file format
+  static const int32_t BYTEORDER; ///< Byte order mark
+  static const uint32_t MAXENTRIES; ///< Maximum number of payloads
+  static const char* METADATATAG; ///< Label for dictionary in metadata
+
+public :
+  // PUBLIC METHODS /////////////////////////////////////////////////////
+
+  /// Constructor
+  PayloadDictionary(void);
+
+  /// Destructor
+  ~PayloadDictionary(void);
+
+  /** Get name of dictionary file of database.
+   *
+   * @param filenameDB Name of etree database
+   *
+   * @returns Name of dictionary file
+   */
+  static std::string filename(const char* filenameDB);
+
+  /** Get line of metadata recording dictionary file of database.
+   *
+   * @param filenameDict Name of dictionary file
+   *
+   * @returns Metadata (name of dictionary file without directory)
+   */
+  static std::string metadata(const char* filenameDict);
+
+  /** Find dictionary file of database.
+   *
+   * The dictionary file named after the database (see filename()) is
+   * used if it exists. Otherwise the last dictionary file recorded in
+   * the metadata is used, relative to the directory of the database.
+   *
+   * @param filenameDB Name of database
+   * @param appmeta Application metadata of database
+   *
+   * @returns Name of dictionary file
+   */
+  static std::string find(const char* filenameDB,
+			  const char* appmeta);
+
+  /** Read dictionary from file.
+   *
+   * @param filename Name of file
+   */
+  void read(const char* filename);
+
+  /** Write dictionary to file.
+   *
+   * @param filename Name of file
+   */
+  void write(const char* filename) const;
+
+  /** Add payload to end of dictionary.
+   *
+   * Payloads are not checked for duplicates.
+   *
+   * @param payload Payload
+   *
+   * @returns Index of payload in dictionary
+   */
+  uint32_t append(const PayloadStruct& payload);
+
+  /// Remove all payloads from dictionary.
+  void clear(void);
+
+  /** Get number of payloads in dictionary.
+   *
+   * @returns Number of payloads
+   */
+  uint32_t size(void) const;
+
+  /** Get payload in dictionary.
+   *
+   * @param pPayload Pointer to payload
+   * @param index Index of payload in dictionary
+   *
+   * @returns 0 if index is in dictionary, nonzero otherwise
+   */
+  int lookup(PayloadStruct* pPayload,
+	     const uint32_t index) const;
+
+private :
+  // NOT IMPLEMENTED ////////////////////////////////////////////////////
+
+  PayloadDictionary(const PayloadDictionary& d); ///< Not implemented
+  const PayloadDictionary& operator=(const PayloadDictionary& d); ///< Not implemented
+
+private :
+  // PRIVATE MEMBERS ////////////////////////////////////////////////////
+
+  std::vector<PayloadStruct> _entries; ///< Payloads in dictionary
+
+}; // PayloadDictionary
+
+#include "PayloadDictionary.icc" // inline methods
+
+#endif // cencalvm_storage_payloaddictionary_h
+
+// End of file
@@ -30,6 +30,7 @@ const char* cencalvm::storage::Projector::_UNITS = "m";
 
 // ----------------------------------------------------------------------
 cencalvm::storage::Projector::Projector(void) :
+  _pContext(proj_context_create()),
   _pProj(0)
 { // constructor
   std::ostringstream args;
@@ -42,13 +43,16 @@ cencalvm::storage::Projector::Projector(void) :
     << " +units=" << _UNITS;
   
   proj_destroy(_pProj);
-  _pProj = proj_create(NULL, args.str().c_str());
+  // Each projector has its own context, so projectors can be used
+  // concurrently from different threads.
+  _pProj = proj_create(_pContext, args.str().c_str());
   if (!_pProj) {
     std::ostringstream msg;
     msg << "Error while initializing projection:\n"
-	<< "  " << proj_errno_string(proj_errno(_pProj)) << "\n"
+	<< "  " << proj_errno_string(proj_context_errno(_pContext)) << "\n"
 	<< "Projection parameters:\n"
 	<< "  " << args.str();
+    proj_context_destroy(_pContext); _pContext = NULL;
     throw std::runtime_error(msg.str());
   } // if
 } // constructor
@@ -57,6 +61,7 @@ cencalvm::storage::Projector::Projector(void) :
 cencalvm::storage::Projector::~Projector(void)
 { // destructor
   proj_destroy(_pProj); _pProj = NULL;
+  proj_context_destroy(_pContext); _pContext = NULL;
 } // destructor
 
 // ----------------------------------------------------------------------
@@ -76,6 +76,7 @@ private :
   // PRIVATE MEMBERS ////////////////////////////////////////////////////
 
   
+  PJ_CONTEXT* _pContext; ///< Handle to Proj4 thread context
   PJ* _pProj; ///< Handle to Proj4 projection
 
   static const double _MERIDIAN; ///< Longitude of central meridian for proj
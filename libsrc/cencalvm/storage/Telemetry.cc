@@ -0,0 +1,323 @@
+// -*- C++ -*-
+//
+// ======================================================================
+//
+//                           Brad T. Aagaard
+//                        U.S. Geological Survey
+//
+// {LicenseText}
+//
+// ======================================================================
+//
+
+#include "Telemetry.h" // implementation of class methods
+
+#include <time.h> // USES time()
+#include <string.h> // USES strcmp(), strncmp(), strchr(), strlen()
+#include <stdio.h> // USES fopen(), fgets(), fputs(), fclose()
+#include <stdlib.h> // USES strtoull()
+#include <sys/resource.h> // USES getrusage()
+#include <iostream> // USES std::cerr
+#include <iomanip> // USES std::setw(), std::setfill(), std::setprecision()
+
+#include <stdexcept> // USES std::runtime_error
+#include <sstream> // USES std::ostringstream
+#include <assert.h> // USES assert()
+
+// ----------------------------------------------------------------------
+const uint64_t cencalvm::storage::Telemetry::_CHECKINTERVAL = 4096;
+
+// ----------------------------------------------------------------------
+// Constructor
+cencalvm::storage::Telemetry::Telemetry(void) :
+  _phase(""),
+  _interval(10.0),
+  _numOctants(0),
+  _numOctantsTotal(0),
+  _numBytesRead(0),
+  _numBytesWritten(0),
+  _numBytesTotal(0),
+  _numSinceCheck(0),
+  _cacheSize(0),
+  _quiet(false)
+{ // constructor
+  _ioPhase.syscallRead = 0;
+  _ioPhase.syscallWritten = 0;
+  _ioPhase.deviceRead = 0;
+  _ioPhase.deviceWritten = 0;
+} // constructor
+
+// ----------------------------------------------------------------------
+// Destructor
+cencalvm::storage::Telemetry::~Telemetry(void)
+{ // destructor
+  try {
+    endPhase();
+  } catch (...) {
+  } // try/catch
+} // destructor
+
+// ----------------------------------------------------------------------
+// Set name of file for JSON lines telemetry log.
+void
+cencalvm::storage::Telemetry::filename(const char* filename)
+{ // filename
+  assert(0 != filename);
+
+  if (_fout.is_open())
+    _fout.close();
+  if (0 == strlen(filename))
+    return;
+
+  _fout.open(filename, std::ios::out | std::ios::trunc);
+  if (!_fout.is_open()) {
+    std::ostringstream msg;
+    msg << "Could not open telemetry log file '" << filename
+	<< "' for writing.";
+    throw std::runtime_error(msg.str());
+  } // if
+} // filename
+
+// ----------------------------------------------------------------------
+// Set interval between progress reports.
+void
+cencalvm::storage::Telemetry::interval(const double seconds)
+{ // interval
+  if (seconds >= 0.0)
+    _interval = seconds;
+} // interval
+
+// ----------------------------------------------------------------------
+// Set flag indicating reports should not be written to stderr.
+void
+cencalvm::storage::Telemetry::quiet(const bool flag)
+{ // quiet
+  _quiet = flag;
+} // quiet
+
+// ----------------------------------------------------------------------
+// Begin phase, ending any current phase.
+void
+cencalvm::storage::Telemetry::beginPhase(const char* name,
+					 const uint64_t numOctantsTotal,
+					 const uint64_t numBytesTotal)
+{ // beginPhase
+  assert(0 != name);
+
+  endPhase();
+
+  _phase = name;
+  _numOctants = 0;
+  _numOctantsTotal = numOctantsTotal;
+  _numBytesRead = 0;
+  _numBytesWritten = 0;
+  _numBytesTotal = numBytesTotal;
+  _numSinceCheck = 0;
+  _cacheSize = 0;
+  processIO(&_ioPhase);
+  _timePhase = std::chrono::steady_clock::now();
+  _timeReport = _timePhase;
+
+  _report("begin");
+} // beginPhase
+
+// ----------------------------------------------------------------------
+// End current phase and report its totals.
+void
+cencalvm::storage::Telemetry::endPhase(void)
+{ // endPhase
+  if (_phase.empty())
+    return;
+
+  _report("end");
+  _phase = "";
+} // endPhase
+
+// ----------------------------------------------------------------------
+// Report progress if interval since last report has elapsed.
+void
+cencalvm::storage::Telemetry::_update(void)
+{ // _update
+  _numSinceCheck = 0;
+  if (_phase.empty() || _interval <= 0.0)
+    return;
+
+  const std::chrono::steady_clock::time_point now =
+    std::chrono::steady_clock::now();
+  if (std::chrono::duration<double>(now - _timeReport).count() >= _interval) {
+    _report("progress");
+    _timeReport = now;
+  } // if
+} // _update
+
+// ----------------------------------------------------------------------
+// Write report of current phase.
+void
+cencalvm::storage::Telemetry::_report(const char* event)
+{ // _report
+  assert(0 != event);
+
+  if (_quiet && !_fout.is_open())
+    return;
+
+  const double elapsed = std::chrono::duration<double>(
+    std::chrono::steady_clock::now() - _timePhase).count();
+  const double rate = (elapsed > 0.0) ? _numOctants / elapsed : 0.0;
+
+  ProcessIOStruct io;
+  processIO(&io);
+  io.syscallRead -= _ioPhase.syscallRead;
+  io.syscallWritten -= _ioPhase.syscallWritten;
+  io.deviceRead -= _ioPhase.deviceRead;
+  io.deviceWritten -= _ioPhase.deviceWritten;
+  const double readAmplification = (_numBytesRead > 0) ?
+    double(io.syscallRead) / _numBytesRead : 0.0;
+
+  // Fraction done from octants if total is known, otherwise from
+  // bytes read.
+  double fraction = -1.0;
+  if (_numOctantsTotal > 0)
+    fraction = double(_numOctants) / _numOctantsTotal;
+  else if (_numBytesTotal > 0)
+    fraction = double(_numBytesRead) / _numBytesTotal;
+  const bool isEnd = (0 == strcmp(event, "end"));
+  const double eta = (isEnd) ? 0.0 :
+    (fraction > 0.0) ? elapsed * (1.0 - fraction) / fraction : -1.0;
+
+  if (_fout.is_open()) {
+    _fout
+      << "{\"time\": " << time(0)
+      << ", \"phase\": \"" << _phase << "\""
+      << ", \"event\": \"" << event << "\""
+      << ", \"elapsed\": " << elapsed
+      << ", \"octants\": " << _numOctants
+      << ", \"octantsTotal\": " << _numOctantsTotal
+      << ", \"octantsPerSec\": " << rate
+      << ", \"bytesRead\": " << _numBytesRead
+      << ", \"bytesWritten\": " << _numBytesWritten
+      << ", \"bytesTotal\": " << _numBytesTotal
+      << ", \"syscallBytesRead\": " << io.syscallRead
+      << ", \"syscallBytesWritten\": " << io.syscallWritten
+      << ", \"deviceBytesRead\": " << io.deviceRead
+      << ", \"deviceBytesWritten\": " << io.deviceWritten
+      << ", \"cacheSize\": " << _cacheSize
+      << ", \"readAmplification\": " << readAmplification
+      << ", \"eta\": ";
+    if (eta >= 0.0)
+      _fout << eta;
+    else
+      _fout << "null";
+    _fout << "}" << std::endl;
+  } // if
+
+  if (_quiet || 0 == strcmp(event, "begin"))
+    return;
+
+  const double mb = 1024.0*1024.0;
+  std::ostringstream msg;
+  msg << std::fixed << std::setprecision(1)
+      << "[" << _phase << "] ";
+  if (isEnd)
+    msg << "done in " << elapsed << " s: ";
+  msg << _numOctants;
+  if (_numOctantsTotal > 0)
+    msg << "/" << _numOctantsTotal;
+  msg << " octants";
+  if (fraction >= 0.0 && !isEnd)
+    msg << " (" << 100.0*fraction << "%)";
+  msg << ", " << uint64_t(rate) << " octants/s"
+      << ", read " << _numBytesRead/mb << " MB"
+      << ", wrote " << _numBytesWritten/mb << " MB"
+      << ", I/O read " << io.syscallRead/mb << " MB";
+  if (_numBytesRead > 0)
+    msg << " (x" << std::setprecision(2) << readAmplification
+	<< std::setprecision(1) << ")";
+  msg << ", I/O wrote " << io.syscallWritten/mb << " MB";
+  if (_cacheSize > 0)
+    msg << ", cache " << _cacheSize << " MB";
+  if (eta >= 0.0 && !isEnd) {
+    const long seconds = long(eta + 0.5);
+    msg << ", ETA " << seconds / 3600 << ":"
+	<< std::setw(2) << std::setfill('0') << (seconds / 60) % 60 << ":"
+	<< std::setw(2) << std::setfill('0') << seconds % 60;
+  } // if
+  std::cerr << msg.str() << std::endl;
+} // _report
+
+// ----------------------------------------------------------------------
+// Get bytes read and written by process.
+void
+cencalvm::storage::Telemetry::processIO(ProcessIOStruct* pIO)
+{ // processIO
+  assert(0 != pIO);
+
+  pIO->syscallRead = 0;
+  pIO->syscallWritten = 0;
+  pIO->deviceRead = 0;
+  pIO->deviceWritten = 0;
+
+  FILE* fin = fopen("/proc/self/io", "r");
+  if (0 == fin)
+    return;
+
+  const int maxLen = 128;
+  char line[maxLen];
+  while (0 != fgets(line, maxLen, fin)) {
+    const char* value = strchr(line, ':');
+    if (0 == value)
+      continue;
+    const uint64_t num = strtoull(value+1, 0, 10);
+    if (0 == strncmp(line, "rchar:", 6))
+      pIO->syscallRead = num;
+    else if (0 == strncmp(line, "wchar:", 6))
+      pIO->syscallWritten = num;
+    else if (0 == strncmp(line, "read_bytes:", 11))
+      pIO->deviceRead = num;
+    else if (0 == strncmp(line, "write_bytes:", 12))
+      pIO->deviceWritten = num;
+  } // while
+  fclose(fin);
+} // processIO
+
+// ----------------------------------------------------------------------
+// Get peak resident set size of process.
+uint64_t
+cencalvm::storage::Telemetry::peakMemory(void)
+{ // peakMemory
+  FILE* fin = fopen("/proc/self/status", "r");
+  if (0 != fin) {
+    uint64_t peak = 0;
+    const int maxLen = 128;
+    char line[maxLen];
+    while (0 != fgets(line, maxLen, fin))
+      if (0 == strncmp(line, "VmHWM:", 6)) {
+	// Value is in kB.
+	peak = 1024 * strtoull(line+6, 0, 10);
+	break;
+      } // if
+    fclose(fin);
+    if (peak > 0)
+      return peak;
+  } // if
+
+  // Maximum resident set size is in kB on Linux.
+  struct rusage usage;
+  if (0 != getrusage(RUSAGE_SELF, &usage))
+    return 0;
+  return uint64_t(usage.ru_maxrss) * 1024;
+} // peakMemory
+
+// ----------------------------------------------------------------------
+// Reset peak resident set size of process.
+bool
+cencalvm::storage::Telemetry::resetPeakMemory(void)
+{ // resetPeakMemory
+  // Writing 5 to clear_refs resets VmHWM (Linux 4.0 and later).
+  FILE* fout = fopen("/proc/self/clear_refs", "w");
+  if (0 == fout)
+    return false;
+  const bool ok = (EOF != fputs("5", fout));
+  return (0 == fclose(fout)) && ok;
+} // resetPeakMemory
+
+// End of file
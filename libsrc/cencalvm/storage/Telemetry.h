@@ -0,0 +1,229 @@
+// -*- C++ -*-
+//
+// ======================================================================
+//
+//                           Brad T. Aagaard
+//                        U.S. Geological Survey
+//
+// {LicenseText}
+//
+// ======================================================================
+//
+
+/** @file libsrc/storage/Telemetry.h
+ *
+ * @brief C++ progress and telemetry reporter for the stages of
+ * building a velocity model database (ingesting, packing, averaging,
+ * and grading).
+ *
+ * Each stage is a phase with a name. While a phase is running, the
+ * stage adds the number of octants it has processed and the number
+ * of bytes of octant data it has read and written. Reports with the
+ * rate of processing octants, the bytes read and written, the bytes
+ * read and written by the process through system calls and from the
+ * storage device, and an estimate of the time remaining are written
+ * periodically to stderr and as JSON lines to a log file.
+ *
+ * Etree does not expose statistics of its buffer cache, so cache
+ * behavior is reported as the ratio of bytes read by the process
+ * through system calls to bytes of octant data read by the stage
+ * (read amplification). Etree reads a page for every miss in its
+ * cache, so a ratio well above one means the cache is too small for
+ * the access pattern of the stage. System call and storage device
+ * counts come from /proc/self/io and are zero on systems without it.
+ *
+ * Telemetry is not thread safe; a stage must update it from a single
+ * thread.
+ */
+
+#if !defined(cencalvm_storage_telemetry_h)
+#define cencalvm_storage_telemetry_h
+
+#include <inttypes.h> // USES uint64_t
+#include <string> // HASA std::string
+#include <fstream> // HASA std::ofstream
+#include <chrono> // HASA std::chrono::steady_clock
+
+namespace cencalvm {
+  namespace storage {
+    class Telemetry;
+    class TestTelemetry; // friend
+  } // namespace storage
+} // namespace cencalvm
+
+/// C++ progress and telemetry reporter for building databases.
+class cencalvm::storage::Telemetry
+{ // Telemetry
+  friend class TestTelemetry; // unit testing
+
+public :
+  // PUBLIC STRUCTS /////////////////////////////////////////////////////
+
+  /// Bytes read and written by process.
+  struct ProcessIOStruct {
+    uint64_t syscallRead; ///< Bytes read through system calls
+    uint64_t syscallWritten; ///< Bytes written through system calls
+    uint64_t deviceRead; ///< Bytes read from storage device
+    uint64_t deviceWritten; ///< Bytes written to storage device
+  }; // ProcessIOStruct
+
+public :
+  // PUBLIC METHODS /////////////////////////////////////////////////////
+
+  /// Constructor
+  Telemetry(void);
+
+  /// Destructor
+  ~Telemetry(void);
+
+  /** Set name of file for JSON lines telemetry log.
+   *
+   * The file is truncated. Default is not to write a log.
+   *
+   * @param filename Name of file (empty for no log)
+   */
+  void filename(const char* filename);
+
+  /** Set interval between progress reports.
+   *
+   * Default is 10 s.
+   *
+   * @param seconds Time between reports in seconds (0 for reports
+   * only at the beginning and end of phases)
+   */
+  void interval(const double seconds);
+
+  /** Set flag indicating reports should not be written to stderr.
+   *
+   * Reports are still written to the log file.
+   *
+   * @param flag True for quiet operation, false to report to stderr
+   */
+  void quiet(const bool flag);
+
+  /** Begin phase, ending any current phase.
+   *
+   * The estimate of the time remaining uses the number of octants if
+   * numOctantsTotal is nonzero and the number of bytes read if
+   * numBytesTotal is nonzero.
+   *
+   * @param name Name of phase
+   * @param numOctantsTotal Number of octants processed in phase (0
+   * if unknown)
+   * @param numBytesTotal Number of bytes read in phase (0 if unknown)
+   */
+  void beginPhase(const char* name,
+		  const uint64_t numOctantsTotal =0,
+		  const uint64_t numBytesTotal =0);
+
+  /** Set size of etree cache used by current phase (reported).
+   *
+   * @param size Size of cache in MB
+   */
+  void cacheSize(const int size);
+
+  /** Add octants processed in current phase.
+   *
+   * @param num Number of octants
+   */
+  void addOctants(const uint64_t num =1);
+
+  /** Add bytes of octant data read in current phase.
+   *
+   * @param num Number of bytes
+   */
+  void addBytesRead(const uint64_t num);
+
+  /** Add bytes of octant data written in current phase.
+   *
+   * @param num Number of bytes
+   */
+  void addBytesWritten(const uint64_t num);
+
+  /// End current phase and report its totals.
+  void endPhase(void);
+
+  /** Get number of octants processed in current phase.
+   *
+   * @returns Number of octants
+   */
+  uint64_t numOctants(void) const;
+
+  /** Get number of bytes of octant data read in current phase.
+   *
+   * @returns Number of bytes
+   */
+  uint64_t numBytesRead(void) const;
+
+  /** Get number of bytes of octant data written in current phase.
+   *
+   * @returns Number of bytes
+   */
+  uint64_t numBytesWritten(void) const;
+
+  /** Get bytes read and written by process from /proc/self/io (all
+   * zero on systems without it).
+   *
+   * @param pIO Pointer to I/O counts
+   */
+  static void processIO(ProcessIOStruct* pIO);
+
+  /** Get peak resident set size of process from /proc/self/status
+   * (maximum resident set size from getrusage() on systems without
+   * it).
+   *
+   * @returns Peak resident set size in bytes
+   */
+  static uint64_t peakMemory(void);
+
+  /** Reset peak resident set size of process to the current resident
+   * set size, so peakMemory() gives the peak of the work that follows.
+   *
+   * @returns True if the peak was reset, false if the system does not
+   * support resetting it
+   */
+  static bool resetPeakMemory(void);
+
+private :
+  // PRIVATE METHODS ////////////////////////////////////////////////////
+
+  /// Report progress if interval since last report has elapsed.
+  void _update(void);
+
+  /** Write report of current phase.
+   *
+   * @param event Name of event ("begin", "progress", or "end")
+   */
+  void _report(const char* event);
+
+  Telemetry(const Telemetry& t); ///< Not implemented
+  const Telemetry& operator=(const Telemetry& t); ///< Not implemented
+
+private :
+  // PRIVATE MEMBERS ////////////////////////////////////////////////////
+
+  /// Number of octants between checks of the clock.
+  static const uint64_t _CHECKINTERVAL;
+
+  std::ofstream _fout; ///< JSON lines log file
+  std::string _phase; ///< Name of current phase (empty if none)
+  std::chrono::steady_clock::time_point _timePhase; ///< Start of phase
+  std::chrono::steady_clock::time_point _timeReport; ///< Time of last report
+  ProcessIOStruct _ioPhase; ///< Process I/O at start of phase
+  double _interval; ///< Time between progress reports in seconds
+  uint64_t _numOctants; ///< Number of octants processed in phase
+  uint64_t _numOctantsTotal; ///< Number of octants in phase (0 if unknown)
+  uint64_t _numBytesRead; ///< Bytes of octant data read in phase
+  uint64_t _numBytesWritten; ///< Bytes of octant data written in phase
+  uint64_t _numBytesTotal; ///< Bytes read in phase (0 if unknown)
+  uint64_t _numSinceCheck; ///< Number of octants since clock was checked
+  int _cacheSize; ///< Size of etree cache in MB used in phase
+  bool _quiet; ///< Flag to eliminate reports to stderr
+
+}; // Telemetry
+
+#include "Telemetry.icc" // inline methods
+
+#endif // cencalvm_storage_telemetry_h
+
+// End of file
@@ -13,14 +13,22 @@
 #include "TestAverager.h" // Implementation of class methods
 
 #include "cencalvm/average/Averager.h" // USES Averager
+#include "cencalvm/average/DirtyList.h" // USES DirtyList
 
 #include "cencalvm/storage/Payload.h" // USES Payload
+#include "cencalvm/storage/DBSnapshot.h" // USES DBSnapshot
 
 extern "C" {
 #include "etree.h" // USES etree
 }
 
 #include <iostream> // USES std::cerr
+#include <fstream> // USES std::ifstream
+#include <string.h> // USES memcmp(), memset()
+#include <fcntl.h> // USES open()
+#include <unistd.h> // USES fork(), pwrite(), close(), _exit()
+#include <sys/wait.h> // USES waitpid()
+#include <vector> // USES std::vector
 
 // ----------------------------------------------------------------------
 CPPUNIT_TEST_SUITE_REGISTRATION( cencalvm::average::TestAverager );
@@ -50,6 +58,248 @@ cencalvm::average::TestAverager::testFillOctants(void)
   averager.quiet(true);
   averager.average();
 
+  _checkDB();
+} // testFillOctants
+
+// ----------------------------------------------------------------------
+// Test fillOctants() with write-behind buffer too small for subtrees.
+void
+cencalvm::average::TestAverager::testFillOctantsSpill(void)
+{ // testFillOctantsSpill
+
+  _createDB();
+
+  Averager averager;
+  averager.filenameIn(_DBFILENAMEIN);
+  averager.filenameOut(_DBFILENAMEOUT);
+  averager.bufferSize(2);
+  averager.quiet(true);
+  averager.average();
+
+  _checkDB();
+} // testFillOctantsSpill
+
+// ----------------------------------------------------------------------
+// Test update()
+void
+cencalvm::average::TestAverager::testUpdate(void)
+{ // testUpdate
+
+  _createDB();
+
+  Averager averager;
+  averager.filenameIn(_DBFILENAMEIN);
+  averager.filenameOut(_DBFILENAMEOUT);
+  averager.quiet(true);
+  averager.average();
+
+  // Edit two leaf octants in both the input and averaged databases.
+  // One is marked dirty directly and the other through the range of
+  // leaves covered by its level 2 ancestor.
+  etree_t* dbIn = etree_open(_DBFILENAMEIN, O_RDWR, 0, 0, 0);
+  CPPUNIT_ASSERT(0 != dbIn);
+  etree_t* dbOut = etree_open(_DBFILENAMEOUT, O_RDWR, 0, 0, 0);
+  CPPUNIT_ASSERT(0 != dbOut);
+  const int numEdits = 2;
+  const int editOctants[] = { 5, 10 };
+  DirtyList dirty;
+  for (int iEdit=0; iEdit < numEdits; ++iEdit) {
+    const int iOctant = editOctants[iEdit];
+    etree_addr_t addr;
+    addr.t = 0;
+    addr.level = _LEVELS[iOctant];
+    addr.type = ETREE_LEAF;
+    const etree_tick_t tickLen = 0x80000000 >> addr.level;
+    const int numCoords = 3;
+    addr.x = tickLen * _COORDS[numCoords*iOctant  ];
+    addr.y = tickLen * _COORDS[numCoords*iOctant+1];
+    addr.z = tickLen * _COORDS[numCoords*iOctant+2];
+
+    const double val = 2.0 * _OCTVALS[iOctant] + 1.0;
+    cencalvm::storage::PayloadStruct payload;
+    int i=0;
+    payload.Vp = _RELPAY[i++]*val;
+    payload.Vs = _RELPAY[i++]*val;
+    payload.Density = _RELPAY[i++]*val;
+    payload.Qp = _RELPAY[i++]*val;
+    payload.Qs = _RELPAY[i++]*val;
+    payload.DepthFreeSurf = _RELPAY[i++]*val;
+    payload.FaultBlock = int(_RELPAY[i++]);
+    payload.Zone = int(_RELPAY[i++]);
+    CPPUNIT_ASSERT(0 == etree_update(dbIn, addr, &payload));
+    CPPUNIT_ASSERT(0 == etree_update(dbOut, addr, &payload));
+
+    if (0 == iEdit) {
+      addr.level = 2;
+      const etree_tick_t mask = ~((0x80000000 >> addr.level) - 1);
+      addr.x &= mask;
+      addr.y &= mask;
+      addr.z &= mask;
+    } // if
+    dirty.add(addr);
+  } // for
+  CPPUNIT_ASSERT(0 == etree_close(dbIn));
+  CPPUNIT_ASSERT(0 == etree_close(dbOut));
+
+  const std::string filenameDirty = DirtyList::filename(_DBFILENAMEOUT);
+  dirty.write(filenameDirty.c_str());
+  averager.update();
+  std::ifstream fin(filenameDirty.c_str());
+  CPPUNIT_ASSERT(!fin.is_open());
+
+  Averager averagerRef;
+  averagerRef.filenameIn(_DBFILENAMEIN);
+  averagerRef.filenameOut(_DBFILENAMEREF);
+  averagerRef.quiet(true);
+  averagerRef.average();
+
+  // Updated database must be identical to averaging the edited input.
+  _checkSameDB(_DBFILENAMEOUT, _DBFILENAMEREF);
+} // testUpdate
+
+// ----------------------------------------------------------------------
+// Test resuming average() from checkpoint.
+void
+cencalvm::average::TestAverager::testResume(void)
+{ // testResume
+  _createDB();
+
+  Averager averagerRef;
+  averagerRef.filenameIn(_DBFILENAMEIN);
+  averagerRef.filenameOut(_DBFILENAMEREF);
+  averagerRef.quiet(true);
+  averagerRef.average();
+
+  // Small buffer forces pending octants to be appended as
+  // placeholders at checkpoints.
+  const std::string filenameCheckpoint =
+    std::string(_DBFILENAMEOUT) + ".checkpoint";
+  Averager averagerStop;
+  averagerStop.filenameIn(_DBFILENAMEIN);
+  averagerStop.filenameOut(_DBFILENAMEOUT);
+  averagerStop.bufferSize(2);
+  averagerStop.checkpointInterval(3);
+  averagerStop._maxInput = 7;
+  averagerStop.quiet(true);
+  averagerStop.average();
+  std::ifstream fin(filenameCheckpoint.c_str());
+  CPPUNIT_ASSERT(fin.is_open());
+  fin.close();
+
+  // Simulate octant appended after the checkpoint before a crash.
+  etree_t* db = etree_open(_DBFILENAMEOUT, O_RDWR, 0, 0, 0);
+  CPPUNIT_ASSERT(0 != db);
+  etree_addr_t addr;
+  addr.t = 0;
+  addr.level = 5;
+  addr.type = ETREE_LEAF;
+  const etree_tick_t tickLen = 0x80000000 >> addr.level;
+  addr.x = 31 * tickLen;
+  addr.y = 31 * tickLen;
+  addr.z = 31 * tickLen;
+  cencalvm::storage::PayloadStruct payload;
+  memset(&payload, 0, sizeof(payload));
+  CPPUNIT_ASSERT(0 == etree_beginappend(db, 1.0));
+  CPPUNIT_ASSERT(0 == etree_append(db, addr, &payload));
+  CPPUNIT_ASSERT(0 == etree_endappend(db));
+  CPPUNIT_ASSERT(0 == etree_close(db));
+
+  Averager averager;
+  averager.filenameIn(_DBFILENAMEIN);
+  averager.filenameOut(_DBFILENAMEOUT);
+  averager.bufferSize(2);
+  averager.checkpointInterval(3);
+  averager.resume(true);
+  averager.quiet(true);
+  averager.average();
+  fin.open(filenameCheckpoint.c_str());
+  CPPUNIT_ASSERT(!fin.is_open());
+
+  _checkSameDB(_DBFILENAMEOUT, _DBFILENAMEREF);
+} // testResume
+
+// ----------------------------------------------------------------------
+// Test resuming average() after a process appending past the
+// checkpoint exits without closing the database.
+void
+cencalvm::average::TestAverager::testResumeCrash(void)
+{ // testResumeCrash
+  _createDB();
+
+  Averager averagerRef;
+  averagerRef.filenameIn(_DBFILENAMEIN);
+  averagerRef.filenameOut(_DBFILENAMEREF);
+  averagerRef.quiet(true);
+  averagerRef.average();
+
+  Averager averagerStop;
+  averagerStop.filenameIn(_DBFILENAMEIN);
+  averagerStop.filenameOut(_DBFILENAMEOUT);
+  averagerStop.bufferSize(2);
+  averagerStop.checkpointInterval(3);
+  averagerStop._maxInput = 7;
+  averagerStop.quiet(true);
+  averagerStop.average();
+
+  // Child appends octants after the checkpoint and exits without
+  // closing the database. Dirty pages evicted before a crash can
+  // overwrite pages of the database at the checkpoint, which is
+  // simulated by overwriting the first page.
+  const pid_t pid = fork();
+  CPPUNIT_ASSERT(pid >= 0);
+  if (0 == pid) {
+    etree_t* db = etree_open(_DBFILENAMEOUT, O_RDWR, 1, 0, 0);
+    if (0 == db || 0 != etree_beginappend(db, 1.0))
+      _exit(1);
+    cencalvm::storage::PayloadStruct payload;
+    memset(&payload, 0, sizeof(payload));
+    etree_addr_t addr;
+    addr.t = 0;
+    addr.type = ETREE_LEAF;
+    addr.level = 5;
+    const etree_tick_t tickLen = 0x80000000 >> addr.level;
+    addr.x = 31 * tickLen;
+    addr.y = 31 * tickLen;
+    addr.z = 31 * tickLen;
+    if (0 != etree_append(db, addr, &payload))
+      _exit(1);
+    const int fd = open(_DBFILENAMEOUT, O_WRONLY);
+    const int pageSize = 4096;
+    std::vector<char> garbage(pageSize, 0x5a);
+    if (fd < 0 || pageSize != pwrite(fd, &garbage[0], pageSize, 0))
+      _exit(1);
+    _exit(0);
+  } // if
+  int status = 0;
+  CPPUNIT_ASSERT_EQUAL(pid, waitpid(pid, &status, 0));
+  CPPUNIT_ASSERT(WIFEXITED(status));
+  CPPUNIT_ASSERT_EQUAL(0, WEXITSTATUS(status));
+
+  Averager averager;
+  averager.filenameIn(_DBFILENAMEIN);
+  averager.filenameOut(_DBFILENAMEOUT);
+  averager.bufferSize(2);
+  averager.checkpointInterval(3);
+  averager.resume(true);
+  averager.quiet(true);
+  averager.average();
+
+  _checkSameDB(_DBFILENAMEOUT, _DBFILENAMEREF);
+
+  // Snapshots are removed when averaging finishes.
+  for (int slot=0; slot < cencalvm::storage::DBSnapshot::NUMSLOTS; ++slot) {
+    const std::string filename =
+      cencalvm::storage::DBSnapshot::filename(_DBFILENAMEOUT, slot);
+    std::ifstream fin(filename.c_str());
+    CPPUNIT_ASSERT(!fin.is_open());
+  } // for
+} // testResumeCrash
+
+// ----------------------------------------------------------------------
+// Check values in averaged etree database.
+void
+cencalvm::average::TestAverager::_checkDB(void) const
+{ // _checkDB
   etree_t* db = etree_open(_DBFILENAMEOUT, O_RDONLY, 0, 0, 0);
   CPPUNIT_ASSERT(0 != db);
 
@@ -101,7 +351,48 @@ cencalvm::average::TestAverager::testFillOctants(void)
 
   int err = etree_close(db);
   CPPUNIT_ASSERT(0 == err);
-} // testFillOctants
+} // _checkDB
+
+// ----------------------------------------------------------------------
+// Check that averaged etree database matches reference database.
+void
+cencalvm::average::TestAverager::_checkSameDB(const char* filename,
+					      const char* filenameRef) const
+{ // _checkSameDB
+  etree_t* dbRef = etree_open(filenameRef, O_RDONLY, 0, 0, 0);
+  CPPUNIT_ASSERT(0 != dbRef);
+  etree_t* db = etree_open(filename, O_RDONLY, 0, 0, 0);
+  CPPUNIT_ASSERT(0 != db);
+  etree_addr_t addr;
+  addr.x = 0;
+  addr.y = 0;
+  addr.z = 0;
+  addr.t = 0;
+  addr.level = 0;
+  etree_addr_t addrRef = addr;
+  CPPUNIT_ASSERT(0 == etree_initcursor(dbRef, addrRef));
+  CPPUNIT_ASSERT(0 == etree_initcursor(db, addr));
+  int numOctants = 0;
+  bool more = true;
+  while (more) {
+    cencalvm::storage::PayloadStruct payloadRef;
+    cencalvm::storage::PayloadStruct payload;
+    CPPUNIT_ASSERT(0 == etree_getcursor(dbRef, &addrRef, "*", &payloadRef));
+    CPPUNIT_ASSERT(0 == etree_getcursor(db, &addr, "*", &payload));
+    CPPUNIT_ASSERT_EQUAL(addrRef.x, addr.x);
+    CPPUNIT_ASSERT_EQUAL(addrRef.y, addr.y);
+    CPPUNIT_ASSERT_EQUAL(addrRef.z, addr.z);
+    CPPUNIT_ASSERT_EQUAL(addrRef.level, addr.level);
+    CPPUNIT_ASSERT(0 == memcmp(&payloadRef, &payload, sizeof(payload)));
+    ++numOctants;
+    more = (0 == etree_advcursor(dbRef));
+    CPPUNIT_ASSERT_EQUAL(more, 0 == etree_advcursor(db));
+  } // while
+  CPPUNIT_ASSERT_EQUAL(_NUMOCTANTS, numOctants);
+
+  CPPUNIT_ASSERT(0 == etree_close(db));
+  CPPUNIT_ASSERT(0 == etree_close(dbRef));
+} // _checkSameDB
 
 // ----------------------------------------------------------------------
 // Create etree with desired number of octants.
@@ -36,6 +36,10 @@ class cencalvm::average::TestAverager : public CppUnit::TestFixture
   CPPUNIT_TEST_SUITE( TestAverager );
   CPPUNIT_TEST( testConstructor );
   CPPUNIT_TEST( testFillOctants );
+  CPPUNIT_TEST( testFillOctantsSpill );
+  CPPUNIT_TEST( testUpdate );
+  CPPUNIT_TEST( testResume );
+  CPPUNIT_TEST( testResumeCrash );
   CPPUNIT_TEST_SUITE_END();
 
   // PUBLIC METHODS /////////////////////////////////////////////////////
@@ -47,12 +51,36 @@ public :
   /// Test fillOctants()
   void testFillOctants(void);
 
+  /// Test fillOctants() with write-behind buffer too small for subtrees.
+  void testFillOctantsSpill(void);
+
+  /// Test update()
+  void testUpdate(void);
+
+  /// Test resuming average() from checkpoint.
+  void testResume(void);
+
+  /// Test resuming average() after a process appending past the
+  /// checkpoint exits without closing the database.
+  void testResumeCrash(void);
+
   // PRIVATE MEMBERS ////////////////////////////////////////////////////
 private :
 
   /// Create etree database.
   void _createDB(void) const;
 
+  /// Check values in averaged etree database.
+  void _checkDB(void) const;
+
+  /** Check that averaged etree database matches reference database.
+   *
+   * @param filename Name of averaged etree database
+   * @param filenameRef Name of reference etree database
+   */
+  void _checkSameDB(const char* filename,
+		    const char* filenameRef) const;
+
   // PRIVATE METHODS ////////////////////////////////////////////////////
 private :
 
@@ -62,6 +90,7 @@ private :
   static const int _COORDS[]; ///< Coordinates of octants in database
   static const char* _DBFILENAMEIN; ///< Filename of input etree database
   static const char* _DBFILENAMEOUT; ///< Filename of output etree database
+  static const char* _DBFILENAMEREF; ///< Filename of reference etree database
   static const int _NUMOCTANTS; ///< Number of octants
   static const int _NUMOCTANTSIN; ///< Number of octants for input
 
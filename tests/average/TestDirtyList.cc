@@ -0,0 +1,143 @@
+// -*- C++ -*-
+//
+// ----------------------------------------------------------------------
+//
+//                           Brad T. Aagaard
+//                        U.S. Geological Survey
+//
+// {LicenseText}
+//
+// ----------------------------------------------------------------------
+//
+
+#include "TestDirtyList.h" // Implementation of class methods
+
+#include "cencalvm/average/DirtyList.h" // USES DirtyList
+
+extern "C" {
+#include "etree.h" // USES etree_addr_t
+}
+
+#include <fstream> // USES std::ofstream
+#include <stdexcept> // USES std::runtime_error
+
+// ----------------------------------------------------------------------
+CPPUNIT_TEST_SUITE_REGISTRATION( cencalvm::average::TestDirtyList );
+
+// ----------------------------------------------------------------------
+const char* cencalvm::average::TestDirtyList::_FILENAME =
+  "data/dirty.etree.dirty";
+const int cencalvm::average::TestDirtyList::_NUMOCTANTS = 4;
+
+// ----------------------------------------------------------------------
+// Test constructor
+void
+cencalvm::average::TestDirtyList::testConstructor(void)
+{ // testConstructor
+  DirtyList dirty;
+  CPPUNIT_ASSERT_EQUAL(size_t(0), dirty.size());
+} // testConstructor
+
+// ----------------------------------------------------------------------
+// Test filename()
+void
+cencalvm::average::TestDirtyList::testFilename(void)
+{ // testFilename
+  CPPUNIT_ASSERT(std::string(_FILENAME) ==
+		 DirtyList::filename("data/dirty.etree"));
+} // testFilename
+
+// ----------------------------------------------------------------------
+// Test add(), octant(), and clear()
+void
+cencalvm::average::TestDirtyList::testAdd(void)
+{ // testAdd
+  DirtyList dirty;
+  for (int i=0; i < _NUMOCTANTS; ++i) {
+    etree_addr_t addr;
+    _octant(&addr, i);
+    dirty.add(addr);
+  } // for
+  CPPUNIT_ASSERT_EQUAL(size_t(_NUMOCTANTS), dirty.size());
+
+  for (int i=_NUMOCTANTS-1; i >= 0; --i) {
+    etree_addr_t addr;
+    dirty.octant(&addr, i);
+    _checkOctant(addr, i);
+  } // for
+
+  dirty.clear();
+  CPPUNIT_ASSERT_EQUAL(size_t(0), dirty.size());
+} // testAdd
+
+// ----------------------------------------------------------------------
+// Test read() and write()
+void
+cencalvm::average::TestDirtyList::testReadWrite(void)
+{ // testReadWrite
+  DirtyList dirtyOut;
+  for (int i=0; i < _NUMOCTANTS; ++i) {
+    etree_addr_t addr;
+    _octant(&addr, i);
+    dirtyOut.add(addr);
+  } // for
+  dirtyOut.write(_FILENAME);
+
+  DirtyList dirty;
+  dirty.read(_FILENAME);
+  CPPUNIT_ASSERT_EQUAL(size_t(_NUMOCTANTS), dirty.size());
+  for (int i=0; i < _NUMOCTANTS; ++i) {
+    etree_addr_t addr;
+    dirty.octant(&addr, i);
+    _checkOctant(addr, i);
+  } // for
+
+  { // Level out of range
+    std::ofstream fout(_FILENAME);
+    fout << "0 0 0 2\n" << "0 0 0 40\n";
+  } // Level out of range
+  CPPUNIT_ASSERT_THROW(dirty.read(_FILENAME), std::runtime_error);
+  CPPUNIT_ASSERT_EQUAL(size_t(0), dirty.size());
+
+  { // Not a list of octants
+    std::ofstream fout(_FILENAME);
+    fout << "0 0 0 2\n" << "0 zero 0 2\n";
+  } // Not a list of octants
+  CPPUNIT_ASSERT_THROW(dirty.read(_FILENAME), std::runtime_error);
+  CPPUNIT_ASSERT_EQUAL(size_t(0), dirty.size());
+
+  CPPUNIT_ASSERT_THROW(dirty.read("data/nosuchfile.dirty"),
+		       std::runtime_error);
+} // testReadWrite
+
+// ----------------------------------------------------------------------
+// Get address of octant in list.
+void
+cencalvm::average::TestDirtyList::_octant(etree_addr_t* pAddr,
+					  const int index)
+{ // _octant
+  const int level = 2 + 3*index;
+  const etree_tick_t tickLen = 0x80000000 >> level;
+  pAddr->x = tickLen * (index+1);
+  pAddr->y = tickLen * (2*index);
+  pAddr->z = tickLen * (3 - index);
+  pAddr->t = 0;
+  pAddr->level = level;
+  pAddr->type = ETREE_LEAF;
+} // _octant
+
+// ----------------------------------------------------------------------
+// Check address of octant in list.
+void
+cencalvm::average::TestDirtyList::_checkOctant(const etree_addr_t& addr,
+					       const int index)
+{ // _checkOctant
+  etree_addr_t addrE;
+  _octant(&addrE, index);
+  CPPUNIT_ASSERT_EQUAL(addrE.x, addr.x);
+  CPPUNIT_ASSERT_EQUAL(addrE.y, addr.y);
+  CPPUNIT_ASSERT_EQUAL(addrE.z, addr.z);
+  CPPUNIT_ASSERT_EQUAL(addrE.level, addr.level);
+} // _checkOctant
+
+// End of file
@@ -0,0 +1,89 @@
+// -*- C++ -*-
+//
+// ----------------------------------------------------------------------
+//
+//                           Brad T. Aagaard
+//                        U.S. Geological Survey
+//
+// {LicenseText}
+//
+// ----------------------------------------------------------------------
+//
+
+/** @file tests/TestDirtyList.h
+ *
+ * @brief C++ TestDirtyList object
+ *
+ * C++ unit testing for DirtyList.
+ */
+
+#if !defined(cencalvm_average_testdirtylist_h)
+#define cencalvm_average_testdirtylist_h
+
+#include <cppunit/extensions/HelperMacros.h>
+
+#include "cencalvm/storage/etreefwd.h" // USES etree_addr_t
+
+namespace cencalvm {
+  namespace average {
+    class TestDirtyList;
+  } // average
+} // cencalvm
+
+/// C++ unit testing for DirtyList
+class cencalvm::average::TestDirtyList : public CppUnit::TestFixture
+{ // class TestDirtyList
+
+  // CPPUNIT TEST SUITE /////////////////////////////////////////////////
+  CPPUNIT_TEST_SUITE( TestDirtyList );
+  CPPUNIT_TEST( testConstructor );
+  CPPUNIT_TEST( testFilename );
+  CPPUNIT_TEST( testAdd );
+  CPPUNIT_TEST( testReadWrite );
+  CPPUNIT_TEST_SUITE_END();
+
+  // PUBLIC METHODS /////////////////////////////////////////////////////
+public :
+
+  /// Test constructor
+  void testConstructor(void);
+
+  /// Test filename()
+  void testFilename(void);
+
+  /// Test add(), octant(), and clear()
+  void testAdd(void);
+
+  /// Test read() and write()
+  void testReadWrite(void);
+
+  // PRIVATE METHODS ////////////////////////////////////////////////////
+private :
+
+  /** Get address of octant in list.
+   *
+   * @param pAddr Pointer to address of octant
+   * @param index Index of octant
+   */
+  static void _octant(etree_addr_t* pAddr,
+		      const int index);
+
+  /** Check address of octant in list.
+   *
+   * @param addr Address of octant
+   * @param index Index of octant
+   */
+  static void _checkOctant(const etree_addr_t& addr,
+			   const int index);
+
+  // PRIVATE MEMBERS ////////////////////////////////////////////////////
+private :
+
+  static const char* _FILENAME; ///< Filename of dirty list
+  static const int _NUMOCTANTS; ///< Number of octants in list
+
+}; // class TestDirtyList
+
+#endif // cencalvm_average_testdirtylist_h
+
+// End of file
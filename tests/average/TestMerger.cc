@@ -0,0 +1,364 @@
+// -*- C++ -*-
+//
+// ----------------------------------------------------------------------
+//
+//                           Brad T. Aagaard
+//                        U.S. Geological Survey
+//
+// {LicenseText}
+//
+// ----------------------------------------------------------------------
+//
+
+#include "TestMerger.h" // Implementation of class methods
+
+#include "cencalvm/average/Merger.h" // USES Merger
+#include "cencalvm/average/Averager.h" // USES Averager
+
+#include "cencalvm/storage/Payload.h" // USES Payload
+#include "cencalvm/storage/CacheMonitor.h" // USES CacheMonitor::AUTOSIZE
+#include "cencalvm/storage/Geometry.h" // USES Geometry
+#include "cencalvm/storage/GeomCenCA.h" // USES GeomCenCA
+
+extern "C" {
+#include "etree.h" // USES etree
+}
+
+#include <stdexcept> // USES std::runtime_error
+#include <math.h> // USES fabs()
+
+// ----------------------------------------------------------------------
+CPPUNIT_TEST_SUITE_REGISTRATION( cencalvm::average::TestMerger );
+
+// ----------------------------------------------------------------------
+#include "data/TestMerger.dat"
+
+// ----------------------------------------------------------------------
+// Test constructor
+void
+cencalvm::average::TestMerger::testConstructor(void)
+{ // testConstructor
+  Merger merger;
+} // testConstructor
+
+// ----------------------------------------------------------------------
+// Test merge() with databases that have not been averaged.
+void
+cencalvm::average::TestMerger::testMergeLeaves(void)
+{ // testMergeLeaves
+  _createDBs();
+
+  Merger merger;
+  merger.filenameIn(_DBFILENAMEDETAILED);
+  merger.filenameExt(_DBFILENAMEEXT);
+  merger.filenameOut(_DBFILENAMEOUT);
+  merger.quiet(true);
+  merger.merge();
+
+  _checkDB(_DBFILENAMEOUT, _DBFILENAMEMERGED);
+} // testMergeLeaves
+
+// ----------------------------------------------------------------------
+// Test merge() with averaged databases.
+void
+cencalvm::average::TestMerger::testMergeAveraged(void)
+{ // testMergeAveraged
+  _createDBs();
+
+  Merger merger;
+  merger.filenameIn(_DBFILENAMEDETAILEDAVG);
+  merger.filenameExt(_DBFILENAMEEXTAVG);
+  merger.filenameOut(_DBFILENAMEOUT);
+  merger.quiet(true);
+  merger.merge();
+
+  // Merging averaged databases must give same result as averaging
+  // merged leaf octants from scratch.
+  _checkDB(_DBFILENAMEOUT, _DBFILENAMEMERGEDAVG);
+} // testMergeAveraged
+
+// ----------------------------------------------------------------------
+// Test merge() with write-behind buffer too small for subtrees.
+void
+cencalvm::average::TestMerger::testMergeAveragedSpill(void)
+{ // testMergeAveragedSpill
+  _createDBs();
+
+  Merger merger;
+  merger.filenameIn(_DBFILENAMEDETAILEDAVG);
+  merger.filenameExt(_DBFILENAMEEXTAVG);
+  merger.filenameOut(_DBFILENAMEOUT);
+  merger.bufferSize(2);
+  merger.quiet(true);
+  merger.merge();
+
+  _checkDB(_DBFILENAMEOUT, _DBFILENAMEMERGEDAVG);
+} // testMergeAveragedSpill
+
+// ----------------------------------------------------------------------
+// Test merge() with automatic sizing of etree caches.
+void
+cencalvm::average::TestMerger::testMergeAutoCache(void)
+{ // testMergeAutoCache
+  _createDBs();
+
+  Merger merger;
+  merger.filenameIn(_DBFILENAMEDETAILEDAVG);
+  merger.filenameExt(_DBFILENAMEEXTAVG);
+  merger.filenameOut(_DBFILENAMEOUT);
+  merger.cacheSize(storage::CacheMonitor::AUTOSIZE);
+  merger.quiet(true);
+  merger.merge();
+
+  _checkDB(_DBFILENAMEOUT, _DBFILENAMEMERGEDAVG);
+} // testMergeAutoCache
+
+// ----------------------------------------------------------------------
+// Test merge() with only one database averaged.
+void
+cencalvm::average::TestMerger::testMergeMixed(void)
+{ // testMergeMixed
+  _createDBs();
+
+  Merger merger;
+  merger.filenameIn(_DBFILENAMEDETAILEDAVG);
+  merger.filenameExt(_DBFILENAMEEXT);
+  merger.filenameOut(_DBFILENAMEOUT);
+  merger.quiet(true);
+  CPPUNIT_ASSERT_THROW(merger.merge(), std::runtime_error);
+} // testMergeMixed
+
+// ----------------------------------------------------------------------
+// Create databases for detailed, extended, and merged leaf octants
+// along with averaged versions of all three databases.
+void
+cencalvm::average::TestMerger::_createDBs(void) const
+{ // _createDBs
+  _createDB(_DBFILENAMEDETAILED, _DETAILEDLEVELS, _DETAILEDCOORDS,
+	    _DETAILEDVALS, _NUMDETAILED);
+  _createDB(_DBFILENAMEEXT, _EXTLEVELS, _EXTCOORDS, _EXTVALS, _NUMEXT);
+
+  etree_t* db = etree_open(_DBFILENAMEMERGED, O_CREAT|O_RDWR|O_TRUNC, 0, 0, 3);
+  CPPUNIT_ASSERT(0 != db);
+  int err = etree_registerschema(db, cencalvm::storage::Payload::SCHEMA);
+  CPPUNIT_ASSERT(0 == err);
+  _insertOctants(db, _DETAILEDLEVELS, _DETAILEDCOORDS, _DETAILEDVALS,
+		 _KEPTDETAILED, _NUMKEPTDETAILED);
+  _insertOctants(db, _EXTLEVELS, _EXTCOORDS, _EXTVALS, 
+		 _KEPTEXT, _NUMKEPTEXT);
+  _insertSplit(db);
+  err = etree_close(db);
+  CPPUNIT_ASSERT(0 == err);
+
+  _averageDB(_DBFILENAMEDETAILED, _DBFILENAMEDETAILEDAVG);
+  _averageDB(_DBFILENAMEEXT, _DBFILENAMEEXTAVG);
+  _averageDB(_DBFILENAMEMERGED, _DBFILENAMEMERGEDAVG);
+} // _createDBs
+
+// ----------------------------------------------------------------------
+// Insert octants into etree database.
+void
+cencalvm::average::TestMerger::_insertOctants(etree_t* db,
+					      const int* levels,
+					      const int* coords,
+					      const double* vals,
+					      const int* indices,
+					      const int numOctants) const
+{ // _insertOctants
+  CPPUNIT_ASSERT(0 != db);
+
+  for (int i=0; i < numOctants; ++i) {
+    const int iOctant = (0 != indices) ? indices[i] : i;
+
+    etree_addr_t addr;
+    addr.level = levels[iOctant];
+    addr.type = ETREE_LEAF;
+
+    const etree_tick_t tickLen = 0x80000000 >> addr.level;
+    const int numCoords = 3;
+    addr.x = tickLen * coords[numCoords*iOctant  ];
+    addr.y = tickLen * coords[numCoords*iOctant+1];
+    addr.z = tickLen * coords[numCoords*iOctant+2];
+
+    const double val = vals[iOctant];
+    cencalvm::storage::PayloadStruct payload;
+    if (val > 0.0) {
+      int iVal=0;
+      payload.Vp = _RELPAY[iVal++]*val;
+      payload.Vs = _RELPAY[iVal++]*val;
+      payload.Density = _RELPAY[iVal++]*val;
+      payload.Qp = _RELPAY[iVal++]*val;
+      payload.Qs = _RELPAY[iVal++]*val;
+      payload.DepthFreeSurf = _RELPAY[iVal++]*val;
+      payload.FaultBlock = int(_RELPAY[iVal++]);
+      payload.Zone = int(_RELPAY[iVal++]);
+    } else {
+      payload.Vp = cencalvm::storage::Payload::NODATAVAL;
+      payload.Vs = cencalvm::storage::Payload::NODATAVAL;
+      payload.Density = cencalvm::storage::Payload::NODATAVAL;
+      payload.Qp = cencalvm::storage::Payload::NODATAVAL;
+      payload.Qs = cencalvm::storage::Payload::NODATAVAL;
+      payload.DepthFreeSurf = cencalvm::storage::Payload::NODATAVAL;
+      payload.FaultBlock = cencalvm::storage::Payload::NODATABLOCK;
+      payload.Zone = cencalvm::storage::Payload::NODATAZONE;
+    } // if/else
+
+    const int err = etree_insert(db, addr, &payload);
+    CPPUNIT_ASSERT(0 == err);
+  } // for
+} // _insertOctants
+
+// ----------------------------------------------------------------------
+// Insert leaf octants created by subdividing leaf octants of the
+// extended model into etree database.
+void
+cencalvm::average::TestMerger::_insertSplit(etree_t* db) const
+{ // _insertSplit
+  CPPUNIT_ASSERT(0 != db);
+
+  cencalvm::storage::GeomCenCA geometry;
+  for (int i=0; i < _NUMSPLIT; ++i) {
+    const int numCoords = 3;
+    const int iCover = _SPLITCOVERS[i];
+    etree_addr_t addrCover;
+    addrCover.level = _EXTLEVELS[iCover];
+    const etree_tick_t tickLenCover = 0x80000000 >> addrCover.level;
+    addrCover.x = tickLenCover * _EXTCOORDS[numCoords*iCover  ];
+    addrCover.y = tickLenCover * _EXTCOORDS[numCoords*iCover+1];
+    addrCover.z = tickLenCover * _EXTCOORDS[numCoords*iCover+2];
+
+    etree_addr_t addr;
+    addr.level = _SPLITLEVELS[i];
+    addr.type = ETREE_LEAF;
+    const etree_tick_t tickLen = 0x80000000 >> addr.level;
+    addr.x = tickLen * _SPLITCOORDS[numCoords*i  ];
+    addr.y = tickLen * _SPLITCOORDS[numCoords*i+1];
+    addr.z = tickLen * _SPLITCOORDS[numCoords*i+2];
+
+    const double val = _EXTVALS[iCover];
+    cencalvm::storage::PayloadStruct payload;
+    int iVal=0;
+    payload.Vp = _RELPAY[iVal++]*val;
+    payload.Vs = _RELPAY[iVal++]*val;
+    payload.Density = _RELPAY[iVal++]*val;
+    payload.Qp = _RELPAY[iVal++]*val;
+    payload.Qs = _RELPAY[iVal++]*val;
+    payload.DepthFreeSurf = _RELPAY[iVal++]*val;
+    payload.FaultBlock = int(_RELPAY[iVal++]);
+    payload.Zone = int(_RELPAY[iVal++]);
+
+    // Depth of free surface is relative to octant centroid.
+    double lon = 0.0;
+    double lat = 0.0;
+    double elevCover = 0.0;
+    geometry.addrToLonLatElev(&lon, &lat, &elevCover, &addrCover);
+    double elev = 0.0;
+    geometry.addrToLonLatElev(&lon, &lat, &elev, &addr);
+    payload.DepthFreeSurf += elevCover - elev;
+
+    const int err = etree_insert(db, addr, &payload);
+    CPPUNIT_ASSERT(0 == err);
+  } // for
+} // _insertSplit
+
+// ----------------------------------------------------------------------
+// Create etree database from octants.
+void
+cencalvm::average::TestMerger::_createDB(const char* filename,
+					 const int* levels,
+					 const int* coords,
+					 const double* vals,
+					 const int numOctants) const
+{ // _createDB
+  etree_t* db = etree_open(filename, O_CREAT|O_RDWR|O_TRUNC, 0, 0, 3);
+  CPPUNIT_ASSERT(0 != db);
+  int err = etree_registerschema(db, cencalvm::storage::Payload::SCHEMA);
+  CPPUNIT_ASSERT(0 == err);
+  _insertOctants(db, levels, coords, vals, 0, numOctants);
+  err = etree_close(db);
+  CPPUNIT_ASSERT(0 == err);
+} // _createDB
+
+// ----------------------------------------------------------------------
+// Average etree database.
+void
+cencalvm::average::TestMerger::_averageDB(const char* filenameIn,
+					   const char* filenameOut) const
+{ // _averageDB
+  Averager averager;
+  averager.filenameIn(filenameIn);
+  averager.filenameOut(filenameOut);
+  averager.quiet(true);
+  averager.average();
+} // _averageDB
+
+// ----------------------------------------------------------------------
+// Check that octants in etree database match those in reference
+// database.
+void
+cencalvm::average::TestMerger::_checkDB(const char* filename,
+					 const char* filenameE) const
+{ // _checkDB
+  etree_t* db = etree_open(filename, O_RDONLY, 0, 0, 0);
+  CPPUNIT_ASSERT(0 != db);
+  etree_t* dbE = etree_open(filenameE, O_RDONLY, 0, 0, 0);
+  CPPUNIT_ASSERT(0 != dbE);
+
+  etree_addr_t cursor;
+  cursor.x = 0;
+  cursor.y = 0;
+  cursor.z = 0;
+  cursor.t = 0;
+  cursor.level = ETREE_MAXLEVEL;
+  int eof = etree_initcursor(db, cursor);
+  int eofE = etree_initcursor(dbE, cursor);
+  CPPUNIT_ASSERT(0 == eof);
+  CPPUNIT_ASSERT(0 == eofE);
+
+  const double tolerance = 1.0e-06;
+  int numOctants = 0;
+  while (!eofE) {
+    CPPUNIT_ASSERT(!eof);
+
+    etree_addr_t addr;
+    cencalvm::storage::PayloadStruct payload;
+    int err = etree_getcursor(db, &addr, "*", &payload);
+    CPPUNIT_ASSERT(0 == err);
+
+    etree_addr_t addrE;
+    cencalvm::storage::PayloadStruct payloadE;
+    err = etree_getcursor(dbE, &addrE, "*", &payloadE);
+    CPPUNIT_ASSERT(0 == err);
+
+    CPPUNIT_ASSERT_EQUAL(addrE.x, addr.x);
+    CPPUNIT_ASSERT_EQUAL(addrE.y, addr.y);
+    CPPUNIT_ASSERT_EQUAL(addrE.z, addr.z);
+    CPPUNIT_ASSERT_EQUAL(addrE.level, addr.level);
+    CPPUNIT_ASSERT_EQUAL(addrE.type, addr.type);
+
+    CPPUNIT_ASSERT_DOUBLES_EQUAL(1.0, payload.Vp/payloadE.Vp, tolerance);
+    CPPUNIT_ASSERT_DOUBLES_EQUAL(1.0, payload.Vs/payloadE.Vs, tolerance);
+    CPPUNIT_ASSERT_DOUBLES_EQUAL(1.0, payload.Density/payloadE.Density,
+				 tolerance);
+    CPPUNIT_ASSERT_DOUBLES_EQUAL(1.0, payload.Qp/payloadE.Qp, tolerance);
+    CPPUNIT_ASSERT_DOUBLES_EQUAL(1.0, payload.Qs/payloadE.Qs, tolerance);
+    CPPUNIT_ASSERT_DOUBLES_EQUAL(1.0, 
+				 payload.DepthFreeSurf/payloadE.DepthFreeSurf,
+				 tolerance);
+    CPPUNIT_ASSERT_EQUAL(payloadE.FaultBlock, payload.FaultBlock);
+    CPPUNIT_ASSERT_EQUAL(payloadE.Zone, payload.Zone);
+    ++numOctants;
+
+    eof = etree_advcursor(db);
+    eofE = etree_advcursor(dbE);
+  } // while
+  CPPUNIT_ASSERT(0 != eof);
+  CPPUNIT_ASSERT(numOctants > 0);
+
+  int err = etree_close(dbE);
+  CPPUNIT_ASSERT(0 == err);
+  err = etree_close(db);
+  CPPUNIT_ASSERT(0 == err);
+} // _checkDB
+
+// End of file 
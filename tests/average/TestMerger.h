@@ -0,0 +1,163 @@
+// -*- C++ -*-
+//
+// ----------------------------------------------------------------------
+//
+//                           Brad T. Aagaard
+//                        U.S. Geological Survey
+//
+// {LicenseText}
+//
+// ----------------------------------------------------------------------
+//
+
+/** @file tests/TestMerger.h
+ *
+ * @brief C++ TestMerger object
+ *
+ * C++ unit testing for Merger.
+ */
+
+#if !defined(cencalvm_average_testmerger_h)
+#define cencalvm_average_testmerger_h
+
+#include <cppunit/extensions/HelperMacros.h>
+
+#include "cencalvm/storage/etreefwd.h" // USES etree_t
+
+namespace cencalvm {
+  namespace average {
+    class TestMerger;
+  } // average
+} // cencalvm
+
+/// C++ unit testing for Merger
+class cencalvm::average::TestMerger : public CppUnit::TestFixture
+{ // class TestMerger
+
+  // CPPUNIT TEST SUITE /////////////////////////////////////////////////
+  CPPUNIT_TEST_SUITE( TestMerger );
+  CPPUNIT_TEST( testConstructor );
+  CPPUNIT_TEST( testMergeLeaves );
+  CPPUNIT_TEST( testMergeAveraged );
+  CPPUNIT_TEST( testMergeAveragedSpill );
+  CPPUNIT_TEST( testMergeAutoCache );
+  CPPUNIT_TEST( testMergeMixed );
+  CPPUNIT_TEST_SUITE_END();
+
+  // PUBLIC METHODS /////////////////////////////////////////////////////
+public :
+
+  /// Test constructor
+  void testConstructor(void);
+
+  /// Test merge() with databases that have not been averaged.
+  void testMergeLeaves(void);
+
+  /// Test merge() with averaged databases.
+  void testMergeAveraged(void);
+
+  /// Test merge() with write-behind buffer too small for subtrees.
+  void testMergeAveragedSpill(void);
+
+  /// Test merge() with automatic sizing of etree caches.
+  void testMergeAutoCache(void);
+
+  /// Test merge() with only one database averaged.
+  void testMergeMixed(void);
+
+  // PRIVATE METHODS ////////////////////////////////////////////////////
+private :
+
+  /** Create databases for detailed, extended, and merged leaf octants
+   * along with averaged versions of all three databases.
+   */
+  void _createDBs(void) const;
+
+  /** Insert octants into etree database.
+   *
+   * @param db Etree database
+   * @param levels Levels of octants
+   * @param coords Coordinates of octants
+   * @param vals Octant values (negative for no data)
+   * @param indices Indices of octants to insert (0 for all octants)
+   * @param numOctants Number of octants to insert
+   */
+  void _insertOctants(etree_t* db,
+		      const int* levels,
+		      const int* coords,
+		      const double* vals,
+		      const int* indices,
+		      const int numOctants) const;
+
+  /** Insert leaf octants created by subdividing leaf octants of the
+   * extended model into etree database.
+   *
+   * @param db Etree database
+   */
+  void _insertSplit(etree_t* db) const;
+
+  /** Create etree database from octants.
+   *
+   * @param filename Name of database file
+   * @param levels Levels of octants
+   * @param coords Coordinates of octants
+   * @param vals Octant values (negative for no data)
+   * @param numOctants Number of octants
+   */
+  void _createDB(const char* filename,
+		 const int* levels,
+		 const int* coords,
+		 const double* vals,
+		 const int numOctants) const;
+
+  /** Average etree database.
+   *
+   * @param filenameIn Name of input database file
+   * @param filenameOut Name of averaged database file
+   */
+  void _averageDB(const char* filenameIn,
+		  const char* filenameOut) const;
+
+  /** Check that octants in etree database match those in reference
+   * database.
+   *
+   * @param filename Name of database file
+   * @param filenameE Name of database file with expected octants
+   */
+  void _checkDB(const char* filename,
+		const char* filenameE) const;
+
+  // PRIVATE MEMBERS ////////////////////////////////////////////////////
+private :
+
+  static const int _NUMDETAILED; ///< Number of octants in detailed model
+  static const int _DETAILEDLEVELS[]; ///< Levels of octants in detailed
+  static const int _DETAILEDCOORDS[]; ///< Coordinates of octants in detailed
+  static const double _DETAILEDVALS[]; ///< Octant values in detailed
+  static const int _NUMEXT; ///< Number of octants in extended model
+  static const int _EXTLEVELS[]; ///< Levels of octants in extended
+  static const int _EXTCOORDS[]; ///< Coordinates of octants in extended
+  static const double _EXTVALS[]; ///< Octant values in extended
+  static const int _NUMKEPTDETAILED; ///< Number of detailed octants merged
+  static const int _KEPTDETAILED[]; ///< Indices of detailed octants merged
+  static const int _NUMKEPTEXT; ///< Number of extended octants merged
+  static const int _KEPTEXT[]; ///< Indices of extended octants merged
+  static const int _NUMSPLIT; ///< Number of subdivided leaf octants
+  static const int _SPLITLEVELS[]; ///< Levels of subdivided leaf octants
+  static const int _SPLITCOORDS[]; ///< Coordinates of subdivided leaves
+  static const int _SPLITCOVERS[]; ///< Indices of extended octants split
+  static const double _RELPAY[]; ///< Relative values of payload
+
+  static const char* _DBFILENAMEDETAILED; ///< Filename of detailed model
+  static const char* _DBFILENAMEDETAILEDAVG; ///< Filename of averaged detailed
+  static const char* _DBFILENAMEEXT; ///< Filename of extended model
+  static const char* _DBFILENAMEEXTAVG; ///< Filename of averaged extended
+  static const char* _DBFILENAMEMERGED; ///< Filename of merged database
+  static const char* _DBFILENAMEMERGEDAVG; ///< Filename of averaged merged
+  static const char* _DBFILENAMEOUT; ///< Filename of output database
+
+}; // class TestMerger
+
+#endif // cencalvm_average_testmerger_h
+
+// End of file 
@@ -0,0 +1,297 @@
+// -*- C++ -*-
+//
+// ----------------------------------------------------------------------
+//
+//                           Brad T. Aagaard
+//                        U.S. Geological Survey
+//
+// {LicenseText}
+//
+// ----------------------------------------------------------------------
+//
+
+#include "TestPatcher.h" // Implementation of class methods
+
+#include "cencalvm/average/Patcher.h" // USES Patcher
+#include "cencalvm/average/Averager.h" // USES Averager
+
+#include "cencalvm/storage/Payload.h" // USES Payload
+#include "cencalvm/storage/CacheMonitor.h" // USES CacheMonitor::AUTOSIZE
+
+extern "C" {
+#include "etree.h" // USES etree
+}
+
+#include <stdexcept> // USES std::runtime_error
+#include <math.h> // USES fabs()
+
+// ----------------------------------------------------------------------
+CPPUNIT_TEST_SUITE_REGISTRATION( cencalvm::average::TestPatcher );
+
+// ----------------------------------------------------------------------
+#include "data/TestPatcher.dat"
+
+// ----------------------------------------------------------------------
+// Test constructor
+void
+cencalvm::average::TestPatcher::testConstructor(void)
+{ // testConstructor
+  Patcher patcher;
+} // testConstructor
+
+// ----------------------------------------------------------------------
+// Test patch() with averaged base database.
+void
+cencalvm::average::TestPatcher::testPatchAveraged(void)
+{ // testPatchAveraged
+  _createDBs();
+
+  Patcher patcher;
+  patcher.filenameIn(_DBFILENAMEBASEAVG);
+  patcher.filenamePatch(_DBFILENAMEPATCH);
+  patcher.filenameOut(_DBFILENAMEOUT);
+  patcher.quiet(true);
+  patcher.patch();
+
+  // Patching averaged base must give same result as averaging merged
+  // leaf octants from scratch.
+  _checkDB(_DBFILENAMEOUT, _DBFILENAMEMERGEDAVG);
+} // testPatchAveraged
+
+// ----------------------------------------------------------------------
+// Test patch() with write-behind buffer too small for subtrees.
+void
+cencalvm::average::TestPatcher::testPatchAveragedSpill(void)
+{ // testPatchAveragedSpill
+  _createDBs();
+
+  Patcher patcher;
+  patcher.filenameIn(_DBFILENAMEBASEAVG);
+  patcher.filenamePatch(_DBFILENAMEPATCH);
+  patcher.filenameOut(_DBFILENAMEOUT);
+  patcher.bufferSize(2);
+  patcher.quiet(true);
+  patcher.patch();
+
+  _checkDB(_DBFILENAMEOUT, _DBFILENAMEMERGEDAVG);
+} // testPatchAveragedSpill
+
+// ----------------------------------------------------------------------
+// Test patch() with automatic sizing of etree caches.
+void
+cencalvm::average::TestPatcher::testPatchAutoCache(void)
+{ // testPatchAutoCache
+  _createDBs();
+
+  Patcher patcher;
+  patcher.filenameIn(_DBFILENAMEBASEAVG);
+  patcher.filenamePatch(_DBFILENAMEPATCH);
+  patcher.filenameOut(_DBFILENAMEOUT);
+  patcher.cacheSize(storage::CacheMonitor::AUTOSIZE);
+  patcher.quiet(true);
+  patcher.patch();
+
+  _checkDB(_DBFILENAMEOUT, _DBFILENAMEMERGEDAVG);
+} // testPatchAutoCache
+
+// ----------------------------------------------------------------------
+// Test patch() with base database that has not been averaged.
+void
+cencalvm::average::TestPatcher::testPatchLeaves(void)
+{ // testPatchLeaves
+  _createDBs();
+
+  Patcher patcher;
+  patcher.filenameIn(_DBFILENAMEBASE);
+  patcher.filenamePatch(_DBFILENAMEPATCH);
+  patcher.filenameOut(_DBFILENAMEOUT);
+  patcher.quiet(true);
+  patcher.patch();
+
+  _checkDB(_DBFILENAMEOUT, _DBFILENAMEMERGED);
+} // testPatchLeaves
+
+// ----------------------------------------------------------------------
+// Test patch() with patch that refines leaf of base database.
+void
+cencalvm::average::TestPatcher::testPatchRefine(void)
+{ // testPatchRefine
+  _createDBs();
+
+  etree_t* db = etree_open(_DBFILENAMEPATCH, O_CREAT|O_RDWR|O_TRUNC, 0, 0, 3);
+  CPPUNIT_ASSERT(0 != db);
+  int err = etree_registerschema(db, cencalvm::storage::Payload::SCHEMA);
+  CPPUNIT_ASSERT(0 == err);
+  const double val = 1.0;
+  _insertOctants(db, &_REFINELEVEL, _REFINECOORDS, &val, 0, 1);
+  err = etree_close(db);
+  CPPUNIT_ASSERT(0 == err);
+
+  Patcher patcher;
+  patcher.filenameIn(_DBFILENAMEBASEAVG);
+  patcher.filenamePatch(_DBFILENAMEPATCH);
+  patcher.filenameOut(_DBFILENAMEOUT);
+  patcher.quiet(true);
+  CPPUNIT_ASSERT_THROW(patcher.patch(), std::runtime_error);
+} // testPatchRefine
+
+// ----------------------------------------------------------------------
+// Create databases for base, patch, and merged leaf octants along with
+// averaged versions of base and merged databases.
+void
+cencalvm::average::TestPatcher::_createDBs(void) const
+{ // _createDBs
+  etree_t* db = etree_open(_DBFILENAMEBASE, O_CREAT|O_RDWR|O_TRUNC, 0, 0, 3);
+  CPPUNIT_ASSERT(0 != db);
+  int err = etree_registerschema(db, cencalvm::storage::Payload::SCHEMA);
+  CPPUNIT_ASSERT(0 == err);
+  _insertOctants(db, _BASELEVELS, _BASECOORDS, _BASEVALS, 0, _NUMBASE);
+  err = etree_close(db);
+  CPPUNIT_ASSERT(0 == err);
+
+  db = etree_open(_DBFILENAMEPATCH, O_CREAT|O_RDWR|O_TRUNC, 0, 0, 3);
+  CPPUNIT_ASSERT(0 != db);
+  err = etree_registerschema(db, cencalvm::storage::Payload::SCHEMA);
+  CPPUNIT_ASSERT(0 == err);
+  _insertOctants(db, _PATCHLEVELS, _PATCHCOORDS, _PATCHVALS, 0, _NUMPATCH);
+  err = etree_close(db);
+  CPPUNIT_ASSERT(0 == err);
+
+  db = etree_open(_DBFILENAMEMERGED, O_CREAT|O_RDWR|O_TRUNC, 0, 0, 3);
+  CPPUNIT_ASSERT(0 != db);
+  err = etree_registerschema(db, cencalvm::storage::Payload::SCHEMA);
+  CPPUNIT_ASSERT(0 == err);
+  _insertOctants(db, _BASELEVELS, _BASECOORDS, _BASEVALS, _KEPT, _NUMKEPT);
+  _insertOctants(db, _PATCHLEVELS, _PATCHCOORDS, _PATCHVALS, 0, _NUMPATCH);
+  err = etree_close(db);
+  CPPUNIT_ASSERT(0 == err);
+
+  _averageDB(_DBFILENAMEBASE, _DBFILENAMEBASEAVG);
+  _averageDB(_DBFILENAMEMERGED, _DBFILENAMEMERGEDAVG);
+} // _createDBs
+
+// ----------------------------------------------------------------------
+// Insert octants into etree database.
+void
+cencalvm::average::TestPatcher::_insertOctants(etree_t* db,
+					       const int* levels,
+					       const int* coords,
+					       const double* vals,
+					       const int* indices,
+					       const int numOctants) const
+{ // _insertOctants
+  CPPUNIT_ASSERT(0 != db);
+
+  for (int i=0; i < numOctants; ++i) {
+    const int iOctant = (0 != indices) ? indices[i] : i;
+
+    etree_addr_t addr;
+    addr.level = levels[iOctant];
+    addr.type = ETREE_LEAF;
+
+    const etree_tick_t tickLen = 0x80000000 >> addr.level;
+    const int numCoords = 3;
+    addr.x = tickLen * coords[numCoords*iOctant  ];
+    addr.y = tickLen * coords[numCoords*iOctant+1];
+    addr.z = tickLen * coords[numCoords*iOctant+2];
+
+    const double val = vals[iOctant];
+    cencalvm::storage::PayloadStruct payload;
+    int iVal=0;
+    payload.Vp = _RELPAY[iVal++]*val;
+    payload.Vs = _RELPAY[iVal++]*val;
+    payload.Density = _RELPAY[iVal++]*val;
+    payload.Qp = _RELPAY[iVal++]*val;
+    payload.Qs = _RELPAY[iVal++]*val;
+    payload.DepthFreeSurf = _RELPAY[iVal++]*val;
+    payload.FaultBlock = int(_RELPAY[iVal++]);
+    payload.Zone = int(_RELPAY[iVal++]);
+
+    const int err = etree_insert(db, addr, &payload);
+    CPPUNIT_ASSERT(0 == err);
+  } // for
+} // _insertOctants
+
+// ----------------------------------------------------------------------
+// Average etree database.
+void
+cencalvm::average::TestPatcher::_averageDB(const char* filenameIn,
+					   const char* filenameOut) const
+{ // _averageDB
+  Averager averager;
+  averager.filenameIn(filenameIn);
+  averager.filenameOut(filenameOut);
+  averager.quiet(true);
+  averager.average();
+} // _averageDB
+
+// ----------------------------------------------------------------------
+// Check that octants in etree database match those in reference
+// database.
+void
+cencalvm::average::TestPatcher::_checkDB(const char* filename,
+					 const char* filenameE) const
+{ // _checkDB
+  etree_t* db = etree_open(filename, O_RDONLY, 0, 0, 0);
+  CPPUNIT_ASSERT(0 != db);
+  etree_t* dbE = etree_open(filenameE, O_RDONLY, 0, 0, 0);
+  CPPUNIT_ASSERT(0 != dbE);
+
+  etree_addr_t cursor;
+  cursor.x = 0;
+  cursor.y = 0;
+  cursor.z = 0;
+  cursor.t = 0;
+  cursor.level = ETREE_MAXLEVEL;
+  int eof = etree_initcursor(db, cursor);
+  int eofE = etree_initcursor(dbE, cursor);
+  CPPUNIT_ASSERT(0 == eof);
+  CPPUNIT_ASSERT(0 == eofE);
+
+  const double tolerance = 1.0e-06;
+  int numOctants = 0;
+  while (!eofE) {
+    CPPUNIT_ASSERT(!eof);
+
+    etree_addr_t addr;
+    cencalvm::storage::PayloadStruct payload;
+    int err = etree_getcursor(db, &addr, "*", &payload);
+    CPPUNIT_ASSERT(0 == err);
+
+    etree_addr_t addrE;
+    cencalvm::storage::PayloadStruct payloadE;
+    err = etree_getcursor(dbE, &addrE, "*", &payloadE);
+    CPPUNIT_ASSERT(0 == err);
+
+    CPPUNIT_ASSERT_EQUAL(addrE.x, addr.x);
+    CPPUNIT_ASSERT_EQUAL(addrE.y, addr.y);
+    CPPUNIT_ASSERT_EQUAL(addrE.z, addr.z);
+    CPPUNIT_ASSERT_EQUAL(addrE.level, addr.level);
+    CPPUNIT_ASSERT_EQUAL(addrE.type, addr.type);
+
+    CPPUNIT_ASSERT_DOUBLES_EQUAL(1.0, payload.Vp/payloadE.Vp, tolerance);
+    CPPUNIT_ASSERT_DOUBLES_EQUAL(1.0, payload.Vs/payloadE.Vs, tolerance);
+    CPPUNIT_ASSERT_DOUBLES_EQUAL(1.0, payload.Density/payloadE.Density,
+				 tolerance);
+    CPPUNIT_ASSERT_DOUBLES_EQUAL(1.0, payload.Qp/payloadE.Qp, tolerance);
+    CPPUNIT_ASSERT_DOUBLES_EQUAL(1.0, payload.Qs/payloadE.Qs, tolerance);
+    CPPUNIT_ASSERT_DOUBLES_EQUAL(1.0, 
+				 payload.DepthFreeSurf/payloadE.DepthFreeSurf,
+				 tolerance);
+    CPPUNIT_ASSERT_EQUAL(payloadE.FaultBlock, payload.FaultBlock);
+    CPPUNIT_ASSERT_EQUAL(payloadE.Zone, payload.Zone);
+    ++numOctants;
+
+    eof = etree_advcursor(db);
+    eofE = etree_advcursor(dbE);
+  } // while
+  CPPUNIT_ASSERT(0 != eof);
+  CPPUNIT_ASSERT(numOctants > 0);
+
+  int err = etree_close(dbE);
+  CPPUNIT_ASSERT(0 == err);
+  err = etree_close(db);
+  CPPUNIT_ASSERT(0 == err);
+} // _checkDB
+
+// End of file 
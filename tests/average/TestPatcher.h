@@ -0,0 +1,137 @@
+// -*- C++ -*-
+//
+// ----------------------------------------------------------------------
+//
+//                           Brad T. Aagaard
+//                        U.S. Geological Survey
+//
+// {LicenseText}
+//
+// ----------------------------------------------------------------------
+//
+
+/** @file tests/TestPatcher.h
+ *
+ * @brief C++ TestPatcher object
+ *
+ * C++ unit testing for Patcher.
+ */
+
+#if !defined(cencalvm_average_testpatcher_h)
+#define cencalvm_average_testpatcher_h
+
+#include <cppunit/extensions/HelperMacros.h>
+
+#include "cencalvm/storage/etreefwd.h" // USES etree_t
+
+namespace cencalvm {
+  namespace average {
+    class TestPatcher;
+  } // average
+} // cencalvm
+
+/// C++ unit testing for Patcher
+class cencalvm::average::TestPatcher : public CppUnit::TestFixture
+{ // class TestPatcher
+
+  // CPPUNIT TEST SUITE /////////////////////////////////////////////////
+  CPPUNIT_TEST_SUITE( TestPatcher );
+  CPPUNIT_TEST( testConstructor );
+  CPPUNIT_TEST( testPatchAveraged );
+  CPPUNIT_TEST( testPatchAveragedSpill );
+  CPPUNIT_TEST( testPatchAutoCache );
+  CPPUNIT_TEST( testPatchLeaves );
+  CPPUNIT_TEST( testPatchRefine );
+  CPPUNIT_TEST_SUITE_END();
+
+  // PUBLIC METHODS /////////////////////////////////////////////////////
+public :
+
+  /// Test constructor
+  void testConstructor(void);
+
+  /// Test patch() with averaged base database.
+  void testPatchAveraged(void);
+
+  /// Test patch() with write-behind buffer too small for subtrees.
+  void testPatchAveragedSpill(void);
+
+  /// Test patch() with automatic sizing of etree caches.
+  void testPatchAutoCache(void);
+
+  /// Test patch() with base database that has not been averaged.
+  void testPatchLeaves(void);
+
+  /// Test patch() with patch that refines leaf of base database.
+  void testPatchRefine(void);
+
+  // PRIVATE METHODS ////////////////////////////////////////////////////
+private :
+
+  /** Create databases for base, patch, and merged leaf octants along
+   * with averaged versions of base and merged databases.
+   */
+  void _createDBs(void) const;
+
+  /** Insert octants into etree database.
+   *
+   * @param db Etree database
+   * @param levels Levels of octants
+   * @param coords Coordinates of octants
+   * @param vals Octant values
+   * @param indices Indices of octants to insert (0 for all octants)
+   * @param numOctants Number of octants to insert
+   */
+  void _insertOctants(etree_t* db,
+		      const int* levels,
+		      const int* coords,
+		      const double* vals,
+		      const int* indices,
+		      const int numOctants) const;
+
+  /** Average etree database.
+   *
+   * @param filenameIn Name of input database file
+   * @param filenameOut Name of averaged database file
+   */
+  void _averageDB(const char* filenameIn,
+		  const char* filenameOut) const;
+
+  /** Check that octants in etree database match those in reference
+   * database.
+   *
+   * @param filename Name of database file
+   * @param filenameE Name of database file with expected octants
+   */
+  void _checkDB(const char* filename,
+		const char* filenameE) const;
+
+  // PRIVATE MEMBERS ////////////////////////////////////////////////////
+private :
+
+  static const int _NUMBASE; ///< Number of octants in base database
+  static const int _BASELEVELS[]; ///< Levels of octants in base
+  static const int _BASECOORDS[]; ///< Coordinates of octants in base
+  static const double _BASEVALS[]; ///< Octant values in base
+  static const int _NUMPATCH; ///< Number of octants in patch database
+  static const int _PATCHLEVELS[]; ///< Levels of octants in patch
+  static const int _PATCHCOORDS[]; ///< Coordinates of octants in patch
+  static const double _PATCHVALS[]; ///< Octant values in patch
+  static const int _NUMKEPT; ///< Number of base octants not patched
+  static const int _KEPT[]; ///< Indices of base octants not patched
+  static const int _REFINELEVEL; ///< Level of octant refining base leaf
+  static const int _REFINECOORDS[]; ///< Coordinates of octant refining leaf
+  static const double _RELPAY[]; ///< Relative values of payload
+
+  static const char* _DBFILENAMEBASE; ///< Filename of base database
+  static const char* _DBFILENAMEBASEAVG; ///< Filename of averaged base
+  static const char* _DBFILENAMEPATCH; ///< Filename of patch database
+  static const char* _DBFILENAMEMERGED; ///< Filename of merged database
+  static const char* _DBFILENAMEMERGEDAVG; ///< Filename of averaged merged
+  static const char* _DBFILENAMEOUT; ///< Filename of patched database
+
+}; // class TestPatcher
+
+#endif // cencalvm_average_testpatcher_h
+
+// End of file 
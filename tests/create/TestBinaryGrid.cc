@@ -0,0 +1,173 @@
+// -*- C++ -*-
+//
+// ----------------------------------------------------------------------
+//
+//                           Brad T. Aagaard
+//                        U.S. Geological Survey
+//
+// {LicenseText}
+//
+// ----------------------------------------------------------------------
+//
+
+#include "TestBinaryGrid.h" // Implementation of class methods
+
+#include "cencalvm/create/BinaryGrid.h" // USES BinaryGrid
+#include "cencalvm/create/GridIngester.h" // USES GridIngester
+#include "cencalvm/storage/Payload.h" // USES PayloadStruct
+#include "cencalvm/storage/Geometry.h" // USES Geometry
+#include "cencalvm/storage/GeomCenCA.h" // USES GeomCenCA
+
+extern "C" {
+#include "etree.h"
+}
+
+#include <fstream> // USES std::ifstream
+#include <string.h> // USES memcpy()
+
+#include <stdexcept> // USES std::runtime_error
+#include <sstream> // USES std::ostringstream
+
+// ----------------------------------------------------------------------
+CPPUNIT_TEST_SUITE_REGISTRATION( cencalvm::create::TestBinaryGrid );
+
+// ----------------------------------------------------------------------
+// Test header()
+void
+cencalvm::create::TestBinaryGrid::testHeader(void)
+{ // testHeader
+  BinaryGridHeaderStruct header;
+  memcpy(header.magic, BinaryGrid::MAGIC, sizeof(header.magic));
+  header.version = BinaryGrid::VERSION;
+  header.byteOrder = BinaryGrid::BYTEORDER;
+  const char* pData = (const char*) &header;
+
+  CPPUNIT_ASSERT(&header == BinaryGrid::header(pData, sizeof(header)));
+
+  // Too small
+  CPPUNIT_ASSERT(0 == BinaryGrid::header(pData, sizeof(header)-1));
+
+  // ASCII grid
+  const char* ascii = "204.8  51.2  2 2 1 4\n"
+    "-123.85829  38.42416    0.0  1.0e-3 2.0e-3 3.0e-3 4.0 5.0 6.0e-3 1 2 0\n";
+  CPPUNIT_ASSERT(0 == BinaryGrid::header(ascii, strlen(ascii)));
+
+  // Byte order mismatch
+  header.byteOrder = 0x04030201;
+  CPPUNIT_ASSERT_THROW(BinaryGrid::header(pData, sizeof(header)),
+		       std::runtime_error);
+  header.byteOrder = BinaryGrid::BYTEORDER;
+
+  // Unknown version
+  header.version = BinaryGrid::VERSION+1;
+  CPPUNIT_ASSERT_THROW(BinaryGrid::header(pData, sizeof(header)),
+		       std::runtime_error);
+} // testHeader
+
+// ----------------------------------------------------------------------
+// Test convert()
+void
+cencalvm::create::TestBinaryGrid::testConvert(void)
+{ // testConvert
+  const char* filenameIn = "data/one.dat";
+  const char* filenameOut = "data/one.bin";
+
+  BinaryGrid::convert(filenameIn, filenameOut);
+
+  std::ifstream fin(filenameOut, std::ios::binary);
+  CPPUNIT_ASSERT(fin.is_open());
+  BinaryGridHeaderStruct header;
+  fin.read((char*) &header, sizeof(header));
+  CPPUNIT_ASSERT(fin.good());
+  CPPUNIT_ASSERT(&header == BinaryGrid::header((const char*) &header,
+					       sizeof(header)));
+
+  const double tolerance = 1.0e-06;
+  CPPUNIT_ASSERT_DOUBLES_EQUAL(204.8, header.resHoriz, tolerance);
+  CPPUNIT_ASSERT_DOUBLES_EQUAL(51.2, header.resVert, tolerance);
+  CPPUNIT_ASSERT_EQUAL(2, int(header.numX));
+  CPPUNIT_ASSERT_EQUAL(2, int(header.numY));
+  CPPUNIT_ASSERT_EQUAL(1, int(header.numZ));
+  CPPUNIT_ASSERT_EQUAL(4, int(header.numTotal));
+
+  const int numRecords = 4;
+  const double pElev[] = { 0.0, -52.0, -104.0, -156.0 };
+  const int pFaultBlock[] = { 1, 0, 0, 1 };
+  const int pZone[] = { 2, 0, 1, 0 };
+  for (int iRecord=0; iRecord < numRecords; ++iRecord) {
+    BinaryGridRecordStruct record;
+    fin.read((char*) &record, sizeof(record));
+    CPPUNIT_ASSERT(fin.good());
+    CPPUNIT_ASSERT_DOUBLES_EQUAL(-123.85829, record.lon, tolerance);
+    CPPUNIT_ASSERT_DOUBLES_EQUAL(38.42416, record.lat, tolerance);
+    CPPUNIT_ASSERT_DOUBLES_EQUAL(pElev[iRecord], record.elev, tolerance);
+    CPPUNIT_ASSERT_EQUAL(pFaultBlock[iRecord], int(record.faultBlock));
+    CPPUNIT_ASSERT_EQUAL(pZone[iRecord], int(record.zone));
+  } // for
+  fin.peek();
+  CPPUNIT_ASSERT(fin.eof());
+} // testConvert
+
+// ----------------------------------------------------------------------
+// Test ingesting binary grid with GridIngester
+void
+cencalvm::create::TestBinaryGrid::testIngest(void)
+{ // testIngest
+  const char* filenameParams = "data/parambinary.txt";
+  const char* filenameOut = "data/one.etree";
+  const char* filenameTmp = "data/tmp.etree";
+
+  BinaryGrid::convert("data/one.dat", "data/one.bin");
+
+  storage::GeomCenCA geometry;
+  GridIngester ingester;
+  ingester.geometry(&geometry);
+  ingester.filenameParams(filenameParams);
+  ingester.filenameOut(filenameOut);
+  ingester.filenameTmp(filenameTmp);
+  ingester.quiet(true);
+  ingester.run();
+
+  const double p = 409612.5;
+  const double q = 204812.5;
+  const double r = 1587187.5;
+  const etree_tick_t level = 3;
+  const double res = geometry.edgeLen(level);
+  const etree_tick_t tickLen = 0x80000000 >> level;
+  etree_addr_t addr;
+  addr.x = tickLen*int(p / res);
+  addr.y = tickLen*int(q / res);
+  addr.z = tickLen*int(r / res);
+  addr.level = level;
+
+  etree_t* db = etree_open(filenameOut, O_RDONLY, 0, 0, 0);
+  if (0 == db) {
+    std::ostringstream msg;
+    msg << "Could not open etree database '" << filenameOut << "'.";
+    throw std::runtime_error(msg.str());
+  } // if
+
+  etree_addr_t resaddr;
+  storage::PayloadStruct payload;
+  if (0 != etree_search(db, addr, &resaddr, "*", &payload))
+    throw std::runtime_error(etree_strerror(etree_errno(db)));
+  CPPUNIT_ASSERT_EQUAL(addr.x, resaddr.x);
+  CPPUNIT_ASSERT_EQUAL(addr.y, resaddr.y);
+  CPPUNIT_ASSERT_EQUAL(addr.z, resaddr.z);
+  CPPUNIT_ASSERT_EQUAL(addr.level, resaddr.level);
+
+  // Values converted to SI units (see data/one.dat)
+  const double tolerance = 1.0e-06;
+  CPPUNIT_ASSERT_DOUBLES_EQUAL(1.0, payload.Vp, tolerance);
+  CPPUNIT_ASSERT_DOUBLES_EQUAL(2.0, payload.Vs, tolerance);
+  CPPUNIT_ASSERT_DOUBLES_EQUAL(3.0, payload.Density, tolerance);
+  CPPUNIT_ASSERT_DOUBLES_EQUAL(4.0, payload.Qp, tolerance);
+  CPPUNIT_ASSERT_DOUBLES_EQUAL(5.0, payload.Qs, tolerance);
+  CPPUNIT_ASSERT_DOUBLES_EQUAL(6.0, payload.DepthFreeSurf, tolerance);
+  CPPUNIT_ASSERT_EQUAL(int16_t(1), payload.FaultBlock);
+  CPPUNIT_ASSERT_EQUAL(int16_t(2), payload.Zone);
+
+  etree_close(db);
+} // testIngest
+
+// End of file 
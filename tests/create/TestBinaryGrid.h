@@ -0,0 +1,58 @@
+// -*- C++ -*-
+//
+// ----------------------------------------------------------------------
+//
+//                           Brad T. Aagaard
+//                        U.S. Geological Survey
+//
+// {LicenseText}
+//
+// ----------------------------------------------------------------------
+//
+
+/** @file tests/TestBinaryGrid.h
+ *
+ * @brief C++ TestBinaryGrid object
+ *
+ * C++ unit testing for TestBinaryGrid.
+ */
+
+#if !defined(cencalvm_create_testbinarygrid_h)
+#define cencalvm_create_testbinarygrid_h
+
+#include <cppunit/extensions/HelperMacros.h>
+
+namespace cencalvm {
+  namespace create {
+    class TestBinaryGrid;
+  } // create
+} // cencalvm
+
+/// C++ unit testing for BinaryGrid
+class cencalvm::create::TestBinaryGrid : public CppUnit::TestFixture
+{ // class TestBinaryGrid
+
+  // CPPUNIT TEST SUITE /////////////////////////////////////////////////
+  CPPUNIT_TEST_SUITE( TestBinaryGrid );
+  CPPUNIT_TEST( testHeader );
+  CPPUNIT_TEST( testConvert );
+  CPPUNIT_TEST( testIngest );
+  CPPUNIT_TEST_SUITE_END();
+
+  // PUBLIC METHODS /////////////////////////////////////////////////////
+public :
+
+  /// Test header()
+  void testHeader(void);
+
+  /// Test convert()
+  void testConvert(void);
+
+  /// Test ingesting binary grid with GridIngester
+  void testIngest(void);
+
+}; // class TestBinaryGrid
+
+#endif // cencalvm_create_testbinarygrid
+
+// End of file 
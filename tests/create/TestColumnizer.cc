@@ -0,0 +1,235 @@
+// -*- C++ -*-
+//
+// ----------------------------------------------------------------------
+//
+//                           Brad T. Aagaard
+//                        U.S. Geological Survey
+//
+// {LicenseText}
+//
+// ----------------------------------------------------------------------
+//
+
+#include "TestColumnizer.h" // Implementation of class methods
+
+#include "cencalvm/create/Columnizer.h" // USES Columnizer
+#include "cencalvm/create/Quantizer.h" // USES Quantizer
+
+#include "cencalvm/average/Averager.h" // USES Averager
+#include "cencalvm/storage/ColumnDB.h" // USES ColumnDB
+#include "cencalvm/storage/Payload.h" // USES PayloadStruct
+
+extern "C" {
+#include "etree.h"
+}
+
+#include <stdlib.h> // USES free()
+#include <string.h> // USES strcmp(), strstr(), memcmp()
+#include <stdexcept> // USES std::runtime_error
+
+// ----------------------------------------------------------------------
+CPPUNIT_TEST_SUITE_REGISTRATION( cencalvm::create::TestColumnizer );
+
+// ----------------------------------------------------------------------
+const char* cencalvm::create::TestColumnizer::_DBFILENAMELEAVES =
+  "data/columnleaves.etree";
+const char* cencalvm::create::TestColumnizer::_DBFILENAMEAVG =
+  "data/columnavg.etree";
+const char* cencalvm::create::TestColumnizer::_DBFILENAMEOUT =
+  "data/columnout.etree";
+const int cencalvm::create::TestColumnizer::_LEVEL = 3;
+const int cencalvm::create::TestColumnizer::_NUMPERDIM = 4;
+
+// ----------------------------------------------------------------------
+// Test constructor
+void
+cencalvm::create::TestColumnizer::testConstructor(void)
+{ // testConstructor
+  Columnizer columnizer;
+} // testConstructor
+
+// ----------------------------------------------------------------------
+// Test columnize()
+void
+cencalvm::create::TestColumnizer::testColumnize(void)
+{ // testColumnize
+  _createDB();
+
+  etree_t* dbIn = etree_open(_DBFILENAMEAVG, O_RDONLY, 0, 0, 0);
+  CPPUNIT_ASSERT(0 != dbIn);
+  CPPUNIT_ASSERT(storage::ColumnDB::isColumnar(_DBFILENAMEOUT));
+  storage::ColumnDB dbOut;
+  dbOut.open(_DBFILENAMEOUT);
+
+  CPPUNIT_ASSERT_EQUAL(int64_t(etree_gettotalcount(dbIn)), dbOut.numOctants());
+  char* schema = etree_getschema(dbIn);
+  CPPUNIT_ASSERT(0 == strcmp(schema, dbOut.schema()));
+  free(schema);
+  char* appmeta = etree_getappmeta(dbIn);
+  if (0 != appmeta)
+    CPPUNIT_ASSERT(0 != strstr(dbOut.appmeta(), appmeta));
+  free(appmeta);
+  CPPUNIT_ASSERT(0 != strstr(dbOut.appmeta(), "split into columns from"));
+
+  // Every octant must be found with identical payload.
+  etree_addr_t cursor;
+  cursor.x = 0;
+  cursor.y = 0;
+  cursor.z = 0;
+  cursor.t = 0;
+  cursor.level = ETREE_MAXLEVEL;
+  CPPUNIT_ASSERT(0 == etree_initcursor(dbIn, cursor));
+  int numOctants = 0;
+  bool more = true;
+  while (more) {
+    etree_addr_t addrE;
+    storage::PayloadStruct payloadE;
+    CPPUNIT_ASSERT(0 == etree_getcursor(dbIn, &addrE, "*", &payloadE));
+
+    etree_addr_t addr;
+    storage::PayloadStruct payload;
+    CPPUNIT_ASSERT(0 == dbOut.search(&addr, &payload, addrE));
+    CPPUNIT_ASSERT_EQUAL(addrE.x, addr.x);
+    CPPUNIT_ASSERT_EQUAL(addrE.y, addr.y);
+    CPPUNIT_ASSERT_EQUAL(addrE.z, addr.z);
+    CPPUNIT_ASSERT_EQUAL(addrE.level, addr.level);
+    CPPUNIT_ASSERT_EQUAL(int(addrE.type), int(addr.type));
+    CPPUNIT_ASSERT(0 == memcmp(&payloadE, &payload, sizeof(payload)));
+
+    ++numOctants;
+    more = (0 == etree_advcursor(dbIn));
+  } // while
+  CPPUNIT_ASSERT_EQUAL(int(etree_gettotalcount(dbIn)), numOctants);
+
+  CPPUNIT_ASSERT(0 == etree_close(dbIn));
+} // testColumnize
+
+// ----------------------------------------------------------------------
+// Test columnize() with compact input database
+void
+cencalvm::create::TestColumnizer::testColumnizeCompact(void)
+{ // testColumnizeCompact
+  _createDB();
+
+  Quantizer quantizer;
+  quantizer.filenameIn(_DBFILENAMEAVG);
+  quantizer.filenameOut(_DBFILENAMELEAVES);
+  quantizer.quiet(true);
+  quantizer.quantize();
+
+  Columnizer columnizer;
+  columnizer.filenameIn(_DBFILENAMELEAVES);
+  columnizer.filenameOut(_DBFILENAMEOUT);
+  columnizer.quiet(true);
+  CPPUNIT_ASSERT_THROW(columnizer.columnize(), std::runtime_error);
+} // testColumnizeCompact
+
+// ----------------------------------------------------------------------
+// Test searching column-split database for points
+void
+cencalvm::create::TestColumnizer::testSearch(void)
+{ // testSearch
+  _createDB();
+
+  etree_t* dbIn = etree_open(_DBFILENAMEAVG, O_RDONLY, 0, 0, 0);
+  CPPUNIT_ASSERT(0 != dbIn);
+  storage::ColumnDB dbOut;
+  dbOut.open(_DBFILENAMEOUT);
+
+  // Points at octant centers and corners at finer levels must find
+  // the same octant as etree_search().
+  const int numPts = 2*_NUMPERDIM + 1;
+  const etree_tick_t dx = (0x80000000 >> _LEVEL) / 2;
+  for (int iZ=0; iZ < numPts; ++iZ)
+    for (int iY=0; iY < numPts; ++iY)
+      for (int iX=0; iX < numPts; ++iX)
+	for (int level=_LEVEL-1; level <= ETREE_MAXLEVEL; level += 2) {
+	  etree_addr_t addr;
+	  addr.x = iX*dx + 3*iZ;
+	  addr.y = iY*dx + 5*iX;
+	  addr.z = iZ*dx + 7*iY;
+	  addr.t = 0;
+	  addr.level = level;
+	  addr.type = ETREE_LEAF;
+	  const etree_tick_t mask = ~((((etree_tick_t) 0x80000000) >> level) - 1);
+	  addr.x &= mask;
+	  addr.y &= mask;
+	  addr.z &= mask;
+
+	  etree_addr_t resAddrE;
+	  storage::PayloadStruct payloadE;
+	  const int errE = etree_search(dbIn, addr, &resAddrE, "*", &payloadE);
+	  etree_addr_t resAddr;
+	  storage::PayloadStruct payload;
+	  const int err = dbOut.search(&resAddr, &payload, addr);
+	  CPPUNIT_ASSERT_EQUAL(0 == errE, 0 == err);
+	  if (0 == errE) {
+	    CPPUNIT_ASSERT_EQUAL(resAddrE.x, resAddr.x);
+	    CPPUNIT_ASSERT_EQUAL(resAddrE.y, resAddr.y);
+	    CPPUNIT_ASSERT_EQUAL(resAddrE.z, resAddr.z);
+	    CPPUNIT_ASSERT_EQUAL(resAddrE.level, resAddr.level);
+	    CPPUNIT_ASSERT(0 == memcmp(&payloadE, &payload, sizeof(payload)));
+	  } // if
+	} // for
+
+  CPPUNIT_ASSERT(0 == etree_close(dbIn));
+} // testSearch
+
+// ----------------------------------------------------------------------
+// Create averaged etree database and split it into columns.
+void
+cencalvm::create::TestColumnizer::_createDB(void) const
+{ // _createDB
+  etree_t* db = etree_open(_DBFILENAMELEAVES, O_CREAT|O_RDWR|O_TRUNC,
+			   0, 0, 3);
+  CPPUNIT_ASSERT(0 != db);
+  int err = etree_registerschema(db, storage::Payload::SCHEMA);
+  CPPUNIT_ASSERT(0 == err);
+
+  const etree_tick_t tickLen = 0x80000000 >> _LEVEL;
+  for (int iZ=0; iZ < _NUMPERDIM; ++iZ)
+    for (int iY=0; iY < _NUMPERDIM; ++iY)
+      for (int iX=0; iX < _NUMPERDIM; ++iX) {
+	// Leave corner of domain empty.
+	if (iX == _NUMPERDIM-1 && iY == _NUMPERDIM-1)
+	  continue;
+
+	etree_addr_t addr;
+	addr.x = iX*tickLen;
+	addr.y = iY*tickLen;
+	addr.z = iZ*tickLen;
+	addr.t = 0;
+	addr.level = _LEVEL;
+	addr.type = ETREE_LEAF;
+
+	const double val = 1.0 + iX + _NUMPERDIM*(iY + _NUMPERDIM*iZ);
+	storage::PayloadStruct payload;
+	payload.Vp = 2000.0 + 10.3*val;
+	payload.Vs = 1000.0 + 10.7*val;
+	payload.Density = 2000.0 + 1.13*val;
+	payload.Qp = 100.0 + 0.37*val;
+	payload.Qs = 50.0 + 0.19*val;
+	payload.DepthFreeSurf = 100.3*val;
+	payload.FaultBlock = 1 + iX;
+	payload.Zone = 1 + iY;
+
+	err = etree_insert(db, addr, &payload);
+	CPPUNIT_ASSERT(0 == err);
+      } // for
+  err = etree_close(db);
+  CPPUNIT_ASSERT(0 == err);
+
+  average::Averager averager;
+  averager.filenameIn(_DBFILENAMELEAVES);
+  averager.filenameOut(_DBFILENAMEAVG);
+  averager.quiet(true);
+  averager.average();
+
+  Columnizer columnizer;
+  columnizer.filenameIn(_DBFILENAMEAVG);
+  columnizer.filenameOut(_DBFILENAMEOUT);
+  columnizer.quiet(true);
+  columnizer.columnize();
+} // _createDB
+
+// End of file
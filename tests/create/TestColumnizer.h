@@ -0,0 +1,77 @@
+// -*- C++ -*-
+//
+// ----------------------------------------------------------------------
+//
+//                           Brad T. Aagaard
+//                        U.S. Geological Survey
+//
+// {LicenseText}
+//
+// ----------------------------------------------------------------------
+//
+
+/** @file tests/TestColumnizer.h
+ *
+ * @brief C++ TestColumnizer object
+ *
+ * C++ unit testing for Columnizer.
+ */
+
+#if !defined(cencalvm_create_testcolumnizer_h)
+#define cencalvm_create_testcolumnizer_h
+
+#include <cppunit/extensions/HelperMacros.h>
+
+namespace cencalvm {
+  namespace create {
+    class TestColumnizer;
+  } // create
+} // cencalvm
+
+/// C++ unit testing for Columnizer
+class cencalvm::create::TestColumnizer : public CppUnit::TestFixture
+{ // class TestColumnizer
+
+  // CPPUNIT TEST SUITE /////////////////////////////////////////////////
+  CPPUNIT_TEST_SUITE( TestColumnizer );
+  CPPUNIT_TEST( testConstructor );
+  CPPUNIT_TEST( testColumnize );
+  CPPUNIT_TEST( testColumnizeCompact );
+  CPPUNIT_TEST( testSearch );
+  CPPUNIT_TEST_SUITE_END();
+
+  // PUBLIC METHODS /////////////////////////////////////////////////////
+public :
+
+  /// Test constructor
+  void testConstructor(void);
+
+  /// Test columnize()
+  void testColumnize(void);
+
+  /// Test columnize() with compact input database
+  void testColumnizeCompact(void);
+
+  /// Test searching column-split database for points
+  void testSearch(void);
+
+  // PRIVATE METHODS ////////////////////////////////////////////////////
+private :
+
+  /// Create averaged etree database and split it into columns.
+  void _createDB(void) const;
+
+  // PRIVATE MEMBERS ////////////////////////////////////////////////////
+private :
+
+  static const char* _DBFILENAMELEAVES; ///< Filename of leaf database
+  static const char* _DBFILENAMEAVG; ///< Filename of averaged database
+  static const char* _DBFILENAMEOUT; ///< Filename of column-split database
+  static const int _LEVEL; ///< Level of leaf octants
+  static const int _NUMPERDIM; ///< Number of leaf octants along each axis
+
+}; // class TestColumnizer
+
+#endif // cencalvm_create_testcolumnizer
+
+// End of file
@@ -0,0 +1,363 @@
+// -*- C++ -*-
+//
+// ----------------------------------------------------------------------
+//
+//                           Brad T. Aagaard
+//                        U.S. Geological Survey
+//
+// {LicenseText}
+//
+// ----------------------------------------------------------------------
+//
+
+#include "TestCompactor.h" // Implementation of class methods
+
+#include "cencalvm/create/Compactor.h" // USES Compactor
+
+#include "cencalvm/create/Quantizer.h" // USES Quantizer
+#include "cencalvm/average/Averager.h" // USES Averager
+#include "cencalvm/average/Patcher.h" // USES Patcher
+#include "cencalvm/storage/Payload.h" // USES PayloadStruct
+#include "cencalvm/storage/PayloadCodec.h" // USES PayloadCodec
+#include "cencalvm/storage/Geometry.h" // USES Geometry
+#include "cencalvm/storage/GeomCenCA.h" // USES GeomCenCA
+
+extern "C" {
+#include "etree.h"
+}
+
+#include <stdlib.h> // USES free()
+#include <string.h> // USES strstr(), strcmp(), memcpy()
+#include <stdexcept> // USES std::runtime_error
+
+// ----------------------------------------------------------------------
+CPPUNIT_TEST_SUITE_REGISTRATION( cencalvm::create::TestCompactor );
+
+// ----------------------------------------------------------------------
+const char* cencalvm::create::TestCompactor::_DBFILENAMELEAVES =
+  "data/compactleaves.etree";
+const char* cencalvm::create::TestCompactor::_DBFILENAMEAVG =
+  "data/compactavg.etree";
+const char* cencalvm::create::TestCompactor::_DBFILENAMEOUT =
+  "data/compactout.etree";
+const char* cencalvm::create::TestCompactor::_DBFILENAMEPATCH =
+  "data/compactpatch.etree";
+const char* cencalvm::create::TestCompactor::_DBFILENAMEQUANTIZED =
+  "data/compactquantized.etree";
+const int cencalvm::create::TestCompactor::_LEVEL = 3;
+const int cencalvm::create::TestCompactor::_NUMPERDIM = 4;
+
+// ----------------------------------------------------------------------
+// Test constructor
+void
+cencalvm::create::TestCompactor::testConstructor(void)
+{ // testConstructor
+  Compactor compactor;
+} // testConstructor
+
+// ----------------------------------------------------------------------
+// Test compact() with averaged database
+void
+cencalvm::create::TestCompactor::testCompact(void)
+{ // testCompact
+  _createDB(false, true, true);
+
+  // Interior octants at levels 0 and 1 and of two octants at level 2
+  // that are not homogeneous, 6 collapsed subtrees, and 15 leaves in
+  // subtrees that are not homogeneous.
+  const int numOctantsE = 25;
+  const int numCollapsedE = 6;
+  _checkCompact(_DBFILENAMEAVG, numOctantsE, numCollapsedE);
+} // testCompact
+
+// ----------------------------------------------------------------------
+// Test compact() with database of leaf octants
+void
+cencalvm::create::TestCompactor::testCompactLeaves(void)
+{ // testCompactLeaves
+  _createDB(false, true, true);
+
+  const int numOctantsE = 21;
+  const int numCollapsedE = 6;
+  _checkCompact(_DBFILENAMELEAVES, numOctantsE, numCollapsedE);
+} // testCompactLeaves
+
+// ----------------------------------------------------------------------
+// Test compact() with homogeneous subtrees nested in larger one
+void
+cencalvm::create::TestCompactor::testCompactNested(void)
+{ // testCompactNested
+  _createDB(true, true, true);
+
+  // Leaves fill only one child of root octant, so subtree is
+  // collapsed at level 1.
+  const int numOctantsE = 2;
+  const int numCollapsedE = 1;
+  _checkCompact(_DBFILENAMEAVG, numOctantsE, numCollapsedE);
+} // testCompactNested
+
+// ----------------------------------------------------------------------
+// Test compact() with depths of free surface inconsistent with a
+// common free surface
+void
+cencalvm::create::TestCompactor::testCompactDepth(void)
+{ // testCompactDepth
+  _createDB(false, false, true);
+
+  // Leaves with identical depths of free surface at different
+  // elevations do not share a free surface, so no subtrees are
+  // collapsed. Interior octants at levels 0, 1, and 2 and 63 leaves.
+  const int numOctantsE = 73;
+  const int numCollapsedE = 0;
+  _checkCompact(_DBFILENAMEAVG, numOctantsE, numCollapsedE);
+} // testCompactDepth
+
+// ----------------------------------------------------------------------
+// Test compact() with free surface above leaves
+void
+cencalvm::create::TestCompactor::testCompactSurface(void)
+{ // testCompactSurface
+  _createDB(true, true, false);
+
+  // Queries relative to the free surface would depend on the height
+  // of collapsed octants, so no subtrees are collapsed. Interior
+  // octants at levels 0, 1, and 2 and 64 leaves.
+  const int numOctantsE = 74;
+  const int numCollapsedE = 0;
+  _checkCompact(_DBFILENAMEAVG, numOctantsE, numCollapsedE);
+} // testCompactSurface
+
+// ----------------------------------------------------------------------
+// Test compact() with database of compact payloads
+void
+cencalvm::create::TestCompactor::testCompactQuantized(void)
+{ // testCompactQuantized
+  _createDB(false, true, true);
+
+  Quantizer quantizer;
+  quantizer.filenameIn(_DBFILENAMEAVG);
+  quantizer.filenameOut(_DBFILENAMEQUANTIZED);
+  quantizer.errorBound("DepthFreeSurf", 5.0);
+  quantizer.quiet(true);
+  quantizer.quantize();
+
+  // Same subtrees are collapsed as for the full payloads.
+  const int numOctantsE = 25;
+  const int numCollapsedE = 6;
+  _checkCompact(_DBFILENAMEQUANTIZED, numOctantsE, numCollapsedE);
+} // testCompactQuantized
+
+// ----------------------------------------------------------------------
+// Test that patching compacted database fails
+void
+cencalvm::create::TestCompactor::testPatch(void)
+{ // testPatch
+  _createDB(false, true, true);
+
+  Compactor compactor;
+  compactor.filenameIn(_DBFILENAMEAVG);
+  compactor.filenameOut(_DBFILENAMEOUT);
+  compactor.quiet(true);
+  compactor.compact();
+
+  average::Patcher patcher;
+  patcher.filenameIn(_DBFILENAMEOUT);
+  patcher.filenamePatch(_DBFILENAMELEAVES);
+  patcher.filenameOut(_DBFILENAMEPATCH);
+  patcher.quiet(true);
+  CPPUNIT_ASSERT_THROW(patcher.patch(), std::runtime_error);
+} // testPatch
+
+// ----------------------------------------------------------------------
+// Create database with leaf octants and averaged database.
+void
+cencalvm::create::TestCompactor::_createDB(const bool isUniform,
+					   const bool isDepthConsistent,
+					   const bool isSurfaceInData) const
+{ // _createDB
+  storage::GeomCenCA geometry;
+
+  etree_t* db = etree_open(_DBFILENAMELEAVES, O_CREAT|O_RDWR|O_TRUNC,
+			   0, 0, 3);
+  CPPUNIT_ASSERT(0 != db);
+  int err = etree_registerschema(db, storage::Payload::SCHEMA);
+  CPPUNIT_ASSERT(0 == err);
+
+  const etree_tick_t tickLen = 0x80000000 >> _LEVEL;
+  for (int iZ=0; iZ < _NUMPERDIM; ++iZ)
+    for (int iY=0; iY < _NUMPERDIM; ++iY)
+      for (int iX=0; iX < _NUMPERDIM; ++iX) {
+	// Leave one leaf in parent (1,1,0) empty.
+	if (!isUniform && 3 == iX && 3 == iY && 0 == iZ)
+	  continue;
+
+	etree_addr_t addr;
+	addr.x = iX*tickLen;
+	addr.y = iY*tickLen;
+	addr.z = iZ*tickLen;
+	addr.t = 0;
+	addr.level = _LEVEL;
+	addr.type = ETREE_LEAF;
+
+	// Payload is uniform within parent octant, except for one leaf
+	// in parent (1,0,0).
+	double val = 1.0;
+	if (!isUniform) {
+	  val += iX/2 + 2*(iY/2 + 2*(iZ/2));
+	  if (3 == iX && 0 == iY && 0 == iZ)
+	    val += 0.5;
+	} // if
+	storage::PayloadStruct payload;
+	payload.Vp = 2000.0 + 10.3*val;
+	payload.Vs = 1000.0 + 10.7*val;
+	payload.Density = 2000.0 + 1.13*val;
+	payload.Qp = 100.0 + 0.37*val;
+	payload.Qs = 50.0 + 0.19*val;
+	payload.DepthFreeSurf = 100.3*val;
+	payload.FaultBlock = 1;
+	if (isDepthConsistent) {
+	  // Depth is relative to centroid of leaf and free surface is
+	  // near centroids of top layer of leaves or of layer above.
+	  double lon = 0.0;
+	  double lat = 0.0;
+	  double elev = 0.0;
+	  geometry.addrToLonLatElev(&lon, &lat, &elev, &addr);
+	  etree_addr_t surfAddr = addr;
+	  surfAddr.z = ((isSurfaceInData) ? _NUMPERDIM-1 : _NUMPERDIM)*tickLen;
+	  double elevSurf = 0.0;
+	  geometry.addrToLonLatElev(&lon, &lat, &elevSurf, &surfAddr);
+	  payload.DepthFreeSurf += elevSurf - elev;
+	} // if
+	payload.Zone = 2;
+
+	err = etree_insert(db, addr, &payload);
+	CPPUNIT_ASSERT(0 == err);
+      } // for
+  err = etree_close(db);
+  CPPUNIT_ASSERT(0 == err);
+
+  average::Averager averager;
+  averager.filenameIn(_DBFILENAMELEAVES);
+  averager.filenameOut(_DBFILENAMEAVG);
+  averager.quiet(true);
+  averager.average();
+} // _createDB
+
+// ----------------------------------------------------------------------
+// Compact database and check searches at leaf octants.
+void
+cencalvm::create::TestCompactor::_checkCompact(const char* filenameDB,
+					       const int numOctantsE,
+					       const int numCollapsedE) const
+{ // _checkCompact
+  Compactor compactor;
+  compactor.filenameIn(filenameDB);
+  compactor.filenameOut(_DBFILENAMEOUT);
+  compactor.quiet(true);
+  compactor.compact();
+
+  etree_t* dbOut = etree_open(_DBFILENAMEOUT, O_RDONLY, 0, 0, 0);
+  CPPUNIT_ASSERT(0 != dbOut);
+
+  char* schema = etree_getschema(dbOut);
+  CPPUNIT_ASSERT(0 != schema);
+  const bool isCompact = (0 == strcmp(storage::Payload::SCHEMACOMPACT, schema));
+  free(schema);
+
+  storage::PayloadCodec codec;
+  char* appmeta = etree_getappmeta(dbOut);
+  CPPUNIT_ASSERT(0 != appmeta);
+  CPPUNIT_ASSERT(0 != strstr(appmeta, storage::Payload::COMPACTEDTAG));
+  if (isCompact)
+    codec.parseMetadata(appmeta);
+  free(appmeta);
+
+  // Collapsed subtrees are leaf octants coarser than data.
+  etree_addr_t addr;
+  addr.x = 0;
+  addr.y = 0;
+  addr.z = 0;
+  addr.t = 0;
+  addr.level = ETREE_MAXLEVEL;
+  int numOctants = 0;
+  int numCollapsed = 0;
+  bool more = (0 == etree_initcursor(dbOut, addr));
+  while (more) {
+    storage::PayloadStruct payload;
+    CPPUNIT_ASSERT(0 == etree_getcursor(dbOut, &addr, "*", &payload));
+    ++numOctants;
+    if (ETREE_LEAF == addr.type && addr.level < _LEVEL)
+      ++numCollapsed;
+    more = (0 == etree_advcursor(dbOut));
+  } // while
+  CPPUNIT_ASSERT_EQUAL(numOctantsE, numOctants);
+  CPPUNIT_ASSERT_EQUAL(numCollapsedE, numCollapsed);
+
+  // Maximum resolution searches return identical payloads, except
+  // for depths of free surface relative to centroids of collapsed
+  // subtrees.
+  storage::GeomCenCA geometry;
+  const double tolerance = 0.1 +
+    ((isCompact) ? 2.0*codec.errorBound("DepthFreeSurf") : 0.0);
+  etree_t* dbIn = etree_open(filenameDB, O_RDONLY, 0, 0, 0);
+  CPPUNIT_ASSERT(0 != dbIn);
+  const etree_tick_t tickLen = 0x80000000 >> _LEVEL;
+  int numLeaves = 0;
+  for (int iZ=0; iZ < _NUMPERDIM; ++iZ)
+    for (int iY=0; iY < _NUMPERDIM; ++iY)
+      for (int iX=0; iX < _NUMPERDIM; ++iX) {
+	addr.x = iX*tickLen;
+	addr.y = iY*tickLen;
+	addr.z = iZ*tickLen;
+	addr.t = 0;
+	addr.level = ETREE_MAXLEVEL;
+	addr.type = ETREE_LEAF;
+
+	etree_addr_t resAddrE;
+	storage::PayloadStruct payloadE;
+	const bool isLeafE =
+	  0 == etree_search(dbIn, addr, &resAddrE, "*", &payloadE) &&
+	  ETREE_LEAF == resAddrE.type;
+
+	etree_addr_t resAddr;
+	storage::PayloadStruct payload;
+	const bool isLeaf =
+	  0 == etree_search(dbOut, addr, &resAddr, "*", &payload) &&
+	  ETREE_LEAF == resAddr.type;
+
+	CPPUNIT_ASSERT_EQUAL(isLeafE, isLeaf);
+	if (isLeafE) {
+	  ++numLeaves;
+	  if (isCompact) {
+	    storage::PayloadCompactStruct compact;
+	    memcpy(&compact, &payloadE, sizeof(compact));
+	    codec.decode(&payloadE, compact);
+	    memcpy(&compact, &payload, sizeof(compact));
+	    codec.decode(&payload, compact);
+	  } // if
+	  CPPUNIT_ASSERT_EQUAL(payloadE.Vp, payload.Vp);
+	  CPPUNIT_ASSERT_EQUAL(payloadE.Vs, payload.Vs);
+	  CPPUNIT_ASSERT_EQUAL(payloadE.Density, payload.Density);
+	  CPPUNIT_ASSERT_EQUAL(payloadE.Qp, payload.Qp);
+	  CPPUNIT_ASSERT_EQUAL(payloadE.Qs, payload.Qs);
+	  CPPUNIT_ASSERT_EQUAL(payloadE.FaultBlock, payload.FaultBlock);
+	  CPPUNIT_ASSERT_EQUAL(payloadE.Zone, payload.Zone);
+
+	  double lon = 0.0;
+	  double lat = 0.0;
+	  double elevE = 0.0;
+	  geometry.addrToLonLatElev(&lon, &lat, &elevE, &resAddrE);
+	  double elev = 0.0;
+	  geometry.addrToLonLatElev(&lon, &lat, &elev, &resAddr);
+	  CPPUNIT_ASSERT_DOUBLES_EQUAL(elevE + payloadE.DepthFreeSurf,
+				       elev + payload.DepthFreeSurf,
+				       tolerance);
+	} // if
+      } // for
+  CPPUNIT_ASSERT(numLeaves > 0);
+
+  CPPUNIT_ASSERT(0 == etree_close(dbIn));
+  CPPUNIT_ASSERT(0 == etree_close(dbOut));
+} // _checkCompact
+
+// End of file
@@ -0,0 +1,128 @@
+// -*- C++ -*-
+//
+// ----------------------------------------------------------------------
+//
+//                           Brad T. Aagaard
+//                        U.S. Geological Survey
+//
+// {LicenseText}
+//
+// ----------------------------------------------------------------------
+//
+
+/** @file tests/TestCompactor.h
+ *
+ * @brief C++ TestCompactor object
+ *
+ * C++ unit testing for Compactor.
+ */
+
+#if !defined(cencalvm_create_testcompactor_h)
+#define cencalvm_create_testcompactor_h
+
+#include <cppunit/extensions/HelperMacros.h>
+
+namespace cencalvm {
+  namespace create {
+    class TestCompactor;
+  } // create
+} // cencalvm
+
+/// C++ unit testing for Compactor
+class cencalvm::create::TestCompactor : public CppUnit::TestFixture
+{ // class TestCompactor
+
+  // CPPUNIT TEST SUITE /////////////////////////////////////////////////
+  CPPUNIT_TEST_SUITE( TestCompactor );
+  CPPUNIT_TEST( testConstructor );
+  CPPUNIT_TEST( testCompact );
+  CPPUNIT_TEST( testCompactLeaves );
+  CPPUNIT_TEST( testCompactNested );
+  CPPUNIT_TEST( testCompactDepth );
+  CPPUNIT_TEST( testCompactSurface );
+  CPPUNIT_TEST( testCompactQuantized );
+  CPPUNIT_TEST( testPatch );
+  CPPUNIT_TEST_SUITE_END();
+
+  // PUBLIC METHODS /////////////////////////////////////////////////////
+public :
+
+  /// Test constructor
+  void testConstructor(void);
+
+  /// Test compact() with averaged database
+  void testCompact(void);
+
+  /// Test compact() with database of leaf octants
+  void testCompactLeaves(void);
+
+  /// Test compact() with homogeneous subtrees nested in larger one
+  void testCompactNested(void);
+
+  /// Test compact() with depths of free surface inconsistent with
+  /// a common free surface
+  void testCompactDepth(void);
+
+  /// Test compact() with free surface above leaves
+  void testCompactSurface(void);
+
+  /// Test compact() with database of compact payloads
+  void testCompactQuantized(void);
+
+  /// Test that patching compacted database fails
+  void testPatch(void);
+
+  // PRIVATE METHODS ////////////////////////////////////////////////////
+private :
+
+  /** Create database with leaf octants at level _LEVEL and averaged
+   * database.
+   *
+   * If not uniform, payloads are uniform within each octant at level
+   * _LEVEL-1 except one octant with a leaf with a different payload
+   * and one octant with a missing leaf.
+   *
+   * If depths are consistent, the depth of the free surface of each
+   * leaf is relative to the centroid of the leaf, so leaves with
+   * uniform payloads share a free surface. Otherwise leaves with
+   * uniform payloads have the same depth of the free surface.
+   *
+   * @param isUniform True if all leaves have the same payload
+   * @param isDepthConsistent True if depths of free surface are
+   * relative to centroids of leaves
+   * @param isSurfaceInData True if free surface lies in top layer of
+   * leaves, false if it lies above leaves
+   */
+  void _createDB(const bool isUniform,
+		 const bool isDepthConsistent,
+		 const bool isSurfaceInData) const;
+
+  /** Compact database and check that searches at leaf octants of
+   * original database return identical payloads, except that depths
+   * of free surface of collapsed subtrees are relative to the
+   * centroid of their root octant.
+   *
+   * @param filenameDB Name of etree database to compact
+   * @param numOctantsE Expected number of octants in compacted database
+   * @param numCollapsedE Expected number of collapsed subtrees
+   */
+  void _checkCompact(const char* filenameDB,
+		     const int numOctantsE,
+		     const int numCollapsedE) const;
+
+  // PRIVATE MEMBERS ////////////////////////////////////////////////////
+private :
+
+  static const char* _DBFILENAMELEAVES; ///< Filename of leaf database
+  static const char* _DBFILENAMEAVG; ///< Filename of averaged database
+  static const char* _DBFILENAMEOUT; ///< Filename of compacted database
+  static const char* _DBFILENAMEPATCH; ///< Filename of patched database
+  static const char* _DBFILENAMEQUANTIZED; ///< Filename of quantized database
+  static const int _LEVEL; ///< Level of leaf octants
+  static const int _NUMPERDIM; ///< Number of leaf octants along each axis
+
+}; // class TestCompactor
+
+#endif // cencalvm_create_testcompactor
+
+// End of file
@@ -0,0 +1,215 @@
+// -*- C++ -*-
+//
+// ----------------------------------------------------------------------
+//
+//                           Brad T. Aagaard
+//                        U.S. Geological Survey
+//
+// {LicenseText}
+//
+// ----------------------------------------------------------------------
+//
+
+#include "TestCompressor.h" // Implementation of class methods
+
+#include "cencalvm/create/Compressor.h" // USES Compressor
+
+#include "cencalvm/average/Averager.h" // USES Averager
+#include "cencalvm/storage/CompressedDB.h" // USES CompressedDB
+#include "cencalvm/storage/Payload.h" // USES PayloadStruct
+
+extern "C" {
+#include "etree.h"
+}
+
+#include <stdlib.h> // USES free()
+#include <string.h> // USES strcmp(), strstr(), memcmp()
+
+// ----------------------------------------------------------------------
+CPPUNIT_TEST_SUITE_REGISTRATION( cencalvm::create::TestCompressor );
+
+// ----------------------------------------------------------------------
+const char* cencalvm::create::TestCompressor::_DBFILENAMELEAVES =
+  "data/compressleaves.etree";
+const char* cencalvm::create::TestCompressor::_DBFILENAMEAVG =
+  "data/compressavg.etree";
+const char* cencalvm::create::TestCompressor::_DBFILENAMEOUT =
+  "data/compressout.etree";
+const int cencalvm::create::TestCompressor::_LEVEL = 3;
+const int cencalvm::create::TestCompressor::_NUMPERDIM = 4;
+const int cencalvm::create::TestCompressor::_BLOCKSIZE = 7;
+
+// ----------------------------------------------------------------------
+// Test constructor
+void
+cencalvm::create::TestCompressor::testConstructor(void)
+{ // testConstructor
+  Compressor compressor;
+} // testConstructor
+
+// ----------------------------------------------------------------------
+// Test compress()
+void
+cencalvm::create::TestCompressor::testCompress(void)
+{ // testCompress
+  _createDB();
+
+  etree_t* dbIn = etree_open(_DBFILENAMEAVG, O_RDONLY, 0, 0, 0);
+  CPPUNIT_ASSERT(0 != dbIn);
+  CPPUNIT_ASSERT(storage::CompressedDB::isCompressed(_DBFILENAMEOUT));
+  storage::CompressedDB dbOut;
+  dbOut.open(_DBFILENAMEOUT, 1);
+
+  CPPUNIT_ASSERT_EQUAL(etree_getpayloadsize(dbIn), dbOut.payloadSize());
+  char* schema = etree_getschema(dbIn);
+  CPPUNIT_ASSERT(0 == strcmp(schema, dbOut.schema()));
+  free(schema);
+  char* appmeta = etree_getappmeta(dbIn);
+  if (0 != appmeta)
+    CPPUNIT_ASSERT(0 != strstr(dbOut.appmeta(), appmeta));
+  free(appmeta);
+  CPPUNIT_ASSERT(0 != strstr(dbOut.appmeta(), "compressed from"));
+
+  // Every octant must be found with identical payload.
+  etree_addr_t cursor;
+  cursor.x = 0;
+  cursor.y = 0;
+  cursor.z = 0;
+  cursor.t = 0;
+  cursor.level = ETREE_MAXLEVEL;
+  CPPUNIT_ASSERT(0 == etree_initcursor(dbIn, cursor));
+  int numOctants = 0;
+  bool more = true;
+  while (more) {
+    etree_addr_t addrE;
+    storage::PayloadStruct payloadE;
+    CPPUNIT_ASSERT(0 == etree_getcursor(dbIn, &addrE, "*", &payloadE));
+
+    etree_addr_t addr;
+    storage::PayloadStruct payload;
+    CPPUNIT_ASSERT(0 == dbOut.search(&addr, &payload, addrE));
+    CPPUNIT_ASSERT_EQUAL(addrE.x, addr.x);
+    CPPUNIT_ASSERT_EQUAL(addrE.y, addr.y);
+    CPPUNIT_ASSERT_EQUAL(addrE.z, addr.z);
+    CPPUNIT_ASSERT_EQUAL(addrE.level, addr.level);
+    CPPUNIT_ASSERT_EQUAL(int(addrE.type), int(addr.type));
+    CPPUNIT_ASSERT(0 == memcmp(&payloadE, &payload, sizeof(payload)));
+
+    ++numOctants;
+    more = (0 == etree_advcursor(dbIn));
+  } // while
+  CPPUNIT_ASSERT_EQUAL(int(etree_gettotalcount(dbIn)), numOctants);
+
+  CPPUNIT_ASSERT(0 == etree_close(dbIn));
+} // testCompress
+
+// ----------------------------------------------------------------------
+// Test searching compressed database for points
+void
+cencalvm::create::TestCompressor::testSearch(void)
+{ // testSearch
+  _createDB();
+
+  etree_t* dbIn = etree_open(_DBFILENAMEAVG, O_RDONLY, 0, 0, 0);
+  CPPUNIT_ASSERT(0 != dbIn);
+  storage::CompressedDB dbOut;
+  dbOut.open(_DBFILENAMEOUT, 0);
+
+  // Points at octant centers and corners at finer levels must find
+  // the same octant as etree_search().
+  const int numPts = 2*_NUMPERDIM + 1;
+  const etree_tick_t dx = (0x80000000 >> _LEVEL) / 2;
+  for (int iZ=0; iZ < numPts; ++iZ)
+    for (int iY=0; iY < numPts; ++iY)
+      for (int iX=0; iX < numPts; ++iX)
+	for (int level=_LEVEL-1; level <= ETREE_MAXLEVEL; level += 2) {
+	  etree_addr_t addr;
+	  addr.x = iX*dx + 3*iZ;
+	  addr.y = iY*dx + 5*iX;
+	  addr.z = iZ*dx + 7*iY;
+	  addr.t = 0;
+	  addr.level = level;
+	  addr.type = ETREE_LEAF;
+	  const etree_tick_t mask = ~((((etree_tick_t) 0x80000000) >> level) - 1);
+	  addr.x &= mask;
+	  addr.y &= mask;
+	  addr.z &= mask;
+
+	  etree_addr_t resAddrE;
+	  storage::PayloadStruct payloadE;
+	  const int errE = etree_search(dbIn, addr, &resAddrE, "*", &payloadE);
+	  etree_addr_t resAddr;
+	  storage::PayloadStruct payload;
+	  const int err = dbOut.search(&resAddr, &payload, addr);
+	  CPPUNIT_ASSERT_EQUAL(0 == errE, 0 == err);
+	  if (0 == errE) {
+	    CPPUNIT_ASSERT_EQUAL(resAddrE.x, resAddr.x);
+	    CPPUNIT_ASSERT_EQUAL(resAddrE.y, resAddr.y);
+	    CPPUNIT_ASSERT_EQUAL(resAddrE.z, resAddr.z);
+	    CPPUNIT_ASSERT_EQUAL(resAddrE.level, resAddr.level);
+	    CPPUNIT_ASSERT(0 == memcmp(&payloadE, &payload, sizeof(payload)));
+	  } // if
+	} // for
+
+  CPPUNIT_ASSERT(0 == etree_close(dbIn));
+} // testSearch
+
+// ----------------------------------------------------------------------
+// Create averaged etree database and compress it.
+void
+cencalvm::create::TestCompressor::_createDB(void) const
+{ // _createDB
+  etree_t* db = etree_open(_DBFILENAMELEAVES, O_CREAT|O_RDWR|O_TRUNC,
+			   0, 0, 3);
+  CPPUNIT_ASSERT(0 != db);
+  int err = etree_registerschema(db, storage::Payload::SCHEMA);
+  CPPUNIT_ASSERT(0 == err);
+
+  const etree_tick_t tickLen = 0x80000000 >> _LEVEL;
+  for (int iZ=0; iZ < _NUMPERDIM; ++iZ)
+    for (int iY=0; iY < _NUMPERDIM; ++iY)
+      for (int iX=0; iX < _NUMPERDIM; ++iX) {
+	// Leave corner of domain empty.
+	if (iX == _NUMPERDIM-1 && iY == _NUMPERDIM-1)
+	  continue;
+
+	etree_addr_t addr;
+	addr.x = iX*tickLen;
+	addr.y = iY*tickLen;
+	addr.z = iZ*tickLen;
+	addr.t = 0;
+	addr.level = _LEVEL;
+	addr.type = ETREE_LEAF;
+
+	const double val = 1.0 + iX + _NUMPERDIM*(iY + _NUMPERDIM*iZ);
+	storage::PayloadStruct payload;
+	payload.Vp = 2000.0 + 10.3*val;
+	payload.Vs = 1000.0 + 10.7*val;
+	payload.Density = 2000.0 + 1.13*val;
+	payload.Qp = 100.0 + 0.37*val;
+	payload.Qs = 50.0 + 0.19*val;
+	payload.DepthFreeSurf = 100.3*val;
+	payload.FaultBlock = 1 + iX;
+	payload.Zone = 1 + iY;
+
+	err = etree_insert(db, addr, &payload);
+	CPPUNIT_ASSERT(0 == err);
+      } // for
+  err = etree_close(db);
+  CPPUNIT_ASSERT(0 == err);
+
+  average::Averager averager;
+  averager.filenameIn(_DBFILENAMELEAVES);
+  averager.filenameOut(_DBFILENAMEAVG);
+  averager.quiet(true);
+  averager.average();
+
+  Compressor compressor;
+  compressor.filenameIn(_DBFILENAMEAVG);
+  compressor.filenameOut(_DBFILENAMEOUT);
+  compressor.blockSize(_BLOCKSIZE);
+  compressor.quiet(true);
+  compressor.compress();
+} // _createDB
+
+// End of file
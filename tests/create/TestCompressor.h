@@ -0,0 +1,74 @@
+// -*- C++ -*-
+//
+// ----------------------------------------------------------------------
+//
+//                           Brad T. Aagaard
+//                        U.S. Geological Survey
+//
+// {LicenseText}
+//
+// ----------------------------------------------------------------------
+//
+
+/** @file tests/TestCompressor.h
+ *
+ * @brief C++ TestCompressor object
+ *
+ * C++ unit testing for Compressor.
+ */
+
+#if !defined(cencalvm_create_testcompressor_h)
+#define cencalvm_create_testcompressor_h
+
+#include <cppunit/extensions/HelperMacros.h>
+
+namespace cencalvm {
+  namespace create {
+    class TestCompressor;
+  } // create
+} // cencalvm
+
+/// C++ unit testing for Compressor
+class cencalvm::create::TestCompressor : public CppUnit::TestFixture
+{ // class TestCompressor
+
+  // CPPUNIT TEST SUITE /////////////////////////////////////////////////
+  CPPUNIT_TEST_SUITE( TestCompressor );
+  CPPUNIT_TEST( testConstructor );
+  CPPUNIT_TEST( testCompress );
+  CPPUNIT_TEST( testSearch );
+  CPPUNIT_TEST_SUITE_END();
+
+  // PUBLIC METHODS /////////////////////////////////////////////////////
+public :
+
+  /// Test constructor
+  void testConstructor(void);
+
+  /// Test compress()
+  void testCompress(void);
+
+  /// Test searching compressed database for points
+  void testSearch(void);
+
+  // PRIVATE METHODS ////////////////////////////////////////////////////
+private :
+
+  /// Create averaged etree database and compress it.
+  void _createDB(void) const;
+
+  // PRIVATE MEMBERS ////////////////////////////////////////////////////
+private :
+
+  static const char* _DBFILENAMELEAVES; ///< Filename of leaf database
+  static const char* _DBFILENAMEAVG; ///< Filename of averaged database
+  static const char* _DBFILENAMEOUT; ///< Filename of compressed database
+  static const int _LEVEL; ///< Level of leaf octants
+  static const int _NUMPERDIM; ///< Number of leaf octants along each axis
+  static const int _BLOCKSIZE; ///< Number of octants in each block
+
+}; // class TestCompressor
+
+#endif // cencalvm_create_testcompressor
+
+// End of file
@@ -0,0 +1,227 @@
+// -*- C++ -*-
+//
+// ----------------------------------------------------------------------
+//
+//                           Brad T. Aagaard
+//                        U.S. Geological Survey
+//
+// {LicenseText}
+//
+// ----------------------------------------------------------------------
+//
+
+#include "TestDictionaryEncoder.h" // Implementation of class methods
+
+#include "cencalvm/create/DictionaryEncoder.h" // USES DictionaryEncoder
+#include "cencalvm/create/Quantizer.h" // USES Quantizer
+
+#include "cencalvm/average/Averager.h" // USES Averager
+#include "cencalvm/storage/Payload.h" // USES PayloadStruct
+#include "cencalvm/storage/PayloadCodec.h" // USES PayloadCodec
+#include "cencalvm/storage/PayloadDictionary.h" // USES PayloadDictionary
+
+extern "C" {
+#include "etree.h"
+}
+
+#include <stdlib.h> // USES free()
+#include <string.h> // USES strcmp(), strstr(), memcmp()
+#include <vector> // USES std::vector
+
+// ----------------------------------------------------------------------
+CPPUNIT_TEST_SUITE_REGISTRATION( cencalvm::create::TestDictionaryEncoder );
+
+// ----------------------------------------------------------------------
+const char* cencalvm::create::TestDictionaryEncoder::_DBFILENAMELEAVES =
+  "data/dictionaryleaves.etree";
+const char* cencalvm::create::TestDictionaryEncoder::_DBFILENAMEAVG =
+  "data/dictionaryavg.etree";
+const char* cencalvm::create::TestDictionaryEncoder::_DBFILENAMECOMPACT =
+  "data/dictionarycompact.etree";
+const char* cencalvm::create::TestDictionaryEncoder::_DBFILENAMEOUT =
+  "data/dictionaryout.etree";
+const int cencalvm::create::TestDictionaryEncoder::_LEVEL = 3;
+const int cencalvm::create::TestDictionaryEncoder::_NUMPERDIM = 4;
+
+// ----------------------------------------------------------------------
+// Test constructor
+void
+cencalvm::create::TestDictionaryEncoder::testConstructor(void)
+{ // testConstructor
+  DictionaryEncoder encoder;
+} // testConstructor
+
+// ----------------------------------------------------------------------
+// Test encode()
+void
+cencalvm::create::TestDictionaryEncoder::testEncode(void)
+{ // testEncode
+  _createDB();
+  _checkEncode(_DBFILENAMEAVG);
+} // testEncode
+
+// ----------------------------------------------------------------------
+// Test encode() with compact input database
+void
+cencalvm::create::TestDictionaryEncoder::testEncodeCompact(void)
+{ // testEncodeCompact
+  _createDB();
+
+  Quantizer quantizer;
+  quantizer.filenameIn(_DBFILENAMEAVG);
+  quantizer.filenameOut(_DBFILENAMECOMPACT);
+  quantizer.quiet(true);
+  quantizer.quantize();
+
+  _checkEncode(_DBFILENAMECOMPACT);
+} // testEncodeCompact
+
+// ----------------------------------------------------------------------
+// Create averaged etree database with repeated leaf payloads.
+void
+cencalvm::create::TestDictionaryEncoder::_createDB(void) const
+{ // _createDB
+  etree_t* db = etree_open(_DBFILENAMELEAVES, O_CREAT|O_RDWR|O_TRUNC,
+			   0, 0, 3);
+  CPPUNIT_ASSERT(0 != db);
+  int err = etree_registerschema(db, storage::Payload::SCHEMA);
+  CPPUNIT_ASSERT(0 == err);
+
+  const etree_tick_t tickLen = 0x80000000 >> _LEVEL;
+  for (int iZ=0; iZ < _NUMPERDIM; ++iZ)
+    for (int iY=0; iY < _NUMPERDIM; ++iY)
+      for (int iX=0; iX < _NUMPERDIM; ++iX) {
+	etree_addr_t addr;
+	addr.x = iX*tickLen;
+	addr.y = iY*tickLen;
+	addr.z = iZ*tickLen;
+	addr.t = 0;
+	addr.level = _LEVEL;
+	addr.type = ETREE_LEAF;
+
+	// Payload depends only on depth and parity of x, so leaves
+	// share payloads.
+	const double val = 1.0 + iX % 2 + 2*iZ;
+	storage::PayloadStruct payload;
+	payload.Vp = 2000.0 + 10.3*val;
+	payload.Vs = 1000.0 + 10.7*val;
+	payload.Density = 2000.0 + 1.13*val;
+	payload.Qp = 100.0 + 0.37*val;
+	payload.Qs = 50.0 + 0.19*val;
+	payload.DepthFreeSurf = 100.3*val;
+	payload.FaultBlock = 1 + iX % 2;
+	payload.Zone = 1 + iZ;
+
+	err = etree_insert(db, addr, &payload);
+	CPPUNIT_ASSERT(0 == err);
+      } // for
+  err = etree_close(db);
+  CPPUNIT_ASSERT(0 == err);
+
+  average::Averager averager;
+  averager.filenameIn(_DBFILENAMELEAVES);
+  averager.filenameOut(_DBFILENAMEAVG);
+  averager.quiet(true);
+  averager.average();
+} // _createDB
+
+// ----------------------------------------------------------------------
+// Encode database and check every octant.
+void
+cencalvm::create::TestDictionaryEncoder::_checkEncode(const char* filenameDB) const
+{ // _checkEncode
+  DictionaryEncoder encoder;
+  encoder.filenameIn(filenameDB);
+  encoder.filenameOut(_DBFILENAMEOUT);
+  encoder.quiet(true);
+  encoder.encode();
+
+  storage::PayloadDictionary dictionary;
+  dictionary.read(storage::PayloadDictionary::filename(_DBFILENAMEOUT).c_str());
+
+  etree_t* dbIn = etree_open(filenameDB, O_RDONLY, 0, 0, 0);
+  CPPUNIT_ASSERT(0 != dbIn);
+  storage::PayloadCodec* pCodec = 0;
+  char* schema = etree_getschema(dbIn);
+  if (0 == strcmp(storage::Payload::SCHEMACOMPACT, schema)) {
+    char* appmeta = etree_getappmeta(dbIn);
+    pCodec = new storage::PayloadCodec;
+    pCodec->parseMetadata(appmeta);
+    free(appmeta);
+  } // if
+  free(schema);
+
+  etree_t* dbOut = etree_open(_DBFILENAMEOUT, O_RDONLY, 0, 0, 0);
+  CPPUNIT_ASSERT(0 != dbOut);
+  schema = etree_getschema(dbOut);
+  CPPUNIT_ASSERT(0 == strcmp(storage::Payload::SCHEMAINDEX, schema));
+  free(schema);
+  char* appmeta = etree_getappmeta(dbOut);
+  CPPUNIT_ASSERT(0 != appmeta);
+  const std::string metadataE = storage::PayloadDictionary::metadata(
+	   storage::PayloadDictionary::filename(_DBFILENAMEOUT).c_str());
+  CPPUNIT_ASSERT(0 != strstr(appmeta, metadataE.c_str()));
+  free(appmeta);
+  CPPUNIT_ASSERT_EQUAL(int(sizeof(storage::PayloadIndexStruct)),
+		       etree_getpayloadsize(dbOut));
+
+  // Both databases have the same octants and each payload appears
+  // once in the dictionary.
+  etree_addr_t addrIn;
+  addrIn.x = 0;
+  addrIn.y = 0;
+  addrIn.z = 0;
+  addrIn.t = 0;
+  addrIn.level = ETREE_MAXLEVEL;
+  etree_addr_t addrOut = addrIn;
+  std::vector<bool> isUsed(dictionary.size(), false);
+  int numOctants = 0;
+  bool more = (0 == etree_initcursor(dbIn, addrIn));
+  CPPUNIT_ASSERT(0 == etree_initcursor(dbOut, addrOut));
+  while (more) {
+    storage::PayloadStruct payloadE;
+    CPPUNIT_ASSERT(0 == etree_getcursor(dbIn, &addrIn, "*", &payloadE));
+    if (0 != pCodec) {
+      const storage::PayloadCompactStruct compact =
+	*(storage::PayloadCompactStruct*) &payloadE;
+      pCodec->decode(&payloadE, compact);
+    } // if
+
+    storage::PayloadIndexStruct index;
+    CPPUNIT_ASSERT(0 == etree_getcursor(dbOut, &addrOut, "*", &index));
+    CPPUNIT_ASSERT_EQUAL(addrIn.x, addrOut.x);
+    CPPUNIT_ASSERT_EQUAL(addrIn.y, addrOut.y);
+    CPPUNIT_ASSERT_EQUAL(addrIn.z, addrOut.z);
+    CPPUNIT_ASSERT_EQUAL(addrIn.level, addrOut.level);
+    CPPUNIT_ASSERT_EQUAL(addrIn.type, addrOut.type);
+
+    storage::PayloadStruct payload;
+    CPPUNIT_ASSERT(0 == dictionary.lookup(&payload, index.Index));
+    CPPUNIT_ASSERT(0 == memcmp(&payloadE, &payload, sizeof(payload)));
+    isUsed[index.Index] = true;
+    ++numOctants;
+
+    more = (0 == etree_advcursor(dbIn));
+    CPPUNIT_ASSERT_EQUAL(more, 0 == etree_advcursor(dbOut));
+  } // while
+
+  // Dictionary is smaller than database and holds only payloads of
+  // octants.
+  CPPUNIT_ASSERT(int(dictionary.size()) < numOctants);
+  for (uint32_t i=0; i < dictionary.size(); ++i) {
+    CPPUNIT_ASSERT(isUsed[i]);
+    storage::PayloadStruct payloadI;
+    dictionary.lookup(&payloadI, i);
+    for (uint32_t j=0; j < i; ++j) {
+      storage::PayloadStruct payloadJ;
+      dictionary.lookup(&payloadJ, j);
+      CPPUNIT_ASSERT(0 != memcmp(&payloadI, &payloadJ, sizeof(payloadI)));
+    } // for
+  } // for
+
+  delete pCodec; pCodec = 0;
+  CPPUNIT_ASSERT(0 == etree_close(dbIn));
+  CPPUNIT_ASSERT(0 == etree_close(dbOut));
+} // _checkEncode
+
+// End of file
@@ -0,0 +1,81 @@
+// -*- C++ -*-
+//
+// ----------------------------------------------------------------------
+//
+//                           Brad T. Aagaard
+//                        U.S. Geological Survey
+//
+// {LicenseText}
+//
+// ----------------------------------------------------------------------
+//
+
+/** @file tests/TestDictionaryEncoder.h
+ *
+ * @brief C++ TestDictionaryEncoder object
+ *
+ * C++ unit testing for DictionaryEncoder.
+ */
+
+#if !defined(cencalvm_create_testdictionaryencoder_h)
+#define cencalvm_create_testdictionaryencoder_h
+
+#include <cppunit/extensions/HelperMacros.h>
+
+namespace cencalvm {
+  namespace create {
+    class TestDictionaryEncoder;
+  } // create
+} // cencalvm
+
+/// C++ unit testing for DictionaryEncoder
+class cencalvm::create::TestDictionaryEncoder : public CppUnit::TestFixture
+{ // class TestDictionaryEncoder
+
+  // CPPUNIT TEST SUITE /////////////////////////////////////////////////
+  CPPUNIT_TEST_SUITE( TestDictionaryEncoder );
+  CPPUNIT_TEST( testConstructor );
+  CPPUNIT_TEST( testEncode );
+  CPPUNIT_TEST( testEncodeCompact );
+  CPPUNIT_TEST_SUITE_END();
+
+  // PUBLIC METHODS /////////////////////////////////////////////////////
+public :
+
+  /// Test constructor
+  void testConstructor(void);
+
+  /// Test encode()
+  void testEncode(void);
+
+  /// Test encode() with compact input database
+  void testEncodeCompact(void);
+
+  // PRIVATE METHODS ////////////////////////////////////////////////////
+private :
+
+  /// Create averaged etree database with repeated leaf payloads.
+  void _createDB(void) const;
+
+  /** Encode database and check that every octant holds the index of
+   * its payload in the dictionary.
+   *
+   * @param filenameDB Name of etree database
+   */
+  void _checkEncode(const char* filenameDB) const;
+
+  // PRIVATE MEMBERS ////////////////////////////////////////////////////
+private :
+
+  static const char* _DBFILENAMELEAVES; ///< Filename of leaf database
+  static const char* _DBFILENAMEAVG; ///< Filename of averaged database
+  static const char* _DBFILENAMECOMPACT; ///< Filename of compact database
+  static const char* _DBFILENAMEOUT; ///< Filename of encoded database
+  static const int _LEVEL; ///< Level of leaf octants
+  static const int _NUMPERDIM; ///< Number of leaf octants along each axis
+
+}; // class TestDictionaryEncoder
+
+#endif // cencalvm_create_testdictionaryencoder
+
+// End of file
@@ -0,0 +1,365 @@
+// -*- C++ -*-
+//
+// ----------------------------------------------------------------------
+//
+//                           Brad T. Aagaard
+//                        U.S. Geological Survey
+//
+// {LicenseText}
+//
+// ----------------------------------------------------------------------
+//
+
+#include "TestExtractor.h" // Implementation of class methods
+
+#include "cencalvm/create/Extractor.h" // USES Extractor
+
+#include "cencalvm/average/Averager.h" // USES Averager
+#include "cencalvm/storage/Payload.h" // USES PayloadStruct
+#include "cencalvm/storage/Geometry.h" // USES Geometry
+#include "cencalvm/storage/GeomCenCA.h" // USES GeomCenCA
+
+extern "C" {
+#include "etree.h"
+}
+
+#include <stdexcept> // USES std::runtime_error
+
+// ----------------------------------------------------------------------
+CPPUNIT_TEST_SUITE_REGISTRATION( cencalvm::create::TestExtractor );
+
+// ----------------------------------------------------------------------
+const char* cencalvm::create::TestExtractor::_DBFILENAMELEAVES = 
+  "data/extractleaves.etree";
+const char* cencalvm::create::TestExtractor::_DBFILENAMEAVG = 
+  "data/extractavg.etree";
+const char* cencalvm::create::TestExtractor::_DBFILENAMEOUT = 
+  "data/extractout.etree";
+const int cencalvm::create::TestExtractor::_LEVEL = 3;
+const int cencalvm::create::TestExtractor::_NUMPERDIM = 4;
+
+// ----------------------------------------------------------------------
+// Test constructor
+void
+cencalvm::create::TestExtractor::testConstructor(void)
+{ // testConstructor
+  Extractor extractor;
+} // testConstructor
+
+// ----------------------------------------------------------------------
+// Test _nextSubtree()
+void
+cencalvm::create::TestExtractor::testNextSubtree(void)
+{ // testNextSubtree
+  const etree_tick_t tickLen = 0x80000000 >> 2;
+
+  // Next sibling at same level
+  etree_addr_t addr;
+  addr.x = 0;
+  addr.y = tickLen;
+  addr.z = 0;
+  addr.t = 0;
+  addr.level = 2;
+  etree_addr_t nextAddr;
+  CPPUNIT_ASSERT(Extractor::_nextSubtree(&nextAddr, addr));
+  CPPUNIT_ASSERT_EQUAL(tickLen, nextAddr.x);
+  CPPUNIT_ASSERT_EQUAL(tickLen, nextAddr.y);
+  CPPUNIT_ASSERT_EQUAL(etree_tick_t(0), nextAddr.z);
+  CPPUNIT_ASSERT_EQUAL(2, nextAddr.level);
+  CPPUNIT_ASSERT(!storage::Geometry::precedes(nextAddr, addr));
+
+  // Last child, so next octant is sibling of parent
+  addr.x = tickLen;
+  addr.y = tickLen;
+  addr.z = tickLen;
+  CPPUNIT_ASSERT(Extractor::_nextSubtree(&nextAddr, addr));
+  CPPUNIT_ASSERT_EQUAL(2*tickLen, nextAddr.x);
+  CPPUNIT_ASSERT_EQUAL(etree_tick_t(0), nextAddr.y);
+  CPPUNIT_ASSERT_EQUAL(etree_tick_t(0), nextAddr.z);
+  CPPUNIT_ASSERT_EQUAL(1, nextAddr.level);
+
+  // Last octant in tree
+  addr.x = 3*tickLen;
+  addr.y = 3*tickLen;
+  addr.z = 3*tickLen;
+  CPPUNIT_ASSERT(!Extractor::_nextSubtree(&nextAddr, addr));
+
+  // Root
+  addr.x = 0;
+  addr.y = 0;
+  addr.z = 0;
+  addr.level = 0;
+  CPPUNIT_ASSERT(!Extractor::_nextSubtree(&nextAddr, addr));
+} // testNextSubtree
+
+// ----------------------------------------------------------------------
+// Test extract()
+void
+cencalvm::create::TestExtractor::testExtract(void)
+{ // testExtract
+  _createDBs();
+
+  Extractor extractor;
+  extractor.filenameIn(_DBFILENAMEAVG);
+  extractor.filenameOut(_DBFILENAMEOUT);
+  double bounds[6];
+  _setRegion(&extractor, bounds);
+  extractor.quiet(true);
+  extractor.extract();
+
+  _checkQueries(bounds, -1);
+
+  etree_t* dbIn = etree_open(_DBFILENAMEAVG, O_RDONLY, 0, 0, 0);
+  CPPUNIT_ASSERT(0 != dbIn);
+  etree_t* dbOut = etree_open(_DBFILENAMEOUT, O_RDONLY, 0, 0, 0);
+  CPPUNIT_ASSERT(0 != dbOut);
+  CPPUNIT_ASSERT(etree_gettotalcount(dbOut) < etree_gettotalcount(dbIn));
+
+  // Octants at corners of the model are outside the region.
+  const etree_tick_t tickLen = 0x80000000 >> _LEVEL;
+  etree_addr_t addr;
+  addr.level = _LEVEL;
+  addr.type = ETREE_INTERIOR;
+  addr.t = 0;
+  addr.x = 0;
+  addr.y = 0;
+  addr.z = 0;
+  etree_addr_t resAddr;
+  storage::PayloadStruct payload;
+  CPPUNIT_ASSERT(0 == etree_search(dbIn, addr, &resAddr, "*", &payload));
+  CPPUNIT_ASSERT(0 != etree_search(dbOut, addr, &resAddr, "*", &payload));
+  addr.x = (_NUMPERDIM-1)*tickLen;
+  addr.y = (_NUMPERDIM-1)*tickLen;
+  addr.z = (_NUMPERDIM-1)*tickLen;
+  CPPUNIT_ASSERT(0 == etree_search(dbIn, addr, &resAddr, "*", &payload));
+  CPPUNIT_ASSERT(0 != etree_search(dbOut, addr, &resAddr, "*", &payload));
+
+  CPPUNIT_ASSERT(0 == etree_close(dbOut));
+  CPPUNIT_ASSERT(0 == etree_close(dbIn));
+} // testExtract
+
+// ----------------------------------------------------------------------
+// Test extract() with maximum level
+void
+cencalvm::create::TestExtractor::testExtractMaxLevel(void)
+{ // testExtractMaxLevel
+  _createDBs();
+
+  const int maxLevel = _LEVEL - 1;
+  Extractor extractor;
+  extractor.filenameIn(_DBFILENAMEAVG);
+  extractor.filenameOut(_DBFILENAMEOUT);
+  double bounds[6];
+  _setRegion(&extractor, bounds);
+  extractor.maxLevel(maxLevel);
+  extractor.quiet(true);
+  extractor.extract();
+
+  _checkQueries(bounds, maxLevel);
+
+  etree_t* db = etree_open(_DBFILENAMEOUT, O_RDONLY, 0, 0, 0);
+  CPPUNIT_ASSERT(0 != db);
+  for (int level=maxLevel+1; level <= _LEVEL; ++level) {
+    CPPUNIT_ASSERT_EQUAL(uint64_t(0), etree_getcount(db, level, ETREE_LEAF));
+    CPPUNIT_ASSERT_EQUAL(uint64_t(0), 
+			 etree_getcount(db, level, ETREE_INTERIOR));
+  } // for
+  CPPUNIT_ASSERT(etree_getcount(db, maxLevel, ETREE_LEAF) > 0);
+  CPPUNIT_ASSERT_EQUAL(uint64_t(0), 
+		       etree_getcount(db, maxLevel, ETREE_INTERIOR));
+  CPPUNIT_ASSERT(0 == etree_close(db));
+} // testExtractMaxLevel
+
+// ----------------------------------------------------------------------
+// Test extract() with maximum level and database not averaged
+void
+cencalvm::create::TestExtractor::testExtractUnaveraged(void)
+{ // testExtractUnaveraged
+  _createDBs();
+
+  Extractor extractor;
+  extractor.filenameIn(_DBFILENAMELEAVES);
+  extractor.filenameOut(_DBFILENAMEOUT);
+  double bounds[6];
+  _setRegion(&extractor, bounds);
+  extractor.maxLevel(_LEVEL-1);
+  extractor.quiet(true);
+  CPPUNIT_ASSERT_THROW(extractor.extract(), std::runtime_error);
+
+  // Without a maximum level, leaf database can be extracted.
+  extractor.maxLevel(-1);
+  extractor.extract();
+  _checkQueries(bounds, -1);
+} // testExtractUnaveraged
+
+// ----------------------------------------------------------------------
+// Test extract() with region outside domain
+void
+cencalvm::create::TestExtractor::testExtractOutside(void)
+{ // testExtractOutside
+  _createDBs();
+
+  storage::GeomCenCA geometry;
+  Extractor extractor;
+  extractor.filenameIn(_DBFILENAMEAVG);
+  extractor.filenameOut(_DBFILENAMEOUT);
+  extractor.geometry(&geometry);
+  extractor.region(0.0, 1.0, 0.0, 1.0, 0.0, 1.0);
+  extractor.quiet(true);
+  CPPUNIT_ASSERT_THROW(extractor.extract(), std::runtime_error);
+
+  // Minimum larger than maximum
+  extractor.region(-121.0, -122.0, 37.0, 38.0, -1000.0, 0.0);
+  CPPUNIT_ASSERT_THROW(extractor.extract(), std::runtime_error);
+} // testExtractOutside
+
+// ----------------------------------------------------------------------
+// Create leaf and averaged etree databases.
+void
+cencalvm::create::TestExtractor::_createDBs(void) const
+{ // _createDBs
+  etree_t* db = etree_open(_DBFILENAMELEAVES, O_CREAT|O_RDWR|O_TRUNC, 
+			   0, 0, 3);
+  CPPUNIT_ASSERT(0 != db);
+  int err = etree_registerschema(db, storage::Payload::SCHEMA);
+  CPPUNIT_ASSERT(0 == err);
+
+  const etree_tick_t tickLen = 0x80000000 >> _LEVEL;
+  for (int iZ=0; iZ < _NUMPERDIM; ++iZ)
+    for (int iY=0; iY < _NUMPERDIM; ++iY)
+      for (int iX=0; iX < _NUMPERDIM; ++iX) {
+	etree_addr_t addr;
+	addr.x = iX*tickLen;
+	addr.y = iY*tickLen;
+	addr.z = iZ*tickLen;
+	addr.t = 0;
+	addr.level = _LEVEL;
+	addr.type = ETREE_LEAF;
+
+	const double val = 1.0 + iX + _NUMPERDIM*(iY + _NUMPERDIM*iZ);
+	storage::PayloadStruct payload;
+	payload.Vp = 2000.0 + 10.0*val;
+	payload.Vs = 1000.0 + 10.0*val;
+	payload.Density = 2000.0 + val;
+	payload.Qp = 100.0 + val;
+	payload.Qs = 50.0 + val;
+	payload.DepthFreeSurf = 100.0*val;
+	payload.FaultBlock = 1 + iX;
+	payload.Zone = 1 + iY;
+	
+	err = etree_insert(db, addr, &payload);
+	CPPUNIT_ASSERT(0 == err);
+      } // for
+  err = etree_close(db);
+  CPPUNIT_ASSERT(0 == err);
+
+  average::Averager averager;
+  averager.filenameIn(_DBFILENAMELEAVES);
+  averager.filenameOut(_DBFILENAMEAVG);
+  averager.quiet(true);
+  averager.average();
+} // _createDBs
+
+// ----------------------------------------------------------------------
+// Set region of extractor to box between centroids of two octants.
+void
+cencalvm::create::TestExtractor::_setRegion(Extractor* pExtractor,
+					    double* pBounds) const
+{ // _setRegion
+  CPPUNIT_ASSERT(0 != pExtractor);
+  CPPUNIT_ASSERT(0 != pBounds);
+
+  storage::GeomCenCA geometry;
+  pExtractor->geometry(&geometry);
+
+  const etree_tick_t tickLen = 0x80000000 >> _LEVEL;
+  etree_addr_t addr;
+  addr.level = _LEVEL;
+  addr.x = 1*tickLen;
+  addr.y = 1*tickLen;
+  addr.z = 1*tickLen;
+  double lonA = 0;
+  double latA = 0;
+  double elevA = 0;
+  geometry.addrToLonLatElev(&lonA, &latA, &elevA, &addr);
+  addr.x = 2*tickLen;
+  addr.y = 2*tickLen;
+  addr.z = 2*tickLen;
+  double lonB = 0;
+  double latB = 0;
+  double elevB = 0;
+  geometry.addrToLonLatElev(&lonB, &latB, &elevB, &addr);
+
+  pBounds[0] = (lonA < lonB) ? lonA : lonB;
+  pBounds[1] = (lonA < lonB) ? lonB : lonA;
+  pBounds[2] = (latA < latB) ? latA : latB;
+  pBounds[3] = (latA < latB) ? latB : latA;
+  pBounds[4] = (elevA < elevB) ? elevA : elevB;
+  pBounds[5] = (elevA < elevB) ? elevB : elevA;
+  pExtractor->region(pBounds[0], pBounds[1], pBounds[2], pBounds[3],
+		     pBounds[4], pBounds[5]);
+} // _setRegion
+
+// ----------------------------------------------------------------------
+// Check that queries of extracted database match queries of original
+// database inside region.
+void
+cencalvm::create::TestExtractor::_checkQueries(const double* bounds,
+					       const int queryLevel) const
+{ // _checkQueries
+  CPPUNIT_ASSERT(0 != bounds);
+
+  etree_t* dbIn = etree_open(_DBFILENAMEAVG, O_RDONLY, 0, 0, 0);
+  CPPUNIT_ASSERT(0 != dbIn);
+  etree_t* dbOut = etree_open(_DBFILENAMEOUT, O_RDONLY, 0, 0, 0);
+  CPPUNIT_ASSERT(0 != dbOut);
+
+  storage::GeomCenCA geometry;
+  const int numSamples = 4;
+  for (int i=0; i <= numSamples; ++i)
+    for (int j=0; j <= numSamples; ++j)
+      for (int k=0; k <= numSamples; ++k) {
+	const double lon = bounds[0] + (bounds[1]-bounds[0])*i/numSamples;
+	const double lat = bounds[2] + (bounds[3]-bounds[2])*j/numSamples;
+	const double elev = bounds[4] + (bounds[5]-bounds[4])*k/numSamples;
+
+	etree_addr_t addr;
+	addr.level = (queryLevel >= 0) ? queryLevel : ETREE_MAXLEVEL;
+	addr.type = ETREE_LEAF;
+	int err = geometry.lonLatElevToAddr(&addr, lon, lat, elev);
+	CPPUNIT_ASSERT(0 == err);
+
+	etree_addr_t resAddrE;
+	storage::PayloadStruct payloadE;
+	err = etree_search(dbIn, addr, &resAddrE, "*", &payloadE);
+	CPPUNIT_ASSERT(0 == err);
+
+	// Extracted database is queried at maximum resolution.
+	addr.level = ETREE_MAXLEVEL;
+	err = geometry.lonLatElevToAddr(&addr, lon, lat, elev);
+	CPPUNIT_ASSERT(0 == err);
+	etree_addr_t resAddr;
+	storage::PayloadStruct payload;
+	err = etree_search(dbOut, addr, &resAddr, "*", &payload);
+	CPPUNIT_ASSERT(0 == err);
+
+	CPPUNIT_ASSERT_EQUAL(resAddrE.x, resAddr.x);
+	CPPUNIT_ASSERT_EQUAL(resAddrE.y, resAddr.y);
+	CPPUNIT_ASSERT_EQUAL(resAddrE.z, resAddr.z);
+	CPPUNIT_ASSERT_EQUAL(resAddrE.level, resAddr.level);
+	CPPUNIT_ASSERT_EQUAL(int(ETREE_LEAF), int(resAddr.type));
+	CPPUNIT_ASSERT_EQUAL(payloadE.Vp, payload.Vp);
+	CPPUNIT_ASSERT_EQUAL(payloadE.Vs, payload.Vs);
+	CPPUNIT_ASSERT_EQUAL(payloadE.Density, payload.Density);
+	CPPUNIT_ASSERT_EQUAL(payloadE.Qp, payload.Qp);
+	CPPUNIT_ASSERT_EQUAL(payloadE.Qs, payload.Qs);
+	CPPUNIT_ASSERT_EQUAL(payloadE.DepthFreeSurf, payload.DepthFreeSurf);
+	CPPUNIT_ASSERT_EQUAL(payloadE.FaultBlock, payload.FaultBlock);
+	CPPUNIT_ASSERT_EQUAL(payloadE.Zone, payload.Zone);
+      } // for
+
+  CPPUNIT_ASSERT(0 == etree_close(dbOut));
+  CPPUNIT_ASSERT(0 == etree_close(dbIn));
+} // _checkQueries
+
+// End of file 
@@ -0,0 +1,104 @@
+// -*- C++ -*-
+//
+// ----------------------------------------------------------------------
+//
+//                           Brad T. Aagaard
+//                        U.S. Geological Survey
+//
+// {LicenseText}
+//
+// ----------------------------------------------------------------------
+//
+
+/** @file tests/TestExtractor.h
+ *
+ * @brief C++ TestExtractor object
+ *
+ * C++ unit testing for Extractor.
+ */
+
+#if !defined(cencalvm_create_testextractor_h)
+#define cencalvm_create_testextractor_h
+
+#include <cppunit/extensions/HelperMacros.h>
+
+namespace cencalvm {
+  namespace create {
+    class TestExtractor;
+    class Extractor; // USES Extractor
+  } // create
+} // cencalvm
+
+/// C++ unit testing for Extractor
+class cencalvm::create::TestExtractor : public CppUnit::TestFixture
+{ // class TestExtractor
+
+  // CPPUNIT TEST SUITE /////////////////////////////////////////////////
+  CPPUNIT_TEST_SUITE( TestExtractor );
+  CPPUNIT_TEST( testConstructor );
+  CPPUNIT_TEST( testNextSubtree );
+  CPPUNIT_TEST( testExtract );
+  CPPUNIT_TEST( testExtractMaxLevel );
+  CPPUNIT_TEST( testExtractUnaveraged );
+  CPPUNIT_TEST( testExtractOutside );
+  CPPUNIT_TEST_SUITE_END();
+
+  // PUBLIC METHODS /////////////////////////////////////////////////////
+public :
+
+  /// Test constructor
+  void testConstructor(void);
+
+  /// Test _nextSubtree()
+  void testNextSubtree(void);
+
+  /// Test extract()
+  void testExtract(void);
+
+  /// Test extract() with maximum level
+  void testExtractMaxLevel(void);
+
+  /// Test extract() with maximum level and database not averaged
+  void testExtractUnaveraged(void);
+
+  /// Test extract() with region outside domain
+  void testExtractOutside(void);
+
+  // PRIVATE METHODS ////////////////////////////////////////////////////
+private :
+
+  /// Create leaf and averaged etree databases.
+  void _createDBs(void) const;
+
+  /** Set region of extractor to box between centroids of two octants.
+   *
+   * @param pExtractor Pointer to extractor
+   * @param pBounds Array of bounds (lonMin, lonMax, latMin, latMax,
+   *   elevMin, elevMax)
+   */
+  void _setRegion(Extractor* pExtractor,
+		  double* pBounds) const;
+
+  /** Check that queries of extracted database match queries of
+   * original database inside region.
+   *
+   * @param bounds Array of bounds of region
+   * @param queryLevel Level of octants queried (negative for leaves)
+   */
+  void _checkQueries(const double* bounds,
+		     const int queryLevel) const;
+
+  // PRIVATE MEMBERS ////////////////////////////////////////////////////
+private :
+
+  static const char* _DBFILENAMELEAVES; ///< Filename of leaf database
+  static const char* _DBFILENAMEAVG; ///< Filename of averaged database
+  static const char* _DBFILENAMEOUT; ///< Filename of extracted database
+  static const int _LEVEL; ///< Level of leaf octants
+  static const int _NUMPERDIM; ///< Number of leaf octants along each axis
+
+}; // class TestExtractor
+
+#endif // cencalvm_create_testextractor
+
+// End of file 
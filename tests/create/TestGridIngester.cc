@@ -15,11 +15,19 @@
 #include "cencalvm/create/GridIngester.h" // USES GridIngester
 #include "cencalvm/storage/Geometry.h" // USES Geometry
 #include "cencalvm/storage/GeomCenCA.h" // USES GeomCenCA
+#include "cencalvm/storage/DBSnapshot.h" // USES DBSnapshot
+#include "cencalvm/storage/Payload.h" // USES PayloadStruct
 
 extern "C" {
 #include "etree.h"
 }
 
+#include <stdio.h> // USES fopen(), fclose()
+#include <string.h> // USES memset()
+#include <fcntl.h> // USES open()
+#include <unistd.h> // USES fork(), pwrite(), _exit()
+#include <sys/wait.h> // USES waitpid()
+#include <vector> // USES std::vector
 #include <stdexcept> // USES std::runtime_error
 #include <sstream> // USES std::ostringstream
 
@@ -108,6 +116,53 @@ cencalvm::create::TestGridIngester::testGeometry(void)
   ingester.geometry(&geom);
 } // testGeometry
 
+// ----------------------------------------------------------------------
+// Test numThreads()
+void
+cencalvm::create::TestGridIngester::testNumThreads(void)
+{ // testNumThreads
+  GridIngester ingester;
+  CPPUNIT_ASSERT_EQUAL(0, ingester._numThreads); // default is # processors
+
+  const int numThreads = 3;
+  ingester.numThreads(numThreads);
+  CPPUNIT_ASSERT_EQUAL(numThreads, ingester._numThreads);
+
+  ingester.numThreads(-1);
+  CPPUNIT_ASSERT_EQUAL(numThreads, ingester._numThreads);
+} // testNumThreads
+
+// ----------------------------------------------------------------------
+// Test sortSize()
+void
+cencalvm::create::TestGridIngester::testSortSize(void)
+{ // testSortSize
+  GridIngester ingester;
+  CPPUNIT_ASSERT_EQUAL(0, ingester._sortSize); // default is to pack
+
+  const int sortSize = 24;
+  ingester.sortSize(sortSize);
+  CPPUNIT_ASSERT_EQUAL(sortSize, ingester._sortSize);
+
+  ingester.sortSize(-1);
+  CPPUNIT_ASSERT_EQUAL(sortSize, ingester._sortSize);
+} // testSortSize
+
+// ----------------------------------------------------------------------
+// Test average()
+void
+cencalvm::create::TestGridIngester::testAverage(void)
+{ // testAverage
+  GridIngester ingester;
+  CPPUNIT_ASSERT(!ingester._average); // default is not to average
+
+  ingester.average(true);
+  CPPUNIT_ASSERT(ingester._average);
+
+  ingester.average(false);
+  CPPUNIT_ASSERT(!ingester._average);
+} // testAverage
+
 // ----------------------------------------------------------------------
 // Test run()
 void 
@@ -126,6 +181,178 @@ cencalvm::create::TestGridIngester::testRun(void)
   ingester.quiet(true);
   ingester.run();
 
+  _checkDB(filenameOut);
+} // testRun
+
+// ----------------------------------------------------------------------
+// Test run() with sorted bulk loading
+void 
+cencalvm::create::TestGridIngester::testRunSorted(void)
+{ // testRunSorted
+  const char* filenameParams = "data/paramfile.txt";
+  const char* filenameOut = "data/one.etree";
+  const char* filenameTmp = "data/tmp.etree";
+  storage::GeomCenCA geometry;
+
+  GridIngester ingester;
+  ingester.geometry(&geometry);
+  ingester.filenameParams(filenameParams);
+  ingester.filenameOut(filenameOut);
+  ingester.filenameTmp(filenameTmp);
+  ingester.sortSize(1);
+  ingester.quiet(true);
+  ingester.run();
+
+  _checkDB(filenameOut);
+} // testRunSorted
+
+// ----------------------------------------------------------------------
+// Test run() resuming from checkpoint
+void
+cencalvm::create::TestGridIngester::testResume(void)
+{ // testResume
+  // Parameter file lists a missing grid file after one.dat, so the
+  // first run stops after checkpointing one.dat.
+  const char* filenameParamsBad = "data/paramresume.txt";
+  const char* filenameParams = "data/paramfile.txt";
+  const char* filenameOut = "data/one.etree";
+  const char* filenameTmp = "data/tmp.etree";
+  const char* filenameCheckpoint = "data/one.etree.checkpoint";
+  storage::GeomCenCA geometry;
+
+  const int numSortSizes = 2;
+  const int sortSizes[] = { 0, 1 };
+  for (int iSort=0; iSort < numSortSizes; ++iSort) {
+    { // interrupted run
+      GridIngester ingester;
+      ingester.geometry(&geometry);
+      ingester.filenameParams(filenameParamsBad);
+      ingester.filenameOut(filenameOut);
+      ingester.filenameTmp(filenameTmp);
+      ingester.sortSize(sortSizes[iSort]);
+      ingester.checkpointInterval(1);
+      ingester.quiet(true);
+      CPPUNIT_ASSERT_THROW(ingester.run(), std::runtime_error);
+    } // interrupted run
+    FILE* fin = fopen(filenameCheckpoint, "r");
+    CPPUNIT_ASSERT(0 != fin);
+    fclose(fin);
+
+    GridIngester ingester;
+    ingester.geometry(&geometry);
+    ingester.filenameParams(filenameParams);
+    ingester.filenameOut(filenameOut);
+    ingester.filenameTmp(filenameTmp);
+    ingester.sortSize(sortSizes[iSort]);
+    ingester.checkpointInterval(1);
+    ingester.resume(true);
+    ingester.quiet(true);
+    ingester.run();
+
+    fin = fopen(filenameCheckpoint, "r");
+    CPPUNIT_ASSERT(0 == fin);
+
+    _checkDB(filenameOut);
+  } // for
+} // testResume
+
+// ----------------------------------------------------------------------
+// Test run() resuming after a process inserting past the checkpoint
+// exits without closing the unpacked database
+void
+cencalvm::create::TestGridIngester::testResumeCrash(void)
+{ // testResumeCrash
+  const char* filenameParamsBad = "data/paramresume.txt";
+  const char* filenameParams = "data/paramfile.txt";
+  const char* filenameOut = "data/one.etree";
+  const char* filenameTmp = "data/tmp.etree";
+  storage::GeomCenCA geometry;
+
+  { // interrupted run
+    GridIngester ingester;
+    ingester.geometry(&geometry);
+    ingester.filenameParams(filenameParamsBad);
+    ingester.filenameOut(filenameOut);
+    ingester.filenameTmp(filenameTmp);
+    ingester.checkpointInterval(1);
+    ingester.quiet(true);
+    CPPUNIT_ASSERT_THROW(ingester.run(), std::runtime_error);
+  } // interrupted run
+
+  // Child inserts an octant after the checkpoint and exits without
+  // closing the database. Dirty pages evicted before a crash can
+  // overwrite pages of the database at the checkpoint, which is
+  // simulated by overwriting the first page.
+  const pid_t pid = fork();
+  CPPUNIT_ASSERT(pid >= 0);
+  if (0 == pid) {
+    etree_t* db = etree_open(filenameTmp, O_RDWR, 1, 0, 0);
+    if (0 == db)
+      _exit(1);
+    storage::PayloadStruct payload;
+    memset(&payload, 0, sizeof(payload));
+    etree_addr_t addr;
+    addr.t = 0;
+    addr.type = ETREE_LEAF;
+    addr.level = 3;
+    addr.x = 0;
+    addr.y = 0;
+    addr.z = 0;
+    if (0 != etree_insert(db, addr, &payload))
+      _exit(1);
+    const int fd = open(filenameTmp, O_WRONLY);
+    const int pageSize = 4096;
+    std::vector<char> garbage(pageSize, 0x5a);
+    if (fd < 0 || pageSize != pwrite(fd, &garbage[0], pageSize, 0))
+      _exit(1);
+    _exit(0);
+  } // if
+  int status = 0;
+  CPPUNIT_ASSERT_EQUAL(pid, waitpid(pid, &status, 0));
+  CPPUNIT_ASSERT(WIFEXITED(status));
+  CPPUNIT_ASSERT_EQUAL(0, WEXITSTATUS(status));
+
+  GridIngester ingester;
+  ingester.geometry(&geometry);
+  ingester.filenameParams(filenameParams);
+  ingester.filenameOut(filenameOut);
+  ingester.filenameTmp(filenameTmp);
+  ingester.checkpointInterval(1);
+  ingester.resume(true);
+  ingester.quiet(true);
+  ingester.run();
+
+  _checkDB(filenameOut);
+
+  // Snapshots are removed when ingestion finishes.
+  for (int slot=0; slot < storage::DBSnapshot::NUMSLOTS; ++slot) {
+    const std::string filename =
+      storage::DBSnapshot::filename(filenameTmp, slot);
+    FILE* fin = fopen(filename.c_str(), "r");
+    CPPUNIT_ASSERT(0 == fin);
+  } // for
+} // testResumeCrash
+
+// ----------------------------------------------------------------------
+// Test quiet()
+void
+cencalvm::create::TestGridIngester::testQuiet(void)
+{ // testQuiet
+  GridIngester ingester;
+  CPPUNIT_ASSERT(!ingester._quiet); // default is not quiet
+  ingester.quiet(true);
+  CPPUNIT_ASSERT(ingester._quiet);
+  ingester.quiet(false);
+  CPPUNIT_ASSERT(!ingester._quiet);
+} // testQuiet
+
+// ----------------------------------------------------------------------
+// Check contents of database created by run().
+void
+cencalvm::create::TestGridIngester::_checkDB(const char* filenameOut) const
+{ // _checkDB
+  storage::GeomCenCA geometry;
+
   const double p = 409612.5;
   const double q = 204812.5;
   const double r = 1587187.5;
@@ -166,20 +393,7 @@ cencalvm::create::TestGridIngester::testRun(void)
 			       tolerance);
   CPPUNIT_ASSERT_EQUAL(_PAYLOAD.FaultBlock, payload.FaultBlock);
   CPPUNIT_ASSERT_EQUAL(_PAYLOAD.Zone, payload.Zone);
-} // testRun
-
-// ----------------------------------------------------------------------
-// Test quiet()
-void
-cencalvm::create::TestGridIngester::testQuiet(void)
-{ // testQuiet
-  GridIngester ingester;
-  CPPUNIT_ASSERT(!ingester._quiet); // default is not quiet
-  ingester.quiet(true);
-  CPPUNIT_ASSERT(ingester._quiet);
-  ingester.quiet(false);
-  CPPUNIT_ASSERT(!ingester._quiet);
-} // testQuiet
+} // _checkDB
 
 // version
 // $Id$
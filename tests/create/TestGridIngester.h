@@ -44,7 +44,13 @@ class cencalvm::create::TestGridIngester : public CppUnit::TestFixture
   CPPUNIT_TEST( testCacheSize );
   CPPUNIT_TEST( testDescription );
   CPPUNIT_TEST( testGeometry );
+  CPPUNIT_TEST( testNumThreads );
+  CPPUNIT_TEST( testSortSize );
+  CPPUNIT_TEST( testAverage );
   CPPUNIT_TEST( testRun );
+  CPPUNIT_TEST( testRunSorted );
+  CPPUNIT_TEST( testResume );
+  CPPUNIT_TEST( testResumeCrash );
   CPPUNIT_TEST( testQuiet );
   CPPUNIT_TEST_SUITE_END();
 
@@ -72,15 +78,43 @@ public :
   /// Test geometry()
   void testGeometry(void);
 
+  /// Test numThreads()
+  void testNumThreads(void);
+
+  /// Test sortSize()
+  void testSortSize(void);
+
+  /// Test average()
+  void testAverage(void);
+
   /// Test run()
   void testRun(void);
 
+  /// Test run() with sorted bulk loading
+  void testRunSorted(void);
+
+  /// Test run() resuming from checkpoint
+  void testResume(void);
+
+  /// Test run() resuming after a process inserting past the
+  /// checkpoint exits without closing the unpacked database
+  void testResumeCrash(void);
+
   /// Test quiet()
   void testQuiet(void);
 
   // PRIVATE METHODS ////////////////////////////////////////////////////
 private :
 
+  /** Check contents of database created by run().
+   *
+   * @param filename Name of database file
+   */
+  void _checkDB(const char* filename) const;
+
+  // PRIVATE MEMBERS ////////////////////////////////////////////////////
+private :
+
   static const cencalvm::storage::PayloadStruct _PAYLOAD; ///< Payload in db
   static const double _LONLATELEV[]; ///< Lon/Lat/Elev of test location
   static const etree_tick_t _ADDRX; ///< Address x tick of test location
@@ -0,0 +1,185 @@
+// -*- C++ -*-
+//
+// ----------------------------------------------------------------------
+//
+//                           Brad T. Aagaard
+//                        U.S. Geological Survey
+//
+// {LicenseText}
+//
+// ----------------------------------------------------------------------
+//
+
+#include "TestOctantSorter.h" // Implementation of class methods
+
+#include "cencalvm/create/OctantSorter.h" // USES OctantSorter
+#include "cencalvm/storage/Payload.h" // USES PayloadStruct
+#include "cencalvm/storage/Geometry.h" // USES Geometry
+
+extern "C" {
+#include "etree.h"
+}
+
+#include <unistd.h> // USES access()
+
+#include <stdexcept> // USES std::runtime_error
+
+// ----------------------------------------------------------------------
+CPPUNIT_TEST_SUITE_REGISTRATION( cencalvm::create::TestOctantSorter );
+
+// ----------------------------------------------------------------------
+const char* cencalvm::create::TestOctantSorter::_FILENAMEROOT = 
+  "data/sort.tmp";
+const int cencalvm::create::TestOctantSorter::_NUMOCTANTS = 64;
+
+// ----------------------------------------------------------------------
+// Test constructor
+void
+cencalvm::create::TestOctantSorter::testConstructor(void)
+{ // testConstructor
+  OctantSorter sorter(_FILENAMEROOT, 1024);
+  CPPUNIT_ASSERT_EQUAL(size_t(0), sorter.numOctants());
+  CPPUNIT_ASSERT_EQUAL(0, sorter.numRuns());
+} // testConstructor
+
+// ----------------------------------------------------------------------
+// Test add()
+void
+cencalvm::create::TestOctantSorter::testAdd(void)
+{ // testAdd
+  OctantSorter sorter(_FILENAMEROOT, 1024*1024);
+  _addOctants(&sorter);
+  CPPUNIT_ASSERT_EQUAL(size_t(_NUMOCTANTS), sorter.numOctants());
+  CPPUNIT_ASSERT_EQUAL(0, sorter.numRuns());
+} // testAdd
+
+// ----------------------------------------------------------------------
+// Test sort() and next() with all octants in memory
+void
+cencalvm::create::TestOctantSorter::testSortMemory(void)
+{ // testSortMemory
+  OctantSorter sorter(_FILENAMEROOT, 1024*1024);
+  _addOctants(&sorter);
+  sorter.sort();
+  CPPUNIT_ASSERT_EQUAL(0, sorter.numRuns());
+  _checkOrder(&sorter);
+} // testSortMemory
+
+// ----------------------------------------------------------------------
+// Test sort() and next() with octants merged from run files
+void
+cencalvm::create::TestOctantSorter::testSortRuns(void)
+{ // testSortRuns
+  const int numRuns = 5;
+  { // scope for sorter
+    // Memory for a little less than 1/4 of the octants
+    const size_t memorySize =
+      (_NUMOCTANTS/4 - 1) * (sizeof(etree_addr_t) + 
+			     sizeof(storage::PayloadStruct));
+    OctantSorter sorter(_FILENAMEROOT, memorySize);
+    _addOctants(&sorter);
+    sorter.sort();
+    CPPUNIT_ASSERT_EQUAL(numRuns, sorter.numRuns());
+    CPPUNIT_ASSERT_EQUAL(0, access("data/sort.tmp.run0", F_OK));
+    _checkOrder(&sorter);
+  } // scope for sorter
+
+  // Run files are removed when sorter is destroyed.
+  CPPUNIT_ASSERT(0 != access("data/sort.tmp.run0", F_OK));
+} // testSortRuns
+
+// ----------------------------------------------------------------------
+// Test checkpoint() and resume()
+void
+cencalvm::create::TestOctantSorter::testResume(void)
+{ // testResume
+  const size_t memorySize = 1024*1024;
+  { // scope for sorter
+    OctantSorter sorter(_FILENAMEROOT, memorySize);
+    _addOctants(&sorter, 0, 20);
+    sorter.checkpoint();
+    CPPUNIT_ASSERT_EQUAL(1, sorter.numRuns());
+    _addOctants(&sorter, 20, 30);
+    sorter.checkpoint();
+    CPPUNIT_ASSERT_EQUAL(2, sorter.numRuns());
+    // Run written after the checkpoint that is resumed.
+    _addOctants(&sorter, 30, 40);
+    sorter.checkpoint();
+    CPPUNIT_ASSERT_EQUAL(3, sorter.numRuns());
+  } // scope for sorter
+
+  // Run files are kept for resuming when sorter is destroyed.
+  CPPUNIT_ASSERT_EQUAL(0, access("data/sort.tmp.run2", F_OK));
+
+  { // scope for sorter
+    OctantSorter sorter(_FILENAMEROOT, memorySize);
+    CPPUNIT_ASSERT_THROW(sorter.resume(3, 30), std::runtime_error);
+  } // scope for sorter
+
+  { // scope for sorter
+    OctantSorter sorter(_FILENAMEROOT, memorySize);
+    sorter.resume(2, 30);
+    CPPUNIT_ASSERT_EQUAL(2, sorter.numRuns());
+    CPPUNIT_ASSERT_EQUAL(size_t(30), sorter.numOctants());
+    CPPUNIT_ASSERT(0 != access("data/sort.tmp.run2", F_OK));
+
+    _addOctants(&sorter, 30, _NUMOCTANTS);
+    sorter.sort();
+    _checkOrder(&sorter);
+  } // scope for sorter
+
+  // Run files are removed once all octants have been returned.
+  CPPUNIT_ASSERT(0 != access("data/sort.tmp.run0", F_OK));
+} // testResume
+
+// ----------------------------------------------------------------------
+// Add octants in scrambled order.
+void
+cencalvm::create::TestOctantSorter::_addOctants(OctantSorter* pSorter,
+						const int iBegin,
+						const int iEnd) const
+{ // _addOctants
+  CPPUNIT_ASSERT(0 != pSorter);
+
+  // Octants at level 2 with payload Vp holding the index of the octant
+  // in etree order. Multiplying by 37 (relatively prime to 64)
+  // scrambles the order of insertion.
+  const etree_tick_t level = 2;
+  const etree_tick_t tickLen = 0x80000000 >> level;
+  for (int i=iBegin; i < iEnd; ++i) {
+    const int index = (37*i) % _NUMOCTANTS;
+    etree_addr_t addr;
+    addr.x = tickLen * ((index & 1) | ((index >> 2) & 2));
+    addr.y = tickLen * (((index >> 1) & 1) | ((index >> 3) & 2));
+    addr.z = tickLen * (((index >> 2) & 1) | ((index >> 4) & 2));
+    addr.t = 0;
+    addr.level = level;
+    addr.type = ETREE_LEAF;
+
+    storage::PayloadStruct payload;
+    payload.Vp = index;
+    payload.FaultBlock = 1;
+    payload.Zone = 2;
+    pSorter->add(addr, payload);
+  } // for
+} // _addOctants
+
+// ----------------------------------------------------------------------
+// Check that octants are returned in etree order.
+void
+cencalvm::create::TestOctantSorter::_checkOrder(OctantSorter* pSorter) const
+{ // _checkOrder
+  CPPUNIT_ASSERT(0 != pSorter);
+
+  etree_addr_t addr;
+  storage::PayloadStruct payload;
+  int count = 0;
+  while (pSorter->next(&addr, &payload)) {
+    CPPUNIT_ASSERT_EQUAL(float(count), payload.Vp);
+    CPPUNIT_ASSERT_EQUAL(int16_t(2), payload.Zone);
+    ++count;
+  } // while
+  CPPUNIT_ASSERT_EQUAL(_NUMOCTANTS, count);
+} // _checkOrder
+
+// End of file 
@@ -0,0 +1,92 @@
+// -*- C++ -*-
+//
+// ----------------------------------------------------------------------
+//
+//                           Brad T. Aagaard
+//                        U.S. Geological Survey
+//
+// {LicenseText}
+//
+// ----------------------------------------------------------------------
+//
+
+/** @file tests/TestOctantSorter.h
+ *
+ * @brief C++ TestOctantSorter object
+ *
+ * C++ unit testing for TestOctantSorter.
+ */
+
+#if !defined(cencalvm_create_testoctantsorter_h)
+#define cencalvm_create_testoctantsorter_h
+
+#include <cppunit/extensions/HelperMacros.h>
+
+namespace cencalvm {
+  namespace create {
+    class TestOctantSorter;
+    class OctantSorter; // USES OctantSorter
+  } // create
+} // cencalvm
+
+/// C++ unit testing for OctantSorter
+class cencalvm::create::TestOctantSorter : public CppUnit::TestFixture
+{ // class TestOctantSorter
+
+  // CPPUNIT TEST SUITE /////////////////////////////////////////////////
+  CPPUNIT_TEST_SUITE( TestOctantSorter );
+  CPPUNIT_TEST( testConstructor );
+  CPPUNIT_TEST( testAdd );
+  CPPUNIT_TEST( testSortMemory );
+  CPPUNIT_TEST( testSortRuns );
+  CPPUNIT_TEST( testResume );
+  CPPUNIT_TEST_SUITE_END();
+
+  // PUBLIC METHODS /////////////////////////////////////////////////////
+public :
+
+  /// Test constructor
+  void testConstructor(void);
+
+  /// Test add()
+  void testAdd(void);
+
+  /// Test sort() and next() with all octants in memory
+  void testSortMemory(void);
+
+  /// Test sort() and next() with octants merged from run files
+  void testSortRuns(void);
+
+  /// Test checkpoint() and resume()
+  void testResume(void);
+
+  // PRIVATE METHODS ////////////////////////////////////////////////////
+private :
+
+  /** Add octants in scrambled order.
+   *
+   * @param pSorter Pointer to sorter
+   * @param iBegin Index of first octant in insertion order to add
+   * @param iEnd Index after last octant in insertion order to add
+   */
+  void _addOctants(OctantSorter* pSorter,
+		   const int iBegin =0,
+		   const int iEnd =_NUMOCTANTS) const;
+
+  /** Check that octants are returned in etree order.
+   *
+   * @param pSorter Pointer to sorter
+   */
+  void _checkOrder(OctantSorter* pSorter) const;
+
+  // PRIVATE MEMBERS ////////////////////////////////////////////////////
+private :
+
+  static const char* _FILENAMEROOT; ///< Root name of run files
+  static const int _NUMOCTANTS; ///< Number of octants added
+
+}; // class TestOctantSorter
+
+#endif // cencalvm_create_testoctantsorter
+
+// End of file 
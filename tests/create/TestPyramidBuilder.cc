@@ -0,0 +1,236 @@
+// -*- C++ -*-
+//
+// ----------------------------------------------------------------------
+//
+//                           Brad T. Aagaard
+//                        U.S. Geological Survey
+//
+// {LicenseText}
+//
+// ----------------------------------------------------------------------
+//
+
+#include "TestPyramidBuilder.h" // Implementation of class methods
+
+#include "cencalvm/create/PyramidBuilder.h" // USES PyramidBuilder
+#include "cencalvm/create/Quantizer.h" // USES Quantizer
+
+#include "cencalvm/average/Averager.h" // USES Averager
+#include "cencalvm/storage/BrickDB.h" // USES BrickDB
+#include "cencalvm/storage/Payload.h" // USES PayloadStruct
+#include "cencalvm/storage/PayloadCodec.h" // USES PayloadCodec
+
+extern "C" {
+#include "etree.h"
+}
+
+#include <stdlib.h> // USES free()
+#include <string.h> // USES strcmp(), memcmp()
+#include <stdexcept> // USES std::runtime_error
+
+// ----------------------------------------------------------------------
+CPPUNIT_TEST_SUITE_REGISTRATION( cencalvm::create::TestPyramidBuilder );
+
+// ----------------------------------------------------------------------
+const char* cencalvm::create::TestPyramidBuilder::_DBFILENAMELEAVES =
+  "data/pyramidleaves.etree";
+const char* cencalvm::create::TestPyramidBuilder::_DBFILENAMEAVG =
+  "data/pyramidavg.etree";
+const char* cencalvm::create::TestPyramidBuilder::_DBFILENAMECOMPACT =
+  "data/pyramidcompact.etree";
+const char* cencalvm::create::TestPyramidBuilder::_DBFILENAMEOUT =
+  "data/pyramidout.bricks";
+const int cencalvm::create::TestPyramidBuilder::_LEVEL = 3;
+const int cencalvm::create::TestPyramidBuilder::_NUMPERDIM = 4;
+
+// ----------------------------------------------------------------------
+// Test constructor
+void
+cencalvm::create::TestPyramidBuilder::testConstructor(void)
+{ // testConstructor
+  PyramidBuilder builder;
+} // testConstructor
+
+// ----------------------------------------------------------------------
+// Test levels()
+void
+cencalvm::create::TestPyramidBuilder::testLevels(void)
+{ // testLevels
+  PyramidBuilder builder;
+  builder.levels(2, 5);
+  CPPUNIT_ASSERT_EQUAL(2, builder._minLevel);
+  CPPUNIT_ASSERT_EQUAL(5, builder._maxLevel);
+
+  // Levels are checked before database is opened.
+  builder.filenameIn("data/nosuchfile.etree");
+  builder.filenameOut(_DBFILENAMEOUT);
+  builder.quiet(true);
+  builder.levels(3, 2);
+  CPPUNIT_ASSERT_THROW(builder.build(), std::runtime_error);
+  builder.levels(-1, 2);
+  CPPUNIT_ASSERT_THROW(builder.build(), std::runtime_error);
+  builder.levels(0, storage::BrickDB::MAXLEVEL+1);
+  CPPUNIT_ASSERT_THROW(builder.build(), std::runtime_error);
+} // testLevels
+
+// ----------------------------------------------------------------------
+// Test build()
+void
+cencalvm::create::TestPyramidBuilder::testBuild(void)
+{ // testBuild
+  _createDB();
+  _checkPyramid(_DBFILENAMEAVG);
+} // testBuild
+
+// ----------------------------------------------------------------------
+// Test build() with compact input database
+void
+cencalvm::create::TestPyramidBuilder::testBuildCompact(void)
+{ // testBuildCompact
+  _createDB();
+
+  Quantizer quantizer;
+  quantizer.filenameIn(_DBFILENAMEAVG);
+  quantizer.filenameOut(_DBFILENAMECOMPACT);
+  quantizer.quiet(true);
+  quantizer.quantize();
+
+  _checkPyramid(_DBFILENAMECOMPACT);
+} // testBuildCompact
+
+// ----------------------------------------------------------------------
+// Create averaged etree database.
+void
+cencalvm::create::TestPyramidBuilder::_createDB(void) const
+{ // _createDB
+  etree_t* db = etree_open(_DBFILENAMELEAVES, O_CREAT|O_RDWR|O_TRUNC,
+			   0, 0, 3);
+  CPPUNIT_ASSERT(0 != db);
+  int err = etree_registerschema(db, storage::Payload::SCHEMA);
+  CPPUNIT_ASSERT(0 == err);
+
+  const etree_tick_t tickLen = 0x80000000 >> _LEVEL;
+  for (int iZ=0; iZ < _NUMPERDIM; ++iZ)
+    for (int iY=0; iY < _NUMPERDIM; ++iY)
+      for (int iX=0; iX < _NUMPERDIM; ++iX) {
+	// Leave corner of domain empty.
+	if (iX == _NUMPERDIM-1 && iY == _NUMPERDIM-1)
+	  continue;
+
+	etree_addr_t addr;
+	addr.x = iX*tickLen;
+	addr.y = iY*tickLen;
+	addr.z = iZ*tickLen;
+	addr.t = 0;
+	addr.level = _LEVEL;
+	addr.type = ETREE_LEAF;
+
+	const double val = 1.0 + iX + _NUMPERDIM*(iY + _NUMPERDIM*iZ);
+	storage::PayloadStruct payload;
+	payload.Vp = 2000.0 + 10.3*val;
+	payload.Vs = 1000.0 + 10.7*val;
+	payload.Density = 2000.0 + 1.13*val;
+	payload.Qp = 100.0 + 0.37*val;
+	payload.Qs = 50.0 + 0.19*val;
+	payload.DepthFreeSurf = 100.3*val;
+	payload.FaultBlock = 1 + iX;
+	payload.Zone = 1 + iY;
+
+	err = etree_insert(db, addr, &payload);
+	CPPUNIT_ASSERT(0 == err);
+      } // for
+  err = etree_close(db);
+  CPPUNIT_ASSERT(0 == err);
+
+  average::Averager averager;
+  averager.filenameIn(_DBFILENAMELEAVES);
+  averager.filenameOut(_DBFILENAMEAVG);
+  averager.quiet(true);
+  averager.average();
+} // _createDB
+
+// ----------------------------------------------------------------------
+// Build pyramid and check every cell against search of etree database.
+void
+cencalvm::create::TestPyramidBuilder::_checkPyramid(const char* filenameDB) const
+{ // _checkPyramid
+  const int minLevel = 0;
+  const int maxLevel = _LEVEL + 1;
+
+  PyramidBuilder builder;
+  builder.filenameIn(filenameDB);
+  builder.filenameOut(_DBFILENAMEOUT);
+  builder.levels(minLevel, maxLevel);
+  builder.quiet(true);
+  builder.build();
+
+  storage::BrickDB pyramid;
+  pyramid.open(_DBFILENAMEOUT);
+  CPPUNIT_ASSERT_EQUAL(maxLevel-minLevel+1, pyramid.numLevels());
+
+  etree_t* db = etree_open(filenameDB, O_RDONLY, 0, 0, 0);
+  CPPUNIT_ASSERT(0 != db);
+  storage::PayloadCodec* pCodec = 0;
+  char* schema = etree_getschema(db);
+  if (0 == strcmp(storage::Payload::SCHEMACOMPACT, schema)) {
+    char* appmeta = etree_getappmeta(db);
+    pCodec = new storage::PayloadCodec;
+    pCodec->parseMetadata(appmeta);
+    free(appmeta);
+  } // if
+  free(schema);
+
+  storage::PayloadStruct noData;
+  noData.Vp = storage::Payload::NODATAVAL;
+  noData.Vs = storage::Payload::NODATAVAL;
+  noData.Density = storage::Payload::NODATAVAL;
+  noData.Qp = storage::Payload::NODATAVAL;
+  noData.Qs = storage::Payload::NODATAVAL;
+  noData.DepthFreeSurf = storage::Payload::NODATAVAL;
+  noData.FaultBlock = storage::Payload::NODATABLOCK;
+  noData.Zone = storage::Payload::NODATAZONE;
+
+  // Cells must hold the payload of a fixed resolution search: octant
+  // at level of cell or leaf octant at coarser level.
+  int numData = 0;
+  for (int level=minLevel; level <= maxLevel; ++level) {
+    const int numCells = 1 << level;
+    const int shift = ETREE_MAXLEVEL - level;
+    for (int iZ=0; iZ < numCells; ++iZ)
+      for (int iY=0; iY < numCells; ++iY)
+	for (int iX=0; iX < numCells; ++iX) {
+	  etree_addr_t addr;
+	  addr.x = etree_tick_t(iX) << shift;
+	  addr.y = etree_tick_t(iY) << shift;
+	  addr.z = etree_tick_t(iZ) << shift;
+	  addr.t = 0;
+	  addr.level = level;
+	  addr.type = ETREE_LEAF;
+
+	  etree_addr_t resAddr;
+	  storage::PayloadStruct payloadE;
+	  const int err = etree_search(db, addr, &resAddr, "*", &payloadE);
+	  if (err ||
+	      (ETREE_INTERIOR == resAddr.type && resAddr.level < level))
+	    payloadE = noData;
+	  else {
+	    ++numData;
+	    if (0 != pCodec) {
+	      const storage::PayloadCompactStruct compact =
+		*(storage::PayloadCompactStruct*) &payloadE;
+	      pCodec->decode(&payloadE, compact);
+	    } // if
+	  } // if/else
+
+	  storage::PayloadStruct payload;
+	  CPPUNIT_ASSERT(0 == pyramid.search(&payload, addr));
+	  CPPUNIT_ASSERT(0 == memcmp(&payloadE, &payload, sizeof(payload)));
+	} // for
+  } // for
+  CPPUNIT_ASSERT(numData > 0);
+
+  delete pCodec; pCodec = 0;
+  CPPUNIT_ASSERT(0 == etree_close(db));
+} // _checkPyramid
+
+// End of file
@@ -0,0 +1,85 @@
+// -*- C++ -*-
+//
+// ----------------------------------------------------------------------
+//
+//                           Brad T. Aagaard
+//                        U.S. Geological Survey
+//
+// {LicenseText}
+//
+// ----------------------------------------------------------------------
+//
+
+/** @file tests/TestPyramidBuilder.h
+ *
+ * @brief C++ TestPyramidBuilder object
+ *
+ * C++ unit testing for PyramidBuilder.
+ */
+
+#if !defined(cencalvm_create_testpyramidbuilder_h)
+#define cencalvm_create_testpyramidbuilder_h
+
+#include <cppunit/extensions/HelperMacros.h>
+
+namespace cencalvm {
+  namespace create {
+    class TestPyramidBuilder;
+  } // create
+} // cencalvm
+
+/// C++ unit testing for PyramidBuilder
+class cencalvm::create::TestPyramidBuilder : public CppUnit::TestFixture
+{ // class TestPyramidBuilder
+
+  // CPPUNIT TEST SUITE /////////////////////////////////////////////////
+  CPPUNIT_TEST_SUITE( TestPyramidBuilder );
+  CPPUNIT_TEST( testConstructor );
+  CPPUNIT_TEST( testLevels );
+  CPPUNIT_TEST( testBuild );
+  CPPUNIT_TEST( testBuildCompact );
+  CPPUNIT_TEST_SUITE_END();
+
+  // PUBLIC METHODS /////////////////////////////////////////////////////
+public :
+
+  /// Test constructor
+  void testConstructor(void);
+
+  /// Test levels()
+  void testLevels(void);
+
+  /// Test build()
+  void testBuild(void);
+
+  /// Test build() with compact input database
+  void testBuildCompact(void);
+
+  // PRIVATE METHODS ////////////////////////////////////////////////////
+private :
+
+  /// Create averaged etree database.
+  void _createDB(void) const;
+
+  /** Build pyramid and check every cell against search of etree
+   * database.
+   *
+   * @param filenameDB Name of etree database
+   */
+  void _checkPyramid(const char* filenameDB) const;
+
+  // PRIVATE MEMBERS ////////////////////////////////////////////////////
+private :
+
+  static const char* _DBFILENAMELEAVES; ///< Filename of leaf database
+  static const char* _DBFILENAMEAVG; ///< Filename of averaged database
+  static const char* _DBFILENAMECOMPACT; ///< Filename of compact database
+  static const char* _DBFILENAMEOUT; ///< Filename of brick pyramid
+  static const int _LEVEL; ///< Level of leaf octants
+  static const int _NUMPERDIM; ///< Number of leaf octants along each axis
+
+}; // class TestPyramidBuilder
+
+#endif // cencalvm_create_testpyramidbuilder
+
+// End of file
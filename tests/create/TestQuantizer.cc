@@ -0,0 +1,209 @@
+// -*- C++ -*-
+//
+// ----------------------------------------------------------------------
+//
+//                           Brad T. Aagaard
+//                        U.S. Geological Survey
+//
+// {LicenseText}
+//
+// ----------------------------------------------------------------------
+//
+
+#include "TestQuantizer.h" // Implementation of class methods
+
+#include "cencalvm/create/Quantizer.h" // USES Quantizer
+
+#include "cencalvm/average/Averager.h" // USES Averager
+#include "cencalvm/storage/Payload.h" // USES PayloadStruct
+#include "cencalvm/storage/PayloadCodec.h" // USES PayloadCodec
+
+extern "C" {
+#include "etree.h"
+}
+
+#include <stdlib.h> // USES free()
+#include <string.h> // USES strcmp()
+#include <stdexcept> // USES std::runtime_error
+
+// ----------------------------------------------------------------------
+CPPUNIT_TEST_SUITE_REGISTRATION( cencalvm::create::TestQuantizer );
+
+// ----------------------------------------------------------------------
+const char* cencalvm::create::TestQuantizer::_DBFILENAMELEAVES =
+  "data/quantizeleaves.etree";
+const char* cencalvm::create::TestQuantizer::_DBFILENAMEAVG =
+  "data/quantizeavg.etree";
+const char* cencalvm::create::TestQuantizer::_DBFILENAMEOUT =
+  "data/quantizeout.etree";
+const int cencalvm::create::TestQuantizer::_LEVEL = 3;
+const int cencalvm::create::TestQuantizer::_NUMPERDIM = 4;
+
+// ----------------------------------------------------------------------
+// Test constructor
+void
+cencalvm::create::TestQuantizer::testConstructor(void)
+{ // testConstructor
+  Quantizer quantizer;
+} // testConstructor
+
+// ----------------------------------------------------------------------
+// Test errorBound()
+void
+cencalvm::create::TestQuantizer::testErrorBound(void)
+{ // testErrorBound
+  Quantizer quantizer;
+
+  quantizer.errorBound("Vs", 2.0);
+  const double tolerance = 1.0e-06;
+  CPPUNIT_ASSERT_DOUBLES_EQUAL(2.0, quantizer._pCodec->errorBound("Vs"),
+			       tolerance);
+
+  CPPUNIT_ASSERT_THROW(quantizer.errorBound("Zone", 1.0),
+		       std::runtime_error);
+} // testErrorBound
+
+// ----------------------------------------------------------------------
+// Test quantize()
+void
+cencalvm::create::TestQuantizer::testQuantize(void)
+{ // testQuantize
+  _createDB();
+
+  Quantizer quantizer;
+  quantizer.filenameIn(_DBFILENAMEAVG);
+  quantizer.filenameOut(_DBFILENAMEOUT);
+  quantizer.errorBound("Density", 0.1);
+  quantizer.quiet(true);
+  quantizer.quantize();
+
+  etree_t* dbIn = etree_open(_DBFILENAMEAVG, O_RDONLY, 0, 0, 0);
+  CPPUNIT_ASSERT(0 != dbIn);
+  etree_t* dbOut = etree_open(_DBFILENAMEOUT, O_RDONLY, 0, 0, 0);
+  CPPUNIT_ASSERT(0 != dbOut);
+
+  CPPUNIT_ASSERT_EQUAL(int(sizeof(storage::PayloadCompactStruct)),
+		       etree_getpayloadsize(dbOut));
+  char* schema = etree_getschema(dbOut);
+  CPPUNIT_ASSERT(0 == strcmp(storage::Payload::SCHEMACOMPACT, schema));
+  free(schema);
+  CPPUNIT_ASSERT_EQUAL(etree_gettotalcount(dbIn),
+		       etree_gettotalcount(dbOut));
+
+  storage::PayloadCodec codec;
+  char* appmeta = etree_getappmeta(dbOut);
+  codec.parseMetadata(appmeta);
+  free(appmeta);
+
+  etree_addr_t cursor;
+  cursor.x = 0;
+  cursor.y = 0;
+  cursor.z = 0;
+  cursor.t = 0;
+  cursor.level = ETREE_MAXLEVEL;
+  CPPUNIT_ASSERT(0 == etree_initcursor(dbIn, cursor));
+  CPPUNIT_ASSERT(0 == etree_initcursor(dbOut, cursor));
+  const double tolerance = 1.0e-03;
+  bool more = true;
+  while (more) {
+    etree_addr_t addrE;
+    storage::PayloadStruct payloadE;
+    CPPUNIT_ASSERT(0 == etree_getcursor(dbIn, &addrE, "*", &payloadE));
+    etree_addr_t addr;
+    storage::PayloadCompactStruct compact;
+    CPPUNIT_ASSERT(0 == etree_getcursor(dbOut, &addr, "*", &compact));
+    storage::PayloadStruct payload;
+    codec.decode(&payload, compact);
+
+    CPPUNIT_ASSERT_EQUAL(addrE.x, addr.x);
+    CPPUNIT_ASSERT_EQUAL(addrE.y, addr.y);
+    CPPUNIT_ASSERT_EQUAL(addrE.z, addr.z);
+    CPPUNIT_ASSERT_EQUAL(addrE.level, addr.level);
+    CPPUNIT_ASSERT_EQUAL(int(addrE.type), int(addr.type));
+
+    const float* pValsE = &payloadE.Vp;
+    const float* pVals = &payload.Vp;
+    for (int iVal=0; iVal < storage::PayloadCodec::NUMVALUES; ++iVal)
+      CPPUNIT_ASSERT_DOUBLES_EQUAL(pValsE[iVal], pVals[iVal],
+	   codec.errorBound(storage::PayloadCodec::NAMES[iVal]) + tolerance);
+    CPPUNIT_ASSERT_EQUAL(payloadE.FaultBlock, payload.FaultBlock);
+    CPPUNIT_ASSERT_EQUAL(payloadE.Zone, payload.Zone);
+
+    more = (0 == etree_advcursor(dbIn));
+    CPPUNIT_ASSERT_EQUAL(more, 0 == etree_advcursor(dbOut));
+  } // while
+
+  CPPUNIT_ASSERT(0 == etree_close(dbOut));
+  CPPUNIT_ASSERT(0 == etree_close(dbIn));
+} // testQuantize
+
+// ----------------------------------------------------------------------
+// Test quantize() with compact input database
+void
+cencalvm::create::TestQuantizer::testQuantizeCompact(void)
+{ // testQuantizeCompact
+  _createDB();
+
+  Quantizer quantizer;
+  quantizer.filenameIn(_DBFILENAMEAVG);
+  quantizer.filenameOut(_DBFILENAMEOUT);
+  quantizer.quiet(true);
+  quantizer.quantize();
+
+  quantizer.filenameIn(_DBFILENAMEOUT);
+  quantizer.filenameOut(_DBFILENAMELEAVES);
+  CPPUNIT_ASSERT_THROW(quantizer.quantize(), std::runtime_error);
+} // testQuantizeCompact
+
+// ----------------------------------------------------------------------
+// Create averaged etree database.
+void
+cencalvm::create::TestQuantizer::_createDB(void) const
+{ // _createDB
+  etree_t* db = etree_open(_DBFILENAMELEAVES, O_CREAT|O_RDWR|O_TRUNC,
+			   0, 0, 3);
+  CPPUNIT_ASSERT(0 != db);
+  int err = etree_registerschema(db, storage::Payload::SCHEMA);
+  CPPUNIT_ASSERT(0 == err);
+
+  const etree_tick_t tickLen = 0x80000000 >> _LEVEL;
+  for (int iZ=0; iZ < _NUMPERDIM; ++iZ)
+    for (int iY=0; iY < _NUMPERDIM; ++iY)
+      for (int iX=0; iX < _NUMPERDIM; ++iX) {
+	etree_addr_t addr;
+	addr.x = iX*tickLen;
+	addr.y = iY*tickLen;
+	addr.z = iZ*tickLen;
+	addr.t = 0;
+	addr.level = _LEVEL;
+	addr.type = ETREE_LEAF;
+
+	const double val = 1.0 + iX + _NUMPERDIM*(iY + _NUMPERDIM*iZ);
+	storage::PayloadStruct payload;
+	payload.Vp = 2000.0 + 10.3*val;
+	payload.Vs = 1000.0 + 10.7*val;
+	payload.Density = 2000.0 + 1.13*val;
+	payload.Qp = 100.0 + 0.37*val;
+	payload.Qs = 50.0 + 0.19*val;
+	payload.DepthFreeSurf = 100.3*val;
+	payload.FaultBlock = 1 + iX;
+	payload.Zone = 1 + iY;
+	if (0 == iX && 0 == iY) {
+	  payload.Vs = storage::Payload::NODATAVAL;
+	  payload.Qs = storage::Payload::NODATAVAL;
+	} // if
+
+	err = etree_insert(db, addr, &payload);
+	CPPUNIT_ASSERT(0 == err);
+      } // for
+  err = etree_close(db);
+  CPPUNIT_ASSERT(0 == err);
+
+  average::Averager averager;
+  averager.filenameIn(_DBFILENAMELEAVES);
+  averager.filenameOut(_DBFILENAMEAVG);
+  averager.quiet(true);
+  averager.average();
+} // _createDB
+
+// End of file
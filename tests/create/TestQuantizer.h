@@ -0,0 +1,77 @@
+// -*- C++ -*-
+//
+// ----------------------------------------------------------------------
+//
+//                           Brad T. Aagaard
+//                        U.S. Geological Survey
+//
+// {LicenseText}
+//
+// ----------------------------------------------------------------------
+//
+
+/** @file tests/TestQuantizer.h
+ *
+ * @brief C++ TestQuantizer object
+ *
+ * C++ unit testing for Quantizer.
+ */
+
+#if !defined(cencalvm_create_testquantizer_h)
+#define cencalvm_create_testquantizer_h
+
+#include <cppunit/extensions/HelperMacros.h>
+
+namespace cencalvm {
+  namespace create {
+    class TestQuantizer;
+  } // create
+} // cencalvm
+
+/// C++ unit testing for Quantizer
+class cencalvm::create::TestQuantizer : public CppUnit::TestFixture
+{ // class TestQuantizer
+
+  // CPPUNIT TEST SUITE /////////////////////////////////////////////////
+  CPPUNIT_TEST_SUITE( TestQuantizer );
+  CPPUNIT_TEST( testConstructor );
+  CPPUNIT_TEST( testErrorBound );
+  CPPUNIT_TEST( testQuantize );
+  CPPUNIT_TEST( testQuantizeCompact );
+  CPPUNIT_TEST_SUITE_END();
+
+  // PUBLIC METHODS /////////////////////////////////////////////////////
+public :
+
+  /// Test constructor
+  void testConstructor(void);
+
+  /// Test errorBound()
+  void testErrorBound(void);
+
+  /// Test quantize()
+  void testQuantize(void);
+
+  /// Test quantize() with compact input database
+  void testQuantizeCompact(void);
+
+  // PRIVATE METHODS ////////////////////////////////////////////////////
+private :
+
+  /// Create averaged etree database.
+  void _createDB(void) const;
+
+  // PRIVATE MEMBERS ////////////////////////////////////////////////////
+private :
+
+  static const char* _DBFILENAMELEAVES; ///< Filename of leaf database
+  static const char* _DBFILENAMEAVG; ///< Filename of averaged database
+  static const char* _DBFILENAMEOUT; ///< Filename of compact database
+  static const int _LEVEL; ///< Level of leaf octants
+  static const int _NUMPERDIM; ///< Number of leaf octants along each axis
+
+}; // class TestQuantizer
+
+#endif // cencalvm_create_testquantizer
+
+// End of file
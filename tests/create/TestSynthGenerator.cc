@@ -0,0 +1,426 @@
+// -*- C++ -*-
+//
+// ----------------------------------------------------------------------
+//
+//                           Brad T. Aagaard
+//                        U.S. Geological Survey
+//
+// {LicenseText}
+//
+// ----------------------------------------------------------------------
+//
+
+#include "TestSynthGenerator.h" // Implementation of class methods
+
+#include "cencalvm/create/SynthGenerator.h" // USES SynthGenerator
+#include "cencalvm/storage/Geometry.h" // USES Geometry
+#include "cencalvm/storage/GeomCenCA.h" // USES GeomCenCA
+#include "cencalvm/storage/Payload.h" // USES PayloadStruct
+
+extern "C" {
+#include "etree.h"
+}
+
+#include <string.h> // USES memcmp()
+#include <math.h> // USES fabs()
+#include <stdexcept> // USES std::runtime_error
+
+// ----------------------------------------------------------------------
+CPPUNIT_TEST_SUITE_REGISTRATION( cencalvm::create::TestSynthGenerator );
+
+// ----------------------------------------------------------------------
+const size_t cencalvm::create::TestSynthGenerator::_NUMOCTANTS = 20000;
+const double cencalvm::create::TestSynthGenerator::_RESOLUTION = 800.0;
+const int cencalvm::create::TestSynthGenerator::_NUMLAYERS = 3;
+const int cencalvm::create::TestSynthGenerator::_NUMBLOCKS = 4;
+
+// ----------------------------------------------------------------------
+// Test constructor
+void
+cencalvm::create::TestSynthGenerator::testConstructor(void)
+{ // testConstructor
+  SynthGenerator generator;
+} // testConstructor
+
+// ----------------------------------------------------------------------
+// Test numOctants()
+void
+cencalvm::create::TestSynthGenerator::testNumOctants(void)
+{ // testNumOctants
+  SynthGenerator generator;
+  CPPUNIT_ASSERT_EQUAL(size_t(1000000), generator._numOctants);
+
+  const size_t num = 12345;
+  generator.numOctants(num);
+  CPPUNIT_ASSERT_EQUAL(num, generator._numOctants);
+
+  generator.numOctants(0);
+  CPPUNIT_ASSERT_EQUAL(num, generator._numOctants);
+} // testNumOctants
+
+// ----------------------------------------------------------------------
+// Test resolution()
+void
+cencalvm::create::TestSynthGenerator::testResolution(void)
+{ // testResolution
+  SynthGenerator generator;
+  CPPUNIT_ASSERT_EQUAL(100.0, generator._resolution);
+
+  const double res = 200.0;
+  generator.resolution(res);
+  CPPUNIT_ASSERT_EQUAL(res, generator._resolution);
+
+  generator.resolution(-1.0);
+  CPPUNIT_ASSERT_EQUAL(res, generator._resolution);
+} // testResolution
+
+// ----------------------------------------------------------------------
+// Test numLayers()
+void
+cencalvm::create::TestSynthGenerator::testNumLayers(void)
+{ // testNumLayers
+  SynthGenerator generator;
+  CPPUNIT_ASSERT_EQUAL(4, generator._numLayers);
+
+  const int num = 2;
+  generator.numLayers(num);
+  CPPUNIT_ASSERT_EQUAL(num, generator._numLayers);
+
+  generator.numLayers(0);
+  CPPUNIT_ASSERT_EQUAL(num, generator._numLayers);
+} // testNumLayers
+
+// ----------------------------------------------------------------------
+// Test topography()
+void
+cencalvm::create::TestSynthGenerator::testTopography(void)
+{ // testTopography
+  SynthGenerator generator;
+  CPPUNIT_ASSERT_EQUAL(1500.0, generator._topography);
+
+  generator.topography(0.0);
+  CPPUNIT_ASSERT_EQUAL(0.0, generator._topography);
+
+  generator.topography(-10.0);
+  CPPUNIT_ASSERT_EQUAL(0.0, generator._topography);
+} // testTopography
+
+// ----------------------------------------------------------------------
+// Test water()
+void
+cencalvm::create::TestSynthGenerator::testWater(void)
+{ // testWater
+  SynthGenerator generator;
+  CPPUNIT_ASSERT_EQUAL(500.0, generator._water);
+
+  generator.water(0.0);
+  CPPUNIT_ASSERT_EQUAL(0.0, generator._water);
+
+  generator.water(-10.0);
+  CPPUNIT_ASSERT_EQUAL(0.0, generator._water);
+} // testWater
+
+// ----------------------------------------------------------------------
+// Test numFaultBlocks()
+void
+cencalvm::create::TestSynthGenerator::testNumFaultBlocks(void)
+{ // testNumFaultBlocks
+  SynthGenerator generator;
+  CPPUNIT_ASSERT_EQUAL(6, generator._numFaultBlocks);
+
+  const int num = 3;
+  generator.numFaultBlocks(num);
+  CPPUNIT_ASSERT_EQUAL(num, generator._numFaultBlocks);
+
+  generator.numFaultBlocks(0);
+  CPPUNIT_ASSERT_EQUAL(num, generator._numFaultBlocks);
+} // testNumFaultBlocks
+
+// ----------------------------------------------------------------------
+// Test seed()
+void
+cencalvm::create::TestSynthGenerator::testSeed(void)
+{ // testSeed
+  SynthGenerator generator;
+  CPPUNIT_ASSERT_EQUAL((unsigned long) 1, generator._seed);
+
+  const unsigned long seed = 4321;
+  generator.seed(seed);
+  CPPUNIT_ASSERT_EQUAL(seed, generator._seed);
+} // testSeed
+
+// ----------------------------------------------------------------------
+// Test _setupModel()
+void
+cencalvm::create::TestSynthGenerator::testSetupModel(void)
+{ // testSetupModel
+  SynthGenerator generator;
+  _setupGenerator(&generator);
+
+  SynthGenerator::ModelStruct model;
+  generator._setupModel(&model);
+
+  // Elevation of z coordinates in GeomCenCA.
+  const double tolerance = 1.0e-6;
+  CPPUNIT_ASSERT_DOUBLES_EQUAL(-396800.0, model.elevBase, tolerance);
+  CPPUNIT_ASSERT_DOUBLES_EQUAL(0.0, model.elev(model.z(0.0)), tolerance);
+
+  const etree_tick_t x0 = 0x20000000;
+  const etree_tick_t y0 = 0x10000000;
+  CPPUNIT_ASSERT_EQUAL(x0, model.x0);
+  CPPUNIT_ASSERT_EQUAL(y0, model.y0);
+
+  CPPUNIT_ASSERT_EQUAL(size_t(_NUMLAYERS), model.layers.size());
+  const int levelTop = 11;
+  const etree_tick_t tickCoarse = 0x80000000 >> (levelTop - _NUMLAYERS + 1);
+  for (int iLayer=0; iLayer < _NUMLAYERS; ++iLayer) {
+    const SynthGenerator::ModelStruct::LayerStruct& layer =
+      model.layers[iLayer];
+    CPPUNIT_ASSERT_EQUAL(levelTop - iLayer, layer.level);
+    CPPUNIT_ASSERT_EQUAL(etree_tick_t(0x80000000 >> layer.level),
+			 layer.tickLen);
+    CPPUNIT_ASSERT_DOUBLES_EQUAL(_RESOLUTION * (1 << iLayer), layer.edgeLen,
+				 tolerance);
+    CPPUNIT_ASSERT(layer.zBottom < layer.zTop);
+    CPPUNIT_ASSERT_EQUAL(etree_tick_t(0), layer.zBottom % tickCoarse);
+    CPPUNIT_ASSERT_EQUAL(etree_tick_t(0), layer.zTop % tickCoarse);
+    if (iLayer > 0)
+      CPPUNIT_ASSERT_EQUAL(model.layers[iLayer-1].zBottom, layer.zTop);
+  } // for
+
+  // Top layer covers topography and extends 64 octants below water.
+  CPPUNIT_ASSERT(model.elev(model.layers[0].zTop) >= generator._topography);
+  CPPUNIT_ASSERT(model.elev(model.layers[0].zBottom) <=
+		 -generator._water - 64*_RESOLUTION/4.0);
+  CPPUNIT_ASSERT(model.elev(model.layers[_NUMLAYERS-1].zBottom) <= -45000.0);
+
+  CPPUNIT_ASSERT_EQUAL(size_t(_NUMBLOCKS), model.blocks.size());
+  CPPUNIT_ASSERT_EQUAL(size_t(_NUMBLOCKS-1), model.faultPhases.size());
+
+  // Resolution must match level of geometry.
+  generator.resolution(1000.0);
+  CPPUNIT_ASSERT_THROW(generator._setupModel(&model), std::runtime_error);
+
+  // Coarsest layer must be below root level.
+  generator.resolution(_RESOLUTION);
+  generator.numLayers(levelTop+1);
+  CPPUNIT_ASSERT_THROW(generator._setupModel(&model), std::runtime_error);
+} // testSetupModel
+
+// ----------------------------------------------------------------------
+// Test _sizeModel()
+void
+cencalvm::create::TestSynthGenerator::testSizeModel(void)
+{ // testSizeModel
+  SynthGenerator generator;
+  _setupGenerator(&generator);
+
+  SynthGenerator::ModelStruct model;
+  generator._setupModel(&model);
+  generator._sizeModel(&model);
+
+  CPPUNIT_ASSERT(model.numX >= model.numY);
+  CPPUNIT_ASSERT_EQUAL(generator._countOctants(model), model.numOctants);
+  const double tolerance = 0.1;
+  CPPUNIT_ASSERT_DOUBLES_EQUAL(1.0, double(model.numOctants) / _NUMOCTANTS,
+			       tolerance);
+
+  // Region must fit in geometry.
+  generator.numOctants(size_t(1) << 50);
+  CPPUNIT_ASSERT_THROW(generator._sizeModel(&model), std::runtime_error);
+} // testSizeModel
+
+// ----------------------------------------------------------------------
+// Test region()
+void
+cencalvm::create::TestSynthGenerator::testRegion(void)
+{ // testRegion
+  SynthGenerator generator;
+  _setupGenerator(&generator);
+
+  SynthGenerator::ModelStruct model;
+  generator._setupModel(&model);
+  generator._sizeModel(&model);
+
+  etree_tick_t x0 = 0;
+  etree_tick_t y0 = 0;
+  etree_tick_t lenX = 0;
+  etree_tick_t lenY = 0;
+  generator.region(&x0, &y0, &lenX, &lenY);
+
+  const etree_tick_t tickCoarse = model.layers.back().tickLen;
+  CPPUNIT_ASSERT_EQUAL(model.x0, x0);
+  CPPUNIT_ASSERT_EQUAL(model.y0, y0);
+  CPPUNIT_ASSERT_EQUAL(model.numX * tickCoarse, lenX);
+  CPPUNIT_ASSERT_EQUAL(model.numY * tickCoarse, lenY);
+} // testRegion
+
+// ----------------------------------------------------------------------
+// Test run()
+void
+cencalvm::create::TestSynthGenerator::testRun(void)
+{ // testRun
+  const char* filenameOut = "data/synth.etree";
+  const char* filenameTmp = "data/synthtmp.etree";
+
+  SynthGenerator generator;
+  _setupGenerator(&generator);
+  generator.filenameOut(filenameOut);
+  generator.filenameTmp(filenameTmp);
+  generator.run();
+
+  SynthGenerator::ModelStruct model;
+  generator._setupModel(&model);
+  generator._sizeModel(&model);
+  _checkDB(filenameOut, model.numOctants);
+} // testRun
+
+// ----------------------------------------------------------------------
+// Test run() with sorted bulk loading
+void
+cencalvm::create::TestSynthGenerator::testRunSorted(void)
+{ // testRunSorted
+  const char* filenameRef = "data/synthref.etree";
+  const char* filenameOut = "data/synthsorted.etree";
+  const char* filenameTmp = "data/synthtmp.etree";
+
+  { // reference
+    SynthGenerator generator;
+    _setupGenerator(&generator);
+    generator.filenameOut(filenameRef);
+    generator.filenameTmp(filenameTmp);
+    generator.run();
+  } // reference
+
+  SynthGenerator generator;
+  _setupGenerator(&generator);
+  generator.filenameOut(filenameOut);
+  generator.filenameTmp(filenameTmp);
+  generator.sortSize(1);
+  generator.run();
+
+  // Sorting must not change the model.
+  _checkSameDB(filenameOut, filenameRef);
+} // testRunSorted
+
+// ----------------------------------------------------------------------
+// Setup generator for small model.
+void
+cencalvm::create::TestSynthGenerator::_setupGenerator(SynthGenerator* pGenerator)
+{ // _setupGenerator
+  CPPUNIT_ASSERT(0 != pGenerator);
+
+  storage::GeomCenCA geometry;
+  pGenerator->geometry(&geometry);
+  pGenerator->numOctants(_NUMOCTANTS);
+  pGenerator->resolution(_RESOLUTION);
+  pGenerator->numLayers(_NUMLAYERS);
+  pGenerator->numFaultBlocks(_NUMBLOCKS);
+  pGenerator->seed(7);
+  pGenerator->quiet(true);
+} // _setupGenerator
+
+// ----------------------------------------------------------------------
+// Check contents of database created by run().
+void
+cencalvm::create::TestSynthGenerator::_checkDB(const char* filename,
+					       const size_t numOctants) const
+{ // _checkDB
+  etree_t* db = etree_open(filename, O_RDONLY, 0, 0, 0);
+  CPPUNIT_ASSERT(0 != db);
+
+  etree_addr_t addr;
+  addr.x = 0;
+  addr.y = 0;
+  addr.z = 0;
+  addr.t = 0;
+  addr.level = 0;
+  CPPUNIT_ASSERT(0 == etree_initcursor(db, addr));
+
+  const int levelTop = 11;
+  const int numZones = 3;
+  size_t numZone[numZones] = { 0, 0, 0 };
+  size_t count = 0;
+  etree_addr_t addrPrev;
+  bool more = true;
+  while (more) {
+    storage::PayloadStruct payload;
+    CPPUNIT_ASSERT(0 == etree_getcursor(db, &addr, "*", &payload));
+
+    // Octants are leaves of layers and never overlap.
+    CPPUNIT_ASSERT(addr.level <= levelTop);
+    CPPUNIT_ASSERT(addr.level > levelTop - _NUMLAYERS);
+    if (count > 0) {
+      CPPUNIT_ASSERT(storage::Geometry::precedes(addrPrev, addr));
+      CPPUNIT_ASSERT(!storage::Geometry::contains(addrPrev, addr));
+    } // if
+    addrPrev = addr;
+
+    CPPUNIT_ASSERT(payload.FaultBlock >= 1);
+    CPPUNIT_ASSERT(payload.FaultBlock <= _NUMBLOCKS);
+    CPPUNIT_ASSERT(payload.Zone >= 1);
+    CPPUNIT_ASSERT(payload.Zone <= numZones);
+    CPPUNIT_ASSERT(payload.DepthFreeSurf >= 0.0);
+    if (1 == payload.Zone) { // water
+      CPPUNIT_ASSERT_EQUAL(float(0.0), payload.Vs);
+      CPPUNIT_ASSERT_EQUAL(float(1000.0), payload.Density);
+      CPPUNIT_ASSERT_EQUAL(levelTop, addr.level);
+    } else {
+      CPPUNIT_ASSERT(payload.Vs > 0.0);
+      CPPUNIT_ASSERT(payload.Vp > payload.Vs);
+      CPPUNIT_ASSERT(payload.Density > 1000.0);
+      CPPUNIT_ASSERT(payload.Qs > 0.0);
+    } // if/else
+    ++numZone[payload.Zone-1];
+
+    ++count;
+    more = (0 == etree_advcursor(db));
+  } // while
+  CPPUNIT_ASSERT_EQUAL(numOctants, count);
+
+  // Model has water, sediments, and basement.
+  for (int iZone=0; iZone < numZones; ++iZone)
+    CPPUNIT_ASSERT(numZone[iZone] > 0);
+
+  CPPUNIT_ASSERT(0 == etree_close(db));
+} // _checkDB
+
+// ----------------------------------------------------------------------
+// Check that database matches reference database.
+void
+cencalvm::create::TestSynthGenerator::_checkSameDB(const char* filename,
+						   const char* filenameRef) const
+{ // _checkSameDB
+  etree_t* dbRef = etree_open(filenameRef, O_RDONLY, 0, 0, 0);
+  CPPUNIT_ASSERT(0 != dbRef);
+  etree_t* db = etree_open(filename, O_RDONLY, 0, 0, 0);
+  CPPUNIT_ASSERT(0 != db);
+  etree_addr_t addr;
+  addr.x = 0;
+  addr.y = 0;
+  addr.z = 0;
+  addr.t = 0;
+  addr.level = 0;
+  etree_addr_t addrRef = addr;
+  CPPUNIT_ASSERT(0 == etree_initcursor(dbRef, addrRef));
+  CPPUNIT_ASSERT(0 == etree_initcursor(db, addr));
+  bool more = true;
+  while (more) {
+    storage::PayloadStruct payloadRef;
+    storage::PayloadStruct payload;
+    CPPUNIT_ASSERT(0 == etree_getcursor(dbRef, &addrRef, "*", &payloadRef));
+    CPPUNIT_ASSERT(0 == etree_getcursor(db, &addr, "*", &payload));
+    CPPUNIT_ASSERT_EQUAL(addrRef.x, addr.x);
+    CPPUNIT_ASSERT_EQUAL(addrRef.y, addr.y);
+    CPPUNIT_ASSERT_EQUAL(addrRef.z, addr.z);
+    CPPUNIT_ASSERT_EQUAL(addrRef.level, addr.level);
+    CPPUNIT_ASSERT(0 == memcmp(&payloadRef, &payload, sizeof(payload)));
+    more = (0 == etree_advcursor(dbRef));
+    CPPUNIT_ASSERT_EQUAL(more, 0 == etree_advcursor(db));
+  } // while
+
+  CPPUNIT_ASSERT(0 == etree_close(db));
+  CPPUNIT_ASSERT(0 == etree_close(dbRef));
+} // _checkSameDB
+
+// End of file
@@ -0,0 +1,134 @@
+// -*- C++ -*-
+//
+// ----------------------------------------------------------------------
+//
+//                           Brad T. Aagaard
+//                        U.S. Geological Survey
+//
+// {LicenseText}
+//
+// ----------------------------------------------------------------------
+//
+
+/** @file tests/TestSynthGenerator.h
+ *
+ * @brief C++ TestSynthGenerator object
+ *
+ * C++ unit testing for SynthGenerator.
+ */
+
+#if !defined(cencalvm_create_testsynthgenerator_h)
+#define cencalvm_create_testsynthgenerator_h
+
+#include <cppunit/extensions/HelperMacros.h>
+
+#include <sys/types.h> // USES size_t
+
+namespace cencalvm {
+  namespace create {
+    class TestSynthGenerator;
+    class SynthGenerator; // USES SynthGenerator
+  } // create
+} // cencalvm
+
+/// C++ unit testing for SynthGenerator
+class cencalvm::create::TestSynthGenerator : public CppUnit::TestFixture
+{ // class TestSynthGenerator
+
+  // CPPUNIT TEST SUITE /////////////////////////////////////////////////
+  CPPUNIT_TEST_SUITE( TestSynthGenerator );
+  CPPUNIT_TEST( testConstructor );
+  CPPUNIT_TEST( testNumOctants );
+  CPPUNIT_TEST( testResolution );
+  CPPUNIT_TEST( testNumLayers );
+  CPPUNIT_TEST( testTopography );
+  CPPUNIT_TEST( testWater );
+  CPPUNIT_TEST( testNumFaultBlocks );
+  CPPUNIT_TEST( testSeed );
+  CPPUNIT_TEST( testSetupModel );
+  CPPUNIT_TEST( testSizeModel );
+  CPPUNIT_TEST( testRegion );
+  CPPUNIT_TEST( testRun );
+  CPPUNIT_TEST( testRunSorted );
+  CPPUNIT_TEST_SUITE_END();
+
+  // PUBLIC METHODS /////////////////////////////////////////////////////
+public :
+
+  /// Test constructor
+  void testConstructor(void);
+
+  /// Test numOctants()
+  void testNumOctants(void);
+
+  /// Test resolution()
+  void testResolution(void);
+
+  /// Test numLayers()
+  void testNumLayers(void);
+
+  /// Test topography()
+  void testTopography(void);
+
+  /// Test water()
+  void testWater(void);
+
+  /// Test numFaultBlocks()
+  void testNumFaultBlocks(void);
+
+  /// Test seed()
+  void testSeed(void);
+
+  /// Test _setupModel()
+  void testSetupModel(void);
+
+  /// Test _sizeModel()
+  void testSizeModel(void);
+
+  /// Test region()
+  void testRegion(void);
+
+  /// Test run()
+  void testRun(void);
+
+  /// Test run() with sorted bulk loading
+  void testRunSorted(void);
+
+  // PRIVATE METHODS ////////////////////////////////////////////////////
+private :
+
+  /** Setup generator for small model.
+   *
+   * @param pGenerator Pointer to generator
+   */
+  static void _setupGenerator(SynthGenerator* pGenerator);
+
+  /** Check contents of database created by run().
+   *
+   * @param filename Name of database file
+   * @param numOctants Number of octants expected in database
+   */
+  void _checkDB(const char* filename,
+		const size_t numOctants) const;
+
+  /** Check that database matches reference database.
+   *
+   * @param filename Name of database file
+   * @param filenameRef Name of reference database file
+   */
+  void _checkSameDB(const char* filename,
+		    const char* filenameRef) const;
+
+  // PRIVATE MEMBERS ////////////////////////////////////////////////////
+private :
+
+  static const size_t _NUMOCTANTS; ///< Target number of octants
+  static const double _RESOLUTION; ///< Resolution at surface
+  static const int _NUMLAYERS; ///< Number of layers
+  static const int _NUMBLOCKS; ///< Number of fault blocks
+
+}; // class TestSynthGenerator
+
+#endif // cencalvm_create_testsynthgenerator_h
+
+// End of file
@@ -13,6 +13,7 @@
 #include "TestVMCreator.h" // Implementation of class methods
 
 #include "cencalvm/create/VMCreator.h" // USES VMCreator
+#include "cencalvm/average/Averager.h" // USES Averager
 #include "cencalvm/storage/Geometry.h" // USES GeomCenCA
 #include "cencalvm/storage/GeomCenCA.h" // USES GeomCenCA
 
@@ -20,6 +21,11 @@ extern "C" {
 #include "etree.h"
 }
 
+#include <vector> // USES std::vector
+#include <algorithm> // USES std::sort()
+#include <string.h> // USES memcmp(), strstr()
+#include <stdlib.h> // USES free()
+
 #include <stdexcept> // USES std::runtime_error
 #include <sstream> // USES std::ostringstream
 
@@ -135,6 +141,185 @@ cencalvm::create::TestVMCreator::testPackDB(void)
   CPPUNIT_ASSERT_EQUAL(_PAYLOAD.Zone, payload.Zone);
 } // testPackDB
 
+// ----------------------------------------------------------------------
+// Test packDB() with several reading threads
+void
+cencalvm::create::TestVMCreator::testPackDBThreads(void)
+{ // testPackDBThreads
+  const char* filenamePacked = _FILENAMEIN;
+  const char* filenameUnpacked = _FILENAMETMP;
+  const int cacheSize = 2;
+  const char* description = "Hello";
+
+  VMCreator creator;
+  creator.quiet(true);
+  creator.numThreads(3);
+
+  creator.openDB(filenameUnpacked, cacheSize, description);
+
+  // Octants spread over the key space, so they fall in many of the
+  // ranges read by different threads. Insert in reverse order, so
+  // the unpacked database is not in etree order.
+  const int level = 4;
+  const int numPerDim = 1 << level;
+  const etree_tick_t tickLen = 0x80000000 >> level;
+  std::vector<etree_addr_t> addrs;
+  for (int iz=numPerDim-1; iz >= 0; iz -= 3)
+    for (int iy=numPerDim-1; iy >= 0; iy -= 3)
+      for (int ix=numPerDim-1; ix >= 0; ix -= 3) {
+	etree_addr_t addr;
+	addr.x = ix*tickLen;
+	addr.y = iy*tickLen;
+	addr.z = iz*tickLen;
+	addr.t = 0;
+	addr.level = level;
+	addrs.push_back(addr);
+      } // for
+  // Coarser octant at same corner as partition of key space
+  etree_addr_t addrCoarse;
+  addrCoarse.x = 0;
+  addrCoarse.y = 0;
+  addrCoarse.z = 0x40000000;
+  addrCoarse.t = 0;
+  addrCoarse.level = 1;
+  addrs.push_back(addrCoarse);
+
+  const int numOctants = addrs.size();
+  for (int i=0; i < numOctants; ++i) {
+    storage::PayloadStruct payload = _PAYLOAD;
+    payload.Vp = addrs[i].x / tickLen;
+    payload.Vs = addrs[i].y / tickLen;
+    payload.Density = addrs[i].z / tickLen;
+    payload.Qp = addrs[i].level;
+    creator.insert(payload, addrs[i]);
+  } // for
+  creator.closeDB();
+  creator.packDB(filenamePacked, filenameUnpacked, cacheSize);
+
+  std::sort(addrs.begin(), addrs.end(), storage::Geometry::precedes);
+
+  etree_t* db = etree_open(filenamePacked, O_RDONLY, 0, 0, 0);
+  if (0 == db) {
+    std::ostringstream msg;
+    msg << "Could not open etree database '" << filenamePacked << "'.";
+    throw std::runtime_error(msg.str());
+  } // if
+
+  etree_addr_t addr;
+  addr.x = 0;
+  addr.y = 0;
+  addr.z = 0;
+  addr.t = 0;
+  addr.level = 0;
+  int count = 0;
+  bool more = (0 == etree_initcursor(db, addr));
+  while (more) {
+    storage::PayloadStruct payload;
+    if (0 != etree_getcursor(db, &addr, "*", &payload))
+      throw std::runtime_error(etree_strerror(etree_errno(db)));
+    CPPUNIT_ASSERT(count < numOctants);
+    CPPUNIT_ASSERT_EQUAL(addrs[count].x, addr.x);
+    CPPUNIT_ASSERT_EQUAL(addrs[count].y, addr.y);
+    CPPUNIT_ASSERT_EQUAL(addrs[count].z, addr.z);
+    CPPUNIT_ASSERT_EQUAL(addrs[count].level, addr.level);
+    CPPUNIT_ASSERT_EQUAL(float(addr.x / tickLen), payload.Vp);
+    CPPUNIT_ASSERT_EQUAL(float(addr.y / tickLen), payload.Vs);
+    CPPUNIT_ASSERT_EQUAL(float(addr.z / tickLen), payload.Density);
+    CPPUNIT_ASSERT_EQUAL(float(addr.level), payload.Qp);
+    ++count;
+    more = (0 == etree_advcursor(db));
+  } // while
+  CPPUNIT_ASSERT_EQUAL(numOctants, count);
+
+  etree_close(db);
+} // testPackDBThreads
+
+// ----------------------------------------------------------------------
+// Test packDB() with octants in a small part of the key space
+void
+cencalvm::create::TestVMCreator::testPackDBSparse(void)
+{ // testPackDBSparse
+  const char* filenamePacked = _FILENAMEIN;
+  const char* filenameUnpacked = _FILENAMETMP;
+  const int cacheSize = 2;
+  const char* description = "Hello";
+
+  VMCreator creator;
+  creator.quiet(true);
+  creator.numThreads(4);
+
+  creator.openDB(filenameUnpacked, cacheSize, description);
+
+  // Octants fill a single octant at level 10, which would fall in one
+  // range if the root octant were split at a fixed level.
+  const int level = 12;
+  const int numPerDim = 4;
+  const etree_tick_t tickLen = 0x80000000 >> level;
+  const etree_tick_t origin = 0x12400000;
+  std::vector<etree_addr_t> addrs;
+  for (int iz=numPerDim-1; iz >= 0; --iz)
+    for (int iy=numPerDim-1; iy >= 0; --iy)
+      for (int ix=numPerDim-1; ix >= 0; --ix) {
+	etree_addr_t addr;
+	addr.x = origin + ix*tickLen;
+	addr.y = origin + iy*tickLen;
+	addr.z = origin + iz*tickLen;
+	addr.t = 0;
+	addr.level = level;
+	addrs.push_back(addr);
+      } // for
+  const int numOctants = addrs.size();
+  for (int i=0; i < numOctants; ++i)
+    creator.insert(_PAYLOAD, addrs[i]);
+  creator.closeDB();
+
+  // Every range contains octants.
+  etree_t* db = etree_open(filenameUnpacked, O_RDONLY, 0, 0, 0);
+  CPPUNIT_ASSERT(0 != db);
+  const size_t numRanges = 16;
+  std::vector<etree_addr_t> splits;
+  VMCreator::_splitKeys(&splits, db, numRanges);
+  CPPUNIT_ASSERT(splits.size() >= numRanges);
+  for (size_t i=0; i < splits.size(); ++i) {
+    etree_addr_t addr = splits[i];
+    CPPUNIT_ASSERT(0 == etree_initcursor(db, addr));
+    storage::PayloadStruct payload;
+    CPPUNIT_ASSERT(0 == etree_getcursor(db, &addr, "*", &payload));
+    if (i+1 < splits.size())
+      CPPUNIT_ASSERT(storage::Geometry::precedes(addr, splits[i+1]));
+  } // for
+  etree_close(db);
+
+  creator.packDB(filenamePacked, filenameUnpacked, cacheSize);
+
+  std::sort(addrs.begin(), addrs.end(), storage::Geometry::precedes);
+
+  db = etree_open(filenamePacked, O_RDONLY, 0, 0, 0);
+  CPPUNIT_ASSERT(0 != db);
+  etree_addr_t addr;
+  addr.x = 0;
+  addr.y = 0;
+  addr.z = 0;
+  addr.t = 0;
+  addr.level = 0;
+  int count = 0;
+  bool more = (0 == etree_initcursor(db, addr));
+  while (more) {
+    storage::PayloadStruct payload;
+    CPPUNIT_ASSERT(0 == etree_getcursor(db, &addr, "*", &payload));
+    CPPUNIT_ASSERT(count < numOctants);
+    CPPUNIT_ASSERT_EQUAL(addrs[count].x, addr.x);
+    CPPUNIT_ASSERT_EQUAL(addrs[count].y, addr.y);
+    CPPUNIT_ASSERT_EQUAL(addrs[count].z, addr.z);
+    CPPUNIT_ASSERT_EQUAL(addrs[count].level, addr.level);
+    ++count;
+    more = (0 == etree_advcursor(db));
+  } // while
+  CPPUNIT_ASSERT_EQUAL(numOctants, count);
+
+  etree_close(db);
+} // testPackDBSparse
+
 // ----------------------------------------------------------------------
 // Test insert()
 void 
@@ -199,6 +384,189 @@ cencalvm::create::TestVMCreator::testInsert(void)
   CPPUNIT_ASSERT_EQUAL(_PAYLOAD.Zone, payload.Zone);
 } // testInsert
 
+// ----------------------------------------------------------------------
+// Test openSortedDB()
+void 
+cencalvm::create::TestVMCreator::testOpenSortedDB(void)
+{ // testOpenSortedDB
+  const char* filename = _FILENAMEIN;
+  const char* filenameTmp = _FILENAMETMP;
+  const char* description = "Hello";
+  const int cacheSize = 2;
+  const int sortSize = 1;
+
+  VMCreator creator;
+  creator.quiet(true);
+
+  creator.openSortedDB(filename, cacheSize, description, filenameTmp,
+		       sortSize);
+  CPPUNIT_ASSERT(0 != creator._pSorter);
+
+  // Insert children of an octant in reverse etree order.
+  const etree_tick_t level = 3;
+  const etree_tick_t tickLen = 0x80000000 >> level;
+  const int numChildren = 8;
+  for (int iChild=numChildren-1; iChild >= 0; --iChild) {
+    etree_addr_t addr;
+    addr.x = tickLen * (iChild & 1);
+    addr.y = tickLen * ((iChild >> 1) & 1);
+    addr.z = tickLen * ((iChild >> 2) & 1);
+    addr.t = 0;
+    addr.level = level;
+    addr.type = ETREE_LEAF;
+    storage::PayloadStruct payload = _PAYLOAD;
+    payload.Vp = iChild;
+    creator.insert(payload, addr);
+  } // for
+  creator.closeDB();
+  CPPUNIT_ASSERT(0 == creator._pSorter);
+
+  etree_t* db = etree_open(filename, O_RDONLY, 0, 0, 0);
+  if (0 == db) {
+    std::ostringstream msg;
+    msg << "Could not open etree database '" << filename << "'.";
+    throw std::runtime_error(msg.str());
+  } // if
+
+  etree_addr_t addr;
+  addr.x = 0;
+  addr.y = 0;
+  addr.z = 0;
+  addr.level = 0;
+  if (0 != etree_initcursor(db, addr))
+    throw std::runtime_error(etree_strerror(etree_errno(db)));
+  int iChild = 0;
+  do {
+    storage::PayloadStruct payload;
+    if (0 != etree_getcursor(db, &addr, "*", &payload))
+      throw std::runtime_error(etree_strerror(etree_errno(db)));
+    CPPUNIT_ASSERT(iChild < numChildren);
+    CPPUNIT_ASSERT_EQUAL(tickLen * (iChild & 1), addr.x);
+    CPPUNIT_ASSERT_EQUAL(tickLen * ((iChild >> 1) & 1), addr.y);
+    CPPUNIT_ASSERT_EQUAL(tickLen * ((iChild >> 2) & 1), addr.z);
+    CPPUNIT_ASSERT_EQUAL(float(iChild), payload.Vp);
+    CPPUNIT_ASSERT_EQUAL(_PAYLOAD.Zone, payload.Zone);
+    ++iChild;
+  } while (0 == etree_advcursor(db));
+  CPPUNIT_ASSERT_EQUAL(numChildren, iChild);
+
+  etree_close(db);
+} // testOpenSortedDB
+
+// ----------------------------------------------------------------------
+// Test openAveragedDB()
+void
+cencalvm::create::TestVMCreator::testOpenAveragedDB(void)
+{ // testOpenAveragedDB
+  const char* description = "Hello";
+  const int cacheSize = 2;
+  const int sortSize = 1;
+  const int bufferSize = 4;
+
+  // Children of an octant in reverse etree order followed by a coarser
+  // leaf octant in front of them.
+  const etree_tick_t level = 3;
+  const etree_tick_t tickLen = 0x80000000 >> level;
+  const int numChildren = 8;
+  std::vector<etree_addr_t> addrs;
+  std::vector<storage::PayloadStruct> payloads;
+  for (int iChild=numChildren-1; iChild >= 0; --iChild) {
+    etree_addr_t addr;
+    addr.x = tickLen * (iChild & 1);
+    addr.y = tickLen * ((iChild >> 1) & 1);
+    addr.z = tickLen * ((iChild >> 2) & 1);
+    addr.t = 0;
+    addr.level = level;
+    addr.type = ETREE_LEAF;
+    storage::PayloadStruct payload = _PAYLOAD;
+    payload.Vp = iChild;
+    payload.Vs = 0.5 * iChild;
+    addrs.push_back(addr);
+    payloads.push_back(payload);
+  } // for
+  etree_addr_t addrCoarse;
+  addrCoarse.x = 2 * tickLen;
+  addrCoarse.y = 0;
+  addrCoarse.z = 0;
+  addrCoarse.t = 0;
+  addrCoarse.level = level - 1;
+  addrCoarse.type = ETREE_LEAF;
+  addrs.push_back(addrCoarse);
+  payloads.push_back(_PAYLOAD);
+  const int numLeaves = addrs.size();
+
+  { // Reference: sorted database averaged separately
+    VMCreator creator;
+    creator.quiet(true);
+    creator.openSortedDB(_FILENAMEIN, cacheSize, description, _FILENAMETMP,
+			 sortSize);
+    for (int i=0; i < numLeaves; ++i)
+      creator.insert(payloads[i], addrs[i]);
+    creator.closeDB();
+
+    average::Averager averager;
+    averager.filenameIn(_FILENAMEIN);
+    averager.filenameOut(_FILENAMEAVGREF);
+    averager.bufferSize(bufferSize);
+    averager.quiet(true);
+    averager.average();
+  } // Reference
+
+  VMCreator creator;
+  creator.quiet(true);
+  creator.openAveragedDB(_FILENAMEAVG, cacheSize, description, _FILENAMETMP,
+			 sortSize, bufferSize);
+  CPPUNIT_ASSERT(0 != creator._pSorter);
+  CPPUNIT_ASSERT_EQUAL(bufferSize, creator._bufferSize);
+  for (int i=0; i < numLeaves; ++i)
+    creator.insert(payloads[i], addrs[i]);
+  creator.closeDB();
+  CPPUNIT_ASSERT(0 == creator._pSorter);
+  CPPUNIT_ASSERT_EQUAL(0, creator._bufferSize);
+
+  etree_t* dbRef = etree_open(_FILENAMEAVGREF, O_RDONLY, 0, 0, 0);
+  CPPUNIT_ASSERT(0 != dbRef);
+  etree_t* db = etree_open(_FILENAMEAVG, O_RDONLY, 0, 0, 0);
+  CPPUNIT_ASSERT(0 != db);
+
+  char* appmeta = etree_getappmeta(db);
+  CPPUNIT_ASSERT(0 != appmeta);
+  CPPUNIT_ASSERT(0 != strstr(appmeta, "spatially averaged on: "));
+  free(appmeta);
+
+  etree_addr_t addr;
+  addr.x = 0;
+  addr.y = 0;
+  addr.z = 0;
+  addr.t = 0;
+  addr.level = 0;
+  etree_addr_t addrRef = addr;
+  CPPUNIT_ASSERT(0 == etree_initcursor(dbRef, addrRef));
+  CPPUNIT_ASSERT(0 == etree_initcursor(db, addr));
+  int numOctants = 0;
+  bool more = true;
+  while (more) {
+    storage::PayloadStruct payloadRef;
+    storage::PayloadStruct payload;
+    CPPUNIT_ASSERT(0 == etree_getcursor(dbRef, &addrRef, "*", &payloadRef));
+    CPPUNIT_ASSERT(0 == etree_getcursor(db, &addr, "*", &payload));
+    CPPUNIT_ASSERT_EQUAL(addrRef.x, addr.x);
+    CPPUNIT_ASSERT_EQUAL(addrRef.y, addr.y);
+    CPPUNIT_ASSERT_EQUAL(addrRef.z, addr.z);
+    CPPUNIT_ASSERT_EQUAL(addrRef.level, addr.level);
+    CPPUNIT_ASSERT_EQUAL(addrRef.type, addr.type);
+    CPPUNIT_ASSERT(0 == memcmp(&payloadRef, &payload, sizeof(payload)));
+    ++numOctants;
+    more = (0 == etree_advcursor(dbRef));
+    CPPUNIT_ASSERT_EQUAL(more, 0 == etree_advcursor(db));
+  } // while
+  // Leaves and their interior ancestors up to the root
+  CPPUNIT_ASSERT_EQUAL(numLeaves + int(level), numOctants);
+
+  etree_close(db);
+  etree_close(dbRef);
+} // testOpenAveragedDB
+
 // ----------------------------------------------------------------------
 // Test quiet()
 void
@@ -212,6 +580,21 @@ cencalvm::create::TestVMCreator::testQuiet(void)
   CPPUNIT_ASSERT(!creator._quiet);
 } // testQuiet
 
+// ----------------------------------------------------------------------
+// Test numThreads()
+void
+cencalvm::create::TestVMCreator::testNumThreads(void)
+{ // testNumThreads
+  VMCreator creator;
+  CPPUNIT_ASSERT_EQUAL(1, creator._numThreads); // default is one thread
+  creator.numThreads(4);
+  CPPUNIT_ASSERT_EQUAL(4, creator._numThreads);
+  creator.numThreads(0);
+  CPPUNIT_ASSERT_EQUAL(0, creator._numThreads);
+  creator.numThreads(-1);
+  CPPUNIT_ASSERT_EQUAL(0, creator._numThreads);
+} // testNumThreads
+
 // version
 // $Id$
 
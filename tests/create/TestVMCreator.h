@@ -41,8 +41,13 @@ class cencalvm::create::TestVMCreator : public CppUnit::TestFixture
   CPPUNIT_TEST( testOpenDB );
   CPPUNIT_TEST( testCloseDB );
   CPPUNIT_TEST( testPackDB );
+  CPPUNIT_TEST( testPackDBThreads );
+  CPPUNIT_TEST( testPackDBSparse );
   CPPUNIT_TEST( testInsert );
+  CPPUNIT_TEST( testOpenSortedDB );
+  CPPUNIT_TEST( testOpenAveragedDB );
   CPPUNIT_TEST( testQuiet );
+  CPPUNIT_TEST( testNumThreads );
   CPPUNIT_TEST_SUITE_END();
 
   // PUBLIC METHODS /////////////////////////////////////////////////////
@@ -60,17 +65,34 @@ public :
   /// Test packDB()
   void testPackDB(void);
 
+  /// Test packDB() with several reading threads
+  void testPackDBThreads(void);
+
+  /// Test packDB() with octants in a small part of the key space
+  void testPackDBSparse(void);
+
   /// Test insert()
   void testInsert(void);
 
+  /// Test openSortedDB()
+  void testOpenSortedDB(void);
+
+  /// Test openAveragedDB()
+  void testOpenAveragedDB(void);
+
   /// Test quiet()
   void testQuiet(void);
 
+  /// Test numThreads()
+  void testNumThreads(void);
+
   // PRIVATE METHODS ////////////////////////////////////////////////////
 private :
 
   static const char* _FILENAMETMP; ///< Name of temporary db file
   static const char* _FILENAMEIN; ///< Name of existing db test file
+  static const char* _FILENAMEAVG; ///< Name of averaged db test file
+  static const char* _FILENAMEAVGREF; ///< Name of db averaged separately
 
   static const cencalvm::storage::PayloadStruct _PAYLOAD; ///< Payload in db
   static const double _LONLATELEV[]; ///< Lon/Lat/Elev of test location
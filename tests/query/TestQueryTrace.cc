@@ -0,0 +1,222 @@
+// -*- C++ -*-
+//
+// ----------------------------------------------------------------------
+//
+//                           Brad T. Aagaard
+//                        U.S. Geological Survey
+//
+// {LicenseText}
+//
+// ----------------------------------------------------------------------
+//
+
+#include "TestQueryTrace.h" // Implementation of class methods
+
+#include "cencalvm/query/QueryTrace.h" // USES QueryTrace
+
+#include <stdexcept> // USES std::runtime_error
+#include <fstream> // USES std::ofstream
+#include <string.h> // USES strcmp()
+#include <stdio.h> // USES fseek(), ftell()
+
+// ----------------------------------------------------------------------
+CPPUNIT_TEST_SUITE_REGISTRATION( cencalvm::query::TestQueryTrace );
+
+// ----------------------------------------------------------------------
+const char* cencalvm::query::TestQueryTrace::_FILENAME = 
+  "data/test.trace";
+const char* cencalvm::query::TestQueryTrace::_FILENAMEBAD = 
+  "data/bad.trace";
+
+// ----------------------------------------------------------------------
+// Test constructor
+void
+cencalvm::query::TestQueryTrace::testConstructor(void)
+{ // testConstructor
+  QueryTrace trace;
+  CPPUNIT_ASSERT(0 == trace._fp);
+  CPPUNIT_ASSERT(!trace._isWriting);
+  CPPUNIT_ASSERT(!trace._hasState);
+} // testConstructor
+
+// ----------------------------------------------------------------------
+// Test write() and read()
+void
+cencalvm::query::TestQueryTrace::testWriteRead(void)
+{ // testWriteRead
+  const int numQueries = 3;
+  const double coords[] = {
+    -122.0, 37.5, -100.0,
+    -121.5, 37.0, -2500.0,
+    -121.0, 38.0, 200.0,
+  };
+
+  QueryTraceStateStruct state;
+  state.queryType = 1;
+  state.squash = 1;
+  state.queryRes = 400.0;
+  state.squashLimit = -2000.0;
+  state.vals.push_back(1);
+  state.vals.push_back(0);
+  state.vals.push_back(8);
+
+  QueryTrace trace;
+  trace.create(_FILENAME);
+  CPPUNIT_ASSERT(trace._isWriting);
+  for (int iQuery=0, i=0; iQuery < numQueries; ++iQuery, i+=3)
+    trace.write(state, coords[i], coords[i+1], coords[i+2]);
+  trace.close();
+  CPPUNIT_ASSERT(0 == trace._fp);
+
+  trace.open(_FILENAME);
+  const QueryTraceHeaderStruct& header = trace.header();
+  CPPUNIT_ASSERT(0 == strcmp(QueryTrace::MAGIC, header.magic));
+  CPPUNIT_ASSERT_EQUAL(QueryTrace::VERSION, header.version);
+  CPPUNIT_ASSERT_EQUAL(QueryTrace::BYTEORDER, header.byteOrder);
+  CPPUNIT_ASSERT(header.startTime > 0);
+
+  QueryTraceQueryStruct query;
+  QueryTraceStateStruct stateR;
+  uint64_t timePrev = 0;
+  for (int iQuery=0, i=0; iQuery < numQueries; ++iQuery, i+=3) {
+    CPPUNIT_ASSERT(trace.read(&query, &stateR));
+    CPPUNIT_ASSERT_EQUAL(coords[i  ], query.lon);
+    CPPUNIT_ASSERT_EQUAL(coords[i+1], query.lat);
+    CPPUNIT_ASSERT_EQUAL(coords[i+2], query.elev);
+    CPPUNIT_ASSERT(query.time >= timePrev);
+    timePrev = query.time;
+
+    CPPUNIT_ASSERT_EQUAL(state.queryType, stateR.queryType);
+    CPPUNIT_ASSERT_EQUAL(state.squash, stateR.squash);
+    CPPUNIT_ASSERT_EQUAL(state.queryRes, stateR.queryRes);
+    CPPUNIT_ASSERT_EQUAL(state.squashLimit, stateR.squashLimit);
+    CPPUNIT_ASSERT(state.vals == stateR.vals);
+  } // for
+  CPPUNIT_ASSERT(!trace.read(&query, &stateR));
+  trace.close();
+} // testWriteRead
+
+// ----------------------------------------------------------------------
+// Test writing state only when it changes
+void
+cencalvm::query::TestQueryTrace::testState(void)
+{ // testState
+  QueryTraceStateStruct stateA;
+  stateA.queryType = 0;
+  stateA.squash = 0;
+  stateA.queryRes = 0.0;
+  stateA.squashLimit = -2000.0;
+  for (int iVal=0; iVal < 9; ++iVal)
+    stateA.vals.push_back(iVal);
+  QueryTraceStateStruct stateB = stateA;
+  stateB.queryType = 2;
+  stateB.queryRes = 1.0;
+
+  QueryTrace trace;
+  trace.create(_FILENAME);
+  trace.write(stateA, -122.0, 37.0, 0.0);
+  trace.write(stateA, -122.0, 37.0, -10.0);
+  trace.close();
+
+  // Header, one state record, and two query records.
+  const long sizeState = 1 + 3*sizeof(int32_t) + 2*sizeof(double) +
+    stateA.vals.size()*sizeof(int32_t);
+  const long sizeQuery = 1 + sizeof(QueryTraceQueryStruct);
+  FILE* fp = fopen(_FILENAME, "rb");
+  CPPUNIT_ASSERT(0 != fp);
+  fseek(fp, 0, SEEK_END);
+  const long sizeE = sizeof(QueryTraceHeaderStruct) + sizeState + 2*sizeQuery;
+  CPPUNIT_ASSERT_EQUAL(sizeE, ftell(fp));
+  fclose(fp);
+
+  trace.create(_FILENAME);
+  trace.write(stateA, -122.0, 37.0, 0.0);
+  trace.write(stateB, -122.0, 37.0, -10.0);
+  trace.write(stateB, -122.0, 37.0, -20.0);
+  trace.write(stateA, -122.0, 37.0, -30.0);
+  trace.close();
+
+  const int queryTypesE[] = { 0, 2, 2, 0 };
+  const int numQueries = 4;
+  trace.open(_FILENAME);
+  QueryTraceQueryStruct query;
+  QueryTraceStateStruct state;
+  for (int iQuery=0; iQuery < numQueries; ++iQuery) {
+    CPPUNIT_ASSERT(trace.read(&query, &state));
+    CPPUNIT_ASSERT_EQUAL(-10.0*iQuery, query.elev);
+    CPPUNIT_ASSERT_EQUAL(queryTypesE[iQuery], int(state.queryType));
+    CPPUNIT_ASSERT(stateA.vals == state.vals);
+  } // for
+  CPPUNIT_ASSERT(!trace.read(&query, &state));
+  trace.close();
+} // testState
+
+// ----------------------------------------------------------------------
+// Test read() with record cut off at end of file
+void
+cencalvm::query::TestQueryTrace::testTruncated(void)
+{ // testTruncated
+  QueryTraceStateStruct state;
+  state.queryType = 0;
+  state.squash = 0;
+  state.queryRes = 0.0;
+  state.squashLimit = 0.0;
+  state.vals.push_back(0);
+
+  QueryTrace trace;
+  trace.create(_FILENAME);
+  trace.write(state, -122.0, 37.0, 0.0);
+  trace.write(state, -122.0, 37.0, -10.0);
+  trace.close();
+
+  // Drop the last 4 bytes, as if the run writing the trace was killed.
+  std::string buffer;
+  { // read
+    std::ifstream fin(_FILENAME, std::ios::binary);
+    buffer.assign(std::istreambuf_iterator<char>(fin),
+		  std::istreambuf_iterator<char>());
+  } // read
+  CPPUNIT_ASSERT(buffer.size() > 4);
+  { // write
+    std::ofstream fout(_FILENAME, std::ios::binary);
+    fout.write(buffer.data(), buffer.size()-4);
+  } // write
+
+  trace.open(_FILENAME);
+  QueryTraceQueryStruct query;
+  CPPUNIT_ASSERT(trace.read(&query, &state));
+  CPPUNIT_ASSERT_EQUAL(0.0, query.elev);
+  CPPUNIT_ASSERT(!trace.read(&query, &state));
+  trace.close();
+} // testTruncated
+
+// ----------------------------------------------------------------------
+// Test open() with file that is not a trace
+void
+cencalvm::query::TestQueryTrace::testBadFile(void)
+{ // testBadFile
+  QueryTrace trace;
+  CPPUNIT_ASSERT_THROW(trace.open("data/missing.trace"), std::runtime_error);
+
+  { // write
+    std::ofstream fout(_FILENAMEBAD);
+    fout << "-122.0 37.0 0.0\n"
+	 << "-121.0 38.0 -100.0\n";
+  } // write
+  CPPUNIT_ASSERT_THROW(trace.open(_FILENAMEBAD), std::runtime_error);
+  CPPUNIT_ASSERT(0 == trace._fp);
+} // testBadFile
+
+// ----------------------------------------------------------------------
+// Test valName()
+void
+cencalvm::query::TestQueryTrace::testValName(void)
+{ // testValName
+  CPPUNIT_ASSERT(0 == strcmp("Vp", QueryTrace::valName(0)));
+  CPPUNIT_ASSERT(0 == strcmp("Zone", QueryTrace::valName(7)));
+  CPPUNIT_ASSERT(0 == strcmp("elevation", QueryTrace::valName(8)));
+  CPPUNIT_ASSERT(0 == QueryTrace::valName(9));
+  CPPUNIT_ASSERT(0 == QueryTrace::valName(-1));
+} // testValName
+
+// End of file 
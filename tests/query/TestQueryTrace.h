@@ -0,0 +1,76 @@
+// -*- C++ -*-
+//
+// ----------------------------------------------------------------------
+//
+//                           Brad T. Aagaard
+//                        U.S. Geological Survey
+//
+// {LicenseText}
+//
+// ----------------------------------------------------------------------
+//
+
+/** @file tests/TestQueryTrace.h
+ *
+ * @brief C++ TestQueryTrace object
+ *
+ * C++ unit testing for QueryTrace.
+ */
+
+#if !defined(cencalvm_query_testquerytrace_h)
+#define cencalvm_query_testquerytrace_h
+
+#include <cppunit/extensions/HelperMacros.h>
+
+namespace cencalvm {
+  namespace query {
+    class TestQueryTrace;
+  } // query
+} // cencalvm
+
+/// C++ unit testing for QueryTrace
+class cencalvm::query::TestQueryTrace : public CppUnit::TestFixture
+{ // class TestQueryTrace
+
+  // CPPUNIT TEST SUITE /////////////////////////////////////////////////
+  CPPUNIT_TEST_SUITE( TestQueryTrace );
+  CPPUNIT_TEST( testConstructor );
+  CPPUNIT_TEST( testWriteRead );
+  CPPUNIT_TEST( testState );
+  CPPUNIT_TEST( testTruncated );
+  CPPUNIT_TEST( testBadFile );
+  CPPUNIT_TEST( testValName );
+  CPPUNIT_TEST_SUITE_END();
+
+  // PUBLIC METHODS /////////////////////////////////////////////////////
+public :
+
+  /// Test constructor
+  void testConstructor(void);
+
+  /// Test write() and read()
+  void testWriteRead(void);
+
+  /// Test writing state only when it changes
+  void testState(void);
+
+  /// Test read() with record cut off at end of file
+  void testTruncated(void);
+
+  /// Test open() with file that is not a trace
+  void testBadFile(void);
+
+  /// Test valName()
+  void testValName(void);
+
+  // PRIVATE MEMBERS ////////////////////////////////////////////////////
+private :
+
+  static const char* _FILENAME; ///< Filename of trace
+  static const char* _FILENAMEBAD; ///< Filename of file that is not a trace
+
+}; // class TestQueryTrace
+
+#endif // cencalvm_query_testquerytrace_h
+
+// End of file 
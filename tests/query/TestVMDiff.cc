@@ -0,0 +1,257 @@
+// -*- C++ -*-
+//
+// ----------------------------------------------------------------------
+//
+//                           Brad T. Aagaard
+//                        U.S. Geological Survey
+//
+// {LicenseText}
+//
+// ----------------------------------------------------------------------
+//
+
+#include "TestVMDiff.h" // Implementation of class methods
+
+#include "cencalvm/query/VMDiff.h" // USES VMDiff
+#include "cencalvm/storage/Payload.h" // USES PayloadStruct
+
+extern "C" {
+#include "etree.h"
+}
+
+#include <stdexcept> // USES std::runtime_error
+#include <fstream> // USES std::ifstream
+#include <string> // USES std::string
+
+// ----------------------------------------------------------------------
+CPPUNIT_TEST_SUITE_REGISTRATION( cencalvm::query::TestVMDiff );
+
+// ----------------------------------------------------------------------
+const char* cencalvm::query::TestVMDiff::_DBFILENAMEOLD = 
+  "data/diffold.etree";
+const char* cencalvm::query::TestVMDiff::_DBFILENAMENEW = 
+  "data/diffnew.etree";
+const char* cencalvm::query::TestVMDiff::_REPORTFILENAME = 
+  "data/diff.txt";
+
+// ----------------------------------------------------------------------
+// Test constructor
+void
+cencalvm::query::TestVMDiff::testConstructor(void)
+{ // testConstructor
+  VMDiff vmdiff;
+} // testConstructor
+
+// ----------------------------------------------------------------------
+// Test tolerance()
+void
+cencalvm::query::TestVMDiff::testTolerance(void)
+{ // testTolerance
+  VMDiff vmdiff;
+  vmdiff.tolerance("Vp", 1.0);
+  vmdiff.tolerance("depthfreesurf", 2.0);
+  CPPUNIT_ASSERT_EQUAL(1.0, vmdiff._pTolerance[0]);
+  CPPUNIT_ASSERT_EQUAL(2.0, vmdiff._pTolerance[5]);
+  CPPUNIT_ASSERT_EQUAL(0.0, vmdiff._pTolerance[1]);
+  CPPUNIT_ASSERT_THROW(vmdiff.tolerance("abc", 1.0), std::runtime_error);
+} // testTolerance
+
+// ----------------------------------------------------------------------
+// Test diff() with identical databases
+void
+cencalvm::query::TestVMDiff::testDiffSame(void)
+{ // testDiffSame
+  _createDBs();
+
+  VMDiff vmdiff;
+  vmdiff.filenameOld(_DBFILENAMEOLD);
+  vmdiff.filenameNew(_DBFILENAMEOLD);
+  vmdiff.quiet(true);
+  vmdiff.diff();
+
+  CPPUNIT_ASSERT_EQUAL(uint64_t(0), vmdiff.count(VMDiff::ADDED));
+  CPPUNIT_ASSERT_EQUAL(uint64_t(0), vmdiff.count(VMDiff::REMOVED));
+  CPPUNIT_ASSERT_EQUAL(uint64_t(0), vmdiff.count(VMDiff::CHANGED));
+  CPPUNIT_ASSERT_EQUAL(uint64_t(15), vmdiff.count(VMDiff::UNCHANGED));
+  CPPUNIT_ASSERT_EQUAL(0, vmdiff.numRegions());
+} // testDiffSame
+
+// ----------------------------------------------------------------------
+// Test diff()
+void
+cencalvm::query::TestVMDiff::testDiff(void)
+{ // testDiff
+  _createDBs();
+
+  VMDiff vmdiff;
+  vmdiff.filenameOld(_DBFILENAMEOLD);
+  vmdiff.filenameNew(_DBFILENAMENEW);
+  vmdiff.tolerance("Vp", 1.0);
+  vmdiff.regionLevel(1);
+  vmdiff.quiet(true);
+  vmdiff.diff();
+
+  CPPUNIT_ASSERT_EQUAL(uint64_t(8), vmdiff.count(VMDiff::ADDED));
+  CPPUNIT_ASSERT_EQUAL(uint64_t(8), vmdiff.count(VMDiff::ADDED, 2));
+  CPPUNIT_ASSERT_EQUAL(uint64_t(1), vmdiff.count(VMDiff::REMOVED));
+  CPPUNIT_ASSERT_EQUAL(uint64_t(1), vmdiff.count(VMDiff::REMOVED, 1));
+  CPPUNIT_ASSERT_EQUAL(uint64_t(2), vmdiff.count(VMDiff::CHANGED));
+  CPPUNIT_ASSERT_EQUAL(uint64_t(2), vmdiff.count(VMDiff::CHANGED, 2));
+  CPPUNIT_ASSERT_EQUAL(uint64_t(12), vmdiff.count(VMDiff::UNCHANGED));
+  CPPUNIT_ASSERT_EQUAL(uint64_t(6), vmdiff.count(VMDiff::UNCHANGED, 1));
+  CPPUNIT_ASSERT_EQUAL(uint64_t(6), vmdiff.count(VMDiff::UNCHANGED, 2));
+  CPPUNIT_ASSERT_EQUAL(2, vmdiff.numRegions());
+
+  const etree_tick_t tickLen = 0x80000000 >> 1;
+  CPPUNIT_ASSERT_EQUAL(etree_tick_t(0), vmdiff._regions[0].x);
+  CPPUNIT_ASSERT_EQUAL(uint64_t(2), vmdiff._regions[0].count[VMDiff::CHANGED]);
+  CPPUNIT_ASSERT_EQUAL(tickLen, vmdiff._regions[1].x);
+  CPPUNIT_ASSERT_EQUAL(tickLen, vmdiff._regions[1].y);
+  CPPUNIT_ASSERT_EQUAL(tickLen, vmdiff._regions[1].z);
+  CPPUNIT_ASSERT_EQUAL(uint64_t(8), vmdiff._regions[1].count[VMDiff::ADDED]);
+  CPPUNIT_ASSERT_EQUAL(uint64_t(1), vmdiff._regions[1].count[VMDiff::REMOVED]);
+
+  // Vs and Zone changed, Vp change is within tolerance.
+  CPPUNIT_ASSERT_EQUAL(uint64_t(0), vmdiff._pFieldCount[0]);
+  CPPUNIT_ASSERT_EQUAL(uint64_t(1), vmdiff._pFieldCount[1]);
+  CPPUNIT_ASSERT_EQUAL(uint64_t(1), vmdiff._pFieldCount[7]);
+  CPPUNIT_ASSERT_DOUBLES_EQUAL(5.0, vmdiff._pMaxDiff[1], 1.0e-6);
+} // testDiff
+
+// ----------------------------------------------------------------------
+// Test diff() with report of differences
+void
+cencalvm::query::TestVMDiff::testDiffReport(void)
+{ // testDiffReport
+  _createDBs();
+
+  VMDiff vmdiff;
+  vmdiff.filenameOld(_DBFILENAMEOLD);
+  vmdiff.filenameNew(_DBFILENAMENEW);
+  vmdiff.filenameReport(_REPORTFILENAME);
+  vmdiff.tolerance("Vp", 1.0);
+  vmdiff.quiet(true);
+  vmdiff.diff();
+
+  std::ifstream fin(_REPORTFILENAME);
+  CPPUNIT_ASSERT(fin.is_open());
+  int numAdded = 0;
+  int numRemoved = 0;
+  int numChanged = 0;
+  std::string line;
+  while (std::getline(fin, line)) {
+    if (0 == line.find("added "))
+      ++numAdded;
+    else if (0 == line.find("removed "))
+      ++numRemoved;
+    else if (0 == line.find("changed ")) {
+      ++numChanged;
+      CPPUNIT_ASSERT(std::string::npos != line.find("Vs") ||
+		     std::string::npos != line.find("Zone"));
+    } else
+      CPPUNIT_ASSERT_EQUAL(std::string::size_type(0), line.find("#"));
+  } // while
+  CPPUNIT_ASSERT_EQUAL(8, numAdded);
+  CPPUNIT_ASSERT_EQUAL(1, numRemoved);
+  CPPUNIT_ASSERT_EQUAL(2, numChanged);
+} // testDiffReport
+
+// ----------------------------------------------------------------------
+// Create old and new databases.
+void
+cencalvm::query::TestVMDiff::_createDBs(void) const
+{ // _createDBs
+  // Old database: level 1 octant refined into 8 leaves at level 2 and
+  // 7 level 1 leaves.
+  // New database: two level 2 leaves changed, Vp of one level 2 leaf
+  // changed within tolerance, and a level 1 leaf refined into 8
+  // leaves at level 2.
+  etree_t* dbOld = 
+    etree_open(_DBFILENAMEOLD, O_CREAT|O_RDWR|O_TRUNC, 0, 0, 3);
+  CPPUNIT_ASSERT(0 != dbOld);
+  int err = etree_registerschema(dbOld, storage::Payload::SCHEMA);
+  CPPUNIT_ASSERT(0 == err);
+  etree_t* dbNew = 
+    etree_open(_DBFILENAMENEW, O_CREAT|O_RDWR|O_TRUNC, 0, 0, 3);
+  CPPUNIT_ASSERT(0 != dbNew);
+  err = etree_registerschema(dbNew, storage::Payload::SCHEMA);
+  CPPUNIT_ASSERT(0 == err);
+
+  storage::PayloadStruct payload;
+  for (int iOct=0; iOct < 8; ++iOct) {
+    const int x = iOct % 2;
+    const int y = (iOct / 2) % 2;
+    const int z = iOct / 4;
+    _setPayload(&payload, 1.0 + iOct);
+    _insertOctant(dbOld, 2, x, y, z, payload);
+    if (0 == iOct)
+      payload.Vp += 0.5;
+    else if (1 == iOct)
+      payload.Vs += 5.0;
+    else if (2 == iOct)
+      payload.Zone += 1;
+    _insertOctant(dbNew, 2, x, y, z, payload);
+  } // for
+  for (int iOct=1; iOct < 8; ++iOct) {
+    const int x = iOct % 2;
+    const int y = (iOct / 2) % 2;
+    const int z = iOct / 4;
+    _setPayload(&payload, 10.0 + iOct);
+    _insertOctant(dbOld, 1, x, y, z, payload);
+    if (7 != iOct)
+      _insertOctant(dbNew, 1, x, y, z, payload);
+    else
+      for (int iChild=0; iChild < 8; ++iChild)
+	_insertOctant(dbNew, 2, 2*x + iChild % 2, 2*y + (iChild / 2) % 2,
+		      2*z + iChild / 4, payload);
+  } // for
+
+  err = etree_close(dbOld);
+  CPPUNIT_ASSERT(0 == err);
+  err = etree_close(dbNew);
+  CPPUNIT_ASSERT(0 == err);
+} // _createDBs
+
+// ----------------------------------------------------------------------
+// Insert octant into etree database.
+void
+cencalvm::query::TestVMDiff::_insertOctant(etree_t* db,
+					   const int level,
+					   const int x,
+					   const int y,
+					   const int z,
+				  const storage::PayloadStruct& payload) const
+{ // _insertOctant
+  CPPUNIT_ASSERT(0 != db);
+
+  etree_addr_t addr;
+  addr.level = level;
+  addr.type = ETREE_LEAF;
+  const etree_tick_t tickLen = 0x80000000 >> level;
+  addr.x = tickLen * x;
+  addr.y = tickLen * y;
+  addr.z = tickLen * z;
+
+  const int err = etree_insert(db, addr, &payload);
+  CPPUNIT_ASSERT(0 == err);
+} // _insertOctant
+
+// ----------------------------------------------------------------------
+// Set payload values from octant value.
+void
+cencalvm::query::TestVMDiff::_setPayload(storage::PayloadStruct* pPayload,
+					 const double val) const
+{ // _setPayload
+  CPPUNIT_ASSERT(0 != pPayload);
+
+  pPayload->Vp = 100.0*val;
+  pPayload->Vs = 50.0*val;
+  pPayload->Density = 2000.0 + val;
+  pPayload->Qp = 100.0 + val;
+  pPayload->Qs = 50.0 + val;
+  pPayload->DepthFreeSurf = 100.0*val;
+  pPayload->FaultBlock = 1;
+  pPayload->Zone = 1;
+} // _setPayload
+
+// End of file 
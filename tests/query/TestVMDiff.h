@@ -0,0 +1,108 @@
+// -*- C++ -*-
+//
+// ----------------------------------------------------------------------
+//
+//                           Brad T. Aagaard
+//                        U.S. Geological Survey
+//
+// {LicenseText}
+//
+// ----------------------------------------------------------------------
+//
+
+/** @file tests/TestVMDiff.h
+ *
+ * @brief C++ TestVMDiff object
+ *
+ * C++ unit testing for VMDiff.
+ */
+
+#if !defined(cencalvm_query_testvmdiff_h)
+#define cencalvm_query_testvmdiff_h
+
+#include <cppunit/extensions/HelperMacros.h>
+
+#include "cencalvm/storage/etreefwd.h" // USES etree_t
+
+namespace cencalvm {
+  namespace query {
+    class TestVMDiff;
+  } // query
+  namespace storage {
+    struct PayloadStruct; // USES PayloadStruct
+  } // storage
+} // cencalvm
+
+/// C++ unit testing for VMDiff
+class cencalvm::query::TestVMDiff : public CppUnit::TestFixture
+{ // class TestVMDiff
+
+  // CPPUNIT TEST SUITE /////////////////////////////////////////////////
+  CPPUNIT_TEST_SUITE( TestVMDiff );
+  CPPUNIT_TEST( testConstructor );
+  CPPUNIT_TEST( testTolerance );
+  CPPUNIT_TEST( testDiffSame );
+  CPPUNIT_TEST( testDiff );
+  CPPUNIT_TEST( testDiffReport );
+  CPPUNIT_TEST_SUITE_END();
+
+  // PUBLIC METHODS /////////////////////////////////////////////////////
+public :
+
+  /// Test constructor
+  void testConstructor(void);
+
+  /// Test tolerance()
+  void testTolerance(void);
+
+  /// Test diff() with identical databases
+  void testDiffSame(void);
+
+  /// Test diff()
+  void testDiff(void);
+
+  /// Test diff() with report of differences
+  void testDiffReport(void);
+
+  // PRIVATE METHODS ////////////////////////////////////////////////////
+private :
+
+  /// Create old and new databases.
+  void _createDBs(void) const;
+
+  /** Insert octant into etree database.
+   *
+   * @param db Etree database
+   * @param level Level of octant
+   * @param x Coordinate of octant in units of octant size
+   * @param y Coordinate of octant in units of octant size
+   * @param z Coordinate of octant in units of octant size
+   * @param payload Payload of octant
+   */
+  void _insertOctant(etree_t* db,
+		     const int level,
+		     const int x,
+		     const int y,
+		     const int z,
+		     const storage::PayloadStruct& payload) const;
+
+  /** Set payload values from octant value.
+   *
+   * @param pPayload Pointer to payload
+   * @param val Octant value
+   */
+  void _setPayload(storage::PayloadStruct* pPayload,
+		   const double val) const;
+
+  // PRIVATE MEMBERS ////////////////////////////////////////////////////
+private :
+
+  static const char* _DBFILENAMEOLD; ///< Filename of old database
+  static const char* _DBFILENAMENEW; ///< Filename of new database
+  static const char* _REPORTFILENAME; ///< Filename of report
+
+}; // class TestVMDiff
+
+#endif // cencalvm_query_testvmdiff_h
+
+// End of file 
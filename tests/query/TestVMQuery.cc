@@ -13,7 +13,18 @@
 #include "TestVMQuery.h" // Implementation of class methods
 
 #include "cencalvm/query/VMQuery.h" // USES VMQuery
+#include "cencalvm/query/QueryTrace.h" // USES QueryTrace
+#include "cencalvm/query/QueryReplayer.h" // USES QueryReplayer
 #include "cencalvm/average/Averager.h" // USES Averager
+#include "cencalvm/create/Columnizer.h" // USES Columnizer
+#include "cencalvm/create/Compactor.h" // USES Compactor
+#include "cencalvm/create/Compressor.h" // USES Compressor
+#include "cencalvm/create/DictionaryEncoder.h" // USES DictionaryEncoder
+#include "cencalvm/create/PyramidBuilder.h" // USES PyramidBuilder
+#include "cencalvm/create/Quantizer.h" // USES Quantizer
+#include "cencalvm/storage/BrickDB.h" // USES BrickDB
+#include "cencalvm/storage/CacheMonitor.h" // USES CacheMonitor
+#include "cencalvm/storage/PayloadDictionary.h" // USES PayloadDictionary
 #include "cencalvm/storage/Geometry.h" // USES Geometry
 #include "cencalvm/storage/ErrorHandler.h" // USES ErrorHandler
 #include "cencalvm/storage/GeomCenCA.h" // USES GeomCenCA
@@ -25,6 +36,10 @@ extern "C" {
 #include <iostream> // USES std::cerr
 #include <assert.h> // USES assert()
 #include <string.h> // USES strcmp()
+#include <stdio.h> // USES rename(), remove()
+#include <math.h> // USES fabs()
+#include <fstream> // USES std::ifstream
+#include <sstream> // USES std::ostringstream
 
 // ----------------------------------------------------------------------
 CPPUNIT_TEST_SUITE_REGISTRATION( cencalvm::query::TestVMQuery );
@@ -154,6 +169,16 @@ cencalvm::query::TestVMQuery::testCacheSize(void)
   const int cacheSize = 523;
   query.cacheSize(cacheSize);
   CPPUNIT_ASSERT_EQUAL(cacheSize, query._cacheSize);
+
+  // Invalid sizes should be ignored
+  query.cacheSize(0);
+  CPPUNIT_ASSERT_EQUAL(cacheSize, query._cacheSize);
+  query.cacheSize(-5);
+  CPPUNIT_ASSERT_EQUAL(cacheSize, query._cacheSize);
+
+  query.cacheSize(cencalvm::storage::CacheMonitor::AUTOSIZE);
+  CPPUNIT_ASSERT_EQUAL(cencalvm::storage::CacheMonitor::AUTOSIZE,
+		       query._cacheSize);
 } // testCacheSize
 
 // ----------------------------------------------------------------------
@@ -472,6 +497,16 @@ cencalvm::query::TestVMQuery::testCacheSizeExt(void)
   const int cacheSize = 523;
   query.cacheSizeExt(cacheSize);
   CPPUNIT_ASSERT_EQUAL(cacheSize, query._cacheSizeExt);
+
+  // Invalid sizes should be ignored
+  query.cacheSizeExt(0);
+  CPPUNIT_ASSERT_EQUAL(cacheSize, query._cacheSizeExt);
+  query.cacheSizeExt(-5);
+  CPPUNIT_ASSERT_EQUAL(cacheSize, query._cacheSizeExt);
+
+  query.cacheSizeExt(cencalvm::storage::CacheMonitor::AUTOSIZE);
+  CPPUNIT_ASSERT_EQUAL(cencalvm::storage::CacheMonitor::AUTOSIZE,
+		       query._cacheSizeExt);
 } // testCacheSizeExt
 
 // ----------------------------------------------------------------------
@@ -533,6 +568,840 @@ cencalvm::query::TestVMQuery::testQueryMaxExt(void)
   delete[] pLonLatElev; pLonLatElev = 0;
 } // testQueryMaxExt
 
+// ----------------------------------------------------------------------
+// Test query() with compact database
+void 
+cencalvm::query::TestVMQuery::testQueryCompact(void)
+{ // testQueryCompact
+  _createDB();
+
+  const int numVals = 9;
+  const char* names[] = { "Vp", "Vs", "Density", "Qp", "Qs",
+			  "DepthFreeSurf", "FaultBlock", "Zone", "Elevation" };
+  const double bounds[] = { 0.01, 0.001, 1.0e-04, 1.0e-05, 1.0e-06, 
+			    0.1, 0.0, 0.0, 0.1 };
+
+  cencalvm::create::Quantizer quantizer;
+  quantizer.filenameIn(_DBFILENAME);
+  quantizer.filenameOut(_DBFILENAMECOMPACT);
+  for (int iVal=0; iVal < 6; ++iVal)
+    quantizer.errorBound(names[iVal], bounds[iVal]);
+  quantizer.quiet(true);
+  quantizer.quantize();
+
+  VMQuery queryE;
+  queryE.filename(_DBFILENAME);
+  queryE.queryType(cencalvm::query::VMQuery::MAXRES);
+  queryE.open();
+  CPPUNIT_ASSERT(0 == queryE._pCodec);
+
+  VMQuery query;
+  query.filename(_DBFILENAMECOMPACT);
+  query.queryType(cencalvm::query::VMQuery::MAXRES);
+  query.open();
+  CPPUNIT_ASSERT(0 != query._pCodec);
+
+  const cencalvm::storage::ErrorHandler* pHandler = query.errorHandler();
+
+  double* pValsE = (numVals > 0) ? new double[numVals] : 0;
+  double* pVals = (numVals > 0) ? new double[numVals] : 0;
+
+  double* pLonLatElev = 0;
+  _dbLonLatElev(&pLonLatElev);
+  const int numLocs = _NUMOCTANTSLEAF;
+  for (int iLoc=0, i=0; iLoc < numLocs; ++iLoc, i+=3) {
+    queryE.query(&pValsE, numVals, 
+		 pLonLatElev[i  ], pLonLatElev[i+1], pLonLatElev[i+2]);
+    query.query(&pVals, numVals, 
+		pLonLatElev[i  ], pLonLatElev[i+1], pLonLatElev[i+2]);
+    
+    // Allow for rounding of restored values to single precision.
+    const double tolerance = 1.0e-06;
+    for (int iVal=0; iVal < numVals; ++iVal)
+      CPPUNIT_ASSERT_DOUBLES_EQUAL(pValsE[iVal], pVals[iVal],
+				   bounds[iVal] + 
+				   tolerance*fabs(pValsE[iVal]));
+  } // for
+
+  queryE.close();
+  query.close();
+  CPPUNIT_ASSERT(0 == query._pCodec);
+
+  CPPUNIT_ASSERT(cencalvm::storage::ErrorHandler::OK == pHandler->status());
+
+  delete[] pLonLatElev; pLonLatElev = 0;
+  delete[] pVals; pVals = 0;
+  delete[] pValsE; pValsE = 0;
+} // testQueryCompact
+
+// ----------------------------------------------------------------------
+// Test query() with compressed database
+void
+cencalvm::query::TestVMQuery::testQueryCompressed(void)
+{ // testQueryCompressed
+  assert(0 != _pGeom);
+
+  _createDB();
+
+  cencalvm::create::Compressor compressor;
+  compressor.filenameIn(_DBFILENAME);
+  compressor.filenameOut(_DBFILENAMECOMPRESSED);
+  compressor.blockSize(3);
+  compressor.quiet(true);
+  compressor.compress();
+
+  VMQuery queryE;
+  queryE.filename(_DBFILENAME);
+  queryE.open();
+  cencalvm::storage::ErrorHandler* pHandlerE = queryE.errorHandler();
+
+  VMQuery query;
+  query.filename(_DBFILENAMECOMPRESSED);
+  query.cacheSize(1);
+  query.open();
+  CPPUNIT_ASSERT(0 == query._db);
+  CPPUNIT_ASSERT(0 != query._pCompressed);
+
+  cencalvm::storage::ErrorHandler* pHandler = query.errorHandler();
+
+  const int numVals = 9;
+  double* pValsE = (numVals > 0) ? new double[numVals] : 0;
+  double* pVals = (numVals > 0) ? new double[numVals] : 0;
+
+  double* pLonLatElev = 0;
+  _dbLonLatElev(&pLonLatElev);
+
+  // Compressed database must give exactly the same values for all
+  // types of queries.
+  const int numOctCoords = 4;
+  const VMQuery::QueryEnum queryTypes[] = { 
+    VMQuery::MAXRES, VMQuery::FIXEDRES, VMQuery::WAVERES };
+  const int numQueryTypes = 3;
+  const double periodMin[] = { 1.0, 800.0, 4000.0 };
+  const int numPeriods = 3;
+  for (int iType=0; iType < numQueryTypes; ++iType) {
+    queryE.queryType(queryTypes[iType]);
+    query.queryType(queryTypes[iType]);
+    const int numRes = (VMQuery::WAVERES == queryTypes[iType]) ?
+      numPeriods : _NUMOCTANTS;
+    for (int iRes=0; iRes < numRes; ++iRes) {
+      const double res = (VMQuery::WAVERES == queryTypes[iType]) ?
+	periodMin[iRes] :
+	_pGeom->edgeLen(_COORDS[numOctCoords*iRes+3]) / _pGeom->vertExag();
+      queryE.queryRes(res);
+      query.queryRes(res);
+      for (int iLoc=0, i=0; iLoc < _NUMOCTANTS; ++iLoc, i+=3) {
+	queryE.query(&pValsE, numVals, 
+		     pLonLatElev[i  ], pLonLatElev[i+1], pLonLatElev[i+2]);
+	query.query(&pVals, numVals, 
+		    pLonLatElev[i  ], pLonLatElev[i+1], pLonLatElev[i+2]);
+	for (int iVal=0; iVal < numVals; ++iVal)
+	  CPPUNIT_ASSERT_EQUAL(pValsE[iVal], pVals[iVal]);
+
+	// Locations without data give the same warnings.
+	CPPUNIT_ASSERT_EQUAL(pHandlerE->status(), pHandler->status());
+	CPPUNIT_ASSERT(0 == strcmp(pHandlerE->message(), pHandler->message()));
+	pHandlerE->resetStatus();
+	pHandler->resetStatus();
+      } // for
+    } // for
+  } // for
+
+  queryE.close();
+  query.close();
+  CPPUNIT_ASSERT(0 == query._pCompressed);
+
+  delete[] pLonLatElev; pLonLatElev = 0;
+  delete[] pVals; pVals = 0;
+  delete[] pValsE; pValsE = 0;
+} // testQueryCompressed
+
+// ----------------------------------------------------------------------
+// Test query() with compacted database
+void
+cencalvm::query::TestVMQuery::testQueryCompacted(void)
+{ // testQueryCompacted
+  assert(0 != _pGeom);
+
+  _createDBSurface();
+
+  cencalvm::create::Compactor compactor;
+  compactor.filenameIn(_DBFILENAMESURFACE);
+  compactor.filenameOut(_DBFILENAMECOMPACTED);
+  compactor.quiet(true);
+  compactor.compact();
+
+  // Database has interior octants at levels 0-11 and 512 leaves at
+  // level 12. Only the 4 subtrees at level 10 with the free surface
+  // in the top layer of leaves are collapsed.
+  const int numDBs = 2;
+  const char* filenames[] = { _DBFILENAMESURFACE, _DBFILENAMECOMPACTED };
+  const int numOctantsE[] = { 594, 306 };
+  for (int iDB=0; iDB < numDBs; ++iDB) {
+    etree_t* db = etree_open(filenames[iDB], O_RDONLY, 0, 0, 0);
+    CPPUNIT_ASSERT(0 != db);
+    etree_addr_t addr;
+    addr.x = 0;
+    addr.y = 0;
+    addr.z = 0;
+    addr.t = 0;
+    addr.level = ETREE_MAXLEVEL;
+    int numOctants = 0;
+    bool more = (0 == etree_initcursor(db, addr));
+    while (more) {
+      ++numOctants;
+      more = (0 == etree_advcursor(db));
+    } // while
+    CPPUNIT_ASSERT_EQUAL(numOctantsE[iDB], numOctants);
+    CPPUNIT_ASSERT(0 == etree_close(db));
+  } // for
+
+  // Columns with free surface in top layer of leaves and above
+  // leaves, at elevations near free surface, boundaries of leaves,
+  // and boundaries of collapsed subtrees.
+  const int level = 12;
+  const int origin = 2048;
+  const int numColumns = 2;
+  const int columns[] = { 1, 6 };
+  const int numElevs = 12;
+  const double elevs[] = { -0.5, -1.5, -48.5, -51.5, -98.5, -101.5,
+			   -150.0, -398.5, -401.5, -550.0, -699.5, -750.0 };
+
+  // Depth of free surface is relative to centroid of octant and
+  // elevation of free surface is restored to single precision.
+  const int numVals = 9;
+  const int iDepth = 5;
+  const int iElev = 8;
+  const double tolerance = 0.01;
+
+  double* pValsE = new double[numVals];
+  double* pVals = new double[numVals];
+
+  const int numSquash = 2;
+  for (int iSquash=0; iSquash < numSquash; ++iSquash) {
+    const bool squash = (1 == iSquash);
+
+    VMQuery queryE;
+    queryE.filename(_DBFILENAMESURFACE);
+    queryE.queryType(cencalvm::query::VMQuery::MAXRES);
+    queryE.squash(squash);
+    queryE.open();
+
+    VMQuery query;
+    query.filename(_DBFILENAMECOMPACTED);
+    query.queryType(cencalvm::query::VMQuery::MAXRES);
+    query.squash(squash);
+    query.open();
+
+    const etree_tick_t tickLen = 0x80000000 >> level;
+    for (int iColumn=0; iColumn < numColumns; ++iColumn) {
+      etree_addr_t addr;
+      addr.x = (origin + columns[iColumn]) * tickLen;
+      addr.y = (origin + 3) * tickLen;
+      addr.z = 0;
+      addr.t = 0;
+      addr.level = level;
+      addr.type = ETREE_LEAF;
+      double lon = 0.0;
+      double lat = 0.0;
+      double elev = 0.0;
+      _pGeom->addrToLonLatElev(&lon, &lat, &elev, &addr);
+
+      for (int iLoc=0; iLoc < numElevs; ++iLoc) {
+	queryE.query(&pValsE, numVals, lon, lat, elevs[iLoc]);
+	query.query(&pVals, numVals, lon, lat, elevs[iLoc]);
+
+	for (int iVal=0; iVal < numVals; ++iVal)
+	  if (iElev == iVal)
+	    CPPUNIT_ASSERT_DOUBLES_EQUAL(pValsE[iVal], pVals[iVal], tolerance);
+	  else if (iDepth != iVal)
+	    CPPUNIT_ASSERT_EQUAL(pValsE[iVal], pVals[iVal]);
+      } // for
+    } // for
+
+    // Queries below the leaves give warnings with both databases.
+    CPPUNIT_ASSERT(queryE.errorHandler()->status() ==
+		   query.errorHandler()->status());
+    queryE.close();
+    query.close();
+  } // for
+
+  delete[] pValsE; pValsE = 0;
+  delete[] pVals; pVals = 0;
+} // testQueryCompacted
+
+// ----------------------------------------------------------------------
+// Test cacheStats() with automatic cache sizing
+void
+cencalvm::query::TestVMQuery::testCacheStats(void)
+{ // testCacheStats
+  _createDB();
+
+  cencalvm::create::Compressor compressor;
+  compressor.filenameIn(_DBFILENAME);
+  compressor.filenameOut(_DBFILENAMECOMPRESSED);
+  compressor.blockSize(3);
+  compressor.quiet(true);
+  compressor.compress();
+
+  const int minSize = cencalvm::storage::CacheMonitor::MINSIZE;
+  cencalvm::storage::CacheStatsStruct stats;
+
+  { // etree database
+    VMQuery query;
+    query.filename(_DBFILENAME);
+    query.cacheSize(cencalvm::storage::CacheMonitor::AUTOSIZE);
+    query.open();
+
+    // Small database should get the minimum size
+    query.cacheStats(&stats);
+    CPPUNIT_ASSERT_EQUAL(minSize, stats.cacheSize);
+    CPPUNIT_ASSERT(stats.isEstimate);
+    CPPUNIT_ASSERT_EQUAL(uint64_t(0), stats.numSearches);
+
+    query.close();
+    query.cacheStats(&stats);
+    CPPUNIT_ASSERT_EQUAL(0, stats.cacheSize);
+  } // etree database
+
+  { // compressed database
+    VMQuery query;
+    query.filename(_DBFILENAMECOMPRESSED);
+    query.cacheSize(cencalvm::storage::CacheMonitor::AUTOSIZE);
+    query.open();
+
+    query.cacheStats(&stats);
+    CPPUNIT_ASSERT_EQUAL(minSize, stats.cacheSize);
+    CPPUNIT_ASSERT(!stats.isEstimate);
+    CPPUNIT_ASSERT_EQUAL(uint64_t(0), stats.numSearches);
+
+    const int numVals = 9;
+    double* pVals = (numVals > 0) ? new double[numVals] : 0;
+    double* pLonLatElev = 0;
+    _dbLonLatElev(&pLonLatElev);
+
+    query.queryType(VMQuery::MAXRES);
+    for (int iLoc=0, i=0; iLoc < _NUMOCTANTS; ++iLoc, i+=3)
+      query.query(&pVals, numVals,
+		  pLonLatElev[i  ], pLonLatElev[i+1], pLonLatElev[i+2]);
+
+    // Counts of compressed database are exact
+    query.cacheStats(&stats);
+    CPPUNIT_ASSERT(stats.numSearches >= uint64_t(_NUMOCTANTS));
+    CPPUNIT_ASSERT_EQUAL(stats.numSearches, stats.numHits + stats.numMisses);
+    CPPUNIT_ASSERT(stats.numMisses > 0);
+    CPPUNIT_ASSERT(stats.numReads > 0);
+    CPPUNIT_ASSERT(stats.bytesRead > 0);
+    CPPUNIT_ASSERT_EQUAL(stats.numReads, stats.numResident);
+    CPPUNIT_ASSERT_EQUAL(uint64_t(0), stats.numEvictions);
+
+    // Cache at the minimum size should not change
+    query._adjustCache(VMQuery::DETAILED);
+    query.cacheStats(&stats);
+    CPPUNIT_ASSERT_EQUAL(minSize, stats.cacheSize);
+    CPPUNIT_ASSERT_EQUAL(0, stats.numResizes);
+
+    // No extended database
+    query.cacheStatsExt(&stats);
+    CPPUNIT_ASSERT_EQUAL(uint64_t(0), stats.numSearches);
+
+    query.close();
+    query.cacheStats(&stats);
+    CPPUNIT_ASSERT_EQUAL(uint64_t(0), stats.numSearches);
+
+    delete[] pLonLatElev; pLonLatElev = 0;
+    delete[] pVals; pVals = 0;
+  } // compressed database
+} // testCacheStats
+
+// ----------------------------------------------------------------------
+// Test reopening etree database with cache of a different size
+void
+cencalvm::query::TestVMQuery::testReopenCache(void)
+{ // testReopenCache
+  _createDB();
+
+  VMQuery queryE;
+  queryE.filename(_DBFILENAME);
+  queryE.open();
+  cencalvm::storage::ErrorHandler* pHandlerE = queryE.errorHandler();
+
+  VMQuery query;
+  query.filename(_DBFILENAME);
+  query.cacheSize(cencalvm::storage::CacheMonitor::AUTOSIZE);
+  query.open();
+  cencalvm::storage::ErrorHandler* pHandler = query.errorHandler();
+
+  const int numVals = 9;
+  double* pValsE = (numVals > 0) ? new double[numVals] : 0;
+  double* pVals = (numVals > 0) ? new double[numVals] : 0;
+  double* pLonLatElev = 0;
+  _dbLonLatElev(&pLonLatElev);
+
+  const int cacheSize = 32;
+  const char* filenameMissing = "data/missing.etree";
+  cencalvm::storage::CacheStatsStruct stats;
+  for (int iPass=0; iPass < 3; ++iPass) {
+    if (1 == iPass) {
+      CPPUNIT_ASSERT(query._reopenCache(VMQuery::DETAILED, cacheSize));
+    } else if (2 == iPass) {
+      // Failure to reopen keeps the old database and cache.
+      const std::string filename = query._filename;
+      query._filename = filenameMissing;
+      CPPUNIT_ASSERT(!query._reopenCache(VMQuery::DETAILED, 2*cacheSize));
+      query._filename = filename;
+      CPPUNIT_ASSERT(0 != query._db);
+    } // if/else
+    query.cacheStats(&stats);
+    const int cacheSizeE = (0 == iPass) ?
+      cencalvm::storage::CacheMonitor::MINSIZE : cacheSize;
+    CPPUNIT_ASSERT_EQUAL(cacheSizeE, stats.cacheSize);
+    CPPUNIT_ASSERT_EQUAL((0 == iPass) ? 0 : 1, stats.numResizes);
+
+    for (int iLoc=0, i=0; iLoc < _NUMOCTANTS; ++iLoc, i+=3) {
+      queryE.query(&pValsE, numVals,
+		   pLonLatElev[i  ], pLonLatElev[i+1], pLonLatElev[i+2]);
+      query.query(&pVals, numVals,
+		  pLonLatElev[i  ], pLonLatElev[i+1], pLonLatElev[i+2]);
+      for (int iVal=0; iVal < numVals; ++iVal)
+	CPPUNIT_ASSERT_EQUAL(pValsE[iVal], pVals[iVal]);
+      CPPUNIT_ASSERT_EQUAL(pHandlerE->status(), pHandler->status());
+      pHandlerE->resetStatus();
+      pHandler->resetStatus();
+    } // for
+  } // for
+
+  queryE.close();
+  query.close();
+
+  delete[] pLonLatElev; pLonLatElev = 0;
+  delete[] pVals; pVals = 0;
+  delete[] pValsE; pValsE = 0;
+} // testReopenCache
+
+// ----------------------------------------------------------------------
+// Test query() with column-split database
+void
+cencalvm::query::TestVMQuery::testQueryColumns(void)
+{ // testQueryColumns
+  assert(0 != _pGeom);
+
+  _createDB();
+
+  cencalvm::create::Columnizer columnizer;
+  columnizer.filenameIn(_DBFILENAME);
+  columnizer.filenameOut(_DBFILENAMECOLUMNS);
+  columnizer.quiet(true);
+  columnizer.columnize();
+
+  double* pLonLatElev = 0;
+  _dbLonLatElev(&pLonLatElev);
+
+  // Column-split database must give exactly the same values for all
+  // types of queries, whether all values or only Vs are requested.
+  const int numOctCoords = 4;
+  const VMQuery::QueryEnum queryTypes[] = { 
+    VMQuery::MAXRES, VMQuery::FIXEDRES, VMQuery::WAVERES };
+  const int numQueryTypes = 3;
+  const double periodMin[] = { 1.0, 800.0, 4000.0 };
+  const int numPeriods = 3;
+  const char* namesAll[] = { "Vp", "Vs", "Density", "Qp", "Qs",
+			     "DepthFreeSurf", "FaultBlock", "Zone",
+			     "Elevation" };
+  const char* namesVs[] = { "Vs" };
+  const char* const* names[] = { namesAll, namesVs };
+  const int numVals[] = { 9, 1 };
+  const int numCases = 2;
+  for (int iCase=0; iCase < numCases; ++iCase) {
+    VMQuery queryE;
+    queryE.filename(_DBFILENAME);
+    queryE.queryVals(names[iCase], numVals[iCase]);
+    queryE.open();
+    cencalvm::storage::ErrorHandler* pHandlerE = queryE.errorHandler();
+
+    VMQuery query;
+    query.filename(_DBFILENAMECOLUMNS);
+    query.queryVals(names[iCase], numVals[iCase]);
+    query.open();
+    CPPUNIT_ASSERT(0 == query._db);
+    CPPUNIT_ASSERT(0 != query._pColumns);
+    cencalvm::storage::ErrorHandler* pHandler = query.errorHandler();
+
+    double* pValsE = new double[numVals[iCase]];
+    double* pVals = new double[numVals[iCase]];
+    for (int iType=0; iType < numQueryTypes; ++iType) {
+      queryE.queryType(queryTypes[iType]);
+      query.queryType(queryTypes[iType]);
+      const int numRes = (VMQuery::WAVERES == queryTypes[iType]) ?
+	numPeriods : _NUMOCTANTS;
+      for (int iRes=0; iRes < numRes; ++iRes) {
+	const double res = (VMQuery::WAVERES == queryTypes[iType]) ?
+	  periodMin[iRes] :
+	  _pGeom->edgeLen(_COORDS[numOctCoords*iRes+3]) / _pGeom->vertExag();
+	queryE.queryRes(res);
+	query.queryRes(res);
+	for (int iLoc=0, i=0; iLoc < _NUMOCTANTS; ++iLoc, i+=3) {
+	  queryE.query(&pValsE, numVals[iCase], 
+		       pLonLatElev[i  ], pLonLatElev[i+1], pLonLatElev[i+2]);
+	  query.query(&pVals, numVals[iCase], 
+		      pLonLatElev[i  ], pLonLatElev[i+1], pLonLatElev[i+2]);
+	  for (int iVal=0; iVal < numVals[iCase]; ++iVal)
+	    CPPUNIT_ASSERT_EQUAL(pValsE[iVal], pVals[iVal]);
+
+	  // Locations without data give the same warnings.
+	  CPPUNIT_ASSERT_EQUAL(pHandlerE->status(), pHandler->status());
+	  CPPUNIT_ASSERT(0 == strcmp(pHandlerE->message(),
+				     pHandler->message()));
+	  pHandlerE->resetStatus();
+	  pHandler->resetStatus();
+	} // for
+      } // for
+    } // for
+
+    queryE.close();
+    query.close();
+    CPPUNIT_ASSERT(0 == query._pColumns);
+
+    delete[] pVals; pVals = 0;
+    delete[] pValsE; pValsE = 0;
+  } // for
+
+  delete[] pLonLatElev; pLonLatElev = 0;
+} // testQueryColumns
+
+// ----------------------------------------------------------------------
+// Test query() with fixed resolution using brick pyramid
+void
+cencalvm::query::TestVMQuery::testQueryPyramid(void)
+{ // testQueryPyramid
+  assert(0 != _pGeom);
+
+  _createDB();
+
+  const int maxLevel = 7;
+  cencalvm::create::PyramidBuilder builder;
+  builder.filenameIn(_DBFILENAME);
+  builder.filenameOut(_DBFILENAMEPYRAMID);
+  builder.levels(0, maxLevel);
+  builder.quiet(true);
+  builder.build();
+
+  VMQuery queryE;
+  queryE.filename(_DBFILENAME);
+  queryE.queryType(VMQuery::FIXEDRES);
+  queryE.open();
+  cencalvm::storage::ErrorHandler* pHandlerE = queryE.errorHandler();
+
+  VMQuery query;
+  query.filename(_DBFILENAME);
+  query.filenamePyramid(_DBFILENAMEPYRAMID);
+  query.queryType(VMQuery::FIXEDRES);
+  query.open();
+  CPPUNIT_ASSERT(0 != query._pPyramid);
+  cencalvm::storage::ErrorHandler* pHandler = query.errorHandler();
+
+  double* pLonLatElev = 0;
+  _dbLonLatElev(&pLonLatElev);
+
+  // Pyramid must give exactly the same values as searching the
+  // database at every level, including locations without data.
+  const int numVals = 9;
+  double* pValsE = new double[numVals];
+  double* pVals = new double[numVals];
+  for (int level=0; level <= maxLevel; ++level) {
+    CPPUNIT_ASSERT(query._pPyramid->hasLevel(level));
+    const double res = _pGeom->edgeLen(level) / _pGeom->vertExag();
+    queryE.queryRes(res);
+    query.queryRes(res);
+    for (int iLoc=0, i=0; iLoc < _NUMOCTANTS; ++iLoc, i+=3) {
+      queryE.query(&pValsE, numVals, 
+		   pLonLatElev[i  ], pLonLatElev[i+1], pLonLatElev[i+2]);
+      query.query(&pVals, numVals, 
+		  pLonLatElev[i  ], pLonLatElev[i+1], pLonLatElev[i+2]);
+      for (int iVal=0; iVal < numVals; ++iVal)
+	CPPUNIT_ASSERT_EQUAL(pValsE[iVal], pVals[iVal]);
+
+      CPPUNIT_ASSERT_EQUAL(pHandlerE->status(), pHandler->status());
+      CPPUNIT_ASSERT(0 == strcmp(pHandlerE->message(), pHandler->message()));
+      pHandlerE->resetStatus();
+      pHandler->resetStatus();
+    } // for
+  } // for
+
+  queryE.close();
+  query.close();
+  CPPUNIT_ASSERT(0 == query._pPyramid);
+
+  delete[] pVals; pVals = 0;
+  delete[] pValsE; pValsE = 0;
+  delete[] pLonLatElev; pLonLatElev = 0;
+} // testQueryPyramid
+
+// ----------------------------------------------------------------------
+// Test query() with dictionary-encoded database
+void
+cencalvm::query::TestVMQuery::testQueryDictionary(void)
+{ // testQueryDictionary
+  assert(0 != _pGeom);
+
+  _createDB();
+
+  cencalvm::create::DictionaryEncoder encoder;
+  encoder.filenameIn(_DBFILENAME);
+  encoder.filenameOut(_DBFILENAMEDICTIONARY);
+  encoder.quiet(true);
+  encoder.encode();
+
+  VMQuery queryE;
+  queryE.filename(_DBFILENAME);
+  queryE.open();
+  CPPUNIT_ASSERT(0 == queryE._pDictionary);
+  cencalvm::storage::ErrorHandler* pHandlerE = queryE.errorHandler();
+
+  VMQuery query;
+  query.filename(_DBFILENAMEDICTIONARY);
+  query.open();
+  CPPUNIT_ASSERT(0 != query._pDictionary);
+  CPPUNIT_ASSERT(query._pDictionary->size() > 0);
+  cencalvm::storage::ErrorHandler* pHandler = query.errorHandler();
+
+  const int numVals = 9;
+  double* pValsE = (numVals > 0) ? new double[numVals] : 0;
+  double* pVals = (numVals > 0) ? new double[numVals] : 0;
+
+  double* pLonLatElev = 0;
+  _dbLonLatElev(&pLonLatElev);
+
+  // Dictionary-encoded database must give exactly the same values for
+  // all types of queries.
+  const int numOctCoords = 4;
+  const VMQuery::QueryEnum queryTypes[] = { 
+    VMQuery::MAXRES, VMQuery::FIXEDRES, VMQuery::WAVERES };
+  const int numQueryTypes = 3;
+  const double periodMin[] = { 1.0, 800.0, 4000.0 };
+  const int numPeriods = 3;
+  for (int iType=0; iType < numQueryTypes; ++iType) {
+    queryE.queryType(queryTypes[iType]);
+    query.queryType(queryTypes[iType]);
+    const int numRes = (VMQuery::WAVERES == queryTypes[iType]) ?
+      numPeriods : _NUMOCTANTS;
+    for (int iRes=0; iRes < numRes; ++iRes) {
+      const double res = (VMQuery::WAVERES == queryTypes[iType]) ?
+	periodMin[iRes] :
+	_pGeom->edgeLen(_COORDS[numOctCoords*iRes+3]) / _pGeom->vertExag();
+      queryE.queryRes(res);
+      query.queryRes(res);
+      for (int iLoc=0, i=0; iLoc < _NUMOCTANTS; ++iLoc, i+=3) {
+	queryE.query(&pValsE, numVals, 
+		     pLonLatElev[i  ], pLonLatElev[i+1], pLonLatElev[i+2]);
+	query.query(&pVals, numVals, 
+		    pLonLatElev[i  ], pLonLatElev[i+1], pLonLatElev[i+2]);
+	for (int iVal=0; iVal < numVals; ++iVal)
+	  CPPUNIT_ASSERT_EQUAL(pValsE[iVal], pVals[iVal]);
+
+	// Locations without data give the same warnings.
+	CPPUNIT_ASSERT_EQUAL(pHandlerE->status(), pHandler->status());
+	CPPUNIT_ASSERT(0 == strcmp(pHandlerE->message(), pHandler->message()));
+	pHandlerE->resetStatus();
+	pHandler->resetStatus();
+      } // for
+    } // for
+  } // for
+
+  queryE.close();
+  query.close();
+  CPPUNIT_ASSERT(0 == query._pDictionary);
+
+  delete[] pLonLatElev; pLonLatElev = 0;
+  delete[] pVals; pVals = 0;
+  delete[] pValsE; pValsE = 0;
+} // testQueryDictionary
+
+// ----------------------------------------------------------------------
+// Test query() with renamed and compressed dictionary-encoded databases
+void
+cencalvm::query::TestVMQuery::testQueryDictionaryMoved(void)
+{ // testQueryDictionaryMoved
+  _createDB();
+
+  cencalvm::create::DictionaryEncoder encoder;
+  encoder.filenameIn(_DBFILENAME);
+  encoder.filenameOut(_DBFILENAMEDICTIONARY);
+  encoder.quiet(true);
+  encoder.encode();
+
+  // Database is renamed without renaming its dictionary.
+  CPPUNIT_ASSERT(0 == rename(_DBFILENAMEDICTIONARY,
+			     _DBFILENAMEDICTIONARYMOVED));
+
+  VMQuery queryE;
+  queryE.filename(_DBFILENAME);
+  queryE.open();
+
+  double* pLonLatElev = 0;
+  _dbLonLatElev(&pLonLatElev);
+
+  const int numVals = 9;
+  double* pValsE = (numVals > 0) ? new double[numVals] : 0;
+  double* pVals = (numVals > 0) ? new double[numVals] : 0;
+
+  const char* filenames[] = {
+    _DBFILENAMEDICTIONARYMOVED,
+    _DBFILENAMECOMPRESSED,
+  };
+  const int numFiles = 2;
+  for (int iFile=0; iFile < numFiles; ++iFile) {
+    if (1 == iFile) {
+      // Compressed database gets its own copy of the dictionary.
+      cencalvm::create::Compressor compressor;
+      compressor.filenameIn(_DBFILENAMEDICTIONARYMOVED);
+      compressor.filenameOut(_DBFILENAMECOMPRESSED);
+      compressor.quiet(true);
+      compressor.compress();
+      const std::string filenameDict =
+	cencalvm::storage::PayloadDictionary::filename(_DBFILENAMEDICTIONARY);
+      CPPUNIT_ASSERT(0 == remove(filenameDict.c_str()));
+    } // if
+
+    VMQuery query;
+    query.filename(filenames[iFile]);
+    query.open();
+    CPPUNIT_ASSERT(0 != query._pDictionary);
+    CPPUNIT_ASSERT(cencalvm::storage::ErrorHandler::OK ==
+		   query.errorHandler()->status());
+
+    for (int iLoc=0, i=0; iLoc < _NUMOCTANTS; ++iLoc, i+=3) {
+      queryE.query(&pValsE, numVals,
+		   pLonLatElev[i  ], pLonLatElev[i+1], pLonLatElev[i+2]);
+      query.query(&pVals, numVals,
+		  pLonLatElev[i  ], pLonLatElev[i+1], pLonLatElev[i+2]);
+      for (int iVal=0; iVal < numVals; ++iVal)
+	CPPUNIT_ASSERT_EQUAL(pValsE[iVal], pVals[iVal]);
+    } // for
+    query.close();
+  } // for
+  queryE.close();
+
+  delete[] pLonLatElev; pLonLatElev = 0;
+  delete[] pVals; pVals = 0;
+  delete[] pValsE; pValsE = 0;
+} // testQueryDictionaryMoved
+
+// ----------------------------------------------------------------------
+// Test filenameTrace()
+void
+cencalvm::query::TestVMQuery::testFilenameTrace(void)
+{ // testFilenameTrace
+  VMQuery query;
+  CPPUNIT_ASSERT(0 == strcmp("", query._filenameTrace.c_str()));
+  query.filenameTrace(_TRACEFILENAME);
+  CPPUNIT_ASSERT(0 == strcmp(_TRACEFILENAME, query._filenameTrace.c_str()));
+  CPPUNIT_ASSERT(0 == query._pTrace);
+} // testFilenameTrace
+
+// ----------------------------------------------------------------------
+// Test recording queries in trace and replaying trace
+void
+cencalvm::query::TestVMQuery::testQueryTrace(void)
+{ // testQueryTrace
+  assert(0 != _pGeom);
+
+  _createDB();
+
+  VMQuery query;
+  query.filename(_DBFILENAME);
+  query.filenameTrace(_TRACEFILENAME);
+  query.open();
+  CPPUNIT_ASSERT(0 != query._pTrace);
+  cencalvm::storage::ErrorHandler* pHandler = query.errorHandler();
+
+  double* pLonLatElev = 0;
+  _dbLonLatElev(&pLonLatElev);
+
+  // Maximum resolution queries of all values followed by fixed
+  // resolution queries of two values with squashing.
+  const int numLocs = _NUMOCTANTSLEAF;
+  const int numValsAll = 9;
+  double* pVals = new double[numValsAll];
+  query.queryType(VMQuery::MAXRES);
+  for (int iLoc=0, i=0; iLoc < numLocs; ++iLoc, i+=3)
+    query.query(&pVals, numValsAll,
+		pLonLatElev[i  ], pLonLatElev[i+1], pLonLatElev[i+2]);
+
+  const char* names[] = { "Vs", "Vp" };
+  const int numVals = 2;
+  const double queryRes = 800.0;
+  const double squashLimit = -3000.0;
+  query.queryVals(names, numVals);
+  query.queryType(VMQuery::FIXEDRES);
+  query.queryRes(queryRes);
+  query.squash(true, squashLimit);
+  for (int iLoc=0, i=0; iLoc < numLocs; ++iLoc, i+=3)
+    query.query(&pVals, numVals,
+		pLonLatElev[i  ], pLonLatElev[i+1], pLonLatElev[i+2]);
+  pHandler->resetStatus();
+  query.close();
+  CPPUNIT_ASSERT(0 == query._pTrace);
+  CPPUNIT_ASSERT(cencalvm::storage::ErrorHandler::OK == pHandler->status());
+  delete[] pVals; pVals = 0;
+
+  // Trace must contain the queries with their states.
+  QueryTrace trace;
+  trace.open(_TRACEFILENAME);
+  QueryTraceQueryStruct traceQuery;
+  QueryTraceStateStruct traceState;
+  uint64_t timePrev = 0;
+  for (int iLoc=0; iLoc < 2*numLocs; ++iLoc) {
+    CPPUNIT_ASSERT(trace.read(&traceQuery, &traceState));
+    const int i = 3*(iLoc % numLocs);
+    const double tolerance = 1.0e-06;
+    CPPUNIT_ASSERT_DOUBLES_EQUAL(pLonLatElev[i  ], traceQuery.lon, tolerance);
+    CPPUNIT_ASSERT_DOUBLES_EQUAL(pLonLatElev[i+1], traceQuery.lat, tolerance);
+    CPPUNIT_ASSERT_DOUBLES_EQUAL(pLonLatElev[i+2], traceQuery.elev, tolerance);
+    CPPUNIT_ASSERT(traceQuery.time >= timePrev);
+    timePrev = traceQuery.time;
+    if (iLoc < numLocs) {
+      CPPUNIT_ASSERT_EQUAL(int32_t(VMQuery::MAXRES), traceState.queryType);
+      CPPUNIT_ASSERT_EQUAL(int32_t(0), traceState.squash);
+      CPPUNIT_ASSERT_EQUAL(numValsAll, int(traceState.vals.size()));
+      for (int iVal=0; iVal < numValsAll; ++iVal)
+	CPPUNIT_ASSERT_EQUAL(iVal, int(traceState.vals[iVal]));
+    } else {
+      CPPUNIT_ASSERT_EQUAL(int32_t(VMQuery::FIXEDRES), traceState.queryType);
+      CPPUNIT_ASSERT_EQUAL(int32_t(1), traceState.squash);
+      CPPUNIT_ASSERT_DOUBLES_EQUAL(queryRes, traceState.queryRes, tolerance);
+      CPPUNIT_ASSERT_DOUBLES_EQUAL(squashLimit, traceState.squashLimit,
+				   tolerance);
+      CPPUNIT_ASSERT_EQUAL(numVals, int(traceState.vals.size()));
+      CPPUNIT_ASSERT_EQUAL(int32_t(1), traceState.vals[0]);
+      CPPUNIT_ASSERT_EQUAL(int32_t(0), traceState.vals[1]);
+    } // if/else
+  } // for
+  CPPUNIT_ASSERT(!trace.read(&traceQuery, &traceState));
+  trace.close();
+  delete[] pLonLatElev; pLonLatElev = 0;
+
+  // Replay trace with more than one thread.
+  QueryReplayer replayer;
+  replayer.filenameTrace(_TRACEFILENAME);
+  replayer.filename(_DBFILENAME);
+  replayer.numThreads(2);
+  replayer.filenameJSON(_REPLAYFILENAME);
+  replayer.quiet(true);
+  replayer.run();
+
+  std::ostringstream numQueries;
+  numQueries << "\"numQueries\": " << 2*numLocs << ",";
+  std::ifstream fin(_REPLAYFILENAME);
+  CPPUNIT_ASSERT(fin.is_open());
+  std::string line;
+  bool foundNumQueries = false;
+  while (std::getline(fin, line))
+    if (line.find(numQueries.str()) != std::string::npos)
+      foundNumQueries = true;
+  CPPUNIT_ASSERT(foundNumQueries);
+} // testQueryTrace
+
 // ----------------------------------------------------------------------
 // Create etree with desired number of octants.
 void
@@ -639,6 +1508,72 @@ cencalvm::query::TestVMQuery::_createDBExt(void) const
   averager.average();  
 } // _createDBExt
 
+// ----------------------------------------------------------------------
+// Create etree database with uniform leaf octants and free surface in
+// top layer of leaves and above leaves.
+void
+cencalvm::query::TestVMQuery::_createDBSurface(void) const
+{ // _createDBSurface
+  assert(0 != _pGeom);
+
+  const char* filenameTmp = "data/surfaceleaf.etree";
+
+  etree_t* db = etree_open(filenameTmp, O_CREAT|O_RDWR|O_TRUNC, 0, 0, 3);
+  CPPUNIT_ASSERT(0 != db);
+
+  int err = etree_registerschema(db, cencalvm::storage::Payload::SCHEMA);
+  CPPUNIT_ASSERT(0 == err);
+
+  // Leaves at level 12 are 100 m high, so the top layer of the block
+  // of 8x8x8 leaves spans elevations from -100 m to 0 m. The free
+  // surface is at -50 m in the first 4 columns along x and 1 m above
+  // the leaves in the others.
+  const int level = 12;
+  const int origin = 2048;
+  const int originZ = 3960;
+  const int numPerDim = 8;
+  const etree_tick_t tickLen = 0x80000000 >> level;
+  for (int iZ=0; iZ < numPerDim; ++iZ)
+    for (int iY=0; iY < numPerDim; ++iY)
+      for (int iX=0; iX < numPerDim; ++iX) {
+	etree_addr_t addr;
+	addr.x = (origin + iX) * tickLen;
+	addr.y = (origin + iY) * tickLen;
+	addr.z = (originZ + iZ) * tickLen;
+	addr.t = 0;
+	addr.level = level;
+	addr.type = ETREE_LEAF;
+
+	double lon = 0.0;
+	double lat = 0.0;
+	double elev = 0.0;
+	_pGeom->addrToLonLatElev(&lon, &lat, &elev, &addr);
+	const double elevSurf = (iX < numPerDim/2) ? -50.0 : 1.0;
+
+	cencalvm::storage::PayloadStruct payload;
+	payload.Vp = 3000.0;
+	payload.Vs = 1500.0;
+	payload.Density = 2500.0;
+	payload.Qp = 200.0;
+	payload.Qs = 100.0;
+	payload.DepthFreeSurf = elevSurf - elev;
+	payload.FaultBlock = 1;
+	payload.Zone = 2;
+
+	err = etree_insert(db, addr, &payload);
+	CPPUNIT_ASSERT(0 == err);
+      } // for
+
+  err = etree_close(db);
+  CPPUNIT_ASSERT(0 == err);
+
+  cencalvm::average::Averager averager;
+  averager.filenameIn(filenameTmp);
+  averager.filenameOut(_DBFILENAMESURFACE);
+  averager.quiet(true);
+  averager.average();
+} // _createDBSurface
+
 // ----------------------------------------------------------------------
 // Get lon/lat/elev of octants in database.
 void
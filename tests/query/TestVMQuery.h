@@ -56,6 +56,17 @@ class cencalvm::query::TestVMQuery : public CppUnit::TestFixture
   CPPUNIT_TEST( testCacheSizeExt );
   CPPUNIT_TEST( testFilenameExt );
   CPPUNIT_TEST( testQueryMaxExt );
+  CPPUNIT_TEST( testQueryCompact );
+  CPPUNIT_TEST( testQueryCompressed );
+  CPPUNIT_TEST( testQueryCompacted );
+  CPPUNIT_TEST( testCacheStats );
+  CPPUNIT_TEST( testReopenCache );
+  CPPUNIT_TEST( testQueryColumns );
+  CPPUNIT_TEST( testQueryPyramid );
+  CPPUNIT_TEST( testQueryDictionary );
+  CPPUNIT_TEST( testQueryDictionaryMoved );
+  CPPUNIT_TEST( testFilenameTrace );
+  CPPUNIT_TEST( testQueryTrace );
 
   CPPUNIT_TEST_SUITE_END();
 
@@ -113,6 +124,40 @@ public :
   /// Test query() with max query and extended model
   void testQueryMaxExt(void);
 
+  /// Test query() with compact database
+  void testQueryCompact(void);
+
+  /// Test query() with compressed database
+  void testQueryCompressed(void);
+
+  /// Test query() with compacted database
+  void testQueryCompacted(void);
+
+  /// Test cacheStats() with automatic cache sizing
+  void testCacheStats(void);
+
+  /// Test reopening etree database with cache of a different size
+  void testReopenCache(void);
+
+  /// Test query() with column-split database
+  void testQueryColumns(void);
+
+  /// Test query() with fixed resolution using brick pyramid
+  void testQueryPyramid(void);
+
+  /// Test query() with dictionary-encoded database
+  void testQueryDictionary(void);
+
+  /// Test query() with renamed and compressed dictionary-encoded
+  /// databases
+  void testQueryDictionaryMoved(void);
+
+  /// Test filenameTrace()
+  void testFilenameTrace(void);
+
+  /// Test recording queries in trace and replaying trace
+  void testQueryTrace(void);
+
   // PRIVATE METHODS ////////////////////////////////////////////////////
 private :
 
@@ -122,6 +167,12 @@ private :
   /// Create etree database for extended region.
   void _createDBExt(void) const;
 
+  /** Create etree database with uniform leaf octants and free surface
+   * in top layer of leaves in part of database and above leaves in
+   * the rest.
+   */
+  void _createDBSurface(void) const;
+
   /** Get lon/lat/elev of octants in database.
    *
    * @param ppCoords Pointer to array of coordinates
@@ -143,6 +194,16 @@ private :
   static const double _RELPAY[]; ///< Relative values of payload
   static const int _COORDS[]; ///< Coordinates of octants in database
   static const char* _DBFILENAME; ///< Filename of output etree database
+  static const char* _DBFILENAMECOMPACT; ///< Filename of compact database
+  static const char* _DBFILENAMECOMPRESSED; ///< Filename of compressed database
+  static const char* _DBFILENAMESURFACE; ///< Filename of database with free surface
+  static const char* _DBFILENAMECOMPACTED; ///< Filename of compacted database
+  static const char* _DBFILENAMECOLUMNS; ///< Filename of column-split database
+  static const char* _DBFILENAMEPYRAMID; ///< Filename of brick pyramid
+  static const char* _DBFILENAMEDICTIONARY; ///< Filename of dictionary-encoded database
+  static const char* _DBFILENAMEDICTIONARYMOVED; ///< Filename of renamed dictionary-encoded database
+  static const char* _TRACEFILENAME; ///< Filename of trace of queries
+  static const char* _REPLAYFILENAME; ///< Filename of JSON replay results
   static const int _NUMOCTANTS; ///< Number of octants
   static const int _NUMOCTANTSLEAF; ///< Number of octants for input
 
@@ -0,0 +1,256 @@
+// -*- C++ -*-
+//
+// ----------------------------------------------------------------------
+//
+//                           Brad T. Aagaard
+//                        U.S. Geological Survey
+//
+// {LicenseText}
+//
+// ----------------------------------------------------------------------
+//
+
+#include "TestBrickDB.h" // Implementation of class methods
+
+#include "cencalvm/storage/BrickDB.h" // USES BrickDB
+#include "cencalvm/storage/Payload.h" // USES PayloadStruct
+
+extern "C" {
+#include "etree.h"
+}
+
+#include <stdio.h> // USES fopen(), fwrite(), fclose()
+#include <string.h> // USES memset(), memcpy(), memcmp()
+#include <vector> // USES std::vector
+#include <stdexcept> // USES std::runtime_error
+
+// ----------------------------------------------------------------------
+CPPUNIT_TEST_SUITE_REGISTRATION( cencalvm::storage::TestBrickDB );
+
+// ----------------------------------------------------------------------
+const char* cencalvm::storage::TestBrickDB::_DBFILENAME =
+  "data/pyramid.bricks";
+
+// ----------------------------------------------------------------------
+// Test constructor
+void
+cencalvm::storage::TestBrickDB::testConstructor(void)
+{ // testConstructor
+  BrickDB db;
+  CPPUNIT_ASSERT_EQUAL(0, db.numLevels());
+  CPPUNIT_ASSERT(!db.hasLevel(0));
+} // testConstructor
+
+// ----------------------------------------------------------------------
+// Test open() and close()
+void
+cencalvm::storage::TestBrickDB::testOpen(void)
+{ // testOpen
+  _writeDB();
+
+  BrickDB db;
+  db.open(_DBFILENAME);
+  CPPUNIT_ASSERT_EQUAL(2, db.numLevels());
+  for (int level=0; level <= BrickDB::MAXLEVEL; ++level)
+    CPPUNIT_ASSERT_EQUAL(2 == level || 5 == level, db.hasLevel(level));
+  CPPUNIT_ASSERT(!db.hasLevel(-1));
+  CPPUNIT_ASSERT(!db.hasLevel(ETREE_MAXLEVEL));
+  db.close();
+  CPPUNIT_ASSERT(0 == db._pFile);
+  CPPUNIT_ASSERT(!db.hasLevel(2));
+
+  CPPUNIT_ASSERT_THROW(db.open("data/TestProjector.dat"),
+		       std::runtime_error);
+  CPPUNIT_ASSERT_THROW(db.open("data/nosuchfile.bricks"),
+		       std::runtime_error);
+} // testOpen
+
+// ----------------------------------------------------------------------
+// Test search()
+void
+cencalvm::storage::TestBrickDB::testSearch(void)
+{ // testSearch
+  _writeDB();
+
+  BrickDB db;
+  db.open(_DBFILENAME);
+
+  PayloadStruct payload;
+
+  // Level 2
+  for (int z=0; z < 4; ++z)
+    for (int y=0; y < 4; ++y)
+      for (int x=0; x < 4; ++x) {
+	CPPUNIT_ASSERT(0 == db.search(&payload, _address(2, x, y, z)));
+	if (1 == x && 2 == y && 3 == z)
+	  _checkNoData(payload);
+	else {
+	  const PayloadStruct payloadE = _payload(2, x, y, z);
+	  CPPUNIT_ASSERT(0 == memcmp(&payloadE, &payload, sizeof(payload)));
+	} // else
+      } // for
+
+  // Address at finer resolution within cell
+  etree_addr_t addr = _address(2, 3, 0, 2);
+  addr.x += 12345;
+  addr.z += 678;
+  CPPUNIT_ASSERT(0 == db.search(&payload, addr));
+  const PayloadStruct payloadE = _payload(2, 3, 0, 2);
+  CPPUNIT_ASSERT(0 == memcmp(&payloadE, &payload, sizeof(payload)));
+
+  // Level 5, first brick has data, second brick is empty, and cells
+  // at larger y and z are outside table of bricks.
+  const int brickSize = BrickDB::BRICKSIZE;
+  for (int z=0; z < 2*brickSize; z += 3)
+    for (int y=0; y < 2*brickSize; y += 5)
+      for (int x=0; x < 2*brickSize; x += 7) {
+	CPPUNIT_ASSERT(0 == db.search(&payload, _address(5, x, y, z)));
+	if (x < brickSize && y < brickSize && z < brickSize) {
+	  const PayloadStruct payloadE = _payload(5, x, y, z);
+	  CPPUNIT_ASSERT(0 == memcmp(&payloadE, &payload, sizeof(payload)));
+	} else
+	  _checkNoData(payload);
+      } // for
+
+  // Levels not in pyramid
+  CPPUNIT_ASSERT(0 != db.search(&payload, _address(3, 0, 0, 0)));
+  CPPUNIT_ASSERT(0 != db.search(&payload, _address(6, 0, 0, 0)));
+} // testSearch
+
+// ----------------------------------------------------------------------
+// Get address of cell.
+etree_addr_t
+cencalvm::storage::TestBrickDB::_address(const int level,
+					 const int x,
+					 const int y,
+					 const int z)
+{ // _address
+  const int shift = ETREE_MAXLEVEL - level;
+  etree_addr_t addr;
+  addr.x = etree_tick_t(x) << shift;
+  addr.y = etree_tick_t(y) << shift;
+  addr.z = etree_tick_t(z) << shift;
+  addr.t = 0;
+  addr.level = level;
+  addr.type = ETREE_LEAF;
+  return addr;
+} // _address
+
+// ----------------------------------------------------------------------
+// Get payload of cell in pyramid.
+cencalvm::storage::PayloadStruct
+cencalvm::storage::TestBrickDB::_payload(const int level,
+					 const int x,
+					 const int y,
+					 const int z)
+{ // _payload
+  const int index = x + 32*(y + 32*z);
+  PayloadStruct payload;
+  payload.Vp = 3000.0 + 100.0*level + index;
+  payload.Vs = 1500.0 + 50.0*level + 0.5*index;
+  payload.Density = 2200.0 + 0.25*index;
+  payload.Qp = 300.0 + level;
+  payload.Qs = 150.0 + level;
+  payload.DepthFreeSurf = 10.0 * index;
+  payload.FaultBlock = 10 + level;
+  payload.Zone = 1 + index % 7;
+  return payload;
+} // _payload
+
+// ----------------------------------------------------------------------
+// Check that payload holds NODATA values.
+void
+cencalvm::storage::TestBrickDB::_checkNoData(const PayloadStruct& payload)
+{ // _checkNoData
+  CPPUNIT_ASSERT_EQUAL(float(Payload::NODATAVAL), payload.Vp);
+  CPPUNIT_ASSERT_EQUAL(float(Payload::NODATAVAL), payload.Vs);
+  CPPUNIT_ASSERT_EQUAL(float(Payload::NODATAVAL), payload.Density);
+  CPPUNIT_ASSERT_EQUAL(float(Payload::NODATAVAL), payload.Qp);
+  CPPUNIT_ASSERT_EQUAL(float(Payload::NODATAVAL), payload.Qs);
+  CPPUNIT_ASSERT_EQUAL(float(Payload::NODATAVAL), payload.DepthFreeSurf);
+  CPPUNIT_ASSERT_EQUAL(int16_t(Payload::NODATABLOCK), payload.FaultBlock);
+  CPPUNIT_ASSERT_EQUAL(int16_t(Payload::NODATAZONE), payload.Zone);
+} // _checkNoData
+
+// ----------------------------------------------------------------------
+// Write brick pyramid.
+void
+cencalvm::storage::TestBrickDB::_writeDB(void) const
+{ // _writeDB
+  const int brickSize = BrickDB::BRICKSIZE;
+  const int cellsPerBrick = brickSize*brickSize*brickSize;
+  const int64_t brickBytes = cellsPerBrick*sizeof(PayloadStruct);
+  const int alignment = BrickDB::ALIGNMENT;
+  const int numLevels = 2;
+
+  PayloadStruct noData;
+  noData.Vp = Payload::NODATAVAL;
+  noData.Vs = Payload::NODATAVAL;
+  noData.Density = Payload::NODATAVAL;
+  noData.Qp = Payload::NODATAVAL;
+  noData.Qs = Payload::NODATAVAL;
+  noData.DepthFreeSurf = Payload::NODATAVAL;
+  noData.FaultBlock = Payload::NODATABLOCK;
+  noData.Zone = Payload::NODATAZONE;
+
+  BrickDBHeaderStruct header;
+  memset(&header, 0, sizeof(header));
+  memcpy(header.magic, BrickDB::MAGIC, sizeof(header.magic));
+  header.version = BrickDB::VERSION;
+  header.byteOrder = BrickDB::BYTEORDER;
+  header.brickSize = brickSize;
+  header.numLevels = numLevels;
+
+  BrickDBLevelStruct levels[2];
+  memset(levels, 0, sizeof(levels));
+  levels[0].level = 2;
+  levels[0].numBricks = 1;
+  levels[0].dims[0] = 1;
+  levels[0].dims[1] = 1;
+  levels[0].dims[2] = 1;
+  levels[1].level = 5;
+  levels[1].numBricks = 1;
+  levels[1].dims[0] = 2;
+  levels[1].dims[1] = 1;
+  levels[1].dims[2] = 1;
+
+  // Level 2
+  std::vector<PayloadStruct> brick2(cellsPerBrick, noData);
+  for (int z=0; z < 4; ++z)
+    for (int y=0; y < 4; ++y)
+      for (int x=0; x < 4; ++x)
+	if (!(1 == x && 2 == y && 3 == z))
+	  brick2[(z*brickSize + y)*brickSize + x] = _payload(2, x, y, z);
+  levels[0].tableOffset = sizeof(header) + sizeof(levels);
+  const int64_t brickOffset2 = alignment *
+    ((levels[0].tableOffset + sizeof(int64_t) + alignment - 1) / alignment);
+  const int64_t table2[1] = { brickOffset2 };
+
+  // Level 5
+  std::vector<PayloadStruct> brick5(cellsPerBrick);
+  for (int z=0; z < brickSize; ++z)
+    for (int y=0; y < brickSize; ++y)
+      for (int x=0; x < brickSize; ++x)
+	brick5[(z*brickSize + y)*brickSize + x] = _payload(5, x, y, z);
+  levels[1].tableOffset = brickOffset2 + brickBytes;
+  const int64_t brickOffset5 = alignment *
+    ((levels[1].tableOffset + 2*sizeof(int64_t) + alignment - 1) / alignment);
+  const int64_t table5[2] = { brickOffset5, -1 };
+
+  FILE* fout = fopen(_DBFILENAME, "wb");
+  CPPUNIT_ASSERT(0 != fout);
+  CPPUNIT_ASSERT(1 == fwrite(&header, sizeof(header), 1, fout));
+  CPPUNIT_ASSERT(1 == fwrite(levels, sizeof(levels), 1, fout));
+  CPPUNIT_ASSERT(1 == fwrite(table2, sizeof(table2), 1, fout));
+  std::vector<char> padding(alignment, '\0');
+  int64_t numPad = brickOffset2 - levels[0].tableOffset - sizeof(table2);
+  CPPUNIT_ASSERT(numPad == int64_t(fwrite(&padding[0], 1, numPad, fout)));
+  CPPUNIT_ASSERT(1 == fwrite(&brick2[0], brickBytes, 1, fout));
+  CPPUNIT_ASSERT(1 == fwrite(table5, sizeof(table5), 1, fout));
+  numPad = brickOffset5 - levels[1].tableOffset - sizeof(table5);
+  CPPUNIT_ASSERT(numPad == int64_t(fwrite(&padding[0], 1, numPad, fout)));
+  CPPUNIT_ASSERT(1 == fwrite(&brick5[0], brickBytes, 1, fout));
+  CPPUNIT_ASSERT(0 == fclose(fout));
+} // _writeDB
+
+// End of file
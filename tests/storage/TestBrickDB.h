@@ -0,0 +1,110 @@
+// -*- C++ -*-
+//
+// ----------------------------------------------------------------------
+//
+//                           Brad T. Aagaard
+//                        U.S. Geological Survey
+//
+// {LicenseText}
+//
+// ----------------------------------------------------------------------
+//
+
+/** @file tests/TestBrickDB.h
+ *
+ * @brief C++ TestBrickDB object
+ *
+ * C++ unit testing for BrickDB.
+ */
+
+#if !defined(cencalvm_storage_testbrickdb_h)
+#define cencalvm_storage_testbrickdb_h
+
+#include <cppunit/extensions/HelperMacros.h>
+
+#include "cencalvm/storage/etreefwd.h" // USES etree_addr_t
+
+namespace cencalvm {
+  namespace storage {
+    class TestBrickDB;
+    struct PayloadStruct; // USES PayloadStruct
+  } // storage
+} // cencalvm
+
+/// C++ unit testing for BrickDB
+class cencalvm::storage::TestBrickDB : public CppUnit::TestFixture
+{ // class TestBrickDB
+
+  // CPPUNIT TEST SUITE /////////////////////////////////////////////////
+  CPPUNIT_TEST_SUITE( TestBrickDB );
+  CPPUNIT_TEST( testConstructor );
+  CPPUNIT_TEST( testOpen );
+  CPPUNIT_TEST( testSearch );
+  CPPUNIT_TEST_SUITE_END();
+
+  // PUBLIC METHODS /////////////////////////////////////////////////////
+public :
+
+  /// Test constructor
+  void testConstructor(void);
+
+  /// Test open() and close()
+  void testOpen(void);
+
+  /// Test search()
+  void testSearch(void);
+
+  // PRIVATE METHODS ////////////////////////////////////////////////////
+private :
+
+  /** Get address of cell.
+   *
+   * @param level Level of cell
+   * @param x Index of cell along x
+   * @param y Index of cell along y
+   * @param z Index of cell along z
+   *
+   * @returns Address of cell
+   */
+  static etree_addr_t _address(const int level,
+			       const int x,
+			       const int y,
+			       const int z);
+
+  /** Get payload of cell in pyramid.
+   *
+   * @param level Level of cell
+   * @param x Index of cell along x
+   * @param y Index of cell along y
+   * @param z Index of cell along z
+   *
+   * @returns Payload of cell
+   */
+  static PayloadStruct _payload(const int level,
+				const int x,
+				const int y,
+				const int z);
+
+  /** Check that payload holds NODATA values.
+   *
+   * @param payload Payload to check
+   */
+  static void _checkNoData(const PayloadStruct& payload);
+
+  /** Write brick pyramid with levels 2 and 5. Level 2 has one brick
+   * with data in all cells except (1,2,3). Level 5 has a table of two
+   * bricks along x with data in all cells of the first brick and an
+   * empty second brick.
+   */
+  void _writeDB(void) const;
+
+  // PRIVATE MEMBERS ////////////////////////////////////////////////////
+private :
+
+  static const char* _DBFILENAME; ///< Filename of brick pyramid
+
+}; // class TestBrickDB
+
+#endif // cencalvm_storage_testbrickdb_h
+
+// End of file
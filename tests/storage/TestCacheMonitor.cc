@@ -0,0 +1,349 @@
+// -*- C++ -*-
+//
+// ----------------------------------------------------------------------
+//
+//                           Brad T. Aagaard
+//                        U.S. Geological Survey
+//
+// {LicenseText}
+//
+// ----------------------------------------------------------------------
+//
+
+#include "TestCacheMonitor.h" // Implementation of class methods
+
+#include "cencalvm/storage/CacheMonitor.h" // USES CacheMonitor
+
+#include <fcntl.h> // USES open()
+#include <unistd.h> // USES pread(), close()
+#include <stdio.h> // USES remove()
+#include <string.h> // USES memset()
+#include <vector> // USES std::vector
+#include <fstream> // USES std::ofstream
+
+// ----------------------------------------------------------------------
+CPPUNIT_TEST_SUITE_REGISTRATION( cencalvm::storage::TestCacheMonitor );
+
+// ----------------------------------------------------------------------
+const char* cencalvm::storage::TestCacheMonitor::_FILENAME =
+  "data/cachemonitor.dat";
+
+// ----------------------------------------------------------------------
+// Test constructor
+void
+cencalvm::storage::TestCacheMonitor::testConstructor(void)
+{ // testConstructor
+  CacheMonitor monitor;
+  CPPUNIT_ASSERT_EQUAL(-1, monitor._fd);
+  CPPUNIT_ASSERT_EQUAL(1, monitor._countdown);
+
+  CacheStatsStruct stats;
+  monitor.stats(&stats);
+  CPPUNIT_ASSERT_EQUAL(uint64_t(0), stats.numSearches);
+  CPPUNIT_ASSERT_EQUAL(uint64_t(0), stats.numHits);
+  CPPUNIT_ASSERT_EQUAL(uint64_t(0), stats.numMisses);
+  CPPUNIT_ASSERT_EQUAL(uint64_t(0), stats.numReads);
+  CPPUNIT_ASSERT_EQUAL(uint64_t(0), stats.capacity);
+  CPPUNIT_ASSERT(stats.isEstimate);
+} // testConstructor
+
+// ----------------------------------------------------------------------
+// Test beginSearch() and endSearch() around reads from a file
+void
+cencalvm::storage::TestCacheMonitor::testSample(void)
+{ // testSample
+  const int numBytes = 2*CacheMonitor::PAGESIZE;
+  std::vector<char> buffer(numBytes, 'a');
+  { // write file
+    std::ofstream fout(_FILENAME, std::ios::binary);
+    fout.write(&buffer[0], numBytes);
+    CPPUNIT_ASSERT(fout.good());
+  } // write file
+  const int fd = open(_FILENAME, O_RDONLY);
+  CPPUNIT_ASSERT(fd >= 0);
+
+  // Searches in even intervals read from the file, so the first and
+  // third sampled searches miss and the others hit.
+  CacheMonitor monitor;
+  monitor.open(1);
+  const int interval = CacheMonitor::SAMPLEINTERVAL;
+  const int numSearches = 4*interval;
+  int numSampled = 0;
+  for (int iSearch=0; iSearch < numSearches; ++iSearch) {
+    const bool isSampled = monitor.beginSearch();
+    CPPUNIT_ASSERT_EQUAL(0 == iSearch % interval && monitor._fd >= 0,
+			 isSampled);
+    if (0 == (iSearch / interval) % 2)
+      CPPUNIT_ASSERT_EQUAL(ssize_t(numBytes),
+			   pread(fd, &buffer[0], numBytes, 0));
+    if (isSampled) {
+      monitor.endSearch();
+      ++numSampled;
+    } // if
+  } // for
+  close(fd);
+  remove(_FILENAME);
+
+  CacheStatsStruct stats;
+  monitor.stats(&stats);
+  CPPUNIT_ASSERT_EQUAL(uint64_t(numSearches), stats.numSearches);
+  if (0 == numSampled) // I/O counters of thread are not available
+    return;
+
+  CPPUNIT_ASSERT_EQUAL(4, numSampled);
+  CPPUNIT_ASSERT_EQUAL(uint64_t(2*interval), stats.numMisses);
+  CPPUNIT_ASSERT_EQUAL(uint64_t(2*interval), stats.numHits);
+  CPPUNIT_ASSERT_EQUAL(uint64_t(2*interval*numBytes), stats.bytesRead);
+  CPPUNIT_ASSERT_EQUAL(uint64_t(4*interval), stats.numReads);
+  CPPUNIT_ASSERT_EQUAL(uint64_t(256), stats.capacity);
+  CPPUNIT_ASSERT_EQUAL(uint64_t(4*interval), stats.numResident);
+  CPPUNIT_ASSERT_EQUAL(uint64_t(0), stats.numEvictions);
+  CPPUNIT_ASSERT_EQUAL(1, stats.cacheSize);
+} // testSample
+
+// ----------------------------------------------------------------------
+// Test stats()
+void
+cencalvm::storage::TestCacheMonitor::testStats(void)
+{ // testStats
+  CacheMonitor monitor;
+  monitor.open(1);
+  monitor._numSearches = 1000;
+  monitor._numSampled = 10;
+  monitor._numSampledMisses = 3;
+  monitor._sampledBytes = 4*CacheMonitor::PAGESIZE;
+
+  CacheStatsStruct stats;
+  monitor.stats(&stats);
+  CPPUNIT_ASSERT_EQUAL(uint64_t(1000), stats.numSearches);
+  CPPUNIT_ASSERT_EQUAL(uint64_t(300), stats.numMisses);
+  CPPUNIT_ASSERT_EQUAL(uint64_t(700), stats.numHits);
+  CPPUNIT_ASSERT_EQUAL(uint64_t(400), stats.numReads);
+  CPPUNIT_ASSERT_EQUAL(uint64_t(400*CacheMonitor::PAGESIZE), stats.bytesRead);
+  CPPUNIT_ASSERT_EQUAL(uint64_t(256), stats.capacity);
+  CPPUNIT_ASSERT_EQUAL(uint64_t(256), stats.numResident);
+  CPPUNIT_ASSERT_EQUAL(uint64_t(144), stats.numEvictions);
+  CPPUNIT_ASSERT_EQUAL(1, stats.cacheSize);
+  CPPUNIT_ASSERT_EQUAL(0, stats.numResizes);
+  CPPUNIT_ASSERT(stats.isEstimate);
+
+  // Opening clears statistics.
+  monitor.open(2);
+  monitor.stats(&stats);
+  CPPUNIT_ASSERT_EQUAL(uint64_t(0), stats.numSearches);
+  CPPUNIT_ASSERT_EQUAL(uint64_t(0), stats.numReads);
+  CPPUNIT_ASSERT_EQUAL(uint64_t(512), stats.capacity);
+  CPPUNIT_ASSERT_EQUAL(2, stats.cacheSize);
+} // testStats
+
+// ----------------------------------------------------------------------
+// Test resize()
+void
+cencalvm::storage::TestCacheMonitor::testResize(void)
+{ // testResize
+  CacheMonitor monitor;
+  monitor.open(1);
+  monitor._numSearches = 1000;
+  monitor._numSampled = 10;
+  monitor._numSampledMisses = 3;
+  monitor._sampledBytes = 4*CacheMonitor::PAGESIZE;
+
+  // Reopened cache is empty, but counts are kept.
+  monitor.resize(4);
+  CacheStatsStruct stats;
+  monitor.stats(&stats);
+  CPPUNIT_ASSERT_EQUAL(uint64_t(1000), stats.numSearches);
+  CPPUNIT_ASSERT_EQUAL(uint64_t(400), stats.numReads);
+  CPPUNIT_ASSERT_EQUAL(uint64_t(1024), stats.capacity);
+  CPPUNIT_ASSERT_EQUAL(uint64_t(0), stats.numResident);
+  CPPUNIT_ASSERT_EQUAL(uint64_t(144), stats.numEvictions);
+  CPPUNIT_ASSERT_EQUAL(4, stats.cacheSize);
+  CPPUNIT_ASSERT_EQUAL(1, stats.numResizes);
+
+  monitor._numSearches = 2000;
+  monitor._numSampled = 20;
+  monitor._sampledBytes = 5*CacheMonitor::PAGESIZE;
+  monitor.stats(&stats);
+  CPPUNIT_ASSERT_EQUAL(uint64_t(500), stats.numReads);
+  CPPUNIT_ASSERT_EQUAL(uint64_t(100), stats.numResident);
+  CPPUNIT_ASSERT_EQUAL(uint64_t(144), stats.numEvictions);
+} // testResize
+
+// ----------------------------------------------------------------------
+// Test availableMemory() and maxSize()
+void
+cencalvm::storage::TestCacheMonitor::testMaxSize(void)
+{ // testMaxSize
+  const uint64_t memory = CacheMonitor::availableMemory();
+  CPPUNIT_ASSERT(memory > 0);
+
+  // Limited by size of file.
+  const int numBytes = 40*1024*1024;
+  { // write file
+    std::ofstream fout(_FILENAME, std::ios::binary);
+    fout.seekp(numBytes-1);
+    fout.put('a');
+    CPPUNIT_ASSERT(fout.good());
+  } // write file
+  const double MB = 1024.0*1024.0;
+  if (memory > 41*MB)
+    CPPUNIT_ASSERT_EQUAL(41, CacheMonitor::maxSize(_FILENAME, 1.0));
+
+  // Limited by available memory (which changes as the test runs).
+  CPPUNIT_ASSERT_EQUAL(CacheMonitor::MINSIZE,
+		       CacheMonitor::maxSize(_FILENAME, 1.0e-12));
+  if (memory > 41*MB) {
+    const double fraction = 32*MB / memory;
+    const int size = CacheMonitor::maxSize(_FILENAME, fraction);
+    CPPUNIT_ASSERT(size >= 30 && size <= 34);
+  } // if
+  remove(_FILENAME);
+
+  // Database that does not exist is limited by memory.
+  const int size = CacheMonitor::maxSize(_FILENAME, 0.5);
+  CPPUNIT_ASSERT(size >= CacheMonitor::MINSIZE);
+  CPPUNIT_ASSERT(size <= int(memory / MB) || size == CacheMonitor::MINSIZE);
+} // testMaxSize
+
+// ----------------------------------------------------------------------
+// Test chooseSize()
+void
+cencalvm::storage::TestCacheMonitor::testChooseSize(void)
+{ // testChooseSize
+  std::string reason = "";
+
+  // Misses with evictions grow cache up to maximum size.
+  CacheStatsStruct stats = _stats(32, 8192, 100000, 20000, 5000);
+  CacheStatsStruct batch = _stats(32, 8192, 1000, 200, 50);
+  CPPUNIT_ASSERT_EQUAL(64, CacheMonitor::chooseSize(&reason, stats, batch,
+						    1000));
+  CPPUNIT_ASSERT(!reason.empty());
+  CPPUNIT_ASSERT_EQUAL(48, CacheMonitor::chooseSize(&reason, stats, batch,
+						    48));
+  reason = "";
+  CPPUNIT_ASSERT_EQUAL(32, CacheMonitor::chooseSize(&reason, stats, batch,
+						    32));
+  CPPUNIT_ASSERT(reason.empty());
+
+  // Misses without evictions while cache fills do not change size.
+  stats = _stats(32, 4096, 1000, 800, 0);
+  batch = _stats(32, 4096, 1000, 800, 0);
+  CPPUNIT_ASSERT_EQUAL(32, CacheMonitor::chooseSize(&reason, stats, batch,
+						    1000));
+  CPPUNIT_ASSERT(reason.empty());
+
+  // Few misses with evictions do not change size.
+  stats = _stats(32, 8192, 100000, 1000, 100);
+  batch = _stats(32, 8192, 1000, 10, 5);
+  CPPUNIT_ASSERT_EQUAL(32, CacheMonitor::chooseSize(&reason, stats, batch,
+						    1000));
+  CPPUNIT_ASSERT(reason.empty());
+
+  // Small working set shrinks cache to twice the working set.
+  stats = _stats(256, 8192, 100000, 8192, 0);
+  batch = _stats(256, 8192, 1000, 0, 0);
+  CPPUNIT_ASSERT_EQUAL(64, CacheMonitor::chooseSize(&reason, stats, batch,
+						    1000));
+  CPPUNIT_ASSERT(!reason.empty());
+
+  // Cache does not shrink below minimum size.
+  stats = _stats(64, 256, 100000, 256, 0);
+  batch = _stats(64, 256, 1000, 0, 0);
+  CPPUNIT_ASSERT_EQUAL(CacheMonitor::MINSIZE,
+		       CacheMonitor::chooseSize(&reason, stats, batch, 1000));
+
+  // Working set filling more than a quarter of cache does not change size.
+  reason = "";
+  stats = _stats(64, 8192, 100000, 8192, 0);
+  batch = _stats(64, 8192, 1000, 0, 0);
+  CPPUNIT_ASSERT_EQUAL(64, CacheMonitor::chooseSize(&reason, stats, batch,
+						    1000));
+  CPPUNIT_ASSERT(reason.empty());
+
+  // No searches in batch do not change size.
+  stats = _stats(64, 0, 0, 0, 0);
+  batch = _stats(64, 0, 0, 0, 0);
+  CPPUNIT_ASSERT_EQUAL(64, CacheMonitor::chooseSize(&reason, stats, batch,
+						    1000));
+  CPPUNIT_ASSERT(reason.empty());
+} // testChooseSize
+
+// ----------------------------------------------------------------------
+// Test worthReopening()
+void
+cencalvm::storage::TestCacheMonitor::testWorthReopening(void)
+{ // testWorthReopening
+  // Cache of 32 MB holds 8192 pages.
+  const CacheStatsStruct stats = _stats(32, 8192, 100000, 20000, 50000);
+
+  // Growing needs more evictions since last resize than 4 refills.
+  CacheStatsStruct sinceResize = _stats(32, 8192, 50000, 10000, 30000);
+  CPPUNIT_ASSERT(!CacheMonitor::worthReopening(stats, sinceResize, 64));
+  sinceResize.numEvictions = 40000;
+  CPPUNIT_ASSERT(CacheMonitor::worthReopening(stats, sinceResize, 64));
+
+  // Same size is never worth reopening.
+  CPPUNIT_ASSERT(!CacheMonitor::worthReopening(stats, sinceResize, 32));
+
+  // Shrinking needs more pages freed than 4 refills.
+  const CacheStatsStruct statsSmall = _stats(256, 8192, 100000, 8192, 0);
+  CPPUNIT_ASSERT(CacheMonitor::worthReopening(statsSmall, statsSmall, 64));
+  const CacheStatsStruct statsLarge = _stats(256, 16000, 100000, 16000, 0);
+  CPPUNIT_ASSERT(!CacheMonitor::worthReopening(statsLarge, statsLarge, 128));
+} // testWorthReopening
+
+// ----------------------------------------------------------------------
+// Test difference()
+void
+cencalvm::storage::TestCacheMonitor::testDifference(void)
+{ // testDifference
+  CacheStatsStruct statsBegin = _stats(32, 100, 1000, 200, 10);
+  statsBegin.numReads = 300;
+  statsBegin.bytesRead = 300*CacheMonitor::PAGESIZE;
+  CacheStatsStruct stats = _stats(64, 150, 3000, 500, 40);
+  stats.numReads = 900;
+  stats.bytesRead = 900*CacheMonitor::PAGESIZE;
+  stats.numResizes = 1;
+
+  CacheStatsStruct diff;
+  CacheMonitor::difference(&diff, stats, statsBegin);
+  CPPUNIT_ASSERT_EQUAL(uint64_t(2000), diff.numSearches);
+  CPPUNIT_ASSERT_EQUAL(uint64_t(1700), diff.numHits);
+  CPPUNIT_ASSERT_EQUAL(uint64_t(300), diff.numMisses);
+  CPPUNIT_ASSERT_EQUAL(uint64_t(600), diff.numReads);
+  CPPUNIT_ASSERT_EQUAL(uint64_t(30), diff.numEvictions);
+  CPPUNIT_ASSERT_EQUAL(uint64_t(600*CacheMonitor::PAGESIZE), diff.bytesRead);
+  CPPUNIT_ASSERT_EQUAL(uint64_t(150), diff.numResident);
+  CPPUNIT_ASSERT_EQUAL(stats.capacity, diff.capacity);
+  CPPUNIT_ASSERT_EQUAL(64, diff.cacheSize);
+  CPPUNIT_ASSERT_EQUAL(1, diff.numResizes);
+
+  // Estimated counts that decrease are clipped at zero.
+  statsBegin.numMisses = 600;
+  CacheMonitor::difference(&diff, stats, statsBegin);
+  CPPUNIT_ASSERT_EQUAL(uint64_t(0), diff.numMisses);
+} // testDifference
+
+// ----------------------------------------------------------------------
+// Create statistics with counts of cache.
+cencalvm::storage::CacheStatsStruct
+cencalvm::storage::TestCacheMonitor::_stats(const int cacheSize,
+					    const uint64_t numResident,
+					    const uint64_t numSearches,
+					    const uint64_t numMisses,
+					    const uint64_t numEvictions)
+{ // _stats
+  CacheStatsStruct stats;
+  memset(&stats, 0, sizeof(stats));
+  stats.cacheSize = cacheSize;
+  stats.capacity = uint64_t(cacheSize) * 1024 * 1024 / CacheMonitor::PAGESIZE;
+  stats.numResident = numResident;
+  stats.numSearches = numSearches;
+  stats.numMisses = numMisses;
+  stats.numHits = numSearches - numMisses;
+  stats.numEvictions = numEvictions;
+  stats.isEstimate = true;
+  return stats;
+} // _stats
+
+// End of file
@@ -0,0 +1,105 @@
+// -*- C++ -*-
+//
+// ----------------------------------------------------------------------
+//
+//                           Brad T. Aagaard
+//                        U.S. Geological Survey
+//
+// {LicenseText}
+//
+// ----------------------------------------------------------------------
+//
+
+/** @file tests/TestCacheMonitor.h
+ *
+ * @brief C++ TestCacheMonitor object
+ *
+ * C++ unit testing for CacheMonitor.
+ */
+
+#if !defined(cencalvm_storage_testcachemonitor_h)
+#define cencalvm_storage_testcachemonitor_h
+
+#include <cppunit/extensions/HelperMacros.h>
+
+#include <inttypes.h> // USES uint64_t
+
+namespace cencalvm {
+  namespace storage {
+    class TestCacheMonitor;
+    struct CacheStatsStruct; // USES CacheStatsStruct
+  } // storage
+} // cencalvm
+
+/// C++ unit testing for CacheMonitor
+class cencalvm::storage::TestCacheMonitor : public CppUnit::TestFixture
+{ // class TestCacheMonitor
+
+  // CPPUNIT TEST SUITE /////////////////////////////////////////////////
+  CPPUNIT_TEST_SUITE( TestCacheMonitor );
+  CPPUNIT_TEST( testConstructor );
+  CPPUNIT_TEST( testSample );
+  CPPUNIT_TEST( testStats );
+  CPPUNIT_TEST( testResize );
+  CPPUNIT_TEST( testMaxSize );
+  CPPUNIT_TEST( testChooseSize );
+  CPPUNIT_TEST( testWorthReopening );
+  CPPUNIT_TEST( testDifference );
+  CPPUNIT_TEST_SUITE_END();
+
+  // PUBLIC METHODS /////////////////////////////////////////////////////
+public :
+
+  /// Test constructor
+  void testConstructor(void);
+
+  /// Test beginSearch() and endSearch() around reads from a file
+  void testSample(void);
+
+  /// Test stats()
+  void testStats(void);
+
+  /// Test resize()
+  void testResize(void);
+
+  /// Test availableMemory() and maxSize()
+  void testMaxSize(void);
+
+  /// Test chooseSize()
+  void testChooseSize(void);
+
+  /// Test worthReopening()
+  void testWorthReopening(void);
+
+  /// Test difference()
+  void testDifference(void);
+
+  // PRIVATE METHODS ////////////////////////////////////////////////////
+private :
+
+  /** Create statistics with counts of cache.
+   *
+   * @param cacheSize Size of cache in MB
+   * @param numResident Number of pages in cache
+   * @param numSearches Number of searches
+   * @param numMisses Number of searches that read from the file
+   * @param numEvictions Number of pages evicted
+   *
+   * @returns Statistics
+   */
+  static CacheStatsStruct _stats(const int cacheSize,
+				 const uint64_t numResident,
+				 const uint64_t numSearches,
+				 const uint64_t numMisses,
+				 const uint64_t numEvictions);
+
+  // PRIVATE MEMBERS ////////////////////////////////////////////////////
+private :
+
+  static const char* _FILENAME; ///< Filename of file read in searches
+
+}; // class TestCacheMonitor
+
+#endif // cencalvm_storage_testcachemonitor_h
+
+// End of file
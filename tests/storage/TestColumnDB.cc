@@ -0,0 +1,288 @@
+// -*- C++ -*-
+//
+// ----------------------------------------------------------------------
+//
+//                           Brad T. Aagaard
+//                        U.S. Geological Survey
+//
+// {LicenseText}
+//
+// ----------------------------------------------------------------------
+//
+
+#include "TestColumnDB.h" // Implementation of class methods
+
+#include "cencalvm/storage/ColumnDB.h" // USES ColumnDB
+#include "cencalvm/storage/Payload.h" // USES PayloadStruct
+
+extern "C" {
+#include "etree.h"
+}
+
+#include <stdio.h> // USES fopen(), fwrite(), fclose()
+#include <string.h> // USES memset(), memcpy(), memcmp(), strcmp()
+#include <stdexcept> // USES std::runtime_error
+
+// ----------------------------------------------------------------------
+CPPUNIT_TEST_SUITE_REGISTRATION( cencalvm::storage::TestColumnDB );
+
+// ----------------------------------------------------------------------
+const char* cencalvm::storage::TestColumnDB::_DBFILENAME =
+  "data/columns.etree";
+const int cencalvm::storage::TestColumnDB::_NUMOCTANTS = 10;
+const etree_tick_t cencalvm::storage::TestColumnDB::_TICKLEN1 =
+  0x80000000 >> 1;
+const etree_tick_t cencalvm::storage::TestColumnDB::_TICKLEN2 =
+  0x80000000 >> 2;
+
+// ----------------------------------------------------------------------
+// Test constructor
+void
+cencalvm::storage::TestColumnDB::testConstructor(void)
+{ // testConstructor
+  ColumnDB db;
+} // testConstructor
+
+// ----------------------------------------------------------------------
+// Test columnFilename() and columnSize()
+void
+cencalvm::storage::TestColumnDB::testColumnFilename(void)
+{ // testColumnFilename
+  CPPUNIT_ASSERT_EQUAL(8, ColumnDB::NUMCOLUMNS);
+  CPPUNIT_ASSERT(std::string("model.col.Vp") ==
+		 ColumnDB::columnFilename("model.col", 0));
+  CPPUNIT_ASSERT(std::string("model.col.DepthFreeSurf") ==
+		 ColumnDB::columnFilename("model.col", 5));
+  CPPUNIT_ASSERT(std::string("model.col.Zone") ==
+		 ColumnDB::columnFilename("model.col", 7));
+
+  size_t payloadSize = 0;
+  for (int i=0; i < ColumnDB::NUMCOLUMNS; ++i)
+    payloadSize += ColumnDB::columnSize(i);
+  CPPUNIT_ASSERT_EQUAL(sizeof(PayloadStruct), payloadSize);
+} // testColumnFilename
+
+// ----------------------------------------------------------------------
+// Test isColumnar()
+void
+cencalvm::storage::TestColumnDB::testIsColumnar(void)
+{ // testIsColumnar
+  _writeDB();
+
+  CPPUNIT_ASSERT(ColumnDB::isColumnar(_DBFILENAME));
+  CPPUNIT_ASSERT(!ColumnDB::isColumnar("data/TestProjector.dat"));
+  CPPUNIT_ASSERT(!ColumnDB::isColumnar("data/nosuchfile.etree"));
+} // testIsColumnar
+
+// ----------------------------------------------------------------------
+// Test open() and close()
+void
+cencalvm::storage::TestColumnDB::testOpen(void)
+{ // testOpen
+  _writeDB();
+
+  ColumnDB db;
+  db.open(_DBFILENAME);
+  CPPUNIT_ASSERT_EQUAL(int64_t(_NUMOCTANTS), db.numOctants());
+  CPPUNIT_ASSERT(0 == strcmp(Payload::SCHEMA, db.schema()));
+  CPPUNIT_ASSERT(0 == strcmp("test metadata", db.appmeta()));
+  for (int i=0; i < ColumnDB::NUMCOLUMNS; ++i)
+    CPPUNIT_ASSERT(0 == db._pColumns[i]);
+  db.close();
+  CPPUNIT_ASSERT(0 == db._pKeys);
+
+  CPPUNIT_ASSERT_THROW(db.open("data/TestProjector.dat"),
+		       std::runtime_error);
+  CPPUNIT_ASSERT_THROW(db.open("data/nosuchfile.etree"),
+		       std::runtime_error);
+} // testOpen
+
+// ----------------------------------------------------------------------
+// Test search()
+void
+cencalvm::storage::TestColumnDB::testSearch(void)
+{ // testSearch
+  _writeDB();
+
+  ColumnDB db;
+  db.open(_DBFILENAME);
+
+  // Octants in database
+  etree_addr_t resAddr;
+  PayloadStruct payload;
+  for (int iOctant=0; iOctant < _NUMOCTANTS; ++iOctant) {
+    const etree_addr_t addr = _address(iOctant);
+    CPPUNIT_ASSERT(0 == db.search(&resAddr, &payload, addr));
+    CPPUNIT_ASSERT_EQUAL(addr.level, resAddr.level);
+    CPPUNIT_ASSERT_EQUAL(int(addr.type), int(resAddr.type));
+    _checkPayload(_payload(iOctant), payload);
+  } // for
+
+  // Point in child 5
+  etree_addr_t addr;
+  addr.x = _TICKLEN2 + 7;
+  addr.y = 3;
+  addr.z = _TICKLEN2 + 1234;
+  addr.t = 0;
+  addr.level = ETREE_MAXLEVEL;
+  addr.type = ETREE_LEAF;
+  CPPUNIT_ASSERT(0 == db.search(&resAddr, &payload, addr));
+  CPPUNIT_ASSERT_EQUAL(2, resAddr.level);
+  _checkPayload(_payload(7), payload);
+
+  // Point outside octant at level 1 is only in root octant
+  addr.x = _TICKLEN1 + 5;
+  CPPUNIT_ASSERT(0 == db.search(&resAddr, &payload, addr));
+  CPPUNIT_ASSERT_EQUAL(0, resAddr.level);
+  _checkPayload(_payload(0), payload);
+
+  // Interior octant not in database
+  addr.x = _TICKLEN1;
+  addr.y = 0;
+  addr.z = 0;
+  addr.level = 1;
+  addr.type = ETREE_INTERIOR;
+  CPPUNIT_ASSERT(0 != db.search(&resAddr, &payload, addr));
+} // testSearch
+
+// ----------------------------------------------------------------------
+// Test search() with subset of columns
+void
+cencalvm::storage::TestColumnDB::testSearchColumns(void)
+{ // testSearchColumns
+  _writeDB();
+
+  ColumnDB db;
+  db.open(_DBFILENAME);
+
+  // Vs and FaultBlock
+  const int columns = (1 << 1) | (1 << 6);
+  etree_addr_t resAddr;
+  PayloadStruct payload;
+  for (int iOctant=0; iOctant < _NUMOCTANTS; ++iOctant) {
+    const etree_addr_t addr = _address(iOctant);
+    CPPUNIT_ASSERT(0 == db.search(&resAddr, &payload, addr, columns));
+    const PayloadStruct payloadE = _payload(iOctant);
+    CPPUNIT_ASSERT_EQUAL(payloadE.Vs, payload.Vs);
+    CPPUNIT_ASSERT_EQUAL(payloadE.FaultBlock, payload.FaultBlock);
+    CPPUNIT_ASSERT_EQUAL(float(Payload::NODATAVAL), payload.Vp);
+    CPPUNIT_ASSERT_EQUAL(float(Payload::NODATAVAL), payload.DepthFreeSurf);
+    CPPUNIT_ASSERT_EQUAL(int16_t(Payload::NODATAZONE), payload.Zone);
+  } // for
+
+  // Only requested columns are mapped.
+  for (int i=0; i < ColumnDB::NUMCOLUMNS; ++i)
+    CPPUNIT_ASSERT_EQUAL(bool(columns & (1 << i)), 0 != db._pColumns[i]);
+
+  // Missing value file
+  CPPUNIT_ASSERT(0 ==
+		 remove(ColumnDB::columnFilename(_DBFILENAME, 0).c_str()));
+  CPPUNIT_ASSERT_THROW(db.search(&resAddr, &payload, _address(0), 1),
+		       std::runtime_error);
+} // testSearchColumns
+
+// ----------------------------------------------------------------------
+// Get address of octant in database.
+etree_addr_t
+cencalvm::storage::TestColumnDB::_address(const int iOctant)
+{ // _address
+  etree_addr_t addr;
+  addr.x = 0;
+  addr.y = 0;
+  addr.z = 0;
+  addr.t = 0;
+  addr.level = (iOctant < 2) ? iOctant : 2;
+  addr.type = (iOctant < 2) ? ETREE_INTERIOR : ETREE_LEAF;
+  if (iOctant >= 2) {
+    const int iChild = iOctant - 2;
+    addr.x = (iChild & 1) * _TICKLEN2;
+    addr.y = ((iChild >> 1) & 1) * _TICKLEN2;
+    addr.z = ((iChild >> 2) & 1) * _TICKLEN2;
+  } // if
+  return addr;
+} // _address
+
+// ----------------------------------------------------------------------
+// Get payload of octant in database.
+cencalvm::storage::PayloadStruct
+cencalvm::storage::TestColumnDB::_payload(const int iOctant)
+{ // _payload
+  PayloadStruct payload;
+  payload.Vp = 3000.0 + 101.3*iOctant;
+  payload.Vs = 1500.0 + 53.7*iOctant;
+  payload.Density = 2200.0 + 11.9*iOctant;
+  payload.Qp = 300.0 + 1.1*iOctant;
+  payload.Qs = 150.0 + 0.7*iOctant;
+  payload.DepthFreeSurf = 1000.0 * iOctant;
+  payload.FaultBlock = 10 + iOctant;
+  payload.Zone = 20 + iOctant;
+  return payload;
+} // _payload
+
+// ----------------------------------------------------------------------
+// Check payload against expected values.
+void
+cencalvm::storage::TestColumnDB::_checkPayload(const PayloadStruct& payloadE,
+						   const PayloadStruct& payload)
+{ // _checkPayload
+  CPPUNIT_ASSERT(0 == memcmp(&payloadE, &payload, sizeof(payload)));
+} // _checkPayload
+
+// ----------------------------------------------------------------------
+// Write column-split database.
+void
+cencalvm::storage::TestColumnDB::_writeDB(void) const
+{ // _writeDB
+  const std::string schema = Payload::SCHEMA;
+  const std::string appmeta = "test metadata";
+
+  FILE* fout = fopen(_DBFILENAME, "wb");
+  CPPUNIT_ASSERT(0 != fout);
+
+  const int64_t keySize = sizeof(ColumnDBKeyStruct);
+  ColumnDBHeaderStruct header;
+  memset(&header, 0, sizeof(header));
+  memcpy(header.magic, ColumnDB::MAGIC, sizeof(header.magic));
+  header.version = ColumnDB::VERSION;
+  header.byteOrder = ColumnDB::BYTEORDER;
+  header.numOctants = _NUMOCTANTS;
+  header.schemaLength = schema.length();
+  header.appmetaLength = appmeta.length();
+  const int64_t metaEnd = sizeof(header) + schema.length() + appmeta.length();
+  header.keysOffset = keySize * ((metaEnd + keySize - 1) / keySize);
+  const std::string padding(header.keysOffset - metaEnd, '\0');
+  CPPUNIT_ASSERT(1 == fwrite(&header, sizeof(header), 1, fout));
+  CPPUNIT_ASSERT(1 == fwrite(schema.data(), schema.length(), 1, fout));
+  CPPUNIT_ASSERT(1 == fwrite(appmeta.data(), appmeta.length(), 1, fout));
+  CPPUNIT_ASSERT(padding.length() ==
+		 fwrite(padding.data(), 1, padding.length(), fout));
+  for (int iOctant=0; iOctant < _NUMOCTANTS; ++iOctant) {
+    const etree_addr_t addr = _address(iOctant);
+    ColumnDBKeyStruct key;
+    key.x = addr.x;
+    key.y = addr.y;
+    key.z = addr.z;
+    key.level = addr.level;
+    key.type = addr.type;
+    CPPUNIT_ASSERT(1 == fwrite(&key, sizeof(key), 1, fout));
+  } // for
+  CPPUNIT_ASSERT(0 == fclose(fout));
+
+  for (int iColumn=0; iColumn < ColumnDB::NUMCOLUMNS; ++iColumn) {
+    const std::string filename =
+      ColumnDB::columnFilename(_DBFILENAME, iColumn);
+    fout = fopen(filename.c_str(), "wb");
+    CPPUNIT_ASSERT(0 != fout);
+    for (int iOctant=0; iOctant < _NUMOCTANTS; ++iOctant) {
+      const PayloadStruct payload = _payload(iOctant);
+      const void* pValue = (iColumn < 6) ? (const void*) (&payload.Vp + iColumn) :
+	(6 == iColumn) ? (const void*) &payload.FaultBlock :
+	(const void*) &payload.Zone;
+      CPPUNIT_ASSERT(1 == fwrite(pValue, ColumnDB::columnSize(iColumn), 1,
+				 fout));
+    } // for
+    CPPUNIT_ASSERT(0 == fclose(fout));
+  } // for
+} // _writeDB
+
+// End of file
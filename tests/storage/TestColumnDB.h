@@ -0,0 +1,113 @@
+// -*- C++ -*-
+//
+// ----------------------------------------------------------------------
+//
+//                           Brad T. Aagaard
+//                        U.S. Geological Survey
+//
+// {LicenseText}
+//
+// ----------------------------------------------------------------------
+//
+
+/** @file tests/TestColumnDB.h
+ *
+ * @brief C++ TestColumnDB object
+ *
+ * C++ unit testing for ColumnDB.
+ */
+
+#if !defined(cencalvm_storage_testcolumndb_h)
+#define cencalvm_storage_testcolumndb_h
+
+#include <cppunit/extensions/HelperMacros.h>
+
+#include "cencalvm/storage/etreefwd.h" // USES etree_addr_t
+
+namespace cencalvm {
+  namespace storage {
+    class TestColumnDB;
+    struct PayloadStruct; // USES PayloadStruct
+  } // storage
+} // cencalvm
+
+/// C++ unit testing for ColumnDB
+class cencalvm::storage::TestColumnDB : public CppUnit::TestFixture
+{ // class TestColumnDB
+
+  // CPPUNIT TEST SUITE /////////////////////////////////////////////////
+  CPPUNIT_TEST_SUITE( TestColumnDB );
+  CPPUNIT_TEST( testConstructor );
+  CPPUNIT_TEST( testColumnFilename );
+  CPPUNIT_TEST( testIsColumnar );
+  CPPUNIT_TEST( testOpen );
+  CPPUNIT_TEST( testSearch );
+  CPPUNIT_TEST( testSearchColumns );
+  CPPUNIT_TEST_SUITE_END();
+
+  // PUBLIC METHODS /////////////////////////////////////////////////////
+public :
+
+  /// Test constructor
+  void testConstructor(void);
+
+  /// Test columnFilename() and columnSize()
+  void testColumnFilename(void);
+
+  /// Test isColumnar()
+  void testIsColumnar(void);
+
+  /// Test open() and close()
+  void testOpen(void);
+
+  /// Test search()
+  void testSearch(void);
+
+  /// Test search() with subset of columns
+  void testSearchColumns(void);
+
+  // PRIVATE METHODS ////////////////////////////////////////////////////
+private :
+
+  /** Get address of octant in database.
+   *
+   * @param iOctant Index of octant in Morton pre-order
+   *
+   * @returns Address of octant
+   */
+  static etree_addr_t _address(const int iOctant);
+
+  /** Get payload of octant in database.
+   *
+   * @param iOctant Index of octant in Morton pre-order
+   *
+   * @returns Payload of octant
+   */
+  static PayloadStruct _payload(const int iOctant);
+
+  /** Check payload against expected values.
+   *
+   * @param payloadE Expected payload
+   * @param payload Payload to check
+   */
+  static void _checkPayload(const PayloadStruct& payloadE,
+			    const PayloadStruct& payload);
+
+  /** Write column-split database with root octant, one octant at
+   * level 1, and its 8 children.
+   */
+  void _writeDB(void) const;
+
+  // PRIVATE MEMBERS ////////////////////////////////////////////////////
+private :
+
+  static const char* _DBFILENAME; ///< Filename of key file of database
+  static const int _NUMOCTANTS; ///< Number of octants in database
+  static const etree_tick_t _TICKLEN1; ///< Edge length of level 1 octant
+  static const etree_tick_t _TICKLEN2; ///< Edge length of level 2 octant
+
+}; // class TestColumnDB
+
+#endif // cencalvm_storage_testcolumndb_h
+
+// End of file
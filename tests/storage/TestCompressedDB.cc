@@ -0,0 +1,378 @@
+// -*- C++ -*-
+//
+// ----------------------------------------------------------------------
+//
+//                           Brad T. Aagaard
+//                        U.S. Geological Survey
+//
+// {LicenseText}
+//
+// ----------------------------------------------------------------------
+//
+
+#include "TestCompressedDB.h" // Implementation of class methods
+
+#include "cencalvm/storage/CompressedDB.h" // USES CompressedDB
+#include "cencalvm/storage/Payload.h" // USES PayloadStruct
+
+extern "C" {
+#include "etree.h"
+}
+
+#include <stdio.h> // USES fopen(), fwrite(), fclose()
+#include <string.h> // USES memset(), memcpy(), memcmp()
+#include <vector> // USES std::vector
+#include <stdexcept> // USES std::runtime_error
+
+// ----------------------------------------------------------------------
+CPPUNIT_TEST_SUITE_REGISTRATION( cencalvm::storage::TestCompressedDB );
+
+// ----------------------------------------------------------------------
+const char* cencalvm::storage::TestCompressedDB::_DBFILENAME =
+  "data/compressed.etree";
+const int cencalvm::storage::TestCompressedDB::_NUMOCTANTS = 10;
+const etree_tick_t cencalvm::storage::TestCompressedDB::_TICKLEN1 =
+  0x80000000 >> 1;
+const etree_tick_t cencalvm::storage::TestCompressedDB::_TICKLEN2 =
+  0x80000000 >> 2;
+
+// ----------------------------------------------------------------------
+// Test constructor
+void
+cencalvm::storage::TestCompressedDB::testConstructor(void)
+{ // testConstructor
+  CompressedDB db;
+} // testConstructor
+
+// ----------------------------------------------------------------------
+// Test encodeBlock() and decodeBlock()
+void
+cencalvm::storage::TestCompressedDB::testEncodeDecode(void)
+{ // testEncodeDecode
+  const int numOctants = _NUMOCTANTS;
+  const int payloadSize = sizeof(PayloadStruct);
+
+  std::vector<etree_addr_t> addrsE(numOctants);
+  std::vector<PayloadStruct> payloadsE(numOctants);
+  for (int iOctant=0; iOctant < numOctants; ++iOctant) {
+    addrsE[iOctant] = _address(iOctant);
+    payloadsE[iOctant] = _payload(iOctant);
+  } // for
+  payloadsE[3].Vs = Payload::NODATAVAL;
+
+  std::string buffer;
+  CompressedDB::encodeBlock(&buffer, &addrsE[0], (const char*) &payloadsE[0],
+			    numOctants, payloadSize);
+  CPPUNIT_ASSERT(buffer.length() > 0);
+
+  std::vector<etree_addr_t> addrs(numOctants);
+  std::vector<PayloadStruct> payloads(numOctants);
+  CompressedDB::decodeBlock(&addrs[0], (char*) &payloads[0], numOctants,
+			    payloadSize, buffer.data(), buffer.length());
+  for (int iOctant=0; iOctant < numOctants; ++iOctant) {
+    CPPUNIT_ASSERT_EQUAL(addrsE[iOctant].x, addrs[iOctant].x);
+    CPPUNIT_ASSERT_EQUAL(addrsE[iOctant].y, addrs[iOctant].y);
+    CPPUNIT_ASSERT_EQUAL(addrsE[iOctant].z, addrs[iOctant].z);
+    CPPUNIT_ASSERT_EQUAL(addrsE[iOctant].level, addrs[iOctant].level);
+    CPPUNIT_ASSERT_EQUAL(int(addrsE[iOctant].type), int(addrs[iOctant].type));
+    CPPUNIT_ASSERT(0 == memcmp(&payloadsE[iOctant], &payloads[iOctant],
+			       payloadSize));
+  } // for
+
+  CPPUNIT_ASSERT_THROW(CompressedDB::decodeBlock(&addrs[0],
+						 (char*) &payloads[0],
+						 numOctants, payloadSize,
+						 buffer.data(),
+						 buffer.length()/2),
+		       std::runtime_error);
+} // testEncodeDecode
+
+// ----------------------------------------------------------------------
+// Test isCompressed()
+void
+cencalvm::storage::TestCompressedDB::testIsCompressed(void)
+{ // testIsCompressed
+  _writeDB(4);
+
+  CPPUNIT_ASSERT(CompressedDB::isCompressed(_DBFILENAME));
+  CPPUNIT_ASSERT(!CompressedDB::isCompressed("data/TestProjector.dat"));
+  CPPUNIT_ASSERT(!CompressedDB::isCompressed("data/nosuchfile.etree"));
+} // testIsCompressed
+
+// ----------------------------------------------------------------------
+// Test open() and close()
+void
+cencalvm::storage::TestCompressedDB::testOpen(void)
+{ // testOpen
+  _writeDB(4);
+
+  CompressedDB db;
+  db.open(_DBFILENAME, 1);
+  CPPUNIT_ASSERT_EQUAL(int(sizeof(PayloadStruct)), db.payloadSize());
+  CPPUNIT_ASSERT(0 == strcmp(Payload::SCHEMA, db.schema()));
+  CPPUNIT_ASSERT(0 == strcmp("test metadata", db.appmeta()));
+  CPPUNIT_ASSERT_EQUAL(size_t(3), db._index.size());
+  db.close();
+  CPPUNIT_ASSERT(0 == db._file);
+
+  CPPUNIT_ASSERT_THROW(db.open("data/TestProjector.dat", 1),
+		       std::runtime_error);
+  CPPUNIT_ASSERT_THROW(db.open("data/nosuchfile.etree", 1),
+		       std::runtime_error);
+} // testOpen
+
+// ----------------------------------------------------------------------
+// Test search()
+void
+cencalvm::storage::TestCompressedDB::testSearch(void)
+{ // testSearch
+  _writeDB(4);
+
+  CompressedDB db;
+  db.open(_DBFILENAME, 1);
+
+  // Octants in database
+  etree_addr_t resAddr;
+  PayloadStruct payload;
+  for (int iOctant=0; iOctant < _NUMOCTANTS; ++iOctant) {
+    const etree_addr_t addr = _address(iOctant);
+    CPPUNIT_ASSERT(0 == db.search(&resAddr, &payload, addr));
+    CPPUNIT_ASSERT_EQUAL(addr.level, resAddr.level);
+    CPPUNIT_ASSERT_EQUAL(int(addr.type), int(resAddr.type));
+    _checkPayload(_payload(iOctant), payload);
+  } // for
+
+  // Point in child 5
+  etree_addr_t addr;
+  addr.x = _TICKLEN2 + 7;
+  addr.y = 3;
+  addr.z = _TICKLEN2 + 1234;
+  addr.t = 0;
+  addr.level = ETREE_MAXLEVEL;
+  addr.type = ETREE_LEAF;
+  CPPUNIT_ASSERT(0 == db.search(&resAddr, &payload, addr));
+  CPPUNIT_ASSERT_EQUAL(2, resAddr.level);
+  _checkPayload(_payload(7), payload);
+
+  // Point outside octant at level 1 is only in root octant
+  addr.x = _TICKLEN1 + 5;
+  CPPUNIT_ASSERT(0 == db.search(&resAddr, &payload, addr));
+  CPPUNIT_ASSERT_EQUAL(0, resAddr.level);
+  _checkPayload(_payload(0), payload);
+
+  // Interior octant not in database
+  addr.x = _TICKLEN1;
+  addr.y = 0;
+  addr.z = 0;
+  addr.level = 1;
+  addr.type = ETREE_INTERIOR;
+  CPPUNIT_ASSERT(0 != db.search(&resAddr, &payload, addr));
+} // testSearch
+
+// ----------------------------------------------------------------------
+// Test cache of decompressed blocks
+void
+cencalvm::storage::TestCompressedDB::testCache(void)
+{ // testCache
+  _writeDB(2);
+
+  CompressedDB db;
+  db.open(_DBFILENAME, 0);
+  CPPUNIT_ASSERT_EQUAL(1, db._cacheCapacity);
+  CPPUNIT_ASSERT_EQUAL(size_t(5), db._index.size());
+
+  etree_addr_t resAddr;
+  PayloadStruct payload;
+  for (int iOctant=_NUMOCTANTS-1; iOctant >= 0; --iOctant) {
+    const etree_addr_t addr = _address(iOctant);
+    CPPUNIT_ASSERT(0 == db.search(&resAddr, &payload, addr));
+    _checkPayload(_payload(iOctant), payload);
+    CPPUNIT_ASSERT_EQUAL(size_t(1), db._lru.size());
+    CPPUNIT_ASSERT_EQUAL(iOctant/2, db._lru.front());
+  } // for
+
+  db.open(_DBFILENAME, 1);
+  CPPUNIT_ASSERT(db._cacheCapacity >= 5);
+  for (int iOctant=0; iOctant < _NUMOCTANTS; ++iOctant) {
+    const etree_addr_t addr = _address(iOctant);
+    CPPUNIT_ASSERT(0 == db.search(&resAddr, &payload, addr));
+  } // for
+  CPPUNIT_ASSERT_EQUAL(size_t(5), db._lru.size());
+  CPPUNIT_ASSERT_EQUAL(4, db._lru.front());
+  CPPUNIT_ASSERT_EQUAL(0, db._lru.back());
+} // testCache
+
+// ----------------------------------------------------------------------
+// Test cacheStats() and cacheSize()
+void
+cencalvm::storage::TestCompressedDB::testCacheStats(void)
+{ // testCacheStats
+  _writeDB(2);
+
+  CompressedDB db;
+  db.open(_DBFILENAME, 0);
+  CacheStatsStruct stats;
+  db.cacheStats(&stats);
+  CPPUNIT_ASSERT_EQUAL(uint64_t(0), stats.numSearches);
+  CPPUNIT_ASSERT_EQUAL(uint64_t(1), stats.capacity);
+  CPPUNIT_ASSERT_EQUAL(0, stats.cacheSize);
+  CPPUNIT_ASSERT(!stats.isEstimate);
+
+  // Octants 0 and 1 are in block 0 and octant 2 is in block 1.
+  etree_addr_t resAddr;
+  PayloadStruct payload;
+  for (int iOctant=0; iOctant < 3; ++iOctant) {
+    const etree_addr_t addr = _address(iOctant);
+    CPPUNIT_ASSERT(0 == db.search(&resAddr, &payload, addr));
+  } // for
+  db.cacheStats(&stats);
+  CPPUNIT_ASSERT_EQUAL(uint64_t(3), stats.numSearches);
+  CPPUNIT_ASSERT_EQUAL(uint64_t(1), stats.numHits);
+  CPPUNIT_ASSERT_EQUAL(uint64_t(2), stats.numMisses);
+  CPPUNIT_ASSERT_EQUAL(uint64_t(2), stats.numReads);
+  CPPUNIT_ASSERT_EQUAL(uint64_t(1), stats.numEvictions);
+  CPPUNIT_ASSERT_EQUAL(uint64_t(1), stats.numResident);
+  CPPUNIT_ASSERT(stats.bytesRead > 0);
+
+  // Growing cache keeps blocks.
+  db.cacheSize(1);
+  for (int iOctant=0; iOctant < _NUMOCTANTS; ++iOctant) {
+    const etree_addr_t addr = _address(iOctant);
+    CPPUNIT_ASSERT(0 == db.search(&resAddr, &payload, addr));
+  } // for
+  db.cacheStats(&stats);
+  CPPUNIT_ASSERT_EQUAL(uint64_t(3+_NUMOCTANTS), stats.numSearches);
+  CPPUNIT_ASSERT_EQUAL(uint64_t(6), stats.numReads);
+  CPPUNIT_ASSERT_EQUAL(uint64_t(1), stats.numEvictions);
+  CPPUNIT_ASSERT_EQUAL(uint64_t(5), stats.numResident);
+  CPPUNIT_ASSERT_EQUAL(1, stats.cacheSize);
+  CPPUNIT_ASSERT_EQUAL(1, stats.numResizes);
+
+  // Shrinking cache evicts least recently used blocks.
+  db.cacheSize(0);
+  db.cacheStats(&stats);
+  CPPUNIT_ASSERT_EQUAL(uint64_t(5), stats.numEvictions);
+  CPPUNIT_ASSERT_EQUAL(uint64_t(1), stats.numResident);
+  CPPUNIT_ASSERT_EQUAL(4, db._lru.front());
+  CPPUNIT_ASSERT_EQUAL(2, stats.numResizes);
+
+  // Opening clears statistics.
+  db.open(_DBFILENAME, 1);
+  db.cacheStats(&stats);
+  CPPUNIT_ASSERT_EQUAL(uint64_t(0), stats.numSearches);
+  CPPUNIT_ASSERT_EQUAL(uint64_t(0), stats.numReads);
+  CPPUNIT_ASSERT_EQUAL(0, stats.numResizes);
+} // testCacheStats
+
+// ----------------------------------------------------------------------
+// Get address of octant in database.
+etree_addr_t
+cencalvm::storage::TestCompressedDB::_address(const int iOctant)
+{ // _address
+  etree_addr_t addr;
+  addr.x = 0;
+  addr.y = 0;
+  addr.z = 0;
+  addr.t = 0;
+  addr.level = (iOctant < 2) ? iOctant : 2;
+  addr.type = (iOctant < 2) ? ETREE_INTERIOR : ETREE_LEAF;
+  if (iOctant >= 2) {
+    const int iChild = iOctant - 2;
+    addr.x = (iChild & 1) * _TICKLEN2;
+    addr.y = ((iChild >> 1) & 1) * _TICKLEN2;
+    addr.z = ((iChild >> 2) & 1) * _TICKLEN2;
+  } // if
+  return addr;
+} // _address
+
+// ----------------------------------------------------------------------
+// Get payload of octant in database.
+cencalvm::storage::PayloadStruct
+cencalvm::storage::TestCompressedDB::_payload(const int iOctant)
+{ // _payload
+  PayloadStruct payload;
+  payload.Vp = 3000.0 + 101.3*iOctant;
+  payload.Vs = 1500.0 + 53.7*iOctant;
+  payload.Density = 2200.0 + 11.9*iOctant;
+  payload.Qp = 300.0 + 1.1*iOctant;
+  payload.Qs = 150.0 + 0.7*iOctant;
+  payload.DepthFreeSurf = 1000.0 * iOctant;
+  payload.FaultBlock = 10 + iOctant;
+  payload.Zone = 20 + iOctant;
+  return payload;
+} // _payload
+
+// ----------------------------------------------------------------------
+// Check payload against expected values.
+void
+cencalvm::storage::TestCompressedDB::_checkPayload(const PayloadStruct& payloadE,
+						   const PayloadStruct& payload)
+{ // _checkPayload
+  CPPUNIT_ASSERT(0 == memcmp(&payloadE, &payload, sizeof(payload)));
+} // _checkPayload
+
+// ----------------------------------------------------------------------
+// Write compressed container.
+void
+cencalvm::storage::TestCompressedDB::_writeDB(const int blockSize) const
+{ // _writeDB
+  const int numOctants = _NUMOCTANTS;
+  const int payloadSize = sizeof(PayloadStruct);
+  const std::string schema = Payload::SCHEMA;
+  const std::string appmeta = "test metadata";
+
+  FILE* fout = fopen(_DBFILENAME, "wb");
+  CPPUNIT_ASSERT(0 != fout);
+
+  CompressedDBHeaderStruct header;
+  memset(&header, 0, sizeof(header));
+  memcpy(header.magic, CompressedDB::MAGIC, sizeof(header.magic));
+  header.version = CompressedDB::VERSION;
+  header.byteOrder = CompressedDB::BYTEORDER;
+  header.payloadSize = payloadSize;
+  header.blockSize = blockSize;
+  header.numOctants = numOctants;
+  header.schemaLength = schema.length();
+  header.appmetaLength = appmeta.length();
+  CPPUNIT_ASSERT(1 == fwrite(&header, sizeof(header), 1, fout));
+  CPPUNIT_ASSERT(1 == fwrite(schema.data(), schema.length(), 1, fout));
+  CPPUNIT_ASSERT(1 == fwrite(appmeta.data(), appmeta.length(), 1, fout));
+  int64_t offset = sizeof(header) + schema.length() + appmeta.length();
+
+  std::vector<CompressedDBIndexStruct> index;
+  for (int iOctant=0; iOctant < numOctants; iOctant += blockSize) {
+    const int numBlock = (iOctant + blockSize <= numOctants) ?
+      blockSize : numOctants - iOctant;
+    std::vector<etree_addr_t> addrs(numBlock);
+    std::vector<PayloadStruct> payloads(numBlock);
+    for (int i=0; i < numBlock; ++i) {
+      addrs[i] = _address(iOctant+i);
+      payloads[i] = _payload(iOctant+i);
+    } // for
+    std::string buffer;
+    CompressedDB::encodeBlock(&buffer, &addrs[0], (const char*) &payloads[0],
+			      numBlock, payloadSize);
+    CPPUNIT_ASSERT(1 == fwrite(buffer.data(), buffer.length(), 1, fout));
+
+    CompressedDBIndexStruct entry;
+    entry.x = addrs[0].x;
+    entry.y = addrs[0].y;
+    entry.z = addrs[0].z;
+    entry.level = addrs[0].level;
+    entry.offset = offset;
+    entry.size = buffer.length();
+    entry.numOctants = numBlock;
+    index.push_back(entry);
+    offset += buffer.length();
+  } // for
+  CPPUNIT_ASSERT(index.size() ==
+		 fwrite(&index[0], sizeof(index[0]), index.size(), fout));
+
+  header.numBlocks = index.size();
+  header.indexOffset = offset;
+  CPPUNIT_ASSERT(0 == fseek(fout, 0, SEEK_SET));
+  CPPUNIT_ASSERT(1 == fwrite(&header, sizeof(header), 1, fout));
+  CPPUNIT_ASSERT(0 == fclose(fout));
+} // _writeDB
+
+// End of file
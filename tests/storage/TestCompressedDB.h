@@ -0,0 +1,119 @@
+// -*- C++ -*-
+//
+// ----------------------------------------------------------------------
+//
+//                           Brad T. Aagaard
+//                        U.S. Geological Survey
+//
+// {LicenseText}
+//
+// ----------------------------------------------------------------------
+//
+
+/** @file tests/TestCompressedDB.h
+ *
+ * @brief C++ TestCompressedDB object
+ *
+ * C++ unit testing for CompressedDB.
+ */
+
+#if !defined(cencalvm_storage_testcompresseddb_h)
+#define cencalvm_storage_testcompresseddb_h
+
+#include <cppunit/extensions/HelperMacros.h>
+
+#include "cencalvm/storage/etreefwd.h" // USES etree_addr_t
+
+namespace cencalvm {
+  namespace storage {
+    class TestCompressedDB;
+    struct PayloadStruct; // USES PayloadStruct
+  } // storage
+} // cencalvm
+
+/// C++ unit testing for CompressedDB
+class cencalvm::storage::TestCompressedDB : public CppUnit::TestFixture
+{ // class TestCompressedDB
+
+  // CPPUNIT TEST SUITE /////////////////////////////////////////////////
+  CPPUNIT_TEST_SUITE( TestCompressedDB );
+  CPPUNIT_TEST( testConstructor );
+  CPPUNIT_TEST( testEncodeDecode );
+  CPPUNIT_TEST( testIsCompressed );
+  CPPUNIT_TEST( testOpen );
+  CPPUNIT_TEST( testSearch );
+  CPPUNIT_TEST( testCache );
+  CPPUNIT_TEST( testCacheStats );
+  CPPUNIT_TEST_SUITE_END();
+
+  // PUBLIC METHODS /////////////////////////////////////////////////////
+public :
+
+  /// Test constructor
+  void testConstructor(void);
+
+  /// Test encodeBlock() and decodeBlock()
+  void testEncodeDecode(void);
+
+  /// Test isCompressed()
+  void testIsCompressed(void);
+
+  /// Test open() and close()
+  void testOpen(void);
+
+  /// Test search()
+  void testSearch(void);
+
+  /// Test cache of decompressed blocks
+  void testCache(void);
+
+  /// Test cacheStats() and cacheSize()
+  void testCacheStats(void);
+
+  // PRIVATE METHODS ////////////////////////////////////////////////////
+private :
+
+  /** Get address of octant in database.
+   *
+   * @param iOctant Index of octant in Morton pre-order
+   *
+   * @returns Address of octant
+   */
+  static etree_addr_t _address(const int iOctant);
+
+  /** Get payload of octant in database.
+   *
+   * @param iOctant Index of octant in Morton pre-order
+   *
+   * @returns Payload of octant
+   */
+  static PayloadStruct _payload(const int iOctant);
+
+  /** Check payload against expected values.
+   *
+   * @param payloadE Expected payload
+   * @param payload Payload to check
+   */
+  static void _checkPayload(const PayloadStruct& payloadE,
+			    const PayloadStruct& payload);
+
+  /** Write compressed container with root octant, one octant at
+   * level 1, and its 8 children.
+   *
+   * @param blockSize Number of octants in each block
+   */
+  void _writeDB(const int blockSize) const;
+
+  // PRIVATE MEMBERS ////////////////////////////////////////////////////
+private :
+
+  static const char* _DBFILENAME; ///< Filename of compressed database
+  static const int _NUMOCTANTS; ///< Number of octants in database
+  static const etree_tick_t _TICKLEN1; ///< Edge length of level 1 octant
+  static const etree_tick_t _TICKLEN2; ///< Edge length of level 2 octant
+
+}; // class TestCompressedDB
+
+#endif // cencalvm_storage_testcompresseddb_h
+
+// End of file
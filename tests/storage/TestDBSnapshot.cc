@@ -0,0 +1,138 @@
+// -*- C++ -*-
+//
+// ----------------------------------------------------------------------
+//
+//                           Brad T. Aagaard
+//                        U.S. Geological Survey
+//
+// {LicenseText}
+//
+// ----------------------------------------------------------------------
+//
+
+#include "TestDBSnapshot.h" // Implementation of class methods
+
+#include "cencalvm/storage/DBSnapshot.h" // USES DBSnapshot
+
+#include <inttypes.h> // USES uint64_t
+#include <fstream> // USES std::ifstream, std::ofstream
+#include <sstream> // USES std::ostringstream
+#include <stdexcept> // USES std::runtime_error
+
+// ----------------------------------------------------------------------
+CPPUNIT_TEST_SUITE_REGISTRATION( cencalvm::storage::TestDBSnapshot );
+
+// ----------------------------------------------------------------------
+const char* cencalvm::storage::TestDBSnapshot::_FILENAME =
+  "data/snapshot.etree";
+
+// ----------------------------------------------------------------------
+// Test filename()
+void
+cencalvm::storage::TestDBSnapshot::testFilename(void)
+{ // testFilename
+  CPPUNIT_ASSERT_EQUAL(std::string("data/snapshot.etree.snapshot0"),
+		       DBSnapshot::filename(_FILENAME, 0));
+  CPPUNIT_ASSERT_EQUAL(std::string("data/snapshot.etree.snapshot1"),
+		       DBSnapshot::filename(_FILENAME, 1));
+} // testFilename
+
+// ----------------------------------------------------------------------
+// Test save() and restore()
+void
+cencalvm::storage::TestDBSnapshot::testSaveRestore(void)
+{ // testSaveRestore
+  // Contents span several copy buffers.
+  std::string contentsA(2*1024*1024 + 100, 'a');
+  contentsA[12345] = 'b';
+  const std::string contentsB = "second checkpoint";
+
+  _writeFile(_FILENAME, contentsA);
+  const uint64_t lengthA = DBSnapshot::save(_FILENAME, 0);
+  CPPUNIT_ASSERT_EQUAL(uint64_t(contentsA.size()), lengthA);
+
+  _writeFile(_FILENAME, contentsB);
+  const uint64_t lengthB = DBSnapshot::save(_FILENAME, 1);
+  CPPUNIT_ASSERT_EQUAL(uint64_t(contentsB.size()), lengthB);
+
+  // Database damaged after checkpoint is replaced by snapshot.
+  _writeFile(_FILENAME, "damaged");
+  DBSnapshot::restore(_FILENAME, 1, lengthB);
+  CPPUNIT_ASSERT(contentsB == _readFile(_FILENAME));
+  DBSnapshot::restore(_FILENAME, 0, lengthA);
+  CPPUNIT_ASSERT(contentsA == _readFile(_FILENAME));
+
+  // Snapshots are kept after restoring.
+  CPPUNIT_ASSERT(contentsA ==
+		 _readFile(DBSnapshot::filename(_FILENAME, 0).c_str()));
+  CPPUNIT_ASSERT(contentsB ==
+		 _readFile(DBSnapshot::filename(_FILENAME, 1).c_str()));
+
+  DBSnapshot::remove(_FILENAME);
+} // testSaveRestore
+
+// ----------------------------------------------------------------------
+// Test restore() with missing snapshot or wrong length
+void
+cencalvm::storage::TestDBSnapshot::testRestoreBad(void)
+{ // testRestoreBad
+  const std::string contents = "checkpoint";
+  _writeFile(_FILENAME, contents);
+  DBSnapshot::remove(_FILENAME);
+  CPPUNIT_ASSERT_THROW(DBSnapshot::restore(_FILENAME, 0, contents.size()),
+		       std::runtime_error);
+
+  const uint64_t length = DBSnapshot::save(_FILENAME, 0);
+  _writeFile(_FILENAME, "damaged");
+  CPPUNIT_ASSERT_THROW(DBSnapshot::restore(_FILENAME, 0, length+1),
+		       std::runtime_error);
+  CPPUNIT_ASSERT(std::string("damaged") == _readFile(_FILENAME));
+
+  CPPUNIT_ASSERT_THROW(DBSnapshot::save("data/missing.etree", 0),
+		       std::runtime_error);
+
+  DBSnapshot::remove(_FILENAME);
+} // testRestoreBad
+
+// ----------------------------------------------------------------------
+// Test remove()
+void
+cencalvm::storage::TestDBSnapshot::testRemove(void)
+{ // testRemove
+  _writeFile(_FILENAME, "checkpoint");
+  DBSnapshot::save(_FILENAME, 0);
+  DBSnapshot::save(_FILENAME, 1);
+  DBSnapshot::remove(_FILENAME);
+  for (int slot=0; slot < DBSnapshot::NUMSLOTS; ++slot) {
+    std::ifstream fin(DBSnapshot::filename(_FILENAME, slot).c_str());
+    CPPUNIT_ASSERT(!fin.is_open());
+  } // for
+
+  // Database is kept.
+  CPPUNIT_ASSERT(std::string("checkpoint") == _readFile(_FILENAME));
+} // testRemove
+
+// ----------------------------------------------------------------------
+// Write file.
+void
+cencalvm::storage::TestDBSnapshot::_writeFile(const char* filename,
+					      const std::string& contents)
+{ // _writeFile
+  std::ofstream fout(filename, std::ios::binary | std::ios::trunc);
+  fout.write(contents.data(), contents.size());
+  CPPUNIT_ASSERT(fout.good());
+} // _writeFile
+
+// ----------------------------------------------------------------------
+// Read file.
+std::string
+cencalvm::storage::TestDBSnapshot::_readFile(const char* filename)
+{ // _readFile
+  std::ifstream fin(filename, std::ios::binary);
+  CPPUNIT_ASSERT(fin.is_open());
+  std::ostringstream contents;
+  contents << fin.rdbuf();
+  return contents.str();
+} // _readFile
+
+// End of file
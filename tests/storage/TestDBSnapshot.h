@@ -0,0 +1,88 @@
+// -*- C++ -*-
+//
+// ----------------------------------------------------------------------
+//
+//                           Brad T. Aagaard
+//                        U.S. Geological Survey
+//
+// {LicenseText}
+//
+// ----------------------------------------------------------------------
+//
+
+/** @file tests/TestDBSnapshot.h
+ *
+ * @brief C++ TestDBSnapshot object
+ *
+ * C++ unit testing for DBSnapshot.
+ */
+
+#if !defined(cencalvm_storage_testdbsnapshot_h)
+#define cencalvm_storage_testdbsnapshot_h
+
+#include <cppunit/extensions/HelperMacros.h>
+
+#include <string> // USES std::string
+
+namespace cencalvm {
+  namespace storage {
+    class TestDBSnapshot;
+  } // storage
+} // cencalvm
+
+/// C++ unit testing for DBSnapshot
+class cencalvm::storage::TestDBSnapshot : public CppUnit::TestFixture
+{ // class TestDBSnapshot
+
+  // CPPUNIT TEST SUITE /////////////////////////////////////////////////
+  CPPUNIT_TEST_SUITE( TestDBSnapshot );
+  CPPUNIT_TEST( testFilename );
+  CPPUNIT_TEST( testSaveRestore );
+  CPPUNIT_TEST( testRestoreBad );
+  CPPUNIT_TEST( testRemove );
+  CPPUNIT_TEST_SUITE_END();
+
+  // PUBLIC METHODS /////////////////////////////////////////////////////
+public :
+
+  /// Test filename()
+  void testFilename(void);
+
+  /// Test save() and restore()
+  void testSaveRestore(void);
+
+  /// Test restore() with missing snapshot or wrong length
+  void testRestoreBad(void);
+
+  /// Test remove()
+  void testRemove(void);
+
+  // PRIVATE METHODS ////////////////////////////////////////////////////
+private :
+
+  /** Write file.
+   *
+   * @param filename Name of file
+   * @param contents Contents of file
+   */
+  static void _writeFile(const char* filename,
+			 const std::string& contents);
+
+  /** Read file.
+   *
+   * @param filename Name of file
+   *
+   * @returns Contents of file
+   */
+  static std::string _readFile(const char* filename);
+
+  // PRIVATE MEMBERS ////////////////////////////////////////////////////
+private :
+
+  static const char* _FILENAME; ///< Filename of database
+
+}; // class TestDBSnapshot
+
+#endif // cencalvm_storage_testdbsnapshot_h
+
+// End of file
@@ -61,6 +61,49 @@ cencalvm::storage::TestGeometry::testFindAncestor(void)
   } // for
 } // testFindAncestor
 
+// ----------------------------------------------------------------------
+// Test precedes()
+void 
+cencalvm::storage::TestGeometry::testPrecedes(void)
+{ // testPrecedes
+
+  const int numTests = 6;
+  const int pLevelsA[] = { 2, 2, 2, 3, 1, 2 };
+  const int pAddrA[] = { 1, 0, 0,
+			 1, 1, 0,
+			 3, 3, 0,
+			 0, 0, 2,
+			 0, 0, 0,
+			 0, 0, 0 };
+  const int pLevelsB[] = { 2, 2, 2, 2, 2, 2 };
+  const int pAddrB[] = { 0, 1, 0,
+			 0, 0, 1,
+			 0, 0, 1,
+			 1, 0, 0,
+			 0, 0, 0,
+			 0, 0, 0 };
+  const bool pPrecedes[] = { true, true, false, false, true, false };
+
+  for (int iTest=0, i=0; iTest < numTests; ++iTest, i+=3) {
+    etree_addr_t addrA;
+    addrA.level = pLevelsA[iTest];
+    etree_tick_t tickLen = 0x80000000 >> addrA.level;
+    addrA.x = pAddrA[i  ]*tickLen;
+    addrA.y = pAddrA[i+1]*tickLen;
+    addrA.z = pAddrA[i+2]*tickLen;
+
+    etree_addr_t addrB;
+    addrB.level = pLevelsB[iTest];
+    tickLen = 0x80000000 >> addrB.level;
+    addrB.x = pAddrB[i  ]*tickLen;
+    addrB.y = pAddrB[i+1]*tickLen;
+    addrB.z = pAddrB[i+2]*tickLen;
+
+    CPPUNIT_ASSERT_EQUAL(pPrecedes[iTest], 
+			 Geometry::precedes(addrA, addrB));
+  } // for
+} // testPrecedes
+
 // version
 // $Id$
 
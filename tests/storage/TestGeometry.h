@@ -35,6 +35,7 @@ class cencalvm::storage::TestGeometry : public CppUnit::TestFixture
   // CPPUNIT TEST SUITE /////////////////////////////////////////////////
   CPPUNIT_TEST_SUITE( TestGeometry );
   CPPUNIT_TEST( testFindAncestor );
+  CPPUNIT_TEST( testPrecedes );
   CPPUNIT_TEST_SUITE_END();
 
   // PUBLIC METHODS /////////////////////////////////////////////////////
@@ -42,6 +43,9 @@ public :
 
   /// Test findAncestor()
   void testFindAncestor(void);
+
+  /// Test precedes()
+  void testPrecedes(void);
   
 }; // class TestGeometry
 
@@ -0,0 +1,224 @@
+// -*- C++ -*-
+//
+// ----------------------------------------------------------------------
+//
+//                           Brad T. Aagaard
+//                        U.S. Geological Survey
+//
+// {LicenseText}
+//
+// ----------------------------------------------------------------------
+//
+
+#include "TestPayloadCodec.h" // Implementation of class methods
+
+#include "cencalvm/storage/PayloadCodec.h" // USES PayloadCodec
+#include "cencalvm/storage/Payload.h" // USES PayloadStruct
+
+#include <stdexcept> // USES std::runtime_error
+
+// ----------------------------------------------------------------------
+CPPUNIT_TEST_SUITE_REGISTRATION( cencalvm::storage::TestPayloadCodec );
+
+// ----------------------------------------------------------------------
+const int cencalvm::storage::TestPayloadCodec::_NUMPAYLOADS = 5;
+
+// ----------------------------------------------------------------------
+// Test constructor
+void
+cencalvm::storage::TestPayloadCodec::testConstructor(void)
+{ // testConstructor
+  PayloadCodec codec;
+
+  CPPUNIT_ASSERT_EQUAL(size_t(16), sizeof(PayloadCompactStruct));
+} // testConstructor
+
+// ----------------------------------------------------------------------
+// Test errorBound()
+void
+cencalvm::storage::TestPayloadCodec::testErrorBound(void)
+{ // testErrorBound
+  PayloadCodec codec;
+
+  const double tolerance = 1.0e-06;
+  CPPUNIT_ASSERT_DOUBLES_EQUAL(0.5, codec.errorBound("Vp"), tolerance);
+  CPPUNIT_ASSERT_DOUBLES_EQUAL(0.5, codec.errorBound("Vs"), tolerance);
+  CPPUNIT_ASSERT_DOUBLES_EQUAL(0.5, codec.errorBound("Density"), tolerance);
+  CPPUNIT_ASSERT_DOUBLES_EQUAL(0.05, codec.errorBound("Qp"), tolerance);
+  CPPUNIT_ASSERT_DOUBLES_EQUAL(0.05, codec.errorBound("Qs"), tolerance);
+  CPPUNIT_ASSERT_DOUBLES_EQUAL(0.5, codec.errorBound("DepthFreeSurf"),
+			       tolerance);
+
+  codec.errorBound("Qs", 0.2);
+  CPPUNIT_ASSERT_DOUBLES_EQUAL(0.2, codec.errorBound("Qs"), tolerance);
+
+  CPPUNIT_ASSERT_THROW(codec.errorBound("Vq", 1.0), std::runtime_error);
+  CPPUNIT_ASSERT_THROW(codec.errorBound("FaultBlock", 1.0),
+		       std::runtime_error);
+  CPPUNIT_ASSERT_THROW(codec.errorBound("Vp", 0.0), std::runtime_error);
+} // testErrorBound
+
+// ----------------------------------------------------------------------
+// Test resetRange(), updateRange(), and initialize()
+void
+cencalvm::storage::TestPayloadCodec::testRange(void)
+{ // testRange
+  PayloadCodec codec;
+  codec.errorBound("Vp", 2.0);
+
+  codec.resetRange();
+  for (int i=0; i < _NUMPAYLOADS; ++i) {
+    PayloadStruct payload;
+    _setPayload(&payload, i);
+    codec.updateRange(payload);
+  } // for
+  codec.initialize();
+
+  // NODATAVAL is not included in range.
+  const double tolerance = 1.0e-06;
+  CPPUNIT_ASSERT_DOUBLES_EQUAL(1500.0, codec._valMin[0], tolerance);
+  CPPUNIT_ASSERT_DOUBLES_EQUAL(6500.0, codec._valMax[0], tolerance);
+  CPPUNIT_ASSERT_DOUBLES_EQUAL(1500.0, codec._offset[0], tolerance);
+  CPPUNIT_ASSERT_DOUBLES_EQUAL(4.0, codec._step[0], tolerance);
+  CPPUNIT_ASSERT_DOUBLES_EQUAL(500.0, codec._valMin[1], tolerance);
+  CPPUNIT_ASSERT_DOUBLES_EQUAL(3700.0, codec._valMax[1], tolerance);
+  CPPUNIT_ASSERT_DOUBLES_EQUAL(1.0, codec._step[1], tolerance);
+} // testRange
+
+// ----------------------------------------------------------------------
+// Test encode() and decode()
+void
+cencalvm::storage::TestPayloadCodec::testEncodeDecode(void)
+{ // testEncodeDecode
+  PayloadCodec codec;
+  codec.errorBound("Vp", 2.0);
+  codec.errorBound("Qs", 0.01);
+
+  codec.resetRange();
+  for (int i=0; i < _NUMPAYLOADS; ++i) {
+    PayloadStruct payload;
+    _setPayload(&payload, i);
+    codec.updateRange(payload);
+  } // for
+  codec.initialize();
+
+  // Float rounding of restored values is small relative to bounds.
+  const double tolerance = 1.0e-03;
+  for (int i=0; i < _NUMPAYLOADS; ++i) {
+    PayloadStruct payloadE;
+    _setPayload(&payloadE, i);
+    PayloadCompactStruct compact;
+    codec.encode(&compact, payloadE);
+    PayloadStruct payload;
+    codec.decode(&payload, compact);
+
+    const float* pValsE = &payloadE.Vp;
+    const float* pVals = &payload.Vp;
+    for (int iVal=0; iVal < PayloadCodec::NUMVALUES; ++iVal) {
+      const double bound = codec.errorBound(PayloadCodec::NAMES[iVal]);
+      if (Payload::NODATAVAL == pValsE[iVal])
+	CPPUNIT_ASSERT_EQUAL(Payload::NODATAVAL, pVals[iVal]);
+      else
+	CPPUNIT_ASSERT_DOUBLES_EQUAL(pValsE[iVal], pVals[iVal],
+				     bound + tolerance);
+    } // for
+    CPPUNIT_ASSERT_EQUAL(payloadE.FaultBlock, payload.FaultBlock);
+    CPPUNIT_ASSERT_EQUAL(payloadE.Zone, payload.Zone);
+  } // for
+
+  // Value outside range
+  PayloadStruct payload;
+  _setPayload(&payload, 0);
+  payload.Vp = 1000.0;
+  PayloadCompactStruct compact;
+  CPPUNIT_ASSERT_THROW(codec.encode(&compact, payload), std::runtime_error);
+} // testEncodeDecode
+
+// ----------------------------------------------------------------------
+// Test initialize() with range too large for error bound
+void
+cencalvm::storage::TestPayloadCodec::testRangeTooLarge(void)
+{ // testRangeTooLarge
+  PayloadCodec codec;
+  codec.errorBound("Vp", 0.01);
+
+  codec.resetRange();
+  for (int i=0; i < _NUMPAYLOADS; ++i) {
+    PayloadStruct payload;
+    _setPayload(&payload, i);
+    codec.updateRange(payload);
+  } // for
+  CPPUNIT_ASSERT_THROW(codec.initialize(), std::runtime_error);
+
+  codec.errorBound("Vp", 0.1);
+  codec.initialize();
+} // testRangeTooLarge
+
+// ----------------------------------------------------------------------
+// Test metadata() and parseMetadata()
+void
+cencalvm::storage::TestPayloadCodec::testMetadata(void)
+{ // testMetadata
+  PayloadCodec codecE;
+  codecE.errorBound("Density", 0.25);
+  codecE.resetRange();
+  for (int i=0; i < _NUMPAYLOADS; ++i) {
+    PayloadStruct payload;
+    _setPayload(&payload, i);
+    codecE.updateRange(payload);
+  } // for
+  codecE.initialize();
+
+  const std::string appmeta =
+    std::string("created by test\n") + codecE.metadata() + "\nhost: test";
+
+  PayloadCodec codec;
+  codec.parseMetadata(appmeta.c_str());
+  for (int iVal=0; iVal < PayloadCodec::NUMVALUES; ++iVal) {
+    CPPUNIT_ASSERT_EQUAL(codecE._offset[iVal], codec._offset[iVal]);
+    CPPUNIT_ASSERT_EQUAL(codecE._step[iVal], codec._step[iVal]);
+  } // for
+  const double tolerance = 1.0e-06;
+  CPPUNIT_ASSERT_DOUBLES_EQUAL(0.25, codec.errorBound("Density"), tolerance);
+
+  CPPUNIT_ASSERT_THROW(codec.parseMetadata("created by test"),
+		       std::runtime_error);
+  CPPUNIT_ASSERT_THROW(codec.parseMetadata("payload quantization: Vp=1,2"),
+		       std::runtime_error);
+  CPPUNIT_ASSERT_THROW(codec.parseMetadata("payload quantization: Vp"),
+		       std::runtime_error);
+} // testMetadata
+
+// ----------------------------------------------------------------------
+// Set payload from index of test payload.
+void
+cencalvm::storage::TestPayloadCodec::_setPayload(PayloadStruct* pPayload,
+						 const int index)
+{ // _setPayload
+  CPPUNIT_ASSERT(0 != pPayload);
+
+  const float vp[] = { 1500.0, 3000.1, 4567.8, Payload::NODATAVAL, 6500.0 };
+  const float vs[] = { 500.0, 1700.3, 2800.6, Payload::NODATAVAL, 3700.0 };
+  const float density[] = { 1900.0, 2250.25, 2600.7, Payload::NODATAVAL,
+			    2900.0 };
+  const float qp[] = { 50.0, 181.33, 320.1, Payload::NODATAVAL, 600.0 };
+  const float qs[] = { 25.0, 90.67, 160.05, Payload::NODATAVAL, 300.0 };
+  const float depth[] = { 0.0, 1234.5, 8765.4, Payload::NODATAVAL,
+			  30000.0 };
+  const short block[] = { 1, 4, 7, Payload::NODATABLOCK,
+			  Payload::INTERIORBLOCK };
+  const short zone[] = { 2, 5, 8, Payload::NODATAZONE,
+			 Payload::INTERIORZONE };
+
+  CPPUNIT_ASSERT(index >= 0 && index < _NUMPAYLOADS);
+  pPayload->Vp = vp[index];
+  pPayload->Vs = vs[index];
+  pPayload->Density = density[index];
+  pPayload->Qp = qp[index];
+  pPayload->Qs = qs[index];
+  pPayload->DepthFreeSurf = depth[index];
+  pPayload->FaultBlock = block[index];
+  pPayload->Zone = zone[index];
+} // _setPayload
+
+// End of file
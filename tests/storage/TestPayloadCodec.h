@@ -0,0 +1,87 @@
+// -*- C++ -*-
+//
+// ----------------------------------------------------------------------
+//
+//                           Brad T. Aagaard
+//                        U.S. Geological Survey
+//
+// {LicenseText}
+//
+// ----------------------------------------------------------------------
+//
+
+/** @file tests/TestPayloadCodec.h
+ *
+ * @brief C++ TestPayloadCodec object
+ *
+ * C++ unit testing for PayloadCodec.
+ */
+
+#if !defined(cencalvm_storage_testpayloadcodec_h)
+#define cencalvm_storage_testpayloadcodec_h
+
+#include <cppunit/extensions/HelperMacros.h>
+
+namespace cencalvm {
+  namespace storage {
+    class TestPayloadCodec;
+    struct PayloadStruct; // USES PayloadStruct
+  } // storage
+} // cencalvm
+
+/// C++ unit testing for PayloadCodec
+class cencalvm::storage::TestPayloadCodec : public CppUnit::TestFixture
+{ // class TestPayloadCodec
+
+  // CPPUNIT TEST SUITE /////////////////////////////////////////////////
+  CPPUNIT_TEST_SUITE( TestPayloadCodec );
+  CPPUNIT_TEST( testConstructor );
+  CPPUNIT_TEST( testErrorBound );
+  CPPUNIT_TEST( testRange );
+  CPPUNIT_TEST( testEncodeDecode );
+  CPPUNIT_TEST( testRangeTooLarge );
+  CPPUNIT_TEST( testMetadata );
+  CPPUNIT_TEST_SUITE_END();
+
+  // PUBLIC METHODS /////////////////////////////////////////////////////
+public :
+
+  /// Test constructor
+  void testConstructor(void);
+
+  /// Test errorBound()
+  void testErrorBound(void);
+
+  /// Test resetRange(), updateRange(), and initialize()
+  void testRange(void);
+
+  /// Test encode() and decode()
+  void testEncodeDecode(void);
+
+  /// Test initialize() with range too large for error bound
+  void testRangeTooLarge(void);
+
+  /// Test metadata() and parseMetadata()
+  void testMetadata(void);
+
+  // PRIVATE METHODS ////////////////////////////////////////////////////
+private :
+
+  /** Set payload from index of test payload.
+   *
+   * @param pPayload Pointer to payload
+   * @param index Index of test payload
+   */
+  static void _setPayload(PayloadStruct* pPayload,
+			  const int index);
+
+  // PRIVATE MEMBERS ////////////////////////////////////////////////////
+private :
+
+  static const int _NUMPAYLOADS; ///< Number of test payloads
+
+}; // class TestPayloadCodec
+
+#endif // cencalvm_storage_testpayloadcodec
+
+// End of file
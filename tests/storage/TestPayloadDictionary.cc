@@ -0,0 +1,145 @@
+// -*- C++ -*-
+//
+// ----------------------------------------------------------------------
+//
+//                           Brad T. Aagaard
+//                        U.S. Geological Survey
+//
+// {LicenseText}
+//
+// ----------------------------------------------------------------------
+//
+
+#include "TestPayloadDictionary.h" // Implementation of class methods
+
+#include "cencalvm/storage/PayloadDictionary.h" // USES PayloadDictionary
+
+#include <string.h> // USES memcmp()
+#include <stdio.h> // USES remove()
+#include <stdexcept> // USES std::runtime_error
+
+// ----------------------------------------------------------------------
+CPPUNIT_TEST_SUITE_REGISTRATION( cencalvm::storage::TestPayloadDictionary );
+
+// ----------------------------------------------------------------------
+const char* cencalvm::storage::TestPayloadDictionary::_FILENAME =
+  "data/dictionary.etree.dict";
+const int cencalvm::storage::TestPayloadDictionary::_NUMENTRIES = 5;
+
+// ----------------------------------------------------------------------
+// Test constructor
+void
+cencalvm::storage::TestPayloadDictionary::testConstructor(void)
+{ // testConstructor
+  PayloadDictionary dictionary;
+  CPPUNIT_ASSERT_EQUAL(uint32_t(0), dictionary.size());
+} // testConstructor
+
+// ----------------------------------------------------------------------
+// Test filename()
+void
+cencalvm::storage::TestPayloadDictionary::testFilename(void)
+{ // testFilename
+  CPPUNIT_ASSERT(std::string(_FILENAME) ==
+		 PayloadDictionary::filename("data/dictionary.etree"));
+} // testFilename
+
+// ----------------------------------------------------------------------
+// Test metadata() and find()
+void
+cencalvm::storage::TestPayloadDictionary::testFind(void)
+{ // testFind
+  const std::string metadata = PayloadDictionary::metadata(_FILENAME);
+  CPPUNIT_ASSERT(std::string(PayloadDictionary::METADATATAG) +
+		 " dictionary.etree.dict" == metadata);
+
+  // Dictionary named after database is used if it exists.
+  PayloadDictionary dictionary;
+  dictionary.append(_payload(0));
+  dictionary.write(_FILENAME);
+  CPPUNIT_ASSERT(std::string(_FILENAME) ==
+		 PayloadDictionary::find("data/dictionary.etree", 0));
+
+  // Renamed database uses last dictionary in metadata.
+  const std::string appmeta =
+    "encoded\n" + PayloadDictionary::metadata("old.etree.dict") + "\n" +
+    metadata + "\nhost: localhost";
+  CPPUNIT_ASSERT(std::string(_FILENAME) ==
+		 PayloadDictionary::find("data/renamed.etree",
+					 appmeta.c_str()));
+  CPPUNIT_ASSERT(std::string("data/renamed.etree.dict") ==
+		 PayloadDictionary::find("data/renamed.etree", "encoded"));
+  CPPUNIT_ASSERT(std::string("data/renamed.etree.dict") ==
+		 PayloadDictionary::find("data/renamed.etree", 0));
+
+  remove(_FILENAME);
+} // testFind
+
+// ----------------------------------------------------------------------
+// Test append(), lookup(), and clear()
+void
+cencalvm::storage::TestPayloadDictionary::testAppend(void)
+{ // testAppend
+  PayloadDictionary dictionary;
+  for (int i=0; i < _NUMENTRIES; ++i)
+    CPPUNIT_ASSERT_EQUAL(uint32_t(i), dictionary.append(_payload(i)));
+  CPPUNIT_ASSERT_EQUAL(uint32_t(_NUMENTRIES), dictionary.size());
+
+  PayloadStruct payload;
+  for (int i=_NUMENTRIES-1; i >= 0; --i) {
+    CPPUNIT_ASSERT(0 == dictionary.lookup(&payload, i));
+    const PayloadStruct payloadE = _payload(i);
+    CPPUNIT_ASSERT(0 == memcmp(&payloadE, &payload, sizeof(payload)));
+  } // for
+  CPPUNIT_ASSERT(0 != dictionary.lookup(&payload, _NUMENTRIES));
+
+  dictionary.clear();
+  CPPUNIT_ASSERT_EQUAL(uint32_t(0), dictionary.size());
+  CPPUNIT_ASSERT(0 != dictionary.lookup(&payload, 0));
+} // testAppend
+
+// ----------------------------------------------------------------------
+// Test read() and write()
+void
+cencalvm::storage::TestPayloadDictionary::testReadWrite(void)
+{ // testReadWrite
+  PayloadDictionary dictionaryOut;
+  for (int i=0; i < _NUMENTRIES; ++i)
+    dictionaryOut.append(_payload(i));
+  dictionaryOut.write(_FILENAME);
+
+  PayloadDictionary dictionary;
+  dictionary.read(_FILENAME);
+  CPPUNIT_ASSERT_EQUAL(uint32_t(_NUMENTRIES), dictionary.size());
+  PayloadStruct payload;
+  for (int i=0; i < _NUMENTRIES; ++i) {
+    CPPUNIT_ASSERT(0 == dictionary.lookup(&payload, i));
+    const PayloadStruct payloadE = _payload(i);
+    CPPUNIT_ASSERT(0 == memcmp(&payloadE, &payload, sizeof(payload)));
+  } // for
+
+  CPPUNIT_ASSERT_THROW(dictionary.read("data/TestProjector.dat"),
+		       std::runtime_error);
+  CPPUNIT_ASSERT_EQUAL(uint32_t(0), dictionary.size());
+  CPPUNIT_ASSERT_THROW(dictionary.read("data/nosuchfile.dict"),
+		       std::runtime_error);
+} // testReadWrite
+
+// ----------------------------------------------------------------------
+// Get payload of entry in dictionary.
+cencalvm::storage::PayloadStruct
+cencalvm::storage::TestPayloadDictionary::_payload(const int index)
+{ // _payload
+  PayloadStruct payload;
+  payload.Vp = 3000.0 + 10.0*index;
+  payload.Vs = 1500.0 + 5.0*index;
+  payload.Density = 2200.0 + 0.5*index;
+  payload.Qp = 300.0 + index;
+  payload.Qs = 150.0 + index;
+  payload.DepthFreeSurf = 25.0*index;
+  payload.FaultBlock = 2 + index;
+  payload.Zone = 1 + index % 3;
+  return payload;
+} // _payload
+
+// End of file
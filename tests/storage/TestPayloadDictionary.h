@@ -0,0 +1,84 @@
+// -*- C++ -*-
+//
+// ----------------------------------------------------------------------
+//
+//                           Brad T. Aagaard
+//                        U.S. Geological Survey
+//
+// {LicenseText}
+//
+// ----------------------------------------------------------------------
+//
+
+/** @file tests/TestPayloadDictionary.h
+ *
+ * @brief C++ TestPayloadDictionary object
+ *
+ * C++ unit testing for PayloadDictionary.
+ */
+
+#if !defined(cencalvm_storage_testpayloaddictionary_h)
+#define cencalvm_storage_testpayloaddictionary_h
+
+#include <cppunit/extensions/HelperMacros.h>
+
+namespace cencalvm {
+  namespace storage {
+    class TestPayloadDictionary;
+    struct PayloadStruct; // USES PayloadStruct
+  } // storage
+} // cencalvm
+
+/// C++ unit testing for PayloadDictionary
+class cencalvm::storage::TestPayloadDictionary : public CppUnit::TestFixture
+{ // class TestPayloadDictionary
+
+  // CPPUNIT TEST SUITE /////////////////////////////////////////////////
+  CPPUNIT_TEST_SUITE( TestPayloadDictionary );
+  CPPUNIT_TEST( testConstructor );
+  CPPUNIT_TEST( testFilename );
+  CPPUNIT_TEST( testFind );
+  CPPUNIT_TEST( testAppend );
+  CPPUNIT_TEST( testReadWrite );
+  CPPUNIT_TEST_SUITE_END();
+
+  // PUBLIC METHODS /////////////////////////////////////////////////////
+public :
+
+  /// Test constructor
+  void testConstructor(void);
+
+  /// Test filename()
+  void testFilename(void);
+
+  /// Test metadata() and find()
+  void testFind(void);
+
+  /// Test append(), lookup(), and clear()
+  void testAppend(void);
+
+  /// Test read() and write()
+  void testReadWrite(void);
+
+  // PRIVATE METHODS ////////////////////////////////////////////////////
+private :
+
+  /** Get payload of entry in dictionary.
+   *
+   * @param index Index of entry
+   *
+   * @returns Payload of entry
+   */
+  static PayloadStruct _payload(const int index);
+
+  // PRIVATE MEMBERS ////////////////////////////////////////////////////
+private :
+
+  static const char* _FILENAME; ///< Filename of dictionary
+  static const int _NUMENTRIES; ///< Number of entries in dictionary
+
+}; // class TestPayloadDictionary
+
+#endif // cencalvm_storage_testpayloaddictionary_h
+
+// End of file
@@ -0,0 +1,225 @@
+// -*- C++ -*-
+//
+// ----------------------------------------------------------------------
+//
+//                           Brad T. Aagaard
+//                        U.S. Geological Survey
+//
+// {LicenseText}
+//
+// ----------------------------------------------------------------------
+//
+
+#include "TestTelemetry.h" // Implementation of class methods
+
+#include "cencalvm/storage/Telemetry.h" // USES Telemetry
+
+#include <fstream> // USES std::ifstream
+#include <stdexcept> // USES std::runtime_error
+
+// ----------------------------------------------------------------------
+CPPUNIT_TEST_SUITE_REGISTRATION( cencalvm::storage::TestTelemetry );
+
+// ----------------------------------------------------------------------
+const char* cencalvm::storage::TestTelemetry::_FILENAME =
+  "data/telemetry.log";
+
+// ----------------------------------------------------------------------
+// Test constructor
+void
+cencalvm::storage::TestTelemetry::testConstructor(void)
+{ // testConstructor
+  Telemetry telemetry;
+  CPPUNIT_ASSERT(telemetry._phase.empty());
+  CPPUNIT_ASSERT(!telemetry._fout.is_open());
+  CPPUNIT_ASSERT_EQUAL(uint64_t(0), telemetry.numOctants());
+  CPPUNIT_ASSERT_EQUAL(uint64_t(0), telemetry.numBytesRead());
+  CPPUNIT_ASSERT_EQUAL(uint64_t(0), telemetry.numBytesWritten());
+} // testConstructor
+
+// ----------------------------------------------------------------------
+// Test interval()
+void
+cencalvm::storage::TestTelemetry::testInterval(void)
+{ // testInterval
+  Telemetry telemetry;
+  CPPUNIT_ASSERT_EQUAL(10.0, telemetry._interval); // default
+
+  const double interval = 2.5;
+  telemetry.interval(interval);
+  CPPUNIT_ASSERT_EQUAL(interval, telemetry._interval);
+
+  telemetry.interval(-1.0);
+  CPPUNIT_ASSERT_EQUAL(interval, telemetry._interval);
+
+  telemetry.interval(0.0);
+  CPPUNIT_ASSERT_EQUAL(0.0, telemetry._interval);
+} // testInterval
+
+// ----------------------------------------------------------------------
+// Test quiet()
+void
+cencalvm::storage::TestTelemetry::testQuiet(void)
+{ // testQuiet
+  Telemetry telemetry;
+  CPPUNIT_ASSERT(!telemetry._quiet); // default is to report to stderr
+  telemetry.quiet(true);
+  CPPUNIT_ASSERT(telemetry._quiet);
+  telemetry.quiet(false);
+  CPPUNIT_ASSERT(!telemetry._quiet);
+} // testQuiet
+
+// ----------------------------------------------------------------------
+// Test beginPhase(), addOctants(), addBytesRead(), addBytesWritten()
+void
+cencalvm::storage::TestTelemetry::testPhase(void)
+{ // testPhase
+  Telemetry telemetry;
+  telemetry.quiet(true);
+
+  telemetry.beginPhase("pack", 100, 200);
+  telemetry.cacheSize(64);
+  CPPUNIT_ASSERT(std::string("pack") == telemetry._phase);
+  CPPUNIT_ASSERT_EQUAL(uint64_t(100), telemetry._numOctantsTotal);
+  CPPUNIT_ASSERT_EQUAL(uint64_t(200), telemetry._numBytesTotal);
+  CPPUNIT_ASSERT_EQUAL(64, telemetry._cacheSize);
+
+  telemetry.addOctants();
+  telemetry.addOctants(9);
+  telemetry.addBytesRead(30);
+  telemetry.addBytesWritten(40);
+  telemetry.addBytesWritten(2);
+  CPPUNIT_ASSERT_EQUAL(uint64_t(10), telemetry.numOctants());
+  CPPUNIT_ASSERT_EQUAL(uint64_t(30), telemetry.numBytesRead());
+  CPPUNIT_ASSERT_EQUAL(uint64_t(42), telemetry.numBytesWritten());
+
+  // New phase resets counts.
+  telemetry.beginPhase("average");
+  CPPUNIT_ASSERT(std::string("average") == telemetry._phase);
+  CPPUNIT_ASSERT_EQUAL(uint64_t(0), telemetry.numOctants());
+  CPPUNIT_ASSERT_EQUAL(uint64_t(0), telemetry.numBytesRead());
+  CPPUNIT_ASSERT_EQUAL(uint64_t(0), telemetry.numBytesWritten());
+  CPPUNIT_ASSERT_EQUAL(uint64_t(0), telemetry._numOctantsTotal);
+  CPPUNIT_ASSERT_EQUAL(0, telemetry._cacheSize);
+
+  telemetry.endPhase();
+  CPPUNIT_ASSERT(telemetry._phase.empty());
+} // testPhase
+
+// ----------------------------------------------------------------------
+// Test filename() and reports at beginning and end of phases.
+void
+cencalvm::storage::TestTelemetry::testLog(void)
+{ // testLog
+  { // scope for telemetry
+    Telemetry telemetry;
+    telemetry.quiet(true);
+    telemetry.filename(_FILENAME);
+
+    telemetry.beginPhase("ingest", 0, 1000);
+    telemetry.addBytesRead(500);
+    telemetry.addOctants(5);
+    telemetry.endPhase();
+
+    telemetry.beginPhase("pack", 5);
+    telemetry.cacheSize(16);
+    telemetry.addOctants(5);
+    telemetry.addBytesWritten(80);
+    // Destructor ends phase.
+  } // scope for telemetry
+
+  const std::vector<std::string>& lines = _readLog(_FILENAME);
+  CPPUNIT_ASSERT_EQUAL(size_t(4), lines.size());
+
+  const char* entriesE[4][3] = {
+    { "\"phase\": \"ingest\"", "\"event\": \"begin\"", "\"bytesTotal\": 1000" },
+    { "\"phase\": \"ingest\"", "\"event\": \"end\"", "\"bytesRead\": 500" },
+    { "\"phase\": \"pack\"", "\"event\": \"begin\"", "\"octantsTotal\": 5" },
+    { "\"phase\": \"pack\"", "\"event\": \"end\"", "\"bytesWritten\": 80" },
+  };
+  for (int iLine=0; iLine < 4; ++iLine) {
+    CPPUNIT_ASSERT_EQUAL('{', lines[iLine][0]);
+    CPPUNIT_ASSERT_EQUAL('}', lines[iLine][lines[iLine].length()-1]);
+    for (int i=0; i < 3; ++i)
+      CPPUNIT_ASSERT(std::string::npos != lines[iLine].find(entriesE[iLine][i]));
+  } // for
+  CPPUNIT_ASSERT(std::string::npos != lines[3].find("\"cacheSize\": 16"));
+  CPPUNIT_ASSERT(std::string::npos != lines[3].find("\"octants\": 5"));
+  CPPUNIT_ASSERT(std::string::npos != lines[3].find("\"eta\": 0"));
+
+  Telemetry telemetry;
+  CPPUNIT_ASSERT_THROW(telemetry.filename("nodir/telemetry.log"),
+		       std::runtime_error);
+} // testLog
+
+// ----------------------------------------------------------------------
+// Test periodic progress reports.
+void
+cencalvm::storage::TestTelemetry::testProgress(void)
+{ // testProgress
+  { // scope for telemetry
+    Telemetry telemetry;
+    telemetry.quiet(true);
+    telemetry.filename(_FILENAME);
+    telemetry.interval(1.0e-9);
+
+    telemetry.beginPhase("average", 4*Telemetry::_CHECKINTERVAL);
+    // Clock is only checked after _CHECKINTERVAL octants.
+    telemetry.addOctants(Telemetry::_CHECKINTERVAL-1);
+    telemetry.addOctants(1);
+    telemetry.addOctants(Telemetry::_CHECKINTERVAL);
+    telemetry.endPhase();
+  } // scope for telemetry
+
+  const std::vector<std::string>& lines = _readLog(_FILENAME);
+  CPPUNIT_ASSERT_EQUAL(size_t(4), lines.size());
+  CPPUNIT_ASSERT(std::string::npos != lines[1].find("\"event\": \"progress\""));
+  CPPUNIT_ASSERT(std::string::npos != lines[1].find("\"octants\": 4096"));
+  CPPUNIT_ASSERT(std::string::npos != lines[2].find("\"event\": \"progress\""));
+  CPPUNIT_ASSERT(std::string::npos != lines[2].find("\"octants\": 8192"));
+  CPPUNIT_ASSERT(std::string::npos == lines[2].find("\"eta\": null"));
+} // testProgress
+
+// ----------------------------------------------------------------------
+// Test peakMemory() and resetPeakMemory().
+void
+cencalvm::storage::TestTelemetry::testPeakMemory(void)
+{ // testPeakMemory
+  const uint64_t peakBegin = Telemetry::peakMemory();
+  if (0 == peakBegin)
+    return; // system without memory statistics
+
+  // Touch every page of a block larger than the process so far.
+  const size_t size = peakBegin + 32*1024*1024;
+  std::vector<char> block(size, 1);
+  const uint64_t peakBlock = Telemetry::peakMemory();
+  CPPUNIT_ASSERT(peakBlock >= size);
+  block.clear();
+  block.shrink_to_fit();
+
+  // The allocator may keep the freed block resident, so the peak after
+  // a reset is only bounded by the earlier peak.
+  const bool isReset = Telemetry::resetPeakMemory();
+  const uint64_t peakReset = Telemetry::peakMemory();
+  CPPUNIT_ASSERT(peakReset > 0);
+  if (isReset)
+    CPPUNIT_ASSERT(peakReset <= peakBlock);
+  else
+    CPPUNIT_ASSERT(peakReset >= peakBlock);
+} // testPeakMemory
+
+// ----------------------------------------------------------------------
+// Read lines of log file.
+std::vector<std::string>
+cencalvm::storage::TestTelemetry::_readLog(const char* filename)
+{ // _readLog
+  std::vector<std::string> lines;
+  std::ifstream fin(filename);
+  CPPUNIT_ASSERT(fin.is_open());
+  std::string line;
+  while (std::getline(fin, line))
+    lines.push_back(line);
+  return lines;
+} // _readLog
+
+// End of file
@@ -0,0 +1,93 @@
+// -*- C++ -*-
+//
+// ----------------------------------------------------------------------
+//
+//                           Brad T. Aagaard
+//                        U.S. Geological Survey
+//
+// {LicenseText}
+//
+// ----------------------------------------------------------------------
+//
+
+/** @file tests/TestTelemetry.h
+ *
+ * @brief C++ TestTelemetry object
+ *
+ * C++ unit testing for Telemetry.
+ */
+
+#if !defined(cencalvm_storage_testtelemetry_h)
+#define cencalvm_storage_testtelemetry_h
+
+#include <cppunit/extensions/HelperMacros.h>
+
+#include <string> // USES std::string
+#include <vector> // USES std::vector
+
+namespace cencalvm {
+  namespace storage {
+    class TestTelemetry;
+  } // storage
+} // cencalvm
+
+/// C++ unit testing for Telemetry
+class cencalvm::storage::TestTelemetry : public CppUnit::TestFixture
+{ // class TestTelemetry
+
+  // CPPUNIT TEST SUITE /////////////////////////////////////////////////
+  CPPUNIT_TEST_SUITE( TestTelemetry );
+  CPPUNIT_TEST( testConstructor );
+  CPPUNIT_TEST( testInterval );
+  CPPUNIT_TEST( testQuiet );
+  CPPUNIT_TEST( testPhase );
+  CPPUNIT_TEST( testLog );
+  CPPUNIT_TEST( testProgress );
+  CPPUNIT_TEST( testPeakMemory );
+  CPPUNIT_TEST_SUITE_END();
+
+  // PUBLIC METHODS /////////////////////////////////////////////////////
+public :
+
+  /// Test constructor
+  void testConstructor(void);
+
+  /// Test interval()
+  void testInterval(void);
+
+  /// Test quiet()
+  void testQuiet(void);
+
+  /// Test beginPhase(), addOctants(), addBytesRead(), addBytesWritten()
+  void testPhase(void);
+
+  /// Test filename() and reports at beginning and end of phases
+  void testLog(void);
+
+  /// Test periodic progress reports
+  void testProgress(void);
+
+  /// Test peakMemory() and resetPeakMemory()
+  void testPeakMemory(void);
+
+  // PRIVATE METHODS ////////////////////////////////////////////////////
+private :
+
+  /** Read lines of log file.
+   *
+   * @param filename Name of log file
+   *
+   * @returns Lines in file
+   */
+  static std::vector<std::string> _readLog(const char* filename);
+
+  // PRIVATE MEMBERS ////////////////////////////////////////////////////
+private :
+
+  static const char* _FILENAME; ///< Filename of telemetry log
+
+}; // class TestTelemetry
+
+#endif // cencalvm_storage_testtelemetry_h
+
+// End of file